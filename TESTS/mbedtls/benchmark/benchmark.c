@@ -0,0 +1,555 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "benchmark.h"
+
+#if !defined(MBEDTLS_CONFIG_FILE)
+#include "mbedtls/config.h"
+#else
+#include MBEDTLS_CONFIG_FILE
+#endif
+
+#include "mbedtls/aes.h"
+#include "mbedtls/gcm.h"
+#include "mbedtls/ccm.h"
+#include "mbedtls/sha256.h"
+#include "mbedtls/sha512.h"
+#include "mbedtls/pk.h"
+#include "mbedtls/rsa.h"
+#include "mbedtls/ecdsa.h"
+#include "mbedtls/ecdh.h"
+#include "mbedtls/certs.h"
+
+#include <stdio.h>
+#include <string.h>
+
+typedef int (*benchmark_op_t)(void *ctx);
+
+// Repeats an operation for BENCHMARK_MS, after a first untimed run that
+// leaves caches and lazily computed tables as later runs find them
+static int benchmark_loop(benchmark_op_t op, void *ctx, size_t bytes,
+                          benchmark_result_t *result)
+{
+    uint64_t limit = benchmark_cycles_per_second() / 1000 * BENCHMARK_MS;
+    uint64_t start;
+    int ret;
+
+    if ((ret = op(ctx)) != 0) {
+        return ret;
+    }
+
+    result->ops = 0;
+    result->cycles = 0;
+    result->bytes = bytes;
+
+    start = benchmark_cycles();
+    do {
+        if ((ret = op(ctx)) != 0) {
+            return ret;
+        }
+
+        result->ops++;
+        result->cycles = benchmark_cycles() - start;
+    } while (result->cycles < limit);
+
+    return 0;
+}
+
+// Deterministic random numbers, so runs do the same work and no entropy
+// source is needed. Not for anything but benchmarks.
+static int benchmark_rng(void *p_rng, unsigned char *output, size_t len)
+{
+    static uint32_t state = 0x12345678;
+    (void)p_rng;
+
+    while (len--) {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        *output++ = (unsigned char)state;
+    }
+
+    return 0;
+}
+
+static unsigned char buf[BENCHMARK_BUFFER_SIZE];
+static unsigned char tag[16];
+static unsigned char iv[16];
+
+
+/* Symmetric primitives, in cycles/byte */
+
+#if defined(MBEDTLS_AES_C)
+static int aes_ecb_op(void *ctx)
+{
+    size_t i;
+    for (i = 0; i + 16 <= sizeof buf; i += 16) {
+        int ret = mbedtls_aes_crypt_ecb(ctx, MBEDTLS_AES_ENCRYPT, buf + i, buf + i);
+        if (ret != 0) {
+            return ret;
+        }
+    }
+
+    return 0;
+}
+
+static int aes_128_ecb(benchmark_result_t *result)
+{
+    mbedtls_aes_context aes;
+    int ret;
+
+    mbedtls_aes_init(&aes);
+    ret = mbedtls_aes_setkey_enc(&aes, buf, 128);
+    if (ret == 0) {
+        ret = benchmark_loop(aes_ecb_op, &aes, sizeof buf, result);
+    }
+
+    mbedtls_aes_free(&aes);
+    return ret;
+}
+#endif /* MBEDTLS_AES_C */
+
+#if defined(MBEDTLS_AES_C) && defined(MBEDTLS_CIPHER_MODE_CBC)
+static int aes_cbc_op(void *ctx)
+{
+    return mbedtls_aes_crypt_cbc(ctx, MBEDTLS_AES_ENCRYPT, sizeof buf, iv, buf, buf);
+}
+
+static int aes_cbc(unsigned keybits, benchmark_result_t *result)
+{
+    mbedtls_aes_context aes;
+    int ret;
+
+    mbedtls_aes_init(&aes);
+    ret = mbedtls_aes_setkey_enc(&aes, buf, keybits);
+    if (ret == 0) {
+        ret = benchmark_loop(aes_cbc_op, &aes, sizeof buf, result);
+    }
+
+    mbedtls_aes_free(&aes);
+    return ret;
+}
+
+static int aes_128_cbc(benchmark_result_t *result)
+{
+    return aes_cbc(128, result);
+}
+
+static int aes_256_cbc(benchmark_result_t *result)
+{
+    return aes_cbc(256, result);
+}
+#endif /* MBEDTLS_AES_C && MBEDTLS_CIPHER_MODE_CBC */
+
+#if defined(MBEDTLS_AES_C) && defined(MBEDTLS_CIPHER_MODE_CTR)
+static int aes_ctr_op(void *ctx)
+{
+    unsigned char stream_block[16];
+    size_t nc_off = 0;
+    return mbedtls_aes_crypt_ctr(ctx, sizeof buf, &nc_off, iv, stream_block, buf, buf);
+}
+
+static int aes_128_ctr(benchmark_result_t *result)
+{
+    mbedtls_aes_context aes;
+    int ret;
+
+    mbedtls_aes_init(&aes);
+    ret = mbedtls_aes_setkey_enc(&aes, buf, 128);
+    if (ret == 0) {
+        ret = benchmark_loop(aes_ctr_op, &aes, sizeof buf, result);
+    }
+
+    mbedtls_aes_free(&aes);
+    return ret;
+}
+#endif /* MBEDTLS_AES_C && MBEDTLS_CIPHER_MODE_CTR */
+
+#if defined(MBEDTLS_GCM_C)
+static int gcm_op(void *ctx)
+{
+    return mbedtls_gcm_crypt_and_tag(ctx, MBEDTLS_GCM_ENCRYPT, sizeof buf,
+            iv, 12, NULL, 0, buf, buf, sizeof tag, tag);
+}
+
+static int aes_128_gcm(benchmark_result_t *result)
+{
+    mbedtls_gcm_context gcm;
+    int ret;
+
+    mbedtls_gcm_init(&gcm);
+    ret = mbedtls_gcm_setkey(&gcm, MBEDTLS_CIPHER_ID_AES, buf, 128);
+    if (ret == 0) {
+        ret = benchmark_loop(gcm_op, &gcm, sizeof buf, result);
+    }
+
+    mbedtls_gcm_free(&gcm);
+    return ret;
+}
+#endif /* MBEDTLS_GCM_C */
+
+#if defined(MBEDTLS_CCM_C)
+static int ccm_op(void *ctx)
+{
+    return mbedtls_ccm_encrypt_and_tag(ctx, sizeof buf,
+            iv, 12, NULL, 0, buf, buf, tag, sizeof tag);
+}
+
+static int aes_128_ccm(benchmark_result_t *result)
+{
+    mbedtls_ccm_context ccm;
+    int ret;
+
+    mbedtls_ccm_init(&ccm);
+    ret = mbedtls_ccm_setkey(&ccm, MBEDTLS_CIPHER_ID_AES, buf, 128);
+    if (ret == 0) {
+        ret = benchmark_loop(ccm_op, &ccm, sizeof buf, result);
+    }
+
+    mbedtls_ccm_free(&ccm);
+    return ret;
+}
+#endif /* MBEDTLS_CCM_C */
+
+#if defined(MBEDTLS_SHA256_C)
+static int sha256_op(void *ctx)
+{
+    unsigned char digest[32];
+    (void)ctx;
+    mbedtls_sha256(buf, sizeof buf, digest, 0);
+    return 0;
+}
+
+static int sha256(benchmark_result_t *result)
+{
+    return benchmark_loop(sha256_op, NULL, sizeof buf, result);
+}
+#endif /* MBEDTLS_SHA256_C */
+
+#if defined(MBEDTLS_SHA512_C)
+static int sha512_op(void *ctx)
+{
+    unsigned char digest[64];
+    (void)ctx;
+    mbedtls_sha512(buf, sizeof buf, digest, 0);
+    return 0;
+}
+
+static int sha512(benchmark_result_t *result)
+{
+    return benchmark_loop(sha512_op, NULL, sizeof buf, result);
+}
+#endif /* MBEDTLS_SHA512_C */
+
+
+/* Public-key operations, in ops/s */
+
+#if defined(MBEDTLS_RSA_C) && defined(MBEDTLS_PK_PARSE_C) && \
+    defined(MBEDTLS_CERTS_C) && defined(MBEDTLS_PEM_PARSE_C)
+#define BENCHMARK_RSA
+
+// RSA-2048 with the test key of certs.c, on a value below the modulus
+static int rsa_public_op(void *ctx)
+{
+    unsigned char out[256];
+    return mbedtls_rsa_public(ctx, buf, out);
+}
+
+static int rsa_private_op(void *ctx)
+{
+    unsigned char out[256];
+    return mbedtls_rsa_private(ctx, benchmark_rng, NULL, buf, out);
+}
+
+static int rsa_2048(benchmark_op_t op, benchmark_result_t *result)
+{
+    mbedtls_pk_context pk;
+    int ret;
+
+    mbedtls_pk_init(&pk);
+    ret = mbedtls_pk_parse_key(&pk, (const unsigned char *)mbedtls_test_srv_key_rsa,
+            strlen(mbedtls_test_srv_key_rsa) + 1, NULL, 0);
+    if (ret == 0 && mbedtls_pk_get_bitlen(&pk) != 2048) {
+        ret = MBEDTLS_ERR_PK_KEY_INVALID_FORMAT;
+    }
+
+    if (ret == 0) {
+        buf[0] = 0;
+        ret = benchmark_loop(op, mbedtls_pk_rsa(pk), 0, result);
+    }
+
+    mbedtls_pk_free(&pk);
+    return ret;
+}
+
+static int rsa_2048_public(benchmark_result_t *result)
+{
+    return rsa_2048(rsa_public_op, result);
+}
+
+static int rsa_2048_private(benchmark_result_t *result)
+{
+    return rsa_2048(rsa_private_op, result);
+}
+#endif /* MBEDTLS_RSA_C && MBEDTLS_PK_PARSE_C && ... */
+
+#if defined(MBEDTLS_ECDSA_C)
+// Sign and verify a hash the size of the curve, with a key made for it
+typedef struct {
+    mbedtls_ecdsa_context ecdsa;
+    mbedtls_mpi r, s;
+    size_t hash_len;
+} ecdsa_bench_t;
+
+static int ecdsa_sign_op(void *ctx)
+{
+    ecdsa_bench_t *bench = ctx;
+    return mbedtls_ecdsa_sign(&bench->ecdsa.grp, &bench->r, &bench->s,
+            &bench->ecdsa.d, buf, bench->hash_len, benchmark_rng, NULL);
+}
+
+static int ecdsa_verify_op(void *ctx)
+{
+    ecdsa_bench_t *bench = ctx;
+    return mbedtls_ecdsa_verify(&bench->ecdsa.grp, buf, bench->hash_len,
+            &bench->ecdsa.Q, &bench->r, &bench->s);
+}
+
+static int ecdsa(mbedtls_ecp_group_id id, benchmark_op_t op,
+                 benchmark_result_t *result)
+{
+    ecdsa_bench_t bench;
+    int ret;
+
+    mbedtls_ecdsa_init(&bench.ecdsa);
+    mbedtls_mpi_init(&bench.r);
+    mbedtls_mpi_init(&bench.s);
+
+    ret = mbedtls_ecdsa_genkey(&bench.ecdsa, id, benchmark_rng, NULL);
+    if (ret == 0) {
+        bench.hash_len = (bench.ecdsa.grp.nbits + 7) / 8;
+        ret = ecdsa_sign_op(&bench);
+    }
+
+    if (ret == 0) {
+        ret = benchmark_loop(op, &bench, 0, result);
+    }
+
+    mbedtls_mpi_free(&bench.s);
+    mbedtls_mpi_free(&bench.r);
+    mbedtls_ecdsa_free(&bench.ecdsa);
+    return ret;
+}
+#endif /* MBEDTLS_ECDSA_C */
+
+#if defined(MBEDTLS_ECDSA_C) && defined(MBEDTLS_ECP_DP_SECP256R1_ENABLED)
+static int ecdsa_secp256r1_sign(benchmark_result_t *result)
+{
+    return ecdsa(MBEDTLS_ECP_DP_SECP256R1, ecdsa_sign_op, result);
+}
+
+static int ecdsa_secp256r1_verify(benchmark_result_t *result)
+{
+    return ecdsa(MBEDTLS_ECP_DP_SECP256R1, ecdsa_verify_op, result);
+}
+#endif
+
+#if defined(MBEDTLS_ECDSA_C) && defined(MBEDTLS_ECP_DP_SECP384R1_ENABLED)
+static int ecdsa_secp384r1_sign(benchmark_result_t *result)
+{
+    return ecdsa(MBEDTLS_ECP_DP_SECP384R1, ecdsa_sign_op, result);
+}
+
+static int ecdsa_secp384r1_verify(benchmark_result_t *result)
+{
+    return ecdsa(MBEDTLS_ECP_DP_SECP384R1, ecdsa_verify_op, result);
+}
+#endif
+
+#if defined(MBEDTLS_ECDH_C)
+// One side of an ephemeral exchange: a new key pair, then the shared
+// secret with the public key of the peer
+static int ecdh_op(void *ctx)
+{
+    mbedtls_ecdh_context *ecdh = ctx;
+    int ret = mbedtls_ecdh_gen_public(&ecdh->grp, &ecdh->d, &ecdh->Q,
+            benchmark_rng, NULL);
+    if (ret != 0) {
+        return ret;
+    }
+
+    return mbedtls_ecdh_compute_shared(&ecdh->grp, &ecdh->z, &ecdh->Qp,
+            &ecdh->d, benchmark_rng, NULL);
+}
+
+static int ecdh(mbedtls_ecp_group_id id, benchmark_result_t *result)
+{
+    mbedtls_ecdh_context ecdh;
+    int ret;
+
+    mbedtls_ecdh_init(&ecdh);
+    ret = mbedtls_ecp_group_load(&ecdh.grp, id);
+    if (ret == 0) {
+        ret = mbedtls_ecdh_gen_public(&ecdh.grp, &ecdh.d, &ecdh.Qp,
+                benchmark_rng, NULL);
+    }
+
+    if (ret == 0) {
+        ret = benchmark_loop(ecdh_op, &ecdh, 0, result);
+    }
+
+    mbedtls_ecdh_free(&ecdh);
+    return ret;
+}
+#endif /* MBEDTLS_ECDH_C */
+
+#if defined(MBEDTLS_ECDH_C) && defined(MBEDTLS_ECP_DP_SECP256R1_ENABLED)
+static int ecdh_secp256r1(benchmark_result_t *result)
+{
+    return ecdh(MBEDTLS_ECP_DP_SECP256R1, result);
+}
+#endif
+
+#if defined(MBEDTLS_ECDH_C) && defined(MBEDTLS_ECP_DP_SECP384R1_ENABLED)
+static int ecdh_secp384r1(benchmark_result_t *result)
+{
+    return ecdh(MBEDTLS_ECP_DP_SECP384R1, result);
+}
+#endif
+
+#if defined(MBEDTLS_ECDH_C) && defined(MBEDTLS_ECP_DP_CURVE25519_ENABLED)
+static int ecdh_curve25519(benchmark_result_t *result)
+{
+    return ecdh(MBEDTLS_ECP_DP_CURVE25519, result);
+}
+#endif
+
+
+// Every benchmark has its entry, those mbed TLS is not configured for
+// have none to run, so results line up across configurations
+static const struct {
+    const char *name;
+    int (*run)(benchmark_result_t *result);
+} benchmarks[BENCHMARK_COUNT] = {
+#if defined(MBEDTLS_AES_C)
+    { "AES-128-ECB",            aes_128_ecb },
+#else
+    { "AES-128-ECB",            NULL },
+#endif
+#if defined(MBEDTLS_AES_C) && defined(MBEDTLS_CIPHER_MODE_CBC)
+    { "AES-128-CBC",            aes_128_cbc },
+    { "AES-256-CBC",            aes_256_cbc },
+#else
+    { "AES-128-CBC",            NULL },
+    { "AES-256-CBC",            NULL },
+#endif
+#if defined(MBEDTLS_AES_C) && defined(MBEDTLS_CIPHER_MODE_CTR)
+    { "AES-128-CTR",            aes_128_ctr },
+#else
+    { "AES-128-CTR",            NULL },
+#endif
+#if defined(MBEDTLS_GCM_C)
+    { "AES-128-GCM",            aes_128_gcm },
+#else
+    { "AES-128-GCM",            NULL },
+#endif
+#if defined(MBEDTLS_CCM_C)
+    { "AES-128-CCM",            aes_128_ccm },
+#else
+    { "AES-128-CCM",            NULL },
+#endif
+#if defined(MBEDTLS_SHA256_C)
+    { "SHA-256",                sha256 },
+#else
+    { "SHA-256",                NULL },
+#endif
+#if defined(MBEDTLS_SHA512_C)
+    { "SHA-512",                sha512 },
+#else
+    { "SHA-512",                NULL },
+#endif
+#if defined(BENCHMARK_RSA)
+    { "RSA-2048 public",        rsa_2048_public },
+    { "RSA-2048 private",       rsa_2048_private },
+#else
+    { "RSA-2048 public",        NULL },
+    { "RSA-2048 private",       NULL },
+#endif
+#if defined(MBEDTLS_ECDSA_C) && defined(MBEDTLS_ECP_DP_SECP256R1_ENABLED)
+    { "ECDSA-secp256r1 sign",   ecdsa_secp256r1_sign },
+    { "ECDSA-secp256r1 verify", ecdsa_secp256r1_verify },
+#else
+    { "ECDSA-secp256r1 sign",   NULL },
+    { "ECDSA-secp256r1 verify", NULL },
+#endif
+#if defined(MBEDTLS_ECDSA_C) && defined(MBEDTLS_ECP_DP_SECP384R1_ENABLED)
+    { "ECDSA-secp384r1 sign",   ecdsa_secp384r1_sign },
+    { "ECDSA-secp384r1 verify", ecdsa_secp384r1_verify },
+#else
+    { "ECDSA-secp384r1 sign",   NULL },
+    { "ECDSA-secp384r1 verify", NULL },
+#endif
+#if defined(MBEDTLS_ECDH_C) && defined(MBEDTLS_ECP_DP_SECP256R1_ENABLED)
+    { "ECDH-secp256r1",         ecdh_secp256r1 },
+#else
+    { "ECDH-secp256r1",         NULL },
+#endif
+#if defined(MBEDTLS_ECDH_C) && defined(MBEDTLS_ECP_DP_SECP384R1_ENABLED)
+    { "ECDH-secp384r1",         ecdh_secp384r1 },
+#else
+    { "ECDH-secp384r1",         NULL },
+#endif
+#if defined(MBEDTLS_ECDH_C) && defined(MBEDTLS_ECP_DP_CURVE25519_ENABLED)
+    { "ECDH-Curve25519",        ecdh_curve25519 },
+#else
+    { "ECDH-Curve25519",        NULL },
+#endif
+};
+
+const char *benchmark_name(size_t index)
+{
+    return index < BENCHMARK_COUNT ? benchmarks[index].name : NULL;
+}
+
+int benchmark_run(size_t index, benchmark_result_t *result)
+{
+    if (index >= BENCHMARK_COUNT || !benchmarks[index].run) {
+        return BENCHMARK_SKIPPED;
+    }
+
+    memset(buf, 0x5a, sizeof buf);
+    memset(iv, 0, sizeof iv);
+    return benchmarks[index].run(result);
+}
+
+// Fixed point with two decimals, as printf of targets often lacks floats
+void benchmark_format(const benchmark_result_t *result, char *text, size_t size)
+{
+    uint64_t value;
+    const char *unit;
+
+    if (result->bytes) {
+        value = result->cycles * 100 / ((uint64_t)result->ops * result->bytes);
+        unit = "cycles/byte";
+    } else {
+        value = (uint64_t)result->ops * benchmark_cycles_per_second() * 100
+              / (result->cycles ? result->cycles : 1);
+        unit = "ops/s";
+    }
+
+    snprintf(text, size, "%lu.%02u %s",
+             (unsigned long)(value / 100), (unsigned)(value % 100), unit);
+}
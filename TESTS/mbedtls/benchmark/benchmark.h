@@ -0,0 +1,97 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Benchmarks of the mbed TLS primitives, as mbed TLS is configured
+ *
+ * Shared by the greentea test in this directory and the host build in
+ * TESTS/mbedtls/host/mbedtls_benchmark, so numbers from a target, with or
+ * without its ALT implementations, and from a PC compare one to one. The
+ * driver provides the clock.
+ */
+
+#ifndef MBEDTLS_BENCHMARK_H
+#define MBEDTLS_BENCHMARK_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Time each benchmark runs for, in milliseconds */
+#ifndef BENCHMARK_MS
+#define BENCHMARK_MS 1000
+#endif
+
+/** Size of the buffers of the symmetric benchmarks */
+#ifndef BENCHMARK_BUFFER_SIZE
+#define BENCHMARK_BUFFER_SIZE 1024
+#endif
+
+/** Number of benchmarks, whether mbed TLS is configured for them or not */
+#define BENCHMARK_COUNT 17
+
+/** Returned by benchmark_run when mbed TLS is not configured for it */
+#define BENCHMARK_SKIPPED 1
+
+/** Result of a benchmark */
+typedef struct {
+    unsigned long ops;  /*!< operations done            */
+    uint64_t cycles;    /*!< cycles they took           */
+    size_t bytes;       /*!< bytes per operation, 0 for
+                             public-key operations      */
+} benchmark_result_t;
+
+/** Free running cycle counter, provided by the driver
+ *
+ *  Only differences are used, the counter may wrap at 64 bits.
+ */
+uint64_t benchmark_cycles(void);
+
+/** Rate of benchmark_cycles, provided by the driver */
+uint64_t benchmark_cycles_per_second(void);
+
+/** Name of a benchmark
+ *
+ *  @param index    Benchmark, below BENCHMARK_COUNT
+ *  @return         Name, as "AES-128-CBC" or "ECDSA-secp256r1 sign"
+ */
+const char *benchmark_name(size_t index);
+
+/** Run a benchmark for BENCHMARK_MS
+ *
+ *  @param index    Benchmark, below BENCHMARK_COUNT
+ *  @param result   Result of the benchmark
+ *  @return         0 on success, BENCHMARK_SKIPPED if mbed TLS is not
+ *                  configured for it, or a negative mbed TLS error code
+ */
+int benchmark_run(size_t index, benchmark_result_t *result);
+
+/** Format a result as "12.34 cycles/byte" for symmetric primitives or
+ *  "56.78 ops/s" for public-key operations
+ *
+ *  @param result   Result of benchmark_run
+ *  @param text     Buffer for the text
+ *  @param size     Size of the buffer
+ */
+void benchmark_format(const benchmark_result_t *result, char *text, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,96 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "mbed.h"
+#include "greentea-client/test_env.h"
+#include "unity.h"
+#include "utest.h"
+
+#include "benchmark.h"
+
+using namespace utest::v1;
+
+// Cycles from the microsecond timer and the core clock, which is what
+// every target has. Benchmarks run for long enough that the resolution
+// of the timer does not matter.
+static Timer timer;
+
+uint64_t benchmark_cycles(void)
+{
+    return timer.read_high_resolution_us() * (SystemCoreClock / 1000000);
+}
+
+// With the same rounding as the cycles
+uint64_t benchmark_cycles_per_second(void)
+{
+    return SystemCoreClock / 1000000 * 1000000;
+}
+
+template <size_t N>
+void test_benchmark()
+{
+    benchmark_result_t result;
+    char text[32];
+
+    int ret = benchmark_run(N, &result);
+    if (ret == BENCHMARK_SKIPPED) {
+        printf("%s: not configured\r\n", benchmark_name(N));
+        return;
+    }
+
+    TEST_ASSERT_EQUAL(0, ret);
+    benchmark_format(&result, text, sizeof text);
+    printf("%s: %s\r\n", benchmark_name(N), text);
+}
+
+#define BENCHMARK_CASE(N) Case(benchmark_name(N), test_benchmark<N>)
+
+Case cases[] = {
+    BENCHMARK_CASE(0),
+    BENCHMARK_CASE(1),
+    BENCHMARK_CASE(2),
+    BENCHMARK_CASE(3),
+    BENCHMARK_CASE(4),
+    BENCHMARK_CASE(5),
+    BENCHMARK_CASE(6),
+    BENCHMARK_CASE(7),
+    BENCHMARK_CASE(8),
+    BENCHMARK_CASE(9),
+    BENCHMARK_CASE(10),
+    BENCHMARK_CASE(11),
+    BENCHMARK_CASE(12),
+    BENCHMARK_CASE(13),
+    BENCHMARK_CASE(14),
+    BENCHMARK_CASE(15),
+    BENCHMARK_CASE(16),
+};
+
+MBED_STATIC_ASSERT(sizeof cases / sizeof cases[0] == BENCHMARK_COUNT,
+        "One case per benchmark");
+
+utest::v1::status_t test_setup(const size_t num_cases) {
+    // Each benchmark runs for BENCHMARK_MS, and a first time untimed
+    GREENTEA_SETUP(60 + 2 * BENCHMARK_COUNT * BENCHMARK_MS / 1000, "default_auto");
+    printf("Core clock: %lu Hz\r\n", (unsigned long)SystemCoreClock);
+    timer.start();
+    return verbose_test_setup_handler(num_cases);
+}
+
+Specification specification(test_setup, cases);
+
+int main() {
+    return !Harness::run(specification);
+}
@@ -0,0 +1,632 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#if !defined(TARGET_LIKE_POSIX)
+    #error [NOT_SUPPORTED] Host test, build with the Makefile in this directory
+#endif
+
+/* Host test and benchmark of batched ECDSA verification in mbed TLS
+ *
+ * mbedtls_ecp_muladd_many is checked against sums of mbedtls_ecp_muladd,
+ * mbedtls_ecp_point_from_x against the points of random keys, and
+ * mbedtls_ecp_check_signed_sum against sums with random signs. Batches of
+ * signatures under one key and under several are then verified as they
+ * are, and with signatures, hashes and keys corrupted at random: the
+ * results must be those of mbedtls_ecdsa_verify, signature by signature.
+ * secp224r1, with P = 1 mod 4, goes through the fallback.
+ *
+ * Last, batches of 1 to 64 secp256r1 signatures are timed against as many
+ * calls to mbedtls_ecdsa_verify.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+
+#include "mbedtls/config.h"
+#include "mbedtls/ecp.h"
+#include "mbedtls/ecdsa.h"
+#include "mbedtls/entropy.h"
+#include "mbedtls/ctr_drbg.h"
+#include "mbedtls/memory_buffer_alloc.h"
+
+#define HEAP_SIZE       (256 * 1024)
+#define SIGNATURES      64
+#define KEYS            8
+#define MAX_TERMS       6
+#define RANDOM_TESTS    200
+#define CORRUPT_TESTS   50
+#define BENCHMARK_NS    300000000
+
+#define CHECK(cond) do {                                                \
+        if (!(cond)) {                                                  \
+            printf("HOST: %s:%d: check failed: %s\r\n",                 \
+                   __FILE__, __LINE__, #cond);                          \
+            exit(EXIT_FAILURE);                                         \
+        }                                                               \
+    } while (0)
+
+
+// Entropy for mbed TLS, as a TRNG would give it on a target
+int mbedtls_hardware_poll(void *data, unsigned char *output, size_t len, size_t *olen)
+{
+    static int fd = -1;
+    if (fd < 0) {
+        fd = open("/dev/urandom", O_RDONLY);
+    }
+
+    ssize_t ret = fd < 0 ? -1 : read(fd, output, len);
+    *olen = ret < 0 ? 0 : ret;
+    return ret < 0 ? -1 : 0;
+}
+
+static unsigned char heap[HEAP_SIZE];
+
+// Heap the DRBG holds
+static size_t heap_base;
+
+static size_t heap_used(void)
+{
+    size_t used, blocks;
+    mbedtls_memory_buffer_alloc_cur_get(&used, &blocks);
+    return used;
+}
+
+static size_t heap_peak(void)
+{
+    size_t used, blocks;
+    mbedtls_memory_buffer_alloc_max_get(&used, &blocks);
+    return used;
+}
+
+static uint64_t nanoseconds(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+static mbedtls_entropy_context entropy;
+static mbedtls_ctr_drbg_context drbg;
+
+// Reproducible choices of the tests
+static uint32_t seed = 0x12345678;
+
+static uint32_t rand32(void)
+{
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    return seed;
+}
+
+static void rand_bytes(unsigned char *buf, size_t len)
+{
+    for (size_t i = 0; i < len; i++) {
+        buf[i] = rand32();
+    }
+}
+
+
+// Random scalar below 2^nbits, with the edge cases now and then
+static void rand_scalar(const mbedtls_ecp_group *grp, mbedtls_mpi *m)
+{
+    size_t bytes = (grp->nbits + 7) / 8;
+
+    switch (rand32() % 8) {
+        case 0:
+            CHECK(mbedtls_mpi_lset(m, rand32() % 3) == 0);
+            break;
+        case 1:
+            CHECK(mbedtls_mpi_sub_int(m, &grp->N, 1 + rand32() % 2) == 0);
+            break;
+        case 2:
+            CHECK(mbedtls_mpi_lset(m, 0) == 0);
+            for (size_t i = 0; i < grp->nbits; i++) {
+                CHECK(mbedtls_mpi_set_bit(m, i, 1) == 0);
+            }
+            break;
+        default:
+            CHECK(mbedtls_mpi_fill_random(m, bytes, mbedtls_ctr_drbg_random, &drbg) == 0);
+            CHECK(mbedtls_mpi_shift_r(m, 8 * bytes - grp->nbits) == 0);
+            break;
+    }
+}
+
+static void negate(const mbedtls_ecp_group *grp, mbedtls_ecp_point *Q,
+                   const mbedtls_ecp_point *P)
+{
+    CHECK(mbedtls_ecp_copy(Q, P) == 0);
+    if (mbedtls_mpi_cmp_int(&Q->Y, 0) != 0) {
+        CHECK(mbedtls_mpi_sub_mpi(&Q->Y, &grp->P, &Q->Y) == 0);
+    }
+}
+
+// Random point, its secret thrown away
+static void rand_point(mbedtls_ecp_group *grp, mbedtls_ecp_point *P)
+{
+    mbedtls_mpi d;
+    mbedtls_mpi_init(&d);
+    CHECK(mbedtls_ecp_gen_keypair(grp, &d, P, mbedtls_ctr_drbg_random, &drbg) == 0);
+    mbedtls_mpi_free(&d);
+}
+
+
+static void check_muladd_many(const char *curve, mbedtls_ecp_group_id id)
+{
+    mbedtls_ecp_group grp;
+    mbedtls_ecp_point P[MAX_TERMS], R, ref;
+    mbedtls_mpi m[MAX_TERMS], mm, one;
+
+    mbedtls_ecp_group_init(&grp);
+    mbedtls_ecp_point_init(&R);
+    mbedtls_ecp_point_init(&ref);
+    mbedtls_mpi_init(&mm);
+    mbedtls_mpi_init(&one);
+    for (int i = 0; i < MAX_TERMS; i++) {
+        mbedtls_ecp_point_init(&P[i]);
+        mbedtls_mpi_init(&m[i]);
+    }
+
+    CHECK(mbedtls_ecp_group_load(&grp, id) == 0);
+    CHECK(mbedtls_mpi_lset(&one, 1) == 0);
+
+    for (int t = 0; t < RANDOM_TESTS; t++) {
+        int count = 1 + t % MAX_TERMS;
+
+        for (int i = 0; i < count; i++) {
+            rand_scalar(&grp, &m[i]);
+
+            // The generator, repeated points, and opposite points with
+            // the same scalar, whose terms cancel out
+            switch (i > 0 ? rand32() % 8 : rand32() % 2) {
+                case 0:
+                    CHECK(mbedtls_ecp_copy(&P[i], &grp.G) == 0);
+                    break;
+                case 2:
+                    CHECK(mbedtls_ecp_copy(&P[i], &P[i - 1]) == 0);
+                    break;
+                case 3:
+                    negate(&grp, &P[i], &P[i - 1]);
+                    CHECK(mbedtls_mpi_copy(&m[i], &m[i - 1]) == 0);
+                    break;
+                default:
+                    rand_point(&grp, &P[i]);
+                    break;
+            }
+        }
+
+        CHECK(mbedtls_ecp_muladd_many(&grp, &R, m, P, count) == 0);
+
+        CHECK(mbedtls_ecp_set_zero(&ref) == 0);
+        for (int i = 0; i < count; i++) {
+            // mbedtls_ecp_mul takes no multiple of N
+            CHECK(mbedtls_mpi_mod_mpi(&mm, &m[i], &grp.N) == 0);
+            if (mbedtls_mpi_cmp_int(&mm, 0) == 0) {
+                continue;
+            }
+            CHECK(mbedtls_ecp_muladd(&grp, &ref, &one, &ref, &mm, &P[i]) == 0);
+        }
+        CHECK(mbedtls_ecp_point_cmp(&R, &ref) == 0);
+    }
+
+    // No terms
+    CHECK(mbedtls_ecp_muladd_many(&grp, &R, m, P, 0) == 0);
+    CHECK(mbedtls_ecp_is_zero(&R));
+
+    // Scalar of nbits + 1 bits
+    CHECK(mbedtls_mpi_lset(&m[0], 0) == 0);
+    CHECK(mbedtls_mpi_set_bit(&m[0], grp.nbits, 1) == 0);
+    CHECK(mbedtls_ecp_muladd_many(&grp, &R, m, P, 1) == MBEDTLS_ERR_ECP_INVALID_KEY);
+
+    // Point off the curve, or not normalized
+    CHECK(mbedtls_mpi_lset(&m[0], 5) == 0);
+    CHECK(mbedtls_ecp_copy(&P[0], &grp.G) == 0);
+    CHECK(mbedtls_mpi_add_int(&P[0].Y, &P[0].Y, 1) == 0);
+    CHECK(mbedtls_ecp_muladd_many(&grp, &R, m, P, 1) == MBEDTLS_ERR_ECP_INVALID_KEY);
+    CHECK(mbedtls_ecp_copy(&P[0], &grp.G) == 0);
+    CHECK(mbedtls_mpi_lset(&P[0].Z, 2) == 0);
+    CHECK(mbedtls_ecp_muladd_many(&grp, &R, m, P, 1) != 0);
+
+    for (int i = 0; i < MAX_TERMS; i++) {
+        mbedtls_ecp_point_free(&P[i]);
+        mbedtls_mpi_free(&m[i]);
+    }
+    mbedtls_mpi_free(&mm);
+    mbedtls_mpi_free(&one);
+    mbedtls_ecp_point_free(&R);
+    mbedtls_ecp_point_free(&ref);
+    mbedtls_ecp_group_free(&grp);
+    CHECK(heap_used() == heap_base);
+
+    printf("HOST: %s: mbedtls_ecp_muladd_many matches mbedtls_ecp_muladd "
+           "on %d sums\r\n", curve, RANDOM_TESTS);
+}
+
+
+static void check_point_from_x(const char *curve, mbedtls_ecp_group_id id)
+{
+    mbedtls_ecp_group grp;
+    mbedtls_ecp_point Q, pt;
+    mbedtls_mpi x;
+    int found = 0, ret;
+
+    mbedtls_ecp_group_init(&grp);
+    mbedtls_ecp_point_init(&Q);
+    mbedtls_ecp_point_init(&pt);
+    mbedtls_mpi_init(&x);
+    CHECK(mbedtls_ecp_group_load(&grp, id) == 0);
+
+    if (mbedtls_mpi_get_bit(&grp.P, 1) == 0) {
+        rand_point(&grp, &Q);
+        CHECK(mbedtls_ecp_point_from_x(&grp, &pt, &Q.X) == MBEDTLS_ERR_ECP_FEATURE_UNAVAILABLE);
+        printf("HOST: %s: no square roots with P = 1 mod 4\r\n", curve);
+        goto exit;
+    }
+
+    for (int t = 0; t < RANDOM_TESTS; t++) {
+        rand_point(&grp, &Q);
+        CHECK(mbedtls_ecp_point_from_x(&grp, &pt, &Q.X) == 0);
+        CHECK(mbedtls_mpi_cmp_int(&pt.Z, 1) == 0);
+        CHECK(mbedtls_mpi_cmp_mpi(&pt.X, &Q.X) == 0);
+        if (mbedtls_mpi_cmp_mpi(&pt.Y, &Q.Y) != 0) {
+            negate(&grp, &pt, &pt);
+            CHECK(mbedtls_mpi_cmp_mpi(&pt.Y, &Q.Y) == 0);
+        }
+
+        // About half of the x-coordinates are those of points
+        CHECK(mbedtls_mpi_fill_random(&x, (grp.pbits + 7) / 8,
+                                      mbedtls_ctr_drbg_random, &drbg) == 0);
+        CHECK(mbedtls_mpi_mod_mpi(&x, &x, &grp.P) == 0);
+        ret = mbedtls_ecp_point_from_x(&grp, &pt, &x);
+        CHECK(ret == 0 || ret == MBEDTLS_ERR_ECP_INVALID_KEY);
+        if (ret == 0) {
+            CHECK(mbedtls_ecp_check_pubkey(&grp, &pt) == 0);
+            found++;
+        }
+    }
+    CHECK(found > RANDOM_TESTS / 4 && found < 3 * RANDOM_TESTS / 4);
+
+    printf("HOST: %s: mbedtls_ecp_point_from_x finds the points of %d keys, "
+           "and of %d random x out of %d\r\n", curve, RANDOM_TESTS, found, RANDOM_TESTS);
+
+exit:
+    mbedtls_mpi_free(&x);
+    mbedtls_ecp_point_free(&Q);
+    mbedtls_ecp_point_free(&pt);
+    mbedtls_ecp_group_free(&grp);
+    CHECK(heap_used() == heap_base);
+}
+
+
+static void check_signed_sum(const char *curve, mbedtls_ecp_group_id id)
+{
+    mbedtls_ecp_group grp;
+    mbedtls_ecp_point T[KEYS], A, N;
+    mbedtls_mpi one;
+
+    mbedtls_ecp_group_init(&grp);
+    mbedtls_ecp_point_init(&A);
+    mbedtls_ecp_point_init(&N);
+    mbedtls_mpi_init(&one);
+    for (int i = 0; i < KEYS; i++) {
+        mbedtls_ecp_point_init(&T[i]);
+    }
+
+    CHECK(mbedtls_ecp_group_load(&grp, id) == 0);
+    CHECK(mbedtls_mpi_lset(&one, 1) == 0);
+
+    for (int t = 0; t < RANDOM_TESTS / 4; t++) {
+        int count = 1 + t % KEYS;
+
+        CHECK(mbedtls_ecp_set_zero(&A) == 0);
+        for (int i = 0; i < count; i++) {
+            rand_point(&grp, &T[i]);
+            if (rand32() % 2) {
+                negate(&grp, &N, &T[i]);
+            } else {
+                CHECK(mbedtls_ecp_copy(&N, &T[i]) == 0);
+            }
+            CHECK(mbedtls_ecp_muladd(&grp, &A, &one, &A, &one, &N) == 0);
+        }
+        CHECK(!mbedtls_ecp_is_zero(&A));
+
+        CHECK(mbedtls_ecp_check_signed_sum(&grp, &A, T, count) == 0);
+        negate(&grp, &A, &A);
+        CHECK(mbedtls_ecp_check_signed_sum(&grp, &A, T, count) == 0);
+
+        // Off by the generator, or by a missing term
+        CHECK(mbedtls_ecp_muladd(&grp, &N, &one, &A, &one, &grp.G) == 0);
+        CHECK(mbedtls_ecp_check_signed_sum(&grp, &N, T, count) ==
+              MBEDTLS_ERR_ECP_VERIFY_FAILED);
+        if (count > 1) {
+            CHECK(mbedtls_ecp_check_signed_sum(&grp, &A, T, count - 1) ==
+                  MBEDTLS_ERR_ECP_VERIFY_FAILED);
+        }
+    }
+
+    CHECK(mbedtls_ecp_check_signed_sum(&grp, &A, T, 0) == MBEDTLS_ERR_ECP_BAD_INPUT_DATA);
+
+    for (int i = 0; i < KEYS; i++) {
+        mbedtls_ecp_point_free(&T[i]);
+    }
+    mbedtls_mpi_free(&one);
+    mbedtls_ecp_point_free(&A);
+    mbedtls_ecp_point_free(&N);
+    mbedtls_ecp_group_free(&grp);
+    CHECK(heap_used() == heap_base);
+
+    printf("HOST: %s: mbedtls_ecp_check_signed_sum finds sums of up to %d "
+           "points\r\n", curve, KEYS);
+}
+
+
+// Signatures under nkeys keys, and the items that point to them
+static mbedtls_ecp_keypair keys[KEYS + 1];
+static unsigned char hashes[SIGNATURES][64];
+static size_t hlens[SIGNATURES];
+static mbedtls_mpi r[SIGNATURES], s[SIGNATURES];
+static mbedtls_ecdsa_batch_item items[SIGNATURES];
+
+static void sign_all(mbedtls_ecp_group *grp, mbedtls_ecp_group_id id, int nkeys)
+{
+    static const size_t lens[] = {32, 20, 48, 64};
+
+    // keys[KEYS] signs nothing, for signatures under the wrong key
+    for (int k = 0; k <= KEYS; k++) {
+        mbedtls_ecp_keypair_init(&keys[k]);
+        if (k < nkeys || k == KEYS) {
+            CHECK(mbedtls_ecp_gen_key(id, &keys[k], mbedtls_ctr_drbg_random, &drbg) == 0);
+        }
+    }
+
+    for (int i = 0; i < SIGNATURES; i++) {
+        int k = rand32() % nkeys;
+
+        hlens[i] = lens[rand32() % 4];
+        rand_bytes(hashes[i], hlens[i]);
+        mbedtls_mpi_init(&r[i]);
+        mbedtls_mpi_init(&s[i]);
+        CHECK(mbedtls_ecdsa_sign(grp, &r[i], &s[i], &keys[k].d, hashes[i], hlens[i],
+                                 mbedtls_ctr_drbg_random, &drbg) == 0);
+
+        items[i].hash = hashes[i];
+        items[i].hlen = hlens[i];
+        items[i].Q = &keys[k].Q;
+        items[i].r = &r[i];
+        items[i].s = &s[i];
+    }
+}
+
+static void free_all(void)
+{
+    for (int k = 0; k <= KEYS; k++) {
+        mbedtls_ecp_keypair_free(&keys[k]);
+    }
+    for (int i = 0; i < SIGNATURES; i++) {
+        mbedtls_mpi_free(&r[i]);
+        mbedtls_mpi_free(&s[i]);
+    }
+}
+
+static void check_batch(const char *curve, mbedtls_ecp_group_id id, int nkeys)
+{
+    static const size_t counts[] = {0, 1, 2, 3, 7, 8, 9, 17, SIGNATURES};
+    mbedtls_ecp_group grp;
+    mbedtls_ecp_point bad_Q;
+    int results[SIGNATURES], expected[SIGNATURES];
+    int corrupted = 0;
+
+    mbedtls_ecp_group_init(&grp);
+    mbedtls_ecp_point_init(&bad_Q);
+    CHECK(mbedtls_ecp_group_load(&grp, id) == 0);
+    sign_all(&grp, id, nkeys);
+
+    // Off the curve
+    CHECK(mbedtls_ecp_copy(&bad_Q, &keys[0].Q) == 0);
+    CHECK(mbedtls_mpi_add_int(&bad_Q.Y, &bad_Q.Y, 1) == 0);
+
+    for (size_t c = 0; c < sizeof counts / sizeof counts[0]; c++) {
+        memset(results, 0xff, sizeof results);
+        CHECK(mbedtls_ecdsa_verify_batch(&grp, items, counts[c], results,
+                                         mbedtls_ctr_drbg_random, &drbg) == 0);
+        for (size_t i = 0; i < counts[c]; i++) {
+            CHECK(results[i] == 0);
+        }
+        CHECK(mbedtls_ecdsa_verify_batch(&grp, items, counts[c], NULL,
+                                         mbedtls_ctr_drbg_random, &drbg) == 0);
+    }
+
+    for (int t = 0; t < CORRUPT_TESTS; t++) {
+        size_t count = 1 + rand32() % SIGNATURES;
+        int bad = 1 + rand32() % 3;
+        size_t which[3];
+        int first = 0, any = 0;
+
+        // Up to three signatures corrupted
+        for (int b = 0; b < bad; b++) {
+            size_t i = which[b] = rand32() % count;
+            switch (rand32() % 8) {
+                case 0:
+                    CHECK(mbedtls_mpi_add_int(&r[i], &r[i], 1) == 0);
+                    break;
+                case 1:
+                    CHECK(mbedtls_mpi_add_int(&s[i], &s[i], 1) == 0);
+                    break;
+                case 2:
+                    hashes[i][rand32() % 16] ^= 1 << rand32() % 8;
+                    break;
+                case 3:
+                    items[i].Q = &keys[KEYS].Q;
+                    break;
+                case 4:
+                    items[i].Q = &bad_Q;
+                    break;
+                case 5:
+                    // r of another signature, whose point is on the curve
+                    CHECK(mbedtls_mpi_copy(&r[i], &r[(i + 1) % SIGNATURES]) == 0);
+                    break;
+                case 6:
+                    CHECK(mbedtls_mpi_lset(&r[i], rand32() % 2 ? 0 : 1) == 0);
+                    break;
+                default:
+                    // -s is valid as well
+                    CHECK(mbedtls_mpi_sub_mpi(&s[i], &grp.N, &s[i]) == 0);
+                    break;
+            }
+        }
+
+        for (size_t i = 0; i < count; i++) {
+            expected[i] = mbedtls_ecdsa_verify(&grp, items[i].hash, items[i].hlen,
+                                               items[i].Q, items[i].r, items[i].s);
+            if (expected[i] != 0) {
+                if (!any) {
+                    first = expected[i];
+                }
+                any = 1;
+                corrupted++;
+            }
+        }
+
+        int ret = mbedtls_ecdsa_verify_batch(&grp, items, count, results,
+                                             mbedtls_ctr_drbg_random, &drbg);
+        CHECK(any ? ret != 0 : ret == 0);
+        CHECK(ret == 0 || ret == MBEDTLS_ERR_ECP_VERIFY_FAILED ||
+              ret == MBEDTLS_ERR_ECP_INVALID_KEY);
+        CHECK(memcmp(results, expected, count * sizeof results[0]) == 0);
+
+        CHECK(mbedtls_ecdsa_verify_batch(&grp, items, count, NULL,
+                                         mbedtls_ctr_drbg_random, &drbg) == first);
+
+        // Signed again, under any of the keys
+        for (int b = 0; b < bad; b++) {
+            size_t i = which[b];
+            int k = rand32() % nkeys;
+            items[i].Q = &keys[k].Q;
+            CHECK(mbedtls_ecdsa_sign(&grp, &r[i], &s[i], &keys[k].d, hashes[i],
+                                     hlens[i], mbedtls_ctr_drbg_random, &drbg) == 0);
+        }
+    }
+
+    // Curves without ECDSA, and no RNG
+    mbedtls_ecp_group x25519;
+    mbedtls_ecp_group_init(&x25519);
+    CHECK(mbedtls_ecp_group_load(&x25519, MBEDTLS_ECP_DP_CURVE25519) == 0);
+    CHECK(mbedtls_ecdsa_verify_batch(&x25519, items, 2, results,
+                                     mbedtls_ctr_drbg_random, &drbg) ==
+          MBEDTLS_ERR_ECP_BAD_INPUT_DATA);
+    mbedtls_ecp_group_free(&x25519);
+    CHECK(mbedtls_ecdsa_verify_batch(&grp, items, 2, results, NULL, NULL) ==
+          MBEDTLS_ERR_ECP_BAD_INPUT_DATA);
+
+    mbedtls_ecp_point_free(&bad_Q);
+    free_all();
+    mbedtls_ecp_group_free(&grp);
+    CHECK(heap_used() == heap_base);
+
+    printf("HOST: %s: %d key%s, batches agree with mbedtls_ecdsa_verify on "
+           "%d invalid signatures\r\n", curve, nkeys, nkeys > 1 ? "s" : " ",
+           corrupted);
+}
+
+
+// Microseconds per signature, sequentially and in batches
+static void benchmark(int nkeys)
+{
+    static const size_t counts[] = {1, 2, 4, 8, 16, SIGNATURES};
+    mbedtls_ecp_group grp;
+    int results[SIGNATURES];
+    uint64_t start, elapsed;
+    unsigned long n;
+
+    mbedtls_ecp_group_init(&grp);
+    CHECK(mbedtls_ecp_group_load(&grp, MBEDTLS_ECP_DP_SECP256R1) == 0);
+    sign_all(&grp, MBEDTLS_ECP_DP_SECP256R1, nkeys);
+
+    for (size_t c = 0; c < sizeof counts / sizeof counts[0]; c++) {
+        size_t count = counts[c];
+        double sequential, batch;
+
+        start = nanoseconds();
+        for (n = 0; (elapsed = nanoseconds() - start) < BENCHMARK_NS; n++) {
+            for (size_t i = 0; i < count; i++) {
+                CHECK(mbedtls_ecdsa_verify(&grp, items[i].hash, items[i].hlen,
+                                           items[i].Q, items[i].r, items[i].s) == 0);
+            }
+        }
+        sequential = (double)elapsed / n / count / 1000;
+
+        mbedtls_memory_buffer_alloc_max_reset();
+        size_t base = heap_used();
+        start = nanoseconds();
+        for (n = 0; (elapsed = nanoseconds() - start) < BENCHMARK_NS; n++) {
+            CHECK(mbedtls_ecdsa_verify_batch(&grp, items, count, results,
+                                             mbedtls_ctr_drbg_random, &drbg) == 0);
+        }
+        batch = (double)elapsed / n / count / 1000;
+
+        printf("HOST: secp256r1 %d key%s, %2u signatures: verify %6.1f us, "
+               "batch %6.1f us per signature (x%.2f), peak heap %5u B\r\n",
+               nkeys, nkeys > 1 ? "s" : " ", (unsigned)count, sequential, batch,
+               sequential / batch, (unsigned)(heap_peak() - base));
+    }
+
+    free_all();
+    mbedtls_ecp_group_free(&grp);
+    CHECK(heap_used() == heap_base);
+}
+
+
+int main(void)
+{
+    mbedtls_memory_buffer_alloc_init(heap, sizeof heap);
+
+    mbedtls_entropy_init(&entropy);
+    mbedtls_ctr_drbg_init(&drbg);
+    CHECK(mbedtls_ctr_drbg_seed(&drbg, mbedtls_entropy_func, &entropy, NULL, 0) == 0);
+    heap_base = heap_used();
+
+    check_muladd_many("secp256r1", MBEDTLS_ECP_DP_SECP256R1);
+    check_muladd_many("secp256k1", MBEDTLS_ECP_DP_SECP256K1);
+    check_muladd_many("secp224r1", MBEDTLS_ECP_DP_SECP224R1);
+    check_point_from_x("secp256r1", MBEDTLS_ECP_DP_SECP256R1);
+    check_point_from_x("secp384r1", MBEDTLS_ECP_DP_SECP384R1);
+    check_point_from_x("secp256k1", MBEDTLS_ECP_DP_SECP256K1);
+    check_point_from_x("secp224r1", MBEDTLS_ECP_DP_SECP224R1);
+    check_signed_sum("secp256r1", MBEDTLS_ECP_DP_SECP256R1);
+    check_signed_sum("secp256k1", MBEDTLS_ECP_DP_SECP256K1);
+
+    check_batch("secp256r1", MBEDTLS_ECP_DP_SECP256R1, 1);
+    check_batch("secp256r1", MBEDTLS_ECP_DP_SECP256R1, KEYS);
+    check_batch("secp384r1", MBEDTLS_ECP_DP_SECP384R1, 3);
+    check_batch("secp256k1", MBEDTLS_ECP_DP_SECP256K1, 3);
+    check_batch("secp224r1", MBEDTLS_ECP_DP_SECP224R1, 3);
+
+    benchmark(1);
+    benchmark(KEYS);
+
+    mbedtls_ctr_drbg_free(&drbg);
+    mbedtls_entropy_free(&entropy);
+    CHECK(heap_used() == 0);
+    CHECK(mbedtls_memory_buffer_alloc_verify() == 0);
+    mbedtls_memory_buffer_alloc_free();
+
+    printf("HOST: all passed\r\n");
+    return 0;
+}
@@ -0,0 +1,31 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* mbed TLS user configuration of the ecp_comb host test, included at
+ * the end of mbedtls/config.h
+ */
+
+// All allocations of mbed TLS come from the heap of memory_buffer_alloc,
+// which keeps count of the bytes in use
+#define MBEDTLS_PLATFORM_MEMORY
+#define MBEDTLS_MEMORY_BUFFER_ALLOC_C
+#define MBEDTLS_MEMORY_DEBUG
+
+// The runtime build computes the tables of the generator, as mbed TLS is
+// configured by default
+#if !defined(ECP_COMB_RUNTIME)
+#define MBEDTLS_ECP_FIXED_POINT_TABLES
+#endif
@@ -0,0 +1,264 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#if !defined(TARGET_LIKE_POSIX)
+    #error [NOT_SUPPORTED] Host test, build with the Makefile in this directory
+#endif
+
+/* Host benchmark of fixed-point multiplication in mbed TLS
+ *
+ * For secp256r1 and secp384r1, times key generation on a newly loaded
+ * group, which computes the table of the generator unless it is built in,
+ * and on a loaded one, ECDSA signatures and verifications, and ECDH with a
+ * static peer key, before and after the key pair precomputes its own
+ * table. The heap of memory_buffer_alloc counts the RAM the tables take.
+ *
+ * Checks that the built-in tables, generated by the mbed TLS importer, are
+ * the ones the comb method computes.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+
+#include "mbedtls/config.h"
+#include "mbedtls/ecp.h"
+#include "mbedtls/ecdsa.h"
+#include "mbedtls/ecdh.h"
+#include "mbedtls/entropy.h"
+#include "mbedtls/ctr_drbg.h"
+#include "mbedtls/memory_buffer_alloc.h"
+
+#define HEAP_SIZE   (128 * 1024)
+#define ROUNDS      20
+
+#if defined(MBEDTLS_ECP_FIXED_POINT_TABLES)
+#define TABLES      "built-in"
+#else
+#define TABLES      "runtime"
+#endif
+
+#define CHECK(cond) do {                                                \
+        if (!(cond)) {                                                  \
+            printf("HOST: %s:%d: check failed: %s\r\n",                 \
+                   __FILE__, __LINE__, #cond);                          \
+            exit(EXIT_FAILURE);                                         \
+        }                                                               \
+    } while (0)
+
+
+// Entropy for mbed TLS, as a TRNG would give it on a target
+int mbedtls_hardware_poll(void *data, unsigned char *output, size_t len, size_t *olen)
+{
+    static int fd = -1;
+    if (fd < 0) {
+        fd = open("/dev/urandom", O_RDONLY);
+    }
+
+    ssize_t ret = fd < 0 ? -1 : read(fd, output, len);
+    *olen = ret < 0 ? 0 : ret;
+    return ret < 0 ? -1 : 0;
+}
+
+static unsigned char heap[HEAP_SIZE];
+
+static size_t heap_used(void)
+{
+    size_t used, blocks;
+    mbedtls_memory_buffer_alloc_cur_get(&used, &blocks);
+    return used;
+}
+
+static mbedtls_entropy_context entropy;
+static mbedtls_ctr_drbg_context drbg;
+
+static struct timespec start;
+
+static void timer_start(void)
+{
+    clock_gettime(CLOCK_MONOTONIC, &start);
+}
+
+// Milliseconds since timer_start, per round
+static double timer_ms(unsigned rounds)
+{
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    return ((end.tv_sec - start.tv_sec) * 1e3
+            + (end.tv_nsec - start.tv_nsec) / 1e6) / rounds;
+}
+
+
+// Points the comb method uses for the generator, as it computes them
+static void runtime_table(mbedtls_ecp_group *grp, mbedtls_ecp_group_id id)
+{
+    mbedtls_ecp_keypair g;
+    mbedtls_ecp_keypair_init(&g);
+    CHECK(mbedtls_ecp_group_load(&g.grp, id) == 0);
+    CHECK(mbedtls_ecp_copy(&g.Q, &g.grp.G) == 0);
+    CHECK(mbedtls_ecp_keypair_precompute(&g) == 0);
+
+    *grp = g.grp;
+    mbedtls_ecp_point_free(&g.Q);
+    mbedtls_mpi_free(&g.d);
+}
+
+static void bench(const char *curve, mbedtls_ecp_group_id id)
+{
+    mbedtls_ecp_group grp;
+    mbedtls_ecp_keypair key;
+    mbedtls_ecp_point R;
+    mbedtls_mpi d, r, s, z, zz;
+    unsigned char hash[32];
+    unsigned i;
+
+    mbedtls_ecp_point_init(&R);
+    mbedtls_mpi_init(&d);
+    mbedtls_mpi_init(&r);
+    mbedtls_mpi_init(&s);
+    mbedtls_mpi_init(&z);
+    mbedtls_mpi_init(&zz);
+    memset(hash, 0x5a, sizeof hash);
+
+    // The built-in table is the one the comb method computes
+    mbedtls_ecp_group_init(&grp);
+    CHECK(mbedtls_ecp_group_load(&grp, id) == 0);
+    mbedtls_ecp_group runtime;
+    runtime_table(&runtime, id);
+#if defined(MBEDTLS_ECP_FIXED_POINT_TABLES)
+    CHECK(grp.T != NULL && grp.T_size == 0);
+    for (i = 0; i < runtime.TF_size; i++) {
+        CHECK(mbedtls_mpi_cmp_mpi(&grp.T[i].X, &runtime.TF[i].X) == 0);
+        CHECK(mbedtls_mpi_cmp_mpi(&grp.T[i].Y, &runtime.TF[i].Y) == 0);
+    }
+#else
+    CHECK(grp.T == NULL);
+#endif
+    mbedtls_ecp_group_free(&runtime);
+
+    // RAM the generator's table takes once the group has used it
+    size_t base = heap_used();
+    CHECK(mbedtls_ecp_gen_keypair(&grp, &d, &R, mbedtls_ctr_drbg_random, &drbg) == 0);
+    mbedtls_ecp_point_free(&R);
+    mbedtls_mpi_free(&d);
+    size_t table_ram = heap_used() - base;
+    mbedtls_ecp_group_free(&grp);
+
+    // Key generation with a newly loaded group, then with a loaded one
+    timer_start();
+    for (i = 0; i < ROUNDS; i++) {
+        mbedtls_ecp_keypair_init(&key);
+        CHECK(mbedtls_ecp_gen_key(id, &key, mbedtls_ctr_drbg_random, &drbg) == 0);
+        mbedtls_ecp_keypair_free(&key);
+    }
+    double keygen_cold = timer_ms(ROUNDS);
+
+    mbedtls_ecp_keypair_init(&key);
+    CHECK(mbedtls_ecp_gen_key(id, &key, mbedtls_ctr_drbg_random, &drbg) == 0);
+
+    timer_start();
+    for (i = 0; i < ROUNDS; i++) {
+        CHECK(mbedtls_ecp_gen_keypair(&key.grp, &d, &R,
+                mbedtls_ctr_drbg_random, &drbg) == 0);
+    }
+    double keygen = timer_ms(ROUNDS);
+
+    timer_start();
+    for (i = 0; i < ROUNDS; i++) {
+        CHECK(mbedtls_ecdsa_sign(&key.grp, &r, &s, &key.d, hash, sizeof hash,
+                mbedtls_ctr_drbg_random, &drbg) == 0);
+    }
+    double sign = timer_ms(ROUNDS);
+
+    // Verification, and ECDH with the key as static peer key, before and
+    // after the key precomputes the table of its public point
+    timer_start();
+    for (i = 0; i < ROUNDS; i++) {
+        CHECK(mbedtls_ecdsa_verify(&key.grp, hash, sizeof hash, &key.Q, &r, &s) == 0);
+    }
+    double verify = timer_ms(ROUNDS);
+
+    timer_start();
+    for (i = 0; i < ROUNDS; i++) {
+        CHECK(mbedtls_ecdh_compute_shared(&key.grp, &z, &key.Q, &d,
+                mbedtls_ctr_drbg_random, &drbg) == 0);
+    }
+    double ecdh = timer_ms(ROUNDS);
+
+    base = heap_used();
+    timer_start();
+    CHECK(mbedtls_ecp_keypair_precompute(&key) == 0);
+    double precompute = timer_ms(1);
+    size_t key_ram = heap_used() - base;
+
+    timer_start();
+    for (i = 0; i < ROUNDS; i++) {
+        CHECK(mbedtls_ecdsa_verify(&key.grp, hash, sizeof hash, &key.Q, &r, &s) == 0);
+    }
+    double verify_fixed = timer_ms(ROUNDS);
+
+    timer_start();
+    for (i = 0; i < ROUNDS; i++) {
+        CHECK(mbedtls_ecdh_compute_shared(&key.grp, &zz, &key.Q, &d,
+                mbedtls_ctr_drbg_random, &drbg) == 0);
+    }
+    double ecdh_fixed = timer_ms(ROUNDS);
+    CHECK(mbedtls_mpi_cmp_mpi(&z, &zz) == 0);
+
+    // A wrong signature still fails with the key's table
+    CHECK(mbedtls_mpi_add_int(&s, &s, 1) == 0);
+    CHECK(mbedtls_ecdsa_verify(&key.grp, hash, sizeof hash, &key.Q, &r, &s) != 0);
+
+    mbedtls_ecp_keypair_free(&key);
+    mbedtls_ecp_point_free(&R);
+    mbedtls_mpi_free(&d);
+    mbedtls_mpi_free(&r);
+    mbedtls_mpi_free(&s);
+    mbedtls_mpi_free(&z);
+    mbedtls_mpi_free(&zz);
+
+    printf("HOST: %-8s %s generator: table RAM %5u B, keygen new group %6.2f ms, "
+           "keygen %6.2f ms, sign %6.2f ms\r\n",
+           TABLES, curve, (unsigned)table_ram, keygen_cold, keygen, sign);
+    printf("HOST: %-8s %s key:       table RAM %5u B, precompute %6.2f ms, "
+           "verify %6.2f -> %6.2f ms, ECDH %6.2f -> %6.2f ms\r\n",
+           TABLES, curve, (unsigned)key_ram, precompute,
+           verify, verify_fixed, ecdh, ecdh_fixed);
+}
+
+int main(void)
+{
+    mbedtls_memory_buffer_alloc_init(heap, sizeof heap);
+
+    mbedtls_entropy_init(&entropy);
+    mbedtls_ctr_drbg_init(&drbg);
+    CHECK(mbedtls_ctr_drbg_seed(&drbg, mbedtls_entropy_func, &entropy, NULL, 0) == 0);
+
+    bench("secp256r1", MBEDTLS_ECP_DP_SECP256R1);
+    bench("secp384r1", MBEDTLS_ECP_DP_SECP384R1);
+
+    mbedtls_ctr_drbg_free(&drbg);
+    mbedtls_entropy_free(&entropy);
+    CHECK(heap_used() == 0);
+    CHECK(mbedtls_memory_buffer_alloc_verify() == 0);
+    mbedtls_memory_buffer_alloc_free();
+
+    printf("HOST: all passed\r\n");
+    return 0;
+}
@@ -0,0 +1,33 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* mbed TLS user configuration of the gcm_kernels host test, included at
+ * the end of mbedtls/config.h
+ */
+
+// AES-CTR on its own, to check the counter carries
+#define MBEDTLS_CIPHER_MODE_CTR
+
+// The default build keeps the kernels as they were
+#if defined(GCM_KERNELS_CTR) || defined(GCM_KERNELS_TABLE8) || defined(GCM_KERNELS_CT)
+#define MBEDTLS_AES_CTR_BLOCKS
+#endif
+
+#if defined(GCM_KERNELS_TABLE8)
+#define MBEDTLS_GCM_GHASH_TABLE8
+#elif defined(GCM_KERNELS_CT)
+#define MBEDTLS_GCM_GHASH_CT
+#endif
@@ -0,0 +1,433 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#if !defined(TARGET_LIKE_POSIX)
+    #error [NOT_SUPPORTED] Host test, build with the Makefile in this directory
+#endif
+
+/* Host test of the GHASH and AES-CTR kernels of mbed TLS
+ *
+ * Each build selects kernels in gcm_kernels_config.h. AES-GCM is checked
+ * against the NIST vectors of the self tests, then against a reference
+ * written from SP800-38D, with GHASH a bit at a time and the counter mode
+ * on mbedtls_aes_crypt_ecb, over random keys, IVs, additional data and
+ * messages fed in random pieces, in place and with the output trailing the
+ * input. AES-CTR is checked the same way around the carries out of the
+ * counter bytes. Throughput is then measured on DTLS-sized records.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+
+#include "mbedtls/config.h"
+#include "mbedtls/aes.h"
+#include "mbedtls/gcm.h"
+
+#if defined(MBEDTLS_GCM_GHASH_TABLE8)
+#define GHASH       "8-bit tables"
+#elif defined(MBEDTLS_GCM_GHASH_CT)
+#define GHASH       "constant time"
+#else
+#define GHASH       "4-bit tables"
+#endif
+
+#if defined(MBEDTLS_AES_CTR_BLOCKS)
+#define CTR         "whole blocks"
+#else
+#define CTR         "block by block"
+#endif
+
+#define RANDOM_TESTS    2000
+#define MAX_LEN         5000
+#define BENCHMARK_NS    200000000
+
+#define CHECK(cond) do {                                                \
+        if (!(cond)) {                                                  \
+            printf("HOST: %s:%d: check failed: %s\r\n",                 \
+                   __FILE__, __LINE__, #cond);                          \
+            exit(EXIT_FAILURE);                                         \
+        }                                                               \
+    } while (0)
+
+
+// Entropy for mbed TLS, as a TRNG would give it on a target
+int mbedtls_hardware_poll(void *data, unsigned char *output, size_t len, size_t *olen)
+{
+    static int fd = -1;
+    if (fd < 0) {
+        fd = open("/dev/urandom", O_RDONLY);
+    }
+
+    ssize_t ret = fd < 0 ? -1 : read(fd, output, len);
+    *olen = ret < 0 ? 0 : ret;
+    return ret < 0 ? -1 : 0;
+}
+
+static uint64_t nanoseconds(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+// Reproducible test data
+static uint32_t seed = 0x12345678;
+
+static uint32_t rand32(void)
+{
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    return seed;
+}
+
+static void rand_bytes(unsigned char *buf, size_t len)
+{
+    for (size_t i = 0; i < len; i++) {
+        buf[i] = rand32();
+    }
+}
+
+
+// GCM as SP800-38D describes it, a bit at a time
+static void ref_mult(unsigned char x[16], const unsigned char h[16])
+{
+    unsigned char z[16] = {0};
+    unsigned char v[16];
+    memcpy(v, h, 16);
+
+    for (int i = 0; i < 128; i++) {
+        if ((x[i / 8] >> (7 - i % 8)) & 1) {
+            for (int j = 0; j < 16; j++) {
+                z[j] ^= v[j];
+            }
+        }
+
+        int lsb = v[15] & 1;
+        for (int j = 15; j > 0; j--) {
+            v[j] = (v[j] >> 1) | (v[j - 1] << 7);
+        }
+        v[0] >>= 1;
+        if (lsb) {
+            v[0] ^= 0xe1;
+        }
+    }
+
+    memcpy(x, z, 16);
+}
+
+static void ref_ghash(unsigned char s[16], const unsigned char h[16],
+                      const unsigned char *data, size_t len)
+{
+    while (len > 0) {
+        size_t n = len < 16 ? len : 16;
+        for (size_t i = 0; i < n; i++) {
+            s[i] ^= data[i];
+        }
+        ref_mult(s, h);
+        data += n;
+        len -= n;
+    }
+}
+
+static void ref_gcm(int mode, const unsigned char *key, unsigned keybits,
+                    const unsigned char *iv, size_t iv_len,
+                    const unsigned char *add, size_t add_len,
+                    const unsigned char *input, size_t len,
+                    unsigned char *output, unsigned char tag[16])
+{
+    mbedtls_aes_context aes;
+    unsigned char h[16] = {0}, j0[16] = {0}, cb[16], ectr[16], s[16] = {0};
+    unsigned char lens[16] = {0};
+
+    mbedtls_aes_init(&aes);
+    CHECK(mbedtls_aes_setkey_enc(&aes, key, keybits) == 0);
+    mbedtls_aes_crypt_ecb(&aes, MBEDTLS_AES_ENCRYPT, h, h);
+
+    if (iv_len == 12) {
+        memcpy(j0, iv, 12);
+        j0[15] = 1;
+    } else {
+        ref_ghash(j0, h, iv, iv_len);
+        for (int i = 0; i < 8; i++) {
+            lens[15 - i] = (uint64_t)iv_len * 8 >> (8 * i);
+        }
+        ref_ghash(j0, h, lens, 16);
+    }
+
+    memcpy(cb, j0, 16);
+    for (size_t off = 0; off < len; off += 16) {
+        for (int i = 15; i >= 12 && ++cb[i] == 0; i--) {
+        }
+        mbedtls_aes_crypt_ecb(&aes, MBEDTLS_AES_ENCRYPT, cb, ectr);
+        for (size_t i = off; i < len && i < off + 16; i++) {
+            output[i] = input[i] ^ ectr[i - off];
+        }
+    }
+
+    ref_ghash(s, h, add, add_len);
+    ref_ghash(s, h, mode == MBEDTLS_GCM_DECRYPT ? input : output, len);
+
+    for (int i = 0; i < 8; i++) {
+        lens[7 - i] = (uint64_t)add_len * 8 >> (8 * i);
+        lens[15 - i] = (uint64_t)len * 8 >> (8 * i);
+    }
+    ref_ghash(s, h, lens, 16);
+
+    mbedtls_aes_crypt_ecb(&aes, MBEDTLS_AES_ENCRYPT, j0, tag);
+    for (int i = 0; i < 16; i++) {
+        tag[i] ^= s[i];
+    }
+
+    mbedtls_aes_free(&aes);
+}
+
+
+static unsigned char in[MAX_LEN + 16];
+static unsigned char buf[MAX_LEN + 16];
+static unsigned char ref[MAX_LEN + 16];
+
+// Feeds len bytes from input to mbedtls_gcm_update in random pieces, all but
+// the last a multiple of 16 bytes
+static void gcm_update_pieces(mbedtls_gcm_context *gcm, size_t len,
+                              const unsigned char *input, unsigned char *output)
+{
+    while (len > 0) {
+        size_t n = 16 * (rand32() % 20);
+        if (n == 0 || n > len) {
+            n = len;
+        }
+        CHECK(mbedtls_gcm_update(gcm, n, input, output) == 0);
+        input += n;
+        output += n;
+        len -= n;
+    }
+}
+
+static void check_gcm(void)
+{
+    static const unsigned keybits[] = {128, 192, 256};
+    mbedtls_gcm_context gcm;
+    unsigned char key[32], iv[64], add[80], tag[16], ref_tag[16];
+
+    mbedtls_gcm_init(&gcm);
+
+    for (int t = 0; t < RANDOM_TESTS; t++) {
+        unsigned bits = keybits[t % 3];
+        size_t iv_len = rand32() % 2 ? 12 : 1 + rand32() % sizeof iv;
+        size_t add_len = rand32() % sizeof add;
+        // Mostly short records, some long enough for byte 15 of the counter
+        // to wrap around
+        size_t len = t % 16 ? rand32() % 300 : rand32() % MAX_LEN;
+
+        rand_bytes(key, sizeof key);
+        rand_bytes(iv, sizeof iv);
+        rand_bytes(add, sizeof add);
+        rand_bytes(in, len);
+
+        CHECK(mbedtls_gcm_setkey(&gcm, MBEDTLS_CIPHER_ID_AES, key, bits) == 0);
+
+        // Encryption in place
+        ref_gcm(MBEDTLS_GCM_ENCRYPT, key, bits, iv, iv_len, add, add_len,
+                in, len, ref, ref_tag);
+        memcpy(buf, in, len);
+        CHECK(mbedtls_gcm_starts(&gcm, MBEDTLS_GCM_ENCRYPT, iv, iv_len,
+                                 add, add_len) == 0);
+        gcm_update_pieces(&gcm, len, buf, buf);
+        CHECK(mbedtls_gcm_finish(&gcm, tag, 16) == 0);
+        CHECK(memcmp(buf, ref, len) == 0);
+        CHECK(memcmp(tag, ref_tag, 16) == 0);
+
+        // Decryption with the output trailing the input, as TLS does to
+        // drop the explicit IV
+        size_t lag = 8 * (1 + rand32() % 2);
+        memcpy(buf + lag, ref, len);
+        CHECK(mbedtls_gcm_starts(&gcm, MBEDTLS_GCM_DECRYPT, iv, iv_len,
+                                 add, add_len) == 0);
+        gcm_update_pieces(&gcm, len, buf + lag, buf);
+        CHECK(mbedtls_gcm_finish(&gcm, tag, 16) == 0);
+        CHECK(memcmp(buf, in, len) == 0);
+        CHECK(memcmp(tag, ref_tag, 16) == 0);
+    }
+
+    mbedtls_gcm_free(&gcm);
+    printf("HOST: AES-GCM matches the reference on %d random messages\r\n",
+           RANDOM_TESTS);
+}
+
+
+#if defined(MBEDTLS_CIPHER_MODE_CTR)
+// AES-CTR across the carries out of the last bytes of the counter
+static void check_ctr(void)
+{
+    static const unsigned char tails[][4] = {
+        {0x00, 0x00, 0x00, 0x00},
+        {0x00, 0x00, 0x00, 0xf0},
+        {0x00, 0x00, 0xff, 0xfe},
+        {0xff, 0xff, 0xff, 0xf8},
+    };
+    mbedtls_aes_context aes;
+    unsigned char key[16], nonce[16], counter[16], ref_counter[16];
+    unsigned char stream[16], ectr[16];
+
+    mbedtls_aes_init(&aes);
+
+    for (int t = 0; t < 200; t++) {
+        size_t len = rand32() % 1200;
+        size_t off = 0;
+
+        rand_bytes(key, sizeof key);
+        rand_bytes(nonce, sizeof nonce);
+        memcpy(nonce + 12, tails[t % 4], 4);
+        if (t % 8 == 3) {
+            // Carry into byte 11 and beyond
+            memset(nonce + 8, 0xff, 4);
+        }
+        rand_bytes(in, len);
+        CHECK(mbedtls_aes_setkey_enc(&aes, key, 128) == 0);
+
+        memcpy(ref_counter, nonce, 16);
+        for (size_t i = 0; i < len; i += 16) {
+            mbedtls_aes_crypt_ecb(&aes, MBEDTLS_AES_ENCRYPT, ref_counter, ectr);
+            for (size_t j = i; j < len && j < i + 16; j++) {
+                ref[j] = in[j] ^ ectr[j - i];
+            }
+            for (int j = 15; j >= 0 && ++ref_counter[j] == 0; j--) {
+            }
+        }
+
+        // In random pieces, in place
+        memcpy(counter, nonce, 16);
+        memcpy(buf, in, len);
+        for (size_t done = 0; done < len; ) {
+            size_t n = rand32() % 100;
+            if (n > len - done) {
+                n = len - done;
+            }
+            CHECK(mbedtls_aes_crypt_ctr(&aes, n, &off, counter, stream,
+                                        buf + done, buf + done) == 0);
+            done += n;
+        }
+        CHECK(memcmp(buf, ref, len) == 0);
+        CHECK(memcmp(counter, ref_counter, 16) == 0);
+    }
+
+#if defined(MBEDTLS_AES_CTR_BLOCKS)
+    // The 32-bit counter of GCM wraps around without carrying into byte 11
+    memset(nonce, 0xa5, 12);
+    memset(nonce + 12, 0xff, 4);
+    nonce[15] = 0xf0;
+    memcpy(counter, nonce, 16);
+    memcpy(ref_counter, nonce, 16);
+    rand_bytes(in, 64 * 16);
+    for (size_t i = 0; i < 64 * 16; i += 16) {
+        mbedtls_aes_crypt_ecb(&aes, MBEDTLS_AES_ENCRYPT, ref_counter, ectr);
+        for (size_t j = 0; j < 16; j++) {
+            ref[i + j] = in[i + j] ^ ectr[j];
+        }
+        for (int j = 15; j >= 12 && ++ref_counter[j] == 0; j--) {
+        }
+    }
+    CHECK(mbedtls_aes_crypt_ctr32(&aes, 64, counter, in, buf) == 0);
+    CHECK(memcmp(buf, ref, 64 * 16) == 0);
+    CHECK(memcmp(counter, ref_counter, 16) == 0);
+#endif
+
+    mbedtls_aes_free(&aes);
+    printf("HOST: AES-CTR matches the reference around counter carries\r\n");
+}
+#endif /* MBEDTLS_CIPHER_MODE_CTR */
+
+
+// Throughput in ns per byte, on data of len bytes
+static void benchmark(size_t len)
+{
+    mbedtls_gcm_context gcm;
+    unsigned char key[16], iv[12], add[13], tag[16];
+    uint64_t start, elapsed;
+    unsigned long n;
+
+    rand_bytes(key, sizeof key);
+    rand_bytes(iv, sizeof iv);
+    rand_bytes(add, sizeof add);
+    rand_bytes(in, len);
+
+    mbedtls_gcm_init(&gcm);
+    CHECK(mbedtls_gcm_setkey(&gcm, MBEDTLS_CIPHER_ID_AES, key, 128) == 0);
+
+    // AES-128-GCM as a DTLS record: 13 bytes of additional data
+    start = nanoseconds();
+    for (n = 0; (elapsed = nanoseconds() - start) < BENCHMARK_NS; n++) {
+        CHECK(mbedtls_gcm_crypt_and_tag(&gcm, MBEDTLS_GCM_ENCRYPT, len, iv, 12,
+                                        add, sizeof add, in, buf, 16, tag) == 0);
+    }
+    printf("HOST: AES-128-GCM %5lu bytes: %6.2f ns/byte\r\n",
+           (unsigned long)len, (double)elapsed / n / len);
+
+    // GHASH alone, as GMAC over the same length
+    start = nanoseconds();
+    for (n = 0; (elapsed = nanoseconds() - start) < BENCHMARK_NS; n++) {
+        CHECK(mbedtls_gcm_crypt_and_tag(&gcm, MBEDTLS_GCM_ENCRYPT, 0, iv, 12,
+                                        in, len, NULL, NULL, 16, tag) == 0);
+    }
+    printf("HOST: GMAC        %5lu bytes: %6.2f ns/byte\r\n",
+           (unsigned long)len, (double)elapsed / n / len);
+
+    mbedtls_gcm_free(&gcm);
+
+#if defined(MBEDTLS_CIPHER_MODE_CTR)
+    mbedtls_aes_context aes;
+    unsigned char nonce[16] = {0}, stream[16];
+    size_t off = 0;
+
+    mbedtls_aes_init(&aes);
+    CHECK(mbedtls_aes_setkey_enc(&aes, key, 128) == 0);
+
+    start = nanoseconds();
+    for (n = 0; (elapsed = nanoseconds() - start) < BENCHMARK_NS; n++) {
+        CHECK(mbedtls_aes_crypt_ctr(&aes, len, &off, nonce, stream, in, buf) == 0);
+    }
+    printf("HOST: AES-128-CTR %5lu bytes: %6.2f ns/byte\r\n",
+           (unsigned long)len, (double)elapsed / n / len);
+
+    mbedtls_aes_free(&aes);
+#endif
+}
+
+
+int main(void)
+{
+    printf("HOST: GHASH with %s, AES-CTR %s\r\n", GHASH, CTR);
+
+    CHECK(mbedtls_aes_self_test(0) == 0);
+    CHECK(mbedtls_gcm_self_test(0) == 0);
+
+    check_gcm();
+#if defined(MBEDTLS_CIPHER_MODE_CTR)
+    check_ctr();
+#endif
+
+    benchmark(64);
+    benchmark(1024);
+    benchmark(16384);
+
+    printf("HOST: all passed\r\n");
+    return 0;
+}
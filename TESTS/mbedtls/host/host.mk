@@ -0,0 +1,76 @@
+# Rules shared by the mbed TLS host tests. The Makefile of each test sets
+# the following, then includes this file:
+#
+#   TARGET          name of the test directory and of its main binary
+#   CONFIG          mbed TLS user configuration of the test, if any
+#   VARIANTS        further builds of the test, each binary $(TARGET)_<v>
+#                   compiled with -D<TARGET>_<V> in upper case
+#   SRCS_EXTRA      sources besides main.c and those of mbed TLS
+#   INCLUDES_EXTRA  include directories besides . and those of mbed TLS
+#   RUN_EXTRA       command "make run" runs after the binaries
+#
+# "make run" builds and runs the variants, then $(TARGET), and
+# "make CFLAGS_EXTRA=-O0" overrides optimisation and other flags. Objects do
+# not track headers, "make clean" after changing one.
+
+MBED    := ../../../..
+MBEDTLS := $(MBED)/features/mbedtls
+
+SRCS := \
+	main.c \
+	$(SRCS_EXTRA) \
+	$(wildcard $(MBEDTLS)/src/*.c)
+
+INCLUDES := \
+	-I. \
+	$(INCLUDES_EXTRA) \
+	-I$(MBEDTLS) \
+	-I$(MBEDTLS)/inc
+
+DEFINES := -DTARGET_LIKE_POSIX -DMBEDTLS_ENTROPY_HARDWARE_ALT
+ifneq ($(CONFIG),)
+DEFINES += -DMBEDTLS_USER_CONFIG_FILE='"$(CONFIG)"'
+endif
+
+CFLAGS_EXTRA ?= -O2
+CFLAGS   := -std=gnu99 -g -Wall -Wno-unused-function $(CFLAGS_EXTRA) $(DEFINES) $(INCLUDES)
+
+OBJDIR := build
+OBJS := $(addprefix $(OBJDIR)/,$(notdir $(SRCS:.c=.o)))
+BINS := $(addprefix $(TARGET)_,$(VARIANTS)) $(TARGET)
+
+vpath %.c $(sort $(dir $(SRCS)))
+
+all: $(BINS)
+
+$(TARGET): $(OBJS)
+	$(CC) -o $@ $^
+
+$(OBJDIR)/%.o: %.c | $(OBJDIR)
+	$(CC) $(CFLAGS) -c -o $@ $<
+
+$(OBJDIR):
+	mkdir -p $@
+
+# One object directory per variant
+define variant
+$(TARGET)_$(1): $(addprefix $(OBJDIR)/$(1)/,$(notdir $(SRCS:.c=.o)))
+	$$(CC) -o $$@ $$^
+
+$(OBJDIR)/$(1)/%.o: %.c | $(OBJDIR)/$(1)
+	$$(CC) $$(CFLAGS) -D$(shell echo $(TARGET)_$(1) | tr a-z A-Z) -c -o $$@ $$<
+
+$(OBJDIR)/$(1):
+	mkdir -p $$@
+endef
+
+$(foreach v,$(VARIANTS),$(eval $(call variant,$(v))))
+
+run: $(BINS)
+	$(foreach b,$(BINS),./$(b) &&) true
+	$(RUN_EXTRA)
+
+clean:
+	rm -rf $(OBJDIR) $(BINS)
+
+.PHONY: all run clean
@@ -0,0 +1,130 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#if !defined(TARGET_LIKE_POSIX)
+    #error [NOT_SUPPORTED] Host test, build with the Makefile in this directory
+#endif
+
+/* Host build of the mbed TLS benchmarks
+ *
+ * Runs the benchmarks of TESTS/mbedtls/benchmark against mbed TLS as
+ * config.h configures it, and prints one line per benchmark in the
+ * format of the greentea test, so results from a PC and from targets
+ * can be tracked side by side.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "benchmark.h"
+
+#define CHECK(cond) do {                                                \
+        if (!(cond)) {                                                  \
+            printf("HOST: %s:%d: check failed: %s\r\n",                 \
+                   __FILE__, __LINE__, #cond);                          \
+            exit(EXIT_FAILURE);                                         \
+        }                                                               \
+    } while (0)
+
+
+// Entropy for mbed TLS, as a TRNG would give it on a target
+int mbedtls_hardware_poll(void *data, unsigned char *output, size_t len, size_t *olen)
+{
+    static int fd = -1;
+    if (fd < 0) {
+        fd = open("/dev/urandom", O_RDONLY);
+    }
+
+    ssize_t ret = fd < 0 ? -1 : read(fd, output, len);
+    *olen = ret < 0 ? 0 : ret;
+    return ret < 0 ? -1 : 0;
+}
+
+
+static uint64_t nanoseconds(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+// The time stamp counter, at the rate measured against the monotonic clock
+static uint64_t tsc_rate;
+
+uint64_t benchmark_cycles(void)
+{
+    return __rdtsc();
+}
+
+uint64_t benchmark_cycles_per_second(void)
+{
+    if (!tsc_rate) {
+        uint64_t start_ns = nanoseconds();
+        uint64_t start = __rdtsc();
+        while (nanoseconds() - start_ns < 100000000) {
+        }
+        tsc_rate = (__rdtsc() - start) * 1000000000 / (nanoseconds() - start_ns);
+    }
+
+    return tsc_rate;
+}
+#else
+uint64_t benchmark_cycles(void)
+{
+    return nanoseconds();
+}
+
+uint64_t benchmark_cycles_per_second(void)
+{
+    return 1000000000;
+}
+#endif
+
+
+int main(void)
+{
+    benchmark_result_t result;
+    char text[32];
+    size_t i;
+
+    printf("HOST: %lu cycles/s, %u ms per benchmark\r\n",
+           (unsigned long)benchmark_cycles_per_second(), BENCHMARK_MS);
+
+    for (i = 0; i < BENCHMARK_COUNT; i++) {
+        int ret = benchmark_run(i, &result);
+        if (ret == BENCHMARK_SKIPPED) {
+            printf("HOST: %s: not configured\r\n", benchmark_name(i));
+            continue;
+        }
+
+        CHECK(ret == 0);
+        CHECK(result.ops > 0);
+        benchmark_format(&result, text, sizeof text);
+        printf("HOST: %s: %s\r\n", benchmark_name(i), text);
+    }
+
+    CHECK(benchmark_run(BENCHMARK_COUNT, &result) == BENCHMARK_SKIPPED);
+
+    printf("HOST: all passed\r\n");
+    return 0;
+}
@@ -0,0 +1,537 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#if !defined(TARGET_LIKE_POSIX)
+    #error [NOT_SUPPORTED] Host test, build with the Makefile in this directory
+#endif
+
+/* Host benchmark of the slabs of the mbed TLS buffer allocator
+ *
+ * A connection parses its certificates and key, and a client and a server
+ * context handshake over in-memory pipes and echo a record, all on the heap
+ * of memory_buffer_alloc. Each connection is timed, and the allocations and
+ * frees of the first one are recorded and replayed on their own, to time
+ * the allocator without the cryptography around it. The heap reports its
+ * peak and the fragmentation of its free space once established.
+ *
+ * Random allocations of random sizes then check that blocks and chunks
+ * never overlap and come zeroed, and that a heap filled with small chunks
+ * gives all of its room back for one large allocation.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "mbedtls/config.h"
+#include "mbedtls/platform.h"
+#include "mbedtls/ssl.h"
+#include "mbedtls/entropy.h"
+#include "mbedtls/ctr_drbg.h"
+#include "mbedtls/certs.h"
+#include "mbedtls/memory_buffer_alloc.h"
+
+#define SERVER_NAME "localhost"
+#define PIPE_SIZE   (64 * 1024)
+#define HEAP_SIZE   (256 * 1024)
+#define MAX_ROUNDS  10000
+#define CONNECTIONS 20
+#define REPLAYS     200
+#define MAX_OPS     400000
+#define STRESS_OPS  200000
+#define STRESS_LIVE 512
+#define SEED        0x2017
+
+#if defined(MBEDTLS_MEMORY_BUFFER_ALLOC_SLABS)
+#define ALLOCATOR   "slabs"
+#else
+#define ALLOCATOR   "first fit"
+#endif
+
+#define CHECK(cond) do {                                                \
+        if (!(cond)) {                                                  \
+            printf("HOST: %s:%d: check failed: %s\r\n",                 \
+                   __FILE__, __LINE__, #cond);                          \
+            exit(EXIT_FAILURE);                                         \
+        }                                                               \
+    } while (0)
+
+#define WOULD_BLOCK(ret) \
+    ((ret) == MBEDTLS_ERR_SSL_WANT_READ || (ret) == MBEDTLS_ERR_SSL_WANT_WRITE)
+
+
+// Entropy for mbed TLS, from a fixed seed rather than from the host, so
+// that every run makes the same keys and so the same allocations. Only fit
+// for a benchmark.
+int mbedtls_hardware_poll(void *data, unsigned char *output, size_t len, size_t *olen)
+{
+    static uint64_t state = SEED;
+
+    for (size_t i = 0; i < len; i++) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        output[i] = (unsigned char)state;
+    }
+
+    *olen = len;
+    return 0;
+}
+
+// Fixed time, which the hello messages carry and so the signatures cover
+static mbedtls_time_t fixed_time(mbedtls_time_t *timer)
+{
+    if (timer) {
+        *timer = SEED;
+    }
+    return SEED;
+}
+
+static uint64_t nanoseconds(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+
+// In-memory pipes
+struct pipe {
+    size_t len;
+    unsigned char buf[PIPE_SIZE];
+};
+
+struct pipe_end {
+    struct pipe *send;
+    struct pipe *recv;
+};
+
+static struct pipe to_server;
+static struct pipe to_client;
+static struct pipe_end cli_end = {&to_server, &to_client};
+static struct pipe_end srv_end = {&to_client, &to_server};
+
+static int pipe_send(void *ctx, const unsigned char *buf, size_t len)
+{
+    struct pipe *p = ((struct pipe_end *)ctx)->send;
+    if (p->len + len > PIPE_SIZE) {
+        return MBEDTLS_ERR_SSL_WANT_WRITE;
+    }
+
+    memcpy(p->buf + p->len, buf, len);
+    p->len += len;
+    return len;
+}
+
+static int pipe_recv(void *ctx, unsigned char *buf, size_t len)
+{
+    struct pipe *p = ((struct pipe_end *)ctx)->recv;
+    if (p->len == 0) {
+        return MBEDTLS_ERR_SSL_WANT_READ;
+    }
+
+    size_t n = p->len < len ? p->len : len;
+    memcpy(buf, p->buf, n);
+    memmove(p->buf, p->buf + n, p->len - n);
+    p->len -= n;
+    return n;
+}
+
+
+// Heap, with the allocations of a connection recorded in order
+static unsigned char heap[HEAP_SIZE];
+
+static void *(*heap_calloc)(size_t, size_t);
+static void (*heap_free)(void *);
+
+struct op {
+    int alloc;
+    unsigned slot;
+    size_t size;
+};
+
+static struct op ops[MAX_OPS];
+static unsigned op_count;
+static void *live[MAX_OPS];
+
+static void *recording_calloc(size_t n, size_t size)
+{
+    void *ptr = heap_calloc(n, size);
+    CHECK(ptr != NULL && op_count < MAX_OPS);
+
+    ops[op_count].alloc = 1;
+    ops[op_count].slot = op_count;
+    ops[op_count].size = n * size;
+    live[op_count++] = ptr;
+    return ptr;
+}
+
+static void recording_free(void *ptr)
+{
+    unsigned slot;
+    if (ptr == NULL) {
+        return;
+    }
+
+    for (slot = 0; slot < op_count && live[slot] != ptr; slot++) {
+    }
+
+    CHECK(slot < op_count && op_count < MAX_OPS);
+    ops[op_count].alloc = 0;
+    ops[op_count].slot = slot;
+    ops[op_count].size = 0;
+    live[op_count++] = NULL;
+    live[slot] = NULL;
+    heap_free(ptr);
+}
+
+static size_t heap_used(void)
+{
+    size_t used, blocks;
+    mbedtls_memory_buffer_alloc_cur_get(&used, &blocks);
+    return used;
+}
+
+static size_t heap_peak(void)
+{
+    size_t used, blocks;
+    mbedtls_memory_buffer_alloc_max_get(&used, &blocks);
+    return used;
+}
+
+
+// Connection pair
+static mbedtls_entropy_context entropy;
+static mbedtls_ctr_drbg_context drbg;
+
+struct connection {
+    const char *name;
+    const char *ca_crt;
+    const char *srv_crt;
+    const char *srv_key;
+};
+
+static const struct connection connections[] = {
+    { "ECDHE-ECDSA", mbedtls_test_ca_crt_ec, mbedtls_test_srv_crt_ec, mbedtls_test_srv_key_ec },
+    { "ECDHE-RSA", mbedtls_test_ca_crt_rsa, mbedtls_test_srv_crt_rsa, mbedtls_test_srv_key_rsa },
+};
+
+struct stats {
+    size_t peak;
+    size_t free_bytes;
+    size_t free_blocks;
+    size_t largest_free;
+};
+
+static void connect(const struct connection *c, struct stats *stats)
+{
+    static unsigned char tx[1000], echo[sizeof tx], rx[sizeof tx];
+    mbedtls_x509_crt ca_crt, srv_crt;
+    mbedtls_pk_context srv_key;
+    mbedtls_ssl_config cli_conf, srv_conf;
+    mbedtls_ssl_context cli, srv;
+
+    memset(&to_server, 0, sizeof to_server);
+    memset(&to_client, 0, sizeof to_client);
+    size_t base = heap_used();
+    mbedtls_memory_buffer_alloc_max_reset();
+
+    mbedtls_x509_crt_init(&ca_crt);
+    mbedtls_x509_crt_init(&srv_crt);
+    mbedtls_pk_init(&srv_key);
+    CHECK(mbedtls_x509_crt_parse(&ca_crt, (const unsigned char *)c->ca_crt,
+            strlen(c->ca_crt) + 1) == 0);
+    CHECK(mbedtls_x509_crt_parse(&srv_crt, (const unsigned char *)c->srv_crt,
+            strlen(c->srv_crt) + 1) == 0);
+    CHECK(mbedtls_pk_parse_key(&srv_key, (const unsigned char *)c->srv_key,
+            strlen(c->srv_key) + 1, NULL, 0) == 0);
+
+    mbedtls_ssl_config_init(&cli_conf);
+    CHECK(mbedtls_ssl_config_defaults(&cli_conf, MBEDTLS_SSL_IS_CLIENT,
+            MBEDTLS_SSL_TRANSPORT_STREAM, MBEDTLS_SSL_PRESET_DEFAULT) == 0);
+    mbedtls_ssl_conf_rng(&cli_conf, mbedtls_ctr_drbg_random, &drbg);
+    mbedtls_ssl_conf_ca_chain(&cli_conf, &ca_crt, NULL);
+    mbedtls_ssl_conf_authmode(&cli_conf, MBEDTLS_SSL_VERIFY_REQUIRED);
+
+    mbedtls_ssl_config_init(&srv_conf);
+    CHECK(mbedtls_ssl_config_defaults(&srv_conf, MBEDTLS_SSL_IS_SERVER,
+            MBEDTLS_SSL_TRANSPORT_STREAM, MBEDTLS_SSL_PRESET_DEFAULT) == 0);
+    mbedtls_ssl_conf_rng(&srv_conf, mbedtls_ctr_drbg_random, &drbg);
+    CHECK(mbedtls_ssl_conf_own_cert(&srv_conf, &srv_crt, &srv_key) == 0);
+
+    mbedtls_ssl_init(&cli);
+    CHECK(mbedtls_ssl_setup(&cli, &cli_conf) == 0);
+    CHECK(mbedtls_ssl_set_hostname(&cli, SERVER_NAME) == 0);
+    mbedtls_ssl_set_bio(&cli, &cli_end, pipe_send, pipe_recv, NULL);
+
+    mbedtls_ssl_init(&srv);
+    CHECK(mbedtls_ssl_setup(&srv, &srv_conf) == 0);
+    mbedtls_ssl_set_bio(&srv, &srv_end, pipe_send, pipe_recv, NULL);
+
+    int cli_ret = MBEDTLS_ERR_SSL_WANT_READ;
+    int srv_ret = MBEDTLS_ERR_SSL_WANT_READ;
+    for (int i = 0; cli_ret || srv_ret; i++) {
+        CHECK(i < MAX_ROUNDS);
+        if (cli_ret) {
+            cli_ret = mbedtls_ssl_handshake(&cli);
+            CHECK(cli_ret == 0 || WOULD_BLOCK(cli_ret));
+        }
+        if (srv_ret) {
+            srv_ret = mbedtls_ssl_handshake(&srv);
+            CHECK(srv_ret == 0 || WOULD_BLOCK(srv_ret));
+        }
+    }
+
+    // Client sends a record, the server echoes it back
+    for (size_t i = 0; i < sizeof tx; i++) {
+        tx[i] = rand();
+    }
+    CHECK(mbedtls_ssl_write(&cli, tx, sizeof tx) == sizeof tx);
+    size_t srv_got = 0, got = 0;
+    for (int i = 0; got < sizeof rx; i++) {
+        CHECK(i < MAX_ROUNDS);
+        int ret = mbedtls_ssl_read(&srv, echo + srv_got, sizeof echo - srv_got);
+        CHECK(ret > 0 || WOULD_BLOCK(ret));
+        if (ret > 0) {
+            CHECK(mbedtls_ssl_write(&srv, echo + srv_got, ret) == ret);
+            srv_got += ret;
+        }
+        ret = mbedtls_ssl_read(&cli, rx + got, sizeof rx - got);
+        CHECK(ret > 0 || WOULD_BLOCK(ret));
+        got += ret > 0 ? ret : 0;
+    }
+    CHECK(memcmp(tx, rx, sizeof tx) == 0);
+
+    if (stats) {
+        stats->peak = heap_peak() - base;
+        mbedtls_memory_buffer_alloc_frag_get(&stats->free_bytes,
+                &stats->free_blocks, &stats->largest_free);
+    }
+
+    mbedtls_ssl_free(&srv);
+    mbedtls_ssl_free(&cli);
+    mbedtls_ssl_config_free(&srv_conf);
+    mbedtls_ssl_config_free(&cli_conf);
+    mbedtls_pk_free(&srv_key);
+    mbedtls_x509_crt_free(&srv_crt);
+    mbedtls_x509_crt_free(&ca_crt);
+}
+
+// Random allocations, each filled with a pattern that is checked on free
+struct block {
+    unsigned char *ptr;
+    size_t size;
+    unsigned char fill;
+};
+
+static struct block blocks[STRESS_LIVE];
+
+static size_t random_size(void)
+{
+    // Mostly small, as bignums and ASN.1 nodes, some records and tables
+    switch (rand() % 8) {
+        case 0:
+            return 1 + rand() % 2048;
+        case 1:
+        case 2:
+            return 1 + rand() % 512;
+        default:
+            return 1 + rand() % 96;
+    }
+}
+
+// Allocates or frees a random block, returns 0 if an allocation failed
+static int churn(void)
+{
+    struct block *b = &blocks[rand() % STRESS_LIVE];
+
+    if (b->ptr) {
+        for (size_t j = 0; j < b->size; j++) {
+            CHECK(b->ptr[j] == b->fill);
+        }
+        mbedtls_free(b->ptr);
+        b->ptr = NULL;
+        return 1;
+    }
+
+    b->size = random_size();
+    b->ptr = mbedtls_calloc(1, b->size);
+    if (b->ptr == NULL) {
+        return 0;
+    }
+
+    for (size_t j = 0; j < b->size; j++) {
+        CHECK(b->ptr[j] == 0);
+    }
+    b->fill = rand();
+    memset(b->ptr, b->fill, b->size);
+    return 1;
+}
+
+static void release(void)
+{
+    for (int i = 0; i < STRESS_LIVE; i++) {
+        mbedtls_free(blocks[i].ptr);
+        blocks[i].ptr = NULL;
+    }
+}
+
+// Replays the recorded connection, with nothing but the allocator in the
+// loop, and returns the time of an allocation and its free
+static unsigned replay(unsigned allocs)
+{
+    uint64_t start = nanoseconds();
+    for (int i = 0; i < REPLAYS; i++) {
+        for (unsigned j = 0; j < op_count; j++) {
+            if (ops[j].alloc) {
+                live[j] = mbedtls_calloc(1, ops[j].size);
+                CHECK(live[j] != NULL);
+            } else {
+                mbedtls_free(live[ops[j].slot]);
+            }
+        }
+    }
+
+    return (nanoseconds() - start) / REPLAYS / allocs;
+}
+
+static void run(const struct connection *c)
+{
+    struct stats stats;
+
+    // The first connection is recorded
+    op_count = 0;
+    mbedtls_platform_set_calloc_free(recording_calloc, recording_free);
+    connect(c, &stats);
+    mbedtls_platform_set_calloc_free(heap_calloc, heap_free);
+
+    unsigned allocs = 0;
+    for (unsigned i = 0; i < op_count; i++) {
+        allocs += ops[i].alloc;
+        CHECK(!ops[i].alloc || live[i] == NULL);
+    }
+    CHECK(op_count == 2 * allocs);
+
+    uint64_t start = nanoseconds();
+    for (int i = 0; i < CONNECTIONS; i++) {
+        connect(c, NULL);
+    }
+    uint64_t connect_ns = (nanoseconds() - start) / CONNECTIONS;
+
+    // On its own, and next to other allocations of all sizes, as other
+    // connections and the application would leave them
+    unsigned replay_ns = replay(allocs);
+    for (int i = 0; i < STRESS_OPS; i++) {
+        churn();
+    }
+    unsigned fragmented_ns = replay(allocs);
+    release();
+
+    printf("HOST: %-9s %-11s %5u allocations, %4u.%03u ms per connection, "
+           "%4u ns per alloc/free pair, %4u ns fragmented\r\n",
+           ALLOCATOR, c->name, allocs,
+           (unsigned)(connect_ns / 1000000), (unsigned)(connect_ns / 1000 % 1000),
+           replay_ns, fragmented_ns);
+    printf("HOST: %-9s %-11s peak %6u B, established: %6u B free in %3u blocks, "
+           "largest %6u B\r\n",
+           ALLOCATOR, c->name, (unsigned)stats.peak, (unsigned)stats.free_bytes,
+           (unsigned)stats.free_blocks, (unsigned)stats.largest_free);
+}
+
+
+static void stress(size_t largest)
+{
+    size_t free_bytes, free_blocks, largest_free;
+    unsigned failed = 0;
+
+    for (int i = 0; i < STRESS_OPS; i++) {
+        failed += !churn();
+        if (i % 10000 == 0) {
+            CHECK(mbedtls_memory_buffer_alloc_verify() == 0);
+        }
+    }
+
+    mbedtls_memory_buffer_alloc_frag_get(&free_bytes, &free_blocks, &largest_free);
+    printf("HOST: %-9s random:     %6u B free in %3u blocks, largest %6u B, "
+           "%u of %u allocations failed\r\n",
+           ALLOCATOR, (unsigned)free_bytes, (unsigned)free_blocks,
+           (unsigned)largest_free, failed, STRESS_OPS);
+
+    release();
+    CHECK(mbedtls_memory_buffer_alloc_verify() == 0);
+
+    // Small chunks until the heap is full, then all of it back for one
+    // allocation of the whole heap
+    unsigned count = 0;
+    void *p, *head = NULL;
+    while ((p = mbedtls_calloc(1, sizeof(void *) + count % 64 * 4)) != NULL) {
+        *(void **)p = head;
+        head = p;
+        count++;
+    }
+    CHECK(count > 1000);
+    while (head) {
+        p = *(void **)head;
+        mbedtls_free(head);
+        head = p;
+    }
+
+    p = mbedtls_calloc(1, largest);
+    CHECK(p != NULL);
+    mbedtls_free(p);
+
+#if defined(MBEDTLS_MEMORY_BUFFER_ALLOC_SLABS)
+    size_t slab_bytes, slab_free;
+    mbedtls_memory_buffer_alloc_slab_get(&slab_bytes, &slab_free);
+    CHECK(slab_bytes == 0 && slab_free == 0);
+#endif
+
+    printf("HOST: %-9s filled with %u small allocations, %u B allocated "
+           "at once after\r\n", ALLOCATOR, count, (unsigned)largest);
+}
+
+int main(void)
+{
+    size_t free_bytes, free_blocks, largest_free;
+
+    mbedtls_memory_buffer_alloc_init(heap, sizeof heap);
+    heap_calloc = mbedtls_calloc;
+    heap_free = mbedtls_free;
+    mbedtls_memory_buffer_alloc_frag_get(&free_bytes, &free_blocks, &largest_free);
+    CHECK(free_blocks == 1 && largest_free == free_bytes);
+
+    srand(SEED);
+    mbedtls_platform_set_time(fixed_time);
+    mbedtls_entropy_init(&entropy);
+    mbedtls_ctr_drbg_init(&drbg);
+    CHECK(mbedtls_ctr_drbg_seed(&drbg, mbedtls_entropy_func, &entropy, NULL, 0) == 0);
+
+    for (size_t i = 0; i < sizeof connections / sizeof connections[0]; i++) {
+        run(&connections[i]);
+    }
+
+    stress(largest_free);
+
+    mbedtls_ctr_drbg_free(&drbg);
+    mbedtls_entropy_free(&entropy);
+    CHECK(mbedtls_memory_buffer_alloc_verify() == 0);
+    CHECK(mbedtls_memory_buffer_alloc_self_test(0) == 0);
+    mbedtls_memory_buffer_alloc_free();
+
+    printf("HOST: all passed\r\n");
+    return 0;
+}
@@ -0,0 +1,36 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* mbed TLS user configuration of the memory_slabs host test, included at
+ * the end of mbedtls/config.h
+ */
+
+// All allocations of mbed TLS come from the heap of memory_buffer_alloc,
+// which keeps count of the bytes in use
+#define MBEDTLS_PLATFORM_MEMORY
+#define MBEDTLS_MEMORY_BUFFER_ALLOC_C
+#define MBEDTLS_MEMORY_DEBUG
+
+// The first-fit build measures the allocator as it was
+#if !defined(MEMORY_SLABS_FIRST_FIT)
+#define MBEDTLS_MEMORY_BUFFER_ALLOC_SLABS
+#endif
+
+// The RSA test certificates are signed with SHA-1
+#define MBEDTLS_SHA1_C
+
+// main.c sets a fixed time, as the time goes into the handshake
+#define MBEDTLS_PLATFORM_TIME_ALT
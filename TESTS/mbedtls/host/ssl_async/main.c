@@ -0,0 +1,637 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#if !defined(TARGET_LIKE_POSIX)
+    #error [NOT_SUPPORTED] Host test, build with the Makefile in this directory
+#endif
+
+/* Host test of asynchronous private key operations in mbed TLS
+ *
+ * A client and a server context talk to each other over in-memory pipes.
+ * Their private key operations go to an engine that holds on to them for a
+ * round, as a worker thread or a crypto accelerator would, so the handshake
+ * returns MBEDTLS_ERR_SSL_WANT_ASYNC and is resumed. Covered are the
+ * server's ServerKeyExchange signature with ECDSA and RSA keys, its RSA
+ * premaster decryption, the client's CertificateVerify signature, over TLS
+ * 1.1, TLS 1.2 and DTLS, and engines that complete at once, fall back to
+ * the handshake's own operations, fail, or are cancelled.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "mbedtls/config.h"
+#include "mbedtls/ssl.h"
+#include "mbedtls/entropy.h"
+#include "mbedtls/ctr_drbg.h"
+#include "mbedtls/certs.h"
+
+#define SERVER_NAME "localhost"
+#define PIPE_SIZE   (64 * 1024)
+#define MAX_ROUNDS  10000
+#define ECHO_SIZE   1000
+
+#define CHECK(cond) do {                                                \
+        if (!(cond)) {                                                  \
+            printf("HOST: %s:%d: check failed: %s\r\n",                 \
+                   __FILE__, __LINE__, #cond);                          \
+            exit(EXIT_FAILURE);                                         \
+        }                                                               \
+    } while (0)
+
+#define WOULD_BLOCK(ret) \
+    ((ret) == MBEDTLS_ERR_SSL_WANT_READ || (ret) == MBEDTLS_ERR_SSL_WANT_WRITE)
+
+
+// Entropy for mbed TLS, as a TRNG would give it on a target
+int mbedtls_hardware_poll(void *data, unsigned char *output, size_t len, size_t *olen)
+{
+    static int fd = -1;
+    if (fd < 0) {
+        fd = open("/dev/urandom", O_RDONLY);
+    }
+
+    ssize_t ret = fd < 0 ? -1 : read(fd, output, len);
+    *olen = ret < 0 ? 0 : ret;
+    return ret < 0 ? -1 : 0;
+}
+
+
+// In-memory pipes, datagrams are queued behind a two-byte length
+struct pipe {
+    int dgram;
+    size_t len;
+    unsigned char buf[PIPE_SIZE];
+};
+
+struct pipe_end {
+    struct pipe *send;
+    struct pipe *recv;
+};
+
+static struct pipe to_server;
+static struct pipe to_client;
+static struct pipe_end cli_end = {&to_server, &to_client};
+static struct pipe_end srv_end = {&to_client, &to_server};
+
+static int pipe_send(void *ctx, const unsigned char *buf, size_t len)
+{
+    struct pipe *p = ((struct pipe_end *)ctx)->send;
+    size_t hdr = p->dgram ? 2 : 0;
+    if (p->len + hdr + len > PIPE_SIZE) {
+        return MBEDTLS_ERR_SSL_WANT_WRITE;
+    }
+
+    if (p->dgram) {
+        p->buf[p->len++] = len >> 8;
+        p->buf[p->len++] = len & 0xff;
+    }
+
+    memcpy(p->buf + p->len, buf, len);
+    p->len += len;
+    return len;
+}
+
+static int pipe_recv(void *ctx, unsigned char *buf, size_t len)
+{
+    struct pipe *p = ((struct pipe_end *)ctx)->recv;
+    if (p->len == 0) {
+        return MBEDTLS_ERR_SSL_WANT_READ;
+    }
+
+    size_t hdr = 0;
+    size_t avail = p->len;
+    if (p->dgram) {
+        hdr = 2;
+        avail = (p->buf[0] << 8) | p->buf[1];
+    }
+
+    size_t n = avail < len ? avail : len;
+    size_t consumed = p->dgram ? hdr + avail : n;
+    memcpy(buf, p->buf + hdr, n);
+    memmove(p->buf, p->buf + consumed, p->len - consumed);
+    p->len -= consumed;
+    return n;
+}
+
+// The pipes lose nothing, retransmission timers never need to expire
+static void timer_set(void *ctx, uint32_t int_ms, uint32_t fin_ms)
+{
+    *(uint32_t *)ctx = fin_ms;
+}
+
+static int timer_get(void *ctx)
+{
+    return *(uint32_t *)ctx ? 0 : -1;
+}
+
+
+// Keys and certificates
+static mbedtls_entropy_context entropy;
+static mbedtls_ctr_drbg_context drbg;
+static mbedtls_x509_crt ca_crt;
+static mbedtls_x509_crt srv_crt_ec;
+static mbedtls_pk_context srv_key_ec;
+static mbedtls_x509_crt srv_crt_rsa;
+static mbedtls_pk_context srv_key_rsa;
+static mbedtls_x509_crt cli_crt;
+static mbedtls_pk_context cli_key;
+
+static const unsigned char psk[16] = "mbed TLS psk";
+static const unsigned char psk_identity[] = "Client_identity";
+
+static mbedtls_pk_context *key_of(const mbedtls_x509_crt *crt)
+{
+    if (crt == &srv_crt_ec) {
+        return &srv_key_ec;
+    } else if (crt == &srv_crt_rsa) {
+        return &srv_key_rsa;
+    } else if (crt == &cli_crt) {
+        return &cli_key;
+    }
+
+    return NULL;
+}
+
+
+// Engine for the private key operations of one side, which holds on to
+// them until told to complete them
+enum engine_mode {
+    ENGINE_NONE,        // no callbacks
+    ENGINE_DEFER,       // operations complete on the next round
+    ENGINE_IMMEDIATE,   // operations complete in the start callback
+    ENGINE_FALLTHROUGH, // the handshake does operations itself
+    ENGINE_FAIL,        // operations fail on the next round
+};
+
+struct engine {
+    enum engine_mode mode;
+
+    // The operation in progress
+    int decrypt;
+    mbedtls_pk_context *key;
+    mbedtls_md_type_t md_alg;
+    unsigned char input[512];
+    size_t input_len;
+    int ready;
+
+    unsigned started;
+    unsigned fallthrough;
+    unsigned completed;
+    unsigned cancelled;
+};
+
+static struct engine cli_engine;
+static struct engine srv_engine;
+
+static int engine_start(mbedtls_ssl_context *ssl, mbedtls_x509_crt *cert, int decrypt,
+                        mbedtls_md_type_t md_alg, const unsigned char *input, size_t len)
+{
+    struct engine *engine = mbedtls_ssl_conf_get_async_config_data(ssl->conf);
+
+    if (engine->mode == ENGINE_FALLTHROUGH) {
+        engine->fallthrough++;
+        return MBEDTLS_ERR_SSL_HW_ACCEL_FALLTHROUGH;
+    }
+
+    // One operation at a time, its state is forgotten once it completes
+    CHECK(mbedtls_ssl_get_async_operation_data(ssl) == NULL);
+    CHECK(len <= sizeof engine->input);
+
+    engine->decrypt = decrypt;
+    engine->key = key_of(cert);
+    engine->md_alg = md_alg;
+    memcpy(engine->input, input, len);
+    engine->input_len = len;
+    engine->ready = engine->mode == ENGINE_IMMEDIATE;
+    engine->started++;
+    CHECK(engine->key != NULL);
+
+    mbedtls_ssl_set_async_operation_data(ssl, engine);
+    return engine->ready ? 0 : MBEDTLS_ERR_SSL_WANT_ASYNC;
+}
+
+static int engine_sign(mbedtls_ssl_context *ssl, mbedtls_x509_crt *cert,
+                       mbedtls_md_type_t md_alg, const unsigned char *hash, size_t hash_len)
+{
+    return engine_start(ssl, cert, 0, md_alg, hash, hash_len);
+}
+
+static int engine_decrypt(mbedtls_ssl_context *ssl, mbedtls_x509_crt *cert,
+                          const unsigned char *input, size_t input_len)
+{
+    return engine_start(ssl, cert, 1, MBEDTLS_MD_NONE, input, input_len);
+}
+
+static int engine_resume(mbedtls_ssl_context *ssl, unsigned char *output,
+                         size_t *output_len, size_t output_size)
+{
+    struct engine *engine = mbedtls_ssl_get_async_operation_data(ssl);
+    CHECK(engine == mbedtls_ssl_conf_get_async_config_data(ssl->conf));
+
+    if (!engine->ready) {
+        return MBEDTLS_ERR_SSL_WANT_ASYNC;
+    }
+
+    engine->completed++;
+    if (engine->mode == ENGINE_FAIL) {
+        return MBEDTLS_ERR_SSL_HW_ACCEL_FAILED;
+    }
+
+    if (engine->decrypt) {
+        return mbedtls_pk_decrypt(engine->key, engine->input, engine->input_len,
+                output, output_len, output_size, mbedtls_ctr_drbg_random, &drbg);
+    }
+
+    int ret = mbedtls_pk_sign(engine->key, engine->md_alg, engine->input, engine->input_len,
+            output, output_len, mbedtls_ctr_drbg_random, &drbg);
+    CHECK(*output_len <= output_size);
+    return ret;
+}
+
+static void engine_cancel(mbedtls_ssl_context *ssl)
+{
+    struct engine *engine = mbedtls_ssl_get_async_operation_data(ssl);
+    CHECK(engine == mbedtls_ssl_conf_get_async_config_data(ssl->conf));
+    engine->cancelled++;
+}
+
+
+// Connection pair
+struct scenario {
+    const char *name;
+    int transport;
+    int ciphersuite;
+    int minor_ver;
+    int client_auth;
+    int rsa;
+    enum engine_mode cli_mode;
+    enum engine_mode srv_mode;
+};
+
+static mbedtls_ssl_config cli_conf;
+static mbedtls_ssl_config srv_conf;
+static mbedtls_ssl_context cli;
+static mbedtls_ssl_context srv;
+static uint32_t cli_timer;
+static uint32_t srv_timer;
+static int ciphersuites[2];
+
+static void setup(const struct scenario *s)
+{
+    int dgram = s->transport == MBEDTLS_SSL_TRANSPORT_DATAGRAM;
+    memset(&to_server, 0, sizeof to_server);
+    memset(&to_client, 0, sizeof to_client);
+    to_server.dgram = dgram;
+    to_client.dgram = dgram;
+
+    memset(&cli_engine, 0, sizeof cli_engine);
+    memset(&srv_engine, 0, sizeof srv_engine);
+    cli_engine.mode = s->cli_mode;
+    srv_engine.mode = s->srv_mode;
+
+    ciphersuites[0] = s->ciphersuite;
+    ciphersuites[1] = 0;
+
+    mbedtls_ssl_config_init(&cli_conf);
+    CHECK(mbedtls_ssl_config_defaults(&cli_conf, MBEDTLS_SSL_IS_CLIENT,
+            s->transport, MBEDTLS_SSL_PRESET_DEFAULT) == 0);
+    mbedtls_ssl_conf_rng(&cli_conf, mbedtls_ctr_drbg_random, &drbg);
+    mbedtls_ssl_conf_ca_chain(&cli_conf, &ca_crt, NULL);
+    mbedtls_ssl_conf_authmode(&cli_conf, MBEDTLS_SSL_VERIFY_REQUIRED);
+    mbedtls_ssl_conf_ciphersuites(&cli_conf, ciphersuites);
+    mbedtls_ssl_conf_max_version(&cli_conf, MBEDTLS_SSL_MAJOR_VERSION_3, s->minor_ver);
+    CHECK(mbedtls_ssl_conf_psk(&cli_conf, psk, sizeof psk,
+            psk_identity, sizeof psk_identity - 1) == 0);
+    if (s->client_auth) {
+        CHECK(mbedtls_ssl_conf_own_cert(&cli_conf, &cli_crt, &cli_key) == 0);
+    }
+    if (s->cli_mode != ENGINE_NONE) {
+        mbedtls_ssl_conf_async_private_cb(&cli_conf, engine_sign, engine_decrypt,
+                engine_resume, engine_cancel, &cli_engine);
+    }
+
+    mbedtls_ssl_config_init(&srv_conf);
+    CHECK(mbedtls_ssl_config_defaults(&srv_conf, MBEDTLS_SSL_IS_SERVER,
+            s->transport, MBEDTLS_SSL_PRESET_DEFAULT) == 0);
+    mbedtls_ssl_conf_rng(&srv_conf, mbedtls_ctr_drbg_random, &drbg);
+    if (s->rsa) {
+        CHECK(mbedtls_ssl_conf_own_cert(&srv_conf, &srv_crt_rsa, &srv_key_rsa) == 0);
+    } else {
+        CHECK(mbedtls_ssl_conf_own_cert(&srv_conf, &srv_crt_ec, &srv_key_ec) == 0);
+    }
+    CHECK(mbedtls_ssl_conf_psk(&srv_conf, psk, sizeof psk,
+            psk_identity, sizeof psk_identity - 1) == 0);
+    if (s->client_auth) {
+        mbedtls_ssl_conf_ca_chain(&srv_conf, &ca_crt, NULL);
+        mbedtls_ssl_conf_authmode(&srv_conf, MBEDTLS_SSL_VERIFY_REQUIRED);
+    }
+    if (s->srv_mode != ENGINE_NONE) {
+        mbedtls_ssl_conf_async_private_cb(&srv_conf, engine_sign, engine_decrypt,
+                engine_resume, engine_cancel, &srv_engine);
+    }
+#if defined(MBEDTLS_SSL_DTLS_HELLO_VERIFY)
+    mbedtls_ssl_conf_dtls_cookies(&srv_conf, NULL, NULL, NULL);
+#endif
+
+    mbedtls_ssl_init(&cli);
+    CHECK(mbedtls_ssl_setup(&cli, &cli_conf) == 0);
+    CHECK(mbedtls_ssl_set_hostname(&cli, SERVER_NAME) == 0);
+    mbedtls_ssl_set_bio(&cli, &cli_end, pipe_send, pipe_recv, NULL);
+    mbedtls_ssl_set_timer_cb(&cli, &cli_timer, timer_set, timer_get);
+
+    mbedtls_ssl_init(&srv);
+    CHECK(mbedtls_ssl_setup(&srv, &srv_conf) == 0);
+    mbedtls_ssl_set_bio(&srv, &srv_end, pipe_send, pipe_recv, NULL);
+    mbedtls_ssl_set_timer_cb(&srv, &srv_timer, timer_set, timer_get);
+}
+
+static void teardown(void)
+{
+    mbedtls_ssl_free(&srv);
+    mbedtls_ssl_free(&cli);
+    mbedtls_ssl_config_free(&srv_conf);
+    mbedtls_ssl_config_free(&cli_conf);
+}
+
+// Runs both sides until the handshake completes or fails, an operation in
+// progress completes once the peer has had its turn. Stops early once a
+// side has waited for stop_after operations, if not 0.
+static unsigned cli_waits;
+static unsigned srv_waits;
+
+static void handshake(int *cli_ret, int *srv_ret, unsigned stop_after)
+{
+    int cli_done = 0, srv_done = 0;
+    cli_waits = srv_waits = 0;
+
+    for (int i = 0; !cli_done || !srv_done; i++) {
+        CHECK(i < MAX_ROUNDS);
+
+        if (!cli_done) {
+            *cli_ret = mbedtls_ssl_handshake(&cli);
+            if (*cli_ret == MBEDTLS_ERR_SSL_WANT_ASYNC) {
+                cli_waits++;
+            } else if (!WOULD_BLOCK(*cli_ret)) {
+                cli_done = 1;
+            }
+        }
+
+        if (!srv_done) {
+            *srv_ret = mbedtls_ssl_handshake(&srv);
+            if (*srv_ret == MBEDTLS_ERR_SSL_WANT_ASYNC) {
+                // What came before the signature is on its way already
+                if (srv_waits++ == 0 && srv.state == MBEDTLS_SSL_SERVER_KEY_EXCHANGE) {
+                    CHECK(to_client.len > 0);
+                }
+            } else if (!WOULD_BLOCK(*srv_ret)) {
+                srv_done = 1;
+            }
+        }
+
+        if (stop_after && (cli_waits >= stop_after || srv_waits >= stop_after)) {
+            return;
+        }
+
+        // A side that failed leaves the other waiting for nothing
+        if (cli_done && *cli_ret != 0) {
+            srv_done = 1;
+        }
+        if (srv_done && *srv_ret != 0) {
+            cli_done = 1;
+        }
+
+        cli_engine.ready = 1;
+        srv_engine.ready = 1;
+    }
+}
+
+// Client sends ECHO_SIZE bytes, the server echoes them back
+static void exchange(void)
+{
+    static unsigned char tx[ECHO_SIZE], echo[ECHO_SIZE], rx[ECHO_SIZE];
+    for (size_t i = 0; i < sizeof tx; i++) {
+        tx[i] = rand();
+    }
+
+    size_t srv_got = 0, got = 0;
+    CHECK(mbedtls_ssl_write(&cli, tx, sizeof tx) == sizeof tx);
+    for (int i = 0; got < sizeof rx; i++) {
+        CHECK(i < MAX_ROUNDS);
+
+        int ret = mbedtls_ssl_read(&srv, echo + srv_got, sizeof echo - srv_got);
+        CHECK(ret > 0 || WOULD_BLOCK(ret));
+        if (ret > 0) {
+            CHECK(mbedtls_ssl_write(&srv, echo + srv_got, ret) == ret);
+            srv_got += ret;
+        }
+
+        ret = mbedtls_ssl_read(&cli, rx + got, sizeof rx - got);
+        CHECK(ret > 0 || WOULD_BLOCK(ret));
+        got += ret > 0 ? ret : 0;
+    }
+
+    CHECK(memcmp(tx, rx, sizeof tx) == 0);
+}
+
+// Connects with operations in progress on the sides whose engine defers
+static void connect(const struct scenario *s)
+{
+    int cli_ret, srv_ret;
+
+    setup(s);
+    handshake(&cli_ret, &srv_ret, 0);
+    CHECK(cli_ret == 0 && srv_ret == 0);
+    exchange();
+
+    if (s->cli_mode == ENGINE_DEFER) {
+        CHECK(cli_engine.started == 1 && cli_engine.completed == 1 && cli_waits > 0);
+    }
+    if (s->srv_mode == ENGINE_DEFER) {
+        CHECK(srv_engine.started == 1 && srv_engine.completed == 1 && srv_waits > 0);
+    }
+    CHECK(cli_engine.cancelled == 0 && srv_engine.cancelled == 0);
+
+    printf("HOST: %s: ok, client waited %u times, server %u times\r\n",
+           s->name, cli_waits, srv_waits);
+    teardown();
+}
+
+#define TLS     MBEDTLS_SSL_TRANSPORT_STREAM
+#define DTLS    MBEDTLS_SSL_TRANSPORT_DATAGRAM
+#define TLS1_1  MBEDTLS_SSL_MINOR_VERSION_2
+#define TLS1_2  MBEDTLS_SSL_MINOR_VERSION_3
+
+static const struct scenario ecdhe_ecdsa = {
+    "TLS ECDHE-ECDSA, server signs", TLS,
+    MBEDTLS_TLS_ECDHE_ECDSA_WITH_AES_128_GCM_SHA256, TLS1_2, 0, 0,
+    ENGINE_NONE, ENGINE_DEFER,
+};
+
+static const struct scenario rsa = {
+    "TLS RSA, server decrypts", TLS,
+    MBEDTLS_TLS_RSA_WITH_AES_128_GCM_SHA256, TLS1_2, 0, 1,
+    ENGINE_NONE, ENGINE_DEFER,
+};
+
+static const struct scenario deferred[] = {
+    ecdhe_ecdsa,
+    { "TLS ECDHE-RSA, server signs", TLS,
+      MBEDTLS_TLS_ECDHE_RSA_WITH_AES_128_GCM_SHA256, TLS1_2, 0, 1,
+      ENGINE_NONE, ENGINE_DEFER },
+    rsa,
+    { "TLS RSA-PSK, server decrypts", TLS,
+      MBEDTLS_TLS_RSA_PSK_WITH_AES_128_GCM_SHA256, TLS1_2, 0, 1,
+      ENGINE_NONE, ENGINE_DEFER },
+    { "TLS ECDHE-ECDSA, client signs", TLS,
+      MBEDTLS_TLS_ECDHE_ECDSA_WITH_AES_128_GCM_SHA256, TLS1_2, 1, 0,
+      ENGINE_DEFER, ENGINE_NONE },
+    { "TLS 1.1 ECDHE-RSA, both sign", TLS,
+      MBEDTLS_TLS_ECDHE_RSA_WITH_AES_128_CBC_SHA, TLS1_1, 1, 1,
+      ENGINE_DEFER, ENGINE_DEFER },
+    { "DTLS ECDHE-ECDSA, both sign", DTLS,
+      MBEDTLS_TLS_ECDHE_ECDSA_WITH_AES_128_GCM_SHA256, TLS1_2, 1, 0,
+      ENGINE_DEFER, ENGINE_DEFER },
+};
+
+int main(void)
+{
+    struct scenario s;
+    int cli_ret, srv_ret;
+
+    mbedtls_entropy_init(&entropy);
+    mbedtls_ctr_drbg_init(&drbg);
+    CHECK(mbedtls_ctr_drbg_seed(&drbg, mbedtls_entropy_func, &entropy, NULL, 0) == 0);
+
+    mbedtls_x509_crt_init(&ca_crt);
+    mbedtls_x509_crt_init(&srv_crt_ec);
+    mbedtls_pk_init(&srv_key_ec);
+    mbedtls_x509_crt_init(&srv_crt_rsa);
+    mbedtls_pk_init(&srv_key_rsa);
+    mbedtls_x509_crt_init(&cli_crt);
+    mbedtls_pk_init(&cli_key);
+    CHECK(mbedtls_x509_crt_parse(&ca_crt, (const unsigned char *)mbedtls_test_cas_pem,
+            mbedtls_test_cas_pem_len) == 0);
+    CHECK(mbedtls_x509_crt_parse(&srv_crt_ec, (const unsigned char *)mbedtls_test_srv_crt_ec,
+            strlen(mbedtls_test_srv_crt_ec) + 1) == 0);
+    CHECK(mbedtls_pk_parse_key(&srv_key_ec, (const unsigned char *)mbedtls_test_srv_key_ec,
+            strlen(mbedtls_test_srv_key_ec) + 1, NULL, 0) == 0);
+    CHECK(mbedtls_x509_crt_parse(&srv_crt_rsa, (const unsigned char *)mbedtls_test_srv_crt_rsa,
+            strlen(mbedtls_test_srv_crt_rsa) + 1) == 0);
+    CHECK(mbedtls_pk_parse_key(&srv_key_rsa, (const unsigned char *)mbedtls_test_srv_key_rsa,
+            strlen(mbedtls_test_srv_key_rsa) + 1, NULL, 0) == 0);
+    CHECK(mbedtls_x509_crt_parse(&cli_crt, (const unsigned char *)mbedtls_test_cli_crt_ec,
+            strlen(mbedtls_test_cli_crt_ec) + 1) == 0);
+    CHECK(mbedtls_pk_parse_key(&cli_key, (const unsigned char *)mbedtls_test_cli_key_ec,
+            strlen(mbedtls_test_cli_key_ec) + 1, NULL, 0) == 0);
+
+    // Every operation the handshake hands out, left in progress for a round
+    for (size_t i = 0; i < sizeof deferred / sizeof deferred[0]; i++) {
+        connect(&deferred[i]);
+    }
+
+    // An engine that completes at once never makes the handshake wait
+    s = ecdhe_ecdsa;
+    s.name = "engine completes at once";
+    s.srv_mode = ENGINE_IMMEDIATE;
+    setup(&s);
+    handshake(&cli_ret, &srv_ret, 0);
+    CHECK(cli_ret == 0 && srv_ret == 0);
+    CHECK(srv_engine.started == 1 && srv_engine.completed == 1 && srv_waits == 0);
+    exchange();
+    teardown();
+    printf("HOST: %s: ok\r\n", s.name);
+
+    // An engine may leave keys it does not hold to the handshake
+    s = rsa;
+    s.name = "engine falls through";
+    s.srv_mode = ENGINE_FALLTHROUGH;
+    setup(&s);
+    handshake(&cli_ret, &srv_ret, 0);
+    CHECK(cli_ret == 0 && srv_ret == 0);
+    CHECK(srv_engine.fallthrough == 1 && srv_engine.started == 0 && srv_waits == 0);
+    exchange();
+    teardown();
+    printf("HOST: %s: ok\r\n", s.name);
+
+    // A failed signature aborts the handshake with the engine's error
+    s = ecdhe_ecdsa;
+    s.name = "signature fails";
+    s.srv_mode = ENGINE_FAIL;
+    setup(&s);
+    handshake(&cli_ret, &srv_ret, 0);
+    CHECK(srv_ret == MBEDTLS_ERR_SSL_HW_ACCEL_FAILED);
+    CHECK(srv_engine.completed == 1 && srv_engine.cancelled == 0);
+    teardown();
+    printf("HOST: %s: ok\r\n", s.name);
+
+    // A failed decryption is not told apart from a bad premaster, the
+    // handshake fails at the Finished messages instead
+    s = rsa;
+    s.name = "decryption fails";
+    s.srv_mode = ENGINE_FAIL;
+    setup(&s);
+    handshake(&cli_ret, &srv_ret, 0);
+    CHECK(srv_ret != 0 && srv_ret != MBEDTLS_ERR_SSL_HW_ACCEL_FAILED);
+    CHECK(srv_engine.completed == 1 && srv_engine.cancelled == 0);
+    teardown();
+    printf("HOST: %s: ok\r\n", s.name);
+
+    // Resetting or freeing a context cancels its operation in progress,
+    // and the reset context connects again
+    s = ecdhe_ecdsa;
+    s.name = "cancel";
+    setup(&s);
+    handshake(&cli_ret, &srv_ret, 1);
+    CHECK(srv_ret == MBEDTLS_ERR_SSL_WANT_ASYNC);
+    CHECK(mbedtls_ssl_session_reset(&srv) == 0);
+    CHECK(srv_engine.cancelled == 1);
+    CHECK(mbedtls_ssl_get_async_operation_data(&srv) == NULL);
+
+    CHECK(mbedtls_ssl_session_reset(&cli) == 0);
+    memset(&to_server, 0, sizeof to_server);
+    memset(&to_client, 0, sizeof to_client);
+    handshake(&cli_ret, &srv_ret, 0);
+    CHECK(cli_ret == 0 && srv_ret == 0);
+    CHECK(srv_engine.started == 2 && srv_engine.completed == 1);
+    exchange();
+
+    CHECK(mbedtls_ssl_session_reset(&srv) == 0);
+    CHECK(mbedtls_ssl_session_reset(&cli) == 0);
+    memset(&to_server, 0, sizeof to_server);
+    memset(&to_client, 0, sizeof to_client);
+    handshake(&cli_ret, &srv_ret, 1);
+    CHECK(srv_ret == MBEDTLS_ERR_SSL_WANT_ASYNC);
+    teardown();
+    CHECK(srv_engine.cancelled == 2);
+    printf("HOST: %s: ok\r\n", s.name);
+
+    mbedtls_pk_free(&cli_key);
+    mbedtls_x509_crt_free(&cli_crt);
+    mbedtls_pk_free(&srv_key_rsa);
+    mbedtls_x509_crt_free(&srv_crt_rsa);
+    mbedtls_pk_free(&srv_key_ec);
+    mbedtls_x509_crt_free(&srv_crt_ec);
+    mbedtls_x509_crt_free(&ca_crt);
+    mbedtls_ctr_drbg_free(&drbg);
+    mbedtls_entropy_free(&entropy);
+
+    printf("HOST: all passed\r\n");
+    return 0;
+}
@@ -0,0 +1,413 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#if !defined(TARGET_LIKE_POSIX)
+    #error [NOT_SUPPORTED] Host test, build with the Makefile in this directory
+#endif
+
+/* Host test of the memory taken by mbed TLS contexts
+ *
+ * A client and a server context talk to each other over in-memory pipes,
+ * over TLS and DTLS, with and without a negotiated maximum fragment
+ * length. The heap of memory_buffer_alloc counts the bytes the pair holds
+ * after setup, at the peak of the handshake, once established, and after
+ * echoing small and large records, and what freeing each context returns.
+ *
+ * Echoed data is checked across the record sizes where the variable length
+ * buffers have to grow, and both contexts are reset and connect again, to
+ * check that the buffers come back for the next handshake. A server that
+ * sends an alert before its first handshake step, when the variable length
+ * buffers are not yet allocated, must still reach the client.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "mbedtls/config.h"
+#include "mbedtls/ssl.h"
+#include "mbedtls/entropy.h"
+#include "mbedtls/ctr_drbg.h"
+#include "mbedtls/certs.h"
+#include "mbedtls/memory_buffer_alloc.h"
+
+#define SERVER_NAME "localhost"
+#define PIPE_SIZE   (64 * 1024)
+#define HEAP_SIZE   (256 * 1024)
+#define MAX_ROUNDS  10000
+
+#if defined(MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH)
+#define BUFFERS     "variable"
+#else
+#define BUFFERS     "fixed"
+#endif
+
+#define CHECK(cond) do {                                                \
+        if (!(cond)) {                                                  \
+            printf("HOST: %s:%d: check failed: %s\r\n",                 \
+                   __FILE__, __LINE__, #cond);                          \
+            exit(EXIT_FAILURE);                                         \
+        }                                                               \
+    } while (0)
+
+#define WOULD_BLOCK(ret) \
+    ((ret) == MBEDTLS_ERR_SSL_WANT_READ || (ret) == MBEDTLS_ERR_SSL_WANT_WRITE)
+
+
+// Entropy for mbed TLS, as a TRNG would give it on a target
+int mbedtls_hardware_poll(void *data, unsigned char *output, size_t len, size_t *olen)
+{
+    static int fd = -1;
+    if (fd < 0) {
+        fd = open("/dev/urandom", O_RDONLY);
+    }
+
+    ssize_t ret = fd < 0 ? -1 : read(fd, output, len);
+    *olen = ret < 0 ? 0 : ret;
+    return ret < 0 ? -1 : 0;
+}
+
+
+// In-memory pipes, datagrams are queued behind a two-byte length
+struct pipe {
+    int dgram;
+    size_t len;
+    unsigned char buf[PIPE_SIZE];
+};
+
+struct pipe_end {
+    struct pipe *send;
+    struct pipe *recv;
+};
+
+static struct pipe to_server;
+static struct pipe to_client;
+static struct pipe_end cli_end = {&to_server, &to_client};
+static struct pipe_end srv_end = {&to_client, &to_server};
+
+static int pipe_send(void *ctx, const unsigned char *buf, size_t len)
+{
+    struct pipe *p = ((struct pipe_end *)ctx)->send;
+    size_t hdr = p->dgram ? 2 : 0;
+    if (p->len + hdr + len > PIPE_SIZE) {
+        return MBEDTLS_ERR_SSL_WANT_WRITE;
+    }
+
+    if (p->dgram) {
+        p->buf[p->len++] = len >> 8;
+        p->buf[p->len++] = len & 0xff;
+    }
+
+    memcpy(p->buf + p->len, buf, len);
+    p->len += len;
+    return len;
+}
+
+static int pipe_recv(void *ctx, unsigned char *buf, size_t len)
+{
+    struct pipe *p = ((struct pipe_end *)ctx)->recv;
+    if (p->len == 0) {
+        return MBEDTLS_ERR_SSL_WANT_READ;
+    }
+
+    size_t hdr = 0;
+    size_t avail = p->len;
+    if (p->dgram) {
+        hdr = 2;
+        avail = (p->buf[0] << 8) | p->buf[1];
+    }
+
+    // A datagram that does not fit is truncated, as a socket would
+    size_t n = avail < len ? avail : len;
+    size_t consumed = p->dgram ? hdr + avail : n;
+    memcpy(buf, p->buf + hdr, n);
+    memmove(p->buf, p->buf + consumed, p->len - consumed);
+    p->len -= consumed;
+    return n;
+}
+
+// The pipes lose nothing, retransmission timers never need to expire
+static void timer_set(void *ctx, uint32_t int_ms, uint32_t fin_ms)
+{
+    *(uint32_t *)ctx = fin_ms;
+}
+
+static int timer_get(void *ctx)
+{
+    return *(uint32_t *)ctx ? 0 : -1;
+}
+
+
+// Heap
+static unsigned char heap[HEAP_SIZE];
+
+static size_t heap_used(void)
+{
+    size_t used, blocks;
+    mbedtls_memory_buffer_alloc_cur_get(&used, &blocks);
+    return used;
+}
+
+static size_t heap_peak(void)
+{
+    size_t used, blocks;
+    mbedtls_memory_buffer_alloc_max_get(&used, &blocks);
+    return used;
+}
+
+
+// Connection pair
+static mbedtls_entropy_context entropy;
+static mbedtls_ctr_drbg_context drbg;
+static mbedtls_x509_crt ca_crt;
+static mbedtls_x509_crt srv_crt;
+static mbedtls_pk_context srv_key;
+
+static mbedtls_ssl_config cli_conf;
+static mbedtls_ssl_config srv_conf;
+static mbedtls_ssl_context cli;
+static mbedtls_ssl_context srv;
+static uint32_t cli_timer;
+static uint32_t srv_timer;
+
+static unsigned char tx[16384];
+static unsigned char echo[16384];
+static unsigned char rx[16384];
+
+static void setup(int transport, unsigned char mfl)
+{
+    int dgram = transport == MBEDTLS_SSL_TRANSPORT_DATAGRAM;
+    memset(&to_server, 0, sizeof to_server);
+    memset(&to_client, 0, sizeof to_client);
+    to_server.dgram = dgram;
+    to_client.dgram = dgram;
+
+    mbedtls_ssl_config_init(&cli_conf);
+    CHECK(mbedtls_ssl_config_defaults(&cli_conf, MBEDTLS_SSL_IS_CLIENT,
+            transport, MBEDTLS_SSL_PRESET_DEFAULT) == 0);
+    mbedtls_ssl_conf_rng(&cli_conf, mbedtls_ctr_drbg_random, &drbg);
+    mbedtls_ssl_conf_ca_chain(&cli_conf, &ca_crt, NULL);
+    mbedtls_ssl_conf_authmode(&cli_conf, MBEDTLS_SSL_VERIFY_REQUIRED);
+    CHECK(mbedtls_ssl_conf_max_frag_len(&cli_conf, mfl) == 0);
+
+    mbedtls_ssl_config_init(&srv_conf);
+    CHECK(mbedtls_ssl_config_defaults(&srv_conf, MBEDTLS_SSL_IS_SERVER,
+            transport, MBEDTLS_SSL_PRESET_DEFAULT) == 0);
+    mbedtls_ssl_conf_rng(&srv_conf, mbedtls_ctr_drbg_random, &drbg);
+    CHECK(mbedtls_ssl_conf_own_cert(&srv_conf, &srv_crt, &srv_key) == 0);
+#if defined(MBEDTLS_SSL_DTLS_HELLO_VERIFY)
+    mbedtls_ssl_conf_dtls_cookies(&srv_conf, NULL, NULL, NULL);
+#endif
+
+    mbedtls_ssl_init(&cli);
+    CHECK(mbedtls_ssl_setup(&cli, &cli_conf) == 0);
+    CHECK(mbedtls_ssl_set_hostname(&cli, SERVER_NAME) == 0);
+    mbedtls_ssl_set_bio(&cli, &cli_end, pipe_send, pipe_recv, NULL);
+    mbedtls_ssl_set_timer_cb(&cli, &cli_timer, timer_set, timer_get);
+
+    mbedtls_ssl_init(&srv);
+    CHECK(mbedtls_ssl_setup(&srv, &srv_conf) == 0);
+    mbedtls_ssl_set_bio(&srv, &srv_end, pipe_send, pipe_recv, NULL);
+    mbedtls_ssl_set_timer_cb(&srv, &srv_timer, timer_set, timer_get);
+}
+
+static void handshake(void)
+{
+    int cli_ret = MBEDTLS_ERR_SSL_WANT_READ;
+    int srv_ret = MBEDTLS_ERR_SSL_WANT_READ;
+
+    for (int i = 0; cli_ret || srv_ret; i++) {
+        CHECK(i < MAX_ROUNDS);
+        if (cli_ret) {
+            cli_ret = mbedtls_ssl_handshake(&cli);
+            CHECK(cli_ret == 0 || WOULD_BLOCK(cli_ret));
+        }
+        if (srv_ret) {
+            srv_ret = mbedtls_ssl_handshake(&srv);
+            CHECK(srv_ret == 0 || WOULD_BLOCK(srv_ret));
+        }
+    }
+}
+
+// Client sends len bytes, the server echoes them back
+static void exchange(size_t len)
+{
+    size_t chunk = len;
+    if (cli_conf.transport == MBEDTLS_SSL_TRANSPORT_DATAGRAM) {
+        size_t max = mbedtls_ssl_get_max_frag_len(&cli);
+        chunk = len < max ? len : max;
+    }
+
+    for (size_t i = 0; i < len; i++) {
+        tx[i] = rand();
+    }
+
+    size_t sent = 0, srv_got = 0, srv_sent = 0, got = 0;
+    for (int i = 0; got < len; i++) {
+        CHECK(i < MAX_ROUNDS);
+        int ret;
+
+        if (sent < len) {
+            size_t n = len - sent < chunk ? len - sent : chunk;
+            ret = mbedtls_ssl_write(&cli, tx + sent, n);
+            CHECK(ret > 0 || WOULD_BLOCK(ret));
+            sent += ret > 0 ? ret : 0;
+        }
+
+        ret = mbedtls_ssl_read(&srv, echo + srv_got, len - srv_got);
+        CHECK(ret > 0 || WOULD_BLOCK(ret));
+        srv_got += ret > 0 ? ret : 0;
+
+        if (srv_sent < srv_got) {
+            size_t n = srv_got - srv_sent < chunk ? srv_got - srv_sent : chunk;
+            ret = mbedtls_ssl_write(&srv, echo + srv_sent, n);
+            CHECK(ret > 0 || WOULD_BLOCK(ret));
+            srv_sent += ret > 0 ? ret : 0;
+        }
+
+        ret = mbedtls_ssl_read(&cli, rx + got, len - got);
+        CHECK(ret > 0 || WOULD_BLOCK(ret));
+        got += ret > 0 ? ret : 0;
+    }
+
+    CHECK(memcmp(tx, rx, len) == 0);
+}
+
+static void run(const char *name, int transport, unsigned char mfl)
+{
+    static const size_t sizes[] = {1, 100, 511, 512, 513, 1000, 1024, 1025, 4000};
+    size_t base = heap_used();
+
+    setup(transport, mfl);
+    size_t after_setup = heap_used() - base;
+
+    mbedtls_memory_buffer_alloc_max_reset();
+    handshake();
+    size_t peak = heap_peak() - base;
+    size_t established = heap_used() - base;
+
+    exchange(100);
+    size_t small = heap_used() - base;
+
+    for (unsigned i = 0; i < sizeof sizes / sizeof sizes[0]; i++) {
+        exchange(sizes[i]);
+    }
+
+    exchange(sizeof tx);
+    size_t large = heap_used() - base;
+
+    // A new connection on the same contexts
+    CHECK(mbedtls_ssl_close_notify(&cli) == 0);
+    CHECK(mbedtls_ssl_session_reset(&cli) == 0);
+    CHECK(mbedtls_ssl_session_reset(&srv) == 0);
+    memset(to_server.buf, 0, sizeof to_server.buf);
+    to_server.len = 0;
+    size_t reset = heap_used() - base;
+
+    handshake();
+    exchange(100);
+    exchange(sizeof tx);
+
+    size_t before_free = heap_used();
+    mbedtls_ssl_free(&cli);
+    size_t cli_bytes = before_free - heap_used();
+    before_free = heap_used();
+    mbedtls_ssl_free(&srv);
+    size_t srv_bytes = before_free - heap_used();
+
+    mbedtls_ssl_config_free(&cli_conf);
+    mbedtls_ssl_config_free(&srv_conf);
+    CHECK(heap_used() == base);
+
+    printf("HOST: %-8s %-13s pair: setup %6u, handshake peak %6u, "
+           "established %6u, after 100 B %6u, after 16 KiB %6u, reset %6u\r\n",
+           BUFFERS, name, (unsigned)after_setup, (unsigned)peak,
+           (unsigned)established, (unsigned)small, (unsigned)large, (unsigned)reset);
+    printf("HOST: %-8s %-13s each: client %6u, server %6u\r\n",
+           BUFFERS, name, (unsigned)cli_bytes, (unsigned)srv_bytes);
+}
+
+// The server turns a client away before its own handshake started
+static void alert(const char *name, int transport)
+{
+    size_t base = heap_used();
+
+    setup(transport, MBEDTLS_SSL_MAX_FRAG_LEN_NONE);
+    CHECK(mbedtls_ssl_send_alert_message(&srv, MBEDTLS_SSL_ALERT_LEVEL_FATAL,
+            MBEDTLS_SSL_ALERT_MSG_HANDSHAKE_FAILURE) == 0);
+
+    // A plaintext alert record, the only one on its way to the client
+    size_t hdr = to_client.dgram ? 2 + 13 : 5;
+    CHECK(to_client.len == hdr + 2);
+    CHECK(to_client.buf[to_client.dgram ? 2 : 0] == MBEDTLS_SSL_MSG_ALERT);
+    CHECK(to_client.buf[hdr] == MBEDTLS_SSL_ALERT_LEVEL_FATAL);
+    CHECK(to_client.buf[hdr + 1] == MBEDTLS_SSL_ALERT_MSG_HANDSHAKE_FAILURE);
+
+    // Both contexts connect once reset
+    CHECK(mbedtls_ssl_session_reset(&cli) == 0);
+    CHECK(mbedtls_ssl_session_reset(&srv) == 0);
+    to_server.len = 0;
+    to_client.len = 0;
+    handshake();
+    exchange(100);
+
+    mbedtls_ssl_free(&cli);
+    mbedtls_ssl_free(&srv);
+    mbedtls_ssl_config_free(&cli_conf);
+    mbedtls_ssl_config_free(&srv_conf);
+    CHECK(heap_used() == base);
+
+    printf("HOST: %-8s %-13s alert before handshake\r\n", BUFFERS, name);
+}
+
+int main(void)
+{
+    mbedtls_memory_buffer_alloc_init(heap, sizeof heap);
+
+    mbedtls_entropy_init(&entropy);
+    mbedtls_ctr_drbg_init(&drbg);
+    CHECK(mbedtls_ctr_drbg_seed(&drbg, mbedtls_entropy_func, &entropy, NULL, 0) == 0);
+
+    mbedtls_x509_crt_init(&ca_crt);
+    mbedtls_x509_crt_init(&srv_crt);
+    mbedtls_pk_init(&srv_key);
+    CHECK(mbedtls_x509_crt_parse(&ca_crt, (const unsigned char *)mbedtls_test_ca_crt_ec,
+            strlen(mbedtls_test_ca_crt_ec) + 1) == 0);
+    CHECK(mbedtls_x509_crt_parse(&srv_crt, (const unsigned char *)mbedtls_test_srv_crt_ec,
+            strlen(mbedtls_test_srv_crt_ec) + 1) == 0);
+    CHECK(mbedtls_pk_parse_key(&srv_key, (const unsigned char *)mbedtls_test_srv_key_ec,
+            strlen(mbedtls_test_srv_key_ec) + 1, NULL, 0) == 0);
+
+    run("TLS", MBEDTLS_SSL_TRANSPORT_STREAM, MBEDTLS_SSL_MAX_FRAG_LEN_NONE);
+    run("TLS mfl 1024", MBEDTLS_SSL_TRANSPORT_STREAM, MBEDTLS_SSL_MAX_FRAG_LEN_1024);
+    run("DTLS", MBEDTLS_SSL_TRANSPORT_DATAGRAM, MBEDTLS_SSL_MAX_FRAG_LEN_NONE);
+    run("DTLS mfl 1024", MBEDTLS_SSL_TRANSPORT_DATAGRAM, MBEDTLS_SSL_MAX_FRAG_LEN_1024);
+    alert("TLS", MBEDTLS_SSL_TRANSPORT_STREAM);
+    alert("DTLS", MBEDTLS_SSL_TRANSPORT_DATAGRAM);
+
+    mbedtls_pk_free(&srv_key);
+    mbedtls_x509_crt_free(&srv_crt);
+    mbedtls_x509_crt_free(&ca_crt);
+    mbedtls_ctr_drbg_free(&drbg);
+    mbedtls_entropy_free(&entropy);
+    CHECK(mbedtls_memory_buffer_alloc_verify() == 0);
+    mbedtls_memory_buffer_alloc_free();
+
+    printf("HOST: all passed\r\n");
+    return 0;
+}
@@ -0,0 +1,32 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* mbed TLS user configuration of the ssl_buffers host test, included at
+ * the end of mbedtls/config.h
+ */
+
+// All allocations of mbed TLS come from the heap of memory_buffer_alloc,
+// which keeps count of the bytes in use
+#define MBEDTLS_PLATFORM_MEMORY
+#define MBEDTLS_MEMORY_BUFFER_ALLOC_C
+#define MBEDTLS_MEMORY_DEBUG
+
+// The fixed build measures the buffers as mbed TLS ships them
+#if defined(SSL_BUFFERS_FIXED)
+#undef MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH
+#else
+#define MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH
+#endif
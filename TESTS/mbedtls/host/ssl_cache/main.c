@@ -0,0 +1,233 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#if !defined(TARGET_LIKE_POSIX)
+    #error [NOT_SUPPORTED] Host test, build with the Makefile in this directory
+#endif
+
+/* Host benchmark of the mbed TLS server session cache
+ *
+ * Fills a cache of 10000 sessions, as a server resuming many clients
+ * would, and times storing sessions, resuming them and looking up
+ * unknown IDs. Then checks that eviction drops the least recently used
+ * sessions, that a session stored again keeps its age, and that the
+ * timeout drops sessions however recently they were used, against the
+ * counters the cache keeps.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+
+#include "mbedtls/config.h"
+#include "mbedtls/ssl.h"
+#include "mbedtls/ssl_cache.h"
+#include "mbedtls/certs.h"
+
+#define SESSIONS    10000
+#define TIMEOUT     86400
+#define CIPHERSUITE 0xc02b
+#define CERT_EVERY  100
+
+#define CHECK(cond) do {                                                \
+        if (!(cond)) {                                                  \
+            printf("HOST: %s:%d: check failed: %s\r\n",                 \
+                   __FILE__, __LINE__, #cond);                          \
+            exit(EXIT_FAILURE);                                         \
+        }                                                               \
+    } while (0)
+
+
+// Entropy for mbed TLS, as a TRNG would give it on a target
+int mbedtls_hardware_poll(void *data, unsigned char *output, size_t len, size_t *olen)
+{
+    static int fd = -1;
+    if (fd < 0) {
+        fd = open("/dev/urandom", O_RDONLY);
+    }
+
+    ssize_t ret = fd < 0 ? -1 : read(fd, output, len);
+    *olen = ret < 0 ? 0 : ret;
+    return ret < 0 ? -1 : 0;
+}
+
+
+// Clock of the cache, moved by hand
+static mbedtls_time_t now = 1000000;
+
+static mbedtls_time_t test_time(mbedtls_time_t *t)
+{
+    if (t) {
+        *t = now;
+    }
+
+    return now;
+}
+
+static double elapsed(const struct timespec *start)
+{
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    return (end.tv_sec - start->tv_sec) * 1e9 + (end.tv_nsec - start->tv_nsec);
+}
+
+
+// Sessions are told apart by their index, written in the ID and the master
+// secret, the rest of the ID is random as a server would make it
+static unsigned char id_salt[32];
+static mbedtls_x509_crt peer_crt;
+
+static void make_session(mbedtls_ssl_session *session, unsigned i, int with_cert)
+{
+    mbedtls_ssl_session_init(session);
+    session->ciphersuite = CIPHERSUITE;
+    session->id_len = sizeof session->id;
+    memcpy(session->id, id_salt, sizeof session->id);
+    memcpy(session->id, &i, sizeof i);
+    memset(session->master, 0, sizeof session->master);
+    memcpy(session->master, &i, sizeof i);
+    session->peer_cert = with_cert && i % CERT_EVERY == 0 ? &peer_crt : NULL;
+}
+
+static int resume(mbedtls_ssl_cache_context *cache, unsigned i)
+{
+    mbedtls_ssl_session session;
+    make_session(&session, i, 0);
+    memset(session.master, 0, sizeof session.master);
+
+    int ret = mbedtls_ssl_cache_get(cache, &session);
+    if (ret == 0) {
+        CHECK(memcmp(session.master, &i, sizeof i) == 0);
+        if (i % CERT_EVERY == 0) {
+            CHECK(session.peer_cert != NULL);
+            CHECK(session.peer_cert->raw.len == peer_crt.raw.len);
+        } else {
+            CHECK(session.peer_cert == NULL);
+        }
+    }
+
+    mbedtls_ssl_session_free(&session);
+    return ret;
+}
+
+static void store(mbedtls_ssl_cache_context *cache, unsigned i)
+{
+    mbedtls_ssl_session session;
+    make_session(&session, i, 1);
+    CHECK(mbedtls_ssl_cache_set(cache, &session) == 0);
+}
+
+
+int main(void)
+{
+    mbedtls_ssl_cache_context cache;
+    mbedtls_ssl_cache_stats stats;
+    struct timespec start;
+    double set_ns, hit_ns, miss_ns;
+    unsigned i;
+
+    size_t olen;
+    CHECK(mbedtls_hardware_poll(NULL, id_salt, sizeof id_salt, &olen) == 0);
+    mbedtls_platform_set_time(test_time);
+
+    mbedtls_x509_crt_init(&peer_crt);
+    CHECK(mbedtls_x509_crt_parse(&peer_crt, (const unsigned char *)mbedtls_test_cli_crt_ec,
+            strlen(mbedtls_test_cli_crt_ec) + 1) == 0);
+
+    mbedtls_ssl_cache_init(&cache);
+    mbedtls_ssl_cache_set_max_entries(&cache, SESSIONS);
+    mbedtls_ssl_cache_set_timeout(&cache, TIMEOUT);
+
+    // Full handshakes, one second apart
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (i = 0; i < SESSIONS; i++) {
+        now++;
+        store(&cache, i);
+    }
+    set_ns = elapsed(&start) / SESSIONS;
+
+    // Every client resumes, then as many unknown IDs are looked up
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (i = 0; i < SESSIONS; i++) {
+        CHECK(resume(&cache, i) == 0);
+    }
+    hit_ns = elapsed(&start) / SESSIONS;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (i = SESSIONS; i < 2 * SESSIONS; i++) {
+        CHECK(resume(&cache, i) != 0);
+    }
+    miss_ns = elapsed(&start) / SESSIONS;
+
+    mbedtls_ssl_cache_get_stats(&cache, &stats, 1);
+    CHECK(stats.hits == SESSIONS && stats.misses == SESSIONS);
+    CHECK(stats.evictions == 0 && stats.expirations == 0);
+    CHECK(stats.entries == SESSIONS);
+
+    printf("HOST: %u sessions: set %.0f ns, resume %.0f ns, unknown ID %.0f ns\r\n",
+           SESSIONS, set_ns, hit_ns, miss_ns);
+
+    // The oldest tenth resume again, so the next tenth are now the least
+    // recently used and are evicted by as many new sessions
+    for (i = 0; i < SESSIONS / 10; i++) {
+        CHECK(resume(&cache, i) == 0);
+    }
+    for (i = 2 * SESSIONS; i < 2 * SESSIONS + SESSIONS / 10; i++) {
+        now++;
+        store(&cache, i);
+    }
+    for (i = 0; i < SESSIONS / 10; i++) {
+        CHECK(resume(&cache, i) == 0);
+    }
+    for (i = SESSIONS / 10; i < 2 * (SESSIONS / 10); i++) {
+        CHECK(resume(&cache, i) != 0);
+    }
+
+    mbedtls_ssl_cache_get_stats(&cache, &stats, 1);
+    CHECK(stats.evictions == SESSIONS / 10 && stats.expirations == 0);
+    CHECK(stats.entries == SESSIONS);
+    printf("HOST: LRU eviction ok\r\n");
+
+    // Storing a session again does not make it younger: the oldest
+    // sessions expire first, whether they were used recently or not
+    store(&cache, 0);
+    now += TIMEOUT - SESSIONS / 2;
+    for (i = 0; i < SESSIONS / 2; i++) {
+        CHECK(resume(&cache, i) != 0);
+    }
+    mbedtls_ssl_cache_get_stats(&cache, &stats, 1);
+    CHECK(stats.expirations > 0 && stats.expirations < SESSIONS / 2);
+    CHECK(stats.entries == (int)(SESSIONS - stats.expirations));
+
+    now += TIMEOUT;
+    CHECK(resume(&cache, SESSIONS - 1) != 0);
+    mbedtls_ssl_cache_get_stats(&cache, &stats, 1);
+    CHECK(stats.entries == 0);
+    printf("HOST: timeout ok\r\n");
+
+    // The cache works again once empty
+    store(&cache, 7);
+    CHECK(resume(&cache, 7) == 0);
+
+    mbedtls_ssl_cache_free(&cache);
+    mbedtls_x509_crt_free(&peer_crt);
+
+    printf("HOST: all passed\r\n");
+    return 0;
+}
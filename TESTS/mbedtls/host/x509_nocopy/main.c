@@ -0,0 +1,591 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#if !defined(TARGET_LIKE_POSIX)
+    #error [NOT_SUPPORTED] Host test, build with the Makefile in this directory
+#endif
+
+/* Host test of the parsing of X.509 certificates without copies
+ *
+ * The test certificates, and one issued here with many subjectAltNames
+ * and extendedKeyUsages, are decoded to DER before the heap is set up, as
+ * they would sit in flash. Each is parsed with mbedtls_x509_crt_parse_der
+ * and mbedtls_x509_crt_parse_der_nocopy, which must agree on the info
+ * string, on the verification of host names and on the key usages, for the
+ * certificates as issued and with random bytes changed.
+ *
+ * The heap of memory_buffer_alloc reports the bytes held by each parsed
+ * chain, and the peak and established heap of a handshake over in-memory
+ * pipes, with the certificates of both ends copied or referenced.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "mbedtls/config.h"
+#include "mbedtls/platform.h"
+#include "mbedtls/ssl.h"
+#include "mbedtls/entropy.h"
+#include "mbedtls/ctr_drbg.h"
+#include "mbedtls/certs.h"
+#include "mbedtls/oid.h"
+#include "mbedtls/asn1write.h"
+#include "mbedtls/x509_crt.h"
+#include "mbedtls/memory_buffer_alloc.h"
+
+#define SERVER_NAME "host17.example.com"
+#define PIPE_SIZE   (64 * 1024)
+#define HEAP_SIZE   (256 * 1024)
+#define MAX_ROUNDS  10000
+#define DNS_NAMES   40
+#define MUTATIONS   1000
+
+#if defined(MBEDTLS_X509_CRT_LAZY_EXTENSIONS)
+#define EXTENSIONS  "lazy"
+#else
+#define EXTENSIONS  "eager"
+#endif
+
+#define CHECK(cond) do {                                                \
+        if (!(cond)) {                                                  \
+            printf("HOST: %s:%d: check failed: %s\r\n",                 \
+                   __FILE__, __LINE__, #cond);                          \
+            exit(EXIT_FAILURE);                                         \
+        }                                                               \
+    } while (0)
+
+#define WOULD_BLOCK(ret) \
+    ((ret) == MBEDTLS_ERR_SSL_WANT_READ || (ret) == MBEDTLS_ERR_SSL_WANT_WRITE)
+
+
+// Entropy for mbed TLS, as a TRNG would give it on a target
+int mbedtls_hardware_poll(void *data, unsigned char *output, size_t len, size_t *olen)
+{
+    static int fd = -1;
+    if (fd < 0) {
+        fd = open("/dev/urandom", O_RDONLY);
+    }
+
+    ssize_t ret = fd < 0 ? -1 : read(fd, output, len);
+    *olen = ret < 0 ? 0 : ret;
+    return ret < 0 ? -1 : 0;
+}
+
+
+// In-memory pipes
+struct pipe {
+    size_t len;
+    unsigned char buf[PIPE_SIZE];
+};
+
+struct pipe_end {
+    struct pipe *send;
+    struct pipe *recv;
+};
+
+static struct pipe to_server;
+static struct pipe to_client;
+static struct pipe_end cli_end = {&to_server, &to_client};
+static struct pipe_end srv_end = {&to_client, &to_server};
+
+static int pipe_send(void *ctx, const unsigned char *buf, size_t len)
+{
+    struct pipe *p = ((struct pipe_end *)ctx)->send;
+    if (p->len + len > PIPE_SIZE) {
+        return MBEDTLS_ERR_SSL_WANT_WRITE;
+    }
+
+    memcpy(p->buf + p->len, buf, len);
+    p->len += len;
+    return len;
+}
+
+static int pipe_recv(void *ctx, unsigned char *buf, size_t len)
+{
+    struct pipe *p = ((struct pipe_end *)ctx)->recv;
+    if (p->len == 0) {
+        return MBEDTLS_ERR_SSL_WANT_READ;
+    }
+
+    size_t n = p->len < len ? p->len : len;
+    memcpy(buf, p->buf, n);
+    memmove(p->buf, p->buf + n, p->len - n);
+    p->len -= n;
+    return n;
+}
+
+
+// Heap
+static unsigned char heap[HEAP_SIZE];
+
+static size_t heap_used(size_t *blocks)
+{
+    size_t used, count;
+    mbedtls_memory_buffer_alloc_cur_get(&used, &count);
+    if (blocks) {
+        *blocks = count;
+    }
+    return used;
+}
+
+static size_t heap_peak(void)
+{
+    size_t used, blocks;
+    mbedtls_memory_buffer_alloc_max_get(&used, &blocks);
+    return used;
+}
+
+
+// Certificates in DER, as they would be stored in flash
+struct der {
+    const char *name;
+    const unsigned char *der;
+    size_t len;
+    int ca;
+};
+
+enum { CA_EC, CA_RSA, SRV_EC, SRV_RSA, MANY, CERTS };
+
+static struct der certs[CERTS];
+
+static void to_der(struct der *d, const char *name, const char *pem, int ca)
+{
+    mbedtls_x509_crt crt;
+    mbedtls_x509_crt_init(&crt);
+    CHECK(mbedtls_x509_crt_parse(&crt, (const unsigned char *)pem, strlen(pem) + 1) == 0);
+
+    unsigned char *der = malloc(crt.raw.len);
+    CHECK(der != NULL);
+    memcpy(der, crt.raw.p, crt.raw.len);
+    d->name = name;
+    d->der = der;
+    d->len = crt.raw.len;
+    d->ca = ca;
+    mbedtls_x509_crt_free(&crt);
+}
+
+// Writes an element of GeneralNames or of a sequence of OIDs backwards
+static size_t write_element(unsigned char **p, unsigned char *start,
+        unsigned char tag, const void *data, size_t len)
+{
+    size_t n = 0;
+    int ret;
+
+    CHECK((ret = mbedtls_asn1_write_raw_buffer(p, start, data, len)) >= 0);
+    n += ret;
+    CHECK((ret = mbedtls_asn1_write_len(p, start, len)) >= 0);
+    n += ret;
+    CHECK((ret = mbedtls_asn1_write_tag(p, start, tag)) >= 0);
+    return n + ret;
+}
+
+static size_t write_sequence(unsigned char **p, unsigned char *start, size_t len)
+{
+    int ret, n;
+
+    CHECK((n = mbedtls_asn1_write_len(p, start, len)) >= 0);
+    CHECK((ret = mbedtls_asn1_write_tag(p, start,
+            MBEDTLS_ASN1_CONSTRUCTED | MBEDTLS_ASN1_SEQUENCE)) >= 0);
+    return len + n + ret;
+}
+
+// Issues a certificate for the EC test server key, from the EC test CA,
+// with DNS_NAMES dNSNames among other names and three extendedKeyUsages
+static void issue_many(mbedtls_ctr_drbg_context *drbg)
+{
+    static unsigned char san[4096], eku[64], out[4096];
+    static const unsigned char ip[4] = { 192, 0, 2, 1 };
+    static const char email[] = "admin@example.com";
+    char issuer[256], name[32];
+    unsigned char *p;
+    size_t len;
+    mbedtls_x509_crt ca;
+    mbedtls_pk_context ca_key, srv_key;
+    mbedtls_x509write_cert crt;
+    mbedtls_mpi serial;
+
+    mbedtls_x509_crt_init(&ca);
+    CHECK(mbedtls_x509_crt_parse_der(&ca, certs[CA_EC].der, certs[CA_EC].len) == 0);
+    CHECK(mbedtls_x509_dn_gets(issuer, sizeof issuer, &ca.subject) > 0);
+
+    mbedtls_pk_init(&ca_key);
+    mbedtls_pk_init(&srv_key);
+    CHECK(mbedtls_pk_parse_key(&ca_key, (const unsigned char *)mbedtls_test_ca_key_ec,
+            mbedtls_test_ca_key_ec_len, (const unsigned char *)mbedtls_test_ca_pwd_ec,
+            mbedtls_test_ca_pwd_ec_len) == 0);
+    CHECK(mbedtls_pk_parse_key(&srv_key, (const unsigned char *)mbedtls_test_srv_key_ec,
+            mbedtls_test_srv_key_ec_len, NULL, 0) == 0);
+
+    // Names other than dNSName are skipped by the parser, as before
+    p = san + sizeof san;
+    len = write_element(&p, san, MBEDTLS_ASN1_CONTEXT_SPECIFIC | 7, ip, sizeof ip);
+    for (int i = DNS_NAMES - 3; i >= 0; i--) {
+        snprintf(name, sizeof name, "host%02d.example.com", i);
+        len += write_element(&p, san, MBEDTLS_ASN1_CONTEXT_SPECIFIC | 2, name, strlen(name));
+        if (i == DNS_NAMES / 2) {
+            len += write_element(&p, san, MBEDTLS_ASN1_CONTEXT_SPECIFIC | 1,
+                    email, strlen(email));
+        }
+    }
+    len += write_element(&p, san, MBEDTLS_ASN1_CONTEXT_SPECIFIC | 2,
+            "*.wild.example.com", strlen("*.wild.example.com"));
+    len += write_element(&p, san, MBEDTLS_ASN1_CONTEXT_SPECIFIC | 2,
+            "localhost", strlen("localhost"));
+    len = write_sequence(&p, san, len);
+    const unsigned char *san_der = p;
+    size_t san_len = len;
+
+    p = eku + sizeof eku;
+    len = write_element(&p, eku, MBEDTLS_ASN1_OID, MBEDTLS_OID_EMAIL_PROTECTION,
+            MBEDTLS_OID_SIZE(MBEDTLS_OID_EMAIL_PROTECTION));
+    len += write_element(&p, eku, MBEDTLS_ASN1_OID, MBEDTLS_OID_CLIENT_AUTH,
+            MBEDTLS_OID_SIZE(MBEDTLS_OID_CLIENT_AUTH));
+    len += write_element(&p, eku, MBEDTLS_ASN1_OID, MBEDTLS_OID_SERVER_AUTH,
+            MBEDTLS_OID_SIZE(MBEDTLS_OID_SERVER_AUTH));
+    len = write_sequence(&p, eku, len);
+
+    mbedtls_mpi_init(&serial);
+    CHECK(mbedtls_mpi_lset(&serial, 49) == 0);
+
+    mbedtls_x509write_crt_init(&crt);
+    mbedtls_x509write_crt_set_md_alg(&crt, MBEDTLS_MD_SHA256);
+    mbedtls_x509write_crt_set_subject_key(&crt, &srv_key);
+    mbedtls_x509write_crt_set_issuer_key(&crt, &ca_key);
+    CHECK(mbedtls_x509write_crt_set_subject_name(&crt, "C=NL,O=PolarSSL,CN=localhost") == 0);
+    CHECK(mbedtls_x509write_crt_set_issuer_name(&crt, issuer) == 0);
+    CHECK(mbedtls_x509write_crt_set_serial(&crt, &serial) == 0);
+    CHECK(mbedtls_x509write_crt_set_validity(&crt, "20170101000000", "20370101000000") == 0);
+    CHECK(mbedtls_x509write_crt_set_basic_constraints(&crt, 0, -1) == 0);
+    CHECK(mbedtls_x509write_crt_set_extension(&crt, MBEDTLS_OID_SUBJECT_ALT_NAME,
+            MBEDTLS_OID_SIZE(MBEDTLS_OID_SUBJECT_ALT_NAME), 0, san_der, san_len) == 0);
+    CHECK(mbedtls_x509write_crt_set_extension(&crt, MBEDTLS_OID_EXTENDED_KEY_USAGE,
+            MBEDTLS_OID_SIZE(MBEDTLS_OID_EXTENDED_KEY_USAGE), 0, p, len) == 0);
+
+    int ret = mbedtls_x509write_crt_der(&crt, out, sizeof out,
+            mbedtls_ctr_drbg_random, drbg);
+    CHECK(ret > 0);
+
+    unsigned char *der = malloc(ret);
+    CHECK(der != NULL);
+    memcpy(der, out + sizeof out - ret, ret);
+    certs[MANY].name = "many names";
+    certs[MANY].der = der;
+    certs[MANY].len = ret;
+    certs[MANY].ca = CA_EC;
+
+    mbedtls_x509write_crt_free(&crt);
+    mbedtls_mpi_free(&serial);
+    mbedtls_pk_free(&srv_key);
+    mbedtls_pk_free(&ca_key);
+    mbedtls_x509_crt_free(&ca);
+}
+
+
+// Copied and referenced certificates must be indistinguishable, mutated
+// certificates are verified for the first names only
+#define MUTATED_NAMES 4
+
+static const char *host_names[] = {
+    SERVER_NAME, "a.wild.example.com", "localhost", "admin@example.com",
+    "LOCALHOST", "host00.example.com",
+    "host37.example.com", "host38.example.com", "wild.example.com",
+    "a.b.wild.example.com", "example.com", "192.0.2.1",
+    "PolarSSL Test EC CA", "",
+};
+
+static const char *usages[] = {
+    MBEDTLS_OID_SERVER_AUTH, MBEDTLS_OID_CLIENT_AUTH,
+    MBEDTLS_OID_EMAIL_PROTECTION, MBEDTLS_OID_CODE_SIGNING,
+    MBEDTLS_OID_ANY_EXTENDED_KEY_USAGE,
+};
+
+// Returns 1 if the certificate parsed
+static int compare(const unsigned char *der, size_t len, const mbedtls_x509_crt *ca,
+        size_t names, int expect_names)
+{
+    static char info_copy[4096], info_nocopy[4096];
+    mbedtls_x509_crt copy, nocopy;
+    uint32_t flags_copy, flags_nocopy;
+
+    mbedtls_x509_crt_init(&copy);
+    mbedtls_x509_crt_init(&nocopy);
+    int ret_copy = mbedtls_x509_crt_parse_der(&copy, der, len);
+    int ret_nocopy = mbedtls_x509_crt_parse_der_nocopy(&nocopy, der, len);
+    CHECK(ret_copy == ret_nocopy);
+
+    if (ret_copy == 0) {
+        CHECK(copy.raw.p != der && nocopy.raw.p == der);
+        CHECK(copy.raw.len == nocopy.raw.len);
+
+        int n = mbedtls_x509_crt_info(info_copy, sizeof info_copy, "", &copy);
+        CHECK(mbedtls_x509_crt_info(info_nocopy, sizeof info_nocopy, "", &nocopy) == n);
+        CHECK(n < 0 || strcmp(info_copy, info_nocopy) == 0);
+
+        for (size_t i = 0; i < names; i++) {
+            int ret = mbedtls_x509_crt_verify(&copy, (mbedtls_x509_crt *)ca, NULL,
+                    host_names[i], &flags_copy, NULL, NULL);
+            CHECK(mbedtls_x509_crt_verify(&nocopy, (mbedtls_x509_crt *)ca, NULL,
+                    host_names[i], &flags_nocopy, NULL, NULL) == ret);
+            CHECK(flags_copy == flags_nocopy);
+        }
+
+        for (size_t i = 0; i < sizeof usages / sizeof usages[0]; i++) {
+            size_t size = strlen(usages[i]);
+            int ret = mbedtls_x509_crt_check_extended_key_usage(&copy,
+                    usages[i], size);
+            CHECK(mbedtls_x509_crt_check_extended_key_usage(&nocopy,
+                    usages[i], size) == ret);
+        }
+    }
+
+    // The names found are those issued, however they are decoded
+    if (expect_names) {
+        char name[32];
+        CHECK(ret_copy == 0);
+        CHECK(strstr(info_copy, "localhost, *.wild.example.com, host00.example.com") != NULL);
+        for (int i = 0; i < DNS_NAMES - 2; i++) {
+            snprintf(name, sizeof name, "host%02d.example.com", i);
+            CHECK(strstr(info_copy, name) != NULL);
+        }
+        CHECK(strstr(info_copy, "admin@example.com") == NULL);
+        CHECK(strstr(info_copy, "TLS Web Server Authentication, "
+                "TLS Web Client Authentication, E-mail Protection") != NULL);
+
+        CHECK(mbedtls_x509_crt_verify(&nocopy, (mbedtls_x509_crt *)ca, NULL,
+                SERVER_NAME, &flags_nocopy, NULL, NULL) == 0);
+        CHECK(mbedtls_x509_crt_verify(&nocopy, (mbedtls_x509_crt *)ca, NULL,
+                "a.wild.example.com", &flags_nocopy, NULL, NULL) == 0);
+        CHECK(mbedtls_x509_crt_verify(&nocopy, (mbedtls_x509_crt *)ca, NULL,
+                "admin@example.com", &flags_nocopy, NULL, NULL) != 0);
+        CHECK(flags_nocopy == MBEDTLS_X509_BADCERT_CN_MISMATCH);
+        CHECK(mbedtls_x509_crt_check_extended_key_usage(&nocopy,
+                MBEDTLS_OID_CLIENT_AUTH,
+                MBEDTLS_OID_SIZE(MBEDTLS_OID_CLIENT_AUTH)) == 0);
+        CHECK(mbedtls_x509_crt_check_extended_key_usage(&nocopy,
+                MBEDTLS_OID_CODE_SIGNING,
+                MBEDTLS_OID_SIZE(MBEDTLS_OID_CODE_SIGNING)) != 0);
+    }
+
+    mbedtls_x509_crt_free(&nocopy);
+    mbedtls_x509_crt_free(&copy);
+    return ret_copy == 0;
+}
+
+static void check_certs(void)
+{
+    static unsigned char mutated[4096];
+    const struct der *many = &certs[MANY];
+    mbedtls_x509_crt cas[2];
+    unsigned parsed = 0;
+
+    for (int i = CA_EC; i <= CA_RSA; i++) {
+        mbedtls_x509_crt_init(&cas[i]);
+        CHECK(mbedtls_x509_crt_parse_der_nocopy(&cas[i], certs[i].der, certs[i].len) == 0);
+    }
+
+    for (int i = 0; i < CERTS; i++) {
+        CHECK(compare(certs[i].der, certs[i].len, &cas[certs[i].ca],
+                sizeof host_names / sizeof host_names[0], i == MANY));
+    }
+
+    // A few random bytes changed, mostly in the extensions, which are at
+    // the end of the certificate before its signature
+    CHECK(many->len <= sizeof mutated);
+    for (int i = 0; i < MUTATIONS; i++) {
+        memcpy(mutated, many->der, many->len);
+        for (int j = 1 + rand() % 3; j > 0; j--) {
+            size_t at = rand() % 2 ? rand() % many->len : many->len - 1 - rand() % 800;
+            mutated[at] = rand();
+        }
+        parsed += compare(mutated, many->len, &cas[CA_EC], MUTATED_NAMES, 0);
+    }
+
+    printf("HOST: %-5s %d certificates and %u of %u mutations parsed alike "
+           "with and without copies\r\n", EXTENSIONS, CERTS, parsed, MUTATIONS);
+
+    mbedtls_x509_crt_free(&cas[CA_RSA]);
+    mbedtls_x509_crt_free(&cas[CA_EC]);
+    CHECK(heap_used(NULL) == 0);
+}
+
+
+// Heap held by each certificate, parsed with and without a copy
+static void measure_certs(void)
+{
+    for (int i = 0; i < CERTS; i++) {
+        size_t used[2], blocks[2];
+
+        for (int nocopy = 0; nocopy < 2; nocopy++) {
+            mbedtls_x509_crt crt;
+            mbedtls_x509_crt_init(&crt);
+            size_t base_blocks, base = heap_used(&base_blocks);
+            CHECK((nocopy ? mbedtls_x509_crt_parse_der_nocopy :
+                   mbedtls_x509_crt_parse_der)(&crt, certs[i].der, certs[i].len) == 0);
+            used[nocopy] = heap_used(&blocks[nocopy]) - base;
+            blocks[nocopy] -= base_blocks;
+            mbedtls_x509_crt_free(&crt);
+        }
+
+        printf("HOST: %-5s %-10s %4u B DER, parsed: %5u B in %2u blocks copied, "
+               "%5u B in %2u blocks referenced\r\n", EXTENSIONS, certs[i].name,
+               (unsigned)certs[i].len, (unsigned)used[0], (unsigned)blocks[0],
+               (unsigned)used[1], (unsigned)blocks[1]);
+    }
+}
+
+
+// Handshake, with the certificates of both ends copied or referenced
+static mbedtls_entropy_context entropy;
+static mbedtls_ctr_drbg_context drbg;
+
+static void handshake(int nocopy, size_t *peak, size_t *established)
+{
+    int (*parse)(mbedtls_x509_crt *, const unsigned char *, size_t) =
+        nocopy ? mbedtls_x509_crt_parse_der_nocopy : mbedtls_x509_crt_parse_der;
+    static unsigned char tx[1000], echo[sizeof tx], rx[sizeof tx];
+    mbedtls_x509_crt ca_crt, srv_crt;
+    mbedtls_pk_context srv_key;
+    mbedtls_ssl_config cli_conf, srv_conf;
+    mbedtls_ssl_context cli, srv;
+
+    memset(&to_server, 0, sizeof to_server);
+    memset(&to_client, 0, sizeof to_client);
+    size_t base = heap_used(NULL);
+    mbedtls_memory_buffer_alloc_max_reset();
+
+    mbedtls_x509_crt_init(&ca_crt);
+    mbedtls_x509_crt_init(&srv_crt);
+    mbedtls_pk_init(&srv_key);
+    CHECK(parse(&ca_crt, certs[CA_EC].der, certs[CA_EC].len) == 0);
+    CHECK(parse(&ca_crt, certs[CA_RSA].der, certs[CA_RSA].len) == 0);
+    CHECK(parse(&srv_crt, certs[MANY].der, certs[MANY].len) == 0);
+    CHECK(mbedtls_pk_parse_key(&srv_key, (const unsigned char *)mbedtls_test_srv_key_ec,
+            mbedtls_test_srv_key_ec_len, NULL, 0) == 0);
+
+    mbedtls_ssl_config_init(&cli_conf);
+    CHECK(mbedtls_ssl_config_defaults(&cli_conf, MBEDTLS_SSL_IS_CLIENT,
+            MBEDTLS_SSL_TRANSPORT_STREAM, MBEDTLS_SSL_PRESET_DEFAULT) == 0);
+    mbedtls_ssl_conf_rng(&cli_conf, mbedtls_ctr_drbg_random, &drbg);
+    mbedtls_ssl_conf_ca_chain(&cli_conf, &ca_crt, NULL);
+    mbedtls_ssl_conf_authmode(&cli_conf, MBEDTLS_SSL_VERIFY_REQUIRED);
+
+    mbedtls_ssl_config_init(&srv_conf);
+    CHECK(mbedtls_ssl_config_defaults(&srv_conf, MBEDTLS_SSL_IS_SERVER,
+            MBEDTLS_SSL_TRANSPORT_STREAM, MBEDTLS_SSL_PRESET_DEFAULT) == 0);
+    mbedtls_ssl_conf_rng(&srv_conf, mbedtls_ctr_drbg_random, &drbg);
+    CHECK(mbedtls_ssl_conf_own_cert(&srv_conf, &srv_crt, &srv_key) == 0);
+
+    mbedtls_ssl_init(&cli);
+    CHECK(mbedtls_ssl_setup(&cli, &cli_conf) == 0);
+    CHECK(mbedtls_ssl_set_hostname(&cli, SERVER_NAME) == 0);
+    mbedtls_ssl_set_bio(&cli, &cli_end, pipe_send, pipe_recv, NULL);
+
+    mbedtls_ssl_init(&srv);
+    CHECK(mbedtls_ssl_setup(&srv, &srv_conf) == 0);
+    mbedtls_ssl_set_bio(&srv, &srv_end, pipe_send, pipe_recv, NULL);
+
+    int cli_ret = MBEDTLS_ERR_SSL_WANT_READ;
+    int srv_ret = MBEDTLS_ERR_SSL_WANT_READ;
+    for (int i = 0; cli_ret || srv_ret; i++) {
+        CHECK(i < MAX_ROUNDS);
+        if (cli_ret) {
+            cli_ret = mbedtls_ssl_handshake(&cli);
+            CHECK(cli_ret == 0 || WOULD_BLOCK(cli_ret));
+        }
+        if (srv_ret) {
+            srv_ret = mbedtls_ssl_handshake(&srv);
+            CHECK(srv_ret == 0 || WOULD_BLOCK(srv_ret));
+        }
+    }
+    CHECK(mbedtls_ssl_get_verify_result(&cli) == 0);
+
+    // Client sends a record, the server echoes it back
+    for (size_t i = 0; i < sizeof tx; i++) {
+        tx[i] = rand();
+    }
+    CHECK(mbedtls_ssl_write(&cli, tx, sizeof tx) == sizeof tx);
+    size_t srv_got = 0, got = 0;
+    for (int i = 0; got < sizeof rx; i++) {
+        CHECK(i < MAX_ROUNDS);
+        int ret = mbedtls_ssl_read(&srv, echo + srv_got, sizeof echo - srv_got);
+        CHECK(ret > 0 || WOULD_BLOCK(ret));
+        if (ret > 0) {
+            CHECK(mbedtls_ssl_write(&srv, echo + srv_got, ret) == ret);
+            srv_got += ret;
+        }
+        ret = mbedtls_ssl_read(&cli, rx + got, sizeof rx - got);
+        CHECK(ret > 0 || WOULD_BLOCK(ret));
+        got += ret > 0 ? ret : 0;
+    }
+    CHECK(memcmp(tx, rx, sizeof tx) == 0);
+
+    *peak = heap_peak() - base;
+    *established = heap_used(NULL) - base;
+
+    mbedtls_ssl_free(&srv);
+    mbedtls_ssl_free(&cli);
+    mbedtls_ssl_config_free(&srv_conf);
+    mbedtls_ssl_config_free(&cli_conf);
+    mbedtls_pk_free(&srv_key);
+    mbedtls_x509_crt_free(&srv_crt);
+    mbedtls_x509_crt_free(&ca_crt);
+    CHECK(heap_used(NULL) == base);
+}
+
+static void measure_handshake(void)
+{
+    for (int nocopy = 0; nocopy < 2; nocopy++) {
+        size_t peak, established;
+        handshake(nocopy, &peak, &established);
+        printf("HOST: %-5s handshake, certificates %-10s peak %6u B, "
+               "established %6u B\r\n", EXTENSIONS,
+               nocopy ? "referenced" : "copied", (unsigned)peak,
+               (unsigned)established);
+    }
+}
+
+int main(void)
+{
+    // Decoded with the allocator of the host, before the heap is set up
+    mbedtls_entropy_init(&entropy);
+    mbedtls_ctr_drbg_init(&drbg);
+    CHECK(mbedtls_ctr_drbg_seed(&drbg, mbedtls_entropy_func, &entropy, NULL, 0) == 0);
+
+    to_der(&certs[CA_EC], "EC CA", mbedtls_test_ca_crt_ec, CA_EC);
+    to_der(&certs[CA_RSA], "RSA CA", mbedtls_test_ca_crt_rsa, CA_RSA);
+    to_der(&certs[SRV_EC], "EC server", mbedtls_test_srv_crt_ec, CA_EC);
+    to_der(&certs[SRV_RSA], "RSA server", mbedtls_test_srv_crt_rsa, CA_RSA);
+    issue_many(&drbg);
+
+    mbedtls_memory_buffer_alloc_init(heap, sizeof heap);
+
+    check_certs();
+    measure_certs();
+    measure_handshake();
+
+    CHECK(mbedtls_x509_self_test(0) == 0);
+
+    mbedtls_ctr_drbg_free(&drbg);
+    mbedtls_entropy_free(&entropy);
+    CHECK(mbedtls_memory_buffer_alloc_verify() == 0);
+    mbedtls_memory_buffer_alloc_free();
+
+    printf("HOST: all passed\r\n");
+    return 0;
+}
@@ -0,0 +1,42 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* mbed TLS user configuration of the x509_nocopy host test, included at
+ * the end of mbedtls/config.h
+ */
+
+// All allocations of mbed TLS come from the heap of memory_buffer_alloc,
+// which keeps count of the bytes in use
+#define MBEDTLS_PLATFORM_MEMORY
+#define MBEDTLS_MEMORY_BUFFER_ALLOC_C
+#define MBEDTLS_MEMORY_DEBUG
+
+// The eager build decodes the extensions into lists, as before
+#if !defined(X509_NOCOPY_EAGER)
+#define MBEDTLS_X509_CRT_LAZY_EXTENSIONS
+#endif
+
+// Certificates with many names are issued by the test itself
+#define MBEDTLS_X509_CREATE_C
+#define MBEDTLS_X509_CRT_WRITE_C
+
+// The key of the EC test CA is encrypted with 3DES, from a password hashed
+// with MD5
+#define MBEDTLS_DES_C
+#define MBEDTLS_MD5_C
+
+// The RSA test certificates are signed with SHA-1
+#define MBEDTLS_SHA1_C
@@ -0,0 +1,137 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#if !defined(TARGET_LIKE_POSIX)
+    #error [NOT_SUPPORTED] Host benchmark, build with the Makefile in this directory
+#endif
+
+/* Host check and benchmark of mbed_lwip_chksum_copy
+ *
+ * Checks the fused copy and checksum against lwIP's own checksum for every
+ * combination of source and destination alignment over a range of lengths,
+ * then times the three ways data can get into a TCP segment: copying and
+ * then checksumming in a second pass, the fused routine, and copying alone
+ * as when the EMAC offloads the checksum. The destination is two bytes off
+ * word alignment, as for TCP payload behind an Ethernet header.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "lwip/opt.h"
+#include "lwip/def.h"
+
+
+#ifndef MBED_CFG_CHECKSUM_COPY_MAX
+#define MBED_CFG_CHECKSUM_COPY_MAX  1600
+#endif
+
+// Bytes run through each routine for every size timed
+#ifndef MBED_CFG_CHECKSUM_COPY_BYTES
+#define MBED_CFG_CHECKSUM_COPY_BYTES (64 * 1024 * 1024)
+#endif
+
+#define CHECK(cond) do {                                                \
+        if (!(cond)) {                                                  \
+            printf("HOST: %s:%d: check failed: %s\r\n",                 \
+                   __FILE__, __LINE__, #cond);                          \
+            exit(EXIT_FAILURE);                                         \
+        }                                                               \
+    } while (0)
+
+// From lwip_inet_chksum.c, the routine behind LWIP_CHKSUM on this host
+u16_t lwip_standard_chksum(const void *dataptr, int len);
+
+typedef u16_t (*copy_fn_t)(void *dst, const void *src, u16_t len);
+
+static u8_t src_buffer[MBED_CFG_CHECKSUM_COPY_MAX + 8];
+static u8_t dst_buffer[MBED_CFG_CHECKSUM_COPY_MAX + 8];
+static volatile u32_t sink;
+
+
+static u16_t copy_then_checksum(void *dst, const void *src, u16_t len)
+{
+    MEMCPY(dst, src, len);
+    return lwip_standard_chksum(dst, len);
+}
+
+static u16_t copy_only(void *dst, const void *src, u16_t len)
+{
+    MEMCPY(dst, src, len);
+    return 0;
+}
+
+static void check_alignments(void)
+{
+    for (unsigned len = 0; len <= MBED_CFG_CHECKSUM_COPY_MAX; len++) {
+        for (unsigned src_off = 0; src_off < 4; src_off++) {
+            for (unsigned dst_off = 0; dst_off < 4; dst_off++) {
+                u8_t *src = src_buffer + src_off;
+                u8_t *dst = dst_buffer + dst_off;
+
+                memset(dst_buffer, 0xa5, sizeof(dst_buffer));
+                u16_t sum = mbed_lwip_chksum_copy(dst, src, len);
+
+                CHECK(sum == lwip_standard_chksum(src, len));
+                CHECK(memcmp(dst, src, len) == 0);
+                CHECK(dst[len] == 0xa5);
+                CHECK(dst_off == 0 || dst[-1] == 0xa5);
+            }
+        }
+    }
+}
+
+static void bench(const char *name, copy_fn_t copy, u16_t len)
+{
+    unsigned count = MBED_CFG_CHECKSUM_COPY_BYTES / len;
+    struct timespec start, end;
+    u32_t sum = 0;
+
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &start);
+    for (unsigned i = 0; i < count; i++) {
+        sum += copy(dst_buffer + 2, src_buffer, len);
+    }
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &end);
+    sink += sum;
+
+    double seconds = (end.tv_sec - start.tv_sec) + 1e-9 * (end.tv_nsec - start.tv_nsec);
+    printf("HOST: %-20s %4u bytes: %8.1f ns/copy, %7.1f MB/s\r\n",
+           name, (unsigned)len, 1e9 * seconds / count,
+           (double)count * len / (1e6 * seconds));
+}
+
+int main(void)
+{
+    srand(0x6d626564);
+    for (unsigned i = 0; i < sizeof(src_buffer); i++) {
+        src_buffer[i] = rand();
+    }
+
+    check_alignments();
+    printf("HOST: mbed_lwip_chksum_copy matches LWIP_CHKSUM for 0-%u bytes at all alignments\r\n",
+           MBED_CFG_CHECKSUM_COPY_MAX);
+
+    static const u16_t sizes[] = {64, 536, 1460};
+    for (unsigned i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        bench("copy then checksum", copy_then_checksum, sizes[i]);
+        bench("fused", mbed_lwip_chksum_copy, sizes[i]);
+        bench("copy only (offload)", copy_only, sizes[i]);
+    }
+
+    return EXIT_SUCCESS;
+}
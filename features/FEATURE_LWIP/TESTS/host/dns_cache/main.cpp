@@ -0,0 +1,342 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#if !defined(TARGET_LIKE_POSIX)
+    #error [NOT_SUPPORTED] Host test, build with the Makefile in this directory
+#endif
+
+/* Host test of the nsapi_dns resolver
+ *
+ * A fake DNS server runs on the stack itself, on one end of a loopback EMAC
+ * pair whose far end reflects every frame back. The resolver is driven
+ * through a copy of lwip_stack with gethostbyname removed, so lookups go
+ * through nsapi_dns as they do on stacks without a resolver of their own.
+ *
+ * The server counts the queries it sees for each name, which is how the
+ * test tells answers from the cache apart from answers off the network.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "lwip_stack.h"
+#include "loopback_emac.h"
+#include "nsapi_dns.h"
+#include "cmsis_os2.h"
+#include "rtos/Semaphore.h"
+
+#define HOST_IP     "10.0.0.2"
+#define NETMASK     "255.255.255.0"
+#define GATEWAY     "10.0.0.1"
+
+// Nothing answers here, the resolver should not wait on it
+#define DEAD_SERVER "10.0.0.9"
+
+#define COALESCE_THREADS 4
+
+
+#define CHECK(cond) do {                                                \
+        if (!(cond)) {                                                  \
+            printf("HOST: %s:%d: check failed: %s\r\n",                 \
+                   __FILE__, __LINE__, #cond);                          \
+            exit(EXIT_FAILURE);                                         \
+        }                                                               \
+    } while (0)
+
+
+// Fake DNS server
+struct fake_record {
+    const char *name;
+    uint8_t addr[NSAPI_IPv4_BYTES];
+    uint32_t ttl;           // seconds, for answers and the SOA of negative answers
+    uint8_t rcode;
+    bool soa;               // send an SOA with negative answers
+    unsigned delay;         // ms before answering
+    volatile unsigned queries;
+};
+
+static fake_record records[] = {
+    {"cached.test",  {10, 0, 1, 1}, 60, 0, false, 0,   0},
+    {"short.test",   {10, 0, 1, 2}, 1,  0, false, 0,   0},
+    {"slow.test",    {10, 0, 1, 3}, 60, 0, false, 200, 0},
+    {"async.test",   {10, 0, 1, 4}, 60, 0, false, 0,   0},
+    {"missing.test", {0},           60, 3, true,  0,   0},
+    {"nosoa.test",   {0},           60, 3, false, 0,   0},
+};
+
+#define RECORD_COUNT (sizeof records / sizeof records[0])
+
+static void put_word(uint8_t **p, uint16_t word)
+{
+    *(*p)++ = word >> 8;
+    *(*p)++ = word;
+}
+
+static void put_dword(uint8_t **p, uint32_t dword)
+{
+    put_word(p, dword >> 16);
+    put_word(p, dword);
+}
+
+static fake_record *find_record(const uint8_t *name)
+{
+    char host[256];
+    size_t len = 0;
+
+    while (*name) {
+        if (len) {
+            host[len++] = '.';
+        }
+        memcpy(&host[len], name + 1, *name);
+        len += *name;
+        name += *name + 1;
+    }
+    host[len] = '\0';
+
+    for (unsigned i = 0; i < RECORD_COUNT; i++) {
+        if (strcasecmp(records[i].name, host) == 0) {
+            return &records[i];
+        }
+    }
+
+    return NULL;
+}
+
+static void *dns_server_thread(void *stack)
+{
+    UDPSocket sock;
+    CHECK(sock.open((NetworkStack *)stack) == 0);
+    CHECK(sock.bind(53) == 0);
+
+    uint8_t packet[512];
+    while (true) {
+        SocketAddress from;
+        nsapi_size_or_error_t size = sock.recvfrom(&from, packet, sizeof packet);
+        CHECK(size >= 12);
+
+        // echo back the header and question, then answer it
+        const uint8_t *name = packet + 12;
+        const uint8_t *end = name + strlen((const char *)name) + 1 + 4;
+        fake_record *record = find_record(name);
+
+        uint8_t *p = packet + 2;
+        put_word(&p, 0x8180 | (record ? record->rcode : 3));
+        put_word(&p, 1);
+        put_word(&p, record && !record->rcode);
+        put_word(&p, record && record->rcode && record->soa);
+        put_word(&p, 0);
+        p = (uint8_t *)end;
+
+        if (record) {
+            record->queries += 1;
+
+            if (!record->rcode) {
+                put_word(&p, 0xc00c);       // name of the question
+                put_word(&p, 1);            // A
+                put_word(&p, 1);            // IN
+                put_dword(&p, record->ttl);
+                put_word(&p, NSAPI_IPv4_BYTES);
+                memcpy(p, record->addr, NSAPI_IPv4_BYTES);
+                p += NSAPI_IPv4_BYTES;
+            } else if (record->soa) {
+                put_word(&p, 0xc00c);
+                put_word(&p, 6);            // SOA
+                put_word(&p, 1);
+                put_dword(&p, 3600);
+                put_word(&p, 22);
+                *p++ = 0;                   // mname
+                *p++ = 0;                   // rname
+                put_dword(&p, 1);           // serial
+                put_dword(&p, 3600);        // refresh
+                put_dword(&p, 600);         // retry
+                put_dword(&p, 86400);       // expire
+                put_dword(&p, record->ttl); // minimum
+            }
+
+            usleep(record->delay * 1000);
+        }
+
+        CHECK(sock.sendto(from, packet, p - packet) == p - packet);
+    }
+
+    return NULL;
+}
+
+static unsigned queries(const char *name)
+{
+    for (unsigned i = 0; i < RECORD_COUNT; i++) {
+        if (strcmp(records[i].name, name) == 0) {
+            return records[i].queries;
+        }
+    }
+
+    return 0;
+}
+
+
+// Tests
+static NetworkStack *stack;
+
+static uint64_t now()
+{
+    return osKernelGetTickCount();
+}
+
+static void resolve(const char *name, nsapi_error_t expected, const char *ip)
+{
+    SocketAddress address;
+    nsapi_error_t err = stack->gethostbyname(name, &address);
+    CHECK(err == expected);
+    if (ip) {
+        CHECK(strcmp(address.get_ip_address(), ip) == 0);
+    }
+}
+
+static void test_cache_hit()
+{
+    uint64_t start = now();
+    resolve("cached.test", NSAPI_ERROR_OK, "10.0.1.1");
+    resolve("cached.test", NSAPI_ERROR_OK, "10.0.1.1");
+    resolve("CACHED.test", NSAPI_ERROR_OK, "10.0.1.1");
+    CHECK(queries("cached.test") == 1);
+
+    // the dead server is asked first, but not waited on
+    CHECK(now() - start < 1000);
+    printf("HOST: cache hit ok\r\n");
+}
+
+static void test_ttl_expiry()
+{
+    resolve("short.test", NSAPI_ERROR_OK, "10.0.1.2");
+    resolve("short.test", NSAPI_ERROR_OK, "10.0.1.2");
+    CHECK(queries("short.test") == 1);
+
+    usleep(1100 * 1000);
+    resolve("short.test", NSAPI_ERROR_OK, "10.0.1.2");
+    CHECK(queries("short.test") == 2);
+    printf("HOST: ttl expiry ok\r\n");
+}
+
+static void test_negative_cache()
+{
+    resolve("missing.test", NSAPI_ERROR_DNS_FAILURE, NULL);
+    resolve("missing.test", NSAPI_ERROR_DNS_FAILURE, NULL);
+    CHECK(queries("missing.test") == 1);
+
+    // without an SOA there is nothing to say how long "no" lasts
+    resolve("nosoa.test", NSAPI_ERROR_DNS_FAILURE, NULL);
+    resolve("nosoa.test", NSAPI_ERROR_DNS_FAILURE, NULL);
+    CHECK(queries("nosoa.test") == 2);
+    printf("HOST: negative cache ok\r\n");
+}
+
+static void *coalesce_thread(void *)
+{
+    resolve("slow.test", NSAPI_ERROR_OK, "10.0.1.3");
+    return NULL;
+}
+
+static void test_coalescing()
+{
+    pthread_t threads[COALESCE_THREADS];
+    for (unsigned i = 0; i < COALESCE_THREADS; i++) {
+        CHECK(pthread_create(&threads[i], NULL, coalesce_thread, NULL) == 0);
+    }
+
+    for (unsigned i = 0; i < COALESCE_THREADS; i++) {
+        CHECK(pthread_join(threads[i], NULL) == 0);
+    }
+
+    CHECK(queries("slow.test") == 1);
+    printf("HOST: coalescing ok\r\n");
+}
+
+static rtos::Semaphore async_done;
+static nsapi_error_t async_result;
+static char async_ip[NSAPI_IP_SIZE];
+
+static void async_callback(nsapi_error_t result, SocketAddress *address)
+{
+    async_result = result;
+    strcpy(async_ip, address ? address->get_ip_address() : "");
+    async_done.release();
+}
+
+static void test_async()
+{
+    CHECK(stack->gethostbyname_async("async.test", async_callback) == 0);
+    CHECK(async_done.wait(5000) > 0);
+    CHECK(async_result == NSAPI_ERROR_OK);
+    CHECK(strcmp(async_ip, "10.0.1.4") == 0);
+
+    CHECK(stack->gethostbyname_async("missing.test", async_callback) == 0);
+    CHECK(async_done.wait(5000) > 0);
+    CHECK(async_result == NSAPI_ERROR_DNS_FAILURE);
+    CHECK(queries("missing.test") == 1);
+
+    CHECK(stack->gethostbyname_async("10.0.1.5", async_callback) == 0);
+    CHECK(async_done.wait(5000) > 0);
+    CHECK(async_result == NSAPI_ERROR_OK);
+    CHECK(strcmp(async_ip, "10.0.1.5") == 0);
+    printf("HOST: async ok\r\n");
+}
+
+
+// The far end of the link hands every frame straight back
+static void reflect_input(void *data, emac_stack_mem_chain_t *chain)
+{
+    emac_interface_t *emac = (emac_interface_t *)data;
+    emac_stack_mem_t *buf = emac_stack_mem_chain_dequeue(NULL, &chain);
+
+    emac->ops.link_out(emac, buf);
+    emac_stack_mem_free(NULL, buf);
+}
+
+int main()
+{
+    emac_interface_t *reflector = loopback_emac_get(1);
+    reflector->ops.set_link_input_cb(reflector, reflect_input, reflector);
+    CHECK(reflector->ops.power_up(reflector));
+
+    CHECK(mbed_lwip_init(loopback_emac_get(0)) == 0);
+    CHECK(mbed_lwip_bringup(false, HOST_IP, NETMASK, GATEWAY) == 0);
+
+    // lwip_stack without its own resolver
+    static nsapi_stack_api_t api = *lwip_stack.stack_api;
+    static nsapi_stack_t nsapi_stack = lwip_stack;
+    api.gethostbyname = NULL;
+    nsapi_stack.stack_api = &api;
+    stack = nsapi_create_stack(&nsapi_stack);
+
+    CHECK(nsapi_dns_add_server(HOST_IP) == 0);
+    CHECK(nsapi_dns_add_server(DEAD_SERVER) == 0);
+
+    pthread_t server;
+    CHECK(pthread_create(&server, NULL, dns_server_thread, stack) == 0);
+    printf("HOST: lwIP up at %s, DNS server on port 53\r\n", HOST_IP);
+
+    test_cache_hit();
+    test_ttl_expiry();
+    test_negative_cache();
+    test_coalescing();
+    test_async();
+
+    printf("HOST: all passed\r\n");
+    return EXIT_SUCCESS;
+}
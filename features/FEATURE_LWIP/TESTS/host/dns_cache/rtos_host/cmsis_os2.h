@@ -0,0 +1,67 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/* The slice of the CMSIS-RTOS2 API used by the platform and netsocket
+ * headers, on pthreads, for host builds of the C++ socket layer */
+#ifndef CMSIS_OS2_H_
+#define CMSIS_OS2_H_
+
+#include <stdint.h>
+#include <time.h>
+#include <pthread.h>
+
+#define osWaitForever 0xFFFFFFFFU
+
+typedef enum {
+    osOK            =  0,
+    osError         = -1,
+    osErrorTimeout  = -2,
+    osErrorResource = -3,
+} osStatus_t;
+
+typedef osStatus_t osStatus;
+
+typedef enum {
+    osPriorityNormal = 24,
+} osPriority_t;
+
+typedef osPriority_t osPriority;
+
+typedef pthread_mutex_t *osMutexId_t;
+
+static inline osStatus_t osMutexAcquire(osMutexId_t mutex_id, uint32_t timeout)
+{
+    (void)timeout;
+    return pthread_mutex_lock(mutex_id) ? osError : osOK;
+}
+
+static inline osStatus_t osMutexRelease(osMutexId_t mutex_id)
+{
+    return pthread_mutex_unlock(mutex_id) ? osError : osOK;
+}
+
+static inline uint32_t osKernelGetTickFreq(void)
+{
+    return 1000;
+}
+
+static inline uint64_t osKernelGetTickCount(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
+
+#endif
@@ -0,0 +1,36 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/* Stands in for mbed.h in host builds of the C++ socket layer */
+#ifndef MBED_H
+#define MBED_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <new>
+
+#include "platform/mbed_assert.h"
+#include "platform/mbed_toolchain.h"
+#include "platform/Callback.h"
+#include "rtos/Mutex.h"
+#include "rtos/Semaphore.h"
+#include "rtos/Thread.h"
+
+using namespace mbed;
+using namespace rtos;
+
+#endif
@@ -0,0 +1,47 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef MUTEX_H
+#define MUTEX_H
+
+#include <pthread.h>
+#include "cmsis_os2.h"
+
+namespace rtos {
+
+/** Recursive mutex on pthreads, for host builds */
+class Mutex {
+public:
+    Mutex();
+    Mutex(const char *name);
+    ~Mutex();
+
+    osStatus lock(uint32_t millisec=osWaitForever);
+    bool trylock();
+    osStatus unlock();
+
+private:
+    void constructor();
+
+    pthread_mutex_t _mutex;
+
+    // Noncopyable
+    Mutex(const Mutex &);
+    Mutex &operator=(const Mutex &);
+};
+
+}
+
+#endif
@@ -0,0 +1,53 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef SEMAPHORE_H
+#define SEMAPHORE_H
+
+#include <stdint.h>
+#include <pthread.h>
+#include "cmsis_os2.h"
+
+namespace rtos {
+
+/** Counting semaphore on pthreads, for host builds */
+class Semaphore {
+public:
+    Semaphore(int32_t count=0);
+    Semaphore(int32_t count, uint16_t max_count);
+    ~Semaphore();
+
+    /** Wait until a token is available
+     *  @return  Number of tokens available before this one was taken, 0 on timeout
+     */
+    int32_t wait(uint32_t millisec=osWaitForever);
+    osStatus release(void);
+
+private:
+    void constructor(int32_t count, uint16_t max_count);
+
+    pthread_mutex_t _mutex;
+    pthread_cond_t _cond;
+    int32_t _count;
+    uint16_t _max_count;
+
+    // Noncopyable
+    Semaphore(const Semaphore &);
+    Semaphore &operator=(const Semaphore &);
+};
+
+}
+
+#endif
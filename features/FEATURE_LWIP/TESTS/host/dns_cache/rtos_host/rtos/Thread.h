@@ -0,0 +1,54 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef THREAD_H
+#define THREAD_H
+
+#include <stdint.h>
+#include <pthread.h>
+#include "cmsis_os2.h"
+#include "platform/Callback.h"
+
+namespace rtos {
+
+/** Thread on pthreads, for host builds. Priority and stack size are
+ *  accepted for compatibility and left to the host scheduler. */
+class Thread {
+public:
+    Thread(osPriority priority=osPriorityNormal,
+           uint32_t stack_size=0, unsigned char *stack_mem=NULL,
+           const char *name=NULL);
+    ~Thread();
+
+    osStatus start(mbed::Callback<void()> task);
+    osStatus join();
+
+    static osStatus wait(uint32_t millisec);
+
+private:
+    static void *_thunk(void *thread_ptr);
+
+    mbed::Callback<void()> _task;
+    pthread_t _thread;
+    bool _started;
+
+    // Noncopyable
+    Thread(const Thread &);
+    Thread &operator=(const Thread &);
+};
+
+}
+
+#endif
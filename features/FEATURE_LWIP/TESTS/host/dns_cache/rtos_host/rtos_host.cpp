@@ -0,0 +1,205 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/* rtos primitives on pthreads, for host builds of the C++ socket layer */
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "cmsis_os2.h"
+#include "rtos/Mutex.h"
+#include "rtos/Semaphore.h"
+#include "rtos/Thread.h"
+
+static pthread_mutex_t singleton_mutex = PTHREAD_MUTEX_INITIALIZER;
+osMutexId_t singleton_mutex_id = &singleton_mutex;
+
+static void deadline(struct timespec *ts, uint32_t millisec)
+{
+    clock_gettime(CLOCK_REALTIME, ts);
+    ts->tv_sec += millisec / 1000;
+    ts->tv_nsec += (millisec % 1000) * 1000000L;
+    if (ts->tv_nsec >= 1000000000L) {
+        ts->tv_sec += 1;
+        ts->tv_nsec -= 1000000000L;
+    }
+}
+
+namespace rtos {
+
+Mutex::Mutex()
+{
+    constructor();
+}
+
+Mutex::Mutex(const char *name)
+{
+    constructor();
+}
+
+void Mutex::constructor()
+{
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(&_mutex, &attr);
+    pthread_mutexattr_destroy(&attr);
+}
+
+Mutex::~Mutex()
+{
+    pthread_mutex_destroy(&_mutex);
+}
+
+osStatus Mutex::lock(uint32_t millisec)
+{
+    if (millisec == osWaitForever) {
+        return pthread_mutex_lock(&_mutex) ? osError : osOK;
+    }
+
+    struct timespec ts;
+    deadline(&ts, millisec);
+    int err = pthread_mutex_timedlock(&_mutex, &ts);
+    return err == ETIMEDOUT ? osErrorTimeout : err ? osError : osOK;
+}
+
+bool Mutex::trylock()
+{
+    return pthread_mutex_trylock(&_mutex) == 0;
+}
+
+osStatus Mutex::unlock()
+{
+    return pthread_mutex_unlock(&_mutex) ? osError : osOK;
+}
+
+
+Semaphore::Semaphore(int32_t count)
+{
+    constructor(count, 0xffff);
+}
+
+Semaphore::Semaphore(int32_t count, uint16_t max_count)
+{
+    constructor(count, max_count);
+}
+
+void Semaphore::constructor(int32_t count, uint16_t max_count)
+{
+    pthread_mutex_init(&_mutex, NULL);
+    pthread_cond_init(&_cond, NULL);
+    _count = count;
+    _max_count = max_count;
+}
+
+Semaphore::~Semaphore()
+{
+    pthread_cond_destroy(&_cond);
+    pthread_mutex_destroy(&_mutex);
+}
+
+int32_t Semaphore::wait(uint32_t millisec)
+{
+    struct timespec ts;
+    if (millisec != osWaitForever) {
+        deadline(&ts, millisec);
+    }
+
+    pthread_mutex_lock(&_mutex);
+    while (_count == 0) {
+        if (millisec == osWaitForever) {
+            pthread_cond_wait(&_cond, &_mutex);
+        } else if (millisec == 0 ||
+                pthread_cond_timedwait(&_cond, &_mutex, &ts) == ETIMEDOUT) {
+            break;
+        }
+    }
+
+    int32_t count = _count;
+    if (_count > 0) {
+        _count -= 1;
+    }
+    pthread_mutex_unlock(&_mutex);
+    return count;
+}
+
+osStatus Semaphore::release(void)
+{
+    osStatus status = osOK;
+
+    pthread_mutex_lock(&_mutex);
+    if (_count < _max_count) {
+        _count += 1;
+        pthread_cond_signal(&_cond);
+    } else {
+        status = osErrorResource;
+    }
+    pthread_mutex_unlock(&_mutex);
+    return status;
+}
+
+
+Thread::Thread(osPriority priority, uint32_t stack_size,
+        unsigned char *stack_mem, const char *name)
+    : _started(false)
+{
+}
+
+Thread::~Thread()
+{
+    if (_started) {
+        pthread_detach(_thread);
+    }
+}
+
+void *Thread::_thunk(void *thread_ptr)
+{
+    Thread *t = (Thread *)thread_ptr;
+    t->_task();
+    return NULL;
+}
+
+osStatus Thread::start(mbed::Callback<void()> task)
+{
+    if (_started) {
+        return osErrorResource;
+    }
+
+    _task = task;
+    if (pthread_create(&_thread, NULL, Thread::_thunk, this)) {
+        return osErrorResource;
+    }
+
+    _started = true;
+    return osOK;
+}
+
+osStatus Thread::join()
+{
+    if (!_started || pthread_join(_thread, NULL)) {
+        return osError;
+    }
+
+    _started = false;
+    return osOK;
+}
+
+osStatus Thread::wait(uint32_t millisec)
+{
+    usleep(millisec * 1000);
+    return osOK;
+}
+
+}
@@ -0,0 +1,741 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#if !defined(TARGET_LIKE_POSIX)
+    #error [NOT_SUPPORTED] Host benchmark, build with the Makefile in this directory
+#endif
+
+/* Host benchmark of lwip_stack.c
+ *
+ * Runs the tcp_packet_pressure and udp_packet_pressure sequences against an
+ * echo server on the same stack. The stack sits on one end of a loopback
+ * EMAC pair and the other end reflects every frame back, so each packet goes
+ * through the full EMAC transmit and receive paths twice. The echo servers
+ * receive with the zero-copy buffer calls and send straight out of the
+ * stack's pbufs, gathering a chain of pbufs into one sendmsg. The UDP client
+ * receives with recvmsg scattered over two vectors.
+ *
+ * The TCP sequence runs twice, the second time lending buffers with
+ * send_ref on both the client and the echo server instead of copying.
+ *
+ * With MBED_CFG_PACKET_PRESSURE_OFFLOAD the loopback EMAC claims checksum
+ * offload in both directions, leaving the stack to skip checksums entirely.
+ *
+ * With MBED_CFG_PACKET_PRESSURE_LOSS the stack's end of the link loses that
+ * many frames per million during the packet pressure sequences, to compare
+ * TCP profiles on a lossy link.
+ *
+ * The connection churn sequence opens far more short-lived connections than
+ * there are pcbs, relying on the stack to recycle those left in TIME_WAIT.
+ * With lwip.socket-grow it then holds more connections open at once than
+ * lwip.socket-max allows. The stack's statistics are printed at the end.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <time.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "lwip_stack.h"
+#include "emac_stack_mem.h"
+#include "loopback_emac.h"
+#include "lwip/sys.h"
+
+
+#ifndef MBED_CFG_TCP_CLIENT_PACKET_PRESSURE_MIN
+#define MBED_CFG_TCP_CLIENT_PACKET_PRESSURE_MIN 64
+#endif
+
+#ifndef MBED_CFG_TCP_CLIENT_PACKET_PRESSURE_MAX
+#define MBED_CFG_TCP_CLIENT_PACKET_PRESSURE_MAX 0x80000
+#endif
+
+#ifndef MBED_CFG_UDP_CLIENT_PACKET_PRESSURE_MIN
+#define MBED_CFG_UDP_CLIENT_PACKET_PRESSURE_MIN 64
+#endif
+
+#ifndef MBED_CFG_UDP_CLIENT_PACKET_PRESSURE_MAX
+#define MBED_CFG_UDP_CLIENT_PACKET_PRESSURE_MAX 0x80000
+#endif
+
+#ifndef MBED_CFG_UDP_CLIENT_PACKET_PRESSURE_TIMEOUT
+#define MBED_CFG_UDP_CLIENT_PACKET_PRESSURE_TIMEOUT 100
+#endif
+
+#ifndef MBED_CFG_PACKET_PRESSURE_SEED
+#define MBED_CFG_PACKET_PRESSURE_SEED 0x6d626564
+#endif
+
+// Size of the shared buffer, standing in for the heap probing done on targets
+#ifndef MBED_CFG_PACKET_PRESSURE_BUFFER
+#define MBED_CFG_PACKET_PRESSURE_BUFFER 0x1000
+#endif
+
+#ifndef MBED_CFG_PACKET_PRESSURE_OFFLOAD
+#define MBED_CFG_PACKET_PRESSURE_OFFLOAD false
+#endif
+
+#ifndef MBED_CFG_PACKET_PRESSURE_LOSS
+#define MBED_CFG_PACKET_PRESSURE_LOSS 0
+#endif
+
+#ifndef MBED_CFG_TCP_CHURN_CONNECTIONS
+#define MBED_CFG_TCP_CHURN_CONNECTIONS 256
+#endif
+
+#ifndef MBED_CFG_TCP_CHURN_CONCURRENT
+#define MBED_CFG_TCP_CHURN_CONCURRENT 16
+#endif
+
+#ifndef MBED_CFG_PACKET_PRESSURE_DEBUG
+#define MBED_CFG_PACKET_PRESSURE_DEBUG false
+#endif
+
+#define ECHO_PORT   7
+#define CHURN_PORT  9
+#define CHURN_SIZE  64
+#define ECHO_IOV    8
+#define HOST_IP     "10.0.0.2"
+#define NETMASK     "255.255.255.0"
+#define GATEWAY     "10.0.0.1"
+
+
+// Simple xorshift pseudorandom number generator
+typedef struct {
+    uint32_t x;
+    uint32_t y;
+} rand_seq_t;
+
+static void rand_seq_init(rand_seq_t *seq)
+{
+    seq->x = MBED_CFG_PACKET_PRESSURE_SEED;
+    seq->y = MBED_CFG_PACKET_PRESSURE_SEED;
+}
+
+static uint32_t rand_seq_next(rand_seq_t *seq)
+{
+    seq->x ^= seq->x << 15;
+    seq->x ^= seq->x >> 18;
+    seq->x ^= seq->y ^ (seq->y >> 11);
+    return seq->x + seq->y;
+}
+
+static void rand_seq_skip(rand_seq_t *seq, size_t size)
+{
+    for (size_t i = 0; i < size; i++) {
+        rand_seq_next(seq);
+    }
+}
+
+static void rand_seq_buffer(const rand_seq_t *seq, uint8_t *buffer, size_t size)
+{
+    rand_seq_t lookahead = *seq;
+
+    for (size_t i = 0; i < size; i++) {
+        buffer[i] = rand_seq_next(&lookahead) & 0xff;
+    }
+}
+
+static int rand_seq_cmp(const rand_seq_t *seq, const uint8_t *buffer, size_t size)
+{
+    rand_seq_t lookahead = *seq;
+
+    for (size_t i = 0; i < size; i++) {
+        int diff = buffer[i] - (rand_seq_next(&lookahead) & 0xff);
+        if (diff != 0) {
+            return diff;
+        }
+    }
+    return 0;
+}
+
+
+#define CHECK(cond) do {                                                \
+        if (!(cond)) {                                                  \
+            printf("HOST: %s:%d: check failed: %s\r\n",                 \
+                   __FILE__, __LINE__, #cond);                          \
+            exit(EXIT_FAILURE);                                         \
+        }                                                               \
+    } while (0)
+
+static nsapi_stack_t *stack = &lwip_stack;
+static nsapi_addr_t host_addr;
+
+static sys_sem_t echo_ready;
+
+static uint8_t buffer[MBED_CFG_PACKET_PRESSURE_BUFFER];
+
+// Whole TCP stream, lent out a chunk at a time with send_ref
+static uint8_t stream[MBED_CFG_TCP_CLIENT_PACKET_PRESSURE_MAX];
+static bool use_send_ref;
+static int send_ref_pending;
+
+static double clock_seconds(clockid_t clock)
+{
+    struct timespec now;
+    clock_gettime(clock, &now);
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+static uint32_t clock_ms(void)
+{
+    return (uint32_t)(clock_seconds(CLOCK_MONOTONIC) * 1000);
+}
+
+
+// Called by the stack once everything echoed from a buffer is acknowledged
+static void echo_buffer_done(void *context)
+{
+    nsapi_buffer_t *buf = (nsapi_buffer_t *)context;
+    stack->stack_api->buffer_release(stack, buf);
+    free(buf);
+}
+
+static void stream_done(void *context)
+{
+    __atomic_sub_fetch(&send_ref_pending, 1, __ATOMIC_SEQ_CST);
+}
+
+// Describes the segments of a received buffer from offset onwards
+static unsigned echo_segments(const nsapi_buffer_t *buf, nsapi_size_t offset, nsapi_iovec_t *iov)
+{
+    unsigned iovcnt = 0;
+    while (iovcnt < ECHO_IOV && offset < buf->size) {
+        const void *seg;
+        nsapi_size_t len = stack->stack_api->buffer_segment(stack, buf, offset, &seg);
+        CHECK(len > 0);
+        iov[iovcnt].iov_base = (void *)seg;
+        iov[iovcnt].iov_len = len;
+        iovcnt++;
+        offset += len;
+    }
+
+    return iovcnt;
+}
+
+// Sends back whatever the client connected to the echo port sends
+static void *tcp_echo_thread(void *arg)
+{
+    nsapi_socket_t server;
+    CHECK(stack->stack_api->socket_open(stack, &server, NSAPI_TCP) == 0);
+    CHECK(stack->stack_api->socket_bind(stack, server, host_addr, ECHO_PORT) == 0);
+    CHECK(stack->stack_api->socket_listen(stack, server, 1) == 0);
+    sys_sem_signal(&echo_ready);
+
+    while (true) {
+        nsapi_socket_t sock;
+        nsapi_addr_t addr;
+        uint16_t port;
+        int err = stack->stack_api->socket_accept(stack, server, &sock, &addr, &port);
+        if (err == NSAPI_ERROR_WOULD_BLOCK) {
+            continue;
+        }
+        CHECK(err == 0);
+
+        while (true) {
+            nsapi_buffer_t *buf = malloc(sizeof(nsapi_buffer_t));
+            CHECK(buf);
+            int rd = stack->stack_api->socket_recv_buffer(stack, sock, buf, sizeof(buffer));
+            if (rd <= 0) {
+                free(buf);
+            }
+            if (rd == NSAPI_ERROR_WOULD_BLOCK) {
+                continue;
+            } else if (rd <= 0) {
+                break;
+            }
+
+            for (int sent = 0; sent < rd;) {
+                nsapi_iovec_t iov[ECHO_IOV];
+                unsigned iovcnt = echo_segments(buf, sent, iov);
+
+                // Lent segments go one at a time, copies are gathered
+                int td = use_send_ref
+                    ? stack->stack_api->socket_send_ref(stack, sock, iov[0].iov_base, iov[0].iov_len, NULL, NULL)
+                    : stack->stack_api->socket_sendmsg(stack, sock, NULL, 0, iov, iovcnt);
+                if (td > 0) {
+                    sent += td;
+                } else if (td == NSAPI_ERROR_WOULD_BLOCK) {
+                    usleep(1000);
+                } else {
+                    break;
+                }
+            }
+
+            // An empty send_ref hands the buffer back once all of it is
+            // acknowledged
+            int err = 0;
+            if (use_send_ref) {
+                while ((err = stack->stack_api->socket_send_ref(stack, sock, NULL, 0,
+                        echo_buffer_done, buf)) == NSAPI_ERROR_WOULD_BLOCK) {
+                    usleep(1000);
+                }
+            }
+            if (!use_send_ref || err < 0) {
+                echo_buffer_done(buf);
+            }
+        }
+
+        stack->stack_api->socket_close(stack, sock);
+    }
+
+    return NULL;
+}
+
+static void *udp_echo_thread(void *arg)
+{
+    nsapi_socket_t sock;
+    CHECK(stack->stack_api->socket_open(stack, &sock, NSAPI_UDP) == 0);
+    CHECK(stack->stack_api->socket_bind(stack, sock, host_addr, ECHO_PORT) == 0);
+    sys_sem_signal(&echo_ready);
+
+    while (true) {
+        nsapi_addr_t addr;
+        uint16_t port;
+        int pending;
+        unsigned optlen = sizeof(pending);
+        CHECK(stack->stack_api->getsockopt(stack, sock, NSAPI_SOCKET, NSAPI_RCVPENDING, &pending, &optlen) == 0);
+        if (!pending) {
+            continue;
+        }
+
+        nsapi_buffer_t buf;
+        int rd = stack->stack_api->socket_recvfrom_buffer(stack, sock, &addr, &port, &buf);
+        CHECK(rd == pending);
+
+        // A chained datagram is gathered back into one
+        nsapi_iovec_t iov[ECHO_IOV];
+        unsigned iovcnt = echo_segments(&buf, 0, iov);
+        nsapi_size_t len = 0;
+        for (unsigned i = 0; i < iovcnt; i++) {
+            len += iov[i].iov_len;
+        }
+        CHECK(len == (nsapi_size_t)rd);
+        stack->stack_api->socket_sendmsg(stack, sock, &addr, port, iov, iovcnt);
+        stack->stack_api->buffer_release(stack, &buf);
+    }
+
+    return NULL;
+}
+
+
+typedef struct {
+    const char *name;
+    size_t bytes;
+    double wall;
+    double cpu;
+    uint32_t frames;
+} bench_result_t;
+
+static void bench_start(bench_result_t *result, const char *name)
+{
+    result->name = name;
+    result->bytes = 0;
+    result->wall = clock_seconds(CLOCK_MONOTONIC);
+    result->cpu = clock_seconds(CLOCK_PROCESS_CPUTIME_ID);
+    loopback_emac_reset_stats(loopback_emac_get(0));
+}
+
+static void bench_stop(bench_result_t *result)
+{
+    loopback_emac_stats_t stats;
+    loopback_emac_get_stats(loopback_emac_get(0), &stats);
+
+    result->wall = clock_seconds(CLOCK_MONOTONIC) - result->wall;
+    result->cpu = clock_seconds(CLOCK_PROCESS_CPUTIME_ID) - result->cpu;
+    result->frames = stats.tx_frames + stats.rx_frames;
+
+    printf("HOST: %s: %zu bytes in %.3fs, %.3f Mbit/s, %.0f packets/s, %.2f us CPU/packet\r\n",
+           result->name, result->bytes, result->wall,
+           8 * result->bytes / (1e6 * result->wall),
+           result->frames / result->wall,
+           result->frames ? 1e6 * result->cpu / result->frames : 0.0);
+    if (stats.tx_lost) {
+        printf("HOST: %s: %u frames lost\r\n", result->name, (unsigned)stats.tx_lost);
+    }
+}
+
+
+// Same sequence as TESTS/mbedmicro-net/tcp_packet_pressure
+static void tcp_packet_pressure(bench_result_t *result, const char *name)
+{
+    bench_start(result, name);
+
+    // Tests exponentially growing sequences
+    for (size_t size = MBED_CFG_TCP_CLIENT_PACKET_PRESSURE_MIN;
+         size < MBED_CFG_TCP_CLIENT_PACKET_PRESSURE_MAX;
+         size *= 2) {
+        nsapi_socket_t sock;
+        CHECK(stack->stack_api->socket_open(stack, &sock, NSAPI_TCP) == 0);
+        CHECK(stack->stack_api->socket_connect(stack, sock, host_addr, ECHO_PORT) == 0);
+        if (MBED_CFG_PACKET_PRESSURE_DEBUG) {
+            printf("TCP: streaming %zu bytes\r\n", size);
+        }
+
+        // Loop to send/recv all data
+        rand_seq_t tx_seq;
+        rand_seq_t rx_seq;
+        rand_seq_init(&tx_seq);
+        rand_seq_init(&rx_seq);
+        size_t rx_count = 0;
+        size_t tx_count = 0;
+        size_t window = sizeof(buffer);
+
+        if (use_send_ref) {
+            rand_seq_buffer(&tx_seq, stream, size);
+        }
+
+        while (tx_count < size || rx_count < size) {
+            // Send out data
+            if (tx_count < size) {
+                size_t chunk_size = size - tx_count;
+                if (chunk_size > window) {
+                    chunk_size = window;
+                }
+
+                int td;
+                if (use_send_ref) {
+                    __atomic_add_fetch(&send_ref_pending, 1, __ATOMIC_SEQ_CST);
+                    td = stack->stack_api->socket_send_ref(stack, sock, stream + tx_count, chunk_size,
+                            stream_done, NULL);
+                    if (td <= 0) {
+                        __atomic_sub_fetch(&send_ref_pending, 1, __ATOMIC_SEQ_CST);
+                    }
+                } else {
+                    rand_seq_buffer(&tx_seq, buffer, chunk_size);
+                    td = stack->stack_api->socket_send(stack, sock, buffer, chunk_size);
+                }
+
+                if (td > 0) {
+                    rand_seq_skip(&tx_seq, td);
+                    tx_count += td;
+                } else if (td != NSAPI_ERROR_WOULD_BLOCK) {
+                    // We may fail to send because of buffering issues,
+                    // cut buffer in half
+                    if (window > MBED_CFG_TCP_CLIENT_PACKET_PRESSURE_MIN) {
+                        window /= 2;
+                    }
+                }
+            }
+
+            // Verify recieved data
+            while (rx_count < size) {
+                int rd = stack->stack_api->socket_recv(stack, sock, buffer, sizeof(buffer));
+                CHECK(rd > 0 || rd == NSAPI_ERROR_WOULD_BLOCK);
+                if (rd > 0) {
+                    CHECK(rand_seq_cmp(&rx_seq, buffer, rd) == 0);
+                    rand_seq_skip(&rx_seq, rd);
+                    rx_count += rd;
+                } else if (rd == NSAPI_ERROR_WOULD_BLOCK) {
+                    break;
+                }
+            }
+        }
+
+        // Closing with data still lent would abort the connection
+        while (__atomic_load_n(&send_ref_pending, __ATOMIC_SEQ_CST)) {
+            usleep(1000);
+        }
+
+        CHECK(stack->stack_api->socket_close(stack, sock) == 0);
+        result->bytes += size;
+    }
+
+    bench_stop(result);
+}
+
+// Same sequence as TESTS/mbedmicro-net/udp_packet_pressure
+static void udp_packet_pressure(bench_result_t *result)
+{
+    bench_start(result, "UDP packet pressure");
+
+    // Tests exponentially growing sequences
+    for (size_t size = MBED_CFG_UDP_CLIENT_PACKET_PRESSURE_MIN;
+         size < MBED_CFG_UDP_CLIENT_PACKET_PRESSURE_MAX;
+         size *= 2) {
+        nsapi_socket_t sock;
+        CHECK(stack->stack_api->socket_open(stack, &sock, NSAPI_UDP) == 0);
+        if (MBED_CFG_PACKET_PRESSURE_DEBUG) {
+            printf("UDP: streaming %zu bytes\r\n", size);
+        }
+
+        // Loop to send/recv all data
+        rand_seq_t tx_seq;
+        rand_seq_t rx_seq;
+        rand_seq_init(&tx_seq);
+        rand_seq_init(&rx_seq);
+        size_t rx_count = 0;
+        size_t tx_count = 0;
+        uint32_t known_time = clock_ms();
+        size_t window = sizeof(buffer);
+
+        while (tx_count < size || rx_count < size) {
+            // Send out packets
+            if (tx_count < size) {
+                size_t chunk_size = size - tx_count;
+                if (chunk_size > window) {
+                    chunk_size = window;
+                }
+
+                rand_seq_buffer(&tx_seq, buffer, chunk_size);
+                int td = stack->stack_api->socket_sendto(stack, sock, host_addr, ECHO_PORT, buffer, chunk_size);
+
+                if (td > 0) {
+                    rand_seq_skip(&tx_seq, td);
+                    tx_count += td;
+                } else if (td != NSAPI_ERROR_WOULD_BLOCK) {
+                    // We may fail to send because of buffering issues, revert to
+                    // last good sequence and cut buffer in half
+                    if (window > MBED_CFG_UDP_CLIENT_PACKET_PRESSURE_MIN) {
+                        window /= 2;
+                    }
+                }
+            }
+
+            // Prioritize recieving over sending packets to avoid flooding
+            // the network while handling erronous packets
+            while (rx_count < size) {
+                nsapi_addr_t addr;
+                uint16_t port;
+                // Scattered over two vectors that happen to be adjacent
+                nsapi_iovec_t iov[2] = {
+                    {buffer, MBED_CFG_UDP_CLIENT_PACKET_PRESSURE_MIN},
+                    {buffer + MBED_CFG_UDP_CLIENT_PACKET_PRESSURE_MIN,
+                     sizeof(buffer) - MBED_CFG_UDP_CLIENT_PACKET_PRESSURE_MIN},
+                };
+                int rd = stack->stack_api->socket_recvmsg(stack, sock, &addr, &port, iov, 2);
+                CHECK(rd > 0 || rd == NSAPI_ERROR_WOULD_BLOCK);
+
+                if (rd > 0) {
+                    if (rand_seq_cmp(&rx_seq, buffer, rd) == 0) {
+                        rand_seq_skip(&rx_seq, rd);
+                        rx_count += rd;
+                        known_time = clock_ms();
+                        if (window < sizeof(buffer)) {
+                            window += MBED_CFG_UDP_CLIENT_PACKET_PRESSURE_MIN;
+                        }
+                    }
+                } else if (clock_ms() - known_time >
+                        MBED_CFG_UDP_CLIENT_PACKET_PRESSURE_TIMEOUT) {
+                    // Dropped packet or out of order, revert to last good sequence
+                    // and cut buffer in half
+                    tx_seq = rx_seq;
+                    tx_count = rx_count;
+                    known_time = clock_ms();
+                    if (window > MBED_CFG_UDP_CLIENT_PACKET_PRESSURE_MIN) {
+                        window /= 2;
+                    }
+
+                    if (MBED_CFG_PACKET_PRESSURE_DEBUG) {
+                        printf("UDP: Dropped, window = %zu\r\n", window);
+                    }
+                } else if (rd == NSAPI_ERROR_WOULD_BLOCK) {
+                    break;
+                }
+            }
+        }
+
+        CHECK(stack->stack_api->socket_close(stack, sock) == 0);
+        result->bytes += size;
+    }
+
+    bench_stop(result);
+}
+
+
+static void tcp_churn_exchange(nsapi_socket_t tx, nsapi_socket_t rx, rand_seq_t *seq)
+{
+    uint8_t data[CHURN_SIZE];
+    rand_seq_buffer(seq, data, sizeof(data));
+    // Segments still waiting on a delayed ack can use up the stack's pool
+    int td;
+    while ((td = stack->stack_api->socket_send(stack, tx, data, sizeof(data)))
+            == NSAPI_ERROR_WOULD_BLOCK) {
+        usleep(1000);
+    }
+    CHECK(td == sizeof(data));
+
+    for (size_t count = 0; count < sizeof(data);) {
+        int rd = stack->stack_api->socket_recv(stack, rx, buffer + count, sizeof(data) - count);
+        CHECK(rd > 0 || rd == NSAPI_ERROR_WOULD_BLOCK);
+        if (rd > 0) {
+            count += rd;
+        }
+    }
+
+    CHECK(memcmp(buffer, data, sizeof(data)) == 0);
+    rand_seq_skip(seq, sizeof(data));
+}
+
+// Short-lived connections, closed by the client so that each one leaves a
+// pcb in TIME_WAIT for the stack to reclaim
+static void tcp_churn(bench_result_t *result)
+{
+    bench_start(result, "TCP connection churn");
+
+    rand_seq_t seq;
+    rand_seq_init(&seq);
+
+    for (int i = 0; i < MBED_CFG_TCP_CHURN_CONNECTIONS; i++) {
+        nsapi_socket_t sock;
+        CHECK(stack->stack_api->socket_open(stack, &sock, NSAPI_TCP) == 0);
+        CHECK(stack->stack_api->socket_connect(stack, sock, host_addr, ECHO_PORT) == 0);
+        tcp_churn_exchange(sock, sock, &seq);
+        CHECK(stack->stack_api->socket_close(stack, sock) == 0);
+        result->bytes += 2 * CHURN_SIZE;
+    }
+
+    bench_stop(result);
+    printf("HOST: %s: %d connections, %.0f connections/s\r\n",
+           result->name, MBED_CFG_TCP_CHURN_CONNECTIONS,
+           MBED_CFG_TCP_CHURN_CONNECTIONS / result->wall);
+
+#if MBED_CONF_LWIP_SOCKET_GROW
+    // Both ends of every connection stay open at once, well past socket-max
+    nsapi_socket_t server;
+    nsapi_socket_t clients[MBED_CFG_TCP_CHURN_CONCURRENT];
+    nsapi_socket_t accepted[MBED_CFG_TCP_CHURN_CONCURRENT];
+    CHECK(stack->stack_api->socket_open(stack, &server, NSAPI_TCP) == 0);
+    CHECK(stack->stack_api->socket_bind(stack, server, host_addr, CHURN_PORT) == 0);
+    CHECK(stack->stack_api->socket_listen(stack, server, MBED_CFG_TCP_CHURN_CONCURRENT) == 0);
+
+    // Accepted as they come, the accept mailbox only holds lwip.mbox-size
+    for (int i = 0; i < MBED_CFG_TCP_CHURN_CONCURRENT; i++) {
+        nsapi_addr_t addr;
+        uint16_t port;
+        int err;
+        CHECK(stack->stack_api->socket_open(stack, &clients[i], NSAPI_TCP) == 0);
+        CHECK(stack->stack_api->socket_connect(stack, clients[i], host_addr, CHURN_PORT) == 0);
+        while ((err = stack->stack_api->socket_accept(stack, server, &accepted[i], &addr, &port))
+                == NSAPI_ERROR_WOULD_BLOCK);
+        CHECK(err == 0);
+    }
+
+    for (int i = 0; i < MBED_CFG_TCP_CHURN_CONCURRENT; i++) {
+        tcp_churn_exchange(clients[i], accepted[i], &seq);
+        tcp_churn_exchange(accepted[i], clients[i], &seq);
+    }
+
+    for (int i = 0; i < MBED_CFG_TCP_CHURN_CONCURRENT; i++) {
+        CHECK(stack->stack_api->socket_close(stack, clients[i]) == 0);
+        CHECK(stack->stack_api->socket_close(stack, accepted[i]) == 0);
+    }
+    CHECK(stack->stack_api->socket_close(stack, server) == 0);
+    printf("HOST: %s: %d connections open at once\r\n",
+           result->name, MBED_CFG_TCP_CHURN_CONCURRENT);
+#endif
+}
+
+static void print_pool_stats(const char *name, const mbed_lwip_pool_stats_t *pool)
+{
+    printf("HOST: %-16s used %4u  max %4u  avail %4u  err %4u\r\n",
+           name, (unsigned)pool->used, (unsigned)pool->max,
+           (unsigned)pool->avail, (unsigned)pool->err);
+}
+
+static void print_proto_stats(const char *name, const mbed_lwip_proto_stats_t *proto)
+{
+    printf("HOST: %-16s xmit %8u  recv %8u  drop %4u  chkerr %4u  err %4u\r\n",
+           name, (unsigned)proto->xmit, (unsigned)proto->recv,
+           (unsigned)proto->drop, (unsigned)proto->chkerr, (unsigned)proto->err);
+}
+
+static void print_stats(void)
+{
+    mbed_lwip_stats_t stats;
+    unsigned optlen = sizeof(stats);
+    CHECK(stack->stack_api->getstackopt(stack, MBED_LWIP_LEVEL, MBED_LWIP_STATS, &stats, &optlen) == 0);
+
+    print_pool_stats("sockets", &stats.sockets);
+    print_pool_stats("netconns", &stats.netconns);
+    print_pool_stats("tcp pcbs", &stats.tcp_pcbs);
+    print_pool_stats("tcp listen pcbs", &stats.tcp_listen_pcbs);
+    print_pool_stats("udp pcbs", &stats.udp_pcbs);
+    print_pool_stats("tcp segs", &stats.tcp_segs);
+    print_pool_stats("pbufs", &stats.pbufs);
+    print_pool_stats("heap", &stats.heap);
+    print_proto_stats("link", &stats.link);
+    print_proto_stats("ip", &stats.ip);
+    print_proto_stats("tcp", &stats.tcp);
+    print_proto_stats("udp", &stats.udp);
+    printf("HOST: %-16s %u\r\n", "tcp time_wait", (unsigned)stats.tcp_time_wait);
+}
+
+// The far end of the link hands every frame straight back
+static void reflect_input(void *data, emac_stack_mem_chain_t *chain)
+{
+    emac_interface_t *emac = (emac_interface_t *)data;
+    emac_stack_mem_t *buf = emac_stack_mem_chain_dequeue(NULL, &chain);
+
+    emac->ops.link_out(emac, buf);
+    emac_stack_mem_free(NULL, buf);
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc > 1) {
+        FILE *capture = fopen(argv[1], "wb");
+        CHECK(capture);
+        loopback_emac_capture(capture);
+    }
+
+    emac_interface_t *reflector = loopback_emac_get(1);
+    reflector->ops.set_link_input_cb(reflector, reflect_input, reflector);
+    CHECK(reflector->ops.power_up(reflector));
+
+    if (MBED_CFG_PACKET_PRESSURE_OFFLOAD) {
+        loopback_emac_set_offload(loopback_emac_get(0),
+                EMAC_OFFLOAD_TX_IP_CHECKSUM | EMAC_OFFLOAD_TX_L4_CHECKSUM |
+                EMAC_OFFLOAD_RX_IP_CHECKSUM | EMAC_OFFLOAD_RX_L4_CHECKSUM);
+    }
+
+    CHECK(mbed_lwip_init(loopback_emac_get(0)) == 0);
+    CHECK(mbed_lwip_bringup(false, HOST_IP, NETMASK, GATEWAY) == 0);
+    host_addr.version = NSAPI_IPv4;
+    sscanf(HOST_IP, "%hhu.%hhu.%hhu.%hhu", &host_addr.bytes[0], &host_addr.bytes[1],
+           &host_addr.bytes[2], &host_addr.bytes[3]);
+    sys_sem_new(&echo_ready, 0);
+    printf("HOST: lwIP up at %s\r\n", HOST_IP);
+
+    pthread_t tcp_echo;
+    pthread_t udp_echo;
+    CHECK(pthread_create(&tcp_echo, NULL, tcp_echo_thread, NULL) == 0);
+    CHECK(pthread_create(&udp_echo, NULL, udp_echo_thread, NULL) == 0);
+    sys_arch_sem_wait(&echo_ready, 0);
+    sys_arch_sem_wait(&echo_ready, 0);
+
+    bench_result_t tcp;
+    bench_result_t tcp_ref;
+    bench_result_t udp;
+    bench_result_t churn;
+    loopback_emac_set_loss(loopback_emac_get(0), MBED_CFG_PACKET_PRESSURE_LOSS,
+            MBED_CFG_PACKET_PRESSURE_SEED);
+    tcp_packet_pressure(&tcp, "TCP packet pressure");
+    use_send_ref = true;
+    tcp_packet_pressure(&tcp_ref, "TCP packet pressure (send_ref)");
+    use_send_ref = false;
+    udp_packet_pressure(&udp);
+    // Lost handshakes would leave churn timing retransmission timers
+    loopback_emac_set_loss(loopback_emac_get(0), 0, 0);
+    tcp_churn(&churn);
+    print_stats();
+
+    loopback_emac_capture(NULL);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,48 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Host build configuration, standing in for the mbed_config.h that the
+ * mbed tools generate from mbed_lib.json. Values match the lwip defaults,
+ * except for socket counts: the echo server may still be closing one
+ * connection while the client opens the next. */
+#ifndef __MBED_CONFIG_DATA__
+#define __MBED_CONFIG_DATA__
+
+#define MBED_CONF_LWIP_IPV4_ENABLED                 1
+#define MBED_CONF_LWIP_IPV6_ENABLED                 0
+#define MBED_CONF_LWIP_IP_VER_PREF                  4
+#define MBED_CONF_LWIP_ADDR_TIMEOUT                 5
+#define MBED_CONF_LWIP_ETHERNET_ENABLED             1
+#define MBED_CONF_LWIP_DEBUG_ENABLED                0
+#define NSAPI_PPP_AVAILABLE                         0
+#define MBED_CONF_LWIP_USE_MBED_TRACE               0
+#define MBED_CONF_LWIP_ENABLE_PPP_TRACE             0
+#define MBED_CONF_LWIP_SOCKET_MAX                   8
+#define MBED_CONF_LWIP_TCP_ENABLED                  1
+#define MBED_CONF_LWIP_TCP_SERVER_MAX               4
+#define MBED_CONF_LWIP_TCP_SOCKET_MAX               8
+#define MBED_CONF_LWIP_TCP_SEND_REF_MAX             4
+#define MBED_CONF_LWIP_UDP_SOCKET_MAX               4
+#define MBED_CONF_LWIP_TCPIP_THREAD_STACKSIZE       1200
+#define MBED_CONF_LWIP_DEFAULT_THREAD_STACKSIZE     512
+#define MBED_CONF_LWIP_PPP_THREAD_STACKSIZE         512
+
+/* TCP sizing is left to the defaults of the profile in lwipopts.h, same
+ * as the null values in mbed_lib.json. MBED_CONF_LWIP_THROUGHPUT_PROFILE,
+ * MBED_CONF_LWIP_TCP_MSS, MBED_CONF_LWIP_TCP_WND and
+ * MBED_CONF_LWIP_TCP_SND_BUF can be set from the make command line. */
+
+#endif
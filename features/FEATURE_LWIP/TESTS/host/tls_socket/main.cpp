@@ -0,0 +1,578 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#if !defined(TARGET_LIKE_POSIX)
+    #error [NOT_SUPPORTED] Host test, build with the Makefile in this directory
+#endif
+
+/* Host test of TLSSocket and DTLSSocket
+ *
+ * A TLS echo server and a DTLS echo server run on the stack itself, on one
+ * end of a loopback EMAC pair whose far end reflects every frame back. Both
+ * present the mbed TLS test ECDSA certificate for "localhost".
+ *
+ * How the TLS server resumes sessions, by session ID, by ticket or not at
+ * all, is switched between tests, and the handshake statistics tell full
+ * handshakes and resumed ones apart.
+ *
+ * Built with TLS_SOCKET_BUFFER_ALLOC, mbed TLS allocates from the heap of
+ * memory_buffer_alloc, which is checked once the tests are done.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "lwip_stack.h"
+#include "loopback_emac.h"
+#include "TCPServer.h"
+#include "TLSSocket.h"
+#include "DTLSSocket.h"
+#include "nsapi_tls.h"
+#include "cmsis_os2.h"
+#include "rtos/Semaphore.h"
+
+#include "mbedtls/certs.h"
+#include "mbedtls/ssl_cache.h"
+#include "mbedtls/ssl_ticket.h"
+#include "mbedtls/ssl_cookie.h"
+#if defined(TLS_SOCKET_BUFFER_ALLOC)
+#include "mbedtls/memory_buffer_alloc.h"
+#endif
+
+#define HOST_IP     "10.0.0.2"
+#define NETMASK     "255.255.255.0"
+#define GATEWAY     "10.0.0.1"
+
+#define TLS_PORT    4433
+#define DTLS_PORT   4434
+#define SERVER_NAME "localhost"
+
+#define ECHO_SIZE   256
+
+// Holds the record buffers of the three connections and the certificates
+#define HEAP_SIZE   (512*1024)
+
+// The ECDSA test certificates, the RSA ones are signed with SHA-1
+#define CA_PEM      mbedtls_test_ca_crt_ec, strlen(mbedtls_test_ca_crt_ec) + 1
+
+// Trusted instead of the CA, the servers' own certificate does not vouch for
+// itself as it is not self-signed
+#define OTHER_CA_PEM mbedtls_test_srv_crt_ec, strlen(mbedtls_test_srv_crt_ec) + 1
+
+
+#define CHECK(cond) do {                                                \
+        if (!(cond)) {                                                  \
+            printf("HOST: %s:%d: check failed: %s\r\n",                 \
+                   __FILE__, __LINE__, #cond);                          \
+            exit(EXIT_FAILURE);                                         \
+        }                                                               \
+    } while (0)
+
+
+// Entropy for mbed TLS, as a TRNG would give it on a target
+extern "C" int mbedtls_hardware_poll(void *data, unsigned char *output, size_t len, size_t *olen)
+{
+    static int fd = -1;
+    if (fd < 0) {
+        fd = open("/dev/urandom", O_RDONLY);
+    }
+
+    ssize_t ret = fd < 0 ? -1 : read(fd, output, len);
+    *olen = ret < 0 ? 0 : ret;
+    return ret < 0 ? -1 : 0;
+}
+
+
+// Servers
+static NetworkStack *stack;
+
+static mbedtls_x509_crt srv_crt;
+static mbedtls_pk_context srv_key;
+static mbedtls_ssl_cache_context srv_cache;
+static mbedtls_ssl_ticket_context srv_ticket;
+static mbedtls_ssl_cookie_ctx srv_cookie;
+static mbedtls_ssl_config tls_conf;
+static mbedtls_ssl_config dtls_conf;
+
+// ms the TLS server waits before each handshake
+static volatile unsigned server_delay;
+
+enum resumption {
+    RESUME_NONE,
+    RESUME_SESSION_ID,
+    RESUME_TICKET,
+};
+
+// Only changed while no handshake is running
+static void server_resumption(resumption mode)
+{
+    mbedtls_ssl_cache_free(&srv_cache);
+    mbedtls_ssl_cache_init(&srv_cache);
+
+    if (mode == RESUME_SESSION_ID) {
+        mbedtls_ssl_conf_session_cache(&tls_conf, &srv_cache,
+                mbedtls_ssl_cache_get, mbedtls_ssl_cache_set);
+    } else {
+        mbedtls_ssl_conf_session_cache(&tls_conf, NULL, NULL, NULL);
+    }
+
+    if (mode == RESUME_TICKET) {
+        mbedtls_ssl_conf_session_tickets_cb(&tls_conf,
+                mbedtls_ssl_ticket_write, mbedtls_ssl_ticket_parse, &srv_ticket);
+    } else {
+        mbedtls_ssl_conf_session_tickets_cb(&tls_conf, NULL, NULL, NULL);
+    }
+}
+
+static void server_config(mbedtls_ssl_config *conf, int transport)
+{
+    mbedtls_ssl_config_init(conf);
+    CHECK(mbedtls_ssl_config_defaults(conf, MBEDTLS_SSL_IS_SERVER,
+            transport, MBEDTLS_SSL_PRESET_DEFAULT) == 0);
+    mbedtls_ssl_conf_rng(conf, nsapi_tls_rng, NULL);
+    CHECK(mbedtls_ssl_conf_own_cert(conf, &srv_crt, &srv_key) == 0);
+}
+
+static int tcp_send(void *ctx, const unsigned char *buf, size_t len)
+{
+    return static_cast<TCPSocket *>(ctx)->send(buf, len);
+}
+
+static int tcp_recv(void *ctx, unsigned char *buf, size_t len)
+{
+    return static_cast<TCPSocket *>(ctx)->recv(buf, len);
+}
+
+static void echo(mbedtls_ssl_context *ssl)
+{
+    unsigned char buffer[ECHO_SIZE];
+    while (true) {
+        int ret = mbedtls_ssl_read(ssl, buffer, sizeof buffer);
+        if (ret <= 0) {
+            break;
+        }
+
+        CHECK(mbedtls_ssl_write(ssl, buffer, ret) == ret);
+    }
+
+    mbedtls_ssl_close_notify(ssl);
+}
+
+static void *tls_server_thread(void *)
+{
+    TCPServer server;
+    CHECK(server.open(stack) == 0);
+    CHECK(server.bind(TLS_PORT) == 0);
+    CHECK(server.listen(2) == 0);
+
+    mbedtls_ssl_context ssl;
+    mbedtls_ssl_init(&ssl);
+    CHECK(mbedtls_ssl_setup(&ssl, &tls_conf) == 0);
+
+    while (true) {
+        TCPSocket conn;
+        CHECK(server.accept(&conn) == 0);
+
+        // The server's flights are several small writes as well
+        int nodelay = 1;
+        CHECK(conn.setsockopt(NSAPI_SOCKET, NSAPI_TCP_NODELAY, &nodelay, sizeof nodelay) == 0);
+
+        CHECK(mbedtls_ssl_session_reset(&ssl) == 0);
+        mbedtls_ssl_set_bio(&ssl, &conn, tcp_send, tcp_recv, NULL);
+        usleep(server_delay * 1000);
+        if (mbedtls_ssl_handshake(&ssl) == 0) {
+            echo(&ssl);
+        }
+
+        conn.close();
+    }
+
+    return NULL;
+}
+
+struct dtls_server {
+    UDPSocket sock;
+    SocketAddress peer;
+    uint64_t timer_start;
+    uint32_t timer_int;
+    uint32_t timer_fin;
+};
+
+static int udp_send(void *ctx, const unsigned char *buf, size_t len)
+{
+    dtls_server *server = static_cast<dtls_server *>(ctx);
+    return server->sock.sendto(server->peer, buf, len);
+}
+
+static int udp_recv(void *ctx, unsigned char *buf, size_t len, uint32_t timeout)
+{
+    dtls_server *server = static_cast<dtls_server *>(ctx);
+    server->sock.set_timeout(timeout ? (int)timeout : -1);
+
+    nsapi_size_or_error_t ret = server->sock.recvfrom(&server->peer, buf, len);
+    return ret == NSAPI_ERROR_WOULD_BLOCK ? MBEDTLS_ERR_SSL_TIMEOUT : ret;
+}
+
+static void udp_set_timer(void *ctx, uint32_t int_ms, uint32_t fin_ms)
+{
+    dtls_server *server = static_cast<dtls_server *>(ctx);
+    server->timer_start = osKernelGetTickCount();
+    server->timer_int = int_ms;
+    server->timer_fin = fin_ms;
+}
+
+static int udp_get_timer(void *ctx)
+{
+    dtls_server *server = static_cast<dtls_server *>(ctx);
+    if (!server->timer_fin) {
+        return -1;
+    }
+
+    uint64_t elapsed = osKernelGetTickCount() - server->timer_start;
+    return elapsed >= server->timer_fin ? 2 : elapsed >= server->timer_int ? 1 : 0;
+}
+
+static void *dtls_server_thread(void *)
+{
+    static dtls_server server;
+    CHECK(server.sock.open(stack) == 0);
+    CHECK(server.sock.bind(DTLS_PORT) == 0);
+
+    mbedtls_ssl_context ssl;
+    mbedtls_ssl_init(&ssl);
+    CHECK(mbedtls_ssl_setup(&ssl, &dtls_conf) == 0);
+    mbedtls_ssl_set_bio(&ssl, &server, udp_send, NULL, udp_recv);
+    mbedtls_ssl_set_timer_cb(&ssl, &server, udp_set_timer, udp_get_timer);
+
+    // Cookies are bound to the client's IP address, there is only the one
+    SocketAddress client(HOST_IP);
+    const void *client_id = client.get_ip_bytes();
+
+    while (true) {
+        CHECK(mbedtls_ssl_session_reset(&ssl) == 0);
+        CHECK(mbedtls_ssl_set_client_transport_id(&ssl,
+                (const unsigned char *)client_id, NSAPI_IPv4_BYTES) == 0);
+
+        // A client that has to prove its address starts over
+        if (mbedtls_ssl_handshake(&ssl) == 0) {
+            echo(&ssl);
+        }
+    }
+
+    return NULL;
+}
+
+
+// Tests
+static SocketAddress tls_server(HOST_IP, TLS_PORT);
+static SocketAddress dtls_server_address(HOST_IP, DTLS_PORT);
+
+static void exchange(TLSSocket *sock)
+{
+    unsigned char out[ECHO_SIZE];
+    unsigned char in[ECHO_SIZE];
+    for (unsigned i = 0; i < sizeof out; i++) {
+        out[i] = rand();
+    }
+
+    CHECK(sock->send(out, sizeof out) == (nsapi_size_or_error_t)sizeof out);
+
+    nsapi_size_t received = 0;
+    while (received < sizeof in) {
+        nsapi_size_or_error_t ret = sock->recv(in + received, sizeof in - received);
+        CHECK(ret > 0);
+        received += ret;
+    }
+
+    CHECK(memcmp(out, in, sizeof out) == 0);
+}
+
+// Connects, checks the echo, and reports whether the session was resumed
+static bool tls_round(TLSSocket *sock, const SocketAddress &address)
+{
+    CHECK(sock->open(stack) == 0);
+    CHECK(sock->set_root_ca_cert(CA_PEM) == 0);
+    CHECK(sock->connect(address, SERVER_NAME) == 0);
+    CHECK(sock->connect(address, SERVER_NAME) == NSAPI_ERROR_IS_CONNECTED);
+    exchange(sock);
+
+    bool resumed = sock->is_resumed();
+    CHECK(sock->close() == 0);
+    return resumed;
+}
+
+static void check_stats(uint32_t full, uint32_t resumed, uint32_t failed)
+{
+    nsapi_tls_stats_t stats;
+    nsapi_tls_get_stats(&stats, true);
+
+    printf("HOST:   %lu full (%lu ms), %lu resumed (%lu ms), %lu failed, longest %lu ms\r\n",
+           (unsigned long)stats.full, (unsigned long)stats.full_time,
+           (unsigned long)stats.resumed, (unsigned long)stats.resumed_time,
+           (unsigned long)stats.failed, (unsigned long)stats.max_time);
+    CHECK(stats.full == full);
+    CHECK(stats.resumed == resumed);
+    CHECK(stats.failed == failed);
+}
+
+static void test_session_id()
+{
+    server_resumption(RESUME_SESSION_ID);
+    nsapi_tls_session_remove(NULL);
+
+    TLSSocket sock;
+    CHECK(!tls_round(&sock, tls_server));
+    CHECK(tls_round(&sock, tls_server));
+    CHECK(tls_round(&sock, tls_server));
+    check_stats(1, 2, 0);
+    printf("HOST: session ID resumption ok\r\n");
+}
+
+static void test_ticket()
+{
+    server_resumption(RESUME_TICKET);
+    nsapi_tls_session_remove(NULL);
+
+    TLSSocket sock;
+    CHECK(!tls_round(&sock, tls_server));
+    CHECK(tls_round(&sock, tls_server));
+    check_stats(1, 1, 0);
+    printf("HOST: ticket resumption ok\r\n");
+}
+
+static void test_server_forgets()
+{
+    // The ticket cached by the previous test is turned down
+    server_resumption(RESUME_NONE);
+
+    TLSSocket sock;
+    CHECK(!tls_round(&sock, tls_server));
+    CHECK(!tls_round(&sock, tls_server));
+    check_stats(2, 0, 0);
+    printf("HOST: fallback to full handshake ok\r\n");
+}
+
+static void test_wrong_name()
+{
+    server_resumption(RESUME_SESSION_ID);
+    nsapi_tls_session_remove(NULL);
+
+    TLSSocket sock;
+    CHECK(sock.open(stack) == 0);
+    CHECK(sock.set_root_ca_cert(CA_PEM) == 0);
+    CHECK(sock.connect(tls_server, "wrong.test") == NSAPI_ERROR_AUTH_FAILURE);
+    CHECK(sock.close() == 0);
+
+    // Nor is anything cached for the server under its right name
+    CHECK(!tls_round(&sock, tls_server));
+    check_stats(1, 0, 1);
+    printf("HOST: certificate name check ok\r\n");
+}
+
+static void test_other_config()
+{
+    server_resumption(RESUME_SESSION_ID);
+    nsapi_tls_session_remove(NULL);
+
+    // A socket that does not check the server establishes a session
+    TLSSocket unverified;
+    CHECK(unverified.open(stack) == 0);
+    mbedtls_ssl_conf_authmode(unverified.get_ssl_config(), MBEDTLS_SSL_VERIFY_NONE);
+    CHECK(unverified.connect(tls_server, SERVER_NAME) == 0);
+    CHECK(!unverified.is_resumed());
+    exchange(&unverified);
+    CHECK(unverified.close() == 0);
+
+    // which one that does has to verify the server itself
+    TLSSocket sock;
+    CHECK(!tls_round(&sock, tls_server));
+
+    // and one that trusts something else fails to, rather than resuming
+    TLSSocket other;
+    CHECK(other.open(stack) == 0);
+    CHECK(other.set_root_ca_cert(OTHER_CA_PEM) == 0);
+    CHECK(other.connect(tls_server, SERVER_NAME) == NSAPI_ERROR_AUTH_FAILURE);
+    CHECK(!other.is_resumed());
+    CHECK(other.close() == 0);
+
+    // Sockets configured alike still share their session
+    CHECK(tls_round(&sock, tls_server));
+    check_stats(2, 1, 1);
+    printf("HOST: sessions kept apart by configuration ok\r\n");
+}
+
+static rtos::Semaphore sigio_sem;
+
+static void sigio()
+{
+    sigio_sem.release();
+}
+
+static bool nonblocking_round(TLSSocket *sock)
+{
+    CHECK(sock->open(stack) == 0);
+    CHECK(sock->set_root_ca_cert(CA_PEM) == 0);
+    sock->set_blocking(false);
+    sock->sigio(sigio);
+
+    unsigned calls = 0;
+    nsapi_error_t ret;
+    while (true) {
+        ret = sock->connect(tls_server, SERVER_NAME);
+        calls += 1;
+        if (ret != NSAPI_ERROR_IN_PROGRESS && ret != NSAPI_ERROR_ALREADY) {
+            break;
+        }
+
+        CHECK(ret == (calls == 1 ? NSAPI_ERROR_IN_PROGRESS : NSAPI_ERROR_ALREADY));
+        CHECK(sigio_sem.wait(5000) > 0);
+    }
+    CHECK(ret == 0);
+    CHECK(calls > 1);
+
+    unsigned char out[ECHO_SIZE];
+    unsigned char in[ECHO_SIZE];
+    memset(out, 0xa5, sizeof out);
+    CHECK(sock->send(out, sizeof out) == (nsapi_size_or_error_t)sizeof out);
+
+    nsapi_size_t received = 0;
+    while (received < sizeof in) {
+        nsapi_size_or_error_t ret = sock->recv(in + received, sizeof in - received);
+        if (ret == NSAPI_ERROR_WOULD_BLOCK) {
+            CHECK(sigio_sem.wait(5000) > 0);
+            continue;
+        }
+
+        CHECK(ret > 0);
+        received += ret;
+    }
+    CHECK(memcmp(out, in, sizeof out) == 0);
+
+    bool resumed = sock->is_resumed();
+    CHECK(sock->close() == 0);
+    return resumed;
+}
+
+static void test_nonblocking()
+{
+    server_resumption(RESUME_SESSION_ID);
+    nsapi_tls_session_remove(NULL);
+
+    // Keep the handshake from completing in the first call
+    server_delay = 20;
+
+    TLSSocket sock;
+    CHECK(!nonblocking_round(&sock));
+    CHECK(nonblocking_round(&sock));
+    server_delay = 0;
+    check_stats(1, 1, 0);
+    printf("HOST: non-blocking handshake ok\r\n");
+}
+
+static void test_dtls()
+{
+    nsapi_tls_session_remove(NULL);
+
+    DTLSSocket sock;
+    CHECK(!tls_round(&sock, dtls_server_address));
+    CHECK(tls_round(&sock, dtls_server_address));
+
+    // TLS and DTLS sessions with the same server are kept apart
+    TLSSocket tls;
+    CHECK(!tls_round(&tls, tls_server));
+    CHECK(tls_round(&sock, dtls_server_address));
+    check_stats(2, 2, 0);
+    printf("HOST: DTLS resumption ok\r\n");
+}
+
+
+// The far end of the link hands every frame straight back
+static void reflect_input(void *data, emac_stack_mem_chain_t *chain)
+{
+    emac_interface_t *emac = (emac_interface_t *)data;
+    emac_stack_mem_t *buf = emac_stack_mem_chain_dequeue(NULL, &chain);
+
+    emac->ops.link_out(emac, buf);
+    emac_stack_mem_free(NULL, buf);
+}
+
+int main()
+{
+#if defined(TLS_SOCKET_BUFFER_ALLOC)
+    static unsigned char heap[HEAP_SIZE];
+    mbedtls_memory_buffer_alloc_init(heap, sizeof heap);
+#endif
+
+    emac_interface_t *reflector = loopback_emac_get(1);
+    reflector->ops.set_link_input_cb(reflector, reflect_input, reflector);
+    CHECK(reflector->ops.power_up(reflector));
+
+    CHECK(mbed_lwip_init(loopback_emac_get(0)) == 0);
+    CHECK(mbed_lwip_bringup(false, HOST_IP, NETMASK, GATEWAY) == 0);
+    stack = nsapi_create_stack(&lwip_stack);
+
+    mbedtls_x509_crt_init(&srv_crt);
+    mbedtls_pk_init(&srv_key);
+    CHECK(mbedtls_x509_crt_parse(&srv_crt, (const unsigned char *)mbedtls_test_srv_crt_ec,
+            strlen(mbedtls_test_srv_crt_ec) + 1) == 0);
+    CHECK(mbedtls_pk_parse_key(&srv_key, (const unsigned char *)mbedtls_test_srv_key_ec,
+            strlen(mbedtls_test_srv_key_ec) + 1, NULL, 0) == 0);
+
+    mbedtls_ssl_cache_init(&srv_cache);
+    mbedtls_ssl_ticket_init(&srv_ticket);
+    CHECK(mbedtls_ssl_ticket_setup(&srv_ticket, nsapi_tls_rng, NULL,
+            MBEDTLS_CIPHER_AES_256_GCM, 86400) == 0);
+
+    server_config(&tls_conf, MBEDTLS_SSL_TRANSPORT_STREAM);
+    server_config(&dtls_conf, MBEDTLS_SSL_TRANSPORT_DATAGRAM);
+    mbedtls_ssl_cookie_init(&srv_cookie);
+    CHECK(mbedtls_ssl_cookie_setup(&srv_cookie, nsapi_tls_rng, NULL) == 0);
+    mbedtls_ssl_conf_dtls_cookies(&dtls_conf, mbedtls_ssl_cookie_write,
+            mbedtls_ssl_cookie_check, &srv_cookie);
+
+    // The DTLS server keeps its own session cache for the whole run
+    static mbedtls_ssl_cache_context dtls_cache;
+    mbedtls_ssl_cache_init(&dtls_cache);
+    mbedtls_ssl_conf_session_cache(&dtls_conf, &dtls_cache,
+            mbedtls_ssl_cache_get, mbedtls_ssl_cache_set);
+    mbedtls_ssl_conf_session_tickets_cb(&dtls_conf, NULL, NULL, NULL);
+    server_resumption(RESUME_NONE);
+
+    pthread_t tls_thread, dtls_thread;
+    CHECK(pthread_create(&tls_thread, NULL, tls_server_thread, NULL) == 0);
+    CHECK(pthread_create(&dtls_thread, NULL, dtls_server_thread, NULL) == 0);
+    printf("HOST: lwIP up at %s, TLS on port %d, DTLS on port %d\r\n",
+           HOST_IP, TLS_PORT, DTLS_PORT);
+
+    test_session_id();
+    test_ticket();
+    test_server_forgets();
+    test_wrong_name();
+    test_other_config();
+    test_nonblocking();
+    test_dtls();
+
+#if defined(TLS_SOCKET_BUFFER_ALLOC)
+    CHECK(mbedtls_memory_buffer_alloc_verify() == 0);
+    printf("HOST: buffer allocator heap ok\r\n");
+#endif
+
+    printf("HOST: all passed\r\n");
+    return EXIT_SUCCESS;
+}
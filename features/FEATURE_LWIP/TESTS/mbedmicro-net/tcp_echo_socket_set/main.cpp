@@ -0,0 +1,162 @@
+#if !FEATURE_LWIP
+    #error [NOT_SUPPORTED] LWIP not supported for this target
+#endif
+#if DEVICE_EMAC
+    #error [NOT_SUPPORTED] Not supported for WiFi targets
+#endif
+
+#include "mbed.h"
+#include "EthernetInterface.h"
+#include "TCPSocket.h"
+#include "SocketSet.h"
+#include "greentea-client/test_env.h"
+#include "unity/unity.h"
+
+
+#ifndef MBED_CFG_TCP_CLIENT_ECHO_BUFFER_SIZE
+#define MBED_CFG_TCP_CLIENT_ECHO_BUFFER_SIZE 64
+#endif
+
+#ifndef MBED_CFG_TCP_CLIENT_ECHO_SOCKETS
+#define MBED_CFG_TCP_CLIENT_ECHO_SOCKETS 3
+#endif
+
+#ifndef MBED_CFG_TCP_CLIENT_ECHO_TIMEOUT
+#define MBED_CFG_TCP_CLIENT_ECHO_TIMEOUT 10000
+#endif
+
+
+EthernetInterface net;
+SocketAddress tcp_addr;
+
+void prep_buffer(char *tx_buffer, size_t tx_size) {
+    for (size_t i=0; i<tx_size; ++i) {
+        tx_buffer[i] = (rand() % 10) + '0';
+    }
+}
+
+
+// Each echo is one transaction, all driven from the main thread
+class Echo {
+private:
+    char tx_buffer[MBED_CFG_TCP_CLIENT_ECHO_BUFFER_SIZE];
+    char rx_buffer[MBED_CFG_TCP_CLIENT_ECHO_BUFFER_SIZE];
+    size_t tx_count;
+    size_t rx_count;
+
+public:
+    TCPSocket sock;
+
+    void start() {
+        int err = sock.open(&net);
+        TEST_ASSERT_EQUAL(0, err);
+
+        err = sock.connect(tcp_addr);
+        TEST_ASSERT_EQUAL(0, err);
+
+        sock.set_blocking(false);
+        prep_buffer(tx_buffer, sizeof(tx_buffer));
+        tx_count = 0;
+        rx_count = 0;
+    }
+
+    // Makes as much progress as possible without blocking
+    void step() {
+        while (tx_count < sizeof(tx_buffer)) {
+            int td = sock.send(tx_buffer + tx_count, sizeof(tx_buffer) - tx_count);
+            if (td == NSAPI_ERROR_WOULD_BLOCK) {
+                break;
+            }
+            TEST_ASSERT(td > 0);
+            tx_count += td;
+        }
+
+        while (rx_count < sizeof(rx_buffer)) {
+            int rd = sock.recv(rx_buffer + rx_count, sizeof(rx_buffer) - rx_count);
+            if (rd == NSAPI_ERROR_WOULD_BLOCK) {
+                break;
+            }
+            TEST_ASSERT(rd > 0);
+            rx_count += rd;
+        }
+    }
+
+    bool done() {
+        return rx_count == sizeof(rx_buffer);
+    }
+
+    void finish() {
+        bool result = !memcmp(tx_buffer, rx_buffer, sizeof(tx_buffer));
+        TEST_ASSERT_EQUAL(true, result);
+
+        int err = sock.close();
+        TEST_ASSERT_EQUAL(0, err);
+    }
+};
+
+Echo echoers[MBED_CFG_TCP_CLIENT_ECHO_SOCKETS];
+
+int main() {
+    GREENTEA_SETUP(60, "tcp_echo");
+
+    int err = net.connect();
+    TEST_ASSERT_EQUAL(0, err);
+
+    printf("MBED: TCPClient IP address is '%s'\n", net.get_ip_address());
+    printf("MBED: TCPClient waiting for server IP and port...\n");
+
+    greentea_send_kv("target_ip", net.get_ip_address());
+
+    char recv_key[] = "host_port";
+    char ipbuf[60] = {0};
+    char portbuf[16] = {0};
+    unsigned int port = 0;
+
+    greentea_send_kv("host_ip", " ");
+    greentea_parse_kv(recv_key, ipbuf, sizeof(recv_key), sizeof(ipbuf));
+
+    greentea_send_kv("host_port", " ");
+    greentea_parse_kv(recv_key, portbuf, sizeof(recv_key), sizeof(ipbuf));
+    sscanf(portbuf, "%u", &port);
+
+    printf("MBED: Server IP address received: %s:%d \n", ipbuf, port);
+    tcp_addr.set_ip_address(ipbuf);
+    tcp_addr.set_port(port);
+
+    // One thread serves every connection through the set
+    SocketSet set;
+    for (int i = 0; i < MBED_CFG_TCP_CLIENT_ECHO_SOCKETS; i++) {
+        echoers[i].start();
+        err = set.add(&echoers[i].sock);
+        TEST_ASSERT_EQUAL(0, err);
+    }
+
+    int remaining = MBED_CFG_TCP_CLIENT_ECHO_SOCKETS;
+    while (remaining > 0) {
+        Socket *ready[MBED_CFG_TCP_CLIENT_ECHO_SOCKETS];
+        int count = set.wait(ready, MBED_CFG_TCP_CLIENT_ECHO_SOCKETS,
+                MBED_CFG_TCP_CLIENT_ECHO_TIMEOUT);
+        TEST_ASSERT(count > 0);
+
+        for (int i = 0; i < count; i++) {
+            for (int j = 0; j < MBED_CFG_TCP_CLIENT_ECHO_SOCKETS; j++) {
+                if (ready[i] != &echoers[j].sock || echoers[j].done()) {
+                    continue;
+                }
+
+                echoers[j].step();
+                if (echoers[j].done()) {
+                    err = set.remove(&echoers[j].sock);
+                    TEST_ASSERT_EQUAL(0, err);
+                    echoers[j].finish();
+                    remaining -= 1;
+                }
+            }
+        }
+    }
+
+    TEST_ASSERT_EQUAL(0, set.size());
+
+    net.disconnect();
+    GREENTEA_TESTSUITE_RESULT(true);
+}
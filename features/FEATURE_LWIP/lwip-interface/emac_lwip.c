@@ -55,11 +55,40 @@ static void emac_lwip_state_change(void *data, bool up)
     }
 }
 
+#if LWIP_CHECKSUM_CTRL_PER_NETIF
+/* Software checksums still needed with the given offloads */
+static u16_t emac_lwip_checksum_ctrl(uint32_t offload)
+{
+    u16_t flags = NETIF_CHECKSUM_ENABLE_ALL;
+
+    if (offload & EMAC_OFFLOAD_TX_IP_CHECKSUM) {
+        flags &= ~NETIF_CHECKSUM_GEN_IP;
+    }
+    if (offload & EMAC_OFFLOAD_TX_L4_CHECKSUM) {
+        flags &= ~(NETIF_CHECKSUM_GEN_UDP | NETIF_CHECKSUM_GEN_TCP |
+                   NETIF_CHECKSUM_GEN_ICMP | NETIF_CHECKSUM_GEN_ICMP6);
+    }
+    if (offload & EMAC_OFFLOAD_RX_IP_CHECKSUM) {
+        flags &= ~NETIF_CHECKSUM_CHECK_IP;
+    }
+    if (offload & EMAC_OFFLOAD_RX_L4_CHECKSUM) {
+        flags &= ~(NETIF_CHECKSUM_CHECK_UDP | NETIF_CHECKSUM_CHECK_TCP |
+                   NETIF_CHECKSUM_CHECK_ICMP | NETIF_CHECKSUM_CHECK_ICMP6);
+    }
+
+    return flags;
+}
+#endif /* LWIP_CHECKSUM_CTRL_PER_NETIF */
+
 err_t emac_lwip_if_init(struct netif *netif)
 {
     int err = ERR_OK;
     emac_interface_t *mac = (emac_interface_t *)netif->state;
 
+    /* Interface capabilities. Set before powering up, as the link state
+     * callback may already have marked the link up when power_up returns. */
+    netif->flags = NETIF_FLAG_BROADCAST | NETIF_FLAG_ETHARP | NETIF_FLAG_ETHERNET | NETIF_FLAG_IGMP;
+
     mac->ops.set_link_input_cb(mac, emac_lwip_input, netif);
     mac->ops.set_link_state_cb(mac, emac_lwip_state_change, netif);
 
@@ -71,11 +100,14 @@ err_t emac_lwip_if_init(struct netif *netif)
     netif->hwaddr_len = mac->ops.get_hwaddr_size(mac);
     mac->ops.get_hwaddr(mac, netif->hwaddr);
 
-    /* Interface capabilities */
-    netif->flags = NETIF_FLAG_BROADCAST | NETIF_FLAG_ETHARP | NETIF_FLAG_ETHERNET | NETIF_FLAG_IGMP;
-
     mac->ops.get_ifname(mac, netif->name, 2);
 
+#if LWIP_CHECKSUM_CTRL_PER_NETIF
+    if (mac->ops.get_offload) {
+        NETIF_SET_CHECKSUM_CTRL(netif, emac_lwip_checksum_ctrl(mac->ops.get_offload(mac)));
+    }
+#endif /* LWIP_CHECKSUM_CTRL_PER_NETIF */
+
 #if LWIP_IPV4
     netif->output = etharp_output;
 #endif /* LWIP_IPV4 */
@@ -28,7 +28,7 @@ emac_stack_mem_t *emac_stack_mem_alloc(emac_stack_t* stack, uint32_t size, uint3
     }
 
     if (align) {
-        uint32_t remainder = (uint32_t)pbuf->payload % align;
+        uint32_t remainder = (uintptr_t)pbuf->payload % align;
         uint32_t offset = align - remainder;
         if (offset >= align) {
             offset = align;
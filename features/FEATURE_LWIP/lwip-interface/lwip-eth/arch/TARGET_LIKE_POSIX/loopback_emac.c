@@ -0,0 +1,403 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#if DEVICE_EMAC
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <sys/time.h>
+
+#include "mbed_assert.h"
+#include "emac_api.h"
+#include "emac_stack_mem.h"
+#include "loopback_emac.h"
+
+#include "lwip/pbuf.h"
+#include "netif/etharp.h"
+
+#define LOOPBACK_EMAC_MTU_SIZE  (1500U)
+
+struct loopback_frame {
+    struct loopback_frame *next;
+    uint32_t len;
+    uint8_t data[];
+};
+
+struct loopback_end {
+    uint8_t hwaddr[ETHARP_HWADDR_LEN];
+    bool powered;
+    bool link_up;
+
+    emac_link_input_fn link_input_cb;
+    void *link_input_data;
+    emac_link_state_change_fn link_state_cb;
+    void *link_state_data;
+
+    pthread_t rx_thread;
+    pthread_mutex_t rx_mutex;
+    pthread_cond_t rx_cond;
+    struct loopback_frame *rx_head;
+    struct loopback_frame *rx_tail;
+    uint32_t rx_queued;
+
+    uint32_t offload;
+    uint32_t loss_ppm;
+    uint32_t loss_state;
+    loopback_emac_stats_t stats;
+};
+
+static struct loopback_end loopback_ends[LOOPBACK_EMAC_ENDS];
+static pthread_mutex_t loopback_mutex = PTHREAD_MUTEX_INITIALIZER;
+static FILE *loopback_capture_file;
+
+static struct loopback_end *loopback_end(emac_interface_t *emac)
+{
+    return (struct loopback_end *)emac->hw;
+}
+
+static struct loopback_end *loopback_peer(emac_interface_t *emac)
+{
+    return &loopback_ends[(loopback_end(emac) - loopback_ends) ^ 1];
+}
+
+static void loopback_capture(const struct loopback_frame *frame)
+{
+    struct {
+        uint32_t ts_sec;
+        uint32_t ts_usec;
+        uint32_t incl_len;
+        uint32_t orig_len;
+    } record;
+    struct timeval now;
+
+    gettimeofday(&now, NULL);
+    record.ts_sec = now.tv_sec;
+    record.ts_usec = now.tv_usec;
+    record.incl_len = frame->len;
+    record.orig_len = frame->len;
+
+    fwrite(&record, sizeof(record), 1, loopback_capture_file);
+    fwrite(frame->data, frame->len, 1, loopback_capture_file);
+}
+
+/* Called with loopback_mutex held */
+static bool loopback_lose(struct loopback_end *end)
+{
+    if (!end->loss_ppm) {
+        return false;
+    }
+
+    /* xorshift32 */
+    uint32_t x = end->loss_state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    end->loss_state = x;
+
+    return x % 1000000 < end->loss_ppm;
+}
+
+static void loopback_set_link(struct loopback_end *end, bool up)
+{
+    if (end->link_up != up) {
+        end->link_up = up;
+        if (end->link_state_cb) {
+            end->link_state_cb(end->link_state_data, up);
+        }
+    }
+}
+
+static void *loopback_rx_thread(void *arg)
+{
+    struct loopback_end *end = (struct loopback_end *)arg;
+
+    pthread_mutex_lock(&end->rx_mutex);
+    while (end->powered || end->rx_head) {
+        struct loopback_frame *frame = end->rx_head;
+        if (!frame) {
+            pthread_cond_wait(&end->rx_cond, &end->rx_mutex);
+            continue;
+        }
+
+        end->rx_head = frame->next;
+        if (!end->rx_head) {
+            end->rx_tail = NULL;
+        }
+        end->rx_queued--;
+        pthread_mutex_unlock(&end->rx_mutex);
+
+        emac_stack_mem_t *buf = NULL;
+        if (end->powered && end->link_input_cb) {
+            buf = emac_stack_mem_alloc(NULL, frame->len, 0);
+        }
+        if (buf) {
+            memcpy(emac_stack_mem_ptr(NULL, buf), frame->data, frame->len);
+            end->stats.rx_frames++;
+            end->stats.rx_bytes += frame->len;
+            end->link_input_cb(end->link_input_data, buf);
+        } else {
+            end->stats.rx_dropped++;
+        }
+        free(frame);
+
+        pthread_mutex_lock(&end->rx_mutex);
+    }
+    pthread_mutex_unlock(&end->rx_mutex);
+
+    return NULL;
+}
+
+static uint32_t loopback_get_mtu_size(emac_interface_t *emac)
+{
+    return LOOPBACK_EMAC_MTU_SIZE;
+}
+
+static void loopback_get_ifname(emac_interface_t *emac, char *name, uint8_t size)
+{
+    MBED_ASSERT(name != NULL);
+    strncpy(name, "lo", size);
+}
+
+static uint8_t loopback_get_hwaddr_size(emac_interface_t *emac)
+{
+    return ETHARP_HWADDR_LEN;
+}
+
+static void loopback_get_hwaddr(emac_interface_t *emac, uint8_t *addr)
+{
+    memcpy(addr, loopback_end(emac)->hwaddr, ETHARP_HWADDR_LEN);
+}
+
+static void loopback_set_hwaddr(emac_interface_t *emac, uint8_t *addr)
+{
+    memcpy(loopback_end(emac)->hwaddr, addr, ETHARP_HWADDR_LEN);
+}
+
+static bool loopback_link_out(emac_interface_t *emac, emac_stack_mem_t *buf)
+{
+    struct loopback_end *end = loopback_end(emac);
+    struct loopback_end *peer = loopback_peer(emac);
+    struct pbuf *p = (struct pbuf *)buf;
+
+    if (!end->link_up) {
+        return false;
+    }
+
+    struct loopback_frame *frame = malloc(sizeof(struct loopback_frame) + p->tot_len);
+    if (!frame) {
+        return false;
+    }
+    frame->next = NULL;
+    frame->len = pbuf_copy_partial(p, frame->data, p->tot_len, 0);
+
+    end->stats.tx_frames++;
+    end->stats.tx_bytes += frame->len;
+
+    pthread_mutex_lock(&loopback_mutex);
+    if (loopback_capture_file) {
+        loopback_capture(frame);
+    }
+    bool lost = loopback_lose(end);
+    pthread_mutex_unlock(&loopback_mutex);
+
+    if (lost) {
+        end->stats.tx_lost++;
+        free(frame);
+        return true;
+    }
+
+    /* A full receive queue loses the frame, as a saturated MAC would */
+    pthread_mutex_lock(&peer->rx_mutex);
+    if (peer->rx_queued < LOOPBACK_EMAC_RX_QUEUE_LEN) {
+        if (peer->rx_tail) {
+            peer->rx_tail->next = frame;
+        } else {
+            peer->rx_head = frame;
+        }
+        peer->rx_tail = frame;
+        peer->rx_queued++;
+        pthread_cond_signal(&peer->rx_cond);
+        frame = NULL;
+    } else {
+        peer->stats.rx_dropped++;
+    }
+    pthread_mutex_unlock(&peer->rx_mutex);
+
+    free(frame);
+    return true;
+}
+
+static bool loopback_power_up(emac_interface_t *emac)
+{
+    struct loopback_end *end = loopback_end(emac);
+    struct loopback_end *peer = loopback_peer(emac);
+
+    pthread_mutex_lock(&loopback_mutex);
+    if (end->powered) {
+        pthread_mutex_unlock(&loopback_mutex);
+        return true;
+    }
+
+    end->powered = true;
+    if (pthread_create(&end->rx_thread, NULL, loopback_rx_thread, end) != 0) {
+        end->powered = false;
+        pthread_mutex_unlock(&loopback_mutex);
+        return false;
+    }
+
+    if (peer->powered) {
+        loopback_set_link(end, true);
+        loopback_set_link(peer, true);
+    }
+    pthread_mutex_unlock(&loopback_mutex);
+
+    return true;
+}
+
+static void loopback_power_down(emac_interface_t *emac)
+{
+    struct loopback_end *end = loopback_end(emac);
+    struct loopback_end *peer = loopback_peer(emac);
+
+    pthread_mutex_lock(&loopback_mutex);
+    if (!end->powered) {
+        pthread_mutex_unlock(&loopback_mutex);
+        return;
+    }
+
+    loopback_set_link(end, false);
+    loopback_set_link(peer, false);
+
+    pthread_mutex_lock(&end->rx_mutex);
+    end->powered = false;
+    pthread_cond_signal(&end->rx_cond);
+    pthread_mutex_unlock(&end->rx_mutex);
+    pthread_mutex_unlock(&loopback_mutex);
+
+    pthread_join(end->rx_thread, NULL);
+}
+
+static void loopback_set_link_input_cb(emac_interface_t *emac, emac_link_input_fn cb, void *data)
+{
+    loopback_end(emac)->link_input_cb = cb;
+    loopback_end(emac)->link_input_data = data;
+}
+
+static void loopback_set_link_state_cb(emac_interface_t *emac, emac_link_state_change_fn cb, void *data)
+{
+    loopback_end(emac)->link_state_cb = cb;
+    loopback_end(emac)->link_state_data = data;
+}
+
+static uint32_t loopback_get_offload(emac_interface_t *emac)
+{
+    return loopback_end(emac)->offload;
+}
+
+static const emac_interface_ops_t loopback_emac_interface = {
+    .get_mtu_size = loopback_get_mtu_size,
+    .get_ifname = loopback_get_ifname,
+    .get_hwaddr_size = loopback_get_hwaddr_size,
+    .get_hwaddr = loopback_get_hwaddr,
+    .set_hwaddr = loopback_set_hwaddr,
+    .link_out = loopback_link_out,
+    .power_up = loopback_power_up,
+    .power_down = loopback_power_down,
+    .set_link_input_cb = loopback_set_link_input_cb,
+    .set_link_state_cb = loopback_set_link_state_cb,
+    .get_offload = loopback_get_offload
+};
+
+static emac_interface_t loopback_emacs[LOOPBACK_EMAC_ENDS] = {
+    { loopback_emac_interface, &loopback_ends[0] },
+    { loopback_emac_interface, &loopback_ends[1] },
+};
+
+static void loopback_init(void)
+{
+    for (unsigned i = 0; i < LOOPBACK_EMAC_ENDS; i++) {
+        struct loopback_end *end = &loopback_ends[i];
+
+        /* Locally administered unicast addresses */
+        end->hwaddr[0] = 0x02;
+        end->hwaddr[5] = i + 1;
+
+        pthread_mutex_init(&end->rx_mutex, NULL);
+        pthread_cond_init(&end->rx_cond, NULL);
+    }
+}
+
+emac_interface_t *loopback_emac_get(unsigned end)
+{
+    static pthread_once_t once = PTHREAD_ONCE_INIT;
+
+    if (end >= LOOPBACK_EMAC_ENDS) {
+        return NULL;
+    }
+
+    pthread_once(&once, loopback_init);
+    return &loopback_emacs[end];
+}
+
+void loopback_emac_capture(FILE *file)
+{
+    static const struct {
+        uint32_t magic;
+        uint16_t version_major;
+        uint16_t version_minor;
+        int32_t thiszone;
+        uint32_t sigfigs;
+        uint32_t snaplen;
+        uint32_t network;
+    } header = { 0xa1b2c3d4, 2, 4, 0, 0, 0xffff, 1 /* LINKTYPE_ETHERNET */ };
+
+    pthread_mutex_lock(&loopback_mutex);
+    if (loopback_capture_file) {
+        fflush(loopback_capture_file);
+    }
+    loopback_capture_file = file;
+    if (file) {
+        fwrite(&header, sizeof(header), 1, file);
+    }
+    pthread_mutex_unlock(&loopback_mutex);
+}
+
+void loopback_emac_get_stats(emac_interface_t *emac, loopback_emac_stats_t *stats)
+{
+    *stats = loopback_end(emac)->stats;
+}
+
+void loopback_emac_reset_stats(emac_interface_t *emac)
+{
+    memset(&loopback_end(emac)->stats, 0, sizeof(loopback_emac_stats_t));
+}
+
+void loopback_emac_set_offload(emac_interface_t *emac, uint32_t offload)
+{
+    loopback_end(emac)->offload = offload;
+}
+
+void loopback_emac_set_loss(emac_interface_t *emac, uint32_t ppm, uint32_t seed)
+{
+    pthread_mutex_lock(&loopback_mutex);
+    loopback_end(emac)->loss_ppm = ppm;
+    loopback_end(emac)->loss_state = seed ? seed : 1;
+    pthread_mutex_unlock(&loopback_mutex);
+}
+
+#endif /* DEVICE_EMAC */
@@ -0,0 +1,106 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LOOPBACK_EMAC_H
+#define LOOPBACK_EMAC_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include "emac_api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Loopback EMAC for host builds of the stack
+ *
+ * Two in-memory EMACs wired back to back: a frame passed to link_out() on
+ * one end is copied, queued, and delivered to the input callback of the
+ * other end from that end's receive thread, the same way a hardware driver
+ * hands frames to the stack. The link is up while both ends are powered.
+ */
+
+#define LOOPBACK_EMAC_ENDS          2
+
+#ifndef LOOPBACK_EMAC_RX_QUEUE_LEN
+#define LOOPBACK_EMAC_RX_QUEUE_LEN  64
+#endif
+
+typedef struct loopback_emac_stats {
+    uint32_t tx_frames;
+    uint32_t tx_bytes;
+    uint32_t rx_frames;
+    uint32_t rx_bytes;
+    uint32_t rx_dropped;
+    uint32_t tx_lost;
+} loopback_emac_stats_t;
+
+/** Return one end of the loopback pair
+ *
+ * @param end   Index of the end, 0 or 1
+ * @return      EMAC interface for that end, NULL if end is out of range
+ */
+emac_interface_t *loopback_emac_get(unsigned end);
+
+/** Record every frame crossing the link to a pcap file
+ *
+ * @param file  File opened for binary writing, or NULL to stop capturing
+ */
+void loopback_emac_capture(FILE *file);
+
+/** Read the traffic counters of one end
+ *
+ * @param emac  EMAC interface returned by loopback_emac_get
+ * @param stats Where to write the counters
+ */
+void loopback_emac_get_stats(emac_interface_t *emac, loopback_emac_stats_t *stats);
+
+/** Reset the traffic counters of one end
+ *
+ * @param emac  EMAC interface returned by loopback_emac_get
+ */
+void loopback_emac_reset_stats(emac_interface_t *emac);
+
+/** Set the checksum offloads an end reports to the stack
+ *
+ * Nothing computes or checks the offloaded checksums, so frames carry
+ * whatever the stack left in them. That only makes sense for an end whose
+ * frames come back to itself with both directions offloaded. Takes effect
+ * when the stack next initialises the interface.
+ *
+ * @param emac    EMAC interface returned by loopback_emac_get
+ * @param offload Mask of emac_offload_t flags
+ */
+void loopback_emac_set_offload(emac_interface_t *emac, uint32_t offload);
+
+/** Lose frames sent out of an end at random, to model a lossy link
+ *
+ * Frames are lost independently of each other. The sequence of losses
+ * only depends on the seed and the frames sent, so runs are repeatable.
+ * Lost frames are still captured, and counted in tx_lost.
+ *
+ * @param emac  EMAC interface returned by loopback_emac_get
+ * @param ppm   Frames lost per million sent, 0 for a perfect link
+ * @param seed  Seed of the loss sequence
+ */
+void loopback_emac_set_loss(emac_interface_t *emac, uint32_t ppm, uint32_t seed);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LOOPBACK_EMAC_H */
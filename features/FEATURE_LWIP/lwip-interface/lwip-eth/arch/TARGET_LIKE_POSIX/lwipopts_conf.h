@@ -0,0 +1,33 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LWIPOPTS_CONF_H
+#define LWIPOPTS_CONF_H
+
+#define LWIP_TRANSPORT_ETHERNET       1
+
+// The throughput profile's send buffers alone would fill the default heap
+// with the bench's client and echo server connected to each other
+#if MBED_CONF_LWIP_THROUGHPUT_PROFILE
+#define MEM_SIZE                      (1600 * 64)
+#else
+#define MEM_SIZE                      (1600 * 16)
+#endif
+
+// Pointer alignment of the host, for 64-bit builds
+#define MEM_ALIGNMENT                 __SIZEOF_POINTER__
+
+#endif
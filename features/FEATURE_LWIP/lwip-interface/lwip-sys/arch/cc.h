@@ -90,6 +90,9 @@
     #define LWIP_CHKSUM_ALGORITHM   1
 #endif
 
+/* Fused copy and checksum, used for LWIP_CHKSUM_COPY */
+uint16_t mbed_lwip_chksum_copy(void *dst, const void *src, uint16_t len);
+
 
 #ifdef LWIP_DEBUG
 
@@ -117,8 +120,13 @@ void assert_printf(char *msg, int line, char *file);
 #endif // MBED_CONF_LWIP_USE_MBED_TRACE
 #endif 
 
+#if defined(TARGET_LIKE_POSIX)
+#define LWIP_PLATFORM_HTONS(x)      __builtin_bswap16(x)
+#define LWIP_PLATFORM_HTONL(x)      __builtin_bswap32(x)
+#else
 #include "cmsis.h"
 #define LWIP_PLATFORM_HTONS(x)      __REV16(x)
 #define LWIP_PLATFORM_HTONL(x)      __REV(x)
+#endif
 
 #endif /* __CC_H__ */ 
@@ -0,0 +1,123 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Fused copy and checksum for lwIP's checksum-on-copy, so that data copied
+ * into a pbuf is only read once. Returns the same unfolded, uninverted sum as
+ * LWIP_CHKSUM over the copied data.
+ *
+ * The source is read a word at a time once it is aligned. Stores go through
+ * memcpy, which compiles to a single store on cores that allow unaligned
+ * access and to byte stores on those that don't, so the destination needn't
+ * share the source's alignment. That is the usual case for TCP, where the
+ * 14-byte Ethernet header leaves the payload off word alignment. */
+#include <stdint.h>
+#include <string.h>
+
+#include "lwip/opt.h"
+
+#if LWIP_CHECKSUM_ON_COPY
+
+/* Sum of a lone byte at the given position in its 16-bit word */
+static u16_t chksum_byte(u8_t byte, int high)
+{
+    u8_t pair[2] = {0, 0};
+    u16_t half;
+
+    pair[high] = byte;
+    memcpy(&half, pair, sizeof(half));
+    return half;
+}
+
+u16_t mbed_lwip_chksum_copy(void *dst, const void *src, u16_t len)
+{
+    u8_t *d = (u8_t *)dst;
+    const u8_t *s = (const u8_t *)src;
+    uint64_t acc = 0;
+    int swapped = (uintptr_t)s & 1;
+
+    /* Align the source, summing as if from the start of its 16-bit word
+     * and swapping the result at the end */
+    if (swapped && len > 0) {
+        acc += chksum_byte(*s, 1);
+        *d++ = *s++;
+        len -= 1;
+    }
+
+    if (((uintptr_t)s & 2) && len >= 2) {
+        u16_t half = *(const u16_t *)s;
+        memcpy(d, &half, sizeof(half));
+        acc += half;
+        s += 2;
+        d += 2;
+        len -= 2;
+    }
+
+    while (len >= 16) {
+        const u32_t *w = (const u32_t *)s;
+        u32_t w0 = w[0];
+        u32_t w1 = w[1];
+        u32_t w2 = w[2];
+        u32_t w3 = w[3];
+        memcpy(d + 0, &w0, sizeof(w0));
+        memcpy(d + 4, &w1, sizeof(w1));
+        memcpy(d + 8, &w2, sizeof(w2));
+        memcpy(d + 12, &w3, sizeof(w3));
+        acc += w0;
+        acc += w1;
+        acc += w2;
+        acc += w3;
+        s += 16;
+        d += 16;
+        len -= 16;
+    }
+
+    while (len >= 4) {
+        u32_t w0 = *(const u32_t *)s;
+        memcpy(d, &w0, sizeof(w0));
+        acc += w0;
+        s += 4;
+        d += 4;
+        len -= 4;
+    }
+
+    if (len >= 2) {
+        u16_t half = *(const u16_t *)s;
+        memcpy(d, &half, sizeof(half));
+        acc += half;
+        s += 2;
+        d += 2;
+        len -= 2;
+    }
+
+    if (len > 0) {
+        acc += chksum_byte(*s, 0);
+        *d = *s;
+    }
+
+    /* Fold the carries back in, 64 to 16 bits */
+    acc = (acc & 0xffffffffu) + (acc >> 32);
+    acc = (acc & 0xffffffffu) + (acc >> 32);
+    acc = (acc & 0xffffu) + (acc >> 16);
+    acc = (acc & 0xffffu) + (acc >> 16);
+
+    if (swapped) {
+        acc = ((acc & 0xff) << 8) | ((acc & 0xff00) >> 8);
+    }
+
+    return (u16_t)acc;
+}
+
+#endif /* LWIP_CHECKSUM_ON_COPY */
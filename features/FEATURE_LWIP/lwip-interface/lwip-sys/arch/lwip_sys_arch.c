@@ -20,8 +20,10 @@
 /* mbed includes */
 #include "mbed_error.h"
 #include "mbed_interface.h"
+#if !defined(TARGET_LIKE_POSIX)
 #include "us_ticker_api.h"
 #include "mbed_rtos_storage.h"
+#endif
 
 /* lwIP includes. */
 #include "lwip/opt.h"
@@ -107,10 +109,13 @@ u32_t sys_now(void) {
   return (u32_t) systick_timems;
 }
 
-#else
-/* CMSIS-RTOS implementation of the lwip operating system abstraction */
+#elif !defined(TARGET_LIKE_POSIX)
+/* CMSIS-RTOS implementation of the lwip operating system abstraction.
+ * Host builds use the pthreads implementation in lwip_sys_arch_posix.c */
 #include "arch/sys_arch.h"
 
+#if !MBED_CONF_LWIP_MBOX_LOCK_FREE
+/* Mailboxes on event flags, the lock-free ring is in lwip_sys_mbox.c */
 /*---------------------------------------------------------------------------*
  * Routine:  sys_mbox_new
  *---------------------------------------------------------------------------*
@@ -290,6 +295,7 @@ u32_t sys_arch_mbox_tryfetch(sys_mbox_t *mbox, void **msg) {
     osKernelRestoreLock(state);
     return ERR_OK;
 }
+#endif /* !MBED_CONF_LWIP_MBOX_LOCK_FREE */
 
 /*---------------------------------------------------------------------------*
  * Routine:  sys_sem_new
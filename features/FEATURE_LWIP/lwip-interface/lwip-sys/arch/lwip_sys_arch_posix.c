@@ -0,0 +1,290 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* pthreads implementation of the lwip operating system abstraction, used
+ * when the stack is built for a POSIX host (TARGET_LIKE_POSIX) so that it
+ * can be exercised and profiled without a target. */
+#if defined(TARGET_LIKE_POSIX)
+
+#include <string.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <time.h>
+
+#include "mbed_error.h"
+
+#include "lwip/opt.h"
+#include "lwip/sys.h"
+
+#if NO_SYS == 0
+#include "arch/sys_arch.h"
+
+static void sys_cond_init(pthread_cond_t *cond)
+{
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(cond, &attr);
+    pthread_condattr_destroy(&attr);
+}
+
+static u32_t sys_now_ms(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (u32_t)(now.tv_sec * 1000 + now.tv_nsec / 1000000);
+}
+
+/* Wait on cond for at most timeout milliseconds (0 waits forever).
+ * Returns false on timeout. */
+static bool sys_cond_wait(pthread_cond_t *cond, pthread_mutex_t *mutex, u32_t timeout)
+{
+    if (timeout == 0) {
+        pthread_cond_wait(cond, mutex);
+        return true;
+    }
+
+    struct timespec abstime;
+    clock_gettime(CLOCK_MONOTONIC, &abstime);
+    abstime.tv_sec  += timeout / 1000;
+    abstime.tv_nsec += (timeout % 1000) * 1000000L;
+    if (abstime.tv_nsec >= 1000000000L) {
+        abstime.tv_sec  += 1;
+        abstime.tv_nsec -= 1000000000L;
+    }
+
+    return pthread_cond_timedwait(cond, mutex, &abstime) != ETIMEDOUT;
+}
+
+#if !MBED_CONF_LWIP_MBOX_LOCK_FREE
+/* Mailboxes on a mutex and condition variables, the lock-free ring is in
+ * lwip_sys_mbox.c */
+err_t sys_mbox_new(sys_mbox_t *mbox, int queue_sz) {
+    if (queue_sz > MB_SIZE)
+        error("sys_mbox_new size error\n");
+
+    memset(mbox, 0, sizeof(*mbox));
+    pthread_mutex_init(&mbox->mutex, NULL);
+    sys_cond_init(&mbox->not_empty);
+    sys_cond_init(&mbox->not_full);
+    mbox->valid = true;
+
+    return ERR_OK;
+}
+
+void sys_mbox_free(sys_mbox_t *mbox) {
+    if (mbox->post_idx != mbox->fetch_idx)
+        error("sys_mbox_free error\n");
+
+    pthread_cond_destroy(&mbox->not_full);
+    pthread_cond_destroy(&mbox->not_empty);
+    pthread_mutex_destroy(&mbox->mutex);
+}
+
+static void sys_mbox_put(sys_mbox_t *mbox, void *msg) {
+    mbox->queue[mbox->post_idx % MB_SIZE] = msg;
+    mbox->post_idx += 1;
+    pthread_cond_signal(&mbox->not_empty);
+}
+
+void sys_mbox_post(sys_mbox_t *mbox, void *msg) {
+    pthread_mutex_lock(&mbox->mutex);
+    while ((uint8_t)(mbox->post_idx - mbox->fetch_idx) >= MB_SIZE-1)
+        pthread_cond_wait(&mbox->not_full, &mbox->mutex);
+
+    sys_mbox_put(mbox, msg);
+    pthread_mutex_unlock(&mbox->mutex);
+}
+
+err_t sys_mbox_trypost(sys_mbox_t *mbox, void *msg) {
+    pthread_mutex_lock(&mbox->mutex);
+    if ((uint8_t)(mbox->post_idx - mbox->fetch_idx) >= MB_SIZE-1) {
+        pthread_mutex_unlock(&mbox->mutex);
+        return ERR_MEM;
+    }
+
+    sys_mbox_put(mbox, msg);
+    pthread_mutex_unlock(&mbox->mutex);
+    return ERR_OK;
+}
+
+static void sys_mbox_get(sys_mbox_t *mbox, void **msg) {
+    if (msg)
+        *msg = mbox->queue[mbox->fetch_idx % MB_SIZE];
+    mbox->fetch_idx += 1;
+    pthread_cond_signal(&mbox->not_full);
+}
+
+u32_t sys_arch_mbox_fetch(sys_mbox_t *mbox, void **msg, u32_t timeout) {
+    u32_t start = sys_now_ms();
+
+    pthread_mutex_lock(&mbox->mutex);
+    while (mbox->post_idx == mbox->fetch_idx) {
+        if (!sys_cond_wait(&mbox->not_empty, &mbox->mutex, timeout)) {
+            pthread_mutex_unlock(&mbox->mutex);
+            return SYS_ARCH_TIMEOUT;
+        }
+    }
+
+    sys_mbox_get(mbox, msg);
+    pthread_mutex_unlock(&mbox->mutex);
+    return sys_now_ms() - start;
+}
+
+u32_t sys_arch_mbox_tryfetch(sys_mbox_t *mbox, void **msg) {
+    pthread_mutex_lock(&mbox->mutex);
+    if (mbox->post_idx == mbox->fetch_idx) {
+        pthread_mutex_unlock(&mbox->mutex);
+        return SYS_MBOX_EMPTY;
+    }
+
+    sys_mbox_get(mbox, msg);
+    pthread_mutex_unlock(&mbox->mutex);
+    return ERR_OK;
+}
+#endif /* !MBED_CONF_LWIP_MBOX_LOCK_FREE */
+
+err_t sys_sem_new(sys_sem_t *sem, u8_t count) {
+    memset(sem, 0, sizeof(*sem));
+    pthread_mutex_init(&sem->mutex, NULL);
+    sys_cond_init(&sem->cond);
+    sem->count = count;
+    sem->valid = true;
+
+    return ERR_OK;
+}
+
+u32_t sys_arch_sem_wait(sys_sem_t *sem, u32_t timeout) {
+    u32_t start = sys_now_ms();
+
+    pthread_mutex_lock(&sem->mutex);
+    while (sem->count == 0) {
+        if (!sys_cond_wait(&sem->cond, &sem->mutex, timeout)) {
+            pthread_mutex_unlock(&sem->mutex);
+            return SYS_ARCH_TIMEOUT;
+        }
+    }
+    sem->count -= 1;
+    pthread_mutex_unlock(&sem->mutex);
+
+    return sys_now_ms() - start;
+}
+
+void sys_sem_signal(sys_sem_t *sem) {
+    pthread_mutex_lock(&sem->mutex);
+    sem->count += 1;
+    pthread_cond_signal(&sem->cond);
+    pthread_mutex_unlock(&sem->mutex);
+}
+
+void sys_sem_free(sys_sem_t *sem) {
+    pthread_cond_destroy(&sem->cond);
+    pthread_mutex_destroy(&sem->mutex);
+}
+
+err_t sys_mutex_new(sys_mutex_t *mutex) {
+    if (pthread_mutex_init(&mutex->mutex, NULL) != 0)
+        return ERR_MEM;
+
+    return ERR_OK;
+}
+
+void sys_mutex_lock(sys_mutex_t *mutex) {
+    if (pthread_mutex_lock(&mutex->mutex) != 0)
+        error("sys_mutex_lock error\n");
+}
+
+void sys_mutex_unlock(sys_mutex_t *mutex) {
+    if (pthread_mutex_unlock(&mutex->mutex) != 0)
+        error("sys_mutex_unlock error\n");
+}
+
+void sys_mutex_free(sys_mutex_t *mutex) {
+    pthread_mutex_destroy(&mutex->mutex);
+}
+
+/* sys_arch_protect() has to support nesting, so it uses a recursive mutex */
+static pthread_mutex_t lwip_sys_mutex;
+
+void sys_init(void) {
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+    if (pthread_mutex_init(&lwip_sys_mutex, &attr) != 0)
+        error("sys_init error\n");
+    pthread_mutexattr_destroy(&attr);
+}
+
+u32_t sys_jiffies(void) {
+    return sys_now_ms() / 10;
+}
+
+sys_prot_t sys_arch_protect(void) {
+    if (pthread_mutex_lock(&lwip_sys_mutex) != 0)
+        error("sys_arch_protect error\n");
+    return (sys_prot_t) 1;
+}
+
+void sys_arch_unprotect(sys_prot_t p) {
+    if (pthread_mutex_unlock(&lwip_sys_mutex) != 0)
+        error("sys_arch_unprotect error\n");
+}
+
+u32_t sys_now(void) {
+    return sys_now_ms();
+}
+
+void sys_msleep(u32_t ms) {
+    struct timespec delay = { ms / 1000, (ms % 1000) * 1000000L };
+    while (nanosleep(&delay, &delay) != 0 && errno == EINTR);
+}
+
+// Keep a pool of thread structures
+static int thread_pool_index = 0;
+static sys_thread_data_t thread_pool[SYS_THREAD_POOL_N];
+
+static void *sys_thread_entry(void *arg) {
+    sys_thread_t t = (sys_thread_t)arg;
+    t->thread(t->arg);
+    return NULL;
+}
+
+/* Stack size and priority are left to the host; lwIP's embedded stack
+ * sizes are far too small for a hosted C library. */
+sys_thread_t sys_thread_new(const char *pcName,
+                            void (*thread)(void *arg),
+                            void *arg, int stacksize, int priority) {
+    LWIP_DEBUGF(SYS_DEBUG, ("New Thread: %s\n", pcName));
+
+    sys_prot_t prot = sys_arch_protect();
+    if (thread_pool_index >= SYS_THREAD_POOL_N)
+        error("sys_thread_new number error\n");
+    sys_thread_t t = &thread_pool[thread_pool_index];
+    thread_pool_index++;
+    sys_arch_unprotect(prot);
+
+    t->thread = thread;
+    t->arg = arg;
+    if (pthread_create(&t->id, NULL, sys_thread_entry, t) != 0)
+        error("sys_thread_new create error\n");
+    pthread_detach(t->id);
+
+    return t;
+}
+
+#endif /* NO_SYS == 0 */
+
+#endif /* TARGET_LIKE_POSIX */
@@ -0,0 +1,295 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Lock-free ring implementation of the lwip mailboxes, selected with
+ * lwip.mbox-lock-free in place of the ones in lwip_sys_arch.c and
+ * lwip_sys_arch_posix.c.
+ *
+ * This is the bounded queue with a sequence number per slot: a slot whose
+ * sequence equals the post index is free for that post, one whose sequence
+ * is one past the fetch index holds the message for that fetch. Writers and
+ * readers claim their index with a compare-and-swap and then publish the
+ * slot's new sequence, so neither ever waits on a lock and posting from an
+ * interrupt is safe. The mailbox semaphores are only signalled when the
+ * other side has said it is about to sleep. */
+#include <string.h>
+#include <stdbool.h>
+
+#include "mbed_error.h"
+#include "mbed_critical.h"
+
+#include "lwip/opt.h"
+#include "lwip/sys.h"
+
+#if NO_SYS == 0 && MBED_CONF_LWIP_MBOX_LOCK_FREE
+#include "arch/sys_arch.h"
+
+#define MB_MASK     ((MB_SIZE) - 1)
+
+static u32_t sys_mbox_load(const u32_t *ptr) {
+    return *(const volatile u32_t *)ptr;
+}
+
+/* A compare-and-swap that cannot fail, for the barrier that comes with it */
+static void sys_mbox_store(u32_t *ptr, u32_t value) {
+    u32_t current = sys_mbox_load(ptr);
+    while (!core_util_atomic_cas_u32(ptr, &current, value));
+}
+
+/* Wake up to count writers waiting on a full mailbox */
+static void sys_mbox_wake_posters(sys_mbox_t *mbox, u32_t count) {
+    u32_t waiting = sys_mbox_load(&mbox->post_waiting);
+    while (waiting > 0 && count > 0) {
+        if (core_util_atomic_cas_u32(&mbox->post_waiting, &waiting, waiting - 1)) {
+            sys_sem_signal(&mbox->post_sem);
+            waiting -= 1;
+            count -= 1;
+        }
+    }
+}
+
+/* Claim a slot and publish msg in it, returns false if the mailbox is full */
+static bool sys_mbox_put(sys_mbox_t *mbox, void *msg) {
+    u32_t pos = sys_mbox_load(&mbox->post_idx);
+    sys_mbox_slot_t *slot;
+
+    while (true) {
+        slot = &mbox->slots[pos & MB_MASK];
+        s32_t diff = (s32_t)(sys_mbox_load(&slot->seq) - pos);
+        if (diff == 0) {
+            if (core_util_atomic_cas_u32(&mbox->post_idx, &pos, pos + 1))
+                break;
+        } else if (diff < 0) {
+            return false;
+        } else {
+            pos = sys_mbox_load(&mbox->post_idx);
+        }
+    }
+
+    slot->msg = msg;
+    sys_mbox_store(&slot->seq, pos + 1);
+
+    u32_t waiting = 1;
+    if (core_util_atomic_cas_u32(&mbox->fetch_waiting, &waiting, 0))
+        sys_sem_signal(&mbox->fetch_sem);
+
+    return true;
+}
+
+/* Take up to count messages that are ready in order, msgs may be NULL to
+ * drop a single message. Returns the number taken. */
+static u32_t sys_mbox_get(sys_mbox_t *mbox, void **msgs, u32_t count) {
+    u32_t pos = sys_mbox_load(&mbox->fetch_idx);
+    u32_t n;
+
+    while (true) {
+        for (n = 0; n < count; n++) {
+            sys_mbox_slot_t *slot = &mbox->slots[(pos + n) & MB_MASK];
+            if (sys_mbox_load(&slot->seq) != pos + n + 1)
+                break;
+        }
+
+        if (n == 0) {
+            s32_t diff = (s32_t)(sys_mbox_load(&mbox->slots[pos & MB_MASK].seq) - (pos + 1));
+            if (diff < 0)
+                return 0;
+
+            /* Another reader got there first */
+            pos = sys_mbox_load(&mbox->fetch_idx);
+        } else if (core_util_atomic_cas_u32(&mbox->fetch_idx, &pos, pos + n)) {
+            break;
+        }
+    }
+
+    for (u32_t i = 0; i < n; i++) {
+        sys_mbox_slot_t *slot = &mbox->slots[(pos + i) & MB_MASK];
+        if (msgs)
+            msgs[i] = slot->msg;
+        sys_mbox_store(&slot->seq, pos + i + MB_SIZE);
+    }
+
+    sys_mbox_wake_posters(mbox, n);
+    return n;
+}
+
+/*---------------------------------------------------------------------------*
+ * Routine:  sys_mbox_new
+ *---------------------------------------------------------------------------*
+ * Description:
+ *      Creates a new mailbox
+ * Inputs:
+ *      sys_mbox_t mbox         -- Handle of mailbox
+ *      int queue_sz            -- Size of elements in the mailbox
+ * Outputs:
+ *      err_t                   -- ERR_OK if message posted, else ERR_MEM
+ *---------------------------------------------------------------------------*/
+err_t sys_mbox_new(sys_mbox_t *mbox, int queue_sz) {
+    if (queue_sz > MB_SIZE)
+        error("sys_mbox_new size error\n");
+
+    memset(mbox, 0, sizeof(*mbox));
+    for (u32_t i = 0; i < MB_SIZE; i++)
+        mbox->slots[i].seq = i;
+
+    if (sys_sem_new(&mbox->post_sem, 0) != ERR_OK ||
+        sys_sem_new(&mbox->fetch_sem, 0) != ERR_OK)
+        error("sys_mbox_new create error\n");
+
+    return ERR_OK;
+}
+
+/*---------------------------------------------------------------------------*
+ * Routine:  sys_mbox_free
+ *---------------------------------------------------------------------------*
+ * Description:
+ *      Deallocates a mailbox. If there are messages still present in the
+ *      mailbox when the mailbox is deallocated, it is an indication of a
+ *      programming error in lwIP and the developer should be notified.
+ * Inputs:
+ *      sys_mbox_t *mbox         -- Handle of mailbox
+ *---------------------------------------------------------------------------*/
+void sys_mbox_free(sys_mbox_t *mbox) {
+    if (mbox->post_idx != mbox->fetch_idx)
+        error("sys_mbox_free error\n");
+
+    sys_sem_free(&mbox->fetch_sem);
+    sys_sem_free(&mbox->post_sem);
+}
+
+/*---------------------------------------------------------------------------*
+ * Routine:  sys_mbox_post
+ *---------------------------------------------------------------------------*
+ * Description:
+ *      Post the "msg" to the mailbox, waiting for room if it is full.
+ *      The writer counts itself in post_waiting before its last look, so
+ *      a reader that makes room after that look knows to wake it.
+ * Inputs:
+ *      sys_mbox_t mbox        -- Handle of mailbox
+ *      void *msg              -- Pointer to data to post
+ *---------------------------------------------------------------------------*/
+void sys_mbox_post(sys_mbox_t *mbox, void *msg) {
+    while (!sys_mbox_put(mbox, msg)) {
+        core_util_atomic_incr_u32(&mbox->post_waiting, 1);
+
+        if (sys_mbox_put(mbox, msg)) {
+            /* Not waiting after all, a reader may have woken us already
+             * and the spare signal only costs someone a second look */
+            u32_t waiting = sys_mbox_load(&mbox->post_waiting);
+            while (waiting > 0 &&
+                   !core_util_atomic_cas_u32(&mbox->post_waiting, &waiting, waiting - 1));
+            return;
+        }
+
+        sys_arch_sem_wait(&mbox->post_sem, 0);
+    }
+}
+
+/*---------------------------------------------------------------------------*
+ * Routine:  sys_mbox_trypost
+ *---------------------------------------------------------------------------*
+ * Description:
+ *      Try to post the "msg" to the mailbox.  Returns immediately with
+ *      error if cannot.
+ * Inputs:
+ *      sys_mbox_t mbox         -- Handle of mailbox
+ *      void *msg               -- Pointer to data to post
+ * Outputs:
+ *      err_t                   -- ERR_OK if message posted, else ERR_MEM
+ *                                  if not.
+ *---------------------------------------------------------------------------*/
+err_t sys_mbox_trypost(sys_mbox_t *mbox, void *msg) {
+    return sys_mbox_put(mbox, msg) ? ERR_OK : ERR_MEM;
+}
+
+/*---------------------------------------------------------------------------*
+ * Routine:  sys_arch_mbox_fetch
+ *---------------------------------------------------------------------------*
+ * Description:
+ *      Blocks the thread until a message arrives in the mailbox, but does
+ *      not block the thread longer than "timeout" milliseconds (0 waits
+ *      forever). The "msg" parameter maybe NULL to indicate that the
+ *      message should be dropped.
+ *
+ *      The reader raises fetch_waiting before its last look, so a writer
+ *      that posts after that look knows to signal. Signals left over from
+ *      a look that found a message just cause one extra pass of the loop.
+ * Inputs:
+ *      sys_mbox_t mbox         -- Handle of mailbox
+ *      void **msg              -- Pointer to pointer to msg received
+ *      u32_t timeout           -- Number of milliseconds until timeout
+ * Outputs:
+ *      u32_t                   -- SYS_ARCH_TIMEOUT if timeout, else number
+ *                                  of milliseconds until received.
+ *---------------------------------------------------------------------------*/
+u32_t sys_arch_mbox_fetch(sys_mbox_t *mbox, void **msg, u32_t timeout) {
+    u32_t start = sys_now();
+
+    while (!sys_mbox_get(mbox, msg, 1)) {
+        sys_mbox_store(&mbox->fetch_waiting, 1);
+        if (sys_mbox_get(mbox, msg, 1)) {
+            sys_mbox_store(&mbox->fetch_waiting, 0);
+            break;
+        }
+
+        u32_t elapsed = sys_now() - start;
+        if (timeout && elapsed >= timeout)
+            return SYS_ARCH_TIMEOUT;
+
+        if (sys_arch_sem_wait(&mbox->fetch_sem,
+                timeout ? timeout - elapsed : 0) == SYS_ARCH_TIMEOUT)
+            return SYS_ARCH_TIMEOUT;
+    }
+
+    return sys_now() - start;
+}
+
+/*---------------------------------------------------------------------------*
+ * Routine:  sys_arch_mbox_tryfetch
+ *---------------------------------------------------------------------------*
+ * Description:
+ *      Similar to sys_arch_mbox_fetch, but if message is not ready
+ *      immediately, we'll return with SYS_MBOX_EMPTY.  On success, 0 is
+ *      returned.
+ * Inputs:
+ *      sys_mbox_t mbox         -- Handle of mailbox
+ *      void **msg              -- Pointer to pointer to msg received
+ * Outputs:
+ *      u32_t                   -- SYS_MBOX_EMPTY if no messages.  Otherwise,
+ *                                  return ERR_OK.
+ *---------------------------------------------------------------------------*/
+u32_t sys_arch_mbox_tryfetch(sys_mbox_t *mbox, void **msg) {
+    return sys_mbox_get(mbox, msg, 1) ? ERR_OK : SYS_MBOX_EMPTY;
+}
+
+/*---------------------------------------------------------------------------*
+ * Routine:  sys_arch_mbox_tryfetch_batch
+ *---------------------------------------------------------------------------*
+ * Description:
+ *      Takes every message that is ready, up to "count", with a single
+ *      claim on the mailbox. Used by the tcpip thread to work through a
+ *      burst without a trip through its timeouts for each message.
+ * Inputs:
+ *      sys_mbox_t mbox         -- Handle of mailbox
+ *      void **msgs             -- Array of at least count messages
+ *      u32_t count             -- Maximum number of messages to take
+ * Outputs:
+ *      u32_t                   -- Number of messages taken
+ *---------------------------------------------------------------------------*/
+u32_t sys_arch_mbox_tryfetch_batch(sys_mbox_t *mbox, void **msgs, u32_t count) {
+    return sys_mbox_get(mbox, msgs, count);
+}
+
+#endif /* NO_SYS == 0 && MBED_CONF_LWIP_MBOX_LOCK_FREE */
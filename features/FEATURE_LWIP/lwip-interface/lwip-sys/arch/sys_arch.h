@@ -19,11 +19,68 @@
 #define __ARCH_SYS_ARCH_H__
 
 #include "lwip/opt.h"
+#if !defined(TARGET_LIKE_POSIX)
 #include "mbed_rtos_storage.h"
+#endif
 
 extern u8_t lwip_ram_heap[];
 
-#if NO_SYS == 0
+// Messages each mailbox holds
+#define MB_SIZE      MBED_CONF_LWIP_MBOX_SIZE
+
+#if NO_SYS == 0 && defined(TARGET_LIKE_POSIX)
+/* pthreads implementation used for host builds of the stack */
+#include <stdbool.h>
+#include <pthread.h>
+
+// === SEMAPHORE ===
+typedef struct {
+    pthread_mutex_t mutex;
+    pthread_cond_t  cond;
+    uint32_t        count;
+    bool            valid;
+} sys_sem_t;
+
+#define sys_sem_valid(x)        ((*x).valid)
+#define sys_sem_set_invalid(x)  ( (*x).valid = false)
+
+// === MUTEX ===
+typedef struct {
+    pthread_mutex_t mutex;
+} sys_mutex_t;
+
+// === MAIL BOX ===
+#if !MBED_CONF_LWIP_MBOX_LOCK_FREE
+typedef struct {
+    pthread_mutex_t mutex;
+    pthread_cond_t  not_empty;
+    pthread_cond_t  not_full;
+    bool            valid;
+
+    uint8_t     post_idx;
+    uint8_t     fetch_idx;
+    void*       queue[MB_SIZE];
+} sys_mbox_t;
+
+#define SYS_MBOX_NULL               ((uint32_t) NULL)
+#define sys_mbox_valid(x)           ((*x).valid)
+#define sys_mbox_set_invalid(x)     ( (*x).valid = false)
+#endif
+
+// === THREAD ===
+typedef struct {
+    pthread_t   id;
+    void      (*thread)(void *arg);
+    void       *arg;
+} sys_thread_data_t;
+typedef sys_thread_data_t* sys_thread_t;
+
+#define SYS_THREAD_POOL_N                   6
+
+// === PROTECTION ===
+typedef int sys_prot_t;
+
+#elif NO_SYS == 0
 #include "cmsis_os2.h"
 
 // === SEMAPHORE ===
@@ -44,8 +101,7 @@ typedef struct {
 } sys_mutex_t;
 
 // === MAIL BOX ===
-#define MB_SIZE      8
-
+#if !MBED_CONF_LWIP_MBOX_LOCK_FREE
 typedef struct {
     osEventFlagsId_t                id;
     osEventFlagsAttr_t              attr;
@@ -62,13 +118,6 @@ typedef struct {
 #define SYS_MBOX_NULL               ((uint32_t) NULL)
 #define sys_mbox_valid(x)           (((*x).id == NULL) ? 0 : 1)
 #define sys_mbox_set_invalid(x)     ( (*x).id = NULL)
-
-#if ((DEFAULT_RAW_RECVMBOX_SIZE) > (MB_SIZE)) || \
-    ((DEFAULT_UDP_RECVMBOX_SIZE) > (MB_SIZE)) || \
-    ((DEFAULT_TCP_RECVMBOX_SIZE) > (MB_SIZE)) || \
-    ((DEFAULT_ACCEPTMBOX_SIZE)   > (MB_SIZE)) || \
-    ((TCPIP_MBOX_SIZE)           > (MB_SIZE))
-#   error Mailbox size not supported
 #endif
 
 // === THREAD ===
@@ -122,4 +171,65 @@ void osDelay(uint32_t ms);
 #endif
 #endif
 
+#if NO_SYS == 0
+#if MBED_CONF_LWIP_MBOX_LOCK_FREE
+/* Lock-free ring mailbox (lwip_sys_mbox.c). Each slot carries a sequence
+ * number that tells writers and readers whose turn it is, so posting and
+ * fetching are a compare-and-swap each. The semaphores are only touched to
+ * wake a reader waiting on an empty mailbox or a writer waiting on a full
+ * one. */
+typedef struct {
+    u32_t       seq;
+    void*       msg;
+} sys_mbox_slot_t;
+
+typedef struct {
+    u32_t       post_idx;
+    u32_t       fetch_idx;
+    u32_t       fetch_waiting;
+    u32_t       post_waiting;
+    sys_sem_t   fetch_sem;
+    sys_sem_t   post_sem;
+    sys_mbox_slot_t slots[MB_SIZE];
+} sys_mbox_t;
+
+#define SYS_MBOX_NULL               ((uint32_t) NULL)
+#define sys_mbox_valid(x)           sys_sem_valid(&(*x).fetch_sem)
+#define sys_mbox_set_invalid(x)     sys_sem_set_invalid(&(*x).fetch_sem)
+
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+/** Take up to count messages without blocking
+ *
+ * @param mbox  Mailbox to fetch from
+ * @param msgs  Where to store the messages
+ * @param count Maximum number of messages to take
+ * @return      Number of messages taken, 0 if the mailbox was empty
+ */
+u32_t sys_arch_mbox_tryfetch_batch(sys_mbox_t *mbox, void **msgs, u32_t count);
+
+#ifdef  __cplusplus
+}
+#endif
+#endif
+
+#if (MB_SIZE) & ((MB_SIZE) - 1)
+#   error Mailbox size must be a power of two
+#endif
+
+#if !MBED_CONF_LWIP_MBOX_LOCK_FREE && (MB_SIZE) > 128
+#   error Mailbox size not supported
+#endif
+
+#if ((DEFAULT_RAW_RECVMBOX_SIZE) > (MB_SIZE)) || \
+    ((DEFAULT_UDP_RECVMBOX_SIZE) > (MB_SIZE)) || \
+    ((DEFAULT_TCP_RECVMBOX_SIZE) > (MB_SIZE)) || \
+    ((DEFAULT_ACCEPTMBOX_SIZE)   > (MB_SIZE)) || \
+    ((TCPIP_MBOX_SIZE)           > (MB_SIZE))
+#   error Mailbox size not supported
+#endif
+#endif
+
 #endif /* __ARCH_SYS_ARCH_H__ */
@@ -0,0 +1,60 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "lwip_memp_grow.h"
+#include "lwip/opt.h"
+#include "lwip/memp.h"
+#include "lwip/priv/tcp_priv.h"
+#include <stdlib.h>
+
+#if MBED_CONF_LWIP_SOCKET_GROW > 0 && !MEMP_MEM_MALLOC
+
+int mbed_lwip_memp_grow(int type)
+{
+    switch (type) {
+        case MEMP_NETCONN:
+#if LWIP_UDP
+        case MEMP_UDP_PCB:
+#endif
+#if LWIP_TCP
+        case MEMP_TCP_PCB_LISTEN:
+#endif
+            break;
+#if LWIP_TCP
+        case MEMP_TCP_PCB:
+            // Only called from the tcpip thread. tcp_alloc reclaims the
+            // oldest TIME_WAIT pcb when this fails, which is cheaper than
+            // growing and keeps a busy server within its configured pool
+            if (tcp_tw_pcbs) {
+                return 0;
+            }
+            break;
+#endif
+        default:
+            return 0;
+    }
+
+    mem_size_t size = MBED_CONF_LWIP_SOCKET_GROW * memp_pool_element_size((memp_t)type)
+                    + MEM_ALIGNMENT - 1;
+    void *mem = malloc(size);
+    if (!mem) {
+        return 0;
+    }
+
+    return memp_pool_extend((memp_t)type, mem, size) > 0;
+}
+
+#endif
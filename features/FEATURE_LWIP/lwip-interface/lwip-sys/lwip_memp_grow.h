@@ -0,0 +1,41 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LWIP_HDR_MEMP_GROW_H
+#define LWIP_HDR_MEMP_GROW_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Grow an exhausted memory pool from the heap
+ *
+ *  Called by memp_malloc through LWIP_HOOK_MEMP_EMPTY when a pool runs
+ *  dry. Only the pools behind sockets (netconns and PCBs) are grown, by
+ *  MBED_CONF_LWIP_SOCKET_GROW elements at a time. The memory is never
+ *  returned to the heap.
+ *
+ *  @param type     The memp_t of the exhausted pool
+ *  @return         Non-zero if the pool was grown and the allocation
+ *                  should be retried
+ */
+int mbed_lwip_memp_grow(int type);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LWIP_HDR_MEMP_GROW_H */
@@ -258,6 +258,69 @@ memp_init_pool(const struct memp_desc *desc)
 #endif /* MEMP_STATS && (defined(LWIP_DEBUG) || LWIP_STATS_DISPLAY) */
 }
 
+#if !MEMP_MEM_MALLOC
+/**
+ * mbed: Size of one element of a built-in pool, including the overflow
+ * check regions, as laid out by memp_pool_extend.
+ *
+ * @param type the pool to query
+ * @return the size in bytes of one element
+ */
+mem_size_t
+memp_pool_element_size(memp_t type)
+{
+  return MEMP_SIZE + memp_pools[type]->size
+#if MEMP_OVERFLOW_CHECK
+    + MEMP_SANITY_REGION_AFTER_ALIGNED
+#endif
+    ;
+}
+
+/**
+ * mbed: Add elements carved out of caller-provided memory to a built-in
+ * pool. The memory is owned by the pool from then on and is never handed
+ * back, so this is meant for growing a pool on demand from the heap.
+ *
+ * @param type the pool to extend
+ * @param mem memory for the new elements, need not be aligned
+ * @param size size of mem in bytes
+ * @return the number of elements added
+ */
+u16_t
+memp_pool_extend(memp_t type, void *mem, mem_size_t size)
+{
+  const struct memp_desc *desc;
+  mem_size_t element;
+  struct memp *memp;
+  u8_t *end;
+  u16_t count = 0;
+  SYS_ARCH_DECL_PROTECT(old_level);
+
+  LWIP_ERROR("memp_pool_extend: type < MEMP_MAX", (type < MEMP_MAX), return 0;);
+  desc = memp_pools[type];
+  element = memp_pool_element_size(type);
+  memp = (struct memp*)LWIP_MEM_ALIGN(mem);
+  end = (u8_t *)mem + size;
+
+  SYS_ARCH_PROTECT(old_level);
+  while ((u8_t *)memp + element <= end) {
+    memp->next = *desc->tab;
+    *desc->tab = memp;
+#if MEMP_OVERFLOW_CHECK
+    memp_overflow_init_element(memp, desc);
+#endif /* MEMP_OVERFLOW_CHECK */
+    memp = (struct memp *)(void *)((u8_t *)memp + element);
+    count++;
+  }
+#if MEMP_STATS
+  desc->stats->avail += count;
+#endif /* MEMP_STATS */
+  SYS_ARCH_UNPROTECT(old_level);
+
+  return count;
+}
+#endif /* !MEMP_MEM_MALLOC */
+
 /**
  * Initializes lwIP built-in pools.
  * Related functions: memp_malloc, memp_free
@@ -397,6 +460,22 @@ memp_malloc_fn(memp_t type, const char* file, const int line)
   memp = do_memp_malloc_pool_fn(memp_pools[type], file, line);
 #endif
 
+#ifdef LWIP_HOOK_MEMP_EMPTY
+  /* mbed: give the port a chance to extend an exhausted pool (see
+     memp_pool_extend) and retry once before reporting the failure */
+  if (memp == NULL && LWIP_HOOK_MEMP_EMPTY(type)) {
+#if !MEMP_OVERFLOW_CHECK
+    memp = do_memp_malloc_pool(memp_pools[type]);
+#else
+    memp = do_memp_malloc_pool_fn(memp_pools[type], file, line);
+#endif
+    if (memp != NULL) {
+      /* adjust err stats: the first attempt failed */
+      MEMP_STATS_DEC(err, type);
+    }
+  }
+#endif /* LWIP_HOOK_MEMP_EMPTY */
+
   return memp;
 }
 
@@ -353,6 +353,9 @@ pbuf_alloc(pbuf_layer layer, u16_t length, pbuf_type type)
     /* If pbuf is to be allocated in RAM, allocate memory for it. */
     p = (struct pbuf*)mem_malloc(LWIP_MEM_ALIGN_SIZE(SIZEOF_STRUCT_PBUF + offset) + LWIP_MEM_ALIGN_SIZE(length));
     if (p == NULL) {
+      /* mbed: most EMAC drivers receive into the heap rather than the pool,
+         so reclaim out-of-sequence segments when it runs out too */
+      PBUF_POOL_IS_EMPTY();
       return NULL;
     }
     /* Set up internal structure of the pbuf. */
@@ -232,6 +232,9 @@ struct netconn {
 #if LWIP_SOCKET
   int socket;
 #endif /* LWIP_SOCKET */
+  /** mbed: opaque pointer for the owner of the netconn, so callbacks can
+      find their state without searching for it */
+  void *callback_arg;
 #if LWIP_SO_SNDTIMEO
   /** timeout to wait for sending data (which means enqueueing data for sending
       in internal buffers) in milliseconds */
@@ -364,6 +367,11 @@ err_t   netconn_gethostbyname(const char *name, ip_addr_t *addr);
 #define netconn_get_ipv6only(conn)        (((conn)->flags & NETCONN_FLAG_IPV6_V6ONLY) != 0)
 #endif /* LWIP_IPV6 */
 
+/** mbed: Set the opaque pointer passed back to the owner of the netconn */
+#define netconn_set_callback_arg(conn, arg)  ((conn)->callback_arg = (arg))
+/** mbed: Get the opaque pointer set with netconn_set_callback_arg */
+#define netconn_get_callback_arg(conn)       ((conn)->callback_arg)
+
 #if LWIP_SO_SNDTIMEO
 /** Set the send timeout in milliseconds */
 #define netconn_set_sendtimeout(conn, timeout)      ((conn)->send_timeout = (timeout))
@@ -146,6 +146,12 @@ void *memp_malloc(memp_t type);
 #endif
 void  memp_free(memp_t type, void *mem);
 
+#if !MEMP_MEM_MALLOC
+/* mbed: growing built-in pools at runtime */
+mem_size_t memp_pool_element_size(memp_t type);
+u16_t memp_pool_extend(memp_t type, void *mem, mem_size_t size);
+#endif /* !MEMP_MEM_MALLOC */
+
 #ifdef __cplusplus
 }
 #endif
@@ -19,6 +19,7 @@
 #include "mbed_assert.h"
 #include <stdio.h>
 #include <stdbool.h>
+#include <stdlib.h>
 #include <string.h>
 #include "lwip_stack.h"
 
@@ -30,10 +31,12 @@
 #include "lwip/dhcp.h"
 #include "lwip/tcpip.h"
 #include "lwip/tcp.h"
+#include "lwip/priv/tcp_priv.h"
 #include "lwip/ip.h"
 #include "lwip/mld6.h"
 #include "lwip/dns.h"
 #include "lwip/udp.h"
+#include "lwip/stats.h"
 #include "netif/lwip_ethernet.h"
 #include "emac_api.h"
 #include "ppp_lwip.h"
@@ -49,8 +52,14 @@ static nsapi_error_t mbed_lwip_err_remap(err_t err);
 
 #define DHCP_TIMEOUT 15000
 
-/* Static arena of sockets */
+#ifndef MBED_CONF_LWIP_TCP_SEND_REF_MAX
+#define MBED_CONF_LWIP_TCP_SEND_REF_MAX 4
+#endif
+
+/* Arena of sockets, a static block that grows from the heap by
+ * MBED_CONF_LWIP_SOCKET_GROW at a time once it runs out */
 static struct lwip_socket {
+    struct lwip_socket *next;
     bool in_use;
 
     struct netconn *conn;
@@ -59,6 +68,17 @@ static struct lwip_socket {
 
     void (*cb)(void *);
     void *data;
+
+#if LWIP_TCP
+    /* Buffers lent by send_ref, in the order they were sent */
+    struct lwip_send_ref {
+        u32_t seqno;
+        void (*cb)(void *);
+        void *context;
+    } send_ref[MBED_CONF_LWIP_TCP_SEND_REF_MAX];
+    u8_t send_ref_head;
+    u8_t send_ref_count;
+#endif
 } lwip_arena[MEMP_NUM_NETCONN];
 
 static bool lwip_inited = false;
@@ -66,29 +86,126 @@ static bool lwip_connected = false;
 static bool netif_inited = false;
 static bool netif_is_ppp = false;
 
+static struct lwip_socket *lwip_arena_free;
+static bool lwip_arena_inited = false;
+static mbed_lwip_pool_stats_t lwip_arena_stats;
+
+/* Called with the arena protected */
+static void mbed_lwip_arena_add(struct lwip_socket *block, int count)
+{
+    for (int i = count - 1; i >= 0; i--) {
+        block[i].in_use = false;
+        block[i].next = lwip_arena_free;
+        lwip_arena_free = &block[i];
+    }
+
+    lwip_arena_stats.avail += count;
+}
+
 static struct lwip_socket *mbed_lwip_arena_alloc(void)
 {
     sys_prot_t prot = sys_arch_protect();
 
-    for (int i = 0; i < MEMP_NUM_NETCONN; i++) {
-        if (!lwip_arena[i].in_use) {
-            struct lwip_socket *s = &lwip_arena[i];
-            memset(s, 0, sizeof *s);
-            s->in_use = true;
-            sys_arch_unprotect(prot);
-            return s;
+    if (!lwip_arena_inited) {
+        mbed_lwip_arena_add(lwip_arena, MEMP_NUM_NETCONN);
+        lwip_arena_inited = true;
+    }
+
+#if MBED_CONF_LWIP_SOCKET_GROW > 0
+    if (!lwip_arena_free) {
+        sys_arch_unprotect(prot);
+        struct lwip_socket *block = malloc(MBED_CONF_LWIP_SOCKET_GROW * sizeof *block);
+        prot = sys_arch_protect();
+
+        if (block) {
+            mbed_lwip_arena_add(block, MBED_CONF_LWIP_SOCKET_GROW);
         }
     }
+#endif
+
+    struct lwip_socket *s = lwip_arena_free;
+    if (!s) {
+        lwip_arena_stats.err++;
+        sys_arch_unprotect(prot);
+        return 0;
+    }
+
+    lwip_arena_free = s->next;
+    memset(s, 0, sizeof *s);
+    s->in_use = true;
+
+    lwip_arena_stats.used++;
+    if (lwip_arena_stats.used > lwip_arena_stats.max) {
+        lwip_arena_stats.max = lwip_arena_stats.used;
+    }
 
     sys_arch_unprotect(prot);
-    return 0;
+    return s;
 }
 
 static void mbed_lwip_arena_dealloc(struct lwip_socket *s)
 {
+    sys_prot_t prot = sys_arch_protect();
+
     s->in_use = false;
+    s->next = lwip_arena_free;
+    lwip_arena_free = s;
+    lwip_arena_stats.used--;
+
+    sys_arch_unprotect(prot);
 }
 
+/* Find the socket that owns a netconn, if it still does */
+static struct lwip_socket *mbed_lwip_arena_find(struct netconn *nc)
+{
+    struct lwip_socket *s = netconn_get_callback_arg(nc);
+    if (s && s->in_use && s->conn == nc) {
+        return s;
+    }
+
+    return 0;
+}
+
+#if LWIP_TCP
+/* The netconn's own sent callback, chained to from mbed_lwip_socket_sent */
+static tcp_sent_fn mbed_lwip_netconn_sent;
+
+/* Hand back lent buffers that the remote host has acknowledged, or all of
+ * them once the connection is gone. Called with the TCP/IP core locked. */
+static void mbed_lwip_send_ref_complete(struct lwip_socket *s, bool all)
+{
+    struct tcp_pcb *pcb = s->conn->pcb.tcp;
+    bool completed = false;
+
+    while (s->send_ref_count) {
+        struct lwip_send_ref ref = s->send_ref[s->send_ref_head];
+        if (!all && pcb && TCP_SEQ_LT(pcb->lastack, ref.seqno)) {
+            break;
+        }
+
+        s->send_ref_head = (s->send_ref_head + 1) % MBED_CONF_LWIP_TCP_SEND_REF_MAX;
+        s->send_ref_count--;
+        ref.cb(ref.context);
+        completed = true;
+    }
+
+    // Wake up any sender waiting for a free slot
+    if (completed && s->cb) {
+        s->cb(s->data);
+    }
+}
+
+static err_t mbed_lwip_socket_sent(void *arg, struct tcp_pcb *pcb, u16_t len)
+{
+    struct lwip_socket *s = mbed_lwip_arena_find((struct netconn *)arg);
+    if (s && s->send_ref_count) {
+        mbed_lwip_send_ref_complete(s, false);
+    }
+
+    return mbed_lwip_netconn_sent(arg, pcb, len);
+}
+#endif
+
 static void mbed_lwip_socket_callback(struct netconn *nc, enum netconn_evt eh, u16_t len)
 {
     // Filter send minus events
@@ -98,15 +215,23 @@ static void mbed_lwip_socket_callback(struct netconn *nc, enum netconn_evt eh, u
 
     sys_prot_t prot = sys_arch_protect();
 
-    for (int i = 0; i < MEMP_NUM_NETCONN; i++) {
-        if (lwip_arena[i].in_use
-            && lwip_arena[i].conn == nc
-            && lwip_arena[i].cb) {
-            lwip_arena[i].cb(lwip_arena[i].data);
-        }
+    struct lwip_socket *s = mbed_lwip_arena_find(nc);
+    if (s && s->cb) {
+        s->cb(s->data);
     }
 
     sys_arch_unprotect(prot);
+
+#if LWIP_TCP
+    // A failed connection has already freed its queued segments, so hand
+    // back any buffers lent to it. Errors come from the TCP/IP thread.
+    if (eh == NETCONN_EVT_ERROR && !nc->pcb.tcp) {
+        s = mbed_lwip_arena_find(nc);
+        if (s && s->send_ref_count) {
+            mbed_lwip_send_ref_complete(s, true);
+        }
+    }
+#endif
 }
 
 
@@ -479,7 +604,13 @@ nsapi_error_t mbed_lwip_emac_init(emac_interface_t *emac)
 nsapi_error_t mbed_lwip_init(emac_interface_t *emac)
 {
     mbed_lwip_core_init();
-    return mbed_lwip_emac_init(emac);
+
+    nsapi_error_t ret = mbed_lwip_emac_init(emac);
+    if (ret == NSAPI_ERROR_OK) {
+        netif_inited = true;
+    }
+
+    return ret;
 }
 
 // Backwards compatibility with people using DEVICE_EMAC
@@ -808,6 +939,7 @@ static nsapi_error_t mbed_lwip_socket_open(nsapi_stack_t *stack, nsapi_socket_t
         return NSAPI_ERROR_NO_SOCKET;
     }
 
+    netconn_set_callback_arg(s->conn, s);
     netconn_set_recvtimeout(s->conn, 1);
     *(struct lwip_socket **)handle = s;
     return 0;
@@ -818,6 +950,21 @@ static nsapi_error_t mbed_lwip_socket_close(nsapi_stack_t *stack, nsapi_socket_t
     struct lwip_socket *s = (struct lwip_socket *)handle;
 
     netbuf_delete(s->buf);
+
+#if LWIP_TCP
+    // Lent buffers can only be handed back once lwIP has dropped every
+    // reference to them, so abort rather than linger on the remote host
+    if (s->send_ref_count) {
+        LOCK_TCPIP_CORE();
+        if (s->conn->pcb.tcp) {
+            tcp_abort(s->conn->pcb.tcp);
+        }
+        mbed_lwip_send_ref_complete(s, true);
+        UNLOCK_TCPIP_CORE();
+    }
+#endif
+
+    netconn_set_callback_arg(s->conn, NULL);
     err_t err = netconn_delete(s->conn);
     mbed_lwip_arena_dealloc(s);
     return mbed_lwip_err_remap(err);
@@ -882,6 +1029,7 @@ static nsapi_error_t mbed_lwip_socket_accept(nsapi_stack_t *stack, nsapi_socket_
         return mbed_lwip_err_remap(err);
     }
 
+    netconn_set_callback_arg(ns->conn, ns);
     netconn_set_recvtimeout(ns->conn, 1);
     *(struct lwip_socket **)handle = ns;
 
@@ -907,17 +1055,65 @@ static nsapi_size_or_error_t mbed_lwip_socket_send(nsapi_stack_t *stack, nsapi_s
     return (nsapi_size_or_error_t)bytes_written;
 }
 
-static nsapi_size_or_error_t mbed_lwip_socket_recv(nsapi_stack_t *stack, nsapi_socket_t handle, void *data, nsapi_size_t size)
+/* Fetch the next netbuf into the socket unless one is already held */
+static err_t mbed_lwip_socket_fill(struct lwip_socket *s)
+{
+    if (s->buf) {
+        return ERR_OK;
+    }
+
+    s->offset = 0;
+    return netconn_recv(s->conn, &s->buf);
+}
+
+#if LWIP_TCP
+static nsapi_size_or_error_t mbed_lwip_socket_send_ref(nsapi_stack_t *stack, nsapi_socket_t handle, const void *data, nsapi_size_t size, void (*callback)(void *), void *context)
 {
     struct lwip_socket *s = (struct lwip_socket *)handle;
+    size_t bytes_written = 0;
+
+    if (callback && s->send_ref_count == MBED_CONF_LWIP_TCP_SEND_REF_MAX) {
+        return NSAPI_ERROR_WOULD_BLOCK;
+    }
 
-    if (!s->buf) {
-        err_t err = netconn_recv(s->conn, &s->buf);
-        s->offset = 0;
+    err_t err = netconn_write_partly(s->conn, data, size, NETCONN_NOCOPY | NETCONN_DONTBLOCK, &bytes_written);
+    if (err != ERR_OK) {
+        return mbed_lwip_err_remap(err);
+    }
 
-        if (err != ERR_OK) {
-            return mbed_lwip_err_remap(err);
+    if (callback) {
+        // Only this thread queues data, so the end of the send buffer is
+        // the end of this write
+        LOCK_TCPIP_CORE();
+        struct tcp_pcb *pcb = s->conn->pcb.tcp;
+        struct lwip_send_ref *ref = &s->send_ref[
+                (s->send_ref_head + s->send_ref_count) % MBED_CONF_LWIP_TCP_SEND_REF_MAX];
+        ref->seqno = pcb ? pcb->snd_lbb : 0;
+        ref->cb = callback;
+        ref->context = context;
+        s->send_ref_count++;
+
+        if (pcb && pcb->sent != mbed_lwip_socket_sent) {
+            mbed_lwip_netconn_sent = pcb->sent;
+            tcp_sent(pcb, mbed_lwip_socket_sent);
         }
+
+        // The data may have been acknowledged already
+        mbed_lwip_send_ref_complete(s, !pcb);
+        UNLOCK_TCPIP_CORE();
+    }
+
+    return (nsapi_size_or_error_t)bytes_written;
+}
+#endif
+
+static nsapi_size_or_error_t mbed_lwip_socket_recv(nsapi_stack_t *stack, nsapi_socket_t handle, void *data, nsapi_size_t size)
+{
+    struct lwip_socket *s = (struct lwip_socket *)handle;
+
+    err_t err = mbed_lwip_socket_fill(s);
+    if (err != ERR_OK) {
+        return mbed_lwip_err_remap(err);
     }
 
     u16_t recv = netbuf_copy_partial(s->buf, data, (u16_t)size, s->offset);
@@ -931,6 +1127,48 @@ static nsapi_size_or_error_t mbed_lwip_socket_recv(nsapi_stack_t *stack, nsapi_s
     return recv;
 }
 
+static nsapi_size_or_error_t mbed_lwip_socket_recv_buffer(nsapi_stack_t *stack, nsapi_socket_t handle, nsapi_buffer_t *buffer, nsapi_size_t size)
+{
+    struct lwip_socket *s = (struct lwip_socket *)handle;
+
+    buffer->handle = 0;
+    buffer->offset = 0;
+    buffer->size = 0;
+
+    err_t err = mbed_lwip_socket_fill(s);
+    if (err != ERR_OK) {
+        return mbed_lwip_err_remap(err);
+    }
+
+    u16_t len = netbuf_len(s->buf) - s->offset;
+    u16_t recv = (size < len) ? (u16_t)size : len;
+    if (!recv) {
+        return 0;
+    }
+
+    // Reference the chain from the pbuf holding the first unread byte,
+    // so pbufs already consumed are freed along with the netbuf
+    struct pbuf *p = s->buf->p;
+    u16_t offset = s->offset;
+    while (offset >= p->len) {
+        offset -= p->len;
+        p = p->next;
+    }
+
+    pbuf_ref(p);
+    buffer->handle = p;
+    buffer->offset = offset;
+    buffer->size = recv;
+
+    s->offset += recv;
+    if (s->offset >= netbuf_len(s->buf)) {
+        netbuf_delete(s->buf);
+        s->buf = 0;
+    }
+
+    return recv;
+}
+
 static nsapi_size_or_error_t mbed_lwip_socket_sendto(nsapi_stack_t *stack, nsapi_socket_t handle, nsapi_addr_t addr, uint16_t port, const void *data, nsapi_size_t size)
 {
     struct lwip_socket *s = (struct lwip_socket *)handle;
@@ -959,22 +1197,273 @@ static nsapi_size_or_error_t mbed_lwip_socket_sendto(nsapi_stack_t *stack, nsapi
 static nsapi_size_or_error_t mbed_lwip_socket_recvfrom(nsapi_stack_t *stack, nsapi_socket_t handle, nsapi_addr_t *addr, uint16_t *port, void *data, nsapi_size_t size)
 {
     struct lwip_socket *s = (struct lwip_socket *)handle;
-    struct netbuf *buf;
 
-    err_t err = netconn_recv(s->conn, &buf);
+    err_t err = mbed_lwip_socket_fill(s);
+    if (err != ERR_OK) {
+        return mbed_lwip_err_remap(err);
+    }
+
+    convert_lwip_addr_to_mbed(addr, netbuf_fromaddr(s->buf));
+    *port = netbuf_fromport(s->buf);
+
+    u16_t recv = netbuf_copy(s->buf, data, (u16_t)size);
+    netbuf_delete(s->buf);
+    s->buf = 0;
+
+    return recv;
+}
+
+static nsapi_size_or_error_t mbed_lwip_socket_recvfrom_buffer(nsapi_stack_t *stack, nsapi_socket_t handle, nsapi_addr_t *addr, uint16_t *port, nsapi_buffer_t *buffer)
+{
+    struct lwip_socket *s = (struct lwip_socket *)handle;
+
+    buffer->handle = 0;
+    buffer->offset = 0;
+    buffer->size = 0;
+
+    err_t err = mbed_lwip_socket_fill(s);
+    if (err != ERR_OK) {
+        return mbed_lwip_err_remap(err);
+    }
+
+    convert_lwip_addr_to_mbed(addr, netbuf_fromaddr(s->buf));
+    *port = netbuf_fromport(s->buf);
+
+    // Keep the whole datagram, the netbuf wrapper goes straight back
+    struct pbuf *p = s->buf->p;
+    pbuf_ref(p);
+    buffer->handle = p;
+    buffer->size = p->tot_len;
+
+    netbuf_delete(s->buf);
+    s->buf = 0;
+
+    return buffer->size;
+}
+
+#if LWIP_TCP
+static nsapi_size_or_error_t mbed_lwip_socket_sendmsg_tcp(struct lwip_socket *s, const nsapi_iovec_t *iov, unsigned iovcnt)
+{
+    nsapi_size_t size = 0;
+    nsapi_size_t sent = 0;
+    err_t err = ERR_OK;
+
+    for (unsigned i = 0; i < iovcnt; i++) {
+        size += iov[i].iov_len;
+    }
+
+    if (!size) {
+        return 0;
+    }
+
+    // Queue every vector before any output, so the pieces are coalesced
+    // into segments rather than each leaving on its own
+    LOCK_TCPIP_CORE();
+    struct tcp_pcb *pcb = s->conn->pcb.tcp;
+    if (ERR_IS_FATAL(s->conn->last_err)) {
+        err = s->conn->last_err;
+    } else if (s->conn->state != NETCONN_NONE) {
+        err = ERR_INPROGRESS;
+    } else if (!pcb) {
+        err = ERR_CONN;
+    } else {
+        for (unsigned i = 0; i < iovcnt; i++) {
+            u16_t len = (iov[i].iov_len > tcp_sndbuf(pcb)) ? tcp_sndbuf(pcb) : (u16_t)iov[i].iov_len;
+            if (!len) {
+                if (iov[i].iov_len) {
+                    break;
+                }
+
+                continue;
+            }
+
+            u8_t flags = TCP_WRITE_FLAG_COPY;
+            if (sent + len < size) {
+                flags |= TCP_WRITE_FLAG_MORE;
+            }
+
+            err = tcp_write(pcb, iov[i].iov_base, len, flags);
+            if (err != ERR_OK) {
+                break;
+            }
+
+            sent += len;
+            if (len < iov[i].iov_len) {
+                break;
+            }
+        }
+
+        if (sent) {
+            err = tcp_output(pcb);
+            if (!ERR_IS_FATAL(err) && err != ERR_RTE) {
+                err = ERR_OK;
+            }
+        } else if (err == ERR_OK || err == ERR_MEM) {
+            // Let the netconn poll raise a send event once there is room
+            s->conn->flags |= NETCONN_FLAG_CHECK_WRITESPACE;
+            err = ERR_WOULDBLOCK;
+        }
+    }
+    UNLOCK_TCPIP_CORE();
+
     if (err != ERR_OK) {
         return mbed_lwip_err_remap(err);
     }
 
-    convert_lwip_addr_to_mbed(addr, netbuf_fromaddr(buf));
-    *port = netbuf_fromport(buf);
+    return sent;
+}
+#endif
+
+static nsapi_size_or_error_t mbed_lwip_socket_sendmsg(nsapi_stack_t *stack, nsapi_socket_t handle, const nsapi_addr_t *addr, uint16_t port, const nsapi_iovec_t *iov, unsigned iovcnt)
+{
+    struct lwip_socket *s = (struct lwip_socket *)handle;
+    ip_addr_t ip_addr;
+
+#if LWIP_TCP
+    if (!addr) {
+        return mbed_lwip_socket_sendmsg_tcp(s, iov, iovcnt);
+    }
+#endif
+
+    if (!addr || !convert_mbed_addr_to_lwip(&ip_addr, addr)) {
+        return NSAPI_ERROR_PARAMETER;
+    }
+
+    // Chain a reference to each vector, the datagram is assembled as it
+    // is copied out to the interface
+    struct netbuf *buf = netbuf_new();
+    if (!buf) {
+        return NSAPI_ERROR_NO_MEMORY;
+    }
+
+    nsapi_size_t size = 0;
+    err_t err = ERR_OK;
+    for (unsigned i = 0; i < iovcnt && err == ERR_OK; i++) {
+        if (!buf->p) {
+            err = netbuf_ref(buf, iov[i].iov_base, (u16_t)iov[i].iov_len);
+        } else if (iov[i].iov_len) {
+            struct netbuf *tail = netbuf_new();
+            if (!tail) {
+                err = ERR_MEM;
+                break;
+            }
+
+            err = netbuf_ref(tail, iov[i].iov_base, (u16_t)iov[i].iov_len);
+            if (err != ERR_OK) {
+                netbuf_delete(tail);
+                break;
+            }
+
+            netbuf_chain(buf, tail);
+        }
+
+        size += iov[i].iov_len;
+    }
+
+    if (err == ERR_OK && !buf->p) {
+        err = netbuf_ref(buf, NULL, 0);
+    }
+
+    if (err == ERR_OK) {
+        err = netconn_sendto(s->conn, buf, &ip_addr, port);
+    }
 
-    u16_t recv = netbuf_copy(buf, data, (u16_t)size);
     netbuf_delete(buf);
+    if (err != ERR_OK) {
+        return mbed_lwip_err_remap(err);
+    }
+
+    return size;
+}
+
+static nsapi_size_or_error_t mbed_lwip_socket_recvmsg(nsapi_stack_t *stack, nsapi_socket_t handle, nsapi_addr_t *addr, uint16_t *port, const nsapi_iovec_t *iov, unsigned iovcnt)
+{
+    struct lwip_socket *s = (struct lwip_socket *)handle;
+    nsapi_size_t recv = 0;
+
+    err_t err = mbed_lwip_socket_fill(s);
+    if (err != ERR_OK) {
+        return mbed_lwip_err_remap(err);
+    }
+
+    if (addr) {
+        convert_lwip_addr_to_mbed(addr, netbuf_fromaddr(s->buf));
+        *port = netbuf_fromport(s->buf);
+    }
+
+    unsigned i = 0;
+    nsapi_size_t iov_offset = 0;
+    while (i < iovcnt) {
+        if (iov_offset >= iov[i].iov_len) {
+            i++;
+            iov_offset = 0;
+            continue;
+        }
+
+        u16_t len = netbuf_copy_partial(s->buf, (u8_t *)iov[i].iov_base + iov_offset,
+                (u16_t)(iov[i].iov_len - iov_offset), s->offset);
+        s->offset += len;
+        iov_offset += len;
+        recv += len;
+
+        if (s->offset >= netbuf_len(s->buf)) {
+            netbuf_delete(s->buf);
+            s->buf = 0;
+
+            // A datagram ends the message, stream data carries on only
+            // while more is already queued
+            if (addr || mbed_lwip_socket_fill(s) != ERR_OK) {
+                break;
+            }
+        }
+    }
+
+    // Discard whatever is left of a datagram
+    if (addr && s->buf) {
+        netbuf_delete(s->buf);
+        s->buf = 0;
+    }
 
     return recv;
 }
 
+static nsapi_size_t mbed_lwip_buffer_segment(nsapi_stack_t *stack, const nsapi_buffer_t *buffer, nsapi_size_t offset, const void **data)
+{
+    if (offset >= buffer->size) {
+        return 0;
+    }
+
+    // Bytes remaining from offset, both relative to the current pbuf
+    nsapi_size_t end = buffer->offset + buffer->size;
+    offset += buffer->offset;
+
+    struct pbuf *p = (struct pbuf *)buffer->handle;
+    while (p && offset >= p->len) {
+        offset -= p->len;
+        end -= p->len;
+        p = p->next;
+    }
+
+    if (!p) {
+        return 0;
+    }
+
+    *data = (const u8_t *)p->payload + offset;
+    nsapi_size_t len = p->len - offset;
+    return (len < end - offset) ? len : end - offset;
+}
+
+static void mbed_lwip_buffer_release(nsapi_stack_t *stack, nsapi_buffer_t *buffer)
+{
+    if (buffer->handle) {
+        pbuf_free((struct pbuf *)buffer->handle);
+    }
+
+    buffer->handle = 0;
+    buffer->offset = 0;
+    buffer->size = 0;
+}
+
 static nsapi_error_t mbed_lwip_setsockopt(nsapi_stack_t *stack, nsapi_socket_t handle, int level, int optname, const void *optval, unsigned optlen)
 {
     struct lwip_socket *s = (struct lwip_socket *)handle;
@@ -1004,6 +1493,18 @@ static nsapi_error_t mbed_lwip_setsockopt(nsapi_stack_t *stack, nsapi_socket_t h
 
             s->conn->pcb.tcp->keep_intvl = *(int*)optval;
             return 0;
+
+        case NSAPI_TCP_NODELAY:
+            if (optlen != sizeof(int) || s->conn->type != NETCONN_TCP) {
+                return NSAPI_ERROR_UNSUPPORTED;
+            }
+
+            if (*(int *)optval) {
+                tcp_nagle_disable(s->conn->pcb.tcp);
+            } else {
+                tcp_nagle_enable(s->conn->pcb.tcp);
+            }
+            return 0;
 #endif
 
         case NSAPI_REUSEADDR:
@@ -1023,6 +1524,131 @@ static nsapi_error_t mbed_lwip_setsockopt(nsapi_stack_t *stack, nsapi_socket_t h
     }
 }
 
+static nsapi_error_t mbed_lwip_getsockopt(nsapi_stack_t *stack, nsapi_socket_t handle, int level, int optname, void *optval, unsigned *optlen)
+{
+    struct lwip_socket *s = (struct lwip_socket *)handle;
+
+    switch (optname) {
+        case NSAPI_RCVPENDING: {
+            if (*optlen < sizeof(int)) {
+                return NSAPI_ERROR_UNSUPPORTED;
+            }
+
+            // Peek by pulling the next netbuf into the socket, recv and
+            // recvfrom consume it from there
+            err_t err = mbed_lwip_socket_fill(s);
+            if (err == ERR_OK) {
+                *(int *)optval = netbuf_len(s->buf) - s->offset;
+            } else if (err == ERR_TIMEOUT || err == ERR_CLSD) {
+                *(int *)optval = 0;
+            } else {
+                return mbed_lwip_err_remap(err);
+            }
+
+            *optlen = sizeof(int);
+            return 0;
+        }
+
+        default:
+            return NSAPI_ERROR_UNSUPPORTED;
+    }
+}
+
+#if LWIP_STATS
+static void mbed_lwip_pool_stats(mbed_lwip_pool_stats_t *dst, memp_t type)
+{
+#if MEMP_STATS
+    const struct stats_mem *src = lwip_stats.memp[type];
+    dst->used = src->used;
+    dst->max = src->max;
+    dst->avail = src->avail;
+    dst->err = src->err;
+#endif
+}
+
+static void mbed_lwip_proto_stats(mbed_lwip_proto_stats_t *dst, const struct stats_proto *src)
+{
+    dst->xmit = src->xmit;
+    dst->recv = src->recv;
+    dst->drop = src->drop;
+    dst->chkerr = src->chkerr;
+    dst->err = src->err;
+}
+#endif
+
+static void mbed_lwip_get_stats(mbed_lwip_stats_t *stats)
+{
+    memset(stats, 0, sizeof *stats);
+
+    sys_prot_t prot = sys_arch_protect();
+    stats->sockets = lwip_arena_stats;
+    if (!lwip_arena_inited) {
+        stats->sockets.avail = MEMP_NUM_NETCONN;
+    }
+    sys_arch_unprotect(prot);
+
+#if LWIP_STATS
+    mbed_lwip_pool_stats(&stats->netconns, MEMP_NETCONN);
+#if LWIP_TCP
+    mbed_lwip_pool_stats(&stats->tcp_pcbs, MEMP_TCP_PCB);
+    mbed_lwip_pool_stats(&stats->tcp_listen_pcbs, MEMP_TCP_PCB_LISTEN);
+    mbed_lwip_pool_stats(&stats->tcp_segs, MEMP_TCP_SEG);
+#endif
+#if LWIP_UDP
+    mbed_lwip_pool_stats(&stats->udp_pcbs, MEMP_UDP_PCB);
+#endif
+    mbed_lwip_pool_stats(&stats->pbufs, MEMP_PBUF_POOL);
+
+#if MEM_STATS
+    stats->heap.used = lwip_stats.mem.used;
+    stats->heap.max = lwip_stats.mem.max;
+    stats->heap.avail = lwip_stats.mem.avail;
+    stats->heap.err = lwip_stats.mem.err;
+#endif
+#if LINK_STATS
+    mbed_lwip_proto_stats(&stats->link, &lwip_stats.link);
+#endif
+#if IP_STATS
+    mbed_lwip_proto_stats(&stats->ip, &lwip_stats.ip);
+#endif
+#if TCP_STATS
+    mbed_lwip_proto_stats(&stats->tcp, &lwip_stats.tcp);
+#endif
+#if UDP_STATS
+    mbed_lwip_proto_stats(&stats->udp, &lwip_stats.udp);
+#endif
+#endif
+
+#if LWIP_TCP
+    LOCK_TCPIP_CORE();
+    for (struct tcp_pcb *pcb = tcp_tw_pcbs; pcb; pcb = pcb->next) {
+        stats->tcp_time_wait++;
+    }
+    UNLOCK_TCPIP_CORE();
+#endif
+}
+
+static nsapi_error_t mbed_lwip_getstackopt(nsapi_stack_t *stack, int level, int optname, void *optval, unsigned *optlen)
+{
+    if (level != MBED_LWIP_LEVEL) {
+        return NSAPI_ERROR_UNSUPPORTED;
+    }
+
+    switch (optname) {
+        case MBED_LWIP_STATS:
+            if (*optlen < sizeof(mbed_lwip_stats_t)) {
+                return NSAPI_ERROR_UNSUPPORTED;
+            }
+
+            mbed_lwip_get_stats((mbed_lwip_stats_t *)optval);
+            *optlen = sizeof(mbed_lwip_stats_t);
+            return 0;
+
+        default:
+            return NSAPI_ERROR_UNSUPPORTED;
+    }
+}
+
 static void mbed_lwip_socket_attach(nsapi_stack_t *stack, nsapi_socket_t handle, void (*callback)(void *), void *data)
 {
     struct lwip_socket *s = (struct lwip_socket *)handle;
@@ -1033,20 +1659,31 @@ static void mbed_lwip_socket_attach(nsapi_stack_t *stack, nsapi_socket_t handle,
 
 /* LWIP network stack */
 const nsapi_stack_api_t lwip_stack_api = {
-    .gethostbyname      = mbed_lwip_gethostbyname,
-    .add_dns_server     = mbed_lwip_add_dns_server,
-    .socket_open        = mbed_lwip_socket_open,
-    .socket_close       = mbed_lwip_socket_close,
-    .socket_bind        = mbed_lwip_socket_bind,
-    .socket_listen      = mbed_lwip_socket_listen,
-    .socket_connect     = mbed_lwip_socket_connect,
-    .socket_accept      = mbed_lwip_socket_accept,
-    .socket_send        = mbed_lwip_socket_send,
-    .socket_recv        = mbed_lwip_socket_recv,
-    .socket_sendto      = mbed_lwip_socket_sendto,
-    .socket_recvfrom    = mbed_lwip_socket_recvfrom,
-    .setsockopt         = mbed_lwip_setsockopt,
-    .socket_attach      = mbed_lwip_socket_attach,
+    .gethostbyname          = mbed_lwip_gethostbyname,
+    .add_dns_server         = mbed_lwip_add_dns_server,
+    .getstackopt            = mbed_lwip_getstackopt,
+    .socket_open            = mbed_lwip_socket_open,
+    .socket_close           = mbed_lwip_socket_close,
+    .socket_bind            = mbed_lwip_socket_bind,
+    .socket_listen          = mbed_lwip_socket_listen,
+    .socket_connect         = mbed_lwip_socket_connect,
+    .socket_accept          = mbed_lwip_socket_accept,
+    .socket_send            = mbed_lwip_socket_send,
+    .socket_recv            = mbed_lwip_socket_recv,
+    .socket_sendto          = mbed_lwip_socket_sendto,
+    .socket_recvfrom        = mbed_lwip_socket_recvfrom,
+    .setsockopt             = mbed_lwip_setsockopt,
+    .getsockopt             = mbed_lwip_getsockopt,
+    .socket_attach          = mbed_lwip_socket_attach,
+    .socket_recv_buffer     = mbed_lwip_socket_recv_buffer,
+    .socket_recvfrom_buffer = mbed_lwip_socket_recvfrom_buffer,
+    .buffer_segment         = mbed_lwip_buffer_segment,
+    .buffer_release         = mbed_lwip_buffer_release,
+#if LWIP_TCP
+    .socket_send_ref        = mbed_lwip_socket_send_ref,
+#endif
+    .socket_sendmsg         = mbed_lwip_socket_sendmsg,
+    .socket_recvmsg         = mbed_lwip_socket_recvmsg,
 };
 
 nsapi_stack_t lwip_stack = {
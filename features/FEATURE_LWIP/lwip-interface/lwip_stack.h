@@ -40,6 +40,57 @@ char *mbed_lwip_get_gateway(char *buf, nsapi_size_t buflen);
 
 extern nsapi_stack_t lwip_stack;
 
+/** Stack option level for lwip-specific options of
+ *  NetworkStack::getstackopt
+ */
+#define MBED_LWIP_LEVEL 5100
+
+/** Option names for level MBED_LWIP_LEVEL
+ */
+typedef enum mbed_lwip_option {
+    MBED_LWIP_STATS, /*!< Gets an mbed_lwip_stats_t */
+} mbed_lwip_option_t;
+
+/** Usage of one of lwip's memory pools
+ */
+typedef struct mbed_lwip_pool_stats {
+    uint32_t used;  /*!< Elements currently allocated */
+    uint32_t max;   /*!< Most elements ever allocated at once */
+    uint32_t avail; /*!< Elements in the pool, including any it has grown by */
+    uint32_t err;   /*!< Allocations that failed */
+} mbed_lwip_pool_stats_t;
+
+/** Packet counters of one of lwip's protocol layers
+ */
+typedef struct mbed_lwip_proto_stats {
+    uint32_t xmit;   /*!< Packets transmitted */
+    uint32_t recv;   /*!< Packets received */
+    uint32_t drop;   /*!< Packets dropped */
+    uint32_t chkerr; /*!< Packets with a bad checksum */
+    uint32_t err;    /*!< Other errors */
+} mbed_lwip_proto_stats_t;
+
+/** Statistics returned for MBED_LWIP_STATS
+ *
+ *  The socket and TIME_WAIT counts are always collected. The rest stay
+ *  zero unless the stack is built with lwip.stats-enabled.
+ */
+typedef struct mbed_lwip_stats {
+    mbed_lwip_pool_stats_t sockets;
+    mbed_lwip_pool_stats_t netconns;
+    mbed_lwip_pool_stats_t tcp_pcbs;
+    mbed_lwip_pool_stats_t tcp_listen_pcbs;
+    mbed_lwip_pool_stats_t udp_pcbs;
+    mbed_lwip_pool_stats_t tcp_segs;
+    mbed_lwip_pool_stats_t pbufs;
+    mbed_lwip_pool_stats_t heap;
+    mbed_lwip_proto_stats_t link;
+    mbed_lwip_proto_stats_t ip;
+    mbed_lwip_proto_stats_t tcp;
+    mbed_lwip_proto_stats_t udp;
+    uint32_t tcp_time_wait; /*!< TCP connections in TIME_WAIT */
+} mbed_lwip_stats_t;
+
 #ifdef __cplusplus
 }
 #endif
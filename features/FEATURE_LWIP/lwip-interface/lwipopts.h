@@ -72,17 +72,32 @@
 #endif
 
 #if NO_SYS == 0
+#if !defined(TARGET_LIKE_POSIX)
 #include "cmsis_os2.h"
+#endif
 
 #define SYS_LIGHTWEIGHT_PROT        1
 
 #define LWIP_RAW                    0
 
-#define TCPIP_MBOX_SIZE             8
-#define DEFAULT_TCP_RECVMBOX_SIZE   8
-#define DEFAULT_UDP_RECVMBOX_SIZE   8
-#define DEFAULT_RAW_RECVMBOX_SIZE   8
-#define DEFAULT_ACCEPTMBOX_SIZE     8
+#ifndef MBED_CONF_LWIP_MBOX_SIZE
+#define MBED_CONF_LWIP_MBOX_SIZE    8
+#endif
+
+#ifndef MBED_CONF_LWIP_MBOX_LOCK_FREE
+#define MBED_CONF_LWIP_MBOX_LOCK_FREE 0
+#endif
+
+#define TCPIP_MBOX_SIZE             MBED_CONF_LWIP_MBOX_SIZE
+#define DEFAULT_TCP_RECVMBOX_SIZE   MBED_CONF_LWIP_MBOX_SIZE
+#define DEFAULT_UDP_RECVMBOX_SIZE   MBED_CONF_LWIP_MBOX_SIZE
+#define DEFAULT_RAW_RECVMBOX_SIZE   MBED_CONF_LWIP_MBOX_SIZE
+#define DEFAULT_ACCEPTMBOX_SIZE     MBED_CONF_LWIP_MBOX_SIZE
+
+// Messages the tcpip thread takes from its mailbox in one go
+#if MBED_CONF_LWIP_MBOX_LOCK_FREE
+#define TCPIP_MBOX_BATCH            8
+#endif
 
 // Thread stack size for lwip tcpip thread
 #ifndef MBED_CONF_LWIP_TCPIP_THREAD_STACKSIZE
@@ -95,7 +110,11 @@
 #define TCPIP_THREAD_STACKSIZE      MBED_CONF_LWIP_TCPIP_THREAD_STACKSIZE
 #endif
 
+#if defined(TARGET_LIKE_POSIX)
+#define TCPIP_THREAD_PRIO           0
+#else
 #define TCPIP_THREAD_PRIO           (osPriorityNormal)
+#endif
 
 // Thread stack size for lwip system threads
 #ifndef MBED_CONF_LWIP_DEFAULT_THREAD_STACKSIZE
@@ -122,14 +141,97 @@
 #endif
 
 // 32-bit alignment
+#ifndef MEM_ALIGNMENT
 #define MEM_ALIGNMENT               4
+#endif
 
 #define LWIP_RAM_HEAP_POINTER       lwip_ram_heap
 
-// Number of pool pbufs.
-// Each requires 684 bytes of RAM.
+// The throughput profile trades RAM for throughput on lossy or high
+// bandwidth-delay links: full-size segments, a larger window and send
+// buffer, window scaling and queueing of out-of-order segments.
+#ifndef MBED_CONF_LWIP_THROUGHPUT_PROFILE
+#define MBED_CONF_LWIP_THROUGHPUT_PROFILE 0
+#endif
+
+// TCP segment size, receive window and send buffer. The window and send
+// buffer are configured in segments, and the pbuf counts below follow them.
+// Defaults depend on the profile, explicit settings override either.
+#ifndef MBED_CONF_LWIP_TCP_MSS
+#if MBED_CONF_LWIP_THROUGHPUT_PROFILE
+#define MBED_CONF_LWIP_TCP_MSS      1460
+#else
+#define MBED_CONF_LWIP_TCP_MSS      536
+#endif
+#endif
+
+#ifndef MBED_CONF_LWIP_TCP_WND
+#if MBED_CONF_LWIP_THROUGHPUT_PROFILE
+#define MBED_CONF_LWIP_TCP_WND      16
+#else
+#define MBED_CONF_LWIP_TCP_WND      4
+#endif
+#endif
+
+#ifndef MBED_CONF_LWIP_TCP_SND_BUF
+#if MBED_CONF_LWIP_THROUGHPUT_PROFILE
+#define MBED_CONF_LWIP_TCP_SND_BUF  8
+#else
+#define MBED_CONF_LWIP_TCP_SND_BUF  2
+#endif
+#endif
+
+#ifndef TCP_MSS
+#define TCP_MSS                     MBED_CONF_LWIP_TCP_MSS
+#endif
+
+#ifndef TCP_WND
+#define TCP_WND                     (MBED_CONF_LWIP_TCP_WND * TCP_MSS)
+#endif
+
+#ifndef TCP_SND_BUF
+#define TCP_SND_BUF                 (MBED_CONF_LWIP_TCP_SND_BUF * TCP_MSS)
+#endif
+
+// Window scaling lets the send window follow a peer advertising more than
+// 64KB, and is needed for a receive window that large. The scale is the
+// smallest that fits TCP_WND into the 16-bit window field.
+#if MBED_CONF_LWIP_THROUGHPUT_PROFILE || TCP_WND > 0xffff
+#define LWIP_WND_SCALE              1
+#if TCP_WND <= 0xffff
+#define TCP_RCV_SCALE               0
+#elif TCP_WND <= 0x1fffe
+#define TCP_RCV_SCALE               1
+#elif TCP_WND <= 0x3fffc
+#define TCP_RCV_SCALE               2
+#elif TCP_WND <= 0x7fff8
+#define TCP_RCV_SCALE               3
+#else
+#define TCP_RCV_SCALE               4
+#endif
+#endif
+
+// Out-of-order segments are queued rather than dropped with the throughput
+// profile, so one lost segment costs a retransmit of that segment only.
+// The queue is bounded per connection by the receive window, and lwIP
+// frees it when the pbuf pool or the heap runs out.
+#if MBED_CONF_LWIP_THROUGHPUT_PROFILE
+#define TCP_QUEUE_OOSEQ             1
+#define TCP_OOSEQ_MAX_BYTES         TCP_WND
+#define TCP_OOSEQ_MAX_PBUFS         MBED_CONF_LWIP_TCP_WND
+// Retransmission timeouts count in ticks of twice this, and fast
+// retransmit needs a run of bare duplicate acks, which traffic in both
+// directions rarely gives. A finer tick shortens the stall after a loss.
+#define TCP_TMR_INTERVAL            100
+#else
+#define TCP_QUEUE_OOSEQ             0
+#define TCP_OOSEQ_MAX_PBUFS         0
+#endif
+
+// Number of pool pbufs, enough to receive a full TCP window plus one.
+// Each requires 684 bytes of RAM with the default TCP_MSS.
 #ifndef PBUF_POOL_SIZE
-#define PBUF_POOL_SIZE              5
+#define PBUF_POOL_SIZE              ((TCP_WND + PBUF_POOL_BUFSIZE - 1) / PBUF_POOL_BUFSIZE + 1)
 #endif
 
 // One tcp_pcb_listen is needed for each TCPServer.
@@ -156,10 +258,17 @@
 #define MEMP_NUM_UDP_PCB            4
 #endif
 
-// Number of non-pool pbufs.
+// Number of non-pool pbufs, enough for TCPSocket::send_ref to fill the
+// TCP send queue with references to application buffers.
 // Each requires 92 bytes of RAM.
 #ifndef MEMP_NUM_PBUF
-#define MEMP_NUM_PBUF               8
+#define MEMP_NUM_PBUF               TCP_SND_QUEUELEN
+#endif
+
+// Number of queued TCP segments, at least enough for a full send buffer
+// plus a full out-of-order queue. Each requires 16 bytes of RAM.
+#ifndef MEMP_NUM_TCP_SEG
+#define MEMP_NUM_TCP_SEG            ((TCP_SND_QUEUELEN > 16 ? TCP_SND_QUEUELEN : 16) + TCP_OOSEQ_MAX_PBUFS)
 #endif
 
 // Each netbuf requires 64 bytes of RAM.
@@ -175,10 +284,28 @@
 #define MEMP_NUM_NETCONN            4
 #endif
 
+// Number of sockets, netconns and pcbs to add from the heap when one of
+// the pools above runs out, rather than failing the open. 0 keeps them fixed.
+#ifndef MBED_CONF_LWIP_SOCKET_GROW
+#define MBED_CONF_LWIP_SOCKET_GROW  0
+#endif
+
+#if MBED_CONF_LWIP_SOCKET_GROW > 0
+#define LWIP_HOOK_MEMP_EMPTY(type)  mbed_lwip_memp_grow(type)
+// Bounds the half-open connections a listener can hold, now that the
+// pcb pool no longer does
+#define TCP_LISTEN_BACKLOG          1
+#endif
+
 #if MBED_CONF_LWIP_TCP_ENABLED
 #define LWIP_TCP                    1
-#define TCP_QUEUE_OOSEQ             0
+#if MBED_CONF_LWIP_THROUGHPUT_PROFILE
+// Small writes append to the last queued segment instead of each taking
+// a segment and pbuf of their own
+#define TCP_OVERSIZE                TCP_MSS
+#else
 #define TCP_OVERSIZE                0
+#endif
 #define LWIP_TCP_KEEPALIVE          1
 #else
 #define LWIP_TCP                    0
@@ -253,8 +380,12 @@
 #define LWIP_DBG_MIN_LEVEL          LWIP_DBG_LEVEL_ALL
 #else
 #define LWIP_NOASSERT               1
+#ifdef MBED_CONF_LWIP_STATS_ENABLED
+#define LWIP_STATS                  MBED_CONF_LWIP_STATS_ENABLED
+#else
 #define LWIP_STATS                  0
 #endif
+#endif
 
 #define LWIP_PLATFORM_BYTESWAP      1
 
@@ -295,8 +426,18 @@
 #ifndef LWIP_ARP
 #define LWIP_ARP                    0
 #endif
-// Checksum-on-copy disabled due to https://savannah.nongnu.org/bugs/?50914
-#define LWIP_CHECKSUM_ON_COPY       0
+// Checksum TCP data while copying it in, rather than in a second pass
+#ifndef MBED_CONF_LWIP_CHECKSUM_ON_COPY
+#define MBED_CONF_LWIP_CHECKSUM_ON_COPY 1
+#endif
+
+#define LWIP_CHECKSUM_ON_COPY       MBED_CONF_LWIP_CHECKSUM_ON_COPY
+#if LWIP_CHECKSUM_ON_COPY
+#define LWIP_CHKSUM_COPY(dst, src, len) mbed_lwip_chksum_copy(dst, src, len)
+#endif
+
+// Lets EMAC drivers turn off the software checksums they offload
+#define LWIP_CHECKSUM_CTRL_PER_NETIF 1
 
 #define LWIP_NETIF_HOSTNAME         1
 #define LWIP_NETIF_STATUS_CALLBACK  1
@@ -309,6 +450,7 @@
 #include "lwip_random.h"
 #include "lwip_tcp_isn.h"
 #define LWIP_HOOK_TCP_ISN lwip_hook_tcp_isn
+#include "lwip_memp_grow.h"
 #ifdef MBEDTLS_MD5_C
 #include "mbedtls/inc/mbedtls/md5.h"
 #define LWIP_USE_EXTERNAL_MBEDTLS 1
@@ -0,0 +1,145 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "mbed.h"
+#include "greentea-client/test_env.h"
+#include "unity.h"
+#include "utest.h"
+
+#include "HeapBlockDevice.h"
+#include "AsyncBlockDevice.h"
+#include <stdlib.h>
+
+using namespace utest::v1;
+
+#define TEST_BLOCK_SIZE 128
+#define TEST_BLOCK_DEVICE_SIZE 32*TEST_BLOCK_SIZE
+#define TEST_BLOCK_COUNT 8
+#define TEST_ERASE_LATENCY 20000
+
+
+// Counts completed operations and records the last error
+static volatile int completed = 0;
+static volatile int completed_err = 0;
+
+static void complete(int err) {
+    if (err) {
+        completed_err = err;
+    }
+    completed += 1;
+}
+
+
+// Queue a set of async operations and check the data in order
+void test_async_read_write() {
+    HeapBlockDevice heap(TEST_BLOCK_DEVICE_SIZE, TEST_BLOCK_SIZE);
+    AsyncBlockDevice bd(&heap);
+
+    int err = bd.init();
+    TEST_ASSERT_EQUAL(0, err);
+
+    uint8_t *write_blocks = new uint8_t[TEST_BLOCK_COUNT*TEST_BLOCK_SIZE];
+    uint8_t *read_blocks = new uint8_t[TEST_BLOCK_COUNT*TEST_BLOCK_SIZE];
+
+    srand(1);
+    for (int i = 0; i < TEST_BLOCK_COUNT*TEST_BLOCK_SIZE; i++) {
+        write_blocks[i] = 0xff & rand();
+    }
+
+    completed = 0;
+    completed_err = 0;
+    for (int b = 0; b < TEST_BLOCK_COUNT; b++) {
+        err = bd.erase_async(b*TEST_BLOCK_SIZE, TEST_BLOCK_SIZE, complete);
+        TEST_ASSERT_EQUAL(0, err);
+        err = bd.program_async(&write_blocks[b*TEST_BLOCK_SIZE],
+                b*TEST_BLOCK_SIZE, TEST_BLOCK_SIZE, complete);
+        TEST_ASSERT_EQUAL(0, err);
+    }
+
+    // Blocking read is ordered after the queued programs
+    err = bd.read(read_blocks, 0, TEST_BLOCK_COUNT*TEST_BLOCK_SIZE);
+    TEST_ASSERT_EQUAL(0, err);
+    TEST_ASSERT_EQUAL(2*TEST_BLOCK_COUNT, completed);
+    TEST_ASSERT_EQUAL(0, completed_err);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(write_blocks, read_blocks,
+            TEST_BLOCK_COUNT*TEST_BLOCK_SIZE);
+
+    memset(read_blocks, 0, TEST_BLOCK_COUNT*TEST_BLOCK_SIZE);
+    err = bd.read_async(read_blocks, 0, TEST_BLOCK_COUNT*TEST_BLOCK_SIZE, complete);
+    TEST_ASSERT_EQUAL(0, err);
+    err = bd.sync();
+    TEST_ASSERT_EQUAL(0, err);
+    TEST_ASSERT_EQUAL(2*TEST_BLOCK_COUNT + 1, completed);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(write_blocks, read_blocks,
+            TEST_BLOCK_COUNT*TEST_BLOCK_SIZE);
+
+    delete[] write_blocks;
+    delete[] read_blocks;
+
+    err = bd.deinit();
+    TEST_ASSERT_EQUAL(0, err);
+}
+
+
+// Check that a slow erase overlaps with work on the calling thread
+void test_async_overlap() {
+    HeapBlockDevice heap(TEST_BLOCK_DEVICE_SIZE, TEST_BLOCK_SIZE);
+    heap.set_latency(0, 0, TEST_ERASE_LATENCY);
+    AsyncBlockDevice bd(&heap);
+
+    int err = bd.init();
+    TEST_ASSERT_EQUAL(0, err);
+
+    Timer timer;
+    timer.start();
+    err = bd.erase(0, TEST_BLOCK_SIZE);
+    TEST_ASSERT_EQUAL(0, err);
+    Thread::wait(TEST_ERASE_LATENCY/1000);
+    int blocking_us = timer.read_us();
+
+    timer.reset();
+    completed = 0;
+    err = bd.erase_async(0, TEST_BLOCK_SIZE, complete);
+    TEST_ASSERT_EQUAL(0, err);
+    Thread::wait(TEST_ERASE_LATENCY/1000);
+    err = bd.sync();
+    TEST_ASSERT_EQUAL(0, err);
+    int async_us = timer.read_us();
+    TEST_ASSERT_EQUAL(1, completed);
+
+    printf("erase + work: blocking %dus, async %dus\n", blocking_us, async_us);
+    TEST_ASSERT(async_us < blocking_us);
+
+    err = bd.deinit();
+    TEST_ASSERT_EQUAL(0, err);
+}
+
+
+// Test setup
+utest::v1::status_t test_setup(const size_t number_of_cases) {
+    GREENTEA_SETUP(30, "default_auto");
+    return verbose_test_setup_handler(number_of_cases);
+}
+
+Case cases[] = {
+    Case("Testing async read write", test_async_read_write),
+    Case("Testing async erase overlap", test_async_overlap),
+};
+
+Specification specification(test_setup, cases);
+
+int main() {
+    return !Harness::run(specification);
+}
@@ -85,6 +85,66 @@ void test_read_write() {
 }
 
 
+// Sequential throughput for large sector-aligned transfers
+template <ssize_t TEST_SIZE, ssize_t CHUNK_SIZE>
+void test_sequential_throughput() {
+    FATFileSystem fs("fat");
+
+    int err = fs.mount(&bd);
+    TEST_ASSERT_EQUAL(0, err);
+
+    uint8_t *buffer = (uint8_t *)malloc(CHUNK_SIZE);
+    TEST_ASSERT(buffer);
+
+    srand(1);
+    for (int i = 0; i < CHUNK_SIZE; i++) {
+        buffer[i] = 0xff & rand();
+    }
+
+    Timer timer;
+    File file;
+    err = file.open(&fs, "test_sequential.dat", O_WRONLY | O_CREAT | O_TRUNC);
+    TEST_ASSERT_EQUAL(0, err);
+    timer.start();
+    for (ssize_t i = 0; i < TEST_SIZE; i += CHUNK_SIZE) {
+        ssize_t size = file.write(buffer, CHUNK_SIZE);
+        TEST_ASSERT_EQUAL(CHUNK_SIZE, size);
+    }
+    err = file.close();
+    TEST_ASSERT_EQUAL(0, err);
+    timer.stop();
+    int write_us = timer.read_us();
+
+    timer.reset();
+    err = file.open(&fs, "test_sequential.dat", O_RDONLY);
+    TEST_ASSERT_EQUAL(0, err);
+    timer.start();
+    for (ssize_t i = 0; i < TEST_SIZE; i += CHUNK_SIZE) {
+        ssize_t size = file.read(buffer, CHUNK_SIZE);
+        TEST_ASSERT_EQUAL(CHUNK_SIZE, size);
+    }
+    timer.stop();
+    err = file.close();
+    TEST_ASSERT_EQUAL(0, err);
+    int read_us = timer.read_us();
+
+    // Check that the last chunk was unmodified
+    srand(1);
+    for (int i = 0; i < CHUNK_SIZE; i++) {
+        TEST_ASSERT_EQUAL(0xff & rand(), buffer[i]);
+    }
+
+    printf("%d bytes in %d byte chunks: write %d KB/s, read %d KB/s\n",
+            (int)TEST_SIZE, (int)CHUNK_SIZE,
+            (int)(1000LL*TEST_SIZE / (write_us ? write_us : 1)),
+            (int)(1000LL*TEST_SIZE / (read_us ? read_us : 1)));
+
+    free(buffer);
+    err = fs.unmount();
+    TEST_ASSERT_EQUAL(0, err);
+}
+
+
 // Simple test for iterating dir entries
 void test_read_dir() {
     FATFileSystem fs("fat");
@@ -156,6 +216,8 @@ Case cases[] = {
     Case("Testing formating", test_format),
     Case("Testing read write < block", test_read_write<BLOCK_SIZE/2>),
     Case("Testing read write > block", test_read_write<2*BLOCK_SIZE>),
+    Case("Testing read write > cluster", test_read_write<16*BLOCK_SIZE>),
+    Case("Testing sequential throughput", test_sequential_throughput<32*BLOCK_SIZE, 8*BLOCK_SIZE>),
     Case("Testing dir iteration", test_read_dir),
 };
 
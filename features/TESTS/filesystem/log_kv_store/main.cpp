@@ -0,0 +1,354 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "mbed.h"
+#include "greentea-client/test_env.h"
+#include "unity.h"
+#include "utest.h"
+
+#include "HeapBlockDevice.h"
+#include "LogKVStore.h"
+#include <stdlib.h>
+#include <errno.h>
+
+using namespace utest::v1;
+
+#define TEST_BLOCK_SIZE 512
+#define TEST_BLOCK_COUNT 16
+#define TEST_KEY_COUNT 32
+#define TEST_VALUE_SIZE 24
+#define TEST_COMMIT_COUNT 1000
+
+
+// Block device that counts the bytes programmed and erased, and can
+// simulate a power cut
+class CountingBlockDevice : public HeapBlockDevice
+{
+public:
+    CountingBlockDevice(bd_size_t size, bd_size_t read, bd_size_t program, bd_size_t erase)
+        : HeapBlockDevice(size, read, program, erase), programmed(0), erased(0), cut(CUT_NONE) {}
+
+    // Let the next erase and the program after it through, as when a
+    // sector is activated, and fail everything after them
+    void cut_after_activate() {
+        cut = CUT_ARMED;
+    }
+
+    void power_on() {
+        cut = CUT_NONE;
+    }
+
+    virtual int program(const void *buffer, bd_addr_t addr, bd_size_t size) {
+        if (cut == CUT_OFF) {
+            return BD_ERROR_DEVICE_ERROR;
+        } else if (cut == CUT_ERASED) {
+            cut = CUT_OFF;
+        }
+
+        programmed += size;
+        return HeapBlockDevice::program(buffer, addr, size);
+    }
+
+    virtual int erase(bd_addr_t addr, bd_size_t size) {
+        if (cut == CUT_OFF) {
+            return BD_ERROR_DEVICE_ERROR;
+        } else if (cut == CUT_ARMED) {
+            cut = CUT_ERASED;
+        }
+
+        erased += size;
+        return HeapBlockDevice::erase(addr, size);
+    }
+
+    bd_size_t programmed;
+    bd_size_t erased;
+
+private:
+    enum { CUT_NONE, CUT_ARMED, CUT_ERASED, CUT_OFF } cut;
+};
+
+CountingBlockDevice bd(TEST_BLOCK_COUNT*TEST_BLOCK_SIZE, 1, 4, TEST_BLOCK_SIZE);
+
+
+// Test formatting
+void test_format() {
+    int err = bd.init();
+    TEST_ASSERT_EQUAL(0, err);
+
+    LogKVStore kv(&bd);
+    err = kv.mount();
+    TEST_ASSERT_EQUAL(-ENOENT, err);
+
+    err = kv.format();
+    TEST_ASSERT_EQUAL(0, err);
+
+    err = kv.unmount();
+    TEST_ASSERT_EQUAL(0, err);
+}
+
+
+// Set, get and remove keys and check they persist across mounts
+void test_set_get_remove() {
+    LogKVStore kv(&bd);
+    int err = kv.mount();
+    TEST_ASSERT_EQUAL(0, err);
+
+    err = kv.set("hello", "world", 6, 0x12);
+    TEST_ASSERT_EQUAL(0, err);
+    err = kv.set("removed", "soon", 5);
+    TEST_ASSERT_EQUAL(0, err);
+    err = kv.remove("removed");
+    TEST_ASSERT_EQUAL(0, err);
+    err = kv.remove("removed");
+    TEST_ASSERT_EQUAL(-ENOENT, err);
+
+    err = kv.unmount();
+    TEST_ASSERT_EQUAL(0, err);
+    err = kv.mount();
+    TEST_ASSERT_EQUAL(0, err);
+
+    char value[8];
+    uint32_t flags;
+    ssize_t size = kv.get("hello", value, sizeof(value), &flags);
+    TEST_ASSERT_EQUAL(6, size);
+    TEST_ASSERT_EQUAL_STRING("world", value);
+    TEST_ASSERT_EQUAL(0x12, flags);
+
+    size = kv.get("removed", value, sizeof(value));
+    TEST_ASSERT_EQUAL(-ENOENT, size);
+    TEST_ASSERT_EQUAL(1, kv.count());
+
+    char key[256];
+    size = kv.key_at(0, key, sizeof(key));
+    TEST_ASSERT_EQUAL(5, size);
+    TEST_ASSERT_EQUAL_STRING("hello", key);
+
+    err = kv.remove("hello");
+    TEST_ASSERT_EQUAL(0, err);
+    err = kv.unmount();
+    TEST_ASSERT_EQUAL(0, err);
+}
+
+
+// Overwrite a set of keys many times so the log wraps and is collected
+void test_commit_traffic() {
+    LogKVStore kv(&bd);
+    int err = kv.mount();
+    TEST_ASSERT_EQUAL(0, err);
+
+    char key[16];
+    uint8_t value[TEST_VALUE_SIZE];
+    for (int k = 0; k < TEST_KEY_COUNT; k++) {
+        sprintf(key, "key%d", k);
+        memset(value, k, sizeof(value));
+        err = kv.set(key, value, sizeof(value));
+        TEST_ASSERT_EQUAL(0, err);
+    }
+
+    bd.programmed = 0;
+    bd.erased = 0;
+    Timer timer;
+    timer.start();
+
+    srand(1);
+    for (int i = 0; i < TEST_COMMIT_COUNT; i++) {
+        int k = rand() % TEST_KEY_COUNT;
+        sprintf(key, "key%d", k);
+        memset(value, k + i, sizeof(value));
+        err = kv.set(key, value, sizeof(value));
+        TEST_ASSERT_EQUAL(0, err);
+    }
+
+    timer.stop();
+
+    // A full image rewrite would program every key on each commit
+    printf("%d commits in %dms: %d bytes programmed per commit, "
+           "%d bytes erased per commit, full image is %d bytes\n",
+            TEST_COMMIT_COUNT, timer.read_ms(),
+            (int)(bd.programmed / TEST_COMMIT_COUNT),
+            (int)(bd.erased / TEST_COMMIT_COUNT),
+            TEST_KEY_COUNT*(int)(TEST_VALUE_SIZE + sizeof(key)));
+
+    err = kv.unmount();
+    TEST_ASSERT_EQUAL(0, err);
+    err = kv.mount();
+    TEST_ASSERT_EQUAL(0, err);
+    TEST_ASSERT_EQUAL(TEST_KEY_COUNT, kv.count());
+
+    // Replay the same sequence to find the last value of each key
+    uint8_t expected[TEST_KEY_COUNT];
+    for (int k = 0; k < TEST_KEY_COUNT; k++) {
+        expected[k] = k;
+    }
+    srand(1);
+    for (int i = 0; i < TEST_COMMIT_COUNT; i++) {
+        int k = rand() % TEST_KEY_COUNT;
+        expected[k] = k + i;
+    }
+
+    for (int k = 0; k < TEST_KEY_COUNT; k++) {
+        sprintf(key, "key%d", k);
+        ssize_t size = kv.get(key, value, sizeof(value));
+        TEST_ASSERT_EQUAL(TEST_VALUE_SIZE, size);
+        for (int j = 0; j < TEST_VALUE_SIZE; j++) {
+            TEST_ASSERT_EQUAL(expected[k], value[j]);
+        }
+    }
+
+    err = kv.unmount();
+    TEST_ASSERT_EQUAL(0, err);
+}
+
+
+// Keep committing across remounts, each round wrapping the log so every
+// sector has been collected and reused before the next mount
+void test_set_after_remount() {
+    LogKVStore kv(&bd);
+    int err = kv.mount();
+    TEST_ASSERT_EQUAL(0, err);
+
+    char key[16];
+    uint8_t value[TEST_VALUE_SIZE];
+    uint8_t expected[TEST_KEY_COUNT];
+    for (int k = 0; k < TEST_KEY_COUNT; k++) {
+        sprintf(key, "key%d", k);
+        memset(value, k, sizeof(value));
+        expected[k] = k;
+        err = kv.set(key, value, sizeof(value));
+        TEST_ASSERT_EQUAL(0, err);
+    }
+
+    srand(2);
+    for (int round = 0; round < 3; round++) {
+        bd.erased = 0;
+        for (int i = 0; i < TEST_COMMIT_COUNT; i++) {
+            int k = rand() % TEST_KEY_COUNT;
+            sprintf(key, "key%d", k);
+            memset(value, k + i + round, sizeof(value));
+            expected[k] = k + i + round;
+            err = kv.set(key, value, sizeof(value));
+            TEST_ASSERT_EQUAL(0, err);
+        }
+        TEST_ASSERT(bd.erased > TEST_BLOCK_COUNT*TEST_BLOCK_SIZE);
+
+        err = kv.unmount();
+        TEST_ASSERT_EQUAL(0, err);
+        err = kv.mount();
+        TEST_ASSERT_EQUAL(0, err);
+        TEST_ASSERT_EQUAL(TEST_KEY_COUNT, kv.count());
+
+        for (int k = 0; k < TEST_KEY_COUNT; k++) {
+            sprintf(key, "key%d", k);
+            ssize_t size = kv.get(key, value, sizeof(value));
+            TEST_ASSERT_EQUAL(TEST_VALUE_SIZE, size);
+            for (int j = 0; j < TEST_VALUE_SIZE; j++) {
+                TEST_ASSERT_EQUAL(expected[k], value[j]);
+            }
+        }
+    }
+
+    err = kv.unmount();
+    TEST_ASSERT_EQUAL(0, err);
+}
+
+
+// Cut the power once the head has advanced into the last free sector but
+// before the oldest sector is collected, the store must still take commits
+// after the next mount
+void test_power_cut_after_activate() {
+    LogKVStore kv(&bd);
+    int err = kv.mount();
+    TEST_ASSERT_EQUAL(0, err);
+
+    char key[16];
+    uint8_t value[TEST_VALUE_SIZE];
+    uint8_t expected[TEST_KEY_COUNT];
+    for (int k = 0; k < TEST_KEY_COUNT; k++) {
+        sprintf(key, "key%d", k);
+        ssize_t size = kv.get(key, value, sizeof(value));
+        TEST_ASSERT_EQUAL(TEST_VALUE_SIZE, size);
+        expected[k] = value[0];
+    }
+
+    // The log has wrapped, so every advance is followed by a collection
+    bd.cut_after_activate();
+    srand(3);
+    int i;
+    for (i = 0; i < TEST_COMMIT_COUNT; i++) {
+        int k = rand() % TEST_KEY_COUNT;
+        sprintf(key, "key%d", k);
+        memset(value, k + i, sizeof(value));
+        err = kv.set(key, value, sizeof(value));
+        if (err) {
+            break;
+        }
+        expected[k] = k + i;
+    }
+    TEST_ASSERT(i < TEST_COMMIT_COUNT);
+    bd.power_on();
+
+    err = kv.unmount();
+    TEST_ASSERT_EQUAL(0, err);
+    err = kv.mount();
+    TEST_ASSERT_EQUAL(0, err);
+
+    for (i = 0; i < TEST_COMMIT_COUNT; i++) {
+        int k = rand() % TEST_KEY_COUNT;
+        sprintf(key, "key%d", k);
+        memset(value, k + i, sizeof(value));
+        expected[k] = k + i;
+        err = kv.set(key, value, sizeof(value));
+        TEST_ASSERT_EQUAL(0, err);
+    }
+
+    err = kv.unmount();
+    TEST_ASSERT_EQUAL(0, err);
+    err = kv.mount();
+    TEST_ASSERT_EQUAL(0, err);
+    TEST_ASSERT_EQUAL(TEST_KEY_COUNT, kv.count());
+
+    for (int k = 0; k < TEST_KEY_COUNT; k++) {
+        sprintf(key, "key%d", k);
+        ssize_t size = kv.get(key, value, sizeof(value));
+        TEST_ASSERT_EQUAL(TEST_VALUE_SIZE, size);
+        for (int j = 0; j < TEST_VALUE_SIZE; j++) {
+            TEST_ASSERT_EQUAL(expected[k], value[j]);
+        }
+    }
+
+    err = kv.unmount();
+    TEST_ASSERT_EQUAL(0, err);
+}
+
+
+// Test setup
+utest::v1::status_t test_setup(const size_t number_of_cases) {
+    GREENTEA_SETUP(60, "default_auto");
+    return verbose_test_setup_handler(number_of_cases);
+}
+
+Case cases[] = {
+    Case("Testing formatting", test_format),
+    Case("Testing set get remove", test_set_get_remove),
+    Case("Testing commit traffic", test_commit_traffic),
+    Case("Testing set after remount", test_set_after_remount),
+    Case("Testing power cut after activate", test_power_cut_after_activate),
+};
+
+Specification specification(test_setup, cases);
+
+int main() {
+    return !Harness::run(specification);
+}
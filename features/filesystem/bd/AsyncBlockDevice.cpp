@@ -0,0 +1,226 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// The adaptor runs its device on a thread, so it is compiled only if the
+// RTOS and the event queue are present.
+#if MBED_CONF_RTOS_PRESENT && MBED_CONF_EVENTS_PRESENT
+
+#include "AsyncBlockDevice.h"
+
+
+// Completion for blocking operations passed through the worker thread
+struct AsyncBlockDeviceCompletion {
+    rtos::Semaphore sem;
+    int err;
+
+    AsyncBlockDeviceCompletion() : sem(0), err(0) {}
+
+    void complete(int result) {
+        err = result;
+        sem.release();
+    }
+
+    int wait() {
+        sem.wait();
+        return err;
+    }
+};
+
+
+AsyncBlockDevice::AsyncBlockDevice(BlockDevice *bd,
+        unsigned queue_size, uint32_t stack_size, osPriority priority)
+    : _bd(bd), _queue(queue_size), _thread(priority, stack_size)
+    , _worker_id(0), _started(false)
+{
+}
+
+AsyncBlockDevice::~AsyncBlockDevice()
+{
+    if (_started) {
+        sync();
+        _queue.break_dispatch();
+        _thread.join();
+    }
+}
+
+int AsyncBlockDevice::init()
+{
+    if (!_started) {
+        osStatus status = _thread.start(callback(&_queue, &EventQueue::dispatch_forever));
+        if (status != osOK) {
+            return BD_ERROR_DEVICE_ERROR;
+        }
+
+        _started = true;
+        _queue.call(this, &AsyncBlockDevice::_bind);
+    }
+
+    int err = sync();
+    if (err) {
+        return err;
+    }
+
+    return _bd->init();
+}
+
+int AsyncBlockDevice::deinit()
+{
+    int err = sync();
+    if (err) {
+        return err;
+    }
+
+    return _bd->deinit();
+}
+
+void AsyncBlockDevice::_bind()
+{
+    _worker_id = rtos::Thread::gettid();
+}
+
+bool AsyncBlockDevice::_on_worker() const
+{
+    return _worker_id && _worker_id == rtos::Thread::gettid();
+}
+
+void AsyncBlockDevice::_read(void *buffer, bd_addr_t addr, bd_size_t size,
+        mbed::Callback<void(int)> callback)
+{
+    callback(_bd->read(buffer, addr, size));
+}
+
+void AsyncBlockDevice::_program(const void *buffer, bd_addr_t addr, bd_size_t size,
+        mbed::Callback<void(int)> callback)
+{
+    callback(_bd->program(buffer, addr, size));
+}
+
+void AsyncBlockDevice::_erase(bd_addr_t addr, bd_size_t size,
+        mbed::Callback<void(int)> callback)
+{
+    callback(_bd->erase(addr, size));
+}
+
+int AsyncBlockDevice::read_async(void *buffer, bd_addr_t addr, bd_size_t size,
+        mbed::Callback<void(int)> callback)
+{
+    MBED_ASSERT(_started);
+    int id = _queue.call(this, &AsyncBlockDevice::_read, buffer, addr, size, callback);
+    return id ? 0 : BD_ERROR_DEVICE_ERROR;
+}
+
+int AsyncBlockDevice::program_async(const void *buffer, bd_addr_t addr, bd_size_t size,
+        mbed::Callback<void(int)> callback)
+{
+    MBED_ASSERT(_started);
+    int id = _queue.call(this, &AsyncBlockDevice::_program, buffer, addr, size, callback);
+    return id ? 0 : BD_ERROR_DEVICE_ERROR;
+}
+
+int AsyncBlockDevice::erase_async(bd_addr_t addr, bd_size_t size,
+        mbed::Callback<void(int)> callback)
+{
+    MBED_ASSERT(_started);
+    int id = _queue.call(this, &AsyncBlockDevice::_erase, addr, size, callback);
+    return id ? 0 : BD_ERROR_DEVICE_ERROR;
+}
+
+int AsyncBlockDevice::read(void *buffer, bd_addr_t addr, bd_size_t size)
+{
+    // Operations issued from a completion callback are already in order
+    if (!_started || _on_worker()) {
+        return _bd->read(buffer, addr, size);
+    }
+
+    AsyncBlockDeviceCompletion done;
+    int err = read_async(buffer, addr, size,
+            callback(&done, &AsyncBlockDeviceCompletion::complete));
+    if (err) {
+        return err;
+    }
+
+    return done.wait();
+}
+
+int AsyncBlockDevice::program(const void *buffer, bd_addr_t addr, bd_size_t size)
+{
+    if (!_started || _on_worker()) {
+        return _bd->program(buffer, addr, size);
+    }
+
+    AsyncBlockDeviceCompletion done;
+    int err = program_async(buffer, addr, size,
+            callback(&done, &AsyncBlockDeviceCompletion::complete));
+    if (err) {
+        return err;
+    }
+
+    return done.wait();
+}
+
+int AsyncBlockDevice::erase(bd_addr_t addr, bd_size_t size)
+{
+    if (!_started || _on_worker()) {
+        return _bd->erase(addr, size);
+    }
+
+    AsyncBlockDeviceCompletion done;
+    int err = erase_async(addr, size,
+            callback(&done, &AsyncBlockDeviceCompletion::complete));
+    if (err) {
+        return err;
+    }
+
+    return done.wait();
+}
+
+int AsyncBlockDevice::sync()
+{
+    if (!_started || _on_worker()) {
+        return 0;
+    }
+
+    // The queue is in order, so a marker completes after everything before it
+    AsyncBlockDeviceCompletion done;
+    int id = _queue.call(&done, &AsyncBlockDeviceCompletion::complete, 0);
+    if (!id) {
+        return BD_ERROR_DEVICE_ERROR;
+    }
+
+    return done.wait();
+}
+
+bd_size_t AsyncBlockDevice::get_read_size() const
+{
+    return _bd->get_read_size();
+}
+
+bd_size_t AsyncBlockDevice::get_program_size() const
+{
+    return _bd->get_program_size();
+}
+
+bd_size_t AsyncBlockDevice::get_erase_size() const
+{
+    return _bd->get_erase_size();
+}
+
+bd_size_t AsyncBlockDevice::size() const
+{
+    return _bd->size();
+}
+
+#endif // MBED_CONF_RTOS_PRESENT && MBED_CONF_EVENTS_PRESENT
@@ -0,0 +1,197 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef MBED_ASYNC_BLOCK_DEVICE_H
+#define MBED_ASYNC_BLOCK_DEVICE_H
+
+#include "BlockDevice.h"
+#include "mbed.h"
+#include "mbed_events.h"
+#include "rtos.h"
+
+
+/** Block device adaptor that runs a blocking block device on a worker thread
+ *
+ *  Operations are queued and executed in order on a private thread, so
+ *  a long erase or program can overlap with other work. The blocking
+ *  functions wait for all previously queued operations to complete.
+ *
+ *  The adaptor needs the RTOS and the event queue, so it is not part of
+ *  mbed_filesystem.h and has to be included on its own.
+ *
+ *  @code
+ *  #include "mbed.h"
+ *  #include "HeapBlockDevice.h"
+ *  #include "AsyncBlockDevice.h"
+ *
+ *  HeapBlockDevice mem(64*512, 512);
+ *  AsyncBlockDevice async(&mem);
+ *
+ *  void erased(int err) {
+ *      printf("erase done: %d\n", err);
+ *  }
+ *
+ *  int main() {
+ *      async.init();
+ *      async.erase_async(0, 8*512, erased);
+ *      // ... other work while the erase runs ...
+ *      async.sync();
+ *  }
+ *  @endcode
+ */
+class AsyncBlockDevice : public BlockDevice
+{
+public:
+    /** Lifetime of the async block device
+     *
+     *  @param bd           Block device to run on the worker thread
+     *  @param queue_size   Size of the buffer used for queued operations in bytes
+     *  @param stack_size   Stack size of the worker thread in bytes
+     *  @param priority     Priority of the worker thread
+     */
+    AsyncBlockDevice(BlockDevice *bd,
+            unsigned queue_size = 8*EVENTS_EVENT_SIZE,
+            uint32_t stack_size = OS_STACK_SIZE,
+            osPriority priority = osPriorityNormal);
+    virtual ~AsyncBlockDevice();
+
+    /** Initialize a block device
+     *
+     *  Starts the worker thread if it is not already running
+     *
+     *  @return         0 on success or a negative error code on failure
+     */
+    virtual int init();
+
+    /** Deinitialize a block device
+     *
+     *  @return         0 on success or a negative error code on failure
+     */
+    virtual int deinit();
+
+    /** Read blocks from a block device
+     *
+     *  @param buffer   Buffer to read blocks into
+     *  @param addr     Address of block to begin reading from
+     *  @param size     Size to read in bytes, must be a multiple of read block size
+     *  @return         0 on success, negative error code on failure
+     */
+    virtual int read(void *buffer, bd_addr_t addr, bd_size_t size);
+
+    /** Program blocks to a block device
+     *
+     *  The blocks must have been erased prior to being programmed
+     *
+     *  @param buffer   Buffer of data to write to blocks
+     *  @param addr     Address of block to begin writing to
+     *  @param size     Size to write in bytes, must be a multiple of program block size
+     *  @return         0 on success, negative error code on failure
+     */
+    virtual int program(const void *buffer, bd_addr_t addr, bd_size_t size);
+
+    /** Erase blocks on a block device
+     *
+     *  The state of an erased block is undefined until it has been programmed
+     *
+     *  @param addr     Address of block to begin erasing
+     *  @param size     Size to erase in bytes, must be a multiple of erase block size
+     *  @return         0 on success, negative error code on failure
+     */
+    virtual int erase(bd_addr_t addr, bd_size_t size);
+
+    /** Read blocks from a block device asynchronously
+     *
+     *  The callback is called from the worker thread
+     *
+     *  @param buffer   Buffer to read blocks into
+     *  @param addr     Address of block to begin reading from
+     *  @param size     Size to read in bytes, must be a multiple of read block size
+     *  @param callback Called with 0 on success or a negative error code on failure
+     *  @return         0 if the read was queued, negative error code on failure
+     */
+    virtual int read_async(void *buffer, bd_addr_t addr, bd_size_t size,
+            mbed::Callback<void(int)> callback);
+
+    /** Program blocks to a block device asynchronously
+     *
+     *  The callback is called from the worker thread
+     *
+     *  @param buffer   Buffer of data to write to blocks
+     *  @param addr     Address of block to begin writing to
+     *  @param size     Size to write in bytes, must be a multiple of program block size
+     *  @param callback Called with 0 on success or a negative error code on failure
+     *  @return         0 if the program was queued, negative error code on failure
+     */
+    virtual int program_async(const void *buffer, bd_addr_t addr, bd_size_t size,
+            mbed::Callback<void(int)> callback);
+
+    /** Erase blocks on a block device asynchronously
+     *
+     *  The callback is called from the worker thread
+     *
+     *  @param addr     Address of block to begin erasing
+     *  @param size     Size to erase in bytes, must be a multiple of erase block size
+     *  @param callback Called with 0 on success or a negative error code on failure
+     *  @return         0 if the erase was queued, negative error code on failure
+     */
+    virtual int erase_async(bd_addr_t addr, bd_size_t size,
+            mbed::Callback<void(int)> callback);
+
+    /** Wait for all queued operations to complete
+     *
+     *  @return         0 on success, negative error code on failure
+     */
+    virtual int sync();
+
+    /** Get the size of a readable block
+     *
+     *  @return         Size of a readable block in bytes
+     */
+    virtual bd_size_t get_read_size() const;
+
+    /** Get the size of a programable block
+     *
+     *  @return         Size of a programable block in bytes
+     */
+    virtual bd_size_t get_program_size() const;
+
+    /** Get the size of a eraseable block
+     *
+     *  @return         Size of a eraseable block in bytes
+     */
+    virtual bd_size_t get_erase_size() const;
+
+    /** Get the total size of the underlying device
+     *
+     *  @return         Size of the underlying device in bytes
+     */
+    virtual bd_size_t size() const;
+
+protected:
+    void _bind();
+    void _read(void *buffer, bd_addr_t addr, bd_size_t size, mbed::Callback<void(int)> callback);
+    void _program(const void *buffer, bd_addr_t addr, bd_size_t size, mbed::Callback<void(int)> callback);
+    void _erase(bd_addr_t addr, bd_size_t size, mbed::Callback<void(int)> callback);
+    bool _on_worker() const;
+
+    BlockDevice *_bd;
+    events::EventQueue _queue;
+    rtos::Thread _thread;
+    osThreadId _worker_id;
+    bool _started;
+};
+
+
+#endif
@@ -18,6 +18,7 @@
 #define MBED_BLOCK_DEVICE_H
 
 #include <stdint.h>
+#include "platform/Callback.h"
 
 
 /** Enum of standard error codes
@@ -93,6 +94,64 @@ public:
      */
     virtual int erase(bd_addr_t addr, bd_size_t size) = 0;
 
+    /** Read blocks from a block device asynchronously
+     *
+     *  The callback is called with the result of the read once it has
+     *  completed. The buffer must remain valid until then. The default
+     *  implementation performs a blocking read and calls the callback
+     *  before returning.
+     *
+     *  @param buffer   Buffer to write blocks to
+     *  @param addr     Address of block to begin reading from
+     *  @param size     Size to read in bytes, must be a multiple of read block size
+     *  @param callback Called with 0 on success or a negative error code on failure
+     *  @return         0 if the read was started, negative error code on failure
+     */
+    virtual int read_async(void *buffer, bd_addr_t addr, bd_size_t size,
+            mbed::Callback<void(int)> callback)
+    {
+        callback(read(buffer, addr, size));
+        return 0;
+    }
+
+    /** Program blocks to a block device asynchronously
+     *
+     *  The callback is called with the result of the program once it has
+     *  completed. The buffer must remain valid until then. The default
+     *  implementation performs a blocking program and calls the callback
+     *  before returning.
+     *
+     *  @param buffer   Buffer of data to write to blocks
+     *  @param addr     Address of block to begin writing to
+     *  @param size     Size to write in bytes, must be a multiple of program block size
+     *  @param callback Called with 0 on success or a negative error code on failure
+     *  @return         0 if the program was started, negative error code on failure
+     */
+    virtual int program_async(const void *buffer, bd_addr_t addr, bd_size_t size,
+            mbed::Callback<void(int)> callback)
+    {
+        callback(program(buffer, addr, size));
+        return 0;
+    }
+
+    /** Erase blocks on a block device asynchronously
+     *
+     *  The callback is called with the result of the erase once it has
+     *  completed. The default implementation performs a blocking erase and
+     *  calls the callback before returning.
+     *
+     *  @param addr     Address of block to begin erasing
+     *  @param size     Size to erase in bytes, must be a multiple of erase block size
+     *  @param callback Called with 0 on success or a negative error code on failure
+     *  @return         0 if the erase was started, negative error code on failure
+     */
+    virtual int erase_async(bd_addr_t addr, bd_size_t size,
+            mbed::Callback<void(int)> callback)
+    {
+        callback(erase(addr, size));
+        return 0;
+    }
+
     /** Get the size of a readable block
      *
      *  @return         Size of a readable block in bytes
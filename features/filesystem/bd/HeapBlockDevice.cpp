@@ -20,6 +20,7 @@
 HeapBlockDevice::HeapBlockDevice(bd_size_t size, bd_size_t block)
     : _read_size(block), _program_size(block), _erase_size(block)
     , _count(size / block), _blocks(0)
+    , _read_latency(0), _program_latency(0), _erase_latency(0)
 {
     MBED_ASSERT(_count * _erase_size == size);
 }
@@ -27,6 +28,7 @@ HeapBlockDevice::HeapBlockDevice(bd_size_t size, bd_size_t block)
 HeapBlockDevice::HeapBlockDevice(bd_size_t size, bd_size_t read, bd_size_t program, bd_size_t erase)
     : _read_size(read), _program_size(program), _erase_size(erase)
     , _count(size / erase), _blocks(0)
+    , _read_latency(0), _program_latency(0), _erase_latency(0)
 {
     MBED_ASSERT(_count * _erase_size == size);
 }
@@ -62,6 +64,20 @@ int HeapBlockDevice::deinit()
     return BD_ERROR_OK;
 }
 
+void HeapBlockDevice::set_latency(uint32_t read, uint32_t program, uint32_t erase)
+{
+    _read_latency = read;
+    _program_latency = program;
+    _erase_latency = erase;
+}
+
+static void simulate_latency(uint32_t latency, bd_size_t blocks)
+{
+    if (latency) {
+        wait_us((int)(latency * blocks));
+    }
+}
+
 bd_size_t HeapBlockDevice::get_read_size() const
 {
     return _read_size;
@@ -86,6 +102,7 @@ int HeapBlockDevice::read(void *b, bd_addr_t addr, bd_size_t size)
 {
     MBED_ASSERT(is_valid_read(addr, size));
     uint8_t *buffer = static_cast<uint8_t*>(b);
+    simulate_latency(_read_latency, size / _read_size);
 
     while (size > 0) {
         bd_addr_t hi = addr / _erase_size;
@@ -109,6 +126,7 @@ int HeapBlockDevice::program(const void *b, bd_addr_t addr, bd_size_t size)
 {
     MBED_ASSERT(is_valid_program(addr, size));
     const uint8_t *buffer = static_cast<const uint8_t*>(b);
+    simulate_latency(_program_latency, size / _program_size);
 
     while (size > 0) {
         bd_addr_t hi = addr / _erase_size;
@@ -135,6 +153,7 @@ int HeapBlockDevice::erase(bd_addr_t addr, bd_size_t size)
 {
     MBED_ASSERT(is_valid_erase(addr, size));
     // TODO assert on programming unerased blocks
+    simulate_latency(_erase_latency, size / _erase_size);
 
     return 0;
 }
@@ -108,6 +108,18 @@ public:
      */
     virtual int erase(bd_addr_t addr, bd_size_t size);
 
+    /** Simulate the latency of a physical device
+     *
+     *  Each operation waits for the given time per block it covers, which
+     *  allows overlapping of slow operations to be measured without
+     *  hardware. Latency is disabled by default.
+     *
+     *  @param read     Time to wait per read block in microseconds
+     *  @param program  Time to wait per program block in microseconds
+     *  @param erase    Time to wait per erase block in microseconds
+     */
+    void set_latency(uint32_t read, uint32_t program, uint32_t erase);
+
     /** Get the size of a readable block
      *
      *  @return         Size of a readable block in bytes
@@ -138,6 +150,9 @@ private:
     bd_size_t _erase_size;
     bd_size_t _count;
     uint8_t **_blocks;
+    uint32_t _read_latency;
+    uint32_t _program_latency;
+    uint32_t _erase_latency;
 };
 
 
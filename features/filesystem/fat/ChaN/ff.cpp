@@ -1072,6 +1072,43 @@ DWORD clmt_clust (	/* <2:Error, >=2:Cluster number */
 
 
 
+/*-----------------------------------------------------------------------*/
+/* FAT handling - Extend a direct transfer over contiguous clusters      */
+/*-----------------------------------------------------------------------*/
+
+#if _FS_DIRECT_IO
+static
+DWORD direct_run (	/* Number of additional sectors, 0xFFFFFFFF:Disk error */
+	FIL* fp,		/* Pointer to the file object, fp->clust is the current cluster */
+	UINT nsect,		/* Number of whole sectors left after the current cluster */
+	int stretch		/* 0:Follow the cluster chain, 1:Stretch the chain if needed */
+)
+{
+	DWORD clst, nclst, run = 0;
+
+
+	clst = fp->clust;
+	while (nsect >= fp->fs->csize) {	/* Only whole clusters are taken */
+#if !_FS_READONLY
+		if (stretch)
+			nclst = create_chain(fp->fs, clst);
+		else
+#endif
+			nclst = get_fat(fp->fs, clst);
+		if (nclst == 0xFFFFFFFF) return 0xFFFFFFFF;
+		if (nclst != clst + 1) break;	/* Fragmented, end of chain or disk full */
+		clst = nclst;
+		run += fp->fs->csize;
+		nsect -= fp->fs->csize;
+	}
+	fp->clust = clst;	/* Last cluster covered by the run */
+	return run;
+}
+#endif	/* _FS_DIRECT_IO */
+
+
+
+
 /*-----------------------------------------------------------------------*/
 /* Directory handling - Set directory index                              */
 /*-----------------------------------------------------------------------*/
@@ -2649,8 +2686,14 @@ FRESULT f_read (
 			sect += csect;
 			cc = btr / SS(fp->fs);				/* When remaining bytes >= sector size, */
 			if (cc) {							/* Read maximum contiguous sectors directly */
-				if (csect + cc > fp->fs->csize)	/* Clip at cluster boundary */
+				if (csect + cc > fp->fs->csize) {	/* Clip at cluster boundary */
 					cc = fp->fs->csize - csect;
+#if _FS_DIRECT_IO
+					remain = direct_run(fp, btr / SS(fp->fs) - cc, 0);	/* Extend over contiguous clusters */
+					if (remain == 0xFFFFFFFF) ABORT(fp->fs, FR_DISK_ERR);
+					cc += (UINT)remain;
+#endif
+				}
 				if (disk_read(fp->fs->drv, rbuff, sect, cc) != RES_OK)
 					ABORT(fp->fs, FR_DISK_ERR);
 #if !_FS_READONLY && _FS_MINIMIZE <= 2			/* Replace one of the read sectors with cached data if it contains a dirty sector */
@@ -2771,8 +2814,14 @@ FRESULT f_write (
 			sect += csect;
 			cc = btw / SS(fp->fs);			/* When remaining bytes >= sector size, */
 			if (cc) {						/* Write maximum contiguous sectors directly */
-				if (csect + cc > fp->fs->csize)	/* Clip at cluster boundary */
+				if (csect + cc > fp->fs->csize) {	/* Clip at cluster boundary */
 					cc = fp->fs->csize - csect;
+#if _FS_DIRECT_IO
+					clst = direct_run(fp, btw / SS(fp->fs) - cc, 1);	/* Extend over contiguous clusters */
+					if (clst == 0xFFFFFFFF) ABORT(fp->fs, FR_DISK_ERR);
+					cc += (UINT)clst;
+#endif
+				}
 				if (disk_write(fp->fs->drv, wbuff, sect, cc) != RES_OK)
 					ABORT(fp->fs, FR_DISK_ERR);
 #if _FS_MINIMIZE <= 2
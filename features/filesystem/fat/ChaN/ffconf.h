@@ -49,6 +49,17 @@
 /* This option switches fast seek feature. (0:Disable or 1:Enable) */
 
 
+#if defined(MBED_CONF_FILESYSTEM_FAT_DIRECT_IO)
+#define _FS_DIRECT_IO	MBED_CONF_FILESYSTEM_FAT_DIRECT_IO
+#else
+#define _FS_DIRECT_IO	1
+#endif
+/* This option lets f_read() and f_write() transfer whole sectors directly
+/  between the caller's buffer and the disk over runs of physically contiguous
+/  clusters, instead of clipping every direct transfer at a cluster boundary.
+/  (0:Disable or 1:Enable) */
+
+
 #define _USE_LABEL		0
 /* This option switches volume label functions, f_getlabel() and f_setlabel().
 /  (0:Disable or 1:Enable) */
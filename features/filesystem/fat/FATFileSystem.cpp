@@ -131,6 +131,53 @@ void fat_filesystem_set_errno(FRESULT res)
 static BlockDevice *_ffs[_VOLUMES] = {0};
 static SingletonPtr<PlatformMutex> _ffs_mutex;
 
+// Pool of file objects, lets files be opened without touching the heap
+#ifndef MBED_CONF_FILESYSTEM_FAT_FILE_POOL_SIZE
+#define MBED_CONF_FILESYSTEM_FAT_FILE_POOL_SIZE 4
+#endif
+
+#if MBED_CONF_FILESYSTEM_FAT_FILE_POOL_SIZE > 32
+#error "filesystem.fat-file-pool-size must be 32 or less"
+#endif
+
+// Paths that fit this buffer are prefixed with the drive on the stack
+#define FFS_PATH_BUFFER_SIZE 64
+
+#if MBED_CONF_FILESYSTEM_FAT_FILE_POOL_SIZE > 0
+static FIL _ffs_files[MBED_CONF_FILESYSTEM_FAT_FILE_POOL_SIZE];
+static uint32_t _ffs_files_used = 0;
+#endif
+
+// Must be called with _ffs_mutex held
+static FIL *fat_file_alloc()
+{
+#if MBED_CONF_FILESYSTEM_FAT_FILE_POOL_SIZE > 0
+    for (int i = 0; i < MBED_CONF_FILESYSTEM_FAT_FILE_POOL_SIZE; i++) {
+        if (!(_ffs_files_used & (1UL << i))) {
+            _ffs_files_used |= 1UL << i;
+            return &_ffs_files[i];
+        }
+    }
+#endif
+
+    // Pool exhausted, fall back to the heap
+    return new FIL;
+}
+
+// Must be called with _ffs_mutex held
+static void fat_file_free(FIL *fh)
+{
+#if MBED_CONF_FILESYSTEM_FAT_FILE_POOL_SIZE > 0
+    if (fh >= &_ffs_files[0] &&
+        fh < &_ffs_files[MBED_CONF_FILESYSTEM_FAT_FILE_POOL_SIZE]) {
+        _ffs_files_used &= ~(1UL << (fh - &_ffs_files[0]));
+        return;
+    }
+#endif
+
+    delete fh;
+}
+
 
 // FAT driver functions
 DWORD get_fattime(void)
@@ -386,8 +433,12 @@ void FATFileSystem::unlock() {
 int FATFileSystem::file_open(fs_file_t *file, const char *path, int flags) {
     debug_if(FFS_DBG, "open(%s) on filesystem [%s], drv [%s]\n", path, getName(), _fsid);
 
-    FIL *fh = new FIL;
-    char *buffer = new char[strlen(_fsid) + strlen(path) + 3];
+    char stack_buffer[FFS_PATH_BUFFER_SIZE];
+    size_t buffer_size = strlen(_fsid) + strlen(path) + 2;
+    char *buffer = stack_buffer;
+    if (buffer_size > sizeof(stack_buffer)) {
+        buffer = new char[buffer_size];
+    }
     strcpy(buffer, _fsid);
     strcat(buffer, "/");
     strcat(buffer, path);
@@ -410,13 +461,17 @@ int FATFileSystem::file_open(fs_file_t *file, const char *path, int flags) {
     }
 
     lock();
+    FIL *fh = fat_file_alloc();
     FRESULT res = f_open(fh, buffer, openmode);
 
+    if (buffer != stack_buffer) {
+        delete[] buffer;
+    }
+
     if (res != FR_OK) {
+        fat_file_free(fh);
         unlock();
         debug_if(FFS_DBG, "f_open('w') failed: %d\n", res);
-        delete[] buffer;
-        delete fh;
         return fat_error_remap(res);
     }
 
@@ -425,7 +480,6 @@ int FATFileSystem::file_open(fs_file_t *file, const char *path, int flags) {
     }
     unlock();
 
-    delete[] buffer;
     *file = fh;
     return 0;
 }
@@ -435,9 +489,9 @@ int FATFileSystem::file_close(fs_file_t file) {
 
     lock();
     FRESULT res = f_close(fh);
+    fat_file_free(fh);
     unlock();
 
-    delete fh;
     return fat_error_remap(res);
 }
 
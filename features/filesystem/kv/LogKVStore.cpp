@@ -0,0 +1,1136 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "LogKVStore.h"
+#include "mbed_assert.h"
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+////// On-disk format //////
+
+#define LOGKV_SECTOR_MAGIC  0x53564b4c  // "LKVS"
+#define LOGKV_RECORD_MAGIC  0x4b56      // "VK"
+#define LOGKV_VERSION       1
+
+#define LOGKV_KEY_MAX       255
+#define LOGKV_CHUNK_SIZE    32
+
+// Internal result of _check for records that are not valid
+#define LOGKV_INVALID       1
+
+enum {
+    LOGKV_TYPE_SET      = 1,
+    LOGKV_TYPE_REMOVE   = 2,
+};
+
+// Written at the start of a sector when it is activated
+struct logkv_sector_header {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t reserved;
+    uint32_t seq;
+    uint32_t crc;
+};
+
+// Followed by the key, the value and a crc32 over all three, seeded with
+// the sequence number of the sector so that records left over from a
+// previous use of the sector are never taken for current ones
+struct logkv_record_header {
+    uint16_t magic;
+    uint8_t type;
+    uint8_t key_size;
+    uint32_t value_size;
+    uint32_t flags;
+};
+
+
+////// Helpers //////
+
+static uint32_t logkv_crc32(uint32_t crc, const void *buffer, size_t size)
+{
+    static const uint32_t table[16] = {
+        0x00000000, 0x1db71064, 0x3b6e20c8, 0x26d930ac,
+        0x76dc4190, 0x6b6b51f4, 0x4db26158, 0x5005713c,
+        0xedb88320, 0xf00f9344, 0xd6d6a3e8, 0xcb61b38c,
+        0x9b64c2b0, 0x86d3d2d4, 0xa00ae278, 0xbdbdf21c,
+    };
+
+    const uint8_t *data = static_cast<const uint8_t*>(buffer);
+    for (size_t i = 0; i < size; i++) {
+        crc = (crc >> 4) ^ table[(crc ^ (data[i] >> 0)) & 0xf];
+        crc = (crc >> 4) ^ table[(crc ^ (data[i] >> 4)) & 0xf];
+    }
+
+    return crc;
+}
+
+static uint32_t logkv_record_crc(uint32_t seq)
+{
+    return logkv_crc32(0xffffffff, &seq, sizeof(seq));
+}
+
+// FNV-1a
+static uint32_t logkv_hash(const char *key, uint8_t key_size)
+{
+    uint32_t hash = 2166136261u;
+    for (uint8_t i = 0; i < key_size; i++) {
+        hash = (hash ^ (uint8_t)key[i]) * 16777619u;
+    }
+
+    return hash;
+}
+
+static bd_size_t logkv_align(bd_size_t size, bd_size_t alignment)
+{
+    return ((size + alignment - 1) / alignment) * alignment;
+}
+
+
+////// Lifetime //////
+
+LogKVStore::LogKVStore(BlockDevice *bd, bd_size_t sector_size)
+    : _bd(bd), _sector_size(sector_size), _sector_count(0), _mounted(false)
+    , _oldest(0), _head(0), _head_off(0), _seq(0)
+    , _index(NULL), _index_count(0), _index_capacity(0)
+    , _read_buffer(NULL), _program_buffer(NULL), _program_buffer_size(0)
+    , _program_addr(0), _program_fill(0)
+{
+}
+
+LogKVStore::~LogKVStore()
+{
+    unmount();
+}
+
+int LogKVStore::_setup()
+{
+    bd_size_t erase_size = _bd->get_erase_size();
+    if (!_sector_size) {
+        _sector_size = erase_size;
+    }
+
+    if (_sector_size % erase_size != 0 ||
+        _sector_size % _bd->get_program_size() != 0) {
+        return -EINVAL;
+    }
+
+    // At least one sector must always be free for garbage collection
+    bd_size_t count = _bd->size() / _sector_size;
+    if (count < 2 || _bd->size() > 0xffffffff) {
+        return -EINVAL;
+    }
+    _sector_count = count;
+
+    if (!_read_buffer) {
+        _read_buffer = new uint8_t[_bd->get_read_size()];
+    }
+
+    if (!_program_buffer) {
+        _program_buffer_size = logkv_align(LOGKV_CHUNK_SIZE, _bd->get_program_size());
+        _program_buffer = new uint8_t[_program_buffer_size];
+    }
+
+    _index_count = 0;
+    return 0;
+}
+
+int LogKVStore::format()
+{
+    _mutex.lock();
+    if (_mounted) {
+        _mutex.unlock();
+        return -EINVAL;
+    }
+
+    int err = _setup();
+    if (err) {
+        _mutex.unlock();
+        return err;
+    }
+
+    // Erasing is not guaranteed to clear the headers of a previous store
+    for (uint32_t i = 0; i < _sector_count; i++) {
+        err = _retire(i);
+        if (err) {
+            _mutex.unlock();
+            return err;
+        }
+    }
+
+    _seq = 0;
+    _oldest = 0;
+    err = _activate(0);
+    if (err) {
+        _mutex.unlock();
+        return err;
+    }
+
+    _mounted = true;
+    _mutex.unlock();
+    return 0;
+}
+
+int LogKVStore::mount()
+{
+    _mutex.lock();
+    if (_mounted) {
+        _mutex.unlock();
+        return -EINVAL;
+    }
+
+    int err = _setup();
+    if (err) {
+        _mutex.unlock();
+        return err;
+    }
+
+    // Find the oldest and newest sectors of the ring
+    bool found = false;
+    uint32_t oldest_seq = 0;
+    for (uint32_t i = 0; i < _sector_count; i++) {
+        uint32_t seq;
+        err = _sector_seq(i, &seq);
+        if (err < 0) {
+            _mutex.unlock();
+            return err;
+        } else if (err) {
+            continue;
+        }
+
+        if (!found || seq < oldest_seq) {
+            oldest_seq = seq;
+            _oldest = i;
+        }
+
+        if (!found || seq > _seq) {
+            _seq = seq;
+            _head = i;
+        }
+
+        found = true;
+    }
+
+    if (!found) {
+        _mutex.unlock();
+        return -ENOENT;
+    }
+
+    // Advancing into the last free sector is followed by collecting the
+    // oldest one. If the power was cut in between there is no free sector
+    // left, and the head only holds copies of records that are still in
+    // the oldest sector, so start the head over and collect again
+    bool recollect = (_oldest != _head && (_head + 1) % _sector_count == _oldest);
+    if (recollect) {
+        err = _activate(_head);
+        if (err) {
+            _mutex.unlock();
+            return err;
+        }
+    }
+
+    // Replay the log from oldest to newest, later records win
+    for (uint32_t i = _oldest; ; i = (i + 1) % _sector_count) {
+        uint32_t seq;
+        err = _sector_seq(i, &seq);
+        if (err < 0) {
+            _free_index();
+            _mutex.unlock();
+            return err;
+        }
+
+        if (!err) {
+            err = _scan(i, seq, &_head_off);
+            if (err) {
+                _free_index();
+                _mutex.unlock();
+                return err;
+            }
+        }
+
+        if (i == _head) {
+            break;
+        }
+    }
+
+    // Anything after the last valid record is either unwritten or an
+    // interrupted write. Flash can't be programmed twice, so in the
+    // latter case leave the rest of the head sector unused. A head that
+    // was just started over has nothing after its header.
+    struct logkv_record_header header;
+    if (!recollect && _head_off + sizeof(header) <= _sector_size) {
+        err = _read(_sector_addr(_head) + _head_off, &header, sizeof(header));
+        if (err) {
+            _free_index();
+            _mutex.unlock();
+            return err;
+        }
+
+        const uint8_t *bytes = reinterpret_cast<const uint8_t*>(&header);
+        for (size_t i = 1; i < sizeof(header); i++) {
+            if (bytes[i] != bytes[0]) {
+                _head_off = _sector_size;
+                break;
+            }
+        }
+    }
+
+    if (recollect) {
+        err = _collect();
+        if (err) {
+            _free_index();
+            _mutex.unlock();
+            return err;
+        }
+    }
+
+    _mounted = true;
+    _mutex.unlock();
+    return 0;
+}
+
+int LogKVStore::unmount()
+{
+    _mutex.lock();
+    if (!_mounted) {
+        _mutex.unlock();
+        return -EINVAL;
+    }
+
+    _free_index();
+
+    delete[] _read_buffer;
+    _read_buffer = NULL;
+    delete[] _program_buffer;
+    _program_buffer = NULL;
+
+    _mounted = false;
+    _mutex.unlock();
+    return 0;
+}
+
+
+////// Key-value operations //////
+
+int LogKVStore::set(const char *key, const void *buffer, size_t size, uint32_t flags)
+{
+    size_t key_size = strlen(key);
+    if (key_size == 0 || key_size > LOGKV_KEY_MAX) {
+        return -EINVAL;
+    }
+
+    _mutex.lock();
+    if (!_mounted) {
+        _mutex.unlock();
+        return -EINVAL;
+    }
+
+    if (_data_start() + _record_size(key_size, size) > _sector_size) {
+        _mutex.unlock();
+        return -ENOSPC;
+    }
+
+    uint32_t hash = logkv_hash(key, key_size);
+    size_t pos;
+    int found = _find(key, key_size, hash, &pos);
+    if (found < 0) {
+        _mutex.unlock();
+        return found;
+    }
+
+    // Make sure the index can't fail after the record is committed
+    int err = _index_reserve(_index_count + 1);
+    if (err) {
+        _mutex.unlock();
+        return err;
+    }
+
+    uint32_t addr;
+    err = _append(LOGKV_TYPE_SET, key, key_size, buffer, size, flags, &addr);
+    if (err) {
+        _mutex.unlock();
+        return err;
+    }
+
+    // Garbage collection only moves records, so pos is still valid
+    if (found) {
+        _index[pos].addr = addr;
+    } else {
+        _index_insert(pos, hash, addr);
+    }
+
+    _mutex.unlock();
+    return 0;
+}
+
+ssize_t LogKVStore::get(const char *key, void *buffer, size_t size, uint32_t *flags)
+{
+    size_t key_size = strlen(key);
+    if (key_size == 0 || key_size > LOGKV_KEY_MAX) {
+        return -EINVAL;
+    }
+
+    _mutex.lock();
+    if (!_mounted) {
+        _mutex.unlock();
+        return -EINVAL;
+    }
+
+    size_t pos;
+    int found = _find(key, key_size, logkv_hash(key, key_size), &pos);
+    if (found <= 0) {
+        _mutex.unlock();
+        return found < 0 ? found : -ENOENT;
+    }
+
+    struct logkv_record_header header;
+    uint32_t addr = _index[pos].addr;
+    int err = _read(addr, &header, sizeof(header));
+    if (err) {
+        _mutex.unlock();
+        return err;
+    }
+
+    if (buffer && size > 0) {
+        if (size > header.value_size) {
+            size = header.value_size;
+        }
+
+        err = _read(addr + sizeof(header) + header.key_size, buffer, size);
+        if (err) {
+            _mutex.unlock();
+            return err;
+        }
+    }
+
+    if (flags) {
+        *flags = header.flags;
+    }
+
+    _mutex.unlock();
+    return header.value_size;
+}
+
+int LogKVStore::remove(const char *key)
+{
+    size_t key_size = strlen(key);
+    if (key_size == 0 || key_size > LOGKV_KEY_MAX) {
+        return -EINVAL;
+    }
+
+    _mutex.lock();
+    if (!_mounted) {
+        _mutex.unlock();
+        return -EINVAL;
+    }
+
+    size_t pos;
+    int found = _find(key, key_size, logkv_hash(key, key_size), &pos);
+    if (found <= 0) {
+        _mutex.unlock();
+        return found < 0 ? found : -ENOENT;
+    }
+
+    // Older records of the key stay on disk until their sector is
+    // collected, so the removal must be logged
+    uint32_t addr;
+    int err = _append(LOGKV_TYPE_REMOVE, key, key_size, NULL, 0, 0, &addr);
+    if (err) {
+        _mutex.unlock();
+        return err;
+    }
+
+    _index_remove(pos);
+    _mutex.unlock();
+    return 0;
+}
+
+size_t LogKVStore::count()
+{
+    _mutex.lock();
+    size_t count = _index_count;
+    _mutex.unlock();
+    return count;
+}
+
+ssize_t LogKVStore::key_at(size_t index, char *key, size_t size)
+{
+    _mutex.lock();
+    if (!_mounted || index >= _index_count) {
+        _mutex.unlock();
+        return -EINVAL;
+    }
+
+    struct logkv_record_header header;
+    uint32_t addr = _index[index].addr;
+    int err = _read(addr, &header, sizeof(header));
+    if (err) {
+        _mutex.unlock();
+        return err;
+    }
+
+    if (size < (size_t)header.key_size + 1) {
+        _mutex.unlock();
+        return -ENAMETOOLONG;
+    }
+
+    err = _read(addr + sizeof(header), key, header.key_size);
+    if (err) {
+        _mutex.unlock();
+        return err;
+    }
+    key[header.key_size] = '\0';
+
+    _mutex.unlock();
+    return header.key_size;
+}
+
+int LogKVStore::gc()
+{
+    _mutex.lock();
+    if (!_mounted) {
+        _mutex.unlock();
+        return -EINVAL;
+    }
+
+    int err = 0;
+    if (_oldest != _head) {
+        err = _collect();
+        if (err == -ENOSPC) {
+            // Not enough room in the head yet, set() will collect later
+            err = 0;
+        }
+    }
+
+    _mutex.unlock();
+    return err;
+}
+
+
+////// Log management //////
+
+int LogKVStore::_sector_seq(uint32_t sector, uint32_t *seq)
+{
+    struct logkv_sector_header header;
+    int err = _read(_sector_addr(sector), &header, sizeof(header));
+    if (err) {
+        return err;
+    }
+
+    if (header.magic != LOGKV_SECTOR_MAGIC ||
+        header.version != LOGKV_VERSION ||
+        header.crc != logkv_crc32(0xffffffff, &header, offsetof(logkv_sector_header, crc))) {
+        return LOGKV_INVALID;
+    }
+
+    *seq = header.seq;
+    return 0;
+}
+
+int LogKVStore::_activate(uint32_t sector)
+{
+    int err = _bd->erase(_sector_addr(sector), _sector_size);
+    if (err) {
+        return err;
+    }
+
+    struct logkv_sector_header header;
+    memset(&header, 0, sizeof(header));
+    header.magic = LOGKV_SECTOR_MAGIC;
+    header.version = LOGKV_VERSION;
+    header.seq = ++_seq;
+    header.crc = logkv_crc32(0xffffffff, &header, offsetof(logkv_sector_header, crc));
+
+    _head = sector;
+    _head_off = _sector_size;
+    _program_addr = _sector_addr(sector);
+    _program_fill = 0;
+    err = _program(&header, sizeof(header));
+    if (!err) {
+        err = _program_flush();
+    }
+    if (err) {
+        return err;
+    }
+
+    _head_off = _data_start();
+    return 0;
+}
+
+int LogKVStore::_retire(uint32_t sector)
+{
+    int err = _bd->erase(_sector_addr(sector), _sector_size);
+    if (err) {
+        return err;
+    }
+
+    // Erasing does not necessarily clear the old header, which would
+    // otherwise bring the sector back into the ring on the next mount
+    struct logkv_sector_header header;
+    memset(&header, 0, sizeof(header));
+
+    _program_addr = _sector_addr(sector);
+    _program_fill = 0;
+    err = _program(&header, sizeof(header));
+    if (!err) {
+        err = _program_flush();
+    }
+
+    return err;
+}
+
+int LogKVStore::_advance()
+{
+    uint32_t next = (_head + 1) % _sector_count;
+    if (next == _oldest) {
+        return -ENOSPC;
+    }
+
+    int err = _activate(next);
+    if (err) {
+        return err;
+    }
+
+    // Keep a free sector for the next advance
+    if ((next + 1) % _sector_count == _oldest) {
+        err = _collect();
+        if (err) {
+            return err;
+        }
+    }
+
+    return 0;
+}
+
+int LogKVStore::_collect()
+{
+    MBED_ASSERT(_oldest != _head);
+    bd_addr_t start = _sector_addr(_oldest);
+
+    uint32_t seq;
+    int err = _sector_seq(_oldest, &seq);
+    if (err) {
+        return err < 0 ? err : -EIO;
+    }
+
+    // Live records are the ones the index still points to, make sure
+    // they fit in the head before moving anything
+    for (int pass = 0; pass < 2; pass++) {
+        bd_size_t live = 0;
+        bd_addr_t off = _data_start();
+        while (off + sizeof(logkv_record_header) + sizeof(uint32_t) <= _sector_size) {
+            uint8_t type;
+            uint8_t key_size;
+            uint32_t value_size;
+            uint32_t addr = start + off;
+            err = _check(addr, seq, &type, &key_size, &value_size);
+            if (err < 0) {
+                return err;
+            } else if (err) {
+                break;
+            }
+
+            bd_size_t size = _record_size(key_size, value_size);
+            if (type == LOGKV_TYPE_SET) {
+                size_t pos = _index_pos(addr, key_size);
+                if (pos < _index_count) {
+                    if (pass == 0) {
+                        live += size;
+                    } else {
+                        uint32_t new_addr;
+                        err = _copy(addr, size, &new_addr);
+                        if (err) {
+                            return err;
+                        }
+
+                        _index[pos].addr = new_addr;
+                    }
+                }
+            }
+
+            off += size;
+        }
+
+        if (pass == 0 && _head_off + live > _sector_size) {
+            return -ENOSPC;
+        }
+    }
+
+    // Everything live is now in the head, the sector can go
+    err = _retire(_oldest);
+    if (err) {
+        return err;
+    }
+
+    _oldest = (_oldest + 1) % _sector_count;
+    return 0;
+}
+
+int LogKVStore::_scan(uint32_t sector, uint32_t seq, bd_addr_t *end)
+{
+    bd_addr_t start = _sector_addr(sector);
+    bd_addr_t off = _data_start();
+    while (off + sizeof(logkv_record_header) + sizeof(uint32_t) <= _sector_size) {
+        uint8_t type;
+        uint8_t key_size;
+        uint32_t value_size;
+        uint32_t addr = start + off;
+        int err = _check(addr, seq, &type, &key_size, &value_size);
+        if (err < 0) {
+            return err;
+        } else if (err) {
+            break;
+        }
+
+        char key[LOGKV_KEY_MAX];
+        err = _read(addr + sizeof(logkv_record_header), key, key_size);
+        if (err) {
+            return err;
+        }
+
+        uint32_t hash = logkv_hash(key, key_size);
+        size_t pos;
+        int found = _find(key, key_size, hash, &pos);
+        if (found < 0) {
+            return found;
+        }
+
+        if (type == LOGKV_TYPE_SET) {
+            if (found) {
+                _index[pos].addr = addr;
+            } else {
+                err = _index_reserve(_index_count + 1);
+                if (err) {
+                    return err;
+                }
+
+                _index_insert(pos, hash, addr);
+            }
+        } else if (found) {
+            _index_remove(pos);
+        }
+
+        off += _record_size(key_size, value_size);
+    }
+
+    *end = off;
+    return 0;
+}
+
+int LogKVStore::_check(uint32_t addr, uint32_t seq,
+        uint8_t *type, uint8_t *key_size, uint32_t *value_size)
+{
+    struct logkv_record_header header;
+    int err = _read(addr, &header, sizeof(header));
+    if (err) {
+        return err;
+    }
+
+    if (header.magic != LOGKV_RECORD_MAGIC ||
+        (header.type != LOGKV_TYPE_SET && header.type != LOGKV_TYPE_REMOVE) ||
+        header.key_size == 0) {
+        return LOGKV_INVALID;
+    }
+
+    bd_addr_t end = addr - (addr % _sector_size) + _sector_size;
+    if (header.value_size > _sector_size ||
+        addr + _record_size(header.key_size, header.value_size) > end) {
+        return LOGKV_INVALID;
+    }
+
+    uint32_t crc = logkv_crc32(logkv_record_crc(seq), &header, sizeof(header));
+    bd_size_t size = header.key_size + header.value_size;
+    bd_addr_t pos = addr + sizeof(header);
+    while (size > 0) {
+        uint8_t chunk[LOGKV_CHUNK_SIZE];
+        bd_size_t chunk_size = size < sizeof(chunk) ? size : sizeof(chunk);
+        err = _read(pos, chunk, chunk_size);
+        if (err) {
+            return err;
+        }
+
+        crc = logkv_crc32(crc, chunk, chunk_size);
+        pos += chunk_size;
+        size -= chunk_size;
+    }
+
+    uint32_t stored;
+    err = _read(pos, &stored, sizeof(stored));
+    if (err) {
+        return err;
+    }
+
+    if (stored != ~crc) {
+        return LOGKV_INVALID;
+    }
+
+    *type = header.type;
+    *key_size = header.key_size;
+    *value_size = header.value_size;
+    return 0;
+}
+
+int LogKVStore::_append(uint8_t type, const char *key, uint8_t key_size,
+        const void *buffer, size_t size, uint32_t flags, uint32_t *addr)
+{
+    bd_size_t record_size = _record_size(key_size, size);
+
+    // Each advance collects at most one sector, give up once every
+    // sector has been tried without making room
+    for (uint32_t i = 0; _head_off + record_size > _sector_size; i++) {
+        if (i >= _sector_count) {
+            return -ENOSPC;
+        }
+
+        int err = _advance();
+        if (err) {
+            return err;
+        }
+    }
+
+    struct logkv_record_header header;
+    header.magic = LOGKV_RECORD_MAGIC;
+    header.type = type;
+    header.key_size = key_size;
+    header.value_size = size;
+    header.flags = flags;
+
+    uint32_t crc = logkv_record_crc(_seq);
+    crc = logkv_crc32(crc, &header, sizeof(header));
+    crc = logkv_crc32(crc, key, key_size);
+    crc = logkv_crc32(crc, buffer, size);
+    crc = ~crc;
+
+    bd_addr_t start = _sector_addr(_head) + _head_off;
+    _program_addr = start;
+    _program_fill = 0;
+
+    // The record only becomes valid once the crc is programmed
+    int err = _program(&header, sizeof(header));
+    if (!err) {
+        err = _program(key, key_size);
+    }
+    if (!err) {
+        err = _program(buffer, size);
+    }
+    if (!err) {
+        err = _program(&crc, sizeof(crc));
+    }
+    if (!err) {
+        err = _program_flush();
+    }
+    if (err) {
+        // Partially programmed, don't append anything else here
+        _head_off = _sector_size;
+        return err;
+    }
+
+    *addr = start;
+    _head_off += record_size;
+    return 0;
+}
+
+int LogKVStore::_copy(uint32_t addr, bd_size_t record_size, uint32_t *new_addr)
+{
+    bd_addr_t start = _sector_addr(_head) + _head_off;
+    _program_addr = start;
+    _program_fill = 0;
+
+    // Padding is rewritten by the flush, the crc is recomputed for the
+    // sequence number of the head
+    struct logkv_record_header header;
+    int err = _read(addr, &header, sizeof(header));
+    if (!err) {
+        err = _program(&header, sizeof(header));
+    }
+    if (err) {
+        _head_off = _sector_size;
+        return err;
+    }
+
+    uint32_t crc = logkv_crc32(logkv_record_crc(_seq), &header, sizeof(header));
+    bd_size_t size = header.key_size + header.value_size;
+    bd_addr_t pos = addr + sizeof(header);
+    while (size > 0) {
+        uint8_t chunk[LOGKV_CHUNK_SIZE];
+        bd_size_t chunk_size = size < sizeof(chunk) ? size : sizeof(chunk);
+        err = _read(pos, chunk, chunk_size);
+        if (!err) {
+            err = _program(chunk, chunk_size);
+        }
+        if (err) {
+            _head_off = _sector_size;
+            return err;
+        }
+
+        crc = logkv_crc32(crc, chunk, chunk_size);
+        pos += chunk_size;
+        size -= chunk_size;
+    }
+
+    crc = ~crc;
+    err = _program(&crc, sizeof(crc));
+    if (!err) {
+        err = _program_flush();
+    }
+    if (err) {
+        _head_off = _sector_size;
+        return err;
+    }
+
+    *new_addr = start;
+    _head_off += record_size;
+    return 0;
+}
+
+
+////// Index //////
+
+size_t LogKVStore::_index_lower_bound(uint32_t hash)
+{
+    size_t lo = 0;
+    size_t hi = _index_count;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (_index[mid].hash < hash) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    return lo;
+}
+
+int LogKVStore::_find(const char *key, uint8_t key_size, uint32_t hash, size_t *pos)
+{
+    size_t lower = _index_lower_bound(hash);
+    for (size_t i = lower; i < _index_count && _index[i].hash == hash; i++) {
+        int equal = _key_equal(_index[i].addr, key, key_size);
+        if (equal < 0) {
+            return equal;
+        } else if (equal) {
+            *pos = i;
+            return 1;
+        }
+    }
+
+    *pos = lower;
+    return 0;
+}
+
+size_t LogKVStore::_index_pos(uint32_t addr, uint8_t key_size)
+{
+    char key[LOGKV_KEY_MAX];
+    int err = _read(addr + sizeof(logkv_record_header), key, key_size);
+    if (err) {
+        return _index_count;
+    }
+
+    uint32_t hash = logkv_hash(key, key_size);
+    for (size_t i = _index_lower_bound(hash); i < _index_count && _index[i].hash == hash; i++) {
+        if (_index[i].addr == addr) {
+            return i;
+        }
+    }
+
+    return _index_count;
+}
+
+int LogKVStore::_key_equal(uint32_t addr, const char *key, uint8_t key_size)
+{
+    struct logkv_record_header header;
+    int err = _read(addr, &header, sizeof(header));
+    if (err) {
+        return err;
+    }
+
+    if (header.key_size != key_size) {
+        return 0;
+    }
+
+    bd_addr_t pos = addr + sizeof(header);
+    while (key_size > 0) {
+        uint8_t chunk[LOGKV_CHUNK_SIZE];
+        uint8_t chunk_size = key_size < sizeof(chunk) ? key_size : sizeof(chunk);
+        err = _read(pos, chunk, chunk_size);
+        if (err) {
+            return err;
+        }
+
+        if (memcmp(chunk, key, chunk_size) != 0) {
+            return 0;
+        }
+
+        key += chunk_size;
+        pos += chunk_size;
+        key_size -= chunk_size;
+    }
+
+    return 1;
+}
+
+int LogKVStore::_index_reserve(size_t count)
+{
+    if (count <= _index_capacity) {
+        return 0;
+    }
+
+    size_t capacity = _index_capacity ? 2*_index_capacity : 8;
+    while (capacity < count) {
+        capacity *= 2;
+    }
+
+    index_entry *index = static_cast<index_entry*>(
+            realloc(_index, capacity*sizeof(index_entry)));
+    if (!index) {
+        return -ENOMEM;
+    }
+
+    _index = index;
+    _index_capacity = capacity;
+    return 0;
+}
+
+void LogKVStore::_index_insert(size_t pos, uint32_t hash, uint32_t addr)
+{
+    MBED_ASSERT(_index_count < _index_capacity);
+    memmove(&_index[pos+1], &_index[pos], (_index_count - pos)*sizeof(index_entry));
+    _index[pos].hash = hash;
+    _index[pos].addr = addr;
+    _index_count += 1;
+}
+
+void LogKVStore::_index_remove(size_t pos)
+{
+    memmove(&_index[pos], &_index[pos+1], (_index_count - pos - 1)*sizeof(index_entry));
+    _index_count -= 1;
+}
+
+void LogKVStore::_free_index()
+{
+    free(_index);
+    _index = NULL;
+    _index_count = 0;
+    _index_capacity = 0;
+}
+
+
+////// Block device access //////
+
+bd_size_t LogKVStore::_record_size(uint8_t key_size, uint32_t value_size) const
+{
+    return logkv_align(sizeof(logkv_record_header) + key_size + value_size + sizeof(uint32_t),
+            _bd->get_program_size());
+}
+
+bd_addr_t LogKVStore::_sector_addr(uint32_t sector) const
+{
+    return (bd_addr_t)sector * _sector_size;
+}
+
+bd_addr_t LogKVStore::_data_start() const
+{
+    return logkv_align(sizeof(logkv_sector_header), _bd->get_program_size());
+}
+
+int LogKVStore::_read(bd_addr_t addr, void *b, bd_size_t size)
+{
+    uint8_t *buffer = static_cast<uint8_t*>(b);
+    bd_size_t read_size = _bd->get_read_size();
+
+    while (size > 0) {
+        bd_size_t off = addr % read_size;
+        if (off == 0 && size >= read_size) {
+            // Aligned, read straight into the caller's buffer
+            bd_size_t chunk = size - (size % read_size);
+            int err = _bd->read(buffer, addr, chunk);
+            if (err) {
+                return err;
+            }
+
+            buffer += chunk;
+            addr += chunk;
+            size -= chunk;
+        } else {
+            int err = _bd->read(_read_buffer, addr - off, read_size);
+            if (err) {
+                return err;
+            }
+
+            bd_size_t chunk = read_size - off;
+            if (chunk > size) {
+                chunk = size;
+            }
+
+            memcpy(buffer, &_read_buffer[off], chunk);
+            buffer += chunk;
+            addr += chunk;
+            size -= chunk;
+        }
+    }
+
+    return 0;
+}
+
+int LogKVStore::_program(const void *b, bd_size_t size)
+{
+    const uint8_t *buffer = static_cast<const uint8_t*>(b);
+
+    while (size > 0) {
+        bd_size_t chunk = _program_buffer_size - _program_fill;
+        if (chunk > size) {
+            chunk = size;
+        }
+
+        memcpy(&_program_buffer[_program_fill], buffer, chunk);
+        _program_fill += chunk;
+        buffer += chunk;
+        size -= chunk;
+
+        if (_program_fill == _program_buffer_size) {
+            int err = _bd->program(_program_buffer, _program_addr, _program_buffer_size);
+            if (err) {
+                return err;
+            }
+
+            _program_addr += _program_buffer_size;
+            _program_fill = 0;
+        }
+    }
+
+    return 0;
+}
+
+int LogKVStore::_program_flush()
+{
+    if (_program_fill == 0) {
+        return 0;
+    }
+
+    bd_size_t size = logkv_align(_program_fill, _bd->get_program_size());
+    memset(&_program_buffer[_program_fill], 0xff, size - _program_fill);
+
+    int err = _bd->program(_program_buffer, _program_addr, size);
+    if (err) {
+        return err;
+    }
+
+    _program_addr += size;
+    _program_fill = 0;
+    return 0;
+}
@@ -0,0 +1,225 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef MBED_LOG_KV_STORE_H
+#define MBED_LOG_KV_STORE_H
+
+#include "BlockDevice.h"
+#include "PlatformMutex.h"
+#include <stdint.h>
+#include <stddef.h>
+#include <sys/types.h>
+
+
+/** Log-structured key-value store on a block device
+ *
+ *  Each set or remove appends a single record to a log, so the flash
+ *  traffic of a commit is proportional to the size of the change rather
+ *  than to the size of the store. A record is committed atomically once
+ *  its trailing CRC has been programmed, an interrupted write is
+ *  discarded on the next mount.
+ *
+ *  The device is split into sectors of one or more erase blocks, used as
+ *  a ring. Only a compact index of key hashes to record addresses is kept
+ *  in RAM. When the log wraps, the oldest sector is garbage collected by
+ *  copying its live records to the head and erasing it, one sector at a
+ *  time, so at least one sector is always kept free. A collected sector
+ *  is marked as such rather than relying on the erase to clear it.
+ *
+ *  @code
+ *  #include "mbed.h"
+ *  #include "HeapBlockDevice.h"
+ *  #include "LogKVStore.h"
+ *
+ *  HeapBlockDevice bd(16*512, 512);
+ *  LogKVStore kv(&bd);
+ *
+ *  int main() {
+ *      bd.init();
+ *      if (kv.mount()) {
+ *          kv.format();
+ *      }
+ *
+ *      kv.set("hello", "world", 6);
+ *
+ *      char value[6];
+ *      kv.get("hello", value, sizeof(value));
+ *      printf("%s\n", value);
+ *
+ *      kv.unmount();
+ *      bd.deinit();
+ *  }
+ *  @endcode
+ *
+ *  @note Synchronization level: Thread safe
+ */
+class LogKVStore
+{
+public:
+    /** Lifetime of the key-value store
+     *
+     *  @param bd           Initialized block device to store records on
+     *  @param sector_size  Size of the sectors the log is split into, must be
+     *                      a multiple of the erase size and defaults to the
+     *                      erase size. Limits the size of a single record.
+     */
+    LogKVStore(BlockDevice *bd, bd_size_t sector_size = 0);
+    virtual ~LogKVStore();
+
+    /** Erase the block device and start an empty store
+     *
+     *  The store is left mounted.
+     *
+     *  @return         0 on success, negative error code on failure
+     */
+    int format();
+
+    /** Mount the store and rebuild the index from the log
+     *
+     *  @return         0 on success, -ENOENT if the block device holds no
+     *                  store, negative error code on other failures
+     */
+    int mount();
+
+    /** Unmount the store and release the index
+     *
+     *  @return         0 on success, negative error code on failure
+     */
+    int unmount();
+
+    /** Set the value of a key
+     *
+     *  The new value is durable when this call returns.
+     *
+     *  @param key      Null-terminated key name of 1 to 255 characters
+     *  @param buffer   Value to store
+     *  @param size     Size of the value in bytes
+     *  @param flags    Caller defined metadata stored with the value,
+     *                  for example permission bits
+     *  @return         0 on success, negative error code on failure
+     */
+    int set(const char *key, const void *buffer, size_t size, uint32_t flags = 0);
+
+    /** Get the value of a key
+     *
+     *  @param key      Null-terminated key name
+     *  @param buffer   Buffer to read the value into, may be NULL to query the size
+     *  @param size     Size of the buffer, at most this many bytes are read
+     *  @param flags    If not NULL, receives the metadata stored with the value
+     *  @return         Full size of the value in bytes, negative error code on
+     *                  failure, -ENOENT if the key does not exist
+     */
+    ssize_t get(const char *key, void *buffer, size_t size, uint32_t *flags = NULL);
+
+    /** Remove a key
+     *
+     *  @param key      Null-terminated key name
+     *  @return         0 on success, -ENOENT if the key does not exist,
+     *                  negative error code on other failures
+     */
+    int remove(const char *key);
+
+    /** Get the number of keys in the store
+     *
+     *  @return         Number of keys
+     */
+    size_t count();
+
+    /** Get the name of a key by position
+     *
+     *  Positions are in an unspecified order and are invalidated by set
+     *  and remove, which allows enumerating the keys for pattern matching.
+     *
+     *  @param index    Position of the key, less than count()
+     *  @param key      Buffer for the null-terminated key name
+     *  @param size     Size of the key buffer, 256 fits any key
+     *  @return         Length of the key name, negative error code on failure
+     */
+    ssize_t key_at(size_t index, char *key, size_t size);
+
+    /** Run one step of garbage collection
+     *
+     *  Collects the oldest sector if the head sector has room for its live
+     *  records. Calling this when idle moves the cost out of set().
+     *
+     *  @return         0 on success or if there was nothing to collect,
+     *                  negative error code on failure
+     */
+    int gc();
+
+protected:
+    struct index_entry {
+        uint32_t hash;
+        uint32_t addr;
+    };
+
+    int _setup();
+    int _sector_seq(uint32_t sector, uint32_t *seq);
+    int _activate(uint32_t sector);
+    int _retire(uint32_t sector);
+    int _advance();
+    int _collect();
+    int _scan(uint32_t sector, uint32_t seq, bd_addr_t *end);
+    int _check(uint32_t addr, uint32_t seq,
+            uint8_t *type, uint8_t *key_size, uint32_t *value_size);
+    int _append(uint8_t type, const char *key, uint8_t key_size,
+            const void *buffer, size_t size, uint32_t flags, uint32_t *addr);
+    int _copy(uint32_t addr, bd_size_t record_size, uint32_t *new_addr);
+
+    size_t _index_lower_bound(uint32_t hash);
+    size_t _index_pos(uint32_t addr, uint8_t key_size);
+    int _find(const char *key, uint8_t key_size, uint32_t hash, size_t *pos);
+    int _key_equal(uint32_t addr, const char *key, uint8_t key_size);
+    int _index_reserve(size_t count);
+    void _index_insert(size_t pos, uint32_t hash, uint32_t addr);
+    void _index_remove(size_t pos);
+    void _free_index();
+
+    int _read(bd_addr_t addr, void *buffer, bd_size_t size);
+    int _program(const void *buffer, bd_size_t size);
+    int _program_flush();
+
+    bd_size_t _record_size(uint8_t key_size, uint32_t value_size) const;
+    bd_addr_t _sector_addr(uint32_t sector) const;
+    bd_addr_t _data_start() const;
+
+    BlockDevice *_bd;
+    bd_size_t _sector_size;
+    uint32_t _sector_count;
+    bool _mounted;
+
+    // Ring of active sectors from oldest to head
+    uint32_t _oldest;
+    uint32_t _head;
+    bd_addr_t _head_off;
+    uint32_t _seq;
+
+    // Index of live keys sorted by hash
+    index_entry *_index;
+    size_t _index_count;
+    size_t _index_capacity;
+
+    // Buffers for unaligned reads and for streaming programs
+    uint8_t *_read_buffer;
+    uint8_t *_program_buffer;
+    bd_size_t _program_buffer_size;
+    bd_addr_t _program_addr;
+    bd_size_t _program_fill;
+
+    PlatformMutex _mutex;
+};
+
+
+#endif
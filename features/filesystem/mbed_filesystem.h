@@ -34,6 +34,9 @@
 #include "bd/SlicingBlockDevice.h"
 #include "bd/HeapBlockDevice.h"
 
+// Key-value stores
+#include "kv/LogKVStore.h"
+
 
 /** @}*/
 #endif
@@ -0,0 +1,148 @@
+/*
+ *  Generator of the comb tables of MBEDTLS_ECP_FIXED_POINT_TABLES
+ *
+ *  Copyright (C) 2017, ARM Limited, All Rights Reserved
+ *  SPDX-License-Identifier: Apache-2.0
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *  not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *  WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Host tool, run by "make ecp-tables" in this directory. It computes the
+ * points the comb method precomputes for the generator of each curve with a
+ * built-in table, as ecp.c computes them at runtime, and prints them as
+ * ecp_comb_tables.h, which ecp_curves.c includes.
+ */
+
+#include "mbedtls/config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "mbedtls/ecp.h"
+
+#if defined(MBEDTLS_ECP_FIXED_POINT_TABLES)
+#error "Build the generator with MBEDTLS_ECP_FIXED_POINT_TABLES disabled"
+#endif
+
+#if MBEDTLS_ECP_FIXED_POINT_OPTIM != 1
+#error "Build the generator with MBEDTLS_ECP_FIXED_POINT_OPTIM set to 1"
+#endif
+
+static const struct
+{
+    const char *name;
+    const char *option;
+    mbedtls_ecp_group_id id;
+} curves[] =
+{
+    { "secp256r1", "MBEDTLS_ECP_DP_SECP256R1_ENABLED", MBEDTLS_ECP_DP_SECP256R1 },
+    { "secp384r1", "MBEDTLS_ECP_DP_SECP384R1_ENABLED", MBEDTLS_ECP_DP_SECP384R1 },
+};
+
+static void fail( const char *what, int ret )
+{
+    fprintf( stderr, "ecp-comb-tables: %s returned -0x%04X\n", what, -ret );
+    exit( EXIT_FAILURE );
+}
+
+/*
+ * Print X as mbedtls_mpi_uint constants, little-endian as the other
+ * constants of ecp_curves.c
+ */
+static void print_mpi( const char *curve, size_t i, char coord,
+                       const mbedtls_mpi *X, size_t len )
+{
+    unsigned char buf[MBEDTLS_ECP_MAX_BYTES];
+    size_t j, k;
+    int ret;
+
+    if( ( ret = mbedtls_mpi_write_binary( X, buf, len ) ) != 0 )
+        fail( "mbedtls_mpi_write_binary", ret );
+
+    printf( "static const mbedtls_mpi_uint %s_T_%u_%c[] = {\n",
+            curve, (unsigned) i, coord );
+    for( j = 0; j < len; j += 8 )
+    {
+        printf( "    BYTES_TO_T_UINT_8(" );
+        for( k = 0; k < 8; k++ )
+            printf( " 0x%02X%s", buf[len - 1 - j - k], k < 7 ? "," : " ),\n" );
+    }
+    printf( "};\n" );
+}
+
+static void print_table( const char *curve, const char *option,
+                         mbedtls_ecp_group_id id )
+{
+    mbedtls_ecp_keypair g;
+    size_t i, len;
+    int ret;
+
+    /*
+     * The table a key pair precomputes for its public point is the one the
+     * comb method computes for the generator, when that point is G
+     */
+    mbedtls_ecp_keypair_init( &g );
+    if( ( ret = mbedtls_ecp_group_load( &g.grp, id ) ) != 0 )
+        fail( "mbedtls_ecp_group_load", ret );
+    if( ( ret = mbedtls_ecp_copy( &g.Q, &g.grp.G ) ) != 0 )
+        fail( "mbedtls_ecp_copy", ret );
+    if( ( ret = mbedtls_ecp_keypair_precompute( &g ) ) != 0 )
+        fail( "mbedtls_ecp_keypair_precompute", ret );
+
+    /* The first point is G, whose constants are used as they are */
+    if( mbedtls_ecp_point_cmp( &g.grp.TF[0], &g.grp.G ) != 0 )
+        fail( "mbedtls_ecp_point_cmp", MBEDTLS_ERR_ECP_BAD_INPUT_DATA );
+
+    /* Multiple of 8 bytes, for BYTES_TO_T_UINT_8 */
+    len = ( mbedtls_mpi_size( &g.grp.P ) + 7 ) & ~(size_t) 7;
+
+    printf( "\n#if defined(%s)\n", option );
+    for( i = 1; i < g.grp.TF_size; i++ )
+    {
+        print_mpi( curve, i, 'X', &g.grp.TF[i].X, len );
+        print_mpi( curve, i, 'Y', &g.grp.TF[i].Y, len );
+    }
+
+    printf( "static const mbedtls_ecp_point %s_T[%u] = {\n",
+            curve, (unsigned) g.grp.TF_size );
+    printf( "    ECP_POINT_INIT_XY( %s_gx, %s_gy ),\n", curve, curve );
+    for( i = 1; i < g.grp.TF_size; i++ )
+        printf( "    ECP_POINT_INIT_XY( %s_T_%u_X, %s_T_%u_Y ),\n",
+                curve, (unsigned) i, curve, (unsigned) i );
+    printf( "};\n" );
+    printf( "#endif /* %s */\n", option );
+
+    mbedtls_ecp_keypair_free( &g );
+}
+
+int main( void )
+{
+    size_t i;
+
+    printf( "/*\n"
+            " *  Comb tables of the generator of the NIST curves\n"
+            " *\n"
+            " *  Copyright (C) 2017, ARM Limited, All Rights Reserved\n"
+            " *  SPDX-License-Identifier: Apache-2.0\n"
+            " *\n"
+            " *  Generated by importer/ecp-comb-tables.c, do not edit.\n"
+            " *  Included by ecp_curves.c with MBEDTLS_ECP_FIXED_POINT_TABLES,\n"
+            " *  after the domain parameters, for MBEDTLS_ECP_WINDOW_SIZE %d.\n"
+            " */\n", MBEDTLS_ECP_WINDOW_SIZE );
+
+    for( i = 0; i < sizeof( curves ) / sizeof( curves[0] ); i++ )
+        print_table( curves[i].name, curves[i].option, curves[i].id );
+
+    return( 0 );
+}
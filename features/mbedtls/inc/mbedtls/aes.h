@@ -250,6 +250,34 @@ int mbedtls_aes_crypt_ctr( mbedtls_aes_context *ctx,
                        unsigned char *output );
 #endif /* MBEDTLS_CIPHER_MODE_CTR */
 
+#if defined(MBEDTLS_AES_CTR_BLOCKS)
+/**
+ * \brief               AES-CTR encryption/decryption of whole blocks with
+ *                      a 32-bit counter, as GCM uses it
+ *                      (see MBEDTLS_AES_CTR_BLOCKS)
+ *
+ *                      Each block of input is XORed with the encryption of
+ *                      the counter block, whose last four bytes are then
+ *                      incremented as a big-endian integer modulo 2^32.
+ *                      The first 12 bytes never change.
+ *
+ * \param ctx           AES context, set up with mbedtls_aes_setkey_enc()
+ * \param blocks        Number of 16-byte blocks
+ * \param counter       Counter block for the first block, updated to the
+ *                      one following the last block
+ * \param input         blocks * 16 bytes of input
+ * \param output        blocks * 16 bytes of output, which may be the same
+ *                      buffer as input
+ *
+ * \return              0 if successful
+ */
+int mbedtls_aes_crypt_ctr32( mbedtls_aes_context *ctx,
+                             size_t blocks,
+                             unsigned char counter[16],
+                             const unsigned char *input,
+                             unsigned char *output );
+#endif /* MBEDTLS_AES_CTR_BLOCKS */
+
 /**
  * \brief           Internal AES block encryption function
  *                  (Only exposed to allow overriding it,
@@ -69,6 +69,10 @@
 #error "MBEDTLS_AESNI_C defined, but not all prerequisites"
 #endif
 
+#if defined(MBEDTLS_AES_CTR_BLOCKS) && !defined(MBEDTLS_AES_C)
+#error "MBEDTLS_AES_CTR_BLOCKS defined, but not all prerequisites"
+#endif
+
 #if defined(MBEDTLS_CTR_DRBG_C) && !defined(MBEDTLS_AES_C)
 #error "MBEDTLS_CTR_DRBG_C defined, but not all prerequisites"
 #endif
@@ -102,6 +106,11 @@
 #error "MBEDTLS_ECDSA_DETERMINISTIC defined, but not all prerequisites"
 #endif
 
+#if defined(MBEDTLS_ECDSA_BATCH_SIZE) &&                               \
+    ( MBEDTLS_ECDSA_BATCH_SIZE < 1 || MBEDTLS_ECDSA_BATCH_SIZE > 12 )
+#error "MBEDTLS_ECDSA_BATCH_SIZE must be between 1 and 12"
+#endif
+
 #if defined(MBEDTLS_ECP_C) && ( !defined(MBEDTLS_BIGNUM_C) || (   \
     !defined(MBEDTLS_ECP_DP_SECP192R1_ENABLED) &&                  \
     !defined(MBEDTLS_ECP_DP_SECP224R1_ENABLED) &&                  \
@@ -150,6 +159,18 @@
 #error "MBEDTLS_GCM_C defined, but not all prerequisites"
 #endif
 
+#if defined(MBEDTLS_GCM_GHASH_TABLE8) && !defined(MBEDTLS_GCM_C)
+#error "MBEDTLS_GCM_GHASH_TABLE8 defined, but not all prerequisites"
+#endif
+
+#if defined(MBEDTLS_GCM_GHASH_CT) && !defined(MBEDTLS_GCM_C)
+#error "MBEDTLS_GCM_GHASH_CT defined, but not all prerequisites"
+#endif
+
+#if defined(MBEDTLS_GCM_GHASH_TABLE8) && defined(MBEDTLS_GCM_GHASH_CT)
+#error "MBEDTLS_GCM_GHASH_TABLE8 and MBEDTLS_GCM_GHASH_CT cannot be defined simultaneously"
+#endif
+
 #if defined(MBEDTLS_ECP_RANDOMIZE_JAC_ALT) && !defined(MBEDTLS_ECP_INTERNAL_ALT)
 #error "MBEDTLS_ECP_RANDOMIZE_JAC_ALT defined, but not all prerequisites"
 #endif
@@ -250,6 +271,10 @@
 #error "MBEDTLS_MEMORY_BUFFER_ALLOC_C defined, but not all prerequisites"
 #endif
 
+#if defined(MBEDTLS_MEMORY_BUFFER_ALLOC_SLABS) && !defined(MBEDTLS_MEMORY_BUFFER_ALLOC_C)
+#error "MBEDTLS_MEMORY_BUFFER_ALLOC_SLABS defined, but not all prerequisites"
+#endif
+
 #if defined(MBEDTLS_PADLOCK_C) && !defined(MBEDTLS_HAVE_ASM)
 #error "MBEDTLS_PADLOCK_C defined, but not all prerequisites"
 #endif
@@ -487,6 +512,11 @@
 #error "MBEDTLS_X509_RSASSA_PSS_SUPPORT defined, but not all prerequisites"
 #endif
 
+#if defined(MBEDTLS_X509_CRT_LAZY_EXTENSIONS) &&                       \
+    !defined(MBEDTLS_X509_CRT_PARSE_C)
+#error "MBEDTLS_X509_CRT_LAZY_EXTENSIONS defined, but not all prerequisites"
+#endif
+
 #if defined(MBEDTLS_SSL_PROTO_SSL3) && ( !defined(MBEDTLS_MD5_C) ||     \
     !defined(MBEDTLS_SHA1_C) )
 #error "MBEDTLS_SSL_PROTO_SSL3 defined, but not all prerequisites"
@@ -585,6 +615,10 @@
 #error "MBEDTLS_SSL_TICKET_C defined, but not all prerequisites"
 #endif
 
+#if defined(MBEDTLS_SSL_ASYNC_PRIVATE) && !defined(MBEDTLS_X509_CRT_PARSE_C)
+#error "MBEDTLS_SSL_ASYNC_PRIVATE defined, but not all prerequisites"
+#endif
+
 #if defined(MBEDTLS_SSL_CBC_RECORD_SPLITTING) && \
     !defined(MBEDTLS_SSL_PROTO_SSL3) && !defined(MBEDTLS_SSL_PROTO_TLS1)
 #error "MBEDTLS_SSL_CBC_RECORD_SPLITTING defined, but not all prerequisites"
@@ -595,6 +629,20 @@
 #error "MBEDTLS_SSL_SERVER_NAME_INDICATION defined, but not all prerequisites"
 #endif
 
+#if defined(MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH) && defined(MBEDTLS_ZLIB_SUPPORT)
+#error "MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH cannot be used with MBEDTLS_ZLIB_SUPPORT"
+#endif
+
+#if defined(MBEDTLS_SSL_IN_CONTENT_LEN) && defined(MBEDTLS_SSL_MAX_CONTENT_LEN) && \
+    MBEDTLS_SSL_IN_CONTENT_LEN > MBEDTLS_SSL_MAX_CONTENT_LEN
+#error "MBEDTLS_SSL_IN_CONTENT_LEN cannot exceed MBEDTLS_SSL_MAX_CONTENT_LEN"
+#endif
+
+#if defined(MBEDTLS_SSL_OUT_CONTENT_LEN) && defined(MBEDTLS_SSL_MAX_CONTENT_LEN) && \
+    MBEDTLS_SSL_OUT_CONTENT_LEN > MBEDTLS_SSL_MAX_CONTENT_LEN
+#error "MBEDTLS_SSL_OUT_CONTENT_LEN cannot exceed MBEDTLS_SSL_MAX_CONTENT_LEN"
+#endif
+
 #if defined(MBEDTLS_THREADING_PTHREAD)
 #if !defined(MBEDTLS_THREADING_C) || defined(MBEDTLS_THREADING_IMPL)
 #error "MBEDTLS_THREADING_PTHREAD defined, but not all prerequisites"
@@ -402,6 +402,63 @@
  */
 //#define MBEDTLS_AES_ROM_TABLES
 
+/**
+ * \def MBEDTLS_AES_CTR_BLOCKS
+ *
+ * Encrypt whole blocks of AES counter mode in one call, for GCM and for
+ * MBEDTLS_CIPHER_MODE_CTR. With the T-table implementation, the parts of the
+ * first two rounds that do not depend on the low byte of the counter are
+ * computed once per 256 blocks, saving about a sixth of the table lookups
+ * of AES-128, and the input is XORed a word at a time.
+ *
+ * Has no effect with MBEDTLS_AES_ALT. With MBEDTLS_AES_ENCRYPT_ALT or an
+ * accelerator (AES-NI, PadLock), blocks go one by one to the accelerated
+ * block function.
+ *
+ * Module:  library/aes.c
+ * Caller:  library/gcm.c
+ *
+ * Requires: MBEDTLS_AES_C
+ *
+ * Uncomment this macro to process blocks of AES-CTR together.
+ */
+//#define MBEDTLS_AES_CTR_BLOCKS
+
+/**
+ * \def MBEDTLS_GCM_GHASH_TABLE8
+ *
+ * Use Shoup's method with 8-bit tables for GHASH instead of 4-bit tables,
+ * on 32-bit words: half the iterations and reductions of the default and no
+ * 64-bit shifts, which Cortex-M has to emulate.
+ *
+ * Adds 4 KiB of precomputed table to every GCM context, two of which live
+ * in every TLS connection using a GCM ciphersuite.
+ *
+ * Module:  library/gcm.c
+ *
+ * Requires: MBEDTLS_GCM_C
+ *
+ * Uncomment this macro to use 8-bit tables for GHASH.
+ */
+//#define MBEDTLS_GCM_GHASH_TABLE8
+
+/**
+ * \def MBEDTLS_GCM_GHASH_CT
+ *
+ * Compute GHASH without tables, with 32-bit multiplications whose timing
+ * does not depend on the data, instead of with 4-bit tables indexed by
+ * secret-dependent values. Slower than the tables; it suits cores without
+ * data cache where the 32 x 32 -> 32 multiply runs in constant time, which
+ * is the case on Cortex-M.
+ *
+ * Module:  library/gcm.c
+ *
+ * Requires: MBEDTLS_GCM_C
+ *
+ * Uncomment this macro to compute GHASH in constant time.
+ */
+//#define MBEDTLS_GCM_GHASH_CT
+
 /**
  * \def MBEDTLS_CAMELLIA_SMALL_MEMORY
  *
@@ -541,6 +598,26 @@
  */
 #define MBEDTLS_ECP_NIST_OPTIM
 
+/**
+ * \def MBEDTLS_ECP_FIXED_POINT_TABLES
+ *
+ * Use tables of the points the comb method precomputes for the generator
+ * of secp256r1 and secp384r1 that are built in as constant data, instead
+ * of computing them into RAM the first time each group multiplies its
+ * generator (when MBEDTLS_ECP_FIXED_POINT_OPTIM is 1, its default).
+ *
+ * This saves the time of computing the tables in the first ECDSA signature
+ * or key generation with each group, and the RAM they take for as long as
+ * the group is loaded, and costs about 1.5 KiB of ROM for secp256r1 and
+ * 4 KiB for secp384r1 (with 32-bit limbs).
+ *
+ * The tables are generated for the default MBEDTLS_ECP_WINDOW_SIZE by the
+ * mbed TLS importer into ecp_comb_tables.h.
+ *
+ * Uncomment this macro to build the tables in.
+ */
+//#define MBEDTLS_ECP_FIXED_POINT_TABLES
+
 /**
  * \def MBEDTLS_ECDSA_DETERMINISTIC
  *
@@ -954,6 +1031,21 @@
  */
 //#define MBEDTLS_MEMORY_BACKTRACE
 
+/**
+ * \def MBEDTLS_MEMORY_BUFFER_ALLOC_SLABS
+ *
+ * Serve allocations of up to MBEDTLS_MEMORY_SLAB_MAX_SIZE bytes from slabs
+ * of the buffer allocator, blocks cut into chunks of one size class.
+ * Bignum limbs and ASN.1 nodes are allocated and freed in O(1), with a word
+ * of overhead instead of a block header, and no longer scatter small holes
+ * through the heap.
+ *
+ * Requires: MBEDTLS_MEMORY_BUFFER_ALLOC_C
+ *
+ * Uncomment this macro to serve small allocations from slabs.
+ */
+//#define MBEDTLS_MEMORY_BUFFER_ALLOC_SLABS
+
 /**
  * \def MBEDTLS_PK_RSA_ALT_SUPPORT
  *
@@ -1032,6 +1124,21 @@
  */
 #define MBEDTLS_SSL_ALL_ALERT_MESSAGES
 
+/**
+ * \def MBEDTLS_SSL_ASYNC_PRIVATE
+ *
+ * Enable asynchronous private key operations in the SSL module, so that
+ * a server's ServerKeyExchange signature and RSA premaster decryption, and
+ * a client's CertificateVerify signature, can run on a worker thread or a
+ * hardware engine while mbedtls_ssl_handshake() returns
+ * MBEDTLS_ERR_SSL_WANT_ASYNC. See mbedtls_ssl_conf_async_private_cb().
+ *
+ * Requires: MBEDTLS_X509_CRT_PARSE_C
+ *
+ * Uncomment this macro to enable asynchronous private key operations.
+ */
+//#define MBEDTLS_SSL_ASYNC_PRIVATE
+
 /**
  * \def MBEDTLS_SSL_DEBUG_ALL
  *
@@ -1158,6 +1265,25 @@
  */
 //#define MBEDTLS_SSL_SRV_RESPECT_CLIENT_PREFERENCE
 
+/**
+ * \def MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH
+ *
+ * Size the record buffers of each SSL context to what the connection needs
+ * instead of allocating MBEDTLS_SSL_IN_CONTENT_LEN and
+ * MBEDTLS_SSL_OUT_CONTENT_LEN bytes for the lifetime of the context.
+ *
+ * The buffers are allocated by the first handshake step, or by an alert
+ * sent before it, not by mbedtls_ssl_setup(), and released again by
+ * mbedtls_ssl_session_reset(). Once the handshake completes they shrink to
+ * the negotiated maximum fragment length, or without one to 512 bytes, and
+ * grow again on demand when larger records are sent or received.
+ *
+ * Requires: !MBEDTLS_ZLIB_SUPPORT
+ *
+ * Uncomment this macro to size the record buffers on demand
+ */
+//#define MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH
+
 /**
  * \def MBEDTLS_SSL_MAX_FRAGMENT_LENGTH
  *
@@ -1437,6 +1563,25 @@
  */
 //#define MBEDTLS_X509_RSASSA_PSS_SUPPORT
 
+/**
+ * \def MBEDTLS_X509_CRT_LAZY_EXTENSIONS
+ *
+ * Keep the subjectAltName and extendedKeyUsage extensions of parsed
+ * certificates as references into their DER data, instead of allocating a
+ * list element per name. The extensions are still checked when parsing,
+ * and their elements are decoded each time they are used, on verification
+ * and by mbedtls_x509_crt_info().
+ *
+ * With this option, subject_alt_names and ext_key_usage of
+ * mbedtls_x509_crt hold the whole extension in their first element, and
+ * applications reading them directly must walk the DER themselves.
+ *
+ * Requires: MBEDTLS_X509_CRT_PARSE_C
+ *
+ * Uncomment this macro to save heap on certificates with many names.
+ */
+//#define MBEDTLS_X509_CRT_LAZY_EXTENSIONS
+
 /**
  * \def MBEDTLS_ZLIB_SUPPORT
  *
@@ -2585,6 +2730,9 @@
 //#define MBEDTLS_ECP_WINDOW_SIZE            6 /**< Maximum window size used */
 //#define MBEDTLS_ECP_FIXED_POINT_OPTIM      1 /**< Enable fixed-point speed-up */
 
+/* ECDSA options */
+//#define MBEDTLS_ECDSA_BATCH_SIZE           8 /**< Maximum number of signatures per linear combination */
+
 /* Entropy options */
 //#define MBEDTLS_ENTROPY_MAX_SOURCES                20 /**< Maximum number of sources supported */
 //#define MBEDTLS_ENTROPY_MAX_GATHER                128 /**< Maximum amount requested from entropy sources */
@@ -2592,6 +2740,8 @@
 
 /* Memory buffer allocator options */
 //#define MBEDTLS_MEMORY_ALIGN_MULTIPLE      4 /**< Align on multiples of this value */
+//#define MBEDTLS_MEMORY_SLAB_MAX_SIZE     256 /**< Largest allocation served from slabs, a multiple of 8 up to 1024 */
+//#define MBEDTLS_MEMORY_SLAB_PAGE_SIZE   1024 /**< Bytes of the heap a slab takes */
 
 /* Platform options */
 //#define MBEDTLS_PLATFORM_STD_MEM_HDR   <stdlib.h> /**< Header to include if MBEDTLS_PLATFORM_NO_STD_FUNCTIONS is defined. Don't define if no header is needed. */
@@ -2629,6 +2779,8 @@
 
 /* SSL options */
 //#define MBEDTLS_SSL_MAX_CONTENT_LEN             16384 /**< Maxium fragment length in bytes, determines the size of each of the two internal I/O buffers */
+//#define MBEDTLS_SSL_IN_CONTENT_LEN              16384 /**< Maximum length of incoming records, defaults to MBEDTLS_SSL_MAX_CONTENT_LEN */
+//#define MBEDTLS_SSL_OUT_CONTENT_LEN             16384 /**< Maximum length of outgoing records, defaults to MBEDTLS_SSL_MAX_CONTENT_LEN */
 //#define MBEDTLS_SSL_DEFAULT_TICKET_LIFETIME     86400 /**< Lifetime of session tickets (if enabled) */
 //#define MBEDTLS_PSK_MAX_LEN               32 /**< Max size of TLS pre-shared keys, in bytes (default 256 bits) */
 //#define MBEDTLS_SSL_COOKIE_TIMEOUT        60 /**< Default expiration delay of DTLS cookies, in seconds if HAVE_TIME, or in number of cookies issued */
@@ -46,11 +46,42 @@
 /** Maximum size of an ECDSA signature in bytes */
 #define MBEDTLS_ECDSA_MAX_LEN  ( 3 + 2 * ( 3 + MBEDTLS_ECP_MAX_BYTES ) )
 
+#if !defined(MBEDTLS_ECDSA_BATCH_SIZE)
+/*
+ * Maximum number of signatures checked together by
+ * mbedtls_ecdsa_verify_batch(). Default: 8. Minimum value: 1. Maximum
+ * value: 12.
+ *
+ * A batch shares the doublings of its scalar multiplications, but the sign
+ * of each point recovered from a signature is unknown, and the check tries
+ * 2^(size - 1) sums of these points. The search doubles with each
+ * signature: at 12 its 2048 point additions eat most of what the shared
+ * doublings save, and at 16 a secp256r1 batch is already four times slower
+ * than verifying its signatures one by one, so larger batches are refused.
+ * The scalar multiplication takes a table of 8 points per public key and
+ * per signature.
+ */
+#define MBEDTLS_ECDSA_BATCH_SIZE    8   /**< Maximum number of signatures per linear combination */
+#endif /* MBEDTLS_ECDSA_BATCH_SIZE */
+
 /**
  * \brief           ECDSA context structure
  */
 typedef mbedtls_ecp_keypair mbedtls_ecdsa_context;
 
+/**
+ * \brief           Signature to verify with mbedtls_ecdsa_verify_batch()
+ */
+typedef struct
+{
+    const unsigned char *hash;  /*!< Message hash */
+    size_t hlen;                /*!< Length of hash */
+    const mbedtls_ecp_point *Q; /*!< Public key to use for verification */
+    const mbedtls_mpi *r;       /*!< First integer of the signature */
+    const mbedtls_mpi *s;       /*!< Second integer of the signature */
+}
+mbedtls_ecdsa_batch_item;
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -115,6 +146,43 @@ int mbedtls_ecdsa_verify( mbedtls_ecp_group *grp,
                   const unsigned char *buf, size_t blen,
                   const mbedtls_ecp_point *Q, const mbedtls_mpi *r, const mbedtls_mpi *s);
 
+/**
+ * \brief           Verify several ECDSA signatures of previously hashed
+ *                  messages at once
+ *
+ *                  The signatures are checked by batches of up to
+ *                  MBEDTLS_ECDSA_BATCH_SIZE, each with a single random
+ *                  linear combination of their verification equations. When
+ *                  a batch fails, its signatures are verified one by one
+ *                  with mbedtls_ecdsa_verify() to find the invalid ones.
+ *
+ * \note            An invalid signature passes its batch with probability
+ *                  below 2^(MBEDTLS_ECDSA_BATCH_SIZE - 128). The batches
+ *                  are only faster on curves with P = 3 mod 4, such as
+ *                  secp256r1 and secp384r1: on other curves, all signatures
+ *                  are verified one by one.
+ *
+ * \param grp       ECP group
+ * \param items     Signatures, with their message hashes and public keys
+ * \param count     Number of signatures
+ * \param results   Array of count results, filled with 0 for each valid
+ *                  signature and the error returned by mbedtls_ecdsa_verify()
+ *                  for the others, or NULL to stop at the first invalid
+ *                  signature
+ * \param f_rng     RNG function for the coefficients of the combinations
+ * \param p_rng     RNG parameter
+ *
+ * \return          0 if all signatures are valid,
+ *                  MBEDTLS_ERR_ECP_VERIFY_FAILED or
+ *                  MBEDTLS_ERR_ECP_INVALID_KEY if one is invalid,
+ *                  or a MBEDTLS_ERR_ECP_XXX or MBEDTLS_MPI_XXX error code
+ */
+int mbedtls_ecdsa_verify_batch( mbedtls_ecp_group *grp,
+                                const mbedtls_ecdsa_batch_item *items, size_t count,
+                                int *results,
+                                int (*f_rng)(void *, unsigned char *, size_t),
+                                void *p_rng );
+
 /**
  * \brief           Compute ECDSA signature and write it to buffer,
  *                  serialized as defined in RFC 4492 page 20.
@@ -151,7 +151,10 @@ typedef struct
     int (*t_post)(mbedtls_ecp_point *, void *); /*!< unused                         */
     void *t_data;                       /*!< unused                         */
     mbedtls_ecp_point *T;       /*!<  pre-computed points for ecp_mul_comb()        */
-    size_t T_size;      /*!<  number for pre-computed points                */
+    size_t T_size;      /*!<  number for pre-computed points, 0 if static   */
+    mbedtls_ecp_point F;        /*!<  other fixed point, see mbedtls_ecp_keypair_precompute() */
+    mbedtls_ecp_point *TF;      /*!<  pre-computed points for F                     */
+    size_t TF_size;     /*!<  number for pre-computed points for F          */
 }
 mbedtls_ecp_group;
 
@@ -223,6 +226,9 @@ mbedtls_ecp_keypair;
  * The cost is increasing EC peak memory usage by a factor roughly 2.
  *
  * Change this value to 0 to reduce peak memory usage.
+ *
+ * With MBEDTLS_ECP_FIXED_POINT_TABLES, the points for secp256r1 and
+ * secp384r1 are constant data instead, and cost no RAM.
  */
 #define MBEDTLS_ECP_FIXED_POINT_OPTIM  1   /**< Enable fixed-point speed-up */
 #endif /* MBEDTLS_ECP_FIXED_POINT_OPTIM */
@@ -555,6 +561,73 @@ int mbedtls_ecp_muladd( mbedtls_ecp_group *grp, mbedtls_ecp_point *R,
              const mbedtls_mpi *m, const mbedtls_ecp_point *P,
              const mbedtls_mpi *n, const mbedtls_ecp_point *Q );
 
+/**
+ * \brief           Multiplication and addition of several points by
+ *                  integers: R = m[0] * P[0] + ... + m[count-1] * P[count-1]
+ *                  (Not thread-safe to use same group in multiple threads)
+ *
+ * \note            Like mbedtls_ecp_muladd(), this function does not
+ *                  guarantee a constant execution flow and timing, and is
+ *                  meant for public data, as in signature verification.
+ *                  The points share their doublings, and each takes a table
+ *                  of 8 points on the heap.
+ *
+ * \param grp       ECP group, in short Weierstrass form
+ * \param R         Destination point
+ * \param m         Array of count integers, 0 <= m[i] < 2^nbits
+ * \param P         Array of count normalized points to multiply
+ * \param count     Number of terms
+ *
+ * \return          0 if successful,
+ *                  MBEDTLS_ERR_ECP_INVALID_KEY if some m[i] is out of range
+ *                  or some P[i] is not a valid pubkey,
+ *                  MBEDTLS_ERR_ECP_ALLOC_FAILED if memory allocation failed
+ */
+int mbedtls_ecp_muladd_many( mbedtls_ecp_group *grp, mbedtls_ecp_point *R,
+                             const mbedtls_mpi *m, const mbedtls_ecp_point *P,
+                             size_t count );
+
+/**
+ * \brief           Find a point with the given x-coordinate. The other point
+ *                  with this x-coordinate is its opposite.
+ *
+ * \note            Only for curves in short Weierstrass form with
+ *                  P = 3 mod 4, such as secp256r1, secp384r1 and secp521r1.
+ *
+ * \param grp       ECP group
+ * \param pt        Destination point, normalized
+ * \param x         x-coordinate
+ *
+ * \return          0 if successful,
+ *                  MBEDTLS_ERR_ECP_INVALID_KEY if no point has this
+ *                  x-coordinate,
+ *                  MBEDTLS_ERR_ECP_FEATURE_UNAVAILABLE for other curves
+ */
+int mbedtls_ecp_point_from_x( const mbedtls_ecp_group *grp, mbedtls_ecp_point *pt,
+                              const mbedtls_mpi *x );
+
+/**
+ * \brief           Check that A = +-T[0] +- T[1] ... +- T[count-1] for
+ *                  some choice of the signs.
+ *                  (Not thread-safe to use same group in multiple threads)
+ *
+ * \note            Tries all 2^(count-1) sums of the last count-1 points,
+ *                  with a point addition each: only for a few points. Does
+ *                  not guarantee a constant execution flow and timing.
+ *
+ * \param grp       ECP group, in short Weierstrass form
+ * \param A         Normalized point to compare with the sums
+ * \param T         Array of count normalized points
+ * \param count     Number of points, at least 1
+ *
+ * \return          0 if some sum is equal to A,
+ *                  MBEDTLS_ERR_ECP_VERIFY_FAILED if none is,
+ *                  MBEDTLS_ERR_ECP_ALLOC_FAILED if memory allocation failed
+ */
+int mbedtls_ecp_check_signed_sum( mbedtls_ecp_group *grp,
+                                  const mbedtls_ecp_point *A,
+                                  const mbedtls_ecp_point *T, size_t count );
+
 /**
  * \brief           Check that a point is a valid public key on this curve
  *
@@ -662,6 +735,26 @@ int mbedtls_ecp_gen_key( mbedtls_ecp_group_id grp_id, mbedtls_ecp_keypair *key,
  */
 int mbedtls_ecp_check_pub_priv( const mbedtls_ecp_keypair *pub, const mbedtls_ecp_keypair *prv );
 
+/**
+ * \brief           Pre-compute the multiples of the public point of a key
+ *                  pair used to multiply it, and keep them with its group
+ *
+ *                  This speeds up multiplying the same public point again
+ *                  and again, as the generator is with
+ *                  MBEDTLS_ECP_FIXED_POINT_OPTIM: verifying ECDSA signatures
+ *                  with a long-lived key, or ECDH with a static peer key
+ *                  (mbedtls_ecdh_compute_shared() with the group and public
+ *                  point of the key pair). The points take as much memory as
+ *                  those of the generator, until the group is freed.
+ *
+ * \param key       Key pair holding a valid public point
+ *
+ * \return          0 if successful,
+ *                  MBEDTLS_ERR_ECP_FEATURE_UNAVAILABLE for Montgomery curves,
+ *                  or a MBEDTLS_ERR_ECP_XXX or MBEDTLS_ERR_MPI_XXX code.
+ */
+int mbedtls_ecp_keypair_precompute( mbedtls_ecp_keypair *key );
+
 #if defined(MBEDTLS_SELF_TEST)
 
 /**
@@ -42,6 +42,9 @@ extern "C" {
  */
 typedef struct {
     mbedtls_cipher_context_t cipher_ctx;/*!< cipher context used */
+#if defined(MBEDTLS_GCM_GHASH_TABLE8)
+    uint32_t HT[256][4];        /*!< Precalculated 8-bit HTable */
+#endif
     uint64_t HL[16];            /*!< Precalculated HTable */
     uint64_t HH[16];            /*!< Precalculated HTable */
     uint64_t len;               /*!< Total data length */
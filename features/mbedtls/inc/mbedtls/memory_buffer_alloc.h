@@ -43,6 +43,14 @@
 #define MBEDTLS_MEMORY_ALIGN_MULTIPLE       4 /**< Align on multiples of this value */
 #endif
 
+#if !defined(MBEDTLS_MEMORY_SLAB_MAX_SIZE)
+#define MBEDTLS_MEMORY_SLAB_MAX_SIZE      256 /**< Largest allocation served from slabs */
+#endif
+
+#if !defined(MBEDTLS_MEMORY_SLAB_PAGE_SIZE)
+#define MBEDTLS_MEMORY_SLAB_PAGE_SIZE    1024 /**< Bytes of the heap a slab takes */
+#endif
+
 /* \} name SECTION: Module settings */
 
 #define MBEDTLS_MEMORY_VERIFY_NONE         0
@@ -64,7 +72,9 @@ extern "C" {
  *           MBEDTLS_THREADING_C is defined)
  *
  * \note    This code is not optimized and provides a straight-forward
- *          implementation of a stack-based memory allocator.
+ *          implementation of a stack-based memory allocator, unless
+ *          MBEDTLS_MEMORY_BUFFER_ALLOC_SLABS serves small allocations
+ *          from slabs.
  *
  * \param buf   buffer to use as heap
  * \param len   size of the buffer
@@ -101,6 +111,7 @@ void mbedtls_memory_buffer_alloc_status( void );
  * \param max_used      Peak number of bytes in use or committed. This
  *                      includes bytes in allocated blocks too small to split
  *                      into smaller blocks but larger than the requested size.
+ *                      A slab counts as a block, committed in full.
  * \param max_blocks    Peak number of blocks in use, including free and used
  */
 void mbedtls_memory_buffer_alloc_max_get( size_t *max_used, size_t *max_blocks );
@@ -116,11 +127,39 @@ void mbedtls_memory_buffer_alloc_max_reset( void );
  * \param cur_used      Current number of bytes in use or committed. This
  *                      includes bytes in allocated blocks too small to split
  *                      into smaller blocks but larger than the requested size.
+ *                      A slab counts as a block, committed in full.
  * \param cur_blocks    Current number of blocks in use, including free and used
  */
 void mbedtls_memory_buffer_alloc_cur_get( size_t *cur_used, size_t *cur_blocks );
 #endif /* MBEDTLS_MEMORY_DEBUG */
 
+/**
+ * \brief   Get the fragmentation of the free space of the heap
+ *
+ *          The largest allocation that can succeed is largest_free bytes,
+ *          however many bytes are free in total.
+ *
+ * \param free_bytes    Bytes in free blocks
+ * \param free_blocks   Number of free blocks
+ * \param largest_free  Bytes in the largest free block
+ */
+void mbedtls_memory_buffer_alloc_frag_get( size_t *free_bytes, size_t *free_blocks,
+                                           size_t *largest_free );
+
+#if defined(MBEDTLS_MEMORY_BUFFER_ALLOC_SLABS)
+/**
+ * \brief   Get the bytes of the heap held by slabs
+ *
+ *          Slabs take MBEDTLS_MEMORY_SLAB_PAGE_SIZE bytes of the heap at a
+ *          time. The last empty slab of each size class is kept for reuse,
+ *          and returned to the heap when a larger allocation needs the room.
+ *
+ * \param slab_bytes    Bytes of the heap in slabs
+ * \param slab_free     Bytes in free chunks of slabs
+ */
+void mbedtls_memory_buffer_alloc_slab_get( size_t *slab_bytes, size_t *slab_free );
+#endif /* MBEDTLS_MEMORY_BUFFER_ALLOC_SLABS */
+
 /**
  * \brief   Verifies that all headers in the memory buffer are correct
  *          and contain sane values. Helps debug buffer-overflow errors.
@@ -109,6 +109,7 @@
 #define MBEDTLS_ERR_SSL_UNEXPECTED_RECORD                 -0x6700  /**< Record header looks valid but is not expected. */
 #define MBEDTLS_ERR_SSL_NON_FATAL                         -0x6680  /**< The alert message received indicates a non-fatal error. */
 #define MBEDTLS_ERR_SSL_INVALID_VERIFY_HASH               -0x6600  /**< Couldn't set the hash for verifying CertificateVerify */
+#define MBEDTLS_ERR_SSL_WANT_ASYNC                        -0x6500  /**< An asynchronous private key operation is in progress. */
 
 /*
  * Various constants
@@ -222,6 +223,22 @@
 #define MBEDTLS_SSL_MAX_CONTENT_LEN         16384   /**< Size of the input / output buffer */
 #endif
 
+/*
+ * Maximum length of incoming and outgoing records, defaulting to the above.
+ *
+ * Reducing MBEDTLS_SSL_OUT_CONTENT_LEN is always safe, as only the records we
+ * send are limited. MBEDTLS_SSL_IN_CONTENT_LEN may only be reduced if all
+ * peers are known to send smaller records, for example because they honour
+ * the Max Fragment Length extension.
+ */
+#if !defined(MBEDTLS_SSL_IN_CONTENT_LEN)
+#define MBEDTLS_SSL_IN_CONTENT_LEN          MBEDTLS_SSL_MAX_CONTENT_LEN
+#endif
+
+#if !defined(MBEDTLS_SSL_OUT_CONTENT_LEN)
+#define MBEDTLS_SSL_OUT_CONTENT_LEN         MBEDTLS_SSL_MAX_CONTENT_LEN
+#endif
+
 /* \} name SECTION: Module settings */
 
 /*
@@ -541,6 +558,101 @@ typedef struct mbedtls_ssl_key_cert mbedtls_ssl_key_cert;
 typedef struct mbedtls_ssl_flight_item mbedtls_ssl_flight_item;
 #endif
 
+#if defined(MBEDTLS_SSL_ASYNC_PRIVATE)
+/**
+ * \brief          Callback type: start an asynchronous signature
+ *
+ *                 Called when the handshake needs a signature with the
+ *                 private key of our certificate: by a server for its
+ *                 ServerKeyExchange message, by a client for its
+ *                 CertificateVerify message.
+ *
+ *                 The operation may complete in this callback, or be handed
+ *                 to a worker thread or a hardware engine. Either way its
+ *                 result is collected with the resume callback. The hash
+ *                 is only valid during this call, copy it if needed later.
+ *                 Per-operation state can be kept with
+ *                 mbedtls_ssl_set_async_operation_data().
+ *
+ * \param ssl      SSL context doing the handshake
+ * \param cert     Certificate whose private key is to sign
+ * \param md_alg   Hash algorithm, MBEDTLS_MD_NONE for the MD5 and SHA-1
+ *                 concatenation of TLS 1.0 and 1.1, as in mbedtls_pk_sign()
+ * \param hash     Hash to sign
+ * \param hash_len Length of the hash
+ *
+ * \return         0 if the operation was started and its result can be
+ *                 collected right away,
+ *                 MBEDTLS_ERR_SSL_WANT_ASYNC if it was started and is
+ *                 still in progress,
+ *                 MBEDTLS_ERR_SSL_HW_ACCEL_FALLTHROUGH to have the
+ *                 handshake sign with mbedtls_pk_sign() instead,
+ *                 or any other error code to abort the handshake.
+ */
+typedef int mbedtls_ssl_async_sign_t( mbedtls_ssl_context *ssl,
+                                      mbedtls_x509_crt *cert,
+                                      mbedtls_md_type_t md_alg,
+                                      const unsigned char *hash,
+                                      size_t hash_len );
+
+/**
+ * \brief          Callback type: start an asynchronous decryption
+ *
+ *                 Called by a server when it needs to decrypt the premaster
+ *                 secret of an RSA key exchange with the private key of its
+ *                 certificate, as mbedtls_pk_decrypt() would. Works as
+ *                 the sign callback otherwise.
+ *
+ * \note           Errors of the decryption, including those returned by
+ *                 the resume callback, are not reported to the client, so
+ *                 as not to tell it about the padding of the premaster.
+ *
+ * \param ssl      SSL context doing the handshake
+ * \param cert     Certificate whose private key is to decrypt
+ * \param input    Encrypted premaster secret
+ * \param input_len Length of the encrypted premaster secret
+ *
+ * \return         As for mbedtls_ssl_async_sign_t.
+ */
+typedef int mbedtls_ssl_async_decrypt_t( mbedtls_ssl_context *ssl,
+                                         mbedtls_x509_crt *cert,
+                                         const unsigned char *input,
+                                         size_t input_len );
+
+/**
+ * \brief          Callback type: collect the result of an asynchronous
+ *                 operation
+ *
+ *                 Called once after a start callback returns 0, and by
+ *                 every call to mbedtls_ssl_handshake() after it returns
+ *                 MBEDTLS_ERR_SSL_WANT_ASYNC, until the operation completes.
+ *
+ * \param ssl      SSL context doing the handshake
+ * \param output   Buffer for the signature or the decrypted premaster
+ * \param output_len Length written to the buffer
+ * \param output_size Size of the buffer
+ *
+ * \return         0 once the operation has completed,
+ *                 MBEDTLS_ERR_SSL_WANT_ASYNC while it is in progress,
+ *                 or any other error code if it failed.
+ */
+typedef int mbedtls_ssl_async_resume_t( mbedtls_ssl_context *ssl,
+                                        unsigned char *output,
+                                        size_t *output_len,
+                                        size_t output_size );
+
+/**
+ * \brief          Callback type: cancel an asynchronous operation
+ *
+ *                 Called when the handshake is freed or reset while an
+ *                 operation is in progress, which then must not touch the
+ *                 context any more.
+ *
+ * \param ssl      SSL context doing the handshake
+ */
+typedef void mbedtls_ssl_async_cancel_t( mbedtls_ssl_context *ssl );
+#endif /* MBEDTLS_SSL_ASYNC_PRIVATE */
+
 /*
  * This structure is used for storing current session data.
  */
@@ -650,6 +762,15 @@ struct mbedtls_ssl_config
     void *p_export_keys;            /*!< context for key export callback    */
 #endif
 
+#if defined(MBEDTLS_SSL_ASYNC_PRIVATE)
+    /** Callbacks for asynchronous private key operations                   */
+    mbedtls_ssl_async_sign_t *f_async_sign_start;
+    mbedtls_ssl_async_decrypt_t *f_async_decrypt_start;
+    mbedtls_ssl_async_resume_t *f_async_resume;
+    mbedtls_ssl_async_cancel_t *f_async_cancel;
+    void *p_async_config_data;      /*!< context for the async callbacks    */
+#endif
+
 #if defined(MBEDTLS_X509_CRT_PARSE_C)
     const mbedtls_x509_crt_profile *cert_profile; /*!< verification profile */
     mbedtls_ssl_key_cert *key_cert; /*!< own certificate/key pair(s)        */
@@ -819,6 +940,9 @@ struct mbedtls_ssl_context
      * Record layer (incoming data)
      */
     unsigned char *in_buf;      /*!< input buffer                     */
+#if defined(MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH)
+    size_t in_buf_len;          /*!< current size of in_buf           */
+#endif
     unsigned char *in_ctr;      /*!< 64-bit incoming message counter
                                      TLS: maintained by us
                                      DTLS: read from peer             */
@@ -850,6 +974,9 @@ struct mbedtls_ssl_context
      * Record layer (outgoing data)
      */
     unsigned char *out_buf;     /*!< output buffer                    */
+#if defined(MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH)
+    size_t out_buf_len;         /*!< current size of out_buf          */
+#endif
     unsigned char *out_ctr;     /*!< 64-bit outgoing message counter  */
     unsigned char *out_hdr;     /*!< start of record header           */
     unsigned char *out_len;     /*!< two-bytes message length field   */
@@ -1288,6 +1415,74 @@ void mbedtls_ssl_conf_export_keys_cb( mbedtls_ssl_config *conf,
         void *p_export_keys );
 #endif /* MBEDTLS_SSL_EXPORT_KEYS */
 
+#if defined(MBEDTLS_SSL_ASYNC_PRIVATE)
+/**
+ * \brief           Configure asynchronous private key operations.
+ *                  (Default: none.)
+ *
+ *                  Signatures and decryptions with the private key of our
+ *                  certificate are started with these callbacks instead of
+ *                  mbedtls_pk_sign() and mbedtls_pk_decrypt(), so that they
+ *                  can run on a worker thread or a hardware engine. While
+ *                  one is in progress, mbedtls_ssl_handshake() returns
+ *                  MBEDTLS_ERR_SSL_WANT_ASYNC and is to be called again once
+ *                  the operation completes.
+ *
+ * \note            See \c mbedtls_ssl_async_sign_t and the other callback
+ *                  types.
+ *
+ * \param conf              SSL configuration
+ * \param f_async_sign      Callback to start a signature, or NULL to sign
+ *                          synchronously
+ * \param f_async_decrypt   Callback to start a decryption, or NULL to
+ *                          decrypt synchronously
+ * \param f_async_resume    Callback to collect the result of an operation
+ * \param f_async_cancel    Callback to cancel an operation, or NULL
+ * \param config_data       Context for the callbacks, see
+ *                          mbedtls_ssl_conf_get_async_config_data()
+ */
+void mbedtls_ssl_conf_async_private_cb( mbedtls_ssl_config *conf,
+        mbedtls_ssl_async_sign_t *f_async_sign,
+        mbedtls_ssl_async_decrypt_t *f_async_decrypt,
+        mbedtls_ssl_async_resume_t *f_async_resume,
+        mbedtls_ssl_async_cancel_t *f_async_cancel,
+        void *config_data );
+
+/**
+ * \brief           Get the context of the asynchronous callbacks
+ *
+ * \param conf      SSL configuration
+ *
+ * \return          The config_data given to
+ *                  mbedtls_ssl_conf_async_private_cb()
+ */
+void *mbedtls_ssl_conf_get_async_config_data( const mbedtls_ssl_config *conf );
+
+/**
+ * \brief           Get the state of the asynchronous operation in progress
+ *
+ * \param ssl       SSL context
+ *
+ * \return          The value last set with
+ *                  mbedtls_ssl_set_async_operation_data() during the
+ *                  current handshake, or NULL
+ */
+void *mbedtls_ssl_get_async_operation_data( const mbedtls_ssl_context *ssl );
+
+/**
+ * \brief           Keep state for the asynchronous operation in progress
+ *
+ *                  Meant for the callbacks. The value is cleared when the
+ *                  operation completes or is cancelled, and with the
+ *                  handshake.
+ *
+ * \param ssl       SSL context
+ * \param ctx       State of the operation
+ */
+void mbedtls_ssl_set_async_operation_data( mbedtls_ssl_context *ssl,
+                                           void *ctx );
+#endif /* MBEDTLS_SSL_ASYNC_PRIVATE */
+
 /**
  * \brief          Callback type: generate a cookie
  *
@@ -56,6 +56,10 @@ typedef struct mbedtls_ssl_cache_entry mbedtls_ssl_cache_entry;
 
 /**
  * \brief   This structure is used for storing cache entries
+ *
+ *          Each entry is on the chain of its hash bucket, on the list of
+ *          entries in order of use and, with MBEDTLS_HAVE_TIME, on the
+ *          list of entries in order of age.
  */
 struct mbedtls_ssl_cache_entry
 {
@@ -66,17 +70,45 @@ struct mbedtls_ssl_cache_entry
 #if defined(MBEDTLS_X509_CRT_PARSE_C)
     mbedtls_x509_buf peer_cert;         /*!< entry peer_cert    */
 #endif
-    mbedtls_ssl_cache_entry *next;      /*!< chain pointer      */
+    mbedtls_ssl_cache_entry *next;      /*!< hash bucket chain  */
+    mbedtls_ssl_cache_entry *lru_prev;  /*!< more recently used */
+    mbedtls_ssl_cache_entry *lru_next;  /*!< less recently used */
+#if defined(MBEDTLS_HAVE_TIME)
+    mbedtls_ssl_cache_entry *age_prev;  /*!< older entry        */
+    mbedtls_ssl_cache_entry *age_next;  /*!< newer entry        */
+#endif
 };
 
+/**
+ * \brief Cache statistics
+ */
+typedef struct
+{
+    unsigned long hits;         /*!< sessions found by get              */
+    unsigned long misses;       /*!< sessions not found by get          */
+    unsigned long evictions;    /*!< entries dropped to make room       */
+    unsigned long expirations;  /*!< entries dropped after the timeout  */
+    int entries;                /*!< entries currently in the cache     */
+}
+mbedtls_ssl_cache_stats;
+
 /**
  * \brief Cache context
  */
 struct mbedtls_ssl_cache_context
 {
-    mbedtls_ssl_cache_entry *chain;     /*!< start of the chain     */
+    mbedtls_ssl_cache_entry **buckets;  /*!< hash table of entries  */
+    size_t bucket_count;                /*!< table size, power of 2 */
+    mbedtls_ssl_cache_entry *lru_head;  /*!< most recently used     */
+    mbedtls_ssl_cache_entry *lru_tail;  /*!< least recently used    */
+#if defined(MBEDTLS_HAVE_TIME)
+    mbedtls_ssl_cache_entry *age_head;  /*!< oldest entry           */
+    mbedtls_ssl_cache_entry *age_tail;  /*!< newest entry           */
+#endif
+    int entries;                /*!< entries in the cache   */
     int timeout;                /*!< cache entry timeout    */
     int max_entries;            /*!< maximum entries        */
+    mbedtls_ssl_cache_stats stats;      /*!< statistics             */
 #if defined(MBEDTLS_THREADING_C)
     mbedtls_threading_mutex_t mutex;    /*!< mutex                  */
 #endif
@@ -129,6 +161,17 @@ void mbedtls_ssl_cache_set_timeout( mbedtls_ssl_cache_context *cache, int timeou
  */
 void mbedtls_ssl_cache_set_max_entries( mbedtls_ssl_cache_context *cache, int max );
 
+/**
+ * \brief          Get the cache statistics
+ *                 (Thread-safe if MBEDTLS_THREADING_C is enabled)
+ *
+ * \param cache    SSL cache context
+ * \param stats    statistics to fill in
+ * \param reset    reset the counters after reading them
+ */
+void mbedtls_ssl_cache_get_stats( mbedtls_ssl_cache_context *cache,
+                                  mbedtls_ssl_cache_stats *stats, int reset );
+
 /**
  * \brief          Free referenced items in a cache context and clear memory
  *
@@ -138,13 +138,21 @@
 #define MBEDTLS_SSL_PADDING_ADD              0
 #endif
 
-#define MBEDTLS_SSL_BUFFER_LEN  ( MBEDTLS_SSL_MAX_CONTENT_LEN               \
-                        + MBEDTLS_SSL_COMPRESSION_ADD               \
+#define MBEDTLS_SSL_PAYLOAD_OVERHEAD ( MBEDTLS_SSL_COMPRESSION_ADD       \
                         + 29 /* counter + header + IV */    \
                         + MBEDTLS_SSL_MAC_ADD                       \
                         + MBEDTLS_SSL_PADDING_ADD                   \
                         )
 
+#define MBEDTLS_SSL_BUFFER_LEN  ( MBEDTLS_SSL_MAX_CONTENT_LEN               \
+                        + MBEDTLS_SSL_PAYLOAD_OVERHEAD )
+
+#define MBEDTLS_SSL_IN_BUFFER_LEN  ( MBEDTLS_SSL_IN_CONTENT_LEN             \
+                        + MBEDTLS_SSL_PAYLOAD_OVERHEAD )
+
+#define MBEDTLS_SSL_OUT_BUFFER_LEN ( MBEDTLS_SSL_OUT_CONTENT_LEN            \
+                        + MBEDTLS_SSL_PAYLOAD_OVERHEAD )
+
 /*
  * TLS extension flags (for extensions with outgoing ServerHello content
  * that need it (e.g. for RENEGOTIATION_INFO the server already knows because
@@ -261,6 +269,11 @@ struct mbedtls_ssl_handshake_params
 #if defined(MBEDTLS_SSL_EXTENDED_MASTER_SECRET)
     int extended_ms;                    /*!< use Extended Master Secret? */
 #endif
+
+#if defined(MBEDTLS_SSL_ASYNC_PRIVATE)
+    int async_in_progress;              /*!< private key operation pending */
+    void *user_async_ctx;               /*!< state of the async callbacks  */
+#endif
 };
 
 /*
@@ -425,6 +438,27 @@ static inline mbedtls_x509_crt *mbedtls_ssl_own_cert( mbedtls_ssl_context *ssl )
     return( key_cert == NULL ? NULL : key_cert->cert );
 }
 
+/*
+ * Sign or decrypt with our private key, through the asynchronous callbacks
+ * when they are set. MBEDTLS_ERR_SSL_WANT_ASYNC means the operation is in
+ * progress: the next call of the handshake step collects its result with
+ * mbedtls_ssl_async_resume() instead of starting it again.
+ */
+int mbedtls_ssl_own_key_sign( mbedtls_ssl_context *ssl,
+                              mbedtls_md_type_t md_alg,
+                              const unsigned char *hash, size_t hash_len,
+                              unsigned char *sig, size_t *sig_len,
+                              size_t sig_size );
+int mbedtls_ssl_own_key_decrypt( mbedtls_ssl_context *ssl,
+                                 const unsigned char *input, size_t ilen,
+                                 unsigned char *output, size_t *olen,
+                                 size_t osize );
+#if defined(MBEDTLS_SSL_ASYNC_PRIVATE)
+int mbedtls_ssl_async_resume( mbedtls_ssl_context *ssl,
+                              unsigned char *output, size_t *output_len,
+                              size_t output_size );
+#endif
+
 /*
  * Check usage of a certificate wrt extensions:
  * keyUsage, extendedKeyUsage (later), and nSCertType (later).
@@ -467,6 +501,30 @@ static inline size_t mbedtls_ssl_hs_hdr_len( const mbedtls_ssl_context *ssl )
     return( 4 );
 }
 
+/*
+ * Current size of the record buffers, which only differs from the maximum
+ * with MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH
+ */
+static inline size_t mbedtls_ssl_in_buf_len( const mbedtls_ssl_context *ssl )
+{
+#if defined(MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH)
+    return( ssl->in_buf_len );
+#else
+    ((void) ssl);
+    return( MBEDTLS_SSL_IN_BUFFER_LEN );
+#endif
+}
+
+static inline size_t mbedtls_ssl_out_buf_len( const mbedtls_ssl_context *ssl )
+{
+#if defined(MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH)
+    return( ssl->out_buf_len );
+#else
+    ((void) ssl);
+    return( MBEDTLS_SSL_OUT_BUFFER_LEN );
+#endif
+}
+
 #if defined(MBEDTLS_SSL_PROTO_DTLS)
 void mbedtls_ssl_send_flight_completed( mbedtls_ssl_context *ssl );
 void mbedtls_ssl_recv_flight_completed( mbedtls_ssl_context *ssl );
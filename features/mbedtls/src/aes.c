@@ -1016,6 +1016,34 @@ int mbedtls_aes_crypt_ctr( mbedtls_aes_context *ctx,
     int c, i;
     size_t n = *nc_off;
 
+#if defined(MBEDTLS_AES_CTR_BLOCKS)
+    /* Whole blocks, until a carry out of the last four bytes of the counter */
+    while( n == 0 && length >= 16 )
+    {
+        size_t blocks = length / 16;
+        uint32_t low = ( (uint32_t) nonce_counter[12] << 24 ) |
+                       ( (uint32_t) nonce_counter[13] << 16 ) |
+                       ( (uint32_t) nonce_counter[14] <<  8 ) |
+                       ( (uint32_t) nonce_counter[15]       );
+
+        if( low != 0 && blocks > (uint32_t)( 0 - low ) )
+            blocks = (uint32_t)( 0 - low );
+
+        mbedtls_aes_crypt_ctr32( ctx, blocks, nonce_counter, input, output );
+
+        if( (uint32_t)( low + blocks ) == 0 )
+        {
+            for( i = 12; i > 0; i-- )
+                if( ++nonce_counter[i - 1] != 0 )
+                    break;
+        }
+
+        input  += blocks * 16;
+        output += blocks * 16;
+        length -= blocks * 16;
+    }
+#endif /* MBEDTLS_AES_CTR_BLOCKS */
+
     while( length-- )
     {
         if( n == 0 ) {
@@ -1037,6 +1065,194 @@ int mbedtls_aes_crypt_ctr( mbedtls_aes_context *ctx,
 }
 #endif /* MBEDTLS_CIPHER_MODE_CTR */
 
+#if defined(MBEDTLS_AES_CTR_BLOCKS)
+#if !defined(MBEDTLS_AES_ENCRYPT_ALT)
+/*
+ * AES-CTR of whole blocks with the T-tables
+ *
+ * Only byte 15 of the counter block changes from one block to the next,
+ * except when it wraps around, so the first round has a single table lookup
+ * that depends on it, and the second round four. Everything else in these
+ * two rounds is computed once per 256 blocks ("counter mode caching" in
+ * Bernstein and Schwabe, "New AES software speed records", 2008).
+ */
+static void aes_ctr32_cached( mbedtls_aes_context *ctx,
+                              size_t blocks,
+                              unsigned char counter[16],
+                              const unsigned char *input,
+                              unsigned char *output )
+{
+    int i;
+    size_t n;
+    uint32_t *RK, X0, X1, X2, X3, Y0, Y1, Y2, Y3;
+    uint32_t P0, Q0, Q1, Q2, Q3, K, W;
+
+    K = ( ctx->rk[3] >> 24 ) & 0xFF;
+
+    while( blocks > 0 )
+    {
+        RK = ctx->rk;
+
+        GET_UINT32_LE( X0, counter,  0 ); X0 ^= RK[0];
+        GET_UINT32_LE( X1, counter,  4 ); X1 ^= RK[1];
+        GET_UINT32_LE( X2, counter,  8 ); X2 ^= RK[2];
+        GET_UINT32_LE( X3, counter, 12 ); X3 ^= RK[3];
+
+        P0 = RK[4] ^ FT0[ ( X0       ) & 0xFF ] ^
+                     FT1[ ( X1 >>  8 ) & 0xFF ] ^
+                     FT2[ ( X2 >> 16 ) & 0xFF ];
+
+        Y1 = RK[5] ^ FT0[ ( X1       ) & 0xFF ] ^
+                     FT1[ ( X2 >>  8 ) & 0xFF ] ^
+                     FT2[ ( X3 >> 16 ) & 0xFF ] ^
+                     FT3[ ( X0 >> 24 ) & 0xFF ];
+
+        Y2 = RK[6] ^ FT0[ ( X2       ) & 0xFF ] ^
+                     FT1[ ( X3 >>  8 ) & 0xFF ] ^
+                     FT2[ ( X0 >> 16 ) & 0xFF ] ^
+                     FT3[ ( X1 >> 24 ) & 0xFF ];
+
+        Y3 = RK[7] ^ FT0[ ( X3       ) & 0xFF ] ^
+                     FT1[ ( X0 >>  8 ) & 0xFF ] ^
+                     FT2[ ( X1 >> 16 ) & 0xFF ] ^
+                     FT3[ ( X2 >> 24 ) & 0xFF ];
+
+        Q0 = RK[8]  ^ FT1[ ( Y1 >>  8 ) & 0xFF ] ^
+                      FT2[ ( Y2 >> 16 ) & 0xFF ] ^
+                      FT3[ ( Y3 >> 24 ) & 0xFF ];
+
+        Q1 = RK[9]  ^ FT0[ ( Y1       ) & 0xFF ] ^
+                      FT1[ ( Y2 >>  8 ) & 0xFF ] ^
+                      FT2[ ( Y3 >> 16 ) & 0xFF ];
+
+        Q2 = RK[10] ^ FT0[ ( Y2       ) & 0xFF ] ^
+                      FT1[ ( Y3 >>  8 ) & 0xFF ] ^
+                      FT3[ ( Y1 >> 24 ) & 0xFF ];
+
+        Q3 = RK[11] ^ FT0[ ( Y3       ) & 0xFF ] ^
+                      FT2[ ( Y1 >> 16 ) & 0xFF ] ^
+                      FT3[ ( Y2 >> 24 ) & 0xFF ];
+
+        /* Blocks until byte 15 wraps around */
+        n = 256 - counter[15];
+        if( n > blocks )
+            n = blocks;
+        blocks -= n;
+
+        while( n-- > 0 )
+        {
+            Y0 = P0 ^ FT3[ counter[15] ^ K ];
+
+            X0 = Q0 ^ FT0[ ( Y0       ) & 0xFF ];
+            X1 = Q1 ^ FT3[ ( Y0 >> 24 ) & 0xFF ];
+            X2 = Q2 ^ FT2[ ( Y0 >> 16 ) & 0xFF ];
+            X3 = Q3 ^ FT1[ ( Y0 >>  8 ) & 0xFF ];
+
+            RK = ctx->rk + 12;
+
+            for( i = ( ctx->nr >> 1 ) - 2; i > 0; i-- )
+            {
+                AES_FROUND( Y0, Y1, Y2, Y3, X0, X1, X2, X3 );
+                AES_FROUND( X0, X1, X2, X3, Y0, Y1, Y2, Y3 );
+            }
+
+            AES_FROUND( Y0, Y1, Y2, Y3, X0, X1, X2, X3 );
+
+            X0 = *RK++ ^ \
+                    ( (uint32_t) FSb[ ( Y0       ) & 0xFF ]       ) ^
+                    ( (uint32_t) FSb[ ( Y1 >>  8 ) & 0xFF ] <<  8 ) ^
+                    ( (uint32_t) FSb[ ( Y2 >> 16 ) & 0xFF ] << 16 ) ^
+                    ( (uint32_t) FSb[ ( Y3 >> 24 ) & 0xFF ] << 24 );
+
+            X1 = *RK++ ^ \
+                    ( (uint32_t) FSb[ ( Y1       ) & 0xFF ]       ) ^
+                    ( (uint32_t) FSb[ ( Y2 >>  8 ) & 0xFF ] <<  8 ) ^
+                    ( (uint32_t) FSb[ ( Y3 >> 16 ) & 0xFF ] << 16 ) ^
+                    ( (uint32_t) FSb[ ( Y0 >> 24 ) & 0xFF ] << 24 );
+
+            X2 = *RK++ ^ \
+                    ( (uint32_t) FSb[ ( Y2       ) & 0xFF ]       ) ^
+                    ( (uint32_t) FSb[ ( Y3 >>  8 ) & 0xFF ] <<  8 ) ^
+                    ( (uint32_t) FSb[ ( Y0 >> 16 ) & 0xFF ] << 16 ) ^
+                    ( (uint32_t) FSb[ ( Y1 >> 24 ) & 0xFF ] << 24 );
+
+            X3 = *RK++ ^ \
+                    ( (uint32_t) FSb[ ( Y3       ) & 0xFF ]       ) ^
+                    ( (uint32_t) FSb[ ( Y0 >>  8 ) & 0xFF ] <<  8 ) ^
+                    ( (uint32_t) FSb[ ( Y1 >> 16 ) & 0xFF ] << 16 ) ^
+                    ( (uint32_t) FSb[ ( Y2 >> 24 ) & 0xFF ] << 24 );
+
+            /* Read the whole input block before writing any output, which
+             * may overlap it */
+            GET_UINT32_LE( W, input,  0 ); X0 ^= W;
+            GET_UINT32_LE( W, input,  4 ); X1 ^= W;
+            GET_UINT32_LE( W, input,  8 ); X2 ^= W;
+            GET_UINT32_LE( W, input, 12 ); X3 ^= W;
+
+            PUT_UINT32_LE( X0, output,  0 );
+            PUT_UINT32_LE( X1, output,  4 );
+            PUT_UINT32_LE( X2, output,  8 );
+            PUT_UINT32_LE( X3, output, 12 );
+
+            input  += 16;
+            output += 16;
+
+            if( ++counter[15] == 0 )
+            {
+                for( i = 15; i > 12; i-- )
+                    if( ++counter[i - 1] != 0 )
+                        break;
+            }
+        }
+    }
+}
+#endif /* !MBEDTLS_AES_ENCRYPT_ALT */
+
+/*
+ * AES-CTR of whole blocks with a 32-bit counter
+ */
+int mbedtls_aes_crypt_ctr32( mbedtls_aes_context *ctx,
+                             size_t blocks,
+                             unsigned char counter[16],
+                             const unsigned char *input,
+                             unsigned char *output )
+{
+    int i;
+    unsigned char stream[16];
+
+#if !defined(MBEDTLS_AES_ENCRYPT_ALT)
+#if defined(MBEDTLS_AESNI_C) && defined(MBEDTLS_HAVE_X86_64)
+    if( ! mbedtls_aesni_has_support( MBEDTLS_AESNI_AES ) )
+#endif
+#if defined(MBEDTLS_PADLOCK_C) && defined(MBEDTLS_HAVE_X86)
+    if( ! aes_padlock_ace )
+#endif
+    {
+        aes_ctr32_cached( ctx, blocks, counter, input, output );
+        return( 0 );
+    }
+#endif /* !MBEDTLS_AES_ENCRYPT_ALT */
+
+    /* Block by block with the accelerator or the alternative implementation */
+    while( blocks-- > 0 )
+    {
+        mbedtls_aes_crypt_ecb( ctx, MBEDTLS_AES_ENCRYPT, counter, stream );
+
+        for( i = 0; i < 16; i++ )
+            output[i] = (unsigned char)( input[i] ^ stream[i] );
+
+        for( i = 16; i > 12; i-- )
+            if( ++counter[i - 1] != 0 )
+                break;
+
+        input  += 16;
+        output += 16;
+    }
+
+    return( 0 );
+}
+#endif /* MBEDTLS_AES_CTR_BLOCKS */
+
 #endif /* !MBEDTLS_AES_ALT */
 
 #if defined(MBEDTLS_SELF_TEST)
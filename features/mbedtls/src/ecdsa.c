@@ -42,6 +42,14 @@
 #include "mbedtls/hmac_drbg.h"
 #endif
 
+#if defined(MBEDTLS_PLATFORM_C)
+#include "mbedtls/platform.h"
+#else
+#include <stdlib.h>
+#define mbedtls_calloc    calloc
+#define mbedtls_free       free
+#endif
+
 /*
  * Derive a suitable integer for group grp from a buffer of length len
  * SEC1 4.1.3 step 5 aka SEC1 4.1.4 step 3
@@ -278,6 +286,244 @@ cleanup:
     return( ret );
 }
 
+/*
+ * Check a batch of ECDSA signatures with one random linear combination.
+ *
+ * For a valid signature, u1 G + u2 Q = R where x(R) = r mod n. Recovering
+ * R_i from r_i, as r_i is almost always x(R_i) itself, and with random
+ * a_0 = 1, a_1, ..., a_(k-1) of 128 bits:
+ *
+ *     (sum a_i u1_i) G + sum (a_i u2_i) Q_i = sum +-(a_i R_i)
+ *
+ * The left-hand side is a single multiplication with shared doublings, the
+ * terms of a public key appearing several times being merged. The sign of
+ * each R_i is unknown, and mbedtls_ecp_check_signed_sum() tries them all.
+ *
+ * Returns MBEDTLS_ERR_ECP_VERIFY_FAILED if a signature may be invalid, and
+ * other errors only for allocation or RNG failures.
+ */
+static int ecdsa_verify_batch_core( mbedtls_ecp_group *grp,
+                                    const mbedtls_ecdsa_batch_item *items, size_t k,
+                                    int (*f_rng)(void *, unsigned char *, size_t),
+                                    void *p_rng )
+{
+    int ret;
+    size_t i, j, keys = 0;
+    mbedtls_mpi *w = NULL, *m = NULL, a, e, t;
+    mbedtls_ecp_point *P = NULL, *T = NULL, R;
+
+    mbedtls_mpi_init( &a ); mbedtls_mpi_init( &e ); mbedtls_mpi_init( &t );
+    mbedtls_ecp_point_init( &R );
+
+    if( ( w = mbedtls_calloc( k, sizeof( mbedtls_mpi ) ) ) == NULL ||
+        ( m = mbedtls_calloc( k + 1, sizeof( mbedtls_mpi ) ) ) == NULL ||
+        ( P = mbedtls_calloc( k + 1, sizeof( mbedtls_ecp_point ) ) ) == NULL ||
+        ( T = mbedtls_calloc( k, sizeof( mbedtls_ecp_point ) ) ) == NULL )
+    {
+        ret = MBEDTLS_ERR_ECP_ALLOC_FAILED;
+        goto cleanup;
+    }
+
+    for( i = 0; i < k; i++ )
+    {
+        mbedtls_mpi_init( &w[i] );
+        mbedtls_ecp_point_init( &T[i] );
+    }
+    for( i = 0; i <= k; i++ )
+    {
+        mbedtls_mpi_init( &m[i] );
+        mbedtls_ecp_point_init( &P[i] );
+    }
+
+    /*
+     * r and s in range 1..n-1, valid public keys
+     */
+    for( i = 0; i < k; i++ )
+    {
+        if( mbedtls_mpi_cmp_int( items[i].r, 1 ) < 0 ||
+            mbedtls_mpi_cmp_mpi( items[i].r, &grp->N ) >= 0 ||
+            mbedtls_mpi_cmp_int( items[i].s, 1 ) < 0 ||
+            mbedtls_mpi_cmp_mpi( items[i].s, &grp->N ) >= 0 ||
+            mbedtls_ecp_check_pubkey( grp, items[i].Q ) != 0 )
+        {
+            ret = MBEDTLS_ERR_ECP_VERIFY_FAILED;
+            goto cleanup;
+        }
+    }
+
+    /*
+     * w_i = 1 / s_i mod n, with a single inversion:
+     * w_i = (s_0 ... s_(i-1)) / (s_0 ... s_i)
+     */
+    MBEDTLS_MPI_CHK( mbedtls_mpi_copy( &w[0], items[0].s ) );
+    for( i = 1; i < k; i++ )
+    {
+        MBEDTLS_MPI_CHK( mbedtls_mpi_mul_mpi( &w[i], &w[i - 1], items[i].s ) );
+        MBEDTLS_MPI_CHK( mbedtls_mpi_mod_mpi( &w[i], &w[i], &grp->N ) );
+    }
+
+    MBEDTLS_MPI_CHK( mbedtls_mpi_inv_mod( &t, &w[k - 1], &grp->N ) );
+
+    for( i = k - 1; i > 0; i-- )
+    {
+        MBEDTLS_MPI_CHK( mbedtls_mpi_mul_mpi( &w[i], &t, &w[i - 1] ) );
+        MBEDTLS_MPI_CHK( mbedtls_mpi_mod_mpi( &w[i], &w[i], &grp->N ) );
+        MBEDTLS_MPI_CHK( mbedtls_mpi_mul_mpi( &t, &t, items[i].s ) );
+        MBEDTLS_MPI_CHK( mbedtls_mpi_mod_mpi( &t, &t, &grp->N ) );
+    }
+    MBEDTLS_MPI_CHK( mbedtls_mpi_copy( &w[0], &t ) );
+
+    /*
+     * m_0 = sum a_i e_i w_i for G, sum a_i r_i w_i for each distinct Q,
+     * T_i = a_i R_i
+     */
+    MBEDTLS_MPI_CHK( mbedtls_ecp_copy( &P[0], &grp->G ) );
+    MBEDTLS_MPI_CHK( mbedtls_mpi_lset( &m[0], 0 ) );
+
+    for( i = 0; i < k; i++ )
+    {
+        if( i == 0 )
+        {
+            MBEDTLS_MPI_CHK( mbedtls_mpi_lset( &a, 1 ) );
+        }
+        else
+        {
+            MBEDTLS_MPI_CHK( mbedtls_mpi_fill_random( &a, 16, f_rng, p_rng ) );
+            MBEDTLS_MPI_CHK( mbedtls_mpi_set_bit( &a, 127, 1 ) );
+        }
+
+        MBEDTLS_MPI_CHK( derive_mpi( grp, &e, items[i].hash, items[i].hlen ) );
+        MBEDTLS_MPI_CHK( mbedtls_mpi_mul_mpi( &t, &e, &w[i] ) );
+        MBEDTLS_MPI_CHK( mbedtls_mpi_mod_mpi( &t, &t, &grp->N ) );
+        MBEDTLS_MPI_CHK( mbedtls_mpi_mul_mpi( &t, &t, &a ) );
+        MBEDTLS_MPI_CHK( mbedtls_mpi_add_mpi( &m[0], &m[0], &t ) );
+        MBEDTLS_MPI_CHK( mbedtls_mpi_mod_mpi( &m[0], &m[0], &grp->N ) );
+
+        for( j = 1; j <= keys; j++ )
+            if( mbedtls_ecp_point_cmp( &P[j], items[i].Q ) == 0 )
+                break;
+
+        if( j > keys )
+        {
+            MBEDTLS_MPI_CHK( mbedtls_ecp_copy( &P[j], items[i].Q ) );
+            MBEDTLS_MPI_CHK( mbedtls_mpi_lset( &m[j], 0 ) );
+            keys++;
+        }
+
+        MBEDTLS_MPI_CHK( mbedtls_mpi_mul_mpi( &t, items[i].r, &w[i] ) );
+        MBEDTLS_MPI_CHK( mbedtls_mpi_mod_mpi( &t, &t, &grp->N ) );
+        MBEDTLS_MPI_CHK( mbedtls_mpi_mul_mpi( &t, &t, &a ) );
+        MBEDTLS_MPI_CHK( mbedtls_mpi_add_mpi( &m[j], &m[j], &t ) );
+        MBEDTLS_MPI_CHK( mbedtls_mpi_mod_mpi( &m[j], &m[j], &grp->N ) );
+
+        ret = mbedtls_ecp_point_from_x( grp, &R, items[i].r );
+        if( ret == MBEDTLS_ERR_ECP_INVALID_KEY ||
+            ret == MBEDTLS_ERR_ECP_FEATURE_UNAVAILABLE )
+        {
+            ret = MBEDTLS_ERR_ECP_VERIFY_FAILED;
+            goto cleanup;
+        }
+        MBEDTLS_MPI_CHK( ret );
+
+        if( i == 0 )
+            MBEDTLS_MPI_CHK( mbedtls_ecp_copy( &T[0], &R ) );
+        else
+            MBEDTLS_MPI_CHK( mbedtls_ecp_muladd_many( grp, &T[i], &a, &R, 1 ) );
+    }
+
+    MBEDTLS_MPI_CHK( mbedtls_ecp_muladd_many( grp, &R, m, P, keys + 1 ) );
+
+    if( mbedtls_ecp_is_zero( &R ) )
+    {
+        ret = MBEDTLS_ERR_ECP_VERIFY_FAILED;
+        goto cleanup;
+    }
+
+    MBEDTLS_MPI_CHK( mbedtls_ecp_check_signed_sum( grp, &R, T, k ) );
+
+cleanup:
+    if( w != NULL && T != NULL )
+    {
+        for( i = 0; i < k; i++ )
+        {
+            mbedtls_mpi_free( &w[i] );
+            mbedtls_ecp_point_free( &T[i] );
+        }
+    }
+    if( m != NULL && P != NULL )
+    {
+        for( i = 0; i <= k; i++ )
+        {
+            mbedtls_mpi_free( &m[i] );
+            mbedtls_ecp_point_free( &P[i] );
+        }
+    }
+    mbedtls_free( w ); mbedtls_free( m ); mbedtls_free( P ); mbedtls_free( T );
+    mbedtls_mpi_free( &a ); mbedtls_mpi_free( &e ); mbedtls_mpi_free( &t );
+    mbedtls_ecp_point_free( &R );
+
+    return( ret );
+}
+
+/*
+ * Verify ECDSA signatures by batches
+ */
+int mbedtls_ecdsa_verify_batch( mbedtls_ecp_group *grp,
+                                const mbedtls_ecdsa_batch_item *items, size_t count,
+                                int *results,
+                                int (*f_rng)(void *, unsigned char *, size_t),
+                                void *p_rng )
+{
+    int ret, ret_j, failed = 0;
+    size_t i, j, n;
+
+    /* Fail cleanly on curves such as Curve25519 that can't be used for ECDSA */
+    if( grp->N.p == NULL || f_rng == NULL )
+        return( MBEDTLS_ERR_ECP_BAD_INPUT_DATA );
+
+    for( i = 0; i < count; i += n )
+    {
+        n = count - i;
+        if( n > MBEDTLS_ECDSA_BATCH_SIZE )
+            n = MBEDTLS_ECDSA_BATCH_SIZE;
+
+        /* Single signatures, and those on curves with P = 1 mod 4 where
+         * points can't be recovered from r, go one by one */
+        if( n > 1 && mbedtls_mpi_get_bit( &grp->P, 0 ) == 1 &&
+                     mbedtls_mpi_get_bit( &grp->P, 1 ) == 1 )
+            ret = ecdsa_verify_batch_core( grp, items + i, n, f_rng, p_rng );
+        else
+            ret = MBEDTLS_ERR_ECP_VERIFY_FAILED;
+
+        if( ret != 0 && ret != MBEDTLS_ERR_ECP_VERIFY_FAILED )
+            return( ret );
+
+        /*
+         * Find the invalid signatures of a failed batch
+         */
+        for( j = i; j < i + n; j++ )
+        {
+            if( ret != 0 )
+            {
+                ret_j = mbedtls_ecdsa_verify( grp, items[j].hash, items[j].hlen,
+                                              items[j].Q, items[j].r, items[j].s );
+                if( ret_j != 0 && results == NULL )
+                    return( ret_j );
+            }
+            else
+                ret_j = 0;
+
+            if( ret_j != 0 )
+                failed = ret_j;
+
+            if( results != NULL )
+                results[j] = ret_j;
+        }
+    }
+
+    return( failed );
+}
+
 /*
  * Convert a signature (given by context) to ASN.1
  */
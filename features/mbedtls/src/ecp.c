@@ -339,13 +339,23 @@ void mbedtls_ecp_group_free( mbedtls_ecp_group *grp )
         mbedtls_mpi_free( &grp->N );
     }
 
-    if( grp->T != NULL )
+    /* Static tables (T_size == 0) are constant data */
+    if( grp->T != NULL && grp->T_size != 0 )
     {
         for( i = 0; i < grp->T_size; i++ )
             mbedtls_ecp_point_free( &grp->T[i] );
         mbedtls_free( grp->T );
     }
 
+    mbedtls_ecp_point_free( &grp->F );
+
+    if( grp->TF != NULL )
+    {
+        for( i = 0; i < grp->TF_size; i++ )
+            mbedtls_ecp_point_free( &grp->TF[i] );
+        mbedtls_free( grp->TF );
+    }
+
     mbedtls_zeroize( grp, sizeof( mbedtls_ecp_group ) );
 }
 
@@ -1344,6 +1354,46 @@ cleanup:
     return( ret );
 }
 
+/*
+ * Pick the window size of the comb method
+ *
+ * fixed: P is a fixed point, whose precomputed points are kept
+ * is_static: the points are a static table of the group
+ */
+static unsigned char ecp_pick_window( const mbedtls_ecp_group *grp,
+                                      unsigned char fixed,
+                                      unsigned char is_static )
+{
+    unsigned char w;
+
+    /*
+     * Minimize the number of multiplications, that is minimize
+     * 10 * d * w + 18 * 2^(w-1) + 11 * d + 7 * w, with d = ceil( nbits / w )
+     * (see costs of the various parts, with 1S = 1M)
+     */
+    w = grp->nbits >= 384 ? 5 : 4;
+
+    /*
+     * If P is fixed, pre-compute a bit more, since this may be re-used later.
+     * Just adding one avoids upping the cost of the first mul too much,
+     * and the memory cost too.
+     */
+    if( fixed )
+        w++;
+
+    /*
+     * Make sure w is within bounds. Static tables are built with the
+     * default window size, and are used as they are.
+     * (The last test is useful only for very small curves in the test suite.)
+     */
+    if( ! is_static && w > MBEDTLS_ECP_WINDOW_SIZE )
+        w = MBEDTLS_ECP_WINDOW_SIZE;
+    if( w >= grp->nbits )
+        w = 2;
+
+    return( w );
+}
+
 /*
  * Multiplication using the comb method,
  * for curves in short Weierstrass form
@@ -1354,7 +1404,7 @@ static int ecp_mul_comb( mbedtls_ecp_group *grp, mbedtls_ecp_point *R,
                          void *p_rng )
 {
     int ret;
-    unsigned char w, m_is_odd, p_eq_g, pre_len, i;
+    unsigned char w, m_is_odd, p_eq_g, p_eq_f, pre_len, i;
     size_t d;
     unsigned char k[COMB_MAX_D + 1];
     mbedtls_ecp_point *T;
@@ -1368,34 +1418,21 @@ static int ecp_mul_comb( mbedtls_ecp_group *grp, mbedtls_ecp_point *R,
         return( MBEDTLS_ERR_ECP_BAD_INPUT_DATA );
 
     /*
-     * Minimize the number of multiplications, that is minimize
-     * 10 * d * w + 18 * 2^(w-1) + 11 * d + 7 * w, with d = ceil( nbits / w )
-     * (see costs of the various parts, with 1S = 1M)
-     */
-    w = grp->nbits >= 384 ? 5 : 4;
-
-    /*
-     * If P == G, pre-compute a bit more, since this may be re-used later.
-     * Just adding one avoids upping the cost of the first mul too much,
-     * and the memory cost too.
+     * Is P the generator, or the other fixed point of the group
+     * (see mbedtls_ecp_keypair_precompute())?
      */
 #if MBEDTLS_ECP_FIXED_POINT_OPTIM == 1
     p_eq_g = ( mbedtls_mpi_cmp_mpi( &P->Y, &grp->G.Y ) == 0 &&
                mbedtls_mpi_cmp_mpi( &P->X, &grp->G.X ) == 0 );
-    if( p_eq_g )
-        w++;
 #else
     p_eq_g = 0;
 #endif
+    p_eq_f = ( ! p_eq_g && grp->TF != NULL &&
+               mbedtls_mpi_cmp_mpi( &P->Y, &grp->F.Y ) == 0 &&
+               mbedtls_mpi_cmp_mpi( &P->X, &grp->F.X ) == 0 );
 
-    /*
-     * Make sure w is within bounds.
-     * (The last test is useful only for very small curves in the test suite.)
-     */
-    if( w > MBEDTLS_ECP_WINDOW_SIZE )
-        w = MBEDTLS_ECP_WINDOW_SIZE;
-    if( w >= grp->nbits )
-        w = 2;
+    w = ecp_pick_window( grp, p_eq_g || p_eq_f,
+                         p_eq_g && grp->T != NULL && grp->T_size == 0 );
 
     /* Other sizes that depend on w */
     pre_len = 1U << ( w - 1 );
@@ -1404,8 +1441,9 @@ static int ecp_mul_comb( mbedtls_ecp_group *grp, mbedtls_ecp_point *R,
     /*
      * Prepare precomputed points: if P == G we want to
      * use grp->T if already initialized, or initialize it.
+     * If P == F, grp->TF was initialized with F.
      */
-    T = p_eq_g ? grp->T : NULL;
+    T = p_eq_g ? grp->T : p_eq_f ? grp->TF : NULL;
 
     if( T == NULL )
     {
@@ -1448,7 +1486,7 @@ static int ecp_mul_comb( mbedtls_ecp_group *grp, mbedtls_ecp_point *R,
 
 cleanup:
 
-    if( T != NULL && ! p_eq_g )
+    if( T != NULL && ! p_eq_g && ! p_eq_f )
     {
         for( i = 0; i < pre_len; i++ )
             mbedtls_ecp_point_free( &T[i] );
@@ -1464,6 +1502,51 @@ cleanup:
     return( ret );
 }
 
+/*
+ * Precompute the points of the comb method for F, the other fixed point
+ */
+static int ecp_precompute_fixed( mbedtls_ecp_group *grp, const mbedtls_ecp_point *P )
+{
+    int ret;
+    unsigned char w, pre_len, i;
+    size_t d;
+    mbedtls_ecp_point *T;
+
+    w = ecp_pick_window( grp, 1, 0 );
+    pre_len = 1U << ( w - 1 );
+    d = ( grp->nbits + w - 1 ) / w;
+
+    T = mbedtls_calloc( pre_len, sizeof( mbedtls_ecp_point ) );
+    if( T == NULL )
+        return( MBEDTLS_ERR_ECP_ALLOC_FAILED );
+
+    MBEDTLS_MPI_CHK( ecp_precompute_comb( grp, T, P, w, d ) );
+    MBEDTLS_MPI_CHK( mbedtls_ecp_copy( &grp->F, P ) );
+
+    /* Replace the points of the previous fixed point, if any */
+    if( grp->TF != NULL )
+    {
+        for( i = 0; i < grp->TF_size; i++ )
+            mbedtls_ecp_point_free( &grp->TF[i] );
+        mbedtls_free( grp->TF );
+    }
+
+    grp->TF = T;
+    grp->TF_size = pre_len;
+    T = NULL;
+
+cleanup:
+
+    if( T != NULL )
+    {
+        for( i = 0; i < pre_len; i++ )
+            mbedtls_ecp_point_free( &T[i] );
+        mbedtls_free( T );
+    }
+
+    return( ret );
+}
+
 #endif /* ECP_SHORTWEIERSTRASS */
 
 #if defined(ECP_MONTGOMERY)
@@ -1729,6 +1812,40 @@ cleanup:
 }
 
 #if defined(ECP_SHORTWEIERSTRASS)
+/*
+ * rhs = X (X^2 + A) + B = X^3 + A X + B, for 0 <= X < P
+ */
+static int ecp_sw_rhs( const mbedtls_ecp_group *grp, mbedtls_mpi *rhs,
+                       const mbedtls_mpi *X )
+{
+    int ret;
+    mbedtls_mpi RHS;
+
+    mbedtls_mpi_init( &RHS );
+
+    MBEDTLS_MPI_CHK( mbedtls_mpi_mul_mpi( &RHS, X,        X       ) );  MOD_MUL( RHS );
+
+    /* Special case for A = -3 */
+    if( grp->A.p == NULL )
+    {
+        MBEDTLS_MPI_CHK( mbedtls_mpi_sub_int( &RHS, &RHS, 3       ) );  MOD_SUB( RHS );
+    }
+    else
+    {
+        MBEDTLS_MPI_CHK( mbedtls_mpi_add_mpi( &RHS, &RHS, &grp->A ) );  MOD_ADD( RHS );
+    }
+
+    MBEDTLS_MPI_CHK( mbedtls_mpi_mul_mpi( &RHS, &RHS,     X       ) );  MOD_MUL( RHS );
+    MBEDTLS_MPI_CHK( mbedtls_mpi_add_mpi( &RHS, &RHS,     &grp->B ) );  MOD_ADD( RHS );
+
+    mbedtls_mpi_swap( rhs, &RHS );
+
+cleanup:
+    mbedtls_mpi_free( &RHS );
+
+    return( ret );
+}
+
 /*
  * Check that an affine point is valid as a public key,
  * short weierstrass curves (SEC1 3.2.3.1)
@@ -1749,23 +1866,10 @@ static int ecp_check_pubkey_sw( const mbedtls_ecp_group *grp, const mbedtls_ecp_
 
     /*
      * YY = Y^2
-     * RHS = X (X^2 + A) + B = X^3 + A X + B
+     * RHS = X^3 + A X + B
      */
     MBEDTLS_MPI_CHK( mbedtls_mpi_mul_mpi( &YY,  &pt->Y,   &pt->Y  ) );  MOD_MUL( YY  );
-    MBEDTLS_MPI_CHK( mbedtls_mpi_mul_mpi( &RHS, &pt->X,   &pt->X  ) );  MOD_MUL( RHS );
-
-    /* Special case for A = -3 */
-    if( grp->A.p == NULL )
-    {
-        MBEDTLS_MPI_CHK( mbedtls_mpi_sub_int( &RHS, &RHS, 3       ) );  MOD_SUB( RHS );
-    }
-    else
-    {
-        MBEDTLS_MPI_CHK( mbedtls_mpi_add_mpi( &RHS, &RHS, &grp->A ) );  MOD_ADD( RHS );
-    }
-
-    MBEDTLS_MPI_CHK( mbedtls_mpi_mul_mpi( &RHS, &RHS,     &pt->X  ) );  MOD_MUL( RHS );
-    MBEDTLS_MPI_CHK( mbedtls_mpi_add_mpi( &RHS, &RHS,     &grp->B ) );  MOD_ADD( RHS );
+    MBEDTLS_MPI_CHK( ecp_sw_rhs( grp, &RHS, &pt->X ) );
 
     if( mbedtls_mpi_cmp_mpi( &YY, &RHS ) != 0 )
         ret = MBEDTLS_ERR_ECP_INVALID_KEY;
@@ -1865,6 +1969,371 @@ cleanup:
 }
 
 
+/*
+ * Window of the NAF of the scalars in mbedtls_ecp_muladd_many(): the odd
+ * multiples P, 3P, ..., (2^(w-1) - 1)P of each point are precomputed
+ */
+#define ECP_NAF_WINDOW  5
+#define ECP_NAF_POINTS  ( 1 << ( ECP_NAF_WINDOW - 2 ) )
+
+/*
+ * Width-w NAF of m >= 0, least significant digit first: digits are zero or
+ * odd, less than 2^(w-1) in absolute value, and each non-zero digit is
+ * followed by at least w - 1 zeros. Returns the number of digits, at most
+ * bitlen(m) + 1, which is the size of naf[].
+ */
+static size_t ecp_naf( signed char naf[], const mbedtls_mpi *m, unsigned char w )
+{
+    size_t i, j, len = mbedtls_mpi_bitlen( m ) + 1;
+    int carry = 0, digit;
+
+    memset( naf, 0, len );
+
+    for( i = 0; i < len; )
+    {
+        if( mbedtls_mpi_get_bit( m, i ) == carry )
+        {
+            i++;
+            continue;
+        }
+
+        digit = carry;
+        for( j = 0; j < w; j++ )
+            digit += mbedtls_mpi_get_bit( m, i + j ) << j;
+
+        carry = ( digit >> ( w - 1 ) ) & 1;
+        naf[i] = (signed char)( digit - ( carry << w ) );
+        i += w;
+    }
+
+    return( len );
+}
+
+/*
+ * R = R + Q or R = R - Q, Q normalized, R possibly zero
+ * NOT constant-time
+ */
+static int ecp_add_signed( const mbedtls_ecp_group *grp, mbedtls_ecp_point *R,
+                           const mbedtls_ecp_point *Q, int neg )
+{
+    int ret;
+    mbedtls_ecp_point mQ;
+
+    mbedtls_ecp_point_init( &mQ );
+
+    if( neg )
+    {
+        MBEDTLS_MPI_CHK( mbedtls_mpi_copy( &mQ.X, &Q->X ) );
+        MBEDTLS_MPI_CHK( mbedtls_mpi_sub_mpi( &mQ.Y, &grp->P, &Q->Y ) );
+        Q = &mQ;
+    }
+
+    /* ecp_add_mixed() would copy Q without its Z, which may be unset */
+    if( mbedtls_mpi_cmp_int( &R->Z, 0 ) == 0 )
+    {
+        MBEDTLS_MPI_CHK( mbedtls_mpi_copy( &R->X, &Q->X ) );
+        MBEDTLS_MPI_CHK( mbedtls_mpi_copy( &R->Y, &Q->Y ) );
+        MBEDTLS_MPI_CHK( mbedtls_mpi_lset( &R->Z, 1 ) );
+    }
+    else
+    {
+        MBEDTLS_MPI_CHK( ecp_add_mixed( grp, R, R, Q ) );
+    }
+
+cleanup:
+    mbedtls_ecp_point_free( &mQ );
+
+    return( ret );
+}
+
+/*
+ * Linear combination of several points, sharing the doublings
+ * (interleaved w-NAF, GECC 3.51)
+ * NOT constant-time
+ */
+static int ecp_muladd_many( const mbedtls_ecp_group *grp, mbedtls_ecp_point *R,
+                            const mbedtls_mpi *m, const mbedtls_ecp_point *P,
+                            size_t count )
+{
+    int ret;
+    size_t i, j, k, len = 0, digits = grp->nbits + 1;
+    int d;
+    signed char *naf = NULL;
+    mbedtls_ecp_point *T = NULL, **TT = NULL;
+
+    if( ( naf = mbedtls_calloc( count, digits ) ) == NULL ||
+        ( T = mbedtls_calloc( count * ECP_NAF_POINTS, sizeof( mbedtls_ecp_point ) ) ) == NULL ||
+        ( TT = mbedtls_calloc( count * ECP_NAF_POINTS, sizeof( mbedtls_ecp_point * ) ) ) == NULL )
+    {
+        ret = MBEDTLS_ERR_ECP_ALLOC_FAILED;
+        goto cleanup;
+    }
+
+    for( i = 0; i < count * ECP_NAF_POINTS; i++ )
+        mbedtls_ecp_point_init( &T[i] );
+
+    /*
+     * T[i][j] = (2j + 1) P[i], starting from 2 P[i] in the last slot
+     */
+    for( i = 0; i < count; i++ )
+    {
+        MBEDTLS_MPI_CHK( ecp_double_jac( grp, &T[( i + 1 ) * ECP_NAF_POINTS - 1], &P[i] ) );
+        TT[i] = &T[( i + 1 ) * ECP_NAF_POINTS - 1];
+    }
+    MBEDTLS_MPI_CHK( ecp_normalize_jac_many( grp, TT, count ) );
+
+    for( i = 0, k = 0; i < count; i++ )
+    {
+        mbedtls_ecp_point *Ti = &T[i * ECP_NAF_POINTS];
+
+        MBEDTLS_MPI_CHK( mbedtls_ecp_copy( &Ti[0], &P[i] ) );
+        for( j = 1; j < ECP_NAF_POINTS; j++ )
+        {
+            MBEDTLS_MPI_CHK( ecp_add_mixed( grp, &Ti[j], &Ti[j - 1],
+                                            &Ti[ECP_NAF_POINTS - 1] ) );
+            TT[k++] = &Ti[j];
+        }
+
+        j = ecp_naf( naf + i * digits, &m[i], ECP_NAF_WINDOW );
+        if( j > len )
+            len = j;
+    }
+    MBEDTLS_MPI_CHK( ecp_normalize_jac_many( grp, TT, k ) );
+
+    MBEDTLS_MPI_CHK( mbedtls_ecp_set_zero( R ) );
+
+    while( len-- > 0 )
+    {
+        if( mbedtls_mpi_cmp_int( &R->Z, 0 ) != 0 )
+            MBEDTLS_MPI_CHK( ecp_double_jac( grp, R, R ) );
+
+        for( i = 0; i < count; i++ )
+        {
+            if( ( d = naf[i * digits + len] ) == 0 )
+                continue;
+
+            MBEDTLS_MPI_CHK( ecp_add_signed( grp, R,
+                        &T[i * ECP_NAF_POINTS + ( d < 0 ? -d : d ) / 2], d < 0 ) );
+        }
+    }
+
+    MBEDTLS_MPI_CHK( ecp_normalize_jac( grp, R ) );
+
+cleanup:
+    if( T != NULL )
+    {
+        for( i = 0; i < count * ECP_NAF_POINTS; i++ )
+            mbedtls_ecp_point_free( &T[i] );
+    }
+    mbedtls_free( T );
+    mbedtls_free( TT );
+    mbedtls_free( naf );
+
+    return( ret );
+}
+
+/*
+ * Linear combination of several points
+ * NOT constant-time
+ */
+int mbedtls_ecp_muladd_many( mbedtls_ecp_group *grp, mbedtls_ecp_point *R,
+                             const mbedtls_mpi *m, const mbedtls_ecp_point *P,
+                             size_t count )
+{
+    int ret;
+    size_t i;
+#if defined(MBEDTLS_ECP_INTERNAL_ALT)
+    char is_grp_capable = 0;
+#endif
+
+    if( ecp_get_type( grp ) != ECP_TYPE_SHORT_WEIERSTRASS )
+        return( MBEDTLS_ERR_ECP_FEATURE_UNAVAILABLE );
+
+    if( count == 0 )
+        return( mbedtls_ecp_set_zero( R ) );
+
+    for( i = 0; i < count; i++ )
+    {
+        if( mbedtls_mpi_cmp_int( &m[i], 0 ) < 0 ||
+            mbedtls_mpi_bitlen( &m[i] ) > grp->nbits )
+            return( MBEDTLS_ERR_ECP_INVALID_KEY );
+
+        if( mbedtls_mpi_cmp_int( &P[i].Z, 1 ) != 0 )
+            return( MBEDTLS_ERR_ECP_BAD_INPUT_DATA );
+
+        if( ( ret = mbedtls_ecp_check_pubkey( grp, &P[i] ) ) != 0 )
+            return( ret );
+    }
+
+#if defined(MBEDTLS_ECP_INTERNAL_ALT)
+#if defined(MBEDTLS_THREADING_C)
+    if( mbedtls_mutex_lock( &mbedtls_threading_ecp_mutex ) != 0 )
+        return ( MBEDTLS_ERR_THREADING_MUTEX_ERROR );
+
+#endif
+    if (  is_grp_capable = mbedtls_internal_ecp_grp_capable( grp )  )
+    {
+        MBEDTLS_MPI_CHK( mbedtls_internal_ecp_init( grp ) );
+    }
+
+#endif /* MBEDTLS_ECP_INTERNAL_ALT */
+    MBEDTLS_MPI_CHK( ecp_muladd_many( grp, R, m, P, count ) );
+
+cleanup:
+
+#if defined(MBEDTLS_ECP_INTERNAL_ALT)
+    if ( is_grp_capable )
+    {
+        mbedtls_internal_ecp_free( grp );
+    }
+
+#if defined(MBEDTLS_THREADING_C)
+    if( mbedtls_mutex_unlock( &mbedtls_threading_ecp_mutex ) != 0 )
+        return ( MBEDTLS_ERR_THREADING_MUTEX_ERROR );
+
+#endif
+#endif /* MBEDTLS_ECP_INTERNAL_ALT */
+    return( ret );
+}
+
+/*
+ * Point with a given x-coordinate, for P = 3 mod 4:
+ * Y = RHS^((P + 1) / 4), if that is a square root of RHS = X^3 + A X + B
+ */
+int mbedtls_ecp_point_from_x( const mbedtls_ecp_group *grp, mbedtls_ecp_point *pt,
+                              const mbedtls_mpi *x )
+{
+    int ret;
+    mbedtls_mpi RHS, E, YY;
+
+    if( ecp_get_type( grp ) != ECP_TYPE_SHORT_WEIERSTRASS ||
+        mbedtls_mpi_get_bit( &grp->P, 0 ) != 1 ||
+        mbedtls_mpi_get_bit( &grp->P, 1 ) != 1 )
+        return( MBEDTLS_ERR_ECP_FEATURE_UNAVAILABLE );
+
+    if( mbedtls_mpi_cmp_int( x, 0 ) < 0 || mbedtls_mpi_cmp_mpi( x, &grp->P ) >= 0 )
+        return( MBEDTLS_ERR_ECP_INVALID_KEY );
+
+    mbedtls_mpi_init( &RHS ); mbedtls_mpi_init( &E ); mbedtls_mpi_init( &YY );
+
+    MBEDTLS_MPI_CHK( ecp_sw_rhs( grp, &RHS, x ) );
+
+    MBEDTLS_MPI_CHK( mbedtls_mpi_add_int( &E, &grp->P, 1 ) );
+    MBEDTLS_MPI_CHK( mbedtls_mpi_shift_r( &E, 2 ) );
+    MBEDTLS_MPI_CHK( mbedtls_mpi_exp_mod( &pt->Y, &RHS, &E, &grp->P, NULL ) );
+
+    MBEDTLS_MPI_CHK( mbedtls_mpi_mul_mpi( &YY, &pt->Y, &pt->Y ) ); MOD_MUL( YY );
+    if( mbedtls_mpi_cmp_mpi( &YY, &RHS ) != 0 )
+    {
+        ret = MBEDTLS_ERR_ECP_INVALID_KEY;
+        goto cleanup;
+    }
+
+    MBEDTLS_MPI_CHK( mbedtls_mpi_copy( &pt->X, x ) );
+    MBEDTLS_MPI_CHK( mbedtls_mpi_lset( &pt->Z, 1 ) );
+
+cleanup:
+    mbedtls_mpi_free( &RHS ); mbedtls_mpi_free( &E ); mbedtls_mpi_free( &YY );
+
+    return( ret );
+}
+
+/*
+ * Check that A = +-T[0] +- T[1] ... +- T[count-1] for some signs.
+ *
+ * S = A - s[1] T[1] - ... - s[count-1] T[count-1] goes through all the signs
+ * in Gray code order, each step adding +-2 T[j], and is compared with T[0] by
+ * x-coordinate only, which covers both signs of T[0]: X_S == x_0 Z_S^2.
+ * NOT constant-time
+ */
+int mbedtls_ecp_check_signed_sum( mbedtls_ecp_group *grp,
+                                  const mbedtls_ecp_point *A,
+                                  const mbedtls_ecp_point *T, size_t count )
+{
+    int ret;
+    size_t i, j;
+    unsigned long step, neg = 0;
+    mbedtls_ecp_point S, *U = NULL, **UU = NULL;
+    mbedtls_mpi ZZ;
+
+    if( ecp_get_type( grp ) != ECP_TYPE_SHORT_WEIERSTRASS )
+        return( MBEDTLS_ERR_ECP_FEATURE_UNAVAILABLE );
+
+    if( count == 0 || count > 8 * sizeof( step ) )
+        return( MBEDTLS_ERR_ECP_BAD_INPUT_DATA );
+
+    if( mbedtls_mpi_cmp_int( &A->Z, 1 ) != 0 )
+        return( MBEDTLS_ERR_ECP_BAD_INPUT_DATA );
+
+    for( i = 0; i < count; i++ )
+        if( mbedtls_mpi_cmp_int( &T[i].Z, 1 ) != 0 )
+            return( MBEDTLS_ERR_ECP_BAD_INPUT_DATA );
+
+    mbedtls_ecp_point_init( &S );
+    mbedtls_mpi_init( &ZZ );
+
+    if( ( U = mbedtls_calloc( count, sizeof( mbedtls_ecp_point ) ) ) == NULL ||
+        ( UU = mbedtls_calloc( count, sizeof( mbedtls_ecp_point * ) ) ) == NULL )
+    {
+        ret = MBEDTLS_ERR_ECP_ALLOC_FAILED;
+        goto cleanup;
+    }
+
+    for( i = 0; i < count; i++ )
+        mbedtls_ecp_point_init( &U[i] );
+
+    /*
+     * U[i] = 2 T[i], S = A - T[1] - ... - T[count-1]
+     */
+    MBEDTLS_MPI_CHK( mbedtls_ecp_copy( &S, A ) );
+    for( i = 1; i < count; i++ )
+    {
+        MBEDTLS_MPI_CHK( ecp_double_jac( grp, &U[i], &T[i] ) );
+        UU[i - 1] = &U[i];
+        MBEDTLS_MPI_CHK( ecp_add_signed( grp, &S, &T[i], 1 ) );
+    }
+    if( count > 1 )
+        MBEDTLS_MPI_CHK( ecp_normalize_jac_many( grp, UU, count - 1 ) );
+
+    for( step = 0; ; )
+    {
+        if( mbedtls_mpi_cmp_int( &S.Z, 0 ) != 0 )
+        {
+            MBEDTLS_MPI_CHK( mbedtls_mpi_mul_mpi( &ZZ, &S.Z, &S.Z ) ); MOD_MUL( ZZ );
+            MBEDTLS_MPI_CHK( mbedtls_mpi_mul_mpi( &ZZ, &ZZ, &T[0].X ) ); MOD_MUL( ZZ );
+
+            if( mbedtls_mpi_cmp_mpi( &ZZ, &S.X ) == 0 )
+            {
+                ret = 0;
+                goto cleanup;
+            }
+        }
+
+        if( ++step >> ( count - 1 ) != 0 )
+            break;
+
+        /* Flip the sign of T[j], j - 1 being the lowest set bit of step */
+        for( j = 1; ( step >> ( j - 1 ) & 1 ) == 0; j++ );
+        neg ^= 1UL << j;
+        MBEDTLS_MPI_CHK( ecp_add_signed( grp, &S, &U[j], ( neg >> j & 1 ) == 0 ) );
+    }
+
+    ret = MBEDTLS_ERR_ECP_VERIFY_FAILED;
+
+cleanup:
+    if( U != NULL )
+    {
+        for( i = 0; i < count; i++ )
+            mbedtls_ecp_point_free( &U[i] );
+    }
+    mbedtls_free( U );
+    mbedtls_free( UU );
+    mbedtls_ecp_point_free( &S );
+    mbedtls_mpi_free( &ZZ );
+
+    return( ret );
+}
+
 #if defined(ECP_MONTGOMERY)
 /*
  * Check validity of a public key for Montgomery curves with x-only schemes
@@ -2081,6 +2550,58 @@ cleanup:
     return( ret );
 }
 
+/*
+ * Precompute the points used to multiply the public point of a key pair
+ */
+int mbedtls_ecp_keypair_precompute( mbedtls_ecp_keypair *key )
+{
+    int ret = MBEDTLS_ERR_ECP_FEATURE_UNAVAILABLE;
+#if defined(MBEDTLS_ECP_INTERNAL_ALT)
+    char is_grp_capable = 0;
+#endif
+
+    if( ecp_get_type( &key->grp ) != ECP_TYPE_SHORT_WEIERSTRASS )
+        return( MBEDTLS_ERR_ECP_FEATURE_UNAVAILABLE );
+
+    if( mbedtls_mpi_cmp_int( &key->Q.Z, 1 ) != 0 )
+        return( MBEDTLS_ERR_ECP_BAD_INPUT_DATA );
+
+    if( ( ret = mbedtls_ecp_check_pubkey( &key->grp, &key->Q ) ) != 0 )
+        return( ret );
+
+#if defined(MBEDTLS_ECP_INTERNAL_ALT)
+#if defined(MBEDTLS_THREADING_C)
+    if( mbedtls_mutex_lock( &mbedtls_threading_ecp_mutex ) != 0 )
+        return ( MBEDTLS_ERR_THREADING_MUTEX_ERROR );
+
+#endif
+    if ( is_grp_capable = mbedtls_internal_ecp_grp_capable( &key->grp ) )
+    {
+        MBEDTLS_MPI_CHK( mbedtls_internal_ecp_init( &key->grp ) );
+    }
+
+#endif /* MBEDTLS_ECP_INTERNAL_ALT */
+#if defined(ECP_SHORTWEIERSTRASS)
+    ret = ecp_precompute_fixed( &key->grp, &key->Q );
+
+#endif
+#if defined(MBEDTLS_ECP_INTERNAL_ALT)
+cleanup:
+
+    if ( is_grp_capable )
+    {
+        mbedtls_internal_ecp_free( &key->grp );
+    }
+
+#if defined(MBEDTLS_THREADING_C)
+    if( mbedtls_mutex_unlock( &mbedtls_threading_ecp_mutex ) != 0 )
+        return ( MBEDTLS_ERR_THREADING_MUTEX_ERROR );
+
+#endif
+#endif /* MBEDTLS_ECP_INTERNAL_ALT */
+    return( ret );
+}
+
 #if defined(MBEDTLS_SELF_TEST)
 
 /*
@@ -82,6 +82,25 @@
  * to be directly usable in MPIs
  */
 
+/*
+ * Points the comb method precomputes for the generator, built in as
+ * constant data with MBEDTLS_ECP_FIXED_POINT_TABLES. They are affine, the
+ * comb method only reads X and Y, and Z is left empty.
+ *
+ * The tables are in ecp_comb_tables.h, included after the domain parameters
+ * and generated by "make ecp-tables" in the mbed TLS importer, for the
+ * default MBEDTLS_ECP_WINDOW_SIZE.
+ */
+#if defined(MBEDTLS_ECP_FIXED_POINT_TABLES) && MBEDTLS_ECP_FIXED_POINT_OPTIM == 1
+#define ECP_COMB_TABLES
+
+#define ECP_MPI_INIT_ARRAY( x ) \
+    { 1, sizeof( x ) / sizeof( mbedtls_mpi_uint ), (mbedtls_mpi_uint *) x }
+
+#define ECP_POINT_INIT_XY( x, y ) \
+    { ECP_MPI_INIT_ARRAY( x ), ECP_MPI_INIT_ARRAY( y ), { 1, 0, NULL } }
+#endif /* MBEDTLS_ECP_FIXED_POINT_TABLES */
+
 /*
  * Domain parameters for secp192r1
  */
@@ -549,6 +568,10 @@ static const mbedtls_mpi_uint brainpoolP512r1_n[] = {
 };
 #endif /* MBEDTLS_ECP_DP_BP512R1_ENABLED */
 
+#if defined(ECP_COMB_TABLES)
+#include "ecp_comb_tables.h"
+#endif
+
 /*
  * Create an MPI from embedded constants
  * (assumes len is an exact multiple of sizeof mbedtls_mpi_uint)
@@ -623,6 +646,12 @@ static int ecp_mod_p521( mbedtls_mpi * );
 #define NIST_MODP( P )
 #endif /* MBEDTLS_ECP_NIST_OPTIM */
 
+#if defined(ECP_COMB_TABLES)
+#define COMB_TABLE( G )     grp->T = (mbedtls_ecp_point *) G ## _T;
+#else
+#define COMB_TABLE( G )
+#endif /* ECP_COMB_TABLES */
+
 /* Additional forward declarations */
 #if defined(MBEDTLS_ECP_DP_CURVE25519_ENABLED)
 static int ecp_mod_p255( mbedtls_mpi * );
@@ -713,12 +742,14 @@ int mbedtls_ecp_group_load( mbedtls_ecp_group *grp, mbedtls_ecp_group_id id )
 #if defined(MBEDTLS_ECP_DP_SECP256R1_ENABLED)
         case MBEDTLS_ECP_DP_SECP256R1:
             NIST_MODP( p256 );
+            COMB_TABLE( secp256r1 );
             return( LOAD_GROUP( secp256r1 ) );
 #endif /* MBEDTLS_ECP_DP_SECP256R1_ENABLED */
 
 #if defined(MBEDTLS_ECP_DP_SECP384R1_ENABLED)
         case MBEDTLS_ECP_DP_SECP384R1:
             NIST_MODP( p384 );
+            COMB_TABLE( secp384r1 );
             return( LOAD_GROUP( secp384r1 ) );
 #endif /* MBEDTLS_ECP_DP_SECP384R1_ENABLED */
 
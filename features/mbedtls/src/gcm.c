@@ -27,6 +27,9 @@
  *
  * We use the algorithm described as Shoup's method with 4-bit tables in
  * [MGV] 4.1, pp. 12-13, to enhance speed without using too much memory.
+ * MBEDTLS_GCM_GHASH_TABLE8 selects the same method with 8-bit tables, and
+ * MBEDTLS_GCM_GHASH_CT a multiplication without tables, in constant time;
+ * both work on 32-bit words.
  */
 
 #if !defined(MBEDTLS_CONFIG_FILE)
@@ -45,6 +48,10 @@
 #include "mbedtls/aesni.h"
 #endif
 
+#if defined(MBEDTLS_AES_CTR_BLOCKS) && !defined(MBEDTLS_AES_ALT)
+#include "mbedtls/aes.h"
+#endif
+
 #if defined(MBEDTLS_SELF_TEST) && defined(MBEDTLS_AES_C)
 #if defined(MBEDTLS_PLATFORM_C)
 #include "mbedtls/platform.h"
@@ -90,6 +97,45 @@ void mbedtls_gcm_init( mbedtls_gcm_context *ctx )
     memset( ctx, 0, sizeof( mbedtls_gcm_context ) );
 }
 
+#if defined(MBEDTLS_GCM_GHASH_TABLE8)
+/*
+ * Precompute the 256 multiples of H for Shoup's method with 8-bit tables,
+ *      HT[i] = H times i,
+ * where i is seen as a field element as for the 4-bit table (0x80
+ * corresponds to 1), and HT[i][0] holds the highest-order bits.
+ */
+static void gcm_gen_table8( mbedtls_gcm_context *ctx, uint64_t vh, uint64_t vl )
+{
+    int i, j, k;
+    uint32_t (*HT)[4] = ctx->HT;
+
+    HT[0][0] = HT[0][1] = HT[0][2] = HT[0][3] = 0;
+
+    HT[128][0] = (uint32_t)( vh >> 32 );
+    HT[128][1] = (uint32_t)( vh       );
+    HT[128][2] = (uint32_t)( vl >> 32 );
+    HT[128][3] = (uint32_t)( vl       );
+
+    for( i = 64; i > 0; i >>= 1 )
+    {
+        uint32_t T = ( HT[2 * i][3] & 1 ) * 0xe1000000U;
+        HT[i][3] = ( HT[2 * i][2] << 31 ) | ( HT[2 * i][3] >> 1 );
+        HT[i][2] = ( HT[2 * i][1] << 31 ) | ( HT[2 * i][2] >> 1 );
+        HT[i][1] = ( HT[2 * i][0] << 31 ) | ( HT[2 * i][1] >> 1 );
+        HT[i][0] = ( HT[2 * i][0] >> 1 ) ^ T;
+    }
+
+    for( i = 2; i <= 128; i *= 2 )
+    {
+        for( j = 1; j < i; j++ )
+        {
+            for( k = 0; k < 4; k++ )
+                HT[i + j][k] = HT[i][k] ^ HT[j][k];
+        }
+    }
+}
+#endif /* MBEDTLS_GCM_GHASH_TABLE8 */
+
 /*
  * Precompute small multiples of H, that is set
  *      HH[i] || HL[i] = H times i,
@@ -100,7 +146,10 @@ void mbedtls_gcm_init( mbedtls_gcm_context *ctx )
  */
 static int gcm_gen_table( mbedtls_gcm_context *ctx )
 {
-    int ret, i, j;
+    int ret;
+#if !defined(MBEDTLS_GCM_GHASH_TABLE8) && !defined(MBEDTLS_GCM_GHASH_CT)
+    int i, j;
+#endif
     uint64_t hi, lo;
     uint64_t vl, vh;
     unsigned char h[16];
@@ -129,6 +178,9 @@ static int gcm_gen_table( mbedtls_gcm_context *ctx )
         return( 0 );
 #endif
 
+#if defined(MBEDTLS_GCM_GHASH_TABLE8)
+    gcm_gen_table8( ctx, vh, vl );
+#elif !defined(MBEDTLS_GCM_GHASH_CT)
     /* 0 corresponds to 0 in GF(2^128) */
     ctx->HH[0] = 0;
     ctx->HL[0] = 0;
@@ -154,6 +206,7 @@ static int gcm_gen_table( mbedtls_gcm_context *ctx )
             HiL[j] = vl ^ ctx->HL[j];
         }
     }
+#endif /* !MBEDTLS_GCM_GHASH_CT */
 
     return( 0 );
 }
@@ -190,6 +243,198 @@ int mbedtls_gcm_setkey( mbedtls_gcm_context *ctx,
     return( 0 );
 }
 
+#if defined(MBEDTLS_GCM_GHASH_TABLE8)
+/*
+ * Shoup's method with 8-bit tables reduces with
+ *      last8[x] = x times P^128
+ * as last4 below
+ */
+static const uint16_t last8[256] =
+{
+    0x0000, 0x01c2, 0x0384, 0x0246, 0x0708, 0x06ca, 0x048c, 0x054e,
+    0x0e10, 0x0fd2, 0x0d94, 0x0c56, 0x0918, 0x08da, 0x0a9c, 0x0b5e,
+    0x1c20, 0x1de2, 0x1fa4, 0x1e66, 0x1b28, 0x1aea, 0x18ac, 0x196e,
+    0x1230, 0x13f2, 0x11b4, 0x1076, 0x1538, 0x14fa, 0x16bc, 0x177e,
+    0x3840, 0x3982, 0x3bc4, 0x3a06, 0x3f48, 0x3e8a, 0x3ccc, 0x3d0e,
+    0x3650, 0x3792, 0x35d4, 0x3416, 0x3158, 0x309a, 0x32dc, 0x331e,
+    0x2460, 0x25a2, 0x27e4, 0x2626, 0x2368, 0x22aa, 0x20ec, 0x212e,
+    0x2a70, 0x2bb2, 0x29f4, 0x2836, 0x2d78, 0x2cba, 0x2efc, 0x2f3e,
+    0x7080, 0x7142, 0x7304, 0x72c6, 0x7788, 0x764a, 0x740c, 0x75ce,
+    0x7e90, 0x7f52, 0x7d14, 0x7cd6, 0x7998, 0x785a, 0x7a1c, 0x7bde,
+    0x6ca0, 0x6d62, 0x6f24, 0x6ee6, 0x6ba8, 0x6a6a, 0x682c, 0x69ee,
+    0x62b0, 0x6372, 0x6134, 0x60f6, 0x65b8, 0x647a, 0x663c, 0x67fe,
+    0x48c0, 0x4902, 0x4b44, 0x4a86, 0x4fc8, 0x4e0a, 0x4c4c, 0x4d8e,
+    0x46d0, 0x4712, 0x4554, 0x4496, 0x41d8, 0x401a, 0x425c, 0x439e,
+    0x54e0, 0x5522, 0x5764, 0x56a6, 0x53e8, 0x522a, 0x506c, 0x51ae,
+    0x5af0, 0x5b32, 0x5974, 0x58b6, 0x5df8, 0x5c3a, 0x5e7c, 0x5fbe,
+    0xe100, 0xe0c2, 0xe284, 0xe346, 0xe608, 0xe7ca, 0xe58c, 0xe44e,
+    0xef10, 0xeed2, 0xec94, 0xed56, 0xe818, 0xe9da, 0xeb9c, 0xea5e,
+    0xfd20, 0xfce2, 0xfea4, 0xff66, 0xfa28, 0xfbea, 0xf9ac, 0xf86e,
+    0xf330, 0xf2f2, 0xf0b4, 0xf176, 0xf438, 0xf5fa, 0xf7bc, 0xf67e,
+    0xd940, 0xd882, 0xdac4, 0xdb06, 0xde48, 0xdf8a, 0xddcc, 0xdc0e,
+    0xd750, 0xd692, 0xd4d4, 0xd516, 0xd058, 0xd19a, 0xd3dc, 0xd21e,
+    0xc560, 0xc4a2, 0xc6e4, 0xc726, 0xc268, 0xc3aa, 0xc1ec, 0xc02e,
+    0xcb70, 0xcab2, 0xc8f4, 0xc936, 0xcc78, 0xcdba, 0xcffc, 0xce3e,
+    0x9180, 0x9042, 0x9204, 0x93c6, 0x9688, 0x974a, 0x950c, 0x94ce,
+    0x9f90, 0x9e52, 0x9c14, 0x9dd6, 0x9898, 0x995a, 0x9b1c, 0x9ade,
+    0x8da0, 0x8c62, 0x8e24, 0x8fe6, 0x8aa8, 0x8b6a, 0x892c, 0x88ee,
+    0x83b0, 0x8272, 0x8034, 0x81f6, 0x84b8, 0x857a, 0x873c, 0x86fe,
+    0xa9c0, 0xa802, 0xaa44, 0xab86, 0xaec8, 0xaf0a, 0xad4c, 0xac8e,
+    0xa7d0, 0xa612, 0xa454, 0xa596, 0xa0d8, 0xa11a, 0xa35c, 0xa29e,
+    0xb5e0, 0xb422, 0xb664, 0xb7a6, 0xb2e8, 0xb32a, 0xb16c, 0xb0ae,
+    0xbbf0, 0xba32, 0xb874, 0xb9b6, 0xbcf8, 0xbd3a, 0xbf7c, 0xbebe
+};
+
+/*
+ * Sets z to z times H with the 8-bit tables, the field element being held
+ * in four 32-bit words, z[0] with the highest-order bits
+ */
+static void gcm_mult32( const mbedtls_gcm_context *ctx, uint32_t z[4] )
+{
+    int i;
+    uint32_t x[4], z0, z1, z2, z3, rem;
+    const uint32_t *T;
+
+    x[0] = z[0]; x[1] = z[1]; x[2] = z[2]; x[3] = z[3];
+
+    T = ctx->HT[x[3] & 0xFF];
+    z0 = T[0]; z1 = T[1]; z2 = T[2]; z3 = T[3];
+
+    for( i = 14; i >= 0; i-- )
+    {
+        rem = z3 & 0xFF;
+        z3 = ( z2 << 24 ) | ( z3 >> 8 );
+        z2 = ( z1 << 24 ) | ( z2 >> 8 );
+        z1 = ( z0 << 24 ) | ( z1 >> 8 );
+        z0 = ( z0 >> 8 ) ^ ( (uint32_t) last8[rem] << 16 );
+
+        T = ctx->HT[( x[i >> 2] >> ( 24 - 8 * ( i & 3 ) ) ) & 0xFF];
+        z0 ^= T[0]; z1 ^= T[1]; z2 ^= T[2]; z3 ^= T[3];
+    }
+
+    z[0] = z0; z[1] = z1; z[2] = z2; z[3] = z3;
+}
+#endif /* MBEDTLS_GCM_GHASH_TABLE8 */
+
+#if defined(MBEDTLS_GCM_GHASH_CT)
+/*
+ * Carry-less multiplication of 32-bit words, low half of the product.
+ * Each integer multiplication only involves bits four positions apart, so
+ * the carries stay in the holes between them and are masked off (as in
+ * BearSSL's ghash_ctmul32). It runs in constant time as long as the 32-bit
+ * multiply does, which is the case on Cortex-M cores; the 32 x 32 -> 64
+ * multiply is not, on Cortex-M3.
+ */
+static uint32_t gcm_bmul32( uint32_t x, uint32_t y )
+{
+    uint32_t x0, x1, x2, x3, y0, y1, y2, y3, z0, z1, z2, z3;
+
+    x0 = x & 0x11111111; x1 = x & 0x22222222;
+    x2 = x & 0x44444444; x3 = x & 0x88888888;
+    y0 = y & 0x11111111; y1 = y & 0x22222222;
+    y2 = y & 0x44444444; y3 = y & 0x88888888;
+
+    z0 = ( x0 * y0 ) ^ ( x1 * y3 ) ^ ( x2 * y2 ) ^ ( x3 * y1 );
+    z1 = ( x0 * y1 ) ^ ( x1 * y0 ) ^ ( x2 * y3 ) ^ ( x3 * y2 );
+    z2 = ( x0 * y2 ) ^ ( x1 * y1 ) ^ ( x2 * y0 ) ^ ( x3 * y3 );
+    z3 = ( x0 * y3 ) ^ ( x1 * y2 ) ^ ( x2 * y1 ) ^ ( x3 * y0 );
+
+    return( ( z0 & 0x11111111 ) | ( z1 & 0x22222222 ) |
+            ( z2 & 0x44444444 ) | ( z3 & 0x88888888 ) );
+}
+
+static uint32_t gcm_rev32( uint32_t x )
+{
+    x = ( ( x & 0x55555555 ) << 1 ) | ( ( x >> 1 ) & 0x55555555 );
+    x = ( ( x & 0x33333333 ) << 2 ) | ( ( x >> 2 ) & 0x33333333 );
+    x = ( ( x & 0x0F0F0F0F ) << 4 ) | ( ( x >> 4 ) & 0x0F0F0F0F );
+    x = ( ( x & 0x00FF00FF ) << 8 ) | ( ( x >> 8 ) & 0x00FF00FF );
+    return( ( x << 16 ) | ( x >> 16 ) );
+}
+
+/*
+ * 32 x 32 -> 64 carry-less multiplication, r[0] holding the high half: it
+ * is the low half of the product of the bit-reversed operands, reversed
+ */
+static void gcm_clmul32( uint32_t x, uint32_t y, uint32_t r[2] )
+{
+    r[0] = gcm_rev32( gcm_bmul32( gcm_rev32( x ), gcm_rev32( y ) ) ) >> 1;
+    r[1] = gcm_bmul32( x, y );
+}
+
+/*
+ * 64 x 64 -> 128 carry-less multiplication with one Karatsuba step,
+ * most significant words first
+ */
+static void gcm_clmul64( const uint32_t a[2], const uint32_t b[2],
+                         uint32_t r[4] )
+{
+    uint32_t h[2], l[2], m[2];
+
+    gcm_clmul32( a[0], b[0], h );
+    gcm_clmul32( a[1], b[1], l );
+    gcm_clmul32( a[0] ^ a[1], b[0] ^ b[1], m );
+
+    m[0] ^= h[0] ^ l[0];
+    m[1] ^= h[1] ^ l[1];
+
+    r[0] = h[0];
+    r[1] = h[1] ^ m[0];
+    r[2] = l[0] ^ m[1];
+    r[3] = l[1];
+}
+
+/*
+ * Sets z to z times H without tables. The bytes of the field elements, read
+ * as big-endian integers, are the bit-reversed polynomials, and so is their
+ * product shifted left by one bit; its 128 low bits are then folded into
+ * the high ones modulo P^128 + P^7 + P^2 + P + 1.
+ */
+static void gcm_mult32( const mbedtls_gcm_context *ctx, uint32_t z[4] )
+{
+    int i;
+    uint32_t h[4], a[2], b[2], p[8], m[4], w[4];
+
+    h[0] = (uint32_t)( ctx->HH[8] >> 32 );
+    h[1] = (uint32_t)( ctx->HH[8]       );
+    h[2] = (uint32_t)( ctx->HL[8] >> 32 );
+    h[3] = (uint32_t)( ctx->HL[8]       );
+
+    /* 128 x 128 -> 256 with another Karatsuba step */
+    gcm_clmul64( z, h, p );
+    gcm_clmul64( z + 2, h + 2, p + 4 );
+
+    a[0] = z[0] ^ z[2]; a[1] = z[1] ^ z[3];
+    b[0] = h[0] ^ h[2]; b[1] = h[1] ^ h[3];
+    gcm_clmul64( a, b, m );
+
+    for( i = 0; i < 4; i++ )
+        m[i] ^= p[i] ^ p[i + 4];
+    for( i = 0; i < 4; i++ )
+        p[i + 2] ^= m[i];
+
+    for( i = 0; i < 7; i++ )
+        p[i] = ( p[i] << 1 ) | ( p[i + 1] >> 31 );
+    p[7] <<= 1;
+
+    /* Bits shifted out by the multiplications by P, P^2 and P^7 below */
+    w[0] = p[4] ^ ( p[7] << 31 ) ^ ( p[7] << 30 ) ^ ( p[7] << 25 );
+    w[1] = p[5];
+    w[2] = p[6];
+    w[3] = p[7];
+
+    z[0] = p[0] ^ w[0] ^ ( w[0] >> 1 ) ^ ( w[0] >> 2 ) ^ ( w[0] >> 7 );
+    for( i = 1; i < 4; i++ )
+    {
+        z[i] = p[i] ^ w[i] ^
+               ( w[i] >> 1 ) ^ ( w[i - 1] << 31 ) ^
+               ( w[i] >> 2 ) ^ ( w[i - 1] << 30 ) ^
+               ( w[i] >> 7 ) ^ ( w[i - 1] << 25 );
+    }
+}
+#endif /* MBEDTLS_GCM_GHASH_CT */
+
+#if !defined(MBEDTLS_GCM_GHASH_TABLE8) && !defined(MBEDTLS_GCM_GHASH_CT)
 /*
  * Shoup's method for multiplication use this table with
  *      last4[x] = x times P^128
@@ -202,6 +447,7 @@ static const uint64_t last4[16] =
     0xe100, 0xfd20, 0xd940, 0xc560,
     0x9180, 0x8da0, 0xa9c0, 0xb5e0
 };
+#endif
 
 /*
  * Sets output to x times H using the precomputed tables.
@@ -210,9 +456,11 @@ static const uint64_t last4[16] =
 static void gcm_mult( mbedtls_gcm_context *ctx, const unsigned char x[16],
                       unsigned char output[16] )
 {
+#if !defined(MBEDTLS_GCM_GHASH_TABLE8) && !defined(MBEDTLS_GCM_GHASH_CT)
     int i = 0;
     unsigned char lo, hi, rem;
     uint64_t zh, zl;
+#endif
 
 #if defined(MBEDTLS_AESNI_C) && defined(MBEDTLS_HAVE_X86_64)
     if( mbedtls_aesni_has_support( MBEDTLS_AESNI_CLMUL ) ) {
@@ -228,6 +476,24 @@ static void gcm_mult( mbedtls_gcm_context *ctx, const unsigned char x[16],
     }
 #endif /* MBEDTLS_AESNI_C && MBEDTLS_HAVE_X86_64 */
 
+#if defined(MBEDTLS_GCM_GHASH_TABLE8) || defined(MBEDTLS_GCM_GHASH_CT)
+    {
+        uint32_t z[4];
+
+        GET_UINT32_BE( z[0], x,  0 );
+        GET_UINT32_BE( z[1], x,  4 );
+        GET_UINT32_BE( z[2], x,  8 );
+        GET_UINT32_BE( z[3], x, 12 );
+
+        gcm_mult32( ctx, z );
+
+        PUT_UINT32_BE( z[0], output,  0 );
+        PUT_UINT32_BE( z[1], output,  4 );
+        PUT_UINT32_BE( z[2], output,  8 );
+        PUT_UINT32_BE( z[3], output, 12 );
+    }
+#else
+
     lo = x[15] & 0xf;
 
     zh = ctx->HH[lo];
@@ -261,6 +527,109 @@ static void gcm_mult( mbedtls_gcm_context *ctx, const unsigned char x[16],
     PUT_UINT32_BE( zh, output, 4 );
     PUT_UINT32_BE( zl >> 32, output, 8 );
     PUT_UINT32_BE( zl, output, 12 );
+#endif /* !MBEDTLS_GCM_GHASH_TABLE8 && !MBEDTLS_GCM_GHASH_CT */
+}
+
+/*
+ * Absorbs len bytes of input, a multiple of 16, into the GHASH state buf
+ */
+static void gcm_ghash( mbedtls_gcm_context *ctx, const unsigned char *input,
+                       size_t len )
+{
+    size_t i;
+
+#if defined(MBEDTLS_GCM_GHASH_TABLE8) || defined(MBEDTLS_GCM_GHASH_CT)
+#if defined(MBEDTLS_AESNI_C) && defined(MBEDTLS_HAVE_X86_64)
+    if( ! mbedtls_aesni_has_support( MBEDTLS_AESNI_CLMUL ) )
+#endif
+    {
+        /* Keep the state in words from one block to the next */
+        uint32_t z[4], w;
+
+        GET_UINT32_BE( z[0], ctx->buf,  0 );
+        GET_UINT32_BE( z[1], ctx->buf,  4 );
+        GET_UINT32_BE( z[2], ctx->buf,  8 );
+        GET_UINT32_BE( z[3], ctx->buf, 12 );
+
+        for( ; len > 0; len -= 16, input += 16 )
+        {
+            GET_UINT32_BE( w, input,  0 ); z[0] ^= w;
+            GET_UINT32_BE( w, input,  4 ); z[1] ^= w;
+            GET_UINT32_BE( w, input,  8 ); z[2] ^= w;
+            GET_UINT32_BE( w, input, 12 ); z[3] ^= w;
+
+            gcm_mult32( ctx, z );
+        }
+
+        PUT_UINT32_BE( z[0], ctx->buf,  0 );
+        PUT_UINT32_BE( z[1], ctx->buf,  4 );
+        PUT_UINT32_BE( z[2], ctx->buf,  8 );
+        PUT_UINT32_BE( z[3], ctx->buf, 12 );
+        return;
+    }
+#endif /* MBEDTLS_GCM_GHASH_TABLE8 || MBEDTLS_GCM_GHASH_CT */
+
+    for( ; len > 0; len -= 16, input += 16 )
+    {
+        for( i = 0; i < 16; i++ )
+            ctx->buf[i] ^= input[i];
+
+        gcm_mult( ctx, ctx->buf, ctx->buf );
+    }
+}
+
+/*
+ * Counter mode on whole blocks, incrementing the last 32 bits of y before
+ * each block
+ */
+static int gcm_ctr( mbedtls_gcm_context *ctx, size_t blocks,
+                    const unsigned char *input, unsigned char *output )
+{
+    int ret;
+    unsigned char ectr[16];
+    size_t i, olen = 0;
+
+#if defined(MBEDTLS_AES_CTR_BLOCKS) && !defined(MBEDTLS_AES_ALT)
+    switch( ctx->cipher_ctx.cipher_info->type )
+    {
+        case MBEDTLS_CIPHER_AES_128_ECB:
+        case MBEDTLS_CIPHER_AES_192_ECB:
+        case MBEDTLS_CIPHER_AES_256_ECB:
+        {
+            uint32_t c;
+
+            GET_UINT32_BE( c, ctx->y, 12 );
+            PUT_UINT32_BE( c + (uint32_t) blocks, ctx->y, 12 );
+
+            memcpy( ectr, ctx->y, 12 );
+            PUT_UINT32_BE( c + 1, ectr, 12 );
+
+            return( mbedtls_aes_crypt_ctr32( ctx->cipher_ctx.cipher_ctx, blocks,
+                                             ectr, input, output ) );
+        }
+
+        default:
+            break;
+    }
+#endif /* MBEDTLS_AES_CTR_BLOCKS && !MBEDTLS_AES_ALT */
+
+    for( ; blocks > 0; blocks--, input += 16, output += 16 )
+    {
+        for( i = 16; i > 12; i-- )
+            if( ++ctx->y[i - 1] != 0 )
+                break;
+
+        if( ( ret = mbedtls_cipher_update( &ctx->cipher_ctx, ctx->y, 16, ectr,
+                                   &olen ) ) != 0 )
+        {
+            return( ret );
+        }
+
+        for( i = 0; i < 16; i++ )
+            output[i] = ectr[i] ^ input[i];
+    }
+
+    return( 0 );
 }
 
 int mbedtls_gcm_starts( mbedtls_gcm_context *ctx,
@@ -327,7 +696,10 @@ int mbedtls_gcm_starts( mbedtls_gcm_context *ctx,
     }
 
     ctx->add_len = add_len;
-    p = add;
+    use_len = add_len & ~(size_t) 15;
+    gcm_ghash( ctx, add, use_len );
+    add_len -= use_len;
+    p = add + use_len;
     while( add_len > 0 )
     {
         use_len = ( add_len < 16 ) ? add_len : 16;
@@ -369,7 +741,25 @@ int mbedtls_gcm_update( mbedtls_gcm_context *ctx,
 
     ctx->len += length;
 
-    p = input;
+    /* Whole blocks at once. On decryption, output may trail input, so all
+     * of input is hashed before any of it is overwritten. */
+    use_len = length & ~(size_t) 15;
+    if( use_len > 0 )
+    {
+        if( ctx->mode == MBEDTLS_GCM_DECRYPT )
+            gcm_ghash( ctx, input, use_len );
+
+        if( ( ret = gcm_ctr( ctx, use_len / 16, input, output ) ) != 0 )
+            return( ret );
+
+        if( ctx->mode == MBEDTLS_GCM_ENCRYPT )
+            gcm_ghash( ctx, output, use_len );
+
+        length -= use_len;
+        out_p += use_len;
+    }
+
+    p = input + use_len;
     while( length > 0 )
     {
         use_len = ( length < 16 ) ? length : 16;
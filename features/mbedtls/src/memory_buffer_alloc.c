@@ -68,6 +68,53 @@ struct _memory_header
     size_t          magic2;
 };
 
+#if defined(MBEDTLS_MEMORY_BUFFER_ALLOC_SLABS)
+/*
+ * Allocations of up to MBEDTLS_MEMORY_SLAB_MAX_SIZE bytes come from slabs:
+ * blocks of the heap cut into chunks of one size class. Free chunks of a
+ * slab are on a list through their first bytes, and slabs with free chunks
+ * on a list per class, so allocation and free are O(1).
+ *
+ * The word before a chunk points to its slab, with SLAB_CHUNK_FREE set
+ * while the chunk is free. Slabs are aligned to at least 4 bytes, so the
+ * word cannot be MAGIC2, which precedes blocks of the heap.
+ */
+#if MBEDTLS_MEMORY_ALIGN_MULTIPLE % 4 != 0
+#error "MBEDTLS_MEMORY_BUFFER_ALLOC_SLABS needs MBEDTLS_MEMORY_ALIGN_MULTIPLE to be a multiple of 4"
+#endif
+
+#if MBEDTLS_MEMORY_SLAB_MAX_SIZE % 8 != 0 || MBEDTLS_MEMORY_SLAB_MAX_SIZE > 1024
+#error "MBEDTLS_MEMORY_SLAB_MAX_SIZE must be a multiple of 8, up to 1024"
+#endif
+
+#define SLAB_MAGIC      0xDD22BB44
+#define SLAB_CHUNK_FREE 1
+#define SLAB_CLASSES    ( sizeof( slab_sizes ) / sizeof( slab_sizes[0] ) )
+
+#define ALIGN_UP( x )   ( ( ( x ) + MBEDTLS_MEMORY_ALIGN_MULTIPLE - 1 ) /   \
+                          MBEDTLS_MEMORY_ALIGN_MULTIPLE *                   \
+                          MBEDTLS_MEMORY_ALIGN_MULTIPLE )
+#define SLAB_HEADER     ALIGN_UP( sizeof( slab_page ) )
+#define CHUNK_HEADER    ALIGN_UP( sizeof( size_t ) )
+#define CHUNK_WORD( p ) ( ( (size_t *) ( p ) )[-1] )
+
+/* Size classes, spaced so no chunk wastes more than a third of itself */
+static const size_t slab_sizes[] =
+    { 8, 16, 24, 32, 48, 64, 96, 128, 192, 256, 384, 512, 768, 1024 };
+
+typedef struct _slab_page slab_page;
+struct _slab_page
+{
+    size_t          magic;
+    size_t          size;       /* of its chunks                    */
+    size_t          count;      /* chunks it holds                  */
+    size_t          used;       /* chunks allocated                 */
+    unsigned char   *free;      /* first free chunk                 */
+    slab_page       *prev;      /* slabs of the class with free     */
+    slab_page       *next;      /* chunks                           */
+};
+#endif /* MBEDTLS_MEMORY_BUFFER_ALLOC_SLABS */
+
 typedef struct
 {
     unsigned char   *buf;
@@ -83,6 +130,12 @@ typedef struct
     size_t          header_count;
     size_t          maximum_header_count;
 #endif
+#if defined(MBEDTLS_MEMORY_BUFFER_ALLOC_SLABS)
+    slab_page       *slabs[SLAB_CLASSES];
+    unsigned char   slab_index[MBEDTLS_MEMORY_SLAB_MAX_SIZE / 8];
+    size_t          slab_bytes;
+    size_t          slab_free;
+#endif
 #if defined(MBEDTLS_THREADING_C)
     mbedtls_threading_mutex_t   mutex;
 #endif
@@ -229,31 +282,18 @@ static int verify_chain()
     return( 0 );
 }
 
-static void *buffer_alloc_calloc( size_t n, size_t size )
+/*
+ * First fit in the list of free blocks, len is aligned
+ */
+static void *heap_alloc( size_t len )
 {
     memory_header *new, *cur = heap.first_free;
     unsigned char *p;
-    void *ret;
-    size_t original_len, len;
 #if defined(MBEDTLS_MEMORY_BACKTRACE)
     void *trace_buffer[MAX_BT];
     size_t trace_cnt;
 #endif
 
-    if( heap.buf == NULL || heap.first == NULL )
-        return( NULL );
-
-    original_len = len = n * size;
-
-    if( n != 0 && len / n != size )
-        return( NULL );
-
-    if( len % MBEDTLS_MEMORY_ALIGN_MULTIPLE )
-    {
-        len -= len % MBEDTLS_MEMORY_ALIGN_MULTIPLE;
-        len += MBEDTLS_MEMORY_ALIGN_MULTIPLE;
-    }
-
     // Find block that fits
     //
     while( cur != NULL )
@@ -276,10 +316,6 @@ static void *buffer_alloc_calloc( size_t n, size_t size )
         mbedtls_exit( 1 );
     }
 
-#if defined(MBEDTLS_MEMORY_DEBUG)
-    heap.alloc_count++;
-#endif
-
     // Found location, split block if > memory_header + 4 room left
     //
     if( cur->size - len < sizeof(memory_header) +
@@ -311,13 +347,7 @@ static void *buffer_alloc_calloc( size_t n, size_t size )
         cur->trace_count = trace_cnt;
 #endif
 
-        if( ( heap.verify & MBEDTLS_MEMORY_VERIFY_ALLOC ) && verify_chain() != 0 )
-            mbedtls_exit( 1 );
-
-        ret = (unsigned char *) cur + sizeof( memory_header );
-        memset( ret, 0, original_len );
-
-        return( ret );
+        return( (unsigned char *) cur + sizeof( memory_header ) );
     }
 
     p = ( (unsigned char *) cur ) + sizeof(memory_header) + len;
@@ -369,32 +399,17 @@ static void *buffer_alloc_calloc( size_t n, size_t size )
     cur->trace_count = trace_cnt;
 #endif
 
-    if( ( heap.verify & MBEDTLS_MEMORY_VERIFY_ALLOC ) && verify_chain() != 0 )
-        mbedtls_exit( 1 );
-
-    ret = (unsigned char *) cur + sizeof( memory_header );
-    memset( ret, 0, original_len );
-
-    return( ret );
+    return( (unsigned char *) cur + sizeof( memory_header ) );
 }
 
-static void buffer_alloc_free( void *ptr )
+/*
+ * Return a block to the list of free blocks, merging it with its neighbours
+ */
+static void heap_free( void *ptr )
 {
     memory_header *hdr, *old = NULL;
     unsigned char *p = (unsigned char *) ptr;
 
-    if( ptr == NULL || heap.buf == NULL || heap.first == NULL )
-        return;
-
-    if( p < heap.buf || p > heap.buf + heap.len )
-    {
-#if defined(MBEDTLS_MEMORY_DEBUG)
-        mbedtls_fprintf( stderr, "FATAL: mbedtls_free() outside of managed "
-                                  "space\n" );
-#endif
-        mbedtls_exit( 1 );
-    }
-
     p -= sizeof(memory_header);
     hdr = (memory_header *) p;
 
@@ -413,7 +428,6 @@ static void buffer_alloc_free( void *ptr )
     hdr->alloc = 0;
 
 #if defined(MBEDTLS_MEMORY_DEBUG)
-    heap.free_count++;
     heap.total_used -= hdr->size;
 #endif
 
@@ -490,6 +504,261 @@ static void buffer_alloc_free( void *ptr )
             heap.first_free->prev_free = hdr;
         heap.first_free = hdr;
     }
+}
+
+#if defined(MBEDTLS_MEMORY_BUFFER_ALLOC_SLABS)
+static void slab_link( slab_page *page )
+{
+    slab_page **head = &heap.slabs[heap.slab_index[( page->size - 1 ) / 8]];
+
+    page->prev = NULL;
+    page->next = *head;
+    if( *head != NULL )
+        (*head)->prev = page;
+    *head = page;
+}
+
+static void slab_unlink( slab_page *page )
+{
+    if( page->prev != NULL )
+        page->prev->next = page->next;
+    else
+        heap.slabs[heap.slab_index[( page->size - 1 ) / 8]] = page->next;
+
+    if( page->next != NULL )
+        page->next->prev = page->prev;
+
+    page->prev = NULL;
+    page->next = NULL;
+}
+
+/*
+ * New slab for a size class, with as many chunks as fit in
+ * MBEDTLS_MEMORY_SLAB_PAGE_SIZE and at least one
+ */
+static slab_page *slab_create( size_t size )
+{
+    size_t stride = ALIGN_UP( CHUNK_HEADER + size );
+    size_t count, i;
+    slab_page *page;
+    unsigned char *chunk;
+
+    count = MBEDTLS_MEMORY_SLAB_PAGE_SIZE > SLAB_HEADER + stride ?
+            ( MBEDTLS_MEMORY_SLAB_PAGE_SIZE - SLAB_HEADER ) / stride : 1;
+
+    page = heap_alloc( SLAB_HEADER + count * stride );
+    if( page == NULL )
+        return( NULL );
+
+    page->magic = SLAB_MAGIC;
+    page->size = size;
+    page->count = count;
+    page->used = 0;
+    page->free = NULL;
+
+    // Free list in address order, the first chunk first
+    //
+    chunk = (unsigned char *) page + SLAB_HEADER + count * stride;
+    for( i = 0; i < count; i++ )
+    {
+        chunk -= stride;
+        CHUNK_WORD( chunk + CHUNK_HEADER ) = (size_t) page | SLAB_CHUNK_FREE;
+        *(unsigned char **) ( chunk + CHUNK_HEADER ) = page->free;
+        page->free = chunk + CHUNK_HEADER;
+    }
+
+    slab_link( page );
+
+    heap.slab_bytes += ( (memory_header *) page - 1 )->size;
+    heap.slab_free += count * size;
+
+    return( page );
+}
+
+static void slab_release( slab_page *page )
+{
+    slab_unlink( page );
+
+    heap.slab_bytes -= ( (memory_header *) page - 1 )->size;
+    heap.slab_free -= page->count * page->size;
+
+    page->magic = 0;
+    heap_free( page );
+}
+
+/*
+ * Return the empty slabs kept for reuse to the heap
+ */
+static int slab_trim( void )
+{
+    slab_page *page, *next;
+    size_t i;
+    int released = 0;
+
+    for( i = 0; i < SLAB_CLASSES; i++ )
+    {
+        for( page = heap.slabs[i]; page != NULL; page = next )
+        {
+            next = page->next;
+            if( page->used == 0 )
+            {
+                slab_release( page );
+                released = 1;
+            }
+        }
+    }
+
+    return( released );
+}
+
+static void *slab_alloc( size_t len )
+{
+    size_t size = slab_sizes[heap.slab_index[( len - 1 ) / 8]];
+    slab_page *page = heap.slabs[heap.slab_index[( len - 1 ) / 8]];
+    unsigned char *chunk;
+
+    if( page == NULL && ( page = slab_create( size ) ) == NULL )
+        return( NULL );
+
+    chunk = page->free;
+    if( CHUNK_WORD( chunk ) != ( (size_t) page | SLAB_CHUNK_FREE ) )
+    {
+#if defined(MBEDTLS_MEMORY_DEBUG)
+        mbedtls_fprintf( stderr, "FATAL: free chunk of slab corrupted\n" );
+#endif
+        mbedtls_exit( 1 );
+    }
+
+    page->free = *(unsigned char **) chunk;
+    page->used++;
+    CHUNK_WORD( chunk ) = (size_t) page;
+
+    // A full slab leaves the list, it has nothing to give
+    //
+    if( page->free == NULL )
+        slab_unlink( page );
+
+    heap.slab_free -= page->size;
+
+    return( chunk );
+}
+
+static void slab_free( unsigned char *chunk )
+{
+    slab_page *page = (slab_page *) ( CHUNK_WORD( chunk ) & ~SLAB_CHUNK_FREE );
+
+    if( (unsigned char *) page < heap.buf ||
+        (unsigned char *) page > heap.buf + heap.len ||
+        page->magic != SLAB_MAGIC )
+    {
+#if defined(MBEDTLS_MEMORY_DEBUG)
+        mbedtls_fprintf( stderr, "FATAL: mbedtls_free() on corrupted "
+                                  "data\n" );
+#endif
+        mbedtls_exit( 1 );
+    }
+
+    if( CHUNK_WORD( chunk ) & SLAB_CHUNK_FREE )
+    {
+#if defined(MBEDTLS_MEMORY_DEBUG)
+        mbedtls_fprintf( stderr, "FATAL: mbedtls_free() on unallocated "
+                                  "data\n" );
+#endif
+        mbedtls_exit( 1 );
+    }
+
+    CHUNK_WORD( chunk ) = (size_t) page | SLAB_CHUNK_FREE;
+    *(unsigned char **) chunk = page->free;
+    if( page->free == NULL )
+        slab_link( page );
+    page->free = chunk;
+    page->used--;
+
+    heap.slab_free += page->size;
+
+    // Keep an empty slab only when it is the last of its class with free
+    // chunks, so alternating alloc and free does not create it each time
+    //
+    if( page->used == 0 && ( page->prev != NULL || page->next != NULL ) )
+        slab_release( page );
+}
+#endif /* MBEDTLS_MEMORY_BUFFER_ALLOC_SLABS */
+
+static void *buffer_alloc_calloc( size_t n, size_t size )
+{
+    void *ret = NULL;
+    size_t original_len, len;
+
+    if( heap.buf == NULL || heap.first == NULL )
+        return( NULL );
+
+    original_len = len = n * size;
+
+    if( n != 0 && len / n != size )
+        return( NULL );
+
+    if( len % MBEDTLS_MEMORY_ALIGN_MULTIPLE )
+    {
+        len -= len % MBEDTLS_MEMORY_ALIGN_MULTIPLE;
+        len += MBEDTLS_MEMORY_ALIGN_MULTIPLE;
+    }
+
+#if defined(MBEDTLS_MEMORY_BUFFER_ALLOC_SLABS)
+    if( len != 0 && len <= MBEDTLS_MEMORY_SLAB_MAX_SIZE )
+        ret = slab_alloc( len );
+
+    // Without room for a new slab, a block may still fit
+    //
+    if( ret == NULL )
+        ret = heap_alloc( len );
+
+    if( ret == NULL && slab_trim() != 0 )
+        ret = heap_alloc( len );
+#else
+    ret = heap_alloc( len );
+#endif
+
+    if( ret == NULL )
+        return( NULL );
+
+#if defined(MBEDTLS_MEMORY_DEBUG)
+    heap.alloc_count++;
+#endif
+
+    if( ( heap.verify & MBEDTLS_MEMORY_VERIFY_ALLOC ) && verify_chain() != 0 )
+        mbedtls_exit( 1 );
+
+    memset( ret, 0, original_len );
+
+    return( ret );
+}
+
+static void buffer_alloc_free( void *ptr )
+{
+    unsigned char *p = (unsigned char *) ptr;
+
+    if( ptr == NULL || heap.buf == NULL || heap.first == NULL )
+        return;
+
+    if( p < heap.buf || p > heap.buf + heap.len )
+    {
+#if defined(MBEDTLS_MEMORY_DEBUG)
+        mbedtls_fprintf( stderr, "FATAL: mbedtls_free() outside of managed "
+                                  "space\n" );
+#endif
+        mbedtls_exit( 1 );
+    }
+
+#if defined(MBEDTLS_MEMORY_DEBUG)
+    heap.free_count++;
+#endif
+
+#if defined(MBEDTLS_MEMORY_BUFFER_ALLOC_SLABS)
+    if( CHUNK_WORD( p ) != MAGIC2 )
+        slab_free( p );
+    else
+#endif
+        heap_free( p );
 
     if( ( heap.verify & MBEDTLS_MEMORY_VERIFY_FREE ) && verify_chain() != 0 )
         mbedtls_exit( 1 );
@@ -505,9 +774,54 @@ int mbedtls_memory_buffer_alloc_verify()
     return verify_chain();
 }
 
+void mbedtls_memory_buffer_alloc_frag_get( size_t *free_bytes, size_t *free_blocks,
+                                           size_t *largest_free )
+{
+    memory_header *cur;
+
+    *free_bytes = 0;
+    *free_blocks = 0;
+    *largest_free = 0;
+
+#if defined(MBEDTLS_THREADING_C)
+    if( mbedtls_mutex_lock( &heap.mutex ) != 0 )
+        return;
+#endif
+
+    for( cur = heap.first_free; cur != NULL; cur = cur->next_free )
+    {
+        *free_bytes += cur->size;
+        *free_blocks += 1;
+        if( cur->size > *largest_free )
+            *largest_free = cur->size;
+    }
+
+#if defined(MBEDTLS_THREADING_C)
+    (void) mbedtls_mutex_unlock( &heap.mutex );
+#endif
+}
+
+#if defined(MBEDTLS_MEMORY_BUFFER_ALLOC_SLABS)
+void mbedtls_memory_buffer_alloc_slab_get( size_t *slab_bytes, size_t *slab_free )
+{
+    *slab_bytes = heap.slab_bytes;
+    *slab_free  = heap.slab_free;
+}
+#endif
+
 #if defined(MBEDTLS_MEMORY_DEBUG)
 void mbedtls_memory_buffer_alloc_status()
 {
+    size_t free_bytes, free_blocks, largest_free;
+
+#if defined(MBEDTLS_MEMORY_BUFFER_ALLOC_SLABS)
+    /* Empty slabs kept for reuse are not leaks */
+    slab_trim();
+#endif
+
+    mbedtls_memory_buffer_alloc_frag_get( &free_bytes, &free_blocks,
+                                          &largest_free );
+
     mbedtls_fprintf( stderr,
                       "Current use: %zu blocks / %zu bytes, max: %zu blocks / "
                       "%zu bytes (total %zu bytes), alloc / free: %zu / %zu\n",
@@ -517,6 +831,18 @@ void mbedtls_memory_buffer_alloc_status()
                       + heap.maximum_used,
                       heap.alloc_count, heap.free_count );
 
+    mbedtls_fprintf( stderr,
+                      "Free: %zu bytes in %zu blocks, largest %zu bytes "
+                      "(fragmentation %zu%%)\n",
+                      free_bytes, free_blocks, largest_free,
+                      free_bytes == 0 ? 0 :
+                      100 - largest_free * 100 / free_bytes );
+
+#if defined(MBEDTLS_MEMORY_BUFFER_ALLOC_SLABS)
+    mbedtls_fprintf( stderr, "Slabs: %zu bytes, %zu bytes in free chunks\n",
+                      heap.slab_bytes, heap.slab_free );
+#endif
+
     if( heap.first->next == NULL )
         mbedtls_fprintf( stderr, "All memory de-allocated in stack buffer\n" );
     else
@@ -570,9 +896,23 @@ static void buffer_alloc_free_mutexed( void *ptr )
 
 void mbedtls_memory_buffer_alloc_init( unsigned char *buf, size_t len )
 {
+#if defined(MBEDTLS_MEMORY_BUFFER_ALLOC_SLABS)
+    size_t i, cls = 0;
+#endif
+
     memset( &heap, 0, sizeof(buffer_alloc_ctx) );
     memset( buf, 0, len );
 
+#if defined(MBEDTLS_MEMORY_BUFFER_ALLOC_SLABS)
+    /* Smallest class that fits, by size in multiples of 8 */
+    for( i = 0; i < sizeof( heap.slab_index ); i++ )
+    {
+        while( slab_sizes[cls] < ( i + 1 ) * 8 )
+            cls++;
+        heap.slab_index[i] = (unsigned char) cls;
+    }
+#endif
+
 #if defined(MBEDTLS_THREADING_C)
     mbedtls_mutex_init( &heap.mutex );
     mbedtls_platform_set_calloc_free( buffer_alloc_calloc_mutexed,
@@ -622,6 +962,10 @@ static int check_pointer( void *p )
 
 static int check_all_free( )
 {
+#if defined(MBEDTLS_MEMORY_BUFFER_ALLOC_SLABS)
+    slab_trim();
+#endif
+
     if(
 #if defined(MBEDTLS_MEMORY_DEBUG)
         heap.total_used != 0 ||
@@ -19,8 +19,9 @@
  *  This file is part of mbed TLS (https://tls.mbed.org)
  */
 /*
- * These session callbacks use a simple chained list
- * to store and retrieve the session information.
+ * These session callbacks keep the sessions in a hash table indexed by
+ * session ID, with the entries also linked in order of use, for LRU
+ * eviction, and in order of age, to drop expired entries from the front.
  */
 
 #if !defined(MBEDTLS_CONFIG_FILE)
@@ -43,6 +44,9 @@
 
 #include <string.h>
 
+/* Initial size of the hash table, doubled when it holds as many entries */
+#define SSL_CACHE_MIN_BUCKETS   16
+
 void mbedtls_ssl_cache_init( mbedtls_ssl_cache_context *cache )
 {
     memset( cache, 0, sizeof( mbedtls_ssl_cache_context ) );
@@ -55,77 +59,263 @@ void mbedtls_ssl_cache_init( mbedtls_ssl_cache_context *cache )
 #endif
 }
 
-int mbedtls_ssl_cache_get( void *data, mbedtls_ssl_session *session )
+/*
+ * FNV-1a of the session ID. IDs are picked at random by the server, so
+ * this spreads them well enough.
+ */
+static size_t ssl_cache_hash( const unsigned char *id, size_t id_len )
 {
-    int ret = 1;
+    uint32_t h = 2166136261u;
+    size_t i;
+
+    for( i = 0; i < id_len; i++ )
+    {
+        h ^= id[i];
+        h *= 16777619u;
+    }
+
+    return( h );
+}
+
+static mbedtls_ssl_cache_entry **ssl_cache_bucket( mbedtls_ssl_cache_context *cache,
+                                                   const mbedtls_ssl_session *session )
+{
+    size_t h = ssl_cache_hash( session->id, session->id_len );
+
+    return( &cache->buckets[h & ( cache->bucket_count - 1 )] );
+}
+
+static mbedtls_ssl_cache_entry *ssl_cache_find( mbedtls_ssl_cache_context *cache,
+                                                const mbedtls_ssl_session *session )
+{
+    mbedtls_ssl_cache_entry *cur;
+
+    if( cache->buckets == NULL )
+        return( NULL );
+
+    for( cur = *ssl_cache_bucket( cache, session ); cur != NULL; cur = cur->next )
+    {
+        if( cur->session.id_len == session->id_len &&
+            memcmp( cur->session.id, session->id, session->id_len ) == 0 )
+            return( cur );
+    }
+
+    return( NULL );
+}
+
+/*
+ * Link an entry in, as the most recently used and the newest
+ */
+static void ssl_cache_link( mbedtls_ssl_cache_context *cache,
+                            mbedtls_ssl_cache_entry *entry )
+{
+    mbedtls_ssl_cache_entry **bucket = ssl_cache_bucket( cache, &entry->session );
+
+    entry->next = *bucket;
+    *bucket = entry;
+
+    entry->lru_prev = NULL;
+    entry->lru_next = cache->lru_head;
+    if( cache->lru_head != NULL )
+        cache->lru_head->lru_prev = entry;
+    else
+        cache->lru_tail = entry;
+    cache->lru_head = entry;
+
 #if defined(MBEDTLS_HAVE_TIME)
-    mbedtls_time_t t = mbedtls_time( NULL );
+    entry->age_next = NULL;
+    entry->age_prev = cache->age_tail;
+    if( cache->age_tail != NULL )
+        cache->age_tail->age_next = entry;
+    else
+        cache->age_head = entry;
+    cache->age_tail = entry;
+#endif
+
+    cache->entries++;
+}
+
+static void ssl_cache_unlink( mbedtls_ssl_cache_context *cache,
+                              mbedtls_ssl_cache_entry *entry )
+{
+    mbedtls_ssl_cache_entry **cur = ssl_cache_bucket( cache, &entry->session );
+
+    while( *cur != entry )
+        cur = &(*cur)->next;
+    *cur = entry->next;
+
+    if( entry->lru_prev != NULL )
+        entry->lru_prev->lru_next = entry->lru_next;
+    else
+        cache->lru_head = entry->lru_next;
+    if( entry->lru_next != NULL )
+        entry->lru_next->lru_prev = entry->lru_prev;
+    else
+        cache->lru_tail = entry->lru_prev;
+
+#if defined(MBEDTLS_HAVE_TIME)
+    if( entry->age_prev != NULL )
+        entry->age_prev->age_next = entry->age_next;
+    else
+        cache->age_head = entry->age_next;
+    if( entry->age_next != NULL )
+        entry->age_next->age_prev = entry->age_prev;
+    else
+        cache->age_tail = entry->age_prev;
+#endif
+
+    cache->entries--;
+}
+
+/*
+ * Move an entry to the front of the LRU list
+ */
+static void ssl_cache_touch( mbedtls_ssl_cache_context *cache,
+                             mbedtls_ssl_cache_entry *entry )
+{
+    if( entry == cache->lru_head )
+        return;
+
+    entry->lru_prev->lru_next = entry->lru_next;
+    if( entry->lru_next != NULL )
+        entry->lru_next->lru_prev = entry->lru_prev;
+    else
+        cache->lru_tail = entry->lru_prev;
+
+    entry->lru_prev = NULL;
+    entry->lru_next = cache->lru_head;
+    cache->lru_head->lru_prev = entry;
+    cache->lru_head = entry;
+}
+
+/*
+ * Free what an unlinked entry holds, leaving it ready for reuse
+ */
+static void ssl_cache_entry_clear( mbedtls_ssl_cache_entry *entry )
+{
+    mbedtls_ssl_session_free( &entry->session );
+
+#if defined(MBEDTLS_X509_CRT_PARSE_C)
+    mbedtls_free( entry->peer_cert.p );
 #endif
+
+    memset( entry, 0, sizeof( mbedtls_ssl_cache_entry ) );
+}
+
+/*
+ * Double the hash table. On failure the table keeps its size, and only
+ * its chains get longer.
+ */
+static int ssl_cache_grow( mbedtls_ssl_cache_context *cache )
+{
+    mbedtls_ssl_cache_entry **old = cache->buckets, *cur;
+    size_t count = cache->bucket_count != 0 ? cache->bucket_count * 2
+                                            : SSL_CACHE_MIN_BUCKETS;
+    mbedtls_ssl_cache_entry **bucket;
+
+    cache->buckets = mbedtls_calloc( count, sizeof( mbedtls_ssl_cache_entry * ) );
+    if( cache->buckets == NULL )
+    {
+        cache->buckets = old;
+        return( 1 );
+    }
+
+    cache->bucket_count = count;
+
+    for( cur = cache->lru_head; cur != NULL; cur = cur->lru_next )
+    {
+        bucket = ssl_cache_bucket( cache, &cur->session );
+        cur->next = *bucket;
+        *bucket = cur;
+    }
+
+    mbedtls_free( old );
+
+    return( 0 );
+}
+
+#if defined(MBEDTLS_HAVE_TIME)
+/*
+ * Drop the entries older than the timeout, from the oldest on
+ */
+static void ssl_cache_expire( mbedtls_ssl_cache_context *cache, mbedtls_time_t t )
+{
+    mbedtls_ssl_cache_entry *cur;
+
+    if( cache->timeout == 0 )
+        return;
+
+    while( ( cur = cache->age_head ) != NULL &&
+           (int) ( t - cur->timestamp ) > cache->timeout )
+    {
+        ssl_cache_unlink( cache, cur );
+        ssl_cache_entry_clear( cur );
+        mbedtls_free( cur );
+
+        cache->stats.expirations++;
+    }
+}
+#endif /* MBEDTLS_HAVE_TIME */
+
+int mbedtls_ssl_cache_get( void *data, mbedtls_ssl_session *session )
+{
+    int ret = 1;
     mbedtls_ssl_cache_context *cache = (mbedtls_ssl_cache_context *) data;
-    mbedtls_ssl_cache_entry *cur, *entry;
+    mbedtls_ssl_cache_entry *entry;
 
 #if defined(MBEDTLS_THREADING_C)
     if( mbedtls_mutex_lock( &cache->mutex ) != 0 )
         return( 1 );
 #endif
 
-    cur = cache->chain;
-    entry = NULL;
-
-    while( cur != NULL )
-    {
-        entry = cur;
-        cur = cur->next;
-
 #if defined(MBEDTLS_HAVE_TIME)
-        if( cache->timeout != 0 &&
-            (int) ( t - entry->timestamp ) > cache->timeout )
-            continue;
+    ssl_cache_expire( cache, mbedtls_time( NULL ) );
 #endif
 
-        if( session->ciphersuite != entry->session.ciphersuite ||
-            session->compression != entry->session.compression ||
-            session->id_len != entry->session.id_len )
-            continue;
+    entry = ssl_cache_find( cache, session );
 
-        if( memcmp( session->id, entry->session.id,
-                    entry->session.id_len ) != 0 )
-            continue;
+    if( entry == NULL ||
+        session->ciphersuite != entry->session.ciphersuite ||
+        session->compression != entry->session.compression )
+        goto exit;
 
-        memcpy( session->master, entry->session.master, 48 );
+    memcpy( session->master, entry->session.master, 48 );
 
-        session->verify_result = entry->session.verify_result;
+    session->verify_result = entry->session.verify_result;
 
 #if defined(MBEDTLS_X509_CRT_PARSE_C)
-        /*
-         * Restore peer certificate (without rest of the original chain)
-         */
-        if( entry->peer_cert.p != NULL )
+    /*
+     * Restore peer certificate (without rest of the original chain)
+     */
+    if( entry->peer_cert.p != NULL )
+    {
+        if( ( session->peer_cert = mbedtls_calloc( 1,
+                             sizeof(mbedtls_x509_crt) ) ) == NULL )
         {
-            if( ( session->peer_cert = mbedtls_calloc( 1,
-                                 sizeof(mbedtls_x509_crt) ) ) == NULL )
-            {
-                ret = 1;
-                goto exit;
-            }
+            goto exit;
+        }
 
-            mbedtls_x509_crt_init( session->peer_cert );
-            if( mbedtls_x509_crt_parse( session->peer_cert, entry->peer_cert.p,
-                                entry->peer_cert.len ) != 0 )
-            {
-                mbedtls_free( session->peer_cert );
-                session->peer_cert = NULL;
-                ret = 1;
-                goto exit;
-            }
+        mbedtls_x509_crt_init( session->peer_cert );
+        if( mbedtls_x509_crt_parse( session->peer_cert, entry->peer_cert.p,
+                            entry->peer_cert.len ) != 0 )
+        {
+            mbedtls_free( session->peer_cert );
+            session->peer_cert = NULL;
+            goto exit;
         }
+    }
 #endif /* MBEDTLS_X509_CRT_PARSE_C */
 
-        ret = 0;
-        goto exit;
-    }
+    ssl_cache_touch( cache, entry );
+
+    ret = 0;
 
 exit:
+    if( ret == 0 )
+        cache->stats.hits++;
+    else
+        cache->stats.misses++;
+
 #if defined(MBEDTLS_THREADING_C)
     if( mbedtls_mutex_unlock( &cache->mutex ) != 0 )
         ret = 1;
@@ -138,100 +328,67 @@ int mbedtls_ssl_cache_set( void *data, const mbedtls_ssl_session *session )
 {
     int ret = 1;
 #if defined(MBEDTLS_HAVE_TIME)
-    mbedtls_time_t t = time( NULL ), oldest = 0;
-    mbedtls_ssl_cache_entry *old = NULL;
+    mbedtls_time_t t = mbedtls_time( NULL );
 #endif
     mbedtls_ssl_cache_context *cache = (mbedtls_ssl_cache_context *) data;
-    mbedtls_ssl_cache_entry *cur, *prv;
-    int count = 0;
+    mbedtls_ssl_cache_entry *cur;
+    int linked = 0;
 
 #if defined(MBEDTLS_THREADING_C)
     if( ( ret = mbedtls_mutex_lock( &cache->mutex ) ) != 0 )
         return( ret );
 #endif
 
-    cur = cache->chain;
-    prv = NULL;
-
-    while( cur != NULL )
-    {
-        count++;
-
 #if defined(MBEDTLS_HAVE_TIME)
-        if( cache->timeout != 0 &&
-            (int) ( t - cur->timestamp ) > cache->timeout )
-        {
-            cur->timestamp = t;
-            break; /* expired, reuse this slot, update timestamp */
-        }
+    ssl_cache_expire( cache, t );
 #endif
 
-        if( memcmp( session->id, cur->session.id, cur->session.id_len ) == 0 )
-            break; /* client reconnected, keep timestamp for session id */
+    cur = ssl_cache_find( cache, session );
 
-#if defined(MBEDTLS_HAVE_TIME)
-        if( oldest == 0 || cur->timestamp < oldest )
+    if( cur != NULL )
+    {
+        /* client reconnected, keep timestamp for session id */
+        ssl_cache_touch( cache, cur );
+        linked = 1;
+    }
+    else
+    {
+        if( cache->max_entries <= 0 )
         {
-            oldest = cur->timestamp;
-            old = cur;
+            ret = 1;
+            goto exit;
         }
-#endif
 
-        prv = cur;
-        cur = cur->next;
-    }
-
-    if( cur == NULL )
-    {
-#if defined(MBEDTLS_HAVE_TIME)
         /*
-         * Reuse oldest entry if max_entries reached
+         * Evict the least recently used entries down to max_entries,
+         * reusing the last one for the new session
          */
-        if( count >= cache->max_entries )
+        while( cache->entries >= cache->max_entries )
         {
-            if( old == NULL )
-            {
-                ret = 1;
-                goto exit;
-            }
+            mbedtls_free( cur );
 
-            cur = old;
+            cur = cache->lru_tail;
+            ssl_cache_unlink( cache, cur );
+            ssl_cache_entry_clear( cur );
+
+            cache->stats.evictions++;
         }
-#else /* MBEDTLS_HAVE_TIME */
-        /*
-         * Reuse first entry in chain if max_entries reached,
-         * but move to last place
-         */
-        if( count >= cache->max_entries )
+
+        if( cur == NULL )
         {
-            if( cache->chain == NULL )
+            if( (size_t) cache->entries >= cache->bucket_count &&
+                ssl_cache_grow( cache ) != 0 && cache->buckets == NULL )
             {
                 ret = 1;
                 goto exit;
             }
 
-            cur = cache->chain;
-            cache->chain = cur->next;
-            cur->next = NULL;
-            prv->next = cur;
-        }
-#endif /* MBEDTLS_HAVE_TIME */
-        else
-        {
-            /*
-             * max_entries not reached, create new entry
-             */
             cur = mbedtls_calloc( 1, sizeof(mbedtls_ssl_cache_entry) );
             if( cur == NULL )
             {
                 ret = 1;
                 goto exit;
             }
-
-            if( prv == NULL )
-                cache->chain = cur;
-            else
-                prv->next = cur;
         }
 
 #if defined(MBEDTLS_HAVE_TIME)
@@ -256,9 +413,16 @@ int mbedtls_ssl_cache_set( void *data, const mbedtls_ssl_session *session )
      */
     if( session->peer_cert != NULL )
     {
+        cur->session.peer_cert = NULL;
+
         cur->peer_cert.p = mbedtls_calloc( 1, session->peer_cert->raw.len );
         if( cur->peer_cert.p == NULL )
         {
+            /* Don't leave a session that would resume without its peer */
+            if( linked )
+                ssl_cache_unlink( cache, cur );
+            ssl_cache_entry_clear( cur );
+            mbedtls_free( cur );
             ret = 1;
             goto exit;
         }
@@ -266,11 +430,12 @@ int mbedtls_ssl_cache_set( void *data, const mbedtls_ssl_session *session )
         memcpy( cur->peer_cert.p, session->peer_cert->raw.p,
                 session->peer_cert->raw.len );
         cur->peer_cert.len = session->peer_cert->raw.len;
-
-        cur->session.peer_cert = NULL;
     }
 #endif /* MBEDTLS_X509_CRT_PARSE_C */
 
+    if( !linked )
+        ssl_cache_link( cache, cur );
+
     ret = 0;
 
 exit:
@@ -298,26 +463,52 @@ void mbedtls_ssl_cache_set_max_entries( mbedtls_ssl_cache_context *cache, int ma
     cache->max_entries = max;
 }
 
+void mbedtls_ssl_cache_get_stats( mbedtls_ssl_cache_context *cache,
+                                  mbedtls_ssl_cache_stats *stats, int reset )
+{
+#if defined(MBEDTLS_THREADING_C)
+    if( mbedtls_mutex_lock( &cache->mutex ) != 0 )
+    {
+        memset( stats, 0, sizeof( mbedtls_ssl_cache_stats ) );
+        return;
+    }
+#endif
+
+    *stats = cache->stats;
+    stats->entries = cache->entries;
+
+    if( reset )
+        memset( &cache->stats, 0, sizeof( mbedtls_ssl_cache_stats ) );
+
+#if defined(MBEDTLS_THREADING_C)
+    mbedtls_mutex_unlock( &cache->mutex );
+#endif
+}
+
 void mbedtls_ssl_cache_free( mbedtls_ssl_cache_context *cache )
 {
     mbedtls_ssl_cache_entry *cur, *prv;
 
-    cur = cache->chain;
+    cur = cache->lru_head;
 
     while( cur != NULL )
     {
         prv = cur;
-        cur = cur->next;
-
-        mbedtls_ssl_session_free( &prv->session );
-
-#if defined(MBEDTLS_X509_CRT_PARSE_C)
-        mbedtls_free( prv->peer_cert.p );
-#endif /* MBEDTLS_X509_CRT_PARSE_C */
+        cur = cur->lru_next;
 
+        ssl_cache_entry_clear( prv );
         mbedtls_free( prv );
     }
 
+    mbedtls_free( cache->buckets );
+    cache->buckets = NULL;
+    cache->bucket_count = 0;
+    cache->lru_head = cache->lru_tail = NULL;
+#if defined(MBEDTLS_HAVE_TIME)
+    cache->age_head = cache->age_tail = NULL;
+#endif
+    cache->entries = 0;
+
 #if defined(MBEDTLS_THREADING_C)
     mbedtls_mutex_free( &cache->mutex );
 #endif
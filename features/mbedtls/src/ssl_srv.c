@@ -1198,7 +1198,7 @@ read_record_header:
     else
 #endif
     {
-        if( msg_len > MBEDTLS_SSL_MAX_CONTENT_LEN )
+        if( msg_len > MBEDTLS_SSL_IN_CONTENT_LEN )
         {
             MBEDTLS_SSL_DEBUG_MSG( 1, ( "bad client hello message" ) );
             return( MBEDTLS_ERR_SSL_BAD_HS_CLIENT_HELLO );
@@ -2077,7 +2077,7 @@ static void ssl_write_ecjpake_kkpp_ext( mbedtls_ssl_context *ssl,
 {
     int ret;
     unsigned char *p = buf;
-    const unsigned char *end = ssl->out_msg + MBEDTLS_SSL_MAX_CONTENT_LEN;
+    const unsigned char *end = ssl->out_msg + MBEDTLS_SSL_OUT_CONTENT_LEN;
     size_t kkpp_len;
 
     *olen = 0;
@@ -2184,7 +2184,7 @@ static int ssl_write_hello_verify_request( mbedtls_ssl_context *ssl )
     cookie_len_byte = p++;
 
     if( ( ret = ssl->conf->f_cookie_write( ssl->conf->p_cookie,
-                                     &p, ssl->out_buf + MBEDTLS_SSL_BUFFER_LEN,
+                                     &p, ssl->out_buf + mbedtls_ssl_out_buf_len( ssl ),
                                      ssl->cli_id, ssl->cli_id_len ) ) != 0 )
     {
         MBEDTLS_SSL_DEBUG_RET( 1, "f_cookie_write", ret );
@@ -2478,7 +2478,7 @@ static int ssl_write_certificate_request( mbedtls_ssl_context *ssl )
     size_t dn_size, total_dn_size; /* excluding length bytes */
     size_t ct_len, sa_len; /* including length bytes */
     unsigned char *buf, *p;
-    const unsigned char * const end = ssl->out_msg + MBEDTLS_SSL_MAX_CONTENT_LEN;
+    const unsigned char * const end = ssl->out_msg + MBEDTLS_SSL_OUT_CONTENT_LEN;
     const mbedtls_x509_crt *crt;
     int authmode;
 
@@ -2668,6 +2668,59 @@ static int ssl_get_ecdh_params_from_cert( mbedtls_ssl_context *ssl )
 #endif /* MBEDTLS_KEY_EXCHANGE_ECDH_RSA_ENABLED) ||
           MBEDTLS_KEY_EXCHANGE_ECDH_ECDSA_ENABLED */
 
+/*
+ * Send the ServerKeyExchange message written in out_msg
+ */
+static int ssl_send_server_key_exchange( mbedtls_ssl_context *ssl )
+{
+    int ret;
+
+    ssl->out_msgtype = MBEDTLS_SSL_MSG_HANDSHAKE;
+    ssl->out_msg[0]  = MBEDTLS_SSL_HS_SERVER_KEY_EXCHANGE;
+
+    ssl->state++;
+
+    if( ( ret = mbedtls_ssl_write_record( ssl ) ) != 0 )
+    {
+        MBEDTLS_SSL_DEBUG_RET( 1, "mbedtls_ssl_write_record", ret );
+        return( ret );
+    }
+
+    MBEDTLS_SSL_DEBUG_MSG( 2, ( "<= write server key exchange" ) );
+
+    return( 0 );
+}
+
+#if defined(MBEDTLS_SSL_ASYNC_PRIVATE)
+/*
+ * Complete a ServerKeyExchange message whose signature was in progress:
+ * the parameters were written up to out_msglen, the signature follows
+ */
+static int ssl_resume_server_key_exchange( mbedtls_ssl_context *ssl )
+{
+    int ret;
+    unsigned char *p = ssl->out_msg + ssl->out_msglen;
+    size_t signature_len = 0;
+
+    if( ( ret = mbedtls_ssl_async_resume( ssl, p + 2, &signature_len,
+                    MBEDTLS_SSL_OUT_CONTENT_LEN - ssl->out_msglen - 2 ) ) != 0 )
+    {
+        if( ret != MBEDTLS_ERR_SSL_WANT_ASYNC )
+            MBEDTLS_SSL_DEBUG_RET( 1, "mbedtls_ssl_async_resume", ret );
+        return( ret );
+    }
+
+    *(p++) = (unsigned char)( signature_len >> 8 );
+    *(p++) = (unsigned char)( signature_len      );
+
+    MBEDTLS_SSL_DEBUG_BUF( 3, "my signature", p, signature_len );
+
+    ssl->out_msglen += 2 + signature_len;
+
+    return( ssl_send_server_key_exchange( ssl ) );
+}
+#endif /* MBEDTLS_SSL_ASYNC_PRIVATE */
+
 static int ssl_write_server_key_exchange( mbedtls_ssl_context *ssl )
 {
     int ret;
@@ -2691,6 +2744,12 @@ static int ssl_write_server_key_exchange( mbedtls_ssl_context *ssl )
 
     MBEDTLS_SSL_DEBUG_MSG( 2, ( "=> write server key exchange" ) );
 
+#if defined(MBEDTLS_SSL_ASYNC_PRIVATE)
+    /* The parameters are written already, only the signature is missing */
+    if( ssl->handshake->async_in_progress != 0 )
+        return( ssl_resume_server_key_exchange( ssl ) );
+#endif
+
 #if defined(MBEDTLS_KEY_EXCHANGE_RSA_ENABLED) ||                           \
     defined(MBEDTLS_KEY_EXCHANGE_PSK_ENABLED) ||                           \
     defined(MBEDTLS_KEY_EXCHANGE_RSA_PSK_ENABLED)
@@ -2721,7 +2780,7 @@ static int ssl_write_server_key_exchange( mbedtls_ssl_context *ssl )
     if( ciphersuite_info->key_exchange == MBEDTLS_KEY_EXCHANGE_ECJPAKE )
     {
         size_t jlen;
-        const unsigned char *end = ssl->out_msg + MBEDTLS_SSL_MAX_CONTENT_LEN;
+        const unsigned char *end = ssl->out_msg + MBEDTLS_SSL_OUT_CONTENT_LEN;
 
         ret = mbedtls_ecjpake_write_round_two( &ssl->handshake->ecjpake_ctx,
                 p, end - p, &jlen, ssl->conf->f_rng, ssl->conf->p_rng );
@@ -2839,7 +2898,7 @@ curve_matching_done:
         }
 
         if( ( ret = mbedtls_ecdh_make_params( &ssl->handshake->ecdh_ctx, &len,
-                                      p, MBEDTLS_SSL_MAX_CONTENT_LEN - n,
+                                      p, MBEDTLS_SSL_OUT_CONTENT_LEN - n,
                                       ssl->conf->f_rng, ssl->conf->p_rng ) ) != 0 )
         {
             MBEDTLS_SSL_DEBUG_RET( 1, "mbedtls_ecdh_make_params", ret );
@@ -3002,11 +3061,15 @@ curve_matching_done:
         }
 #endif /* MBEDTLS_SSL_PROTO_TLS1_2 */
 
-        if( ( ret = mbedtls_pk_sign( mbedtls_ssl_own_key( ssl ), md_alg, hash, hashlen,
-                        p + 2 , &signature_len,
-                        ssl->conf->f_rng, ssl->conf->p_rng ) ) != 0 )
+        /* Where the signature goes, should it complete asynchronously */
+        ssl->out_msglen = 4 + n;
+
+        if( ( ret = mbedtls_ssl_own_key_sign( ssl, md_alg, hash, hashlen,
+                        p + 2, &signature_len,
+                        MBEDTLS_SSL_OUT_CONTENT_LEN - n - 6 ) ) != 0 )
         {
-            MBEDTLS_SSL_DEBUG_RET( 1, "mbedtls_pk_sign", ret );
+            if( ret != MBEDTLS_ERR_SSL_WANT_ASYNC )
+                MBEDTLS_SSL_DEBUG_RET( 1, "mbedtls_ssl_own_key_sign", ret );
             return( ret );
         }
 
@@ -3022,21 +3085,9 @@ curve_matching_done:
           MBEDTLS_KEY_EXCHANGE_ECDHE_RSA_ENABLED ||
           MBEDTLS_KEY_EXCHANGE_ECDHE_ECDSA_ENABLED */
 
-    ssl->out_msglen  = 4 + n;
-    ssl->out_msgtype = MBEDTLS_SSL_MSG_HANDSHAKE;
-    ssl->out_msg[0]  = MBEDTLS_SSL_HS_SERVER_KEY_EXCHANGE;
-
-    ssl->state++;
-
-    if( ( ret = mbedtls_ssl_write_record( ssl ) ) != 0 )
-    {
-        MBEDTLS_SSL_DEBUG_RET( 1, "mbedtls_ssl_write_record", ret );
-        return( ret );
-    }
-
-    MBEDTLS_SSL_DEBUG_MSG( 2, ( "<= write server key exchange" ) );
+    ssl->out_msglen = 4 + n;
 
-    return( 0 );
+    return( ssl_send_server_key_exchange( ssl ) );
 }
 
 static int ssl_write_server_hello_done( mbedtls_ssl_context *ssl )
@@ -3167,10 +3218,21 @@ static int ssl_parse_encrypted_pms( mbedtls_ssl_context *ssl,
     if( ret != 0 )
         return( ret );
 
-    ret = mbedtls_pk_decrypt( mbedtls_ssl_own_key( ssl ), p, len,
-                      peer_pms, &peer_pmslen,
-                      sizeof( peer_pms ),
-                      ssl->conf->f_rng, ssl->conf->p_rng );
+    peer_pmslen = 0;
+
+#if defined(MBEDTLS_SSL_ASYNC_PRIVATE)
+    if( ssl->handshake->async_in_progress != 0 )
+        ret = mbedtls_ssl_async_resume( ssl, peer_pms, &peer_pmslen,
+                                        sizeof( peer_pms ) );
+    else
+#endif
+    ret = mbedtls_ssl_own_key_decrypt( ssl, p, len,
+                                       peer_pms, &peer_pmslen,
+                                       sizeof( peer_pms ) );
+
+    /* Not an error yet, the handshake is called again once it completes */
+    if( ret == MBEDTLS_ERR_SSL_WANT_ASYNC )
+        return( ret );
 
     diff  = (unsigned int) ret;
     diff |= peer_pmslen ^ 48;
@@ -3288,6 +3350,15 @@ static int ssl_parse_client_key_exchange( mbedtls_ssl_context *ssl )
 
     MBEDTLS_SSL_DEBUG_MSG( 2, ( "=> parse client key exchange" ) );
 
+#if defined(MBEDTLS_SSL_ASYNC_PRIVATE)
+    /* The message is still in in_msg, the decryption of its premaster
+     * secret was left in progress */
+    if( ssl->handshake->async_in_progress != 0 )
+    {
+        MBEDTLS_SSL_DEBUG_MSG( 3, ( "resume decryption of the premaster" ) );
+    }
+    else
+#endif
     if( ( ret = mbedtls_ssl_read_record( ssl ) ) != 0 )
     {
         MBEDTLS_SSL_DEBUG_RET( 1, "mbedtls_ssl_read_record", ret );
@@ -3400,6 +3471,14 @@ static int ssl_parse_client_key_exchange( mbedtls_ssl_context *ssl )
 #if defined(MBEDTLS_KEY_EXCHANGE_RSA_PSK_ENABLED)
     if( ciphersuite_info->key_exchange == MBEDTLS_KEY_EXCHANGE_RSA_PSK )
     {
+#if defined(MBEDTLS_SSL_ASYNC_PRIVATE)
+        /* The identity was parsed, and the PSK set, on the first call */
+        if( ssl->handshake->async_in_progress != 0 )
+        {
+            p += 2 + ( ( (size_t) p[0] << 8 ) | p[1] );
+        }
+        else
+#endif
         if( ( ret = ssl_parse_client_psk_identity( ssl, &p, end ) ) != 0 )
         {
             MBEDTLS_SSL_DEBUG_RET( 1, ( "ssl_parse_client_psk_identity" ), ret );
@@ -3408,7 +3487,8 @@ static int ssl_parse_client_key_exchange( mbedtls_ssl_context *ssl )
 
         if( ( ret = ssl_parse_encrypted_pms( ssl, p, end, 2 ) ) != 0 )
         {
-            MBEDTLS_SSL_DEBUG_RET( 1, ( "ssl_parse_encrypted_pms" ), ret );
+            if( ret != MBEDTLS_ERR_SSL_WANT_ASYNC )
+                MBEDTLS_SSL_DEBUG_RET( 1, ( "ssl_parse_encrypted_pms" ), ret );
             return( ret );
         }
 
@@ -3482,7 +3562,8 @@ static int ssl_parse_client_key_exchange( mbedtls_ssl_context *ssl )
     {
         if( ( ret = ssl_parse_encrypted_pms( ssl, p, end, 0 ) ) != 0 )
         {
-            MBEDTLS_SSL_DEBUG_RET( 1, ( "ssl_parse_parse_encrypted_pms_secret" ), ret );
+            if( ret != MBEDTLS_ERR_SSL_WANT_ASYNC )
+                MBEDTLS_SSL_DEBUG_RET( 1, ( "ssl_parse_parse_encrypted_pms_secret" ), ret );
             return( ret );
         }
     }
@@ -3763,7 +3844,7 @@ static int ssl_write_new_session_ticket( mbedtls_ssl_context *ssl )
     if( ( ret = ssl->conf->f_ticket_write( ssl->conf->p_ticket,
                                 ssl->session_negotiate,
                                 ssl->out_msg + 10,
-                                ssl->out_msg + MBEDTLS_SSL_MAX_CONTENT_LEN,
+                                ssl->out_msg + MBEDTLS_SSL_OUT_CONTENT_LEN,
                                 &tlen, &lifetime ) ) != 0 )
     {
         MBEDTLS_SSL_DEBUG_RET( 1, "mbedtls_ssl_ticket_write", ret );
@@ -155,6 +155,269 @@ static unsigned int mfl_code_to_length[MBEDTLS_SSL_MAX_FRAG_LEN_INVALID] =
 };
 #endif /* MBEDTLS_SSL_MAX_FRAGMENT_LENGTH */
 
+/*
+ * Point the record layer into the start of the I/O buffers
+ */
+static void ssl_reset_in_out_pointers( mbedtls_ssl_context *ssl )
+{
+#if defined(MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH)
+    if( ssl->in_buf == NULL )
+    {
+        ssl->out_ctr = ssl->out_hdr = ssl->out_len = NULL;
+        ssl->out_iv = ssl->out_msg = NULL;
+        ssl->in_ctr = ssl->in_hdr = ssl->in_len = NULL;
+        ssl->in_iv = ssl->in_msg = ssl->in_offt = NULL;
+        return;
+    }
+#endif
+
+#if defined(MBEDTLS_SSL_PROTO_DTLS)
+    if( ssl->conf->transport == MBEDTLS_SSL_TRANSPORT_DATAGRAM )
+    {
+        ssl->out_hdr = ssl->out_buf;
+        ssl->out_ctr = ssl->out_buf +  3;
+        ssl->out_len = ssl->out_buf + 11;
+        ssl->out_iv  = ssl->out_buf + 13;
+        ssl->out_msg = ssl->out_buf + 13;
+
+        ssl->in_hdr = ssl->in_buf;
+        ssl->in_ctr = ssl->in_buf +  3;
+        ssl->in_len = ssl->in_buf + 11;
+        ssl->in_iv  = ssl->in_buf + 13;
+        ssl->in_msg = ssl->in_buf + 13;
+    }
+    else
+#endif
+    {
+        ssl->out_ctr = ssl->out_buf;
+        ssl->out_hdr = ssl->out_buf +  8;
+        ssl->out_len = ssl->out_buf + 11;
+        ssl->out_iv  = ssl->out_buf + 13;
+        ssl->out_msg = ssl->out_buf + 13;
+
+        ssl->in_ctr = ssl->in_buf;
+        ssl->in_hdr = ssl->in_buf +  8;
+        ssl->in_len = ssl->in_buf + 11;
+        ssl->in_iv  = ssl->in_buf + 13;
+        ssl->in_msg = ssl->in_buf + 13;
+    }
+}
+
+#if defined(MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH)
+/*
+ * Variable length I/O buffers
+ *
+ * The buffers are allocated at their maximum size by the first handshake
+ * step and shrink once the handshake is over, to the negotiated maximum
+ * fragment length for DTLS input, which must hold whole datagrams, and to
+ * SSL_MIN_CONTENT_LEN otherwise. From there they grow on demand, doubling
+ * their content space until the record at hand fits, up to the maximum.
+ * mbedtls_ssl_session_reset() releases them until the next handshake. An
+ * alert sent before the first handshake step allocates them at their
+ * smallest size.
+ */
+#define SSL_MIN_CONTENT_LEN     512     /* Smallest fragment length of RFC 6066 */
+
+static size_t ssl_grow_len( size_t cur_len, size_t len, size_t max_len )
+{
+    size_t new_len = cur_len;
+
+    while( new_len < len && new_len < max_len )
+        new_len = 2 * new_len - MBEDTLS_SSL_PAYLOAD_OVERHEAD;
+
+    return( new_len < max_len ? new_len : max_len );
+}
+
+static int ssl_resize_in_buf( mbedtls_ssl_context *ssl, size_t len )
+{
+    unsigned char *buf;
+
+    if( len == ssl->in_buf_len )
+        return( 0 );
+
+    if( ( buf = mbedtls_calloc( 1, len ) ) == NULL )
+    {
+        MBEDTLS_SSL_DEBUG_MSG( 1, ( "alloc(%d bytes) failed", len ) );
+        return( MBEDTLS_ERR_SSL_ALLOC_FAILED );
+    }
+
+    MBEDTLS_SSL_DEBUG_MSG( 3, ( "input buffer %d -> %d bytes",
+                                ssl->in_buf_len, len ) );
+
+    memcpy( buf, ssl->in_buf, len < ssl->in_buf_len ? len : ssl->in_buf_len );
+
+    ssl->in_ctr = buf + ( ssl->in_ctr - ssl->in_buf );
+    ssl->in_hdr = buf + ( ssl->in_hdr - ssl->in_buf );
+    ssl->in_len = buf + ( ssl->in_len - ssl->in_buf );
+    ssl->in_iv  = buf + ( ssl->in_iv  - ssl->in_buf );
+    ssl->in_msg = buf + ( ssl->in_msg - ssl->in_buf );
+    if( ssl->in_offt != NULL )
+        ssl->in_offt = buf + ( ssl->in_offt - ssl->in_buf );
+
+    mbedtls_zeroize( ssl->in_buf, ssl->in_buf_len );
+    mbedtls_free( ssl->in_buf );
+    ssl->in_buf = buf;
+    ssl->in_buf_len = len;
+
+    return( 0 );
+}
+
+static int ssl_resize_out_buf( mbedtls_ssl_context *ssl, size_t len )
+{
+    unsigned char *buf;
+
+    if( len == ssl->out_buf_len )
+        return( 0 );
+
+    if( ( buf = mbedtls_calloc( 1, len ) ) == NULL )
+    {
+        MBEDTLS_SSL_DEBUG_MSG( 1, ( "alloc(%d bytes) failed", len ) );
+        return( MBEDTLS_ERR_SSL_ALLOC_FAILED );
+    }
+
+    MBEDTLS_SSL_DEBUG_MSG( 3, ( "output buffer %d -> %d bytes",
+                                ssl->out_buf_len, len ) );
+
+    memcpy( buf, ssl->out_buf, len < ssl->out_buf_len ? len : ssl->out_buf_len );
+
+    ssl->out_ctr = buf + ( ssl->out_ctr - ssl->out_buf );
+    ssl->out_hdr = buf + ( ssl->out_hdr - ssl->out_buf );
+    ssl->out_len = buf + ( ssl->out_len - ssl->out_buf );
+    ssl->out_iv  = buf + ( ssl->out_iv  - ssl->out_buf );
+    ssl->out_msg = buf + ( ssl->out_msg - ssl->out_buf );
+
+    mbedtls_zeroize( ssl->out_buf, ssl->out_buf_len );
+    mbedtls_free( ssl->out_buf );
+    ssl->out_buf = buf;
+    ssl->out_buf_len = len;
+
+    return( 0 );
+}
+
+static void ssl_free_buffers( mbedtls_ssl_context *ssl )
+{
+    if( ssl->out_buf != NULL )
+    {
+        mbedtls_zeroize( ssl->out_buf, ssl->out_buf_len );
+        mbedtls_free( ssl->out_buf );
+        ssl->out_buf = NULL;
+        ssl->out_buf_len = 0;
+    }
+
+    if( ssl->in_buf != NULL )
+    {
+        mbedtls_zeroize( ssl->in_buf, ssl->in_buf_len );
+        mbedtls_free( ssl->in_buf );
+        ssl->in_buf = NULL;
+        ssl->in_buf_len = 0;
+    }
+
+    ssl_reset_in_out_pointers( ssl );
+}
+
+static int ssl_alloc_buffers( mbedtls_ssl_context *ssl,
+                              size_t in_len, size_t out_len )
+{
+    if( ( ssl->in_buf = mbedtls_calloc( 1, in_len ) ) == NULL ||
+        ( ssl->out_buf = mbedtls_calloc( 1, out_len ) ) == NULL )
+    {
+        MBEDTLS_SSL_DEBUG_MSG( 1, ( "alloc(%d + %d bytes) failed",
+                                    in_len, out_len ) );
+        mbedtls_free( ssl->in_buf );
+        ssl->in_buf = NULL;
+        return( MBEDTLS_ERR_SSL_ALLOC_FAILED );
+    }
+
+    ssl->in_buf_len = in_len;
+    ssl->out_buf_len = out_len;
+    ssl_reset_in_out_pointers( ssl );
+
+    return( 0 );
+}
+
+/*
+ * Allocate the buffers at their smallest size for records sent outside of
+ * a handshake, such as an alert before the first handshake step
+ */
+static int ssl_min_buffers( mbedtls_ssl_context *ssl )
+{
+    size_t in_len = SSL_MIN_CONTENT_LEN;
+    size_t out_len = SSL_MIN_CONTENT_LEN;
+
+    if( ssl->out_buf != NULL )
+        return( 0 );
+
+    if( in_len > MBEDTLS_SSL_IN_CONTENT_LEN )
+        in_len = MBEDTLS_SSL_IN_CONTENT_LEN;
+    if( out_len > MBEDTLS_SSL_OUT_CONTENT_LEN )
+        out_len = MBEDTLS_SSL_OUT_CONTENT_LEN;
+
+    return( ssl_alloc_buffers( ssl, in_len + MBEDTLS_SSL_PAYLOAD_OVERHEAD,
+                                    out_len + MBEDTLS_SSL_PAYLOAD_OVERHEAD ) );
+}
+
+/*
+ * Bring the buffers to their maximum size for a handshake
+ */
+static int ssl_handshake_buffers( mbedtls_ssl_context *ssl )
+{
+    int ret;
+
+    if( ssl->in_buf == NULL )
+        return( ssl_alloc_buffers( ssl, MBEDTLS_SSL_IN_BUFFER_LEN,
+                                        MBEDTLS_SSL_OUT_BUFFER_LEN ) );
+
+    if( ( ret = ssl_resize_in_buf( ssl, MBEDTLS_SSL_IN_BUFFER_LEN ) ) != 0 )
+        return( ret );
+
+    return( ssl_resize_out_buf( ssl, MBEDTLS_SSL_OUT_BUFFER_LEN ) );
+}
+
+/*
+ * Shrink the buffers once the handshake is over, keeping whatever they
+ * still hold. Failing to shrink is harmless, the buffers just stay larger.
+ */
+static void ssl_shrink_buffers( mbedtls_ssl_context *ssl )
+{
+    size_t in_len = SSL_MIN_CONTENT_LEN;
+    size_t out_len = SSL_MIN_CONTENT_LEN;
+    size_t used;
+
+#if defined(MBEDTLS_SSL_PROTO_DTLS)
+    if( ssl->conf->transport == MBEDTLS_SSL_TRANSPORT_DATAGRAM )
+    {
+        in_len = MBEDTLS_SSL_IN_CONTENT_LEN;
+#if defined(MBEDTLS_SSL_MAX_FRAGMENT_LENGTH)
+        if( mfl_code_to_length[ssl->session->mfl_code] < in_len )
+            in_len = mfl_code_to_length[ssl->session->mfl_code];
+#endif
+    }
+#endif
+
+    if( in_len > MBEDTLS_SSL_IN_CONTENT_LEN )
+        in_len = MBEDTLS_SSL_IN_CONTENT_LEN;
+    if( out_len > MBEDTLS_SSL_OUT_CONTENT_LEN )
+        out_len = MBEDTLS_SSL_OUT_CONTENT_LEN;
+
+    in_len += MBEDTLS_SSL_PAYLOAD_OVERHEAD;
+    out_len += MBEDTLS_SSL_PAYLOAD_OVERHEAD;
+
+    /* Records already read, or still being handed out to the application */
+    used = (size_t)( ssl->in_hdr - ssl->in_buf ) + ssl->in_left;
+    if( (size_t)( ssl->in_msg - ssl->in_buf ) + ssl->in_msglen > used )
+        used = (size_t)( ssl->in_msg - ssl->in_buf ) + ssl->in_msglen;
+    if( ssl->in_offt != NULL &&
+        (size_t)( ssl->in_offt - ssl->in_buf ) + ssl->in_msglen > used )
+        used = (size_t)( ssl->in_offt - ssl->in_buf ) + ssl->in_msglen;
+
+    if( used <= in_len && in_len < ssl->in_buf_len )
+        (void) ssl_resize_in_buf( ssl, in_len );
+
+    if( ssl->out_left == 0 && out_len < ssl->out_buf_len )
+        (void) ssl_resize_out_buf( ssl, out_len );
+}
+#endif /* MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH */
+
 #if defined(MBEDTLS_SSL_CLI_C)
 static int ssl_session_copy( mbedtls_ssl_session *dst, const mbedtls_ssl_session *src )
 {
@@ -1863,14 +2126,14 @@ static int ssl_decrypt_buf( mbedtls_ssl_context *ssl )
              * Padding is guaranteed to be incorrect if:
              *   1. padlen >= ssl->in_msglen
              *
-             *   2. padding_idx >= MBEDTLS_SSL_MAX_CONTENT_LEN +
+             *   2. padding_idx >= MBEDTLS_SSL_IN_CONTENT_LEN +
              *                     ssl->transform_in->maclen
              *
              * In both cases we reset padding_idx to a safe value (0) to
              * prevent out-of-buffer reads.
              */
             correct &= ( ssl->in_msglen >= padlen + 1 );
-            correct &= ( padding_idx < MBEDTLS_SSL_MAX_CONTENT_LEN +
+            correct &= ( padding_idx < MBEDTLS_SSL_IN_CONTENT_LEN +
                                        ssl->transform_in->maclen );
 
             padding_idx *= correct;
@@ -2067,6 +2330,8 @@ static int ssl_compress_buf( mbedtls_ssl_context *ssl )
     unsigned char *msg_post = ssl->out_msg;
     size_t len_pre = ssl->out_msglen;
     unsigned char *msg_pre = ssl->compress_buf;
+    size_t len_max = mbedtls_ssl_out_buf_len( ssl )
+                     - (size_t)( ssl->out_msg - ssl->out_buf );
 
     MBEDTLS_SSL_DEBUG_MSG( 2, ( "=> compress buf" ) );
 
@@ -2084,7 +2349,7 @@ static int ssl_compress_buf( mbedtls_ssl_context *ssl )
     ssl->transform_out->ctx_deflate.next_in = msg_pre;
     ssl->transform_out->ctx_deflate.avail_in = len_pre;
     ssl->transform_out->ctx_deflate.next_out = msg_post;
-    ssl->transform_out->ctx_deflate.avail_out = MBEDTLS_SSL_BUFFER_LEN;
+    ssl->transform_out->ctx_deflate.avail_out = len_max;
 
     ret = deflate( &ssl->transform_out->ctx_deflate, Z_SYNC_FLUSH );
     if( ret != Z_OK )
@@ -2093,7 +2358,7 @@ static int ssl_compress_buf( mbedtls_ssl_context *ssl )
         return( MBEDTLS_ERR_SSL_COMPRESSION_FAILED );
     }
 
-    ssl->out_msglen = MBEDTLS_SSL_BUFFER_LEN -
+    ssl->out_msglen = len_max -
                       ssl->transform_out->ctx_deflate.avail_out;
 
     MBEDTLS_SSL_DEBUG_MSG( 3, ( "after compression: msglen = %d, ",
@@ -2130,7 +2395,7 @@ static int ssl_decompress_buf( mbedtls_ssl_context *ssl )
     ssl->transform_in->ctx_inflate.next_in = msg_pre;
     ssl->transform_in->ctx_inflate.avail_in = len_pre;
     ssl->transform_in->ctx_inflate.next_out = msg_post;
-    ssl->transform_in->ctx_inflate.avail_out = MBEDTLS_SSL_MAX_CONTENT_LEN;
+    ssl->transform_in->ctx_inflate.avail_out = MBEDTLS_SSL_IN_CONTENT_LEN;
 
     ret = inflate( &ssl->transform_in->ctx_inflate, Z_SYNC_FLUSH );
     if( ret != Z_OK )
@@ -2139,7 +2404,7 @@ static int ssl_decompress_buf( mbedtls_ssl_context *ssl )
         return( MBEDTLS_ERR_SSL_COMPRESSION_FAILED );
     }
 
-    ssl->in_msglen = MBEDTLS_SSL_MAX_CONTENT_LEN -
+    ssl->in_msglen = MBEDTLS_SSL_IN_CONTENT_LEN -
                      ssl->transform_in->ctx_inflate.avail_out;
 
     MBEDTLS_SSL_DEBUG_MSG( 3, ( "after decompression: msglen = %d, ",
@@ -2214,7 +2479,21 @@ int mbedtls_ssl_fetch_input( mbedtls_ssl_context *ssl, size_t nb_want )
         return( MBEDTLS_ERR_SSL_BAD_INPUT_DATA );
     }
 
-    if( nb_want > MBEDTLS_SSL_BUFFER_LEN - (size_t)( ssl->in_hdr - ssl->in_buf ) )
+#if defined(MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH)
+    /* Datagrams are read whole, only stream transport can grow the buffer
+     * to the length of the record at hand */
+    if( ssl->conf->transport == MBEDTLS_SSL_TRANSPORT_STREAM &&
+        nb_want > ssl->in_buf_len - (size_t)( ssl->in_hdr - ssl->in_buf ) )
+    {
+        ret = ssl_resize_in_buf( ssl, ssl_grow_len( ssl->in_buf_len,
+                    (size_t)( ssl->in_hdr - ssl->in_buf ) + nb_want,
+                    MBEDTLS_SSL_IN_BUFFER_LEN ) );
+        if( ret != 0 )
+            return( ret );
+    }
+#endif
+
+    if( nb_want > mbedtls_ssl_in_buf_len( ssl ) - (size_t)( ssl->in_hdr - ssl->in_buf ) )
     {
         MBEDTLS_SSL_DEBUG_MSG( 1, ( "requesting more data than fits" ) );
         return( MBEDTLS_ERR_SSL_BAD_INPUT_DATA );
@@ -2297,7 +2576,7 @@ int mbedtls_ssl_fetch_input( mbedtls_ssl_context *ssl, size_t nb_want )
             ret = MBEDTLS_ERR_SSL_TIMEOUT;
         else
         {
-            len = MBEDTLS_SSL_BUFFER_LEN - ( ssl->in_hdr - ssl->in_buf );
+            len = mbedtls_ssl_in_buf_len( ssl ) - ( ssl->in_hdr - ssl->in_buf );
 
             if( ssl->state != MBEDTLS_SSL_HANDSHAKE_OVER )
                 timeout = ssl->handshake->retransmit_timeout;
@@ -2944,7 +3223,7 @@ static int ssl_reassemble_dtls_handshake( mbedtls_ssl_context *ssl )
         MBEDTLS_SSL_DEBUG_MSG( 2, ( "initialize reassembly, total length = %d",
                             msg_len ) );
 
-        if( ssl->in_hslen > MBEDTLS_SSL_MAX_CONTENT_LEN )
+        if( ssl->in_hslen > MBEDTLS_SSL_IN_CONTENT_LEN )
         {
             MBEDTLS_SSL_DEBUG_MSG( 1, ( "handshake message too large" ) );
             return( MBEDTLS_ERR_SSL_FEATURE_UNAVAILABLE );
@@ -3048,7 +3327,7 @@ static int ssl_reassemble_dtls_handshake( mbedtls_ssl_context *ssl )
         ssl->next_record_offset = new_remain - ssl->in_hdr;
         ssl->in_left = ssl->next_record_offset + remain_len;
 
-        if( ssl->in_left > MBEDTLS_SSL_BUFFER_LEN -
+        if( ssl->in_left > mbedtls_ssl_in_buf_len( ssl ) -
                            (size_t)( ssl->in_hdr - ssl->in_buf ) )
         {
             MBEDTLS_SSL_DEBUG_MSG( 1, ( "reassembled message too large for buffer" ) );
@@ -3422,7 +3701,7 @@ static int ssl_handle_possible_reconnect( mbedtls_ssl_context *ssl )
             ssl->conf->p_cookie,
             ssl->cli_id, ssl->cli_id_len,
             ssl->in_buf, ssl->in_left,
-            ssl->out_buf, MBEDTLS_SSL_MAX_CONTENT_LEN, &len );
+            ssl->out_buf, mbedtls_ssl_out_buf_len( ssl ), &len );
 
     MBEDTLS_SSL_DEBUG_RET( 2, "ssl_check_dtls_clihlo_cookie", ret );
 
@@ -3518,8 +3797,10 @@ static int ssl_parse_record_header( mbedtls_ssl_context *ssl )
         return( MBEDTLS_ERR_SSL_INVALID_RECORD );
     }
 
-    /* Check length against the size of our buffer */
-    if( ssl->in_msglen > MBEDTLS_SSL_BUFFER_LEN
+    /* Check length against the size of our buffer, which with stream
+     * transport grows to fit the record */
+    if( ssl->in_msglen > ( ssl->conf->transport == MBEDTLS_SSL_TRANSPORT_STREAM ?
+                           MBEDTLS_SSL_IN_BUFFER_LEN : mbedtls_ssl_in_buf_len( ssl ) )
                          - (size_t)( ssl->in_msg - ssl->in_buf ) )
     {
         MBEDTLS_SSL_DEBUG_MSG( 1, ( "bad message length" ) );
@@ -3530,7 +3811,7 @@ static int ssl_parse_record_header( mbedtls_ssl_context *ssl )
     if( ssl->transform_in == NULL )
     {
         if( ssl->in_msglen < 1 ||
-            ssl->in_msglen > MBEDTLS_SSL_MAX_CONTENT_LEN )
+            ssl->in_msglen > MBEDTLS_SSL_IN_CONTENT_LEN )
         {
             MBEDTLS_SSL_DEBUG_MSG( 1, ( "bad message length" ) );
             return( MBEDTLS_ERR_SSL_INVALID_RECORD );
@@ -3546,7 +3827,7 @@ static int ssl_parse_record_header( mbedtls_ssl_context *ssl )
 
 #if defined(MBEDTLS_SSL_PROTO_SSL3)
         if( ssl->minor_ver == MBEDTLS_SSL_MINOR_VERSION_0 &&
-            ssl->in_msglen > ssl->transform_in->minlen + MBEDTLS_SSL_MAX_CONTENT_LEN )
+            ssl->in_msglen > ssl->transform_in->minlen + MBEDTLS_SSL_IN_CONTENT_LEN )
         {
             MBEDTLS_SSL_DEBUG_MSG( 1, ( "bad message length" ) );
             return( MBEDTLS_ERR_SSL_INVALID_RECORD );
@@ -3559,7 +3840,7 @@ static int ssl_parse_record_header( mbedtls_ssl_context *ssl )
          */
         if( ssl->minor_ver >= MBEDTLS_SSL_MINOR_VERSION_1 &&
             ssl->in_msglen > ssl->transform_in->minlen +
-                             MBEDTLS_SSL_MAX_CONTENT_LEN + 256 )
+                             MBEDTLS_SSL_IN_CONTENT_LEN + 256 )
         {
             MBEDTLS_SSL_DEBUG_MSG( 1, ( "bad message length" ) );
             return( MBEDTLS_ERR_SSL_INVALID_RECORD );
@@ -3683,7 +3964,7 @@ static int ssl_prepare_record_content( mbedtls_ssl_context *ssl )
         MBEDTLS_SSL_DEBUG_BUF( 4, "input payload after decrypt",
                        ssl->in_msg, ssl->in_msglen );
 
-        if( ssl->in_msglen > MBEDTLS_SSL_MAX_CONTENT_LEN )
+        if( ssl->in_msglen > MBEDTLS_SSL_IN_CONTENT_LEN )
         {
             MBEDTLS_SSL_DEBUG_MSG( 1, ( "bad message length" ) );
             return( MBEDTLS_ERR_SSL_INVALID_RECORD );
@@ -4031,6 +4312,11 @@ int mbedtls_ssl_send_alert_message( mbedtls_ssl_context *ssl,
 
     MBEDTLS_SSL_DEBUG_MSG( 2, ( "=> send alert message" ) );
 
+#if defined(MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH)
+    if( ( ret = ssl_min_buffers( ssl ) ) != 0 )
+        return( ret );
+#endif
+
     ssl->out_msgtype = MBEDTLS_SSL_MSG_ALERT;
     ssl->out_msglen = 2;
     ssl->out_msg[0] = level;
@@ -4173,10 +4459,10 @@ int mbedtls_ssl_write_certificate( mbedtls_ssl_context *ssl )
     while( crt != NULL )
     {
         n = crt->raw.len;
-        if( n > MBEDTLS_SSL_MAX_CONTENT_LEN - 3 - i )
+        if( n > MBEDTLS_SSL_OUT_CONTENT_LEN - 3 - i )
         {
             MBEDTLS_SSL_DEBUG_MSG( 1, ( "certificate too large, %d > %d",
-                           i + 3 + n, MBEDTLS_SSL_MAX_CONTENT_LEN ) );
+                           i + 3 + n, MBEDTLS_SSL_OUT_CONTENT_LEN ) );
             return( MBEDTLS_ERR_SSL_CERTIFICATE_TOO_LARGE );
         }
 
@@ -4959,6 +5245,10 @@ static void ssl_handshake_wrapup_free_hs_transform( mbedtls_ssl_context *ssl )
     ssl->transform = ssl->transform_negotiate;
     ssl->transform_negotiate = NULL;
 
+#if defined(MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH)
+    ssl_shrink_buffers( ssl );
+#endif
+
     MBEDTLS_SSL_DEBUG_MSG( 3, ( "<= handshake wrapup: final free" ) );
 }
 
@@ -5281,6 +5571,28 @@ void mbedtls_ssl_session_init( mbedtls_ssl_session *session )
     memset( session, 0, sizeof(mbedtls_ssl_session) );
 }
 
+/*
+ * Tell the async callbacks that the operation they run is no longer wanted,
+ * before the handshake it belongs to goes away
+ */
+static void ssl_async_cancel( mbedtls_ssl_context *ssl )
+{
+#if defined(MBEDTLS_SSL_ASYNC_PRIVATE)
+    if( ssl->handshake->async_in_progress != 0 )
+    {
+        MBEDTLS_SSL_DEBUG_MSG( 2, ( "cancel asynchronous private key operation" ) );
+
+        if( ssl->conf->f_async_cancel != NULL )
+            ssl->conf->f_async_cancel( ssl );
+
+        ssl->handshake->async_in_progress = 0;
+        ssl->handshake->user_async_ctx = NULL;
+    }
+#else
+    ((void) ssl);
+#endif
+}
+
 static int ssl_handshake_init( mbedtls_ssl_context *ssl )
 {
     /* Clear old handshake information if present */
@@ -5289,7 +5601,10 @@ static int ssl_handshake_init( mbedtls_ssl_context *ssl )
     if( ssl->session_negotiate )
         mbedtls_ssl_session_free( ssl->session_negotiate );
     if( ssl->handshake )
+    {
+        ssl_async_cancel( ssl );
         mbedtls_ssl_handshake_free( ssl->handshake );
+    }
 
     /*
      * Either the pointers are now NULL or cleared properly and can be freed.
@@ -5394,52 +5709,26 @@ int mbedtls_ssl_setup( mbedtls_ssl_context *ssl,
                        const mbedtls_ssl_config *conf )
 {
     int ret;
-    const size_t len = MBEDTLS_SSL_BUFFER_LEN;
 
     ssl->conf = conf;
 
     /*
-     * Prepare base structures
+     * Prepare base structures, with MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH
+     * the buffers are left to the first handshake step
      */
-    if( ( ssl-> in_buf = mbedtls_calloc( 1, len ) ) == NULL ||
-        ( ssl->out_buf = mbedtls_calloc( 1, len ) ) == NULL )
+#if !defined(MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH)
+    if( ( ssl-> in_buf = mbedtls_calloc( 1, MBEDTLS_SSL_IN_BUFFER_LEN ) ) == NULL ||
+        ( ssl->out_buf = mbedtls_calloc( 1, MBEDTLS_SSL_OUT_BUFFER_LEN ) ) == NULL )
     {
-        MBEDTLS_SSL_DEBUG_MSG( 1, ( "alloc(%d bytes) failed", len ) );
+        MBEDTLS_SSL_DEBUG_MSG( 1, ( "alloc(%d + %d bytes) failed",
+                MBEDTLS_SSL_IN_BUFFER_LEN, MBEDTLS_SSL_OUT_BUFFER_LEN ) );
         mbedtls_free( ssl->in_buf );
         ssl->in_buf = NULL;
         return( MBEDTLS_ERR_SSL_ALLOC_FAILED );
     }
-
-#if defined(MBEDTLS_SSL_PROTO_DTLS)
-    if( conf->transport == MBEDTLS_SSL_TRANSPORT_DATAGRAM )
-    {
-        ssl->out_hdr = ssl->out_buf;
-        ssl->out_ctr = ssl->out_buf +  3;
-        ssl->out_len = ssl->out_buf + 11;
-        ssl->out_iv  = ssl->out_buf + 13;
-        ssl->out_msg = ssl->out_buf + 13;
-
-        ssl->in_hdr = ssl->in_buf;
-        ssl->in_ctr = ssl->in_buf +  3;
-        ssl->in_len = ssl->in_buf + 11;
-        ssl->in_iv  = ssl->in_buf + 13;
-        ssl->in_msg = ssl->in_buf + 13;
-    }
-    else
 #endif
-    {
-        ssl->out_ctr = ssl->out_buf;
-        ssl->out_hdr = ssl->out_buf +  8;
-        ssl->out_len = ssl->out_buf + 11;
-        ssl->out_iv  = ssl->out_buf + 13;
-        ssl->out_msg = ssl->out_buf + 13;
 
-        ssl->in_ctr = ssl->in_buf;
-        ssl->in_hdr = ssl->in_buf +  8;
-        ssl->in_len = ssl->in_buf + 11;
-        ssl->in_iv  = ssl->in_buf + 13;
-        ssl->in_msg = ssl->in_buf + 13;
-    }
+    ssl_reset_in_out_pointers( ssl );
 
     if( ( ret = ssl_handshake_init( ssl ) ) != 0 )
         return( ret );
@@ -5475,7 +5764,7 @@ static int ssl_session_reset_int( mbedtls_ssl_context *ssl, int partial )
 
     ssl->in_offt = NULL;
 
-    ssl->in_msg = ssl->in_buf + 13;
+    ssl_reset_in_out_pointers( ssl );
     ssl->in_msgtype = 0;
     ssl->in_msglen = 0;
     if( partial == 0 )
@@ -5492,7 +5781,6 @@ static int ssl_session_reset_int( mbedtls_ssl_context *ssl, int partial )
     ssl->nb_zero = 0;
     ssl->record_read = 0;
 
-    ssl->out_msg = ssl->out_buf + 13;
     ssl->out_msgtype = 0;
     ssl->out_msglen = 0;
     ssl->out_left = 0;
@@ -5504,9 +5792,17 @@ static int ssl_session_reset_int( mbedtls_ssl_context *ssl, int partial )
     ssl->transform_in = NULL;
     ssl->transform_out = NULL;
 
-    memset( ssl->out_buf, 0, MBEDTLS_SSL_BUFFER_LEN );
+#if defined(MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH)
+    /* Release the buffers until the next handshake step */
     if( partial == 0 )
-        memset( ssl->in_buf, 0, MBEDTLS_SSL_BUFFER_LEN );
+        ssl_free_buffers( ssl );
+    else
+#endif
+    {
+        memset( ssl->out_buf, 0, mbedtls_ssl_out_buf_len( ssl ) );
+        if( partial == 0 )
+            memset( ssl->in_buf, 0, mbedtls_ssl_in_buf_len( ssl ) );
+    }
 
 #if defined(MBEDTLS_SSL_HW_RECORD_ACCEL)
     if( mbedtls_ssl_hw_record_reset != NULL )
@@ -5831,7 +6127,7 @@ int mbedtls_ssl_conf_psk( mbedtls_ssl_config *conf,
 
     /* Identity len will be encoded on two bytes */
     if( ( psk_identity_len >> 16 ) != 0 ||
-        psk_identity_len > MBEDTLS_SSL_MAX_CONTENT_LEN )
+        psk_identity_len > MBEDTLS_SSL_OUT_CONTENT_LEN )
     {
         return( MBEDTLS_ERR_SSL_BAD_INPUT_DATA );
     }
@@ -6162,6 +6458,42 @@ void mbedtls_ssl_conf_export_keys_cb( mbedtls_ssl_config *conf,
 }
 #endif
 
+#if defined(MBEDTLS_SSL_ASYNC_PRIVATE)
+void mbedtls_ssl_conf_async_private_cb( mbedtls_ssl_config *conf,
+        mbedtls_ssl_async_sign_t *f_async_sign,
+        mbedtls_ssl_async_decrypt_t *f_async_decrypt,
+        mbedtls_ssl_async_resume_t *f_async_resume,
+        mbedtls_ssl_async_cancel_t *f_async_cancel,
+        void *config_data )
+{
+    conf->f_async_sign_start = f_async_sign;
+    conf->f_async_decrypt_start = f_async_decrypt;
+    conf->f_async_resume = f_async_resume;
+    conf->f_async_cancel = f_async_cancel;
+    conf->p_async_config_data = config_data;
+}
+
+void *mbedtls_ssl_conf_get_async_config_data( const mbedtls_ssl_config *conf )
+{
+    return( conf->p_async_config_data );
+}
+
+void *mbedtls_ssl_get_async_operation_data( const mbedtls_ssl_context *ssl )
+{
+    if( ssl->handshake == NULL )
+        return( NULL );
+
+    return( ssl->handshake->user_async_ctx );
+}
+
+void mbedtls_ssl_set_async_operation_data( mbedtls_ssl_context *ssl,
+                                           void *ctx )
+{
+    if( ssl->handshake != NULL )
+        ssl->handshake->user_async_ctx = ctx;
+}
+#endif /* MBEDTLS_SSL_ASYNC_PRIVATE */
+
 /*
  * SSL get accessors
  */
@@ -6264,12 +6596,13 @@ int mbedtls_ssl_get_record_expansion( const mbedtls_ssl_context *ssl )
 #if defined(MBEDTLS_SSL_MAX_FRAGMENT_LENGTH)
 size_t mbedtls_ssl_get_max_frag_len( const mbedtls_ssl_context *ssl )
 {
-    size_t max_len;
+    size_t max_len = MBEDTLS_SSL_OUT_CONTENT_LEN;
 
     /*
      * Assume mfl_code is correct since it was checked when set
      */
-    max_len = mfl_code_to_length[ssl->conf->mfl_code];
+    if( mfl_code_to_length[ssl->conf->mfl_code] < max_len )
+        max_len = mfl_code_to_length[ssl->conf->mfl_code];
 
     /*
      * Check if a smaller max length was negotiated
@@ -6319,6 +6652,11 @@ int mbedtls_ssl_handshake_step( mbedtls_ssl_context *ssl )
     if( ssl == NULL || ssl->conf == NULL )
         return( MBEDTLS_ERR_SSL_BAD_INPUT_DATA );
 
+#if defined(MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH)
+    if( ( ret = ssl_handshake_buffers( ssl ) ) != 0 )
+        return( ret );
+#endif
+
 #if defined(MBEDTLS_SSL_CLI_C)
     if( ssl->conf->endpoint == MBEDTLS_SSL_IS_CLIENT )
         ret = mbedtls_ssl_handshake_client_step( ssl );
@@ -6782,6 +7120,9 @@ static int ssl_write_real( mbedtls_ssl_context *ssl,
     int ret;
 #if defined(MBEDTLS_SSL_MAX_FRAGMENT_LENGTH)
     size_t max_len = mbedtls_ssl_get_max_frag_len( ssl );
+#else
+    size_t max_len = MBEDTLS_SSL_OUT_CONTENT_LEN;
+#endif
 
     if( len > max_len )
     {
@@ -6797,7 +7138,6 @@ static int ssl_write_real( mbedtls_ssl_context *ssl,
 #endif
             len = max_len;
     }
-#endif /* MBEDTLS_SSL_MAX_FRAGMENT_LENGTH */
 
     if( ssl->out_left != 0 )
     {
@@ -6809,6 +7149,21 @@ static int ssl_write_real( mbedtls_ssl_context *ssl,
     }
     else
     {
+#if defined(MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH)
+        if( len + MBEDTLS_SSL_PAYLOAD_OVERHEAD > ssl->out_buf_len &&
+            ssl_resize_out_buf( ssl, ssl_grow_len( ssl->out_buf_len,
+                        len + MBEDTLS_SSL_PAYLOAD_OVERHEAD,
+                        MBEDTLS_SSL_OUT_BUFFER_LEN ) ) != 0 )
+        {
+            /* Send what fits, unless that would split a datagram */
+#if defined(MBEDTLS_SSL_PROTO_DTLS)
+            if( ssl->conf->transport == MBEDTLS_SSL_TRANSPORT_DATAGRAM )
+                return( MBEDTLS_ERR_SSL_ALLOC_FAILED );
+#endif
+            len = ssl->out_buf_len - MBEDTLS_SSL_PAYLOAD_OVERHEAD;
+        }
+#endif
+
         ssl->out_msglen  = len;
         ssl->out_msgtype = MBEDTLS_SSL_MSG_APPLICATION_DATA;
         memcpy( ssl->out_msg, buf, len );
@@ -7073,13 +7428,13 @@ void mbedtls_ssl_free( mbedtls_ssl_context *ssl )
 
     if( ssl->out_buf != NULL )
     {
-        mbedtls_zeroize( ssl->out_buf, MBEDTLS_SSL_BUFFER_LEN );
+        mbedtls_zeroize( ssl->out_buf, mbedtls_ssl_out_buf_len( ssl ) );
         mbedtls_free( ssl->out_buf );
     }
 
     if( ssl->in_buf != NULL )
     {
-        mbedtls_zeroize( ssl->in_buf, MBEDTLS_SSL_BUFFER_LEN );
+        mbedtls_zeroize( ssl->in_buf, mbedtls_ssl_in_buf_len( ssl ) );
         mbedtls_free( ssl->in_buf );
     }
 
@@ -7099,6 +7454,7 @@ void mbedtls_ssl_free( mbedtls_ssl_context *ssl )
 
     if( ssl->handshake )
     {
+        ssl_async_cancel( ssl );
         mbedtls_ssl_handshake_free( ssl->handshake );
         mbedtls_ssl_transform_free( ssl->transform_negotiate );
         mbedtls_ssl_session_free( ssl->session_negotiate );
@@ -7511,6 +7867,99 @@ int mbedtls_ssl_check_sig_hash( const mbedtls_ssl_context *ssl,
 #endif /* MBEDTLS_KEY_EXCHANGE__WITH_CERT__ENABLED */
 
 #if defined(MBEDTLS_X509_CRT_PARSE_C)
+#if defined(MBEDTLS_SSL_ASYNC_PRIVATE)
+/*
+ * Collect the result of the operation in progress, and forget about it
+ * once it is done, whether it succeeded or not
+ */
+int mbedtls_ssl_async_resume( mbedtls_ssl_context *ssl,
+                              unsigned char *output, size_t *output_len,
+                              size_t output_size )
+{
+    int ret;
+
+    ret = ssl->conf->f_async_resume( ssl, output, output_len, output_size );
+    if( ret != MBEDTLS_ERR_SSL_WANT_ASYNC )
+    {
+        ssl->handshake->async_in_progress = 0;
+        ssl->handshake->user_async_ctx = NULL;
+    }
+
+    return( ret );
+}
+
+/*
+ * Follow up on a start callback: collect the result right away, or leave
+ * the operation in progress for the next call of the handshake
+ */
+static int ssl_async_started( mbedtls_ssl_context *ssl, int ret,
+                              unsigned char *output, size_t *output_len,
+                              size_t output_size )
+{
+    if( ret != 0 && ret != MBEDTLS_ERR_SSL_WANT_ASYNC )
+        return( ret );
+
+    ssl->handshake->async_in_progress = 1;
+
+    if( ret == MBEDTLS_ERR_SSL_WANT_ASYNC )
+    {
+        MBEDTLS_SSL_DEBUG_MSG( 2, ( "asynchronous private key operation in progress" ) );
+        return( ret );
+    }
+
+    return( mbedtls_ssl_async_resume( ssl, output, output_len, output_size ) );
+}
+#endif /* MBEDTLS_SSL_ASYNC_PRIVATE */
+
+int mbedtls_ssl_own_key_sign( mbedtls_ssl_context *ssl,
+                              mbedtls_md_type_t md_alg,
+                              const unsigned char *hash, size_t hash_len,
+                              unsigned char *sig, size_t *sig_len,
+                              size_t sig_size )
+{
+#if defined(MBEDTLS_SSL_ASYNC_PRIVATE)
+    if( ssl->conf->f_async_sign_start != NULL )
+    {
+        int ret;
+
+        /* Callbacks always get the length, as mbedtls_pk_sign() works out */
+        if( hash_len == 0 )
+            hash_len = mbedtls_md_get_size( mbedtls_md_info_from_type( md_alg ) );
+
+        ret = ssl->conf->f_async_sign_start( ssl, mbedtls_ssl_own_cert( ssl ),
+                                             md_alg, hash, hash_len );
+        if( ret != MBEDTLS_ERR_SSL_HW_ACCEL_FALLTHROUGH )
+            return( ssl_async_started( ssl, ret, sig, sig_len, sig_size ) );
+    }
+#endif /* MBEDTLS_SSL_ASYNC_PRIVATE */
+
+    ((void) sig_size);
+    return( mbedtls_pk_sign( mbedtls_ssl_own_key( ssl ), md_alg, hash, hash_len,
+                             sig, sig_len, ssl->conf->f_rng, ssl->conf->p_rng ) );
+}
+
+int mbedtls_ssl_own_key_decrypt( mbedtls_ssl_context *ssl,
+                                 const unsigned char *input, size_t ilen,
+                                 unsigned char *output, size_t *olen,
+                                 size_t osize )
+{
+#if defined(MBEDTLS_SSL_ASYNC_PRIVATE)
+    if( ssl->conf->f_async_decrypt_start != NULL )
+    {
+        int ret;
+
+        ret = ssl->conf->f_async_decrypt_start( ssl, mbedtls_ssl_own_cert( ssl ),
+                                                input, ilen );
+        if( ret != MBEDTLS_ERR_SSL_HW_ACCEL_FALLTHROUGH )
+            return( ssl_async_started( ssl, ret, output, olen, osize ) );
+    }
+#endif /* MBEDTLS_SSL_ASYNC_PRIVATE */
+
+    return( mbedtls_pk_decrypt( mbedtls_ssl_own_key( ssl ), input, ilen,
+                                output, olen, osize,
+                                ssl->conf->f_rng, ssl->conf->p_rng ) );
+}
+
 int mbedtls_ssl_check_cert_usage( const mbedtls_x509_crt *cert,
                           const mbedtls_ssl_ciphersuite_t *ciphersuite,
                           int cert_endpoint,
@@ -198,6 +198,15 @@ static const char *features[] = {
 #if defined(MBEDTLS_AES_ROM_TABLES)
     "MBEDTLS_AES_ROM_TABLES",
 #endif /* MBEDTLS_AES_ROM_TABLES */
+#if defined(MBEDTLS_AES_CTR_BLOCKS)
+    "MBEDTLS_AES_CTR_BLOCKS",
+#endif /* MBEDTLS_AES_CTR_BLOCKS */
+#if defined(MBEDTLS_GCM_GHASH_TABLE8)
+    "MBEDTLS_GCM_GHASH_TABLE8",
+#endif /* MBEDTLS_GCM_GHASH_TABLE8 */
+#if defined(MBEDTLS_GCM_GHASH_CT)
+    "MBEDTLS_GCM_GHASH_CT",
+#endif /* MBEDTLS_GCM_GHASH_CT */
 #if defined(MBEDTLS_CAMELLIA_SMALL_MEMORY)
     "MBEDTLS_CAMELLIA_SMALL_MEMORY",
 #endif /* MBEDTLS_CAMELLIA_SMALL_MEMORY */
@@ -270,6 +279,9 @@ static const char *features[] = {
 #if defined(MBEDTLS_ECP_NIST_OPTIM)
     "MBEDTLS_ECP_NIST_OPTIM",
 #endif /* MBEDTLS_ECP_NIST_OPTIM */
+#if defined(MBEDTLS_ECP_FIXED_POINT_TABLES)
+    "MBEDTLS_ECP_FIXED_POINT_TABLES",
+#endif /* MBEDTLS_ECP_FIXED_POINT_TABLES */
 #if defined(MBEDTLS_ECDSA_DETERMINISTIC)
     "MBEDTLS_ECDSA_DETERMINISTIC",
 #endif /* MBEDTLS_ECDSA_DETERMINISTIC */
@@ -336,6 +348,9 @@ static const char *features[] = {
 #if defined(MBEDTLS_MEMORY_BACKTRACE)
     "MBEDTLS_MEMORY_BACKTRACE",
 #endif /* MBEDTLS_MEMORY_BACKTRACE */
+#if defined(MBEDTLS_MEMORY_BUFFER_ALLOC_SLABS)
+    "MBEDTLS_MEMORY_BUFFER_ALLOC_SLABS",
+#endif /* MBEDTLS_MEMORY_BUFFER_ALLOC_SLABS */
 #if defined(MBEDTLS_PK_RSA_ALT_SUPPORT)
     "MBEDTLS_PK_RSA_ALT_SUPPORT",
 #endif /* MBEDTLS_PK_RSA_ALT_SUPPORT */
@@ -357,6 +372,9 @@ static const char *features[] = {
 #if defined(MBEDTLS_SSL_ALL_ALERT_MESSAGES)
     "MBEDTLS_SSL_ALL_ALERT_MESSAGES",
 #endif /* MBEDTLS_SSL_ALL_ALERT_MESSAGES */
+#if defined(MBEDTLS_SSL_ASYNC_PRIVATE)
+    "MBEDTLS_SSL_ASYNC_PRIVATE",
+#endif /* MBEDTLS_SSL_ASYNC_PRIVATE */
 #if defined(MBEDTLS_SSL_DEBUG_ALL)
     "MBEDTLS_SSL_DEBUG_ALL",
 #endif /* MBEDTLS_SSL_DEBUG_ALL */
@@ -384,6 +402,9 @@ static const char *features[] = {
 #if defined(MBEDTLS_SSL_SRV_RESPECT_CLIENT_PREFERENCE)
     "MBEDTLS_SSL_SRV_RESPECT_CLIENT_PREFERENCE",
 #endif /* MBEDTLS_SSL_SRV_RESPECT_CLIENT_PREFERENCE */
+#if defined(MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH)
+    "MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH",
+#endif /* MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH */
 #if defined(MBEDTLS_SSL_MAX_FRAGMENT_LENGTH)
     "MBEDTLS_SSL_MAX_FRAGMENT_LENGTH",
 #endif /* MBEDTLS_SSL_MAX_FRAGMENT_LENGTH */
@@ -453,6 +474,9 @@ static const char *features[] = {
 #if defined(MBEDTLS_X509_RSASSA_PSS_SUPPORT)
     "MBEDTLS_X509_RSASSA_PSS_SUPPORT",
 #endif /* MBEDTLS_X509_RSASSA_PSS_SUPPORT */
+#if defined(MBEDTLS_X509_CRT_LAZY_EXTENSIONS)
+    "MBEDTLS_X509_CRT_LAZY_EXTENSIONS",
+#endif /* MBEDTLS_X509_CRT_LAZY_EXTENSIONS */
 #if defined(MBEDTLS_ZLIB_SUPPORT)
     "MBEDTLS_ZLIB_SUPPORT",
 #endif /* MBEDTLS_ZLIB_SUPPORT */
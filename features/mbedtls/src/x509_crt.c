@@ -402,7 +402,35 @@ static int x509_get_ext_key_usage( unsigned char **p,
                                mbedtls_x509_sequence *ext_key_usage)
 {
     int ret;
+#if defined(MBEDTLS_X509_CRT_LAZY_EXTENSIONS)
+    size_t len;
+
+    if( ( ret = mbedtls_asn1_get_tag( p, end, &len,
+            MBEDTLS_ASN1_CONSTRUCTED | MBEDTLS_ASN1_SEQUENCE ) ) != 0 )
+        return( MBEDTLS_ERR_X509_INVALID_EXTENSIONS + ret );
+
+    if( *p + len != end )
+        return( MBEDTLS_ERR_X509_INVALID_EXTENSIONS +
+                MBEDTLS_ERR_ASN1_LENGTH_MISMATCH );
+
+    /* Keep the whole sequence, walked by x509_seq_next() */
+    ext_key_usage->buf.tag = MBEDTLS_ASN1_CONSTRUCTED | MBEDTLS_ASN1_SEQUENCE;
+    ext_key_usage->buf.p = *p;
+    ext_key_usage->buf.len = len;
+
+    while( *p < end )
+    {
+        if( ( ret = mbedtls_asn1_get_tag( p, end, &len, MBEDTLS_ASN1_OID ) ) != 0 )
+            return( MBEDTLS_ERR_X509_INVALID_EXTENSIONS + ret );
 
+        *p += len;
+    }
+
+    /* Sequence length must be >= 1 */
+    if( ext_key_usage->buf.len == 0 )
+        return( MBEDTLS_ERR_X509_INVALID_EXTENSIONS +
+                MBEDTLS_ERR_ASN1_INVALID_LENGTH );
+#else
     if( ( ret = mbedtls_asn1_get_sequence_of( p, end, ext_key_usage, MBEDTLS_ASN1_OID ) ) != 0 )
         return( MBEDTLS_ERR_X509_INVALID_EXTENSIONS + ret );
 
@@ -410,6 +438,7 @@ static int x509_get_ext_key_usage( unsigned char **p,
     if( ext_key_usage->buf.p == NULL )
         return( MBEDTLS_ERR_X509_INVALID_EXTENSIONS +
                 MBEDTLS_ERR_ASN1_INVALID_LENGTH );
+#endif /* MBEDTLS_X509_CRT_LAZY_EXTENSIONS */
 
     return( 0 );
 }
@@ -446,9 +475,11 @@ static int x509_get_subject_alt_name( unsigned char **p,
 {
     int ret;
     size_t len, tag_len;
-    mbedtls_asn1_buf *buf;
     unsigned char tag;
+#if !defined(MBEDTLS_X509_CRT_LAZY_EXTENSIONS)
+    mbedtls_asn1_buf *buf;
     mbedtls_asn1_sequence *cur = subject_alt_name;
+#endif
 
     /* Get main sequence tag */
     if( ( ret = mbedtls_asn1_get_tag( p, end, &len,
@@ -459,6 +490,13 @@ static int x509_get_subject_alt_name( unsigned char **p,
         return( MBEDTLS_ERR_X509_INVALID_EXTENSIONS +
                 MBEDTLS_ERR_ASN1_LENGTH_MISMATCH );
 
+#if defined(MBEDTLS_X509_CRT_LAZY_EXTENSIONS)
+    /* Keep the whole sequence, walked by x509_seq_next() */
+    subject_alt_name->buf.tag = MBEDTLS_ASN1_CONSTRUCTED | MBEDTLS_ASN1_SEQUENCE;
+    subject_alt_name->buf.p = *p;
+    subject_alt_name->buf.len = len;
+#endif
+
     while( *p < end )
     {
         if( ( end - *p ) < 1 )
@@ -481,6 +519,9 @@ static int x509_get_subject_alt_name( unsigned char **p,
             continue;
         }
 
+#if defined(MBEDTLS_X509_CRT_LAZY_EXTENSIONS)
+        *p += tag_len;
+#else
         /* Allocate and assign next pointer */
         if( cur->buf.p != NULL )
         {
@@ -501,10 +542,13 @@ static int x509_get_subject_alt_name( unsigned char **p,
         buf->p = *p;
         buf->len = tag_len;
         *p += buf->len;
+#endif /* MBEDTLS_X509_CRT_LAZY_EXTENSIONS */
     }
 
+#if !defined(MBEDTLS_X509_CRT_LAZY_EXTENSIONS)
     /* Set final sequence entry's next pointer to NULL */
     cur->next = NULL;
+#endif
 
     if( *p != end )
         return( MBEDTLS_ERR_X509_INVALID_EXTENSIONS +
@@ -513,6 +557,73 @@ static int x509_get_subject_alt_name( unsigned char **p,
     return( 0 );
 }
 
+/*
+ * Walks the dNSNames of subjectAltName or the OIDs of extKeyUsage. With
+ * MBEDTLS_X509_CRT_LAZY_EXTENSIONS, the list has a single element holding
+ * the whole extension, checked when the certificate was parsed, and the
+ * names are decoded here as they are needed.
+ */
+typedef struct
+{
+#if defined(MBEDTLS_X509_CRT_LAZY_EXTENSIONS)
+    unsigned char *p;
+    const unsigned char *end;
+    unsigned char tag;
+    mbedtls_x509_buf buf;
+#else
+    const mbedtls_x509_sequence *cur;
+#endif
+}
+x509_seq_iter;
+
+static void x509_seq_init( x509_seq_iter *it, const mbedtls_x509_sequence *seq,
+                           unsigned char tag )
+{
+#if defined(MBEDTLS_X509_CRT_LAZY_EXTENSIONS)
+    it->p = seq->buf.p;
+    it->end = seq->buf.p == NULL ? NULL : seq->buf.p + seq->buf.len;
+    it->tag = tag;
+#else
+    ((void) tag);
+    it->cur = seq;
+#endif
+}
+
+static const mbedtls_x509_buf *x509_seq_next( x509_seq_iter *it )
+{
+#if defined(MBEDTLS_X509_CRT_LAZY_EXTENSIONS)
+    size_t len;
+    unsigned char tag;
+
+    while( it->p != NULL && it->p < it->end )
+    {
+        tag = *it->p++;
+        if( mbedtls_asn1_get_len( &it->p, it->end, &len ) != 0 )
+            return( NULL );
+
+        it->buf.tag = tag;
+        it->buf.p = it->p;
+        it->buf.len = len;
+        it->p += len;
+
+        if( tag == it->tag )
+            return( &it->buf );
+    }
+#else
+    const mbedtls_x509_sequence *cur;
+
+    while( ( cur = it->cur ) != NULL )
+    {
+        it->cur = cur->next;
+
+        if( cur->buf.p != NULL )
+            return( &cur->buf );
+    }
+#endif /* MBEDTLS_X509_CRT_LAZY_EXTENSIONS */
+
+    return( NULL );
+}
+
 /*
  * X.509 v3 extensions
  *
@@ -660,7 +771,7 @@ static int x509_get_crt_ext( unsigned char **p,
  * Parse and fill a single X.509 certificate in DER format
  */
 static int x509_crt_parse_der_core( mbedtls_x509_crt *crt, const unsigned char *buf,
-                                    size_t buflen )
+                                    size_t buflen, int make_copy )
 {
     int ret;
     size_t len;
@@ -703,17 +814,28 @@ static int x509_crt_parse_der_core( mbedtls_x509_crt *crt, const unsigned char *
     }
     crt_end = p + len;
 
-    // Create and populate a new buffer for the raw field
     crt->raw.len = crt_end - buf;
-    crt->raw.p = p = mbedtls_calloc( 1, crt->raw.len );
-    if( p == NULL )
-        return( MBEDTLS_ERR_X509_ALLOC_FAILED );
 
-    memcpy( p, buf, crt->raw.len );
+    if( make_copy != 0 )
+    {
+        // Create and populate a new buffer for the raw field
+        crt->raw.p = p = mbedtls_calloc( 1, crt->raw.len );
+        if( p == NULL )
+            return( MBEDTLS_ERR_X509_ALLOC_FAILED );
 
-    // Direct pointers to the new buffer 
-    p += crt->raw.len - len;
-    end = crt_end = p + len;
+        memcpy( p, buf, crt->raw.len );
+        crt->own_buffer = 1;
+
+        // Direct pointers to the new buffer
+        p += crt->raw.len - len;
+        end = crt_end = p + len;
+    }
+    else
+    {
+        // Point into the caller's buffer, which outlives the certificate
+        crt->raw.p = (unsigned char *) buf;
+        crt->own_buffer = 0;
+    }
 
     /*
      * TBSCertificate  ::=  SEQUENCE  {
@@ -914,10 +1036,11 @@ static int x509_crt_parse_der_core( mbedtls_x509_crt *crt, const unsigned char *
 
 /*
  * Parse one X.509 certificate in DER format from a buffer and add them to a
- * chained list
+ * chained list, with or without a copy of the buffer
  */
-int mbedtls_x509_crt_parse_der( mbedtls_x509_crt *chain, const unsigned char *buf,
-                        size_t buflen )
+static int x509_crt_parse_der_internal( mbedtls_x509_crt *chain,
+                                        const unsigned char *buf,
+                                        size_t buflen, int make_copy )
 {
     int ret;
     mbedtls_x509_crt *crt = chain, *prev = NULL;
@@ -949,7 +1072,7 @@ int mbedtls_x509_crt_parse_der( mbedtls_x509_crt *chain, const unsigned char *bu
         crt = crt->next;
     }
 
-    if( ( ret = x509_crt_parse_der_core( crt, buf, buflen ) ) != 0 )
+    if( ( ret = x509_crt_parse_der_core( crt, buf, buflen, make_copy ) ) != 0 )
     {
         if( prev )
             prev->next = NULL;
@@ -963,6 +1086,19 @@ int mbedtls_x509_crt_parse_der( mbedtls_x509_crt *chain, const unsigned char *bu
     return( 0 );
 }
 
+int mbedtls_x509_crt_parse_der( mbedtls_x509_crt *chain, const unsigned char *buf,
+                        size_t buflen )
+{
+    return( x509_crt_parse_der_internal( chain, buf, buflen, 1 ) );
+}
+
+int mbedtls_x509_crt_parse_der_nocopy( mbedtls_x509_crt *chain,
+                                       const unsigned char *buf,
+                                       size_t buflen )
+{
+    return( x509_crt_parse_der_internal( chain, buf, buflen, 0 ) );
+}
+
 /*
  * Parse one or more PEM certificates from a buffer and add them to the chained
  * list
@@ -1225,28 +1361,29 @@ static int x509_info_subject_alt_name( char **buf, size_t *size,
     size_t i;
     size_t n = *size;
     char *p = *buf;
-    const mbedtls_x509_sequence *cur = subject_alt_name;
+    x509_seq_iter it;
+    const mbedtls_x509_buf *name;
     const char *sep = "";
     size_t sep_len = 0;
 
-    while( cur != NULL )
+    x509_seq_init( &it, subject_alt_name, MBEDTLS_ASN1_CONTEXT_SPECIFIC | 2 );
+
+    while( ( name = x509_seq_next( &it ) ) != NULL )
     {
-        if( cur->buf.len + sep_len >= n )
+        if( name->len + sep_len >= n )
         {
             *p = '\0';
             return( MBEDTLS_ERR_X509_BUFFER_TOO_SMALL );
         }
 
-        n -= cur->buf.len + sep_len;
+        n -= name->len + sep_len;
         for( i = 0; i < sep_len; i++ )
             *p++ = sep[i];
-        for( i = 0; i < cur->buf.len; i++ )
-            *p++ = cur->buf.p[i];
+        for( i = 0; i < name->len; i++ )
+            *p++ = name->p[i];
 
         sep = ", ";
         sep_len = 2;
-
-        cur = cur->next;
     }
 
     *p = '\0';
@@ -1326,20 +1463,21 @@ static int x509_info_ext_key_usage( char **buf, size_t *size,
     const char *desc;
     size_t n = *size;
     char *p = *buf;
-    const mbedtls_x509_sequence *cur = extended_key_usage;
+    x509_seq_iter it;
+    const mbedtls_x509_buf *oid;
     const char *sep = "";
 
-    while( cur != NULL )
+    x509_seq_init( &it, extended_key_usage, MBEDTLS_ASN1_OID );
+
+    while( ( oid = x509_seq_next( &it ) ) != NULL )
     {
-        if( mbedtls_oid_get_extended_key_usage( &cur->buf, &desc ) != 0 )
+        if( mbedtls_oid_get_extended_key_usage( oid, &desc ) != 0 )
             desc = "???";
 
         ret = mbedtls_snprintf( p, n, "%s%s", sep, desc );
         MBEDTLS_X509_SAFE_SNPRINTF;
 
         sep = ", ";
-
-        cur = cur->next;
     }
 
     *size = n;
@@ -1572,7 +1710,8 @@ int mbedtls_x509_crt_check_extended_key_usage( const mbedtls_x509_crt *crt,
                                        const char *usage_oid,
                                        size_t usage_len )
 {
-    const mbedtls_x509_sequence *cur;
+    x509_seq_iter it;
+    const mbedtls_x509_buf *cur_oid;
 
     /* Extension is not mandatory, absent means no restriction */
     if( ( crt->ext_types & MBEDTLS_X509_EXT_EXTENDED_KEY_USAGE ) == 0 )
@@ -1581,10 +1720,10 @@ int mbedtls_x509_crt_check_extended_key_usage( const mbedtls_x509_crt *crt,
     /*
      * Look for the requested usage (or wildcard ANY) in our list
      */
-    for( cur = &crt->ext_key_usage; cur != NULL; cur = cur->next )
-    {
-        const mbedtls_x509_buf *cur_oid = &cur->buf;
+    x509_seq_init( &it, &crt->ext_key_usage, MBEDTLS_ASN1_OID );
 
+    while( ( cur_oid = x509_seq_next( &it ) ) != NULL )
+    {
         if( cur_oid->len == usage_len &&
             memcmp( cur_oid->p, usage_oid, usage_len ) == 0 )
         {
@@ -1748,7 +1887,7 @@ static int x509_memcasecmp( const void *s1, const void *s2, size_t len )
 /*
  * Return 0 if name matches wildcard, -1 otherwise
  */
-static int x509_check_wildcard( const char *cn, mbedtls_x509_buf *name )
+static int x509_check_wildcard( const char *cn, const mbedtls_x509_buf *name )
 {
     size_t i;
     size_t cn_idx = 0, cn_len = strlen( cn );
@@ -2197,7 +2336,8 @@ int mbedtls_x509_crt_verify_with_profile( mbedtls_x509_crt *crt,
     int pathlen = 0, selfsigned = 0;
     mbedtls_x509_crt *parent;
     mbedtls_x509_name *name;
-    mbedtls_x509_sequence *cur = NULL;
+    x509_seq_iter it;
+    const mbedtls_x509_buf *san;
     mbedtls_pk_type_t pk_type;
 
     if( profile == NULL )
@@ -2212,25 +2352,24 @@ int mbedtls_x509_crt_verify_with_profile( mbedtls_x509_crt *crt,
 
         if( crt->ext_types & MBEDTLS_X509_EXT_SUBJECT_ALT_NAME )
         {
-            cur = &crt->subject_alt_names;
+            x509_seq_init( &it, &crt->subject_alt_names,
+                           MBEDTLS_ASN1_CONTEXT_SPECIFIC | 2 );
 
-            while( cur != NULL )
+            while( ( san = x509_seq_next( &it ) ) != NULL )
             {
-                if( cur->buf.len == cn_len &&
-                    x509_memcasecmp( cn, cur->buf.p, cn_len ) == 0 )
+                if( san->len == cn_len &&
+                    x509_memcasecmp( cn, san->p, cn_len ) == 0 )
                     break;
 
-                if( cur->buf.len > 2 &&
-                    memcmp( cur->buf.p, "*.", 2 ) == 0 &&
-                    x509_check_wildcard( cn, &cur->buf ) == 0 )
+                if( san->len > 2 &&
+                    memcmp( san->p, "*.", 2 ) == 0 &&
+                    x509_check_wildcard( cn, san ) == 0 )
                 {
                     break;
                 }
-
-                cur = cur->next;
             }
 
-            if( cur == NULL )
+            if( san == NULL )
                 *flags |= MBEDTLS_X509_BADCERT_CN_MISMATCH;
         }
         else
@@ -2377,7 +2516,7 @@ void mbedtls_x509_crt_free( mbedtls_x509_crt *crt )
             mbedtls_free( seq_prv );
         }
 
-        if( cert_cur->raw.p != NULL )
+        if( cert_cur->raw.p != NULL && cert_cur->own_buffer )
         {
             mbedtls_zeroize( cert_cur->raw.p, cert_cur->raw.len );
             mbedtls_free( cert_cur->raw.p );
@@ -35,6 +35,7 @@
 #define TRACE_GROUP "nsif"
 
 #define NS_INTERFACE_SOCKETS_MAX  16  //same as NanoStack SOCKET_MAX
+#define NS_INTERFACE_IOV_MAX      8   //longer vectors are gathered by NetworkStack
 
 #define MALLOC  ns_dyn_mem_alloc
 #define FREE    ns_dyn_mem_free
@@ -511,7 +512,7 @@ nsapi_error_t NanostackInterface::socket_close(void *handle)
 
 }
 
-nsapi_size_or_error_t NanostackInterface::do_sendto(void *handle, const ns_address_t *address, const void *data, nsapi_size_t size)
+nsapi_size_or_error_t NanostackInterface::do_sendmsg(void *handle, const ns_address_t *address, ns_iovec_t *iov, unsigned iovcnt)
 {
     // Validate parameters
     NanostackSocket * socket = static_cast<NanostackSocket *>(handle);
@@ -536,27 +537,19 @@ nsapi_size_or_error_t NanostackInterface::do_sendto(void *handle, const ns_addre
     }
 
     int retcode;
-#if 0
-    retcode = ::socket_sendto(socket->socket_id, address,
-                                            data, size);
-#else
-    // Use sendmsg purely to get the new return style
-    // of returning data written rather than 0 on success,
-    // which means TCP can do partial writes. (Sadly,
-    // it's the only call which takes flags so we can
-    // leave the NS_MSG_LEGACY0 flag clear).
+    // sendmsg also gives the new return style of returning
+    // data written rather than 0 on success, which means
+    // TCP can do partial writes. (It's the only call which
+    // takes flags so we can leave the NS_MSG_LEGACY0 flag
+    // clear).
     ns_msghdr_t msg;
-    ns_iovec_t iov;
-    iov.iov_base = const_cast<void *>(data);
-    iov.iov_len = size;
     msg.msg_name = const_cast<ns_address_t *>(address);
     msg.msg_namelen = address ? sizeof *address : 0;
-    msg.msg_iov = &iov;
-    msg.msg_iovlen = 1;
+    msg.msg_iov = iov;
+    msg.msg_iovlen = iovcnt;
     msg.msg_control = NULL;
     msg.msg_controllen = 0;
     retcode = ::socket_sendmsg(socket->socket_id, &msg, 0);
-#endif
 
     /*
      * \return length if entire amount written (which could be 0)
@@ -579,7 +572,7 @@ nsapi_size_or_error_t NanostackInterface::do_sendto(void *handle, const ns_addre
     }
 
 out:
-    tr_debug("socket_sendto(socket=%p) sock_id=%d, ret=%i", socket, socket->socket_id, ret);
+    tr_debug("socket_sendmsg(socket=%p) sock_id=%d, ret=%i", socket, socket->socket_id, ret);
 
     return ret;
 }
@@ -592,8 +585,11 @@ nsapi_size_or_error_t NanostackInterface::socket_sendto(void *handle, const Sock
 
     ns_address_t ns_address;
     convert_mbed_addr_to_ns(&ns_address, &address);
-    /*No lock gaurd needed here as do_sendto() will handle locks.*/
-    return do_sendto(handle, &ns_address, data, size);
+    ns_iovec_t iov;
+    iov.iov_base = const_cast<void *>(data);
+    iov.iov_len = size;
+    /*No lock gaurd needed here as do_sendmsg() will handle locks.*/
+    return do_sendmsg(handle, &ns_address, &iov, 1);
 }
 
 nsapi_size_or_error_t NanostackInterface::socket_recvfrom(void *handle, SocketAddress *address, void *buffer, nsapi_size_t size)
@@ -852,7 +848,94 @@ out:
 
 nsapi_size_or_error_t NanostackInterface::socket_send(void *handle, const void *data, nsapi_size_t size)
 {
-    return do_sendto(handle, NULL, data, size);
+    ns_iovec_t iov;
+    iov.iov_base = const_cast<void *>(data);
+    iov.iov_len = size;
+    return do_sendmsg(handle, NULL, &iov, 1);
+}
+
+nsapi_size_or_error_t NanostackInterface::socket_sendmsg(void *handle, const SocketAddress *address, const nsapi_iovec_t *iov, unsigned iovcnt)
+{
+    if (iovcnt > NS_INTERFACE_IOV_MAX) {
+        return NetworkStack::socket_sendmsg(handle, address, iov, iovcnt);
+    }
+
+    if (address && address->get_ip_version() != NSAPI_IPv6) {
+        return NSAPI_ERROR_UNSUPPORTED;
+    }
+
+    ns_address_t ns_address;
+    if (address) {
+        convert_mbed_addr_to_ns(&ns_address, address);
+    }
+
+    ns_iovec_t ns_iov[NS_INTERFACE_IOV_MAX];
+    for (unsigned i = 0; i < iovcnt; i++) {
+        ns_iov[i].iov_base = iov[i].iov_base;
+        ns_iov[i].iov_len = iov[i].iov_len;
+    }
+
+    /*No lock gaurd needed here as do_sendmsg() will handle locks.*/
+    return do_sendmsg(handle, address ? &ns_address : NULL, ns_iov, iovcnt);
+}
+
+nsapi_size_or_error_t NanostackInterface::socket_recvmsg(void *handle, SocketAddress *address, const nsapi_iovec_t *iov, unsigned iovcnt)
+{
+    if (iovcnt > NS_INTERFACE_IOV_MAX) {
+        return NetworkStack::socket_recvmsg(handle, address, iov, iovcnt);
+    }
+
+    // Validate parameters
+    NanostackSocket *socket = static_cast<NanostackSocket *>(handle);
+    if (handle == NULL) {
+        MBED_ASSERT(false);
+        return NSAPI_ERROR_NO_SOCKET;
+    }
+
+    nsapi_size_or_error_t ret;
+
+    NanostackLockGuard lock;
+
+    if (socket->closed()) {
+        ret = NSAPI_ERROR_NO_CONNECTION;
+        goto out;
+    }
+
+    {
+        ns_address_t ns_address;
+        ns_iovec_t ns_iov[NS_INTERFACE_IOV_MAX];
+        for (unsigned i = 0; i < iovcnt; i++) {
+            ns_iov[i].iov_base = iov[i].iov_base;
+            ns_iov[i].iov_len = iov[i].iov_len;
+        }
+
+        ns_msghdr_t msg;
+        msg.msg_name = &ns_address;
+        msg.msg_namelen = sizeof ns_address;
+        msg.msg_iov = ns_iov;
+        msg.msg_iovlen = iovcnt;
+        msg.msg_control = NULL;
+        msg.msg_controllen = 0;
+        msg.msg_flags = 0;
+
+        int retcode = ::socket_recvmsg(socket->socket_id, &msg, 0);
+
+        if (retcode == NS_EWOULDBLOCK) {
+            ret = NSAPI_ERROR_WOULD_BLOCK;
+        } else if (retcode < 0) {
+            ret = NSAPI_ERROR_PARAMETER;
+        } else {
+            ret = retcode;
+            if (address != NULL) {
+                convert_ns_addr_to_mbed(address, &ns_address);
+            }
+        }
+    }
+
+out:
+    tr_debug("socket_recvmsg(socket=%p) sock_id=%d, ret=%i", socket, socket->socket_id, ret);
+
+    return ret;
 }
 
 nsapi_size_or_error_t NanostackInterface::socket_recv(void *handle, void *data, nsapi_size_t size)
@@ -27,6 +27,7 @@
 #include "MeshInterfaceNanostack.h"
 
 struct ns_address;
+struct ns_iovec;
 
 class NanostackInterface : public NetworkStack {
 public:
@@ -185,6 +186,47 @@ protected:
      */
     virtual nsapi_size_or_error_t socket_recvfrom(void *handle, SocketAddress *address, void *buffer, nsapi_size_t size);
 
+    /** Send a message gathered from several buffers
+     *
+     *  The contents of the buffers in iov are sent as if they were one
+     *  contiguous buffer. For a UDP socket, address is the remote host and
+     *  the buffers form one datagram. For a TCP socket, address is NULL
+     *  and the socket must be connected to a remote host. Returns the
+     *  number of bytes sent from the buffers.
+     *
+     *  This call is non-blocking. If sendmsg would block,
+     *  NSAPI_ERROR_WOULD_BLOCK is returned immediately.
+     *
+     *  @param handle   Socket handle
+     *  @param address  The SocketAddress of the remote host, or NULL for TCP
+     *  @param iov      Array of buffers of data to send to the host
+     *  @param iovcnt   Number of buffers in iov
+     *  @return         Number of sent bytes on success, negative error
+     *                  code on failure
+     */
+    virtual nsapi_size_or_error_t socket_sendmsg(void *handle, const SocketAddress *address, const nsapi_iovec_t *iov, unsigned iovcnt);
+
+    /** Receive a message scattered into several buffers
+     *
+     *  Received data fills the buffers in iov in order. For a UDP socket,
+     *  one datagram is received, any part of it that does not fit is
+     *  discarded, and the source address is stored in address. For a TCP
+     *  socket, address is NULL. Returns the number of bytes received into
+     *  the buffers.
+     *
+     *  This call is non-blocking. If recvmsg would block,
+     *  NSAPI_ERROR_WOULD_BLOCK is returned immediately.
+     *
+     *  @param handle   Socket handle
+     *  @param address  Destination for the source address, or NULL for TCP
+     *  @param iov      Array of destination buffers for data received
+     *                  from the host
+     *  @param iovcnt   Number of buffers in iov
+     *  @return         Number of received bytes on success, negative error
+     *                  code on failure
+     */
+    virtual nsapi_size_or_error_t socket_recvmsg(void *handle, SocketAddress *address, const nsapi_iovec_t *iov, unsigned iovcnt);
+
     /** Register a callback on state change of the socket
      *
      *  The specified callback will be called on state changes such as when
@@ -231,7 +273,7 @@ protected:
     virtual nsapi_error_t getsockopt(void *handle, int level, int optname, void *optval, unsigned *optlen);
 
 private:
-    nsapi_size_or_error_t do_sendto(void *handle, const struct ns_address *address, const void *data, nsapi_size_t size);
+    nsapi_size_or_error_t do_sendmsg(void *handle, const struct ns_address *address, struct ns_iovec *iov, unsigned iovcnt);
     char text_ip_address[40];
     static NanostackInterface * _ns_interface;
 };
@@ -0,0 +1,76 @@
+/* DTLSSocket
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "DTLSSocket.h"
+
+#if defined(MBEDTLS_SSL_CLI_C) && defined(MBEDTLS_X509_CRT_PARSE_C) \
+        && defined(MBEDTLS_SSL_PROTO_DTLS)
+
+DTLSSocket::DTLSSocket()
+{
+}
+
+DTLSSocket::~DTLSSocket()
+{
+    close();
+}
+
+nsapi_protocol_t DTLSSocket::get_proto()
+{
+    return NSAPI_UDP;
+}
+
+int DTLSSocket::get_transport()
+{
+    return MBEDTLS_SSL_TRANSPORT_DATAGRAM;
+}
+
+nsapi_error_t DTLSSocket::setup_context()
+{
+    nsapi_error_t err = TLSSocket::setup_context();
+    if (err) {
+        return err;
+    }
+
+    mbedtls_ssl_set_timer_cb(&_ssl, this, &TLSSocket::set_delay, &TLSSocket::get_delay);
+    return NSAPI_ERROR_OK;
+}
+
+// There is nothing to connect, the handshake starts straight away
+nsapi_error_t DTLSSocket::transport_connect(const SocketAddress &address)
+{
+    _peer = address;
+    return NSAPI_ERROR_OK;
+}
+
+nsapi_size_or_error_t DTLSSocket::transport_send(const void *data, nsapi_size_t size)
+{
+    return _stack->socket_sendto(_socket, _peer, data, size);
+}
+
+nsapi_size_or_error_t DTLSSocket::transport_recv(void *data, nsapi_size_t size)
+{
+    SocketAddress from;
+    nsapi_size_or_error_t ret = _stack->socket_recvfrom(_socket, &from, data, size);
+    if (ret >= 0 && from != _peer) {
+        // Not from the server, wait for the next datagram
+        return NSAPI_ERROR_WOULD_BLOCK;
+    }
+
+    return ret;
+}
+
+#endif
@@ -0,0 +1,83 @@
+/** \addtogroup netsocket */
+/** @{*/
+/* DTLSSocket
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef DTLSSOCKET_H
+#define DTLSSOCKET_H
+
+#include "netsocket/TLSSocket.h"
+
+#if defined(MBEDTLS_SSL_CLI_C) && defined(MBEDTLS_X509_CRT_PARSE_C) \
+        && defined(MBEDTLS_SSL_PROTO_DTLS)
+
+
+/** DTLS client connection over UDP
+ *
+ *  Works as TLSSocket does, sessions included, with datagrams from any
+ *  address other than the server's ignored. Each send is one record, and
+ *  each recv returns at most one record, whose bytes beyond size are
+ *  discarded.
+ *
+ *  Lost handshake messages are sent again on a timer. In blocking mode
+ *  connect keeps to the timer itself. In non-blocking mode the timer is
+ *  only checked when connect is called, so connect has to be called
+ *  every so often as well as on sigio, until the handshake completes.
+ */
+class DTLSSocket : public TLSSocket {
+public:
+    /** Create an uninitialized socket
+     *
+     *  Must call open to initialize the socket on a network stack.
+     */
+    DTLSSocket();
+
+    /** Create a socket on a network interface
+     *
+     *  Creates and opens a socket on the network stack of the given
+     *  network interface.
+     *
+     *  @param stack    Network stack as target for socket
+     */
+    template <typename S>
+    DTLSSocket(S *stack)
+    {
+        open(stack);
+    }
+
+    /** Destroy a socket
+     *
+     *  Closes socket if the socket is still open
+     */
+    virtual ~DTLSSocket();
+
+protected:
+    virtual nsapi_protocol_t get_proto();
+    virtual int get_transport();
+    virtual nsapi_error_t setup_context();
+    virtual nsapi_error_t transport_connect(const SocketAddress &address);
+    virtual nsapi_size_or_error_t transport_send(const void *data, nsapi_size_t size);
+    virtual nsapi_size_or_error_t transport_recv(void *data, nsapi_size_t size);
+
+    SocketAddress _peer;
+};
+
+
+#endif
+
+#endif
+
+/** @}*/
@@ -0,0 +1,81 @@
+/* NetworkBuffer
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "NetworkBuffer.h"
+#include "NetworkStack.h"
+#include <string.h>
+
+
+NetworkBuffer::NetworkBuffer()
+    : _stack(0)
+{
+    _buffer.handle = 0;
+    _buffer.offset = 0;
+    _buffer.size = 0;
+}
+
+NetworkBuffer::~NetworkBuffer()
+{
+    release();
+}
+
+nsapi_size_t NetworkBuffer::size() const
+{
+    return _buffer.size;
+}
+
+nsapi_size_t NetworkBuffer::segment(nsapi_size_t offset, const void **data) const
+{
+    if (!_stack || offset >= _buffer.size) {
+        return 0;
+    }
+
+    return _stack->buffer_segment(&_buffer, offset, data);
+}
+
+nsapi_size_t NetworkBuffer::copy(void *data, nsapi_size_t size, nsapi_size_t offset) const
+{
+    nsapi_size_t copied = 0;
+
+    while (copied < size) {
+        const void *seg;
+        nsapi_size_t len = segment(offset + copied, &seg);
+        if (len == 0) {
+            break;
+        }
+
+        if (len > size - copied) {
+            len = size - copied;
+        }
+
+        memcpy(static_cast<uint8_t *>(data) + copied, seg, len);
+        copied += len;
+    }
+
+    return copied;
+}
+
+void NetworkBuffer::release()
+{
+    if (_stack && _buffer.handle) {
+        _stack->buffer_release(&_buffer);
+    }
+
+    _stack = 0;
+    _buffer.handle = 0;
+    _buffer.offset = 0;
+    _buffer.size = 0;
+}
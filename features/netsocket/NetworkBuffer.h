@@ -0,0 +1,100 @@
+/** \addtogroup netsocket */
+/** @{*/
+/* NetworkBuffer
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef NETWORK_BUFFER_H
+#define NETWORK_BUFFER_H
+
+#include "nsapi_types.h"
+
+// Predeclared classes
+class NetworkStack;
+
+
+/** NetworkBuffer class
+ *
+ *  View of received data that is still held in the network stack's own
+ *  memory, as returned by TCPSocket::recv_buffer and
+ *  UDPSocket::recvfrom_buffer. The data can be parsed in place without
+ *  being copied into an application buffer. The stack memory stays
+ *  allocated until the buffer is released, either explicitly or when the
+ *  NetworkBuffer is destroyed or reused by another receive.
+ */
+class NetworkBuffer {
+public:
+    /** Create an empty buffer
+     */
+    NetworkBuffer();
+
+    /** Destroy the buffer
+     *
+     *  Releases any data still held by the buffer
+     */
+    ~NetworkBuffer();
+
+    /** Get the number of bytes in the buffer
+     *
+     *  @return         Number of bytes of data, 0 if the buffer is empty
+     */
+    nsapi_size_t size() const;
+
+    /** Get a contiguous segment of the buffer
+     *
+     *  Received data may be spread over several blocks of stack memory.
+     *  Returns the number of contiguous bytes stored at offset and points
+     *  data at the first of them, so the whole buffer can be walked by
+     *  advancing offset by the returned length until 0 is returned.
+     *
+     *  @param offset   Offset into the buffer in bytes
+     *  @param data     Destination for a pointer to the segment
+     *  @return         Number of bytes in the segment, 0 if offset is
+     *                  past the end of the buffer
+     */
+    nsapi_size_t segment(nsapi_size_t offset, const void **data) const;
+
+    /** Copy data out of the buffer
+     *
+     *  @param data     Destination for the data
+     *  @param size     Maximum number of bytes to copy
+     *  @param offset   Offset into the buffer to copy from
+     *  @return         Number of bytes copied
+     */
+    nsapi_size_t copy(void *data, nsapi_size_t size, nsapi_size_t offset = 0) const;
+
+    /** Release the data held by the buffer
+     *
+     *  Hands the memory back to the network stack and leaves the buffer
+     *  empty. Releasing an empty buffer has no effect.
+     */
+    void release();
+
+private:
+    friend class TCPSocket;
+    friend class UDPSocket;
+
+    // Buffers own stack memory and can not be copied
+    NetworkBuffer(const NetworkBuffer &);
+    NetworkBuffer &operator=(const NetworkBuffer &);
+
+    NetworkStack *_stack;
+    nsapi_buffer_t _buffer;
+};
+
+
+#endif
+
+/** @}*/
@@ -19,6 +19,7 @@
 
 #include "netsocket/nsapi_types.h"
 #include "netsocket/SocketAddress.h"
+#include "Callback.h"
 
 // Predeclared class
 class NetworkStack;
@@ -33,6 +34,13 @@ class NetworkInterface {
 public:
     virtual ~NetworkInterface() {};
 
+    /** Hostname resolution callback
+     *
+     *  Called with the result of gethostbyname_async, and the resolved
+     *  address on success. The address is NULL on failure.
+     */
+    typedef mbed::Callback<void (nsapi_error_t result, SocketAddress *address)> hostbyname_cb_t;
+
     /** Get the local MAC address
      *
      *  Provided MAC address is intended for info or debug purposes and
@@ -119,6 +127,21 @@ public:
     virtual nsapi_error_t gethostbyname(const char *host,
             SocketAddress *address, nsapi_version_t version = NSAPI_UNSPEC);
 
+    /** Translates a hostname to an IP address without blocking
+     *
+     *  The callback is called once the lookup completes, from a resolver
+     *  thread, so it must not block for long. Answers are cached for as
+     *  long as their TTL allows, so the callback may follow quickly.
+     *
+     *  @param host     Hostname to resolve
+     *  @param callback Callback to call with the result
+     *  @param version  IP version of address to resolve, NSAPI_UNSPEC indicates
+     *                  version is chosen by the stack (defaults to NSAPI_UNSPEC)
+     *  @return         0 if the lookup was started, negative error code on failure
+     */
+    virtual nsapi_error_t gethostbyname_async(const char *host,
+            hostbyname_cb_t callback, nsapi_version_t version = NSAPI_UNSPEC);
+
     /** Add a domain name server to list of servers to query
      *
      *  @param address  Destination for the host address
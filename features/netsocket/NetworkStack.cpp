@@ -18,6 +18,8 @@
 #include "nsapi_dns.h"
 #include "mbed.h"
 #include "stddef.h"
+#include <string.h>
+#include <stdlib.h>
 #include <new>
 
 
@@ -45,6 +47,11 @@ nsapi_error_t NetworkStack::gethostbyname(const char *name, SocketAddress *addre
     return nsapi_dns_query(this, name, address, version);
 }
 
+nsapi_error_t NetworkStack::gethostbyname_async(const char *name, hostbyname_cb_t callback, nsapi_version_t version)
+{
+    return nsapi_dns_query_async(this, name, callback, version);
+}
+
 nsapi_error_t NetworkStack::add_dns_server(const SocketAddress &address)
 {
     return nsapi_dns_add_server(address);
@@ -70,6 +77,131 @@ nsapi_error_t NetworkStack::getsockopt(void *handle, int level, int optname, voi
     return NSAPI_ERROR_UNSUPPORTED;
 }
 
+nsapi_size_or_error_t NetworkStack::socket_recv_buffer(nsapi_socket_t handle, nsapi_buffer_t *buffer, nsapi_size_t size)
+{
+    return NSAPI_ERROR_UNSUPPORTED;
+}
+
+nsapi_size_or_error_t NetworkStack::socket_recvfrom_buffer(nsapi_socket_t handle, SocketAddress *address, nsapi_buffer_t *buffer)
+{
+    return NSAPI_ERROR_UNSUPPORTED;
+}
+
+nsapi_size_t NetworkStack::buffer_segment(const nsapi_buffer_t *buffer, nsapi_size_t offset, const void **data)
+{
+    return 0;
+}
+
+void NetworkStack::buffer_release(nsapi_buffer_t *buffer)
+{
+    buffer->handle = 0;
+    buffer->offset = 0;
+    buffer->size = 0;
+}
+
+nsapi_size_or_error_t NetworkStack::socket_send_ref(nsapi_socket_t handle, const void *data, nsapi_size_t size,
+        void (*callback)(void *), void *context)
+{
+    // Copied data is no longer needed once queued
+    nsapi_size_or_error_t ret = socket_send(handle, data, size);
+    if (ret >= 0 && callback) {
+        callback(context);
+    }
+
+    return ret;
+}
+
+nsapi_size_or_error_t NetworkStack::socket_sendmsg(nsapi_socket_t handle, const SocketAddress *address,
+        const nsapi_iovec_t *iov, unsigned iovcnt)
+{
+    if (iovcnt == 1) {
+        return address ? socket_sendto(handle, *address, iov[0].iov_base, iov[0].iov_len)
+                       : socket_send(handle, iov[0].iov_base, iov[0].iov_len);
+    }
+
+    // Gather into one buffer so the message is not split across
+    // segments or datagrams
+    nsapi_size_t size = 0;
+    for (unsigned i = 0; i < iovcnt; i++) {
+        size += iov[i].iov_len;
+    }
+
+    uint8_t *data = (uint8_t *)malloc(size ? size : 1);
+    if (!data) {
+        return NSAPI_ERROR_NO_MEMORY;
+    }
+
+    nsapi_size_t offset = 0;
+    for (unsigned i = 0; i < iovcnt; i++) {
+        memcpy(data + offset, iov[i].iov_base, iov[i].iov_len);
+        offset += iov[i].iov_len;
+    }
+
+    nsapi_size_or_error_t ret = address ? socket_sendto(handle, *address, data, size)
+                                        : socket_send(handle, data, size);
+    free(data);
+    return ret;
+}
+
+nsapi_size_or_error_t NetworkStack::socket_recvmsg(nsapi_socket_t handle, SocketAddress *address,
+        const nsapi_iovec_t *iov, unsigned iovcnt)
+{
+    if (!address) {
+        // Stream data can be taken a buffer at a time, stopping once
+        // nothing more is queued
+        nsapi_size_t recv = 0;
+        for (unsigned i = 0; i < iovcnt; i++) {
+            if (!iov[i].iov_len) {
+                continue;
+            }
+
+            nsapi_size_or_error_t ret = socket_recv(handle, iov[i].iov_base, iov[i].iov_len);
+            if (ret < 0) {
+                return recv ? (nsapi_size_or_error_t)recv : ret;
+            }
+
+            recv += ret;
+            if ((nsapi_size_t)ret < iov[i].iov_len) {
+                break;
+            }
+        }
+
+        return recv;
+    }
+
+    if (iovcnt == 1) {
+        return socket_recvfrom(handle, address, iov[0].iov_base, iov[0].iov_len);
+    }
+
+    // A datagram must be taken in one call, so receive into one buffer
+    // and scatter it
+    nsapi_size_t size = 0;
+    for (unsigned i = 0; i < iovcnt; i++) {
+        size += iov[i].iov_len;
+    }
+
+    uint8_t *data = (uint8_t *)malloc(size ? size : 1);
+    if (!data) {
+        return NSAPI_ERROR_NO_MEMORY;
+    }
+
+    nsapi_size_or_error_t ret = socket_recvfrom(handle, address, data, size);
+
+    nsapi_size_t offset = 0;
+    for (unsigned i = 0; i < iovcnt && ret > 0 && offset < (nsapi_size_t)ret; i++) {
+        nsapi_size_t len = (nsapi_size_t)ret - offset;
+        if (len > iov[i].iov_len) {
+            len = iov[i].iov_len;
+        }
+
+        memcpy(iov[i].iov_base, data + offset, len);
+        offset += len;
+    }
+
+    free(data);
+    return ret;
+}
+
 
 // NetworkStackWrapper class for encapsulating the raw nsapi_stack structure
 class NetworkStackWrapper : public NetworkStack
@@ -275,6 +407,99 @@ protected:
 
         return _stack_api()->getsockopt(_stack(), socket, level, optname, optval, optlen);
     }
+
+    virtual nsapi_size_or_error_t socket_recv_buffer(nsapi_socket_t socket, nsapi_buffer_t *buffer, nsapi_size_t size)
+    {
+        if (!_stack_api()->socket_recv_buffer) {
+            return NSAPI_ERROR_UNSUPPORTED;
+        }
+
+        return _stack_api()->socket_recv_buffer(_stack(), socket, buffer, size);
+    }
+
+    virtual nsapi_size_or_error_t socket_recvfrom_buffer(nsapi_socket_t socket, SocketAddress *address, nsapi_buffer_t *buffer)
+    {
+        if (!_stack_api()->socket_recvfrom_buffer) {
+            return NSAPI_ERROR_UNSUPPORTED;
+        }
+
+        nsapi_addr_t addr = {NSAPI_IPv4, 0};
+        uint16_t port = 0;
+
+        nsapi_size_or_error_t err = _stack_api()->socket_recvfrom_buffer(_stack(), socket, &addr, &port, buffer);
+
+        if (address) {
+            address->set_addr(addr);
+            address->set_port(port);
+        }
+
+        return err;
+    }
+
+    virtual nsapi_size_t buffer_segment(const nsapi_buffer_t *buffer, nsapi_size_t offset, const void **data)
+    {
+        if (!_stack_api()->buffer_segment) {
+            return 0;
+        }
+
+        return _stack_api()->buffer_segment(_stack(), buffer, offset, data);
+    }
+
+    virtual void buffer_release(nsapi_buffer_t *buffer)
+    {
+        if (!_stack_api()->buffer_release) {
+            return;
+        }
+
+        _stack_api()->buffer_release(_stack(), buffer);
+    }
+
+    virtual nsapi_size_or_error_t socket_send_ref(nsapi_socket_t socket, const void *data, nsapi_size_t size,
+            void (*callback)(void *), void *context)
+    {
+        if (!_stack_api()->socket_send_ref) {
+            return NetworkStack::socket_send_ref(socket, data, size, callback, context);
+        }
+
+        return _stack_api()->socket_send_ref(_stack(), socket, data, size, callback, context);
+    }
+
+    virtual nsapi_size_or_error_t socket_sendmsg(nsapi_socket_t socket, const SocketAddress *address,
+            const nsapi_iovec_t *iov, unsigned iovcnt)
+    {
+        if (!_stack_api()->socket_sendmsg) {
+            return NetworkStack::socket_sendmsg(socket, address, iov, iovcnt);
+        }
+
+        if (!address) {
+            return _stack_api()->socket_sendmsg(_stack(), socket, 0, 0, iov, iovcnt);
+        }
+
+        nsapi_addr_t addr = address->get_addr();
+        return _stack_api()->socket_sendmsg(_stack(), socket, &addr, address->get_port(), iov, iovcnt);
+    }
+
+    virtual nsapi_size_or_error_t socket_recvmsg(nsapi_socket_t socket, SocketAddress *address,
+            const nsapi_iovec_t *iov, unsigned iovcnt)
+    {
+        if (!_stack_api()->socket_recvmsg) {
+            return NetworkStack::socket_recvmsg(socket, address, iov, iovcnt);
+        }
+
+        if (!address) {
+            return _stack_api()->socket_recvmsg(_stack(), socket, 0, 0, iov, iovcnt);
+        }
+
+        nsapi_addr_t addr = {NSAPI_IPv4, 0};
+        uint16_t port = 0;
+
+        nsapi_size_or_error_t err = _stack_api()->socket_recvmsg(_stack(), socket, &addr, &port, iov, iovcnt);
+
+        address->set_addr(addr);
+        address->set_port(port);
+
+        return err;
+    }
 };
 
 
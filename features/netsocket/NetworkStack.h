@@ -36,6 +36,10 @@ class NetworkStack
 public:
     virtual ~NetworkStack() {};
 
+    /** Hostname resolution callback, see NetworkInterface::hostbyname_cb_t
+     */
+    typedef NetworkInterface::hostbyname_cb_t hostbyname_cb_t;
+
     /** Get the local IP address
      *
      *  @return         Null-terminated representation of the local IP address
@@ -60,6 +64,21 @@ public:
     virtual nsapi_error_t gethostbyname(const char *host,
             SocketAddress *address, nsapi_version_t version = NSAPI_UNSPEC);
 
+    /** Translates a hostname to an IP address without blocking
+     *
+     *  The lookup runs on a shared resolver thread through gethostbyname,
+     *  and the callback is called from that thread with the result. The
+     *  address passed to the callback is NULL if the lookup failed.
+     *
+     *  @param host     Hostname to resolve
+     *  @param callback Callback to call with the result
+     *  @param version  IP version of address to resolve, NSAPI_UNSPEC indicates
+     *                  version is chosen by the stack (defaults to NSAPI_UNSPEC)
+     *  @return         0 if the lookup was started, negative error code on failure
+     */
+    virtual nsapi_error_t gethostbyname_async(const char *host,
+            hostbyname_cb_t callback, nsapi_version_t version = NSAPI_UNSPEC);
+
     /** Add a domain name server to list of servers to query
      *
      *  @param address  Destination for the host address
@@ -103,6 +122,9 @@ protected:
     friend class UDPSocket;
     friend class TCPSocket;
     friend class TCPServer;
+    friend class TLSSocket;
+    friend class DTLSSocket;
+    friend class NetworkBuffer;
 
     /** Opens a socket
      *
@@ -299,6 +321,148 @@ protected:
      */
     virtual nsapi_error_t getsockopt(nsapi_socket_t handle, int level,
             int optname, void *optval, unsigned *optlen);
+
+    /** Receive data over a TCP socket without copying
+     *
+     *  The socket must be connected to a remote host. Up to size bytes of
+     *  received data are handed over in buffer, which must be released
+     *  with buffer_release once the data has been consumed. Returns the
+     *  number of bytes in the buffer.
+     *
+     *  This call is non-blocking. If recv_buffer would block,
+     *  NSAPI_ERROR_WOULD_BLOCK is returned immediately.
+     *
+     *  Stacks that keep received data in their own memory should override
+     *  this, along with buffer_segment and buffer_release. By default
+     *  NSAPI_ERROR_UNSUPPORTED is returned.
+     *
+     *  @param handle   Socket handle
+     *  @param buffer   Destination for the received buffer
+     *  @param size     Maximum number of bytes to receive
+     *  @return         Number of received bytes on success, negative error
+     *                  code on failure
+     */
+    virtual nsapi_size_or_error_t socket_recv_buffer(nsapi_socket_t handle,
+            nsapi_buffer_t *buffer, nsapi_size_t size);
+
+    /** Receive a packet over a UDP socket without copying
+     *
+     *  The whole datagram is handed over in buffer, which must be released
+     *  with buffer_release once the data has been consumed. Stores the
+     *  source address in address if address is not NULL. Returns the
+     *  number of bytes in the buffer.
+     *
+     *  This call is non-blocking. If recvfrom_buffer would block,
+     *  NSAPI_ERROR_WOULD_BLOCK is returned immediately.
+     *
+     *  @param handle   Socket handle
+     *  @param address  Destination for the source address or NULL
+     *  @param buffer   Destination for the received buffer
+     *  @return         Number of received bytes on success, negative error
+     *                  code on failure
+     */
+    virtual nsapi_size_or_error_t socket_recvfrom_buffer(nsapi_socket_t handle,
+            SocketAddress *address, nsapi_buffer_t *buffer);
+
+    /** Get a contiguous segment of a received buffer
+     *
+     *  Returns the number of contiguous bytes stored at offset into the
+     *  buffer and points data at the first of them. Returns 0 if offset
+     *  is past the end of the buffer.
+     *
+     *  @param buffer   Buffer from socket_recv_buffer or socket_recvfrom_buffer
+     *  @param offset   Offset into the buffer in bytes
+     *  @param data     Destination for a pointer to the segment
+     *  @return         Number of bytes in the segment
+     */
+    virtual nsapi_size_t buffer_segment(const nsapi_buffer_t *buffer,
+            nsapi_size_t offset, const void **data);
+
+    /** Release a received buffer
+     *
+     *  Hands the memory held by the buffer back to the stack and leaves
+     *  the buffer empty. Releasing an empty buffer has no effect.
+     *
+     *  @param buffer   Buffer from socket_recv_buffer or socket_recvfrom_buffer
+     */
+    virtual void buffer_release(nsapi_buffer_t *buffer);
+
+    /** Send data over a TCP socket without copying
+     *
+     *  The socket must be connected to a remote host. Up to size bytes are
+     *  queued to be sent straight from data, which must stay valid and
+     *  unmodified until callback is called. The callback is called once
+     *  the remote host has acknowledged the queued bytes, or the stack has
+     *  otherwise stopped using them. Returns the number of bytes queued.
+     *  A size of 0 queues nothing and calls callback once all data sent
+     *  before it is no longer needed.
+     *
+     *  This call is non-blocking. If send_ref would block,
+     *  NSAPI_ERROR_WOULD_BLOCK is returned immediately.
+     *
+     *  By default the data is copied with socket_send and callback is
+     *  called before returning.
+     *
+     *  @param handle   Socket handle
+     *  @param data     Buffer of data to send to the host
+     *  @param size     Size of the buffer in bytes
+     *  @param callback Function to call once the data is no longer needed
+     *  @param context  Argument to pass to callback
+     *  @return         Number of queued bytes on success, negative error
+     *                  code on failure
+     */
+    virtual nsapi_size_or_error_t socket_send_ref(nsapi_socket_t handle,
+            const void *data, nsapi_size_t size, void (*callback)(void *), void *context);
+
+    /** Send a message gathered from several buffers
+     *
+     *  The contents of the buffers in iov are sent as if they were one
+     *  contiguous buffer. For a UDP socket, address is the remote host and
+     *  the buffers form one datagram. For a TCP socket, address is NULL
+     *  and the socket must be connected to a remote host. Returns the
+     *  number of bytes sent from the buffers.
+     *
+     *  This call is non-blocking. If sendmsg would block,
+     *  NSAPI_ERROR_WOULD_BLOCK is returned immediately.
+     *
+     *  By default the buffers are copied into one temporary buffer and
+     *  sent with socket_send or socket_sendto.
+     *
+     *  @param handle   Socket handle
+     *  @param address  The SocketAddress of the remote host, or NULL for TCP
+     *  @param iov      Array of buffers of data to send to the host
+     *  @param iovcnt   Number of buffers in iov
+     *  @return         Number of sent bytes on success, negative error
+     *                  code on failure
+     */
+    virtual nsapi_size_or_error_t socket_sendmsg(nsapi_socket_t handle,
+            const SocketAddress *address, const nsapi_iovec_t *iov, unsigned iovcnt);
+
+    /** Receive a message scattered into several buffers
+     *
+     *  Received data fills the buffers in iov in order. For a UDP socket,
+     *  one datagram is received, any part of it that does not fit is
+     *  discarded, and the source address is stored in address. For a TCP
+     *  socket, address is NULL. Returns the number of bytes received into
+     *  the buffers.
+     *
+     *  This call is non-blocking. If recvmsg would block,
+     *  NSAPI_ERROR_WOULD_BLOCK is returned immediately.
+     *
+     *  By default TCP data is received with socket_recv into each buffer
+     *  in turn, and a UDP datagram is received with socket_recvfrom into
+     *  one temporary buffer and copied out.
+     *
+     *  @param handle   Socket handle
+     *  @param address  Destination for the source address, or NULL for TCP
+     *  @param iov      Array of destination buffers for data received
+     *                  from the host
+     *  @param iovcnt   Number of buffers in iov
+     *  @return         Number of received bytes on success, negative error
+     *                  code on failure
+     */
+    virtual nsapi_size_or_error_t socket_recvmsg(nsapi_socket_t handle,
+            SocketAddress *address, const nsapi_iovec_t *iov, unsigned iovcnt);
 };
 
 
@@ -149,6 +149,16 @@ nsapi_error_t Socket::getsockopt(int level, int optname, void *optval, unsigned
 
 }
 
+nsapi_size_or_error_t Socket::sendmsg(const SocketAddress *address, const nsapi_iovec_t *iov, unsigned iovcnt)
+{
+    return NSAPI_ERROR_UNSUPPORTED;
+}
+
+nsapi_size_or_error_t Socket::recvmsg(SocketAddress *address, const nsapi_iovec_t *iov, unsigned iovcnt)
+{
+    return NSAPI_ERROR_UNSUPPORTED;
+}
+
 void Socket::sigio(Callback<void()> callback)
 {
     _lock.lock();
@@ -154,6 +154,51 @@ public:
      */    
     nsapi_error_t getsockopt(int level, int optname, void *optval, unsigned *optlen);
 
+    /** Send a message gathered from several buffers
+     *
+     *  The contents of the buffers in iov are sent as if they were one
+     *  contiguous buffer, so a header and payload held apart need not be
+     *  copied together first. The address is required for datagram
+     *  sockets and ignored for connected stream sockets. Returns the
+     *  number of bytes sent from the buffers.
+     *
+     *  By default, sendmsg blocks until data is sent. If socket is set to
+     *  non-blocking or times out, NSAPI_ERROR_WOULD_BLOCK is returned
+     *  immediately. Sockets that cannot send data return
+     *  NSAPI_ERROR_UNSUPPORTED.
+     *
+     *  @param address  The SocketAddress of the remote host or NULL
+     *  @param iov      Array of buffers of data to send to the host
+     *  @param iovcnt   Number of buffers in iov
+     *  @return         Number of sent bytes on success, negative error
+     *                  code on failure
+     */
+    virtual nsapi_size_or_error_t sendmsg(const SocketAddress *address,
+            const nsapi_iovec_t *iov, unsigned iovcnt);
+
+    /** Receive a message scattered into several buffers
+     *
+     *  Received data fills the buffers in iov in order. Datagram sockets
+     *  receive one datagram, discard any part of it that does not fit,
+     *  and store the source address in address if address is not NULL.
+     *  Stream sockets leave address unmodified. Returns the number of
+     *  bytes received into the buffers.
+     *
+     *  By default, recvmsg blocks until data is received. If socket is set
+     *  to non-blocking or times out, NSAPI_ERROR_WOULD_BLOCK is returned
+     *  immediately. Sockets that cannot receive data return
+     *  NSAPI_ERROR_UNSUPPORTED.
+     *
+     *  @param address  Destination for the source address or NULL
+     *  @param iov      Array of destination buffers for data received
+     *                  from the host
+     *  @param iovcnt   Number of buffers in iov
+     *  @return         Number of received bytes on success, negative error
+     *                  code on failure
+     */
+    virtual nsapi_size_or_error_t recvmsg(SocketAddress *address,
+            const nsapi_iovec_t *iov, unsigned iovcnt);
+
     /** Register a callback on state change of the socket
      *
      *  The specified callback will be called on state changes such as when
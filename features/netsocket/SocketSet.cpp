@@ -0,0 +1,199 @@
+/* SocketSet
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "SocketSet.h"
+#include "mbed_critical.h"
+#include "mbed.h"
+
+
+SocketSet::SocketSet()
+    : _head(0), _tail(0), _size(0), _sem(0)
+{
+    for (unsigned i = 0; i < MBED_CONF_NSAPI_SOCKET_SET_MAX; i++) {
+        _entries[i].set = this;
+        _entries[i].socket = 0;
+        _entries[i].next = 0;
+        _entries[i].queued = false;
+    }
+}
+
+SocketSet::~SocketSet()
+{
+    for (unsigned i = 0; i < MBED_CONF_NSAPI_SOCKET_SET_MAX; i++) {
+        if (_entries[i].socket) {
+            remove(_entries[i].socket);
+        }
+    }
+}
+
+nsapi_error_t SocketSet::add(Socket *socket)
+{
+    _lock.lock();
+
+    Entry *entry = 0;
+    for (unsigned i = 0; i < MBED_CONF_NSAPI_SOCKET_SET_MAX; i++) {
+        if (_entries[i].socket == socket) {
+            _lock.unlock();
+            return NSAPI_ERROR_PARAMETER;
+        } else if (!entry && !_entries[i].socket) {
+            entry = &_entries[i];
+        }
+    }
+
+    if (!entry) {
+        _lock.unlock();
+        return NSAPI_ERROR_NO_MEMORY;
+    }
+
+    core_util_critical_section_enter();
+    entry->socket = socket;
+    core_util_critical_section_exit();
+    _size += 1;
+
+    socket->sigio(mbed::callback(entry, &Entry::event));
+
+    // Anything that happened before the socket was added has been missed
+    signal(entry);
+
+    _lock.unlock();
+    return NSAPI_ERROR_OK;
+}
+
+nsapi_error_t SocketSet::remove(Socket *socket)
+{
+    _lock.lock();
+
+    Entry *entry = 0;
+    for (unsigned i = 0; i < MBED_CONF_NSAPI_SOCKET_SET_MAX; i++) {
+        if (_entries[i].socket == socket) {
+            entry = &_entries[i];
+            break;
+        }
+    }
+
+    if (!entry) {
+        _lock.unlock();
+        return NSAPI_ERROR_PARAMETER;
+    }
+
+    socket->sigio(0);
+
+    // A signal may already be in flight, so unlink the entry under the
+    // same critical section that queues it
+    core_util_critical_section_enter();
+    entry->socket = 0;
+    if (entry->queued) {
+        Entry **prev = &_head;
+        Entry *last = 0;
+        while (*prev != entry) {
+            last = *prev;
+            prev = &(*prev)->next;
+        }
+
+        *prev = entry->next;
+        if (_tail == entry) {
+            _tail = last;
+        }
+
+        entry->next = 0;
+        entry->queued = false;
+    }
+    core_util_critical_section_exit();
+    _size -= 1;
+
+    _lock.unlock();
+    return NSAPI_ERROR_OK;
+}
+
+nsapi_size_or_error_t SocketSet::wait(Socket **ready, unsigned count, int timeout)
+{
+    uint32_t start = osKernelGetTickCount();
+
+    while (true) {
+        unsigned found = 0;
+
+        core_util_critical_section_enter();
+        while (found < count && _head) {
+            Entry *entry = _head;
+            _head = entry->next;
+            if (!_head) {
+                _tail = 0;
+            }
+
+            entry->next = 0;
+            entry->queued = false;
+            ready[found++] = entry->socket;
+        }
+        core_util_critical_section_exit();
+
+        if (found || !count) {
+            return found;
+        } else if (timeout == 0) {
+            return NSAPI_ERROR_WOULD_BLOCK;
+        }
+
+        // Tokens left over from sockets already handed back only cause
+        // another pass over the empty queue, which must not restart the
+        // timeout
+        uint32_t wait = osWaitForever;
+        if (timeout > 0) {
+            uint64_t elapsed = (uint64_t)(osKernelGetTickCount() - start)
+                    * 1000 / osKernelGetTickFreq();
+            if (elapsed >= (uint64_t)timeout) {
+                return NSAPI_ERROR_WOULD_BLOCK;
+            }
+            wait = timeout - elapsed;
+        }
+
+        int32_t tokens = _sem.wait(wait);
+        if (tokens < 1) {
+            return NSAPI_ERROR_WOULD_BLOCK;
+        }
+    }
+}
+
+unsigned SocketSet::size() const
+{
+    return _size;
+}
+
+void SocketSet::signal(Entry *entry)
+{
+    bool queued = false;
+
+    core_util_critical_section_enter();
+    if (entry->socket && !entry->queued) {
+        entry->queued = true;
+        entry->next = 0;
+        if (_tail) {
+            _tail->next = entry;
+        } else {
+            _head = entry;
+        }
+        _tail = entry;
+        queued = true;
+    }
+    core_util_critical_section_exit();
+
+    if (queued) {
+        _sem.release();
+    }
+}
+
+void SocketSet::Entry::event()
+{
+    set->signal(this);
+}
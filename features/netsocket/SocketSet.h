@@ -0,0 +1,133 @@
+/** \addtogroup netsocket */
+/** @{*/
+/* SocketSet
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SOCKET_SET_H
+#define SOCKET_SET_H
+
+#include "netsocket/Socket.h"
+#include "rtos/Mutex.h"
+#include "rtos/Semaphore.h"
+
+#ifndef MBED_CONF_NSAPI_SOCKET_SET_MAX
+#define MBED_CONF_NSAPI_SOCKET_SET_MAX 32
+#endif
+
+
+/** SocketSet class
+ *
+ *  Lets one thread wait on many sockets at once. Each socket added to the
+ *  set is watched through its sigio callback, and sockets that have seen
+ *  a state change are queued as they are signalled, so wait hands back
+ *  only those sockets without scanning the rest of the set.
+ *
+ *  Readiness is edge triggered: a socket is reported once per state
+ *  change, and may be readable, writable, accepting, closed or reported
+ *  spuriously. After a socket is reported it should be used in
+ *  non-blocking mode until it returns NSAPI_ERROR_WOULD_BLOCK, after which
+ *  it will be reported again on the next state change.
+ */
+class SocketSet {
+public:
+    /** Create an empty socket set
+     */
+    SocketSet();
+
+    /** Destroy the socket set
+     *
+     *  Removes any sockets still in the set
+     */
+    ~SocketSet();
+
+    /** Add a socket to the set
+     *
+     *  The set takes over the socket's sigio callback until the socket is
+     *  removed. The socket is reported by the next wait, since it may
+     *  already have state changes pending. A socket must be removed from
+     *  the set before it is destroyed.
+     *
+     *  @param socket   Socket to watch
+     *  @return         0 on success, NSAPI_ERROR_NO_MEMORY if the set is
+     *                  full, NSAPI_ERROR_PARAMETER if the socket is
+     *                  already in the set
+     */
+    nsapi_error_t add(Socket *socket);
+
+    /** Remove a socket from the set
+     *
+     *  Clears the socket's sigio callback and drops any report still
+     *  pending for it.
+     *
+     *  @param socket   Socket to stop watching
+     *  @return         0 on success, NSAPI_ERROR_PARAMETER if the socket
+     *                  is not in the set
+     */
+    nsapi_error_t remove(Socket *socket);
+
+    /** Wait for sockets in the set to change state
+     *
+     *  Stores up to count reported sockets in ready, in the order they
+     *  were signalled, and returns how many were stored. Any further
+     *  reported sockets are left for the next wait.
+     *
+     *  Only one thread should wait on a set at a time.
+     *
+     *  @param ready    Destination for the reported sockets
+     *  @param count    Maximum number of sockets to store in ready
+     *  @param timeout  Timeout in milliseconds, 0 to poll or -1 to wait
+     *                  forever (defaults to -1)
+     *  @return         Number of reported sockets on success,
+     *                  NSAPI_ERROR_WOULD_BLOCK if none were reported
+     *                  before the timeout
+     */
+    nsapi_size_or_error_t wait(Socket **ready, unsigned count, int timeout = -1);
+
+    /** Get the number of sockets in the set
+     *
+     *  @return         Number of sockets being watched
+     */
+    unsigned size() const;
+
+private:
+    struct Entry {
+        SocketSet *set;
+        Socket *socket;
+        Entry *next;
+        bool queued;
+
+        void event();
+    };
+
+    // Called from the socket's sigio, which may be in interrupt context
+    void signal(Entry *entry);
+
+    // Sets hand out pointers to their entries and can not be copied
+    SocketSet(const SocketSet &);
+    SocketSet &operator=(const SocketSet &);
+
+    Entry _entries[MBED_CONF_NSAPI_SOCKET_SET_MAX];
+    Entry *_head;
+    Entry *_tail;
+    unsigned _size;
+    rtos::Semaphore _sem;
+    rtos::Mutex _lock;
+};
+
+
+#endif
+
+/** @}*/
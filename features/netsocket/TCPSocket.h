@@ -23,6 +23,7 @@
 #include "netsocket/Socket.h"
 #include "netsocket/NetworkStack.h"
 #include "netsocket/NetworkInterface.h"
+#include "netsocket/NetworkBuffer.h"
 #include "rtos/Semaphore.h"
 
 
@@ -93,6 +94,42 @@ public:
      *                  code on failure
      */
     nsapi_size_or_error_t send(const void *data, nsapi_size_t size);
+
+    /** Send data over a TCP socket without copying
+     *
+     *  The socket must be connected to a remote host. The data is lent to
+     *  the network stack and sent straight from the buffer, which must stay
+     *  valid and unmodified until the stack hands it back. Returns the
+     *  number of bytes lent from the buffer.
+     *
+     *  Each successful send_ref is completed by one call to the callback
+     *  registered with sigsent, in the order the data was sent. Stacks
+     *  without zero-copy send copy the data and complete immediately.
+     *  Closing the socket with data still lent aborts the connection.
+     *
+     *  By default, send_ref blocks until data is sent. If socket is set to
+     *  non-blocking or times out, NSAPI_ERROR_WOULD_BLOCK is returned
+     *  immediately.
+     *
+     *  @param data     Buffer of data to send to the host
+     *  @param size     Size of the buffer in bytes
+     *  @return         Number of sent bytes on success, negative error
+     *                  code on failure
+     */
+    nsapi_size_or_error_t send_ref(const void *data, nsapi_size_t size);
+
+    /** Register a callback on completion of send_ref
+     *
+     *  The callback is called once for each successful send_ref, when the
+     *  network stack no longer needs that buffer. This is normally when
+     *  the remote host has acknowledged the data.
+     *
+     *  The callback may be called from the network stack's thread or in
+     *  an interrupt context and should not perform expensive operations.
+     *
+     *  @param func     Function to call when a lent buffer is handed back
+     */
+    void sigsent(mbed::Callback<void()> func);
     
     /** Receive data over a TCP socket
      *
@@ -110,17 +147,83 @@ public:
      */
     nsapi_size_or_error_t recv(void *data, nsapi_size_t size);
 
+    /** Receive data over a TCP socket without copying
+     *
+     *  The socket must be connected to a remote host. Up to size bytes of
+     *  received data are handed over in buffer, still in the network
+     *  stack's memory, so they can be parsed in place. Any data previously
+     *  held by buffer is released first. Returns the number of bytes in
+     *  the buffer.
+     *
+     *  By default, recv_buffer blocks until data is received. If socket is
+     *  set to non-blocking or times out, NSAPI_ERROR_WOULD_BLOCK is returned
+     *  immediately. NSAPI_ERROR_UNSUPPORTED is returned if the underlying
+     *  stack does not support zero-copy receive.
+     *
+     *  The number of bytes that can be received without blocking can be
+     *  queried with the NSAPI_RCVPENDING socket option.
+     *
+     *  @param buffer   Destination for the received data
+     *  @param size     Maximum number of bytes to receive
+     *  @return         Number of received bytes on success, negative error
+     *                  code on failure
+     */
+    nsapi_size_or_error_t recv_buffer(NetworkBuffer *buffer, nsapi_size_t size);
+
+    /** Send data gathered from several buffers over a TCP socket
+     *
+     *  The socket must be connected to a remote host. The contents of the
+     *  buffers in iov are sent as if they were one contiguous buffer, so
+     *  they may leave in a single segment. The address is ignored.
+     *  Returns the number of bytes sent from the buffers.
+     *
+     *  By default, sendmsg blocks until data is sent. If socket is set to
+     *  non-blocking or times out, NSAPI_ERROR_WOULD_BLOCK is returned
+     *  immediately.
+     *
+     *  @param address  Ignored, may be NULL
+     *  @param iov      Array of buffers of data to send to the host
+     *  @param iovcnt   Number of buffers in iov
+     *  @return         Number of sent bytes on success, negative error
+     *                  code on failure
+     */
+    virtual nsapi_size_or_error_t sendmsg(const SocketAddress *address,
+            const nsapi_iovec_t *iov, unsigned iovcnt);
+
+    /** Receive data scattered into several buffers over a TCP socket
+     *
+     *  The socket must be connected to a remote host. Received data fills
+     *  the buffers in iov in order. The address is left unmodified.
+     *  Returns the number of bytes received into the buffers.
+     *
+     *  By default, recvmsg blocks until data is received. If socket is set
+     *  to non-blocking or times out, NSAPI_ERROR_WOULD_BLOCK is returned
+     *  immediately.
+     *
+     *  @param address  Ignored, may be NULL
+     *  @param iov      Array of destination buffers for data received
+     *                  from the host
+     *  @param iovcnt   Number of buffers in iov
+     *  @return         Number of received bytes on success, negative error
+     *                  code on failure
+     */
+    virtual nsapi_size_or_error_t recvmsg(SocketAddress *address,
+            const nsapi_iovec_t *iov, unsigned iovcnt);
+
 protected:
     friend class TCPServer;
 
     virtual nsapi_protocol_t get_proto();
     virtual void event();
 
+    static void send_ref_done(void *context);
+
     volatile unsigned _pending;
     rtos::Semaphore _read_sem;
     rtos::Semaphore _write_sem;
     bool _read_in_progress;
     bool _write_in_progress;
+    mbed::Callback<void()> _sent_callback;
 };
 
 
@@ -0,0 +1,622 @@
+/* TLSSocket
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "TLSSocket.h"
+
+#if defined(MBEDTLS_SSL_CLI_C) && defined(MBEDTLS_X509_CRT_PARSE_C)
+
+#include "mbedtls/ssl_internal.h"
+#include "mbedtls/net_sockets.h"
+#include "mbedtls/platform.h"
+#include "mbed_assert.h"
+#include "cmsis_os2.h"
+#include <string.h>
+#include <stdlib.h>
+
+static uint64_t tls_time()
+{
+    return osKernelGetTickCount() * 1000 / osKernelGetTickFreq();
+}
+
+TLSSocket::TLSSocket()
+{
+    construct();
+}
+
+void TLSSocket::construct()
+{
+    mbedtls_ssl_init(&_ssl);
+    mbedtls_ssl_config_init(&_conf);
+    mbedtls_x509_crt_init(&_cacert);
+    mbedtls_x509_crt_init(&_clicert);
+    mbedtls_pk_init(&_pkey);
+    _conf_ready = false;
+    _ssl_ready = false;
+
+    _state = TLS_IDLE;
+    _hostname = NULL;
+    _port = 0;
+    _offered = false;
+    _resumed = false;
+    _handshake_start = 0;
+    _handshake_time = 0;
+    _transport_error = NSAPI_ERROR_OK;
+
+    _timer_start = 0;
+    _timer_int = 0;
+    _timer_fin = 0;
+
+    _pending = 0;
+    _read_in_progress = false;
+    _write_in_progress = false;
+}
+
+TLSSocket::~TLSSocket()
+{
+    close();
+
+    mbedtls_ssl_config_free(&_conf);
+    mbedtls_x509_crt_free(&_cacert);
+    mbedtls_x509_crt_free(&_clicert);
+    mbedtls_pk_free(&_pkey);
+    free(_hostname);
+}
+
+nsapi_protocol_t TLSSocket::get_proto()
+{
+    return NSAPI_TCP;
+}
+
+int TLSSocket::get_transport()
+{
+    return MBEDTLS_SSL_TRANSPORT_STREAM;
+}
+
+nsapi_error_t TLSSocket::set_root_ca_cert(const void *root_ca, size_t len)
+{
+    _lock.lock();
+    int ret = mbedtls_x509_crt_parse(&_cacert, (const unsigned char *)root_ca, len);
+    _lock.unlock();
+
+    return ret ? NSAPI_ERROR_PARAMETER : NSAPI_ERROR_OK;
+}
+
+nsapi_error_t TLSSocket::set_root_ca_cert_nocopy(const void *root_ca, size_t len)
+{
+    _lock.lock();
+    int ret = mbedtls_x509_crt_parse_der_nocopy(&_cacert, (const unsigned char *)root_ca, len);
+    _lock.unlock();
+
+    return ret ? NSAPI_ERROR_PARAMETER : NSAPI_ERROR_OK;
+}
+
+nsapi_error_t TLSSocket::set_client_cert_key(const void *cert, size_t cert_len,
+        const void *key, size_t key_len)
+{
+    _lock.lock();
+
+    nsapi_error_t ret = NSAPI_ERROR_OK;
+    if (mbedtls_x509_crt_parse(&_clicert, (const unsigned char *)cert, cert_len) != 0
+            || mbedtls_pk_parse_key(&_pkey, (const unsigned char *)key, key_len, NULL, 0) != 0) {
+        ret = NSAPI_ERROR_PARAMETER;
+    } else if (_conf_ready && mbedtls_ssl_conf_own_cert(&_conf, &_clicert, &_pkey) != 0) {
+        ret = NSAPI_ERROR_NO_MEMORY;
+    }
+
+    _lock.unlock();
+    return ret;
+}
+
+mbedtls_ssl_config *TLSSocket::get_ssl_config()
+{
+    _lock.lock();
+    if (!_conf_ready) {
+        setup_config();
+    }
+    _lock.unlock();
+
+    return _conf_ready ? &_conf : NULL;
+}
+
+mbedtls_ssl_context *TLSSocket::get_ssl_context()
+{
+    return &_ssl;
+}
+
+void TLSSocket::async_done()
+{
+    event();
+}
+
+bool TLSSocket::is_resumed() const
+{
+    return _resumed;
+}
+
+uint32_t TLSSocket::get_handshake_time() const
+{
+    return _handshake_time;
+}
+
+nsapi_error_t TLSSocket::setup_config()
+{
+    int ret = mbedtls_ssl_config_defaults(&_conf, MBEDTLS_SSL_IS_CLIENT,
+            get_transport(), MBEDTLS_SSL_PRESET_DEFAULT);
+    if (ret) {
+        return tls_error(ret);
+    }
+
+    mbedtls_ssl_conf_rng(&_conf, nsapi_tls_rng, NULL);
+    mbedtls_ssl_conf_ca_chain(&_conf, &_cacert, NULL);
+
+    if (mbedtls_pk_get_type(&_pkey) != MBEDTLS_PK_NONE) {
+        ret = mbedtls_ssl_conf_own_cert(&_conf, &_clicert, &_pkey);
+        if (ret) {
+            return tls_error(ret);
+        }
+    }
+
+    _conf_ready = true;
+    return NSAPI_ERROR_OK;
+}
+
+nsapi_error_t TLSSocket::setup_context()
+{
+    // The context, and its record buffers, are kept from one connection
+    // to the next until the socket is closed
+    int ret;
+    if (_ssl_ready) {
+        ret = mbedtls_ssl_session_reset(&_ssl);
+    } else {
+        ret = mbedtls_ssl_setup(&_ssl, &_conf);
+        _ssl_ready = !ret;
+    }
+
+    if (ret) {
+        return tls_error(ret);
+    }
+
+    mbedtls_ssl_set_bio(&_ssl, this, &TLSSocket::ssl_send, &TLSSocket::ssl_recv, NULL);
+    return NSAPI_ERROR_OK;
+}
+
+// Prepares the context for a handshake with the named server, and offers
+// the session cached for it if there is one
+nsapi_error_t TLSSocket::prepare(const SocketAddress &address, const char *hostname)
+{
+    nsapi_error_t err;
+    if (!_conf_ready) {
+        err = setup_config();
+        if (err) {
+            return err;
+        }
+    }
+
+    err = setup_context();
+    if (err) {
+        return err;
+    }
+
+    // Handshake flights go out as several small writes, which Nagle's
+    // algorithm would hold back for the server's delayed ack
+    if (get_proto() == NSAPI_TCP) {
+        int nodelay = 1;
+        _stack->setsockopt(_socket, NSAPI_SOCKET, NSAPI_TCP_NODELAY, &nodelay, sizeof nodelay);
+    }
+
+    const char *name = hostname ? hostname : address.get_ip_address();
+    if (!name) {
+        return NSAPI_ERROR_PARAMETER;
+    }
+
+    size_t name_len = strlen(name);
+    char *copy = (char *)malloc(name_len + 1);
+    if (!copy) {
+        return NSAPI_ERROR_NO_MEMORY;
+    }
+    memcpy(copy, name, name_len + 1);
+    free(_hostname);
+    _hostname = copy;
+    _port = address.get_port();
+
+    // A session reset keeps the hostname, and setting it again does
+    // not free the previous one
+    mbedtls_free(_ssl.hostname);
+    _ssl.hostname = NULL;
+    if (hostname) {
+        int ret = mbedtls_ssl_set_hostname(&_ssl, hostname);
+        if (ret) {
+            return tls_error(ret);
+        }
+    }
+
+    mbedtls_ssl_session session;
+    mbedtls_ssl_session_init(&session);
+    _offered = nsapi_tls_session_get(_hostname, _port, &_conf, &session) == NSAPI_ERROR_OK
+            && mbedtls_ssl_set_session(&_ssl, &session) == 0;
+    mbedtls_ssl_session_free(&session);
+
+    _resumed = false;
+    _transport_error = NSAPI_ERROR_OK;
+    _timer_fin = 0;
+    return NSAPI_ERROR_OK;
+}
+
+// Ends a handshake, successful or not
+void TLSSocket::finish(nsapi_error_t result)
+{
+    _handshake_time = tls_time() - _handshake_start;
+    _timer_fin = 0;
+
+    if (!result) {
+        _state = TLS_CONNECTED;
+        nsapi_tls_session_set(_hostname, _port, &_ssl);
+    } else {
+        // A session the server chokes on is not offered again
+        _state = TLS_IDLE;
+        if (_offered) {
+            nsapi_tls_session_remove(_hostname);
+        }
+    }
+
+    nsapi_tls_record_handshake(result, _resumed, _handshake_time);
+}
+
+nsapi_error_t TLSSocket::connect(const char *host, uint16_t port)
+{
+    if (!_stack) {
+        return NSAPI_ERROR_NO_SOCKET;
+    }
+
+    SocketAddress address;
+    nsapi_error_t err = _stack->gethostbyname(host, &address);
+    if (err) {
+        return NSAPI_ERROR_DNS_FAILURE;
+    }
+
+    address.set_port(port);
+
+    // connect is thread safe
+    return connect(address, host);
+}
+
+nsapi_error_t TLSSocket::connect(const SocketAddress &address, const char *hostname)
+{
+    _lock.lock();
+    nsapi_error_t ret;
+
+    // If this assert is hit then there are two threads
+    // performing a send at the same time which is undefined
+    // behavior
+    MBED_ASSERT(!_write_in_progress);
+    _write_in_progress = true;
+
+    if (!_socket) {
+        ret = NSAPI_ERROR_NO_SOCKET;
+    } else if (_state == TLS_CONNECTED) {
+        ret = NSAPI_ERROR_IS_CONNECTED;
+    } else if (_state != TLS_IDLE) {
+        ret = handshake(address, false);
+    } else if (!(ret = prepare(address, hostname))) {
+        _state = TLS_CONNECTING;
+        ret = handshake(address, true);
+    }
+
+    _write_in_progress = false;
+    _lock.unlock();
+    return ret;
+}
+
+// Connects the underlying socket and runs the handshake for as long as
+// the socket's timeout allows. Called with the lock held.
+nsapi_error_t TLSSocket::handshake(const SocketAddress &address, bool started)
+{
+    uint64_t start = tls_time();
+
+    while (true) {
+        if (_state == TLS_CONNECTING) {
+            _pending = 0;
+            nsapi_error_t err = transport_connect(address);
+            if (err == NSAPI_ERROR_OK || err == NSAPI_ERROR_IS_CONNECTED) {
+                _state = TLS_HANDSHAKING;
+                _handshake_start = tls_time();
+            } else if (err != NSAPI_ERROR_IN_PROGRESS && err != NSAPI_ERROR_ALREADY) {
+                _state = TLS_IDLE;
+                return err;
+            }
+        }
+
+        if (_state == TLS_HANDSHAKING) {
+            _pending = 0;
+            int err = 0;
+            while (!err && _ssl.state != MBEDTLS_SSL_HANDSHAKE_OVER) {
+                err = mbedtls_ssl_handshake_step(&_ssl);
+
+                // The handshake parameters are freed with the last step
+                if (_ssl.handshake) {
+                    _resumed = _ssl.handshake->resume;
+                }
+            }
+
+            if (!err) {
+                finish(NSAPI_ERROR_OK);
+                return NSAPI_ERROR_OK;
+            } else if (err != MBEDTLS_ERR_SSL_WANT_READ && err != MBEDTLS_ERR_SSL_WANT_WRITE &&
+                       err != MBEDTLS_ERR_SSL_WANT_ASYNC) {
+                nsapi_error_t ret = tls_error(err);
+                finish(ret);
+                return ret;
+            }
+        }
+
+        if (_timeout == 0 || wait(start, _read_sem)) {
+            return started ? NSAPI_ERROR_IN_PROGRESS : NSAPI_ERROR_ALREADY;
+        }
+    }
+}
+
+nsapi_size_or_error_t TLSSocket::send(const void *data, nsapi_size_t size)
+{
+    _lock.lock();
+    nsapi_size_or_error_t ret;
+
+    // If this assert is hit then there are two threads
+    // performing a send at the same time which is undefined
+    // behavior
+    MBED_ASSERT(!_write_in_progress);
+    _write_in_progress = true;
+
+    uint64_t start = tls_time();
+
+    while (true) {
+        if (!_socket) {
+            ret = NSAPI_ERROR_NO_SOCKET;
+            break;
+        } else if (_state != TLS_CONNECTED) {
+            ret = NSAPI_ERROR_NO_CONNECTION;
+            break;
+        }
+
+        _pending = 0;
+        int err = mbedtls_ssl_write(&_ssl, (const unsigned char *)data, size);
+        if (err >= 0) {
+            ret = err;
+            break;
+        } else if (err != MBEDTLS_ERR_SSL_WANT_READ && err != MBEDTLS_ERR_SSL_WANT_WRITE &&
+                   err != MBEDTLS_ERR_SSL_WANT_ASYNC) {
+            ret = tls_error(err);
+            break;
+        } else if (_timeout == 0 || wait(start, _write_sem)) {
+            ret = NSAPI_ERROR_WOULD_BLOCK;
+            break;
+        }
+    }
+
+    _write_in_progress = false;
+    _lock.unlock();
+    return ret;
+}
+
+nsapi_size_or_error_t TLSSocket::recv(void *data, nsapi_size_t size)
+{
+    _lock.lock();
+    nsapi_size_or_error_t ret;
+
+    // If this assert is hit then there are two threads
+    // performing a recv at the same time which is undefined
+    // behavior
+    MBED_ASSERT(!_read_in_progress);
+    _read_in_progress = true;
+
+    uint64_t start = tls_time();
+
+    while (true) {
+        if (!_socket) {
+            ret = NSAPI_ERROR_NO_SOCKET;
+            break;
+        } else if (_state != TLS_CONNECTED) {
+            ret = NSAPI_ERROR_NO_CONNECTION;
+            break;
+        }
+
+        _pending = 0;
+        int err = mbedtls_ssl_read(&_ssl, (unsigned char *)data, size);
+        if (err >= 0) {
+            ret = err;
+            break;
+        } else if (err == MBEDTLS_ERR_SSL_PEER_CLOSE_NOTIFY) {
+            ret = 0;
+            break;
+        } else if (err != MBEDTLS_ERR_SSL_WANT_READ && err != MBEDTLS_ERR_SSL_WANT_WRITE &&
+                   err != MBEDTLS_ERR_SSL_WANT_ASYNC) {
+            ret = tls_error(err);
+            break;
+        } else if (_timeout == 0 || wait(start, _read_sem)) {
+            ret = NSAPI_ERROR_WOULD_BLOCK;
+            break;
+        }
+    }
+
+    _read_in_progress = false;
+    _lock.unlock();
+    return ret;
+}
+
+nsapi_error_t TLSSocket::close()
+{
+    _lock.lock();
+
+    // Best effort, a close notification that would block is dropped
+    if (_socket && _state == TLS_CONNECTED) {
+        mbedtls_ssl_close_notify(&_ssl);
+    }
+    _state = TLS_IDLE;
+
+    nsapi_error_t ret = Socket::close();
+
+    if (_ssl_ready) {
+        mbedtls_ssl_free(&_ssl);
+        mbedtls_ssl_init(&_ssl);
+        _ssl_ready = false;
+    }
+
+    _lock.unlock();
+    return ret;
+}
+
+// Waits for the socket to signal, for no longer than is left of the
+// socket's timeout, or of the retransmission timer if one is running.
+// Called with the lock held.
+nsapi_error_t TLSSocket::wait(uint64_t start, rtos::Semaphore &sem)
+{
+    uint64_t now = tls_time();
+    uint32_t timeout = _timeout;
+
+    if (_timeout != osWaitForever) {
+        if (now - start >= _timeout) {
+            return NSAPI_ERROR_WOULD_BLOCK;
+        }
+
+        timeout = _timeout - (now - start);
+    }
+
+    if (_timer_fin) {
+        uint64_t elapsed = now - _timer_start;
+        uint32_t left = elapsed < _timer_fin ? _timer_fin - elapsed : 0;
+        if (left < timeout) {
+            timeout = left;
+        }
+    }
+
+    if (timeout) {
+        // Release lock before blocking so other threads
+        // accessing this object aren't blocked
+        _lock.unlock();
+        sem.wait(timeout);
+        _lock.lock();
+    }
+
+    return NSAPI_ERROR_OK;
+}
+
+nsapi_error_t TLSSocket::tls_error(int ret)
+{
+    if (_transport_error) {
+        return _transport_error;
+    }
+
+    switch (ret) {
+        case MBEDTLS_ERR_SSL_WANT_READ:
+        case MBEDTLS_ERR_SSL_WANT_WRITE:
+        case MBEDTLS_ERR_SSL_WANT_ASYNC:
+            return NSAPI_ERROR_WOULD_BLOCK;
+        case MBEDTLS_ERR_SSL_ALLOC_FAILED:
+            return NSAPI_ERROR_NO_MEMORY;
+        case MBEDTLS_ERR_SSL_BAD_INPUT_DATA:
+        case MBEDTLS_ERR_SSL_FEATURE_UNAVAILABLE:
+            return NSAPI_ERROR_PARAMETER;
+        case MBEDTLS_ERR_SSL_TIMEOUT:
+            return NSAPI_ERROR_CONNECTION_TIMEOUT;
+        case MBEDTLS_ERR_SSL_CONN_EOF:
+            return NSAPI_ERROR_CONNECTION_LOST;
+        default:
+            return _state == TLS_CONNECTED ? NSAPI_ERROR_CONNECTION_LOST
+                                           : NSAPI_ERROR_AUTH_FAILURE;
+    }
+}
+
+void TLSSocket::event()
+{
+    _write_sem.release();
+    _read_sem.release();
+
+    _pending += 1;
+    if (_callback && _pending == 1) {
+        _callback();
+    }
+}
+
+
+// Transport
+nsapi_error_t TLSSocket::transport_connect(const SocketAddress &address)
+{
+    return _stack->socket_connect(_socket, address);
+}
+
+nsapi_size_or_error_t TLSSocket::transport_send(const void *data, nsapi_size_t size)
+{
+    return _stack->socket_send(_socket, data, size);
+}
+
+nsapi_size_or_error_t TLSSocket::transport_recv(void *data, nsapi_size_t size)
+{
+    return _stack->socket_recv(_socket, data, size);
+}
+
+int TLSSocket::ssl_send(void *ctx, const unsigned char *buf, size_t len)
+{
+    TLSSocket *socket = static_cast<TLSSocket *>(ctx);
+    nsapi_size_or_error_t ret = socket->transport_send(buf, len);
+    if (ret == NSAPI_ERROR_WOULD_BLOCK) {
+        return MBEDTLS_ERR_SSL_WANT_WRITE;
+    } else if (ret < 0) {
+        socket->_transport_error = ret;
+        return MBEDTLS_ERR_NET_SEND_FAILED;
+    }
+
+    return ret;
+}
+
+int TLSSocket::ssl_recv(void *ctx, unsigned char *buf, size_t len)
+{
+    TLSSocket *socket = static_cast<TLSSocket *>(ctx);
+    nsapi_size_or_error_t ret = socket->transport_recv(buf, len);
+    if (ret == NSAPI_ERROR_WOULD_BLOCK) {
+        return MBEDTLS_ERR_SSL_WANT_READ;
+    } else if (ret < 0) {
+        socket->_transport_error = ret;
+        return MBEDTLS_ERR_NET_RECV_FAILED;
+    }
+
+    return ret;
+}
+
+void TLSSocket::set_delay(void *ctx, uint32_t int_ms, uint32_t fin_ms)
+{
+    TLSSocket *socket = static_cast<TLSSocket *>(ctx);
+    socket->_timer_start = tls_time();
+    socket->_timer_int = int_ms;
+    socket->_timer_fin = fin_ms;
+}
+
+int TLSSocket::get_delay(void *ctx)
+{
+    TLSSocket *socket = static_cast<TLSSocket *>(ctx);
+    if (!socket->_timer_fin) {
+        return -1;
+    }
+
+    uint64_t elapsed = tls_time() - socket->_timer_start;
+    if (elapsed >= socket->_timer_fin) {
+        return 2;
+    } else if (elapsed >= socket->_timer_int) {
+        return 1;
+    }
+
+    return 0;
+}
+
+#endif
@@ -0,0 +1,288 @@
+/** \addtogroup netsocket */
+/** @{*/
+/* TLSSocket
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TLSSOCKET_H
+#define TLSSOCKET_H
+
+#include "netsocket/Socket.h"
+#include "netsocket/NetworkStack.h"
+#include "netsocket/NetworkInterface.h"
+#include "netsocket/nsapi_tls.h"
+#include "rtos/Semaphore.h"
+#include "mbedtls/ssl.h"
+
+#if defined(MBEDTLS_SSL_CLI_C) && defined(MBEDTLS_X509_CRT_PARSE_C)
+
+
+/** TLS client connection over TCP
+ *
+ *  The handshake runs in connect. Sessions are cached by server name and
+ *  port, so that reconnecting to a server resumes the last session with
+ *  it, by session ID or by session ticket, whichever the server offered.
+ *  A session is only resumed by sockets with the same trusted CAs, client
+ *  certificate and authentication mode as the one that established it.
+ *
+ *  In non-blocking mode, connect returns NSAPI_ERROR_IN_PROGRESS once the
+ *  connection is started and NSAPI_ERROR_ALREADY while the handshake goes
+ *  on. Calling connect again on each sigio callback drives the handshake
+ *  to completion, at which point connect returns 0, and
+ *  NSAPI_ERROR_IS_CONNECTED after that.
+ */
+class TLSSocket : public Socket {
+public:
+    /** Create an uninitialized socket
+     *
+     *  Must call open to initialize the socket on a network stack.
+     */
+    TLSSocket();
+
+    /** Create a socket on a network interface
+     *
+     *  Creates and opens a socket on the network stack of the given
+     *  network interface.
+     *
+     *  @param stack    Network stack as target for socket
+     */
+    template <typename S>
+    TLSSocket(S *stack)
+    {
+        construct();
+        open(stack);
+    }
+
+    /** Destroy a socket
+     *
+     *  Closes socket if the socket is still open
+     */
+    virtual ~TLSSocket();
+
+    /** Set the certificates trusted to sign the server's certificate
+     *
+     *  May be called several times to trust several chains. PEM data must
+     *  include the terminating null character in its length.
+     *
+     *  @param root_ca  PEM or DER encoded certificate chain
+     *  @param len      Length of the certificate chain in bytes
+     *  @return         0 on success, negative error code on failure
+     */
+    nsapi_error_t set_root_ca_cert(const void *root_ca, size_t len);
+
+    /** Trust a DER encoded certificate without copying it
+     *
+     *  Like set_root_ca_cert, but the socket keeps pointers into the
+     *  certificate instead of a heap copy of it, so it must stay valid
+     *  while the socket is in use, as constant data in flash does.
+     *
+     *  @param root_ca  DER encoded certificate
+     *  @param len      Length of the certificate in bytes
+     *  @return         0 on success, negative error code on failure
+     */
+    nsapi_error_t set_root_ca_cert_nocopy(const void *root_ca, size_t len);
+
+    /** Set the certificate and key presented to servers that ask for one
+     *
+     *  PEM data must include the terminating null character in its length.
+     *
+     *  @param cert     PEM or DER encoded certificate chain
+     *  @param cert_len Length of the certificate chain in bytes
+     *  @param key      PEM or DER encoded private key
+     *  @param key_len  Length of the private key in bytes
+     *  @return         0 on success, negative error code on failure
+     */
+    nsapi_error_t set_client_cert_key(const void *cert, size_t cert_len,
+            const void *key, size_t key_len);
+
+    /** Close the socket
+     *
+     *  Sends a close notification to the server if the connection is
+     *  established, then closes the underlying socket. Called from
+     *  destructor if socket is not closed.
+     *
+     *  @return         0 on success, negative error code on failure
+     */
+    nsapi_error_t close();
+
+    /** Connects to a TLS server
+     *
+     *  Resolves the hostname and connects to the server, which must
+     *  present a certificate issued to the hostname.
+     *
+     *  @param host     Hostname of the remote host
+     *  @param port     Port of the remote host
+     *  @return         0 on success, negative error code on failure
+     *                  NSAPI_ERROR_AUTH_FAILURE indicates the handshake failed
+     */
+    nsapi_error_t connect(const char *host, uint16_t port);
+
+    /** Connects to a TLS server at a known address
+     *
+     *  The server must present a certificate issued to hostname, which is
+     *  also the name sessions with the server are cached under. Without a
+     *  hostname, the certificate's name is not checked and sessions are
+     *  cached under the server's IP address.
+     *
+     *  @param address  The SocketAddress of the remote host
+     *  @param hostname Name of the remote host or NULL
+     *  @return         0 on success, negative error code on failure
+     *                  NSAPI_ERROR_AUTH_FAILURE indicates the handshake failed
+     */
+    nsapi_error_t connect(const SocketAddress &address, const char *hostname = NULL);
+
+    /** Send data over the TLS connection
+     *
+     *  The handshake must have completed. Returns the number of bytes
+     *  sent from the buffer.
+     *
+     *  By default, send blocks until data is sent. If socket is set to
+     *  non-blocking or times out, NSAPI_ERROR_WOULD_BLOCK is returned
+     *  immediately. A send that would block must be repeated with the
+     *  same data once the socket signals.
+     *
+     *  @param data     Buffer of data to send to the host
+     *  @param size     Size of the buffer in bytes
+     *  @return         Number of sent bytes on success, negative error
+     *                  code on failure
+     */
+    nsapi_size_or_error_t send(const void *data, nsapi_size_t size);
+
+    /** Receive data over the TLS connection
+     *
+     *  The handshake must have completed. Returns the number of bytes
+     *  received into the buffer, or 0 once the server has closed the
+     *  connection.
+     *
+     *  By default, recv blocks until data is received. If socket is set
+     *  to non-blocking or times out, NSAPI_ERROR_WOULD_BLOCK is returned
+     *  immediately.
+     *
+     *  @param data     Destination buffer for data received from the host
+     *  @param size     Size of the buffer in bytes
+     *  @return         Number of received bytes on success, negative error
+     *                  code on failure
+     */
+    nsapi_size_or_error_t recv(void *data, nsapi_size_t size);
+
+    /** Check whether the last handshake resumed a cached session
+     *
+     *  @return         True if the last completed handshake was abbreviated
+     */
+    bool is_resumed() const;
+
+    /** Get the duration of the last completed handshake
+     *
+     *  Measured from the first handshake message sent to the last one
+     *  received, so the time taken to connect the underlying socket is
+     *  not included.
+     *
+     *  @return         Duration of the handshake in milliseconds
+     */
+    uint32_t get_handshake_time() const;
+
+    /** Get the mbed TLS configuration of the socket
+     *
+     *  The configuration is set up by the first call, and may be adjusted
+     *  until the first connect. Use with care.
+     *
+     *  @return         The mbed TLS configuration, or NULL if it could not
+     *                  be set up
+     */
+    mbedtls_ssl_config *get_ssl_config();
+
+    /** Get the mbed TLS context of the connection
+     *
+     *  @return         The mbed TLS context. Use with care.
+     */
+    mbedtls_ssl_context *get_ssl_context();
+
+    /** Signal the end of an asynchronous private key operation
+     *
+     *  With callbacks set by mbedtls_ssl_conf_async_private_cb on the
+     *  configuration, the handshake waits while our signature is computed
+     *  elsewhere, on a worker thread or a crypto engine. Whatever computes
+     *  it calls this once done, from any context, to resume the handshake:
+     *  a blocking connect carries on, and a non-blocking one signals its
+     *  sigio callback to be called again.
+     */
+    void async_done();
+
+protected:
+    enum tls_state {
+        TLS_IDLE,
+        TLS_CONNECTING,
+        TLS_HANDSHAKING,
+        TLS_CONNECTED,
+    };
+
+    void construct();
+    nsapi_error_t setup_config();
+    nsapi_error_t prepare(const SocketAddress &address, const char *hostname);
+    nsapi_error_t handshake(const SocketAddress &address, bool started);
+    void finish(nsapi_error_t result);
+    nsapi_error_t wait(uint64_t start, rtos::Semaphore &sem);
+    nsapi_error_t tls_error(int ret);
+
+    virtual nsapi_protocol_t get_proto();
+    virtual void event();
+
+    /* Transport hooks, overridden by DTLSSocket */
+    virtual int get_transport();
+    virtual nsapi_error_t setup_context();
+    virtual nsapi_error_t transport_connect(const SocketAddress &address);
+    virtual nsapi_size_or_error_t transport_send(const void *data, nsapi_size_t size);
+    virtual nsapi_size_or_error_t transport_recv(void *data, nsapi_size_t size);
+
+    static int ssl_send(void *ctx, const unsigned char *buf, size_t len);
+    static int ssl_recv(void *ctx, unsigned char *buf, size_t len);
+    static void set_delay(void *ctx, uint32_t int_ms, uint32_t fin_ms);
+    static int get_delay(void *ctx);
+
+    mbedtls_ssl_context _ssl;
+    mbedtls_ssl_config _conf;
+    mbedtls_x509_crt _cacert;
+    mbedtls_x509_crt _clicert;
+    mbedtls_pk_context _pkey;
+    bool _conf_ready;
+    bool _ssl_ready;
+
+    tls_state _state;
+    char *_hostname;
+    uint16_t _port;
+    bool _offered;
+    bool _resumed;
+    uint64_t _handshake_start;
+    uint32_t _handshake_time;
+    nsapi_error_t _transport_error;
+
+    // DTLS retransmission timer, in milliseconds since _timer_start
+    uint64_t _timer_start;
+    uint32_t _timer_int;
+    uint32_t _timer_fin;
+
+    volatile unsigned _pending;
+    rtos::Semaphore _read_sem;
+    rtos::Semaphore _write_sem;
+    bool _read_in_progress;
+    bool _write_in_progress;
+};
+
+
+#endif
+
+#endif
+
+/** @}*/
@@ -23,6 +23,7 @@
 #include "netsocket/Socket.h"
 #include "netsocket/NetworkStack.h"
 #include "netsocket/NetworkInterface.h"
+#include "netsocket/NetworkBuffer.h"
 #include "rtos/Semaphore.h"
 
 
@@ -99,6 +100,10 @@ public:
      *  Receives data and stores the source address in address if address
      *  is not NULL. Returns the number of bytes received into the buffer.
      *
+     *  Any bytes of the datagram beyond size are discarded. The size of the
+     *  next datagram can be queried first with the NSAPI_RCVPENDING socket
+     *  option, or the whole datagram received with recvfrom_buffer.
+     *
      *  By default, recvfrom blocks until data is sent. If socket is set to
      *  non-blocking or times out, NSAPI_ERROR_WOULD_BLOCK is returned
      *  immediately.
@@ -112,6 +117,66 @@ public:
     nsapi_size_or_error_t recvfrom(SocketAddress *address,
             void *data, nsapi_size_t size);
 
+    /** Receive a packet over a UDP socket without copying
+     *
+     *  The whole datagram is handed over in buffer, still in the network
+     *  stack's memory, so it is never truncated and can be parsed in place.
+     *  Any data previously held by buffer is released first. Stores the
+     *  source address in address if address is not NULL. Returns the number
+     *  of bytes in the buffer.
+     *
+     *  By default, recvfrom_buffer blocks until data is received. If socket
+     *  is set to non-blocking or times out, NSAPI_ERROR_WOULD_BLOCK is
+     *  returned immediately. NSAPI_ERROR_UNSUPPORTED is returned if the
+     *  underlying stack does not support zero-copy receive.
+     *
+     *  @param address  Destination for the source address or NULL
+     *  @param buffer   Destination for the received datagram
+     *  @return         Number of received bytes on success, negative error
+     *                  code on failure
+     */
+    nsapi_size_or_error_t recvfrom_buffer(SocketAddress *address, NetworkBuffer *buffer);
+
+    /** Send a packet gathered from several buffers over a UDP socket
+     *
+     *  Sends the contents of the buffers in iov as one datagram to the
+     *  specified address. Returns the number of bytes sent from the
+     *  buffers, or NSAPI_ERROR_NO_ADDRESS if address is NULL.
+     *
+     *  By default, sendmsg blocks until data is sent. If socket is set to
+     *  non-blocking or times out, NSAPI_ERROR_WOULD_BLOCK is returned
+     *  immediately.
+     *
+     *  @param address  The SocketAddress of the remote host
+     *  @param iov      Array of buffers of data to send to the host
+     *  @param iovcnt   Number of buffers in iov
+     *  @return         Number of sent bytes on success, negative error
+     *                  code on failure
+     */
+    virtual nsapi_size_or_error_t sendmsg(const SocketAddress *address,
+            const nsapi_iovec_t *iov, unsigned iovcnt);
+
+    /** Receive a packet scattered into several buffers over a UDP socket
+     *
+     *  Receives one datagram into the buffers in iov in order and stores
+     *  the source address in address if address is not NULL. Any bytes of
+     *  the datagram beyond the total size of the buffers are discarded.
+     *  Returns the number of bytes received into the buffers.
+     *
+     *  By default, recvmsg blocks until data is received. If socket is set
+     *  to non-blocking or times out, NSAPI_ERROR_WOULD_BLOCK is returned
+     *  immediately.
+     *
+     *  @param address  Destination for the source address or NULL
+     *  @param iov      Array of destination buffers for data received
+     *                  from the host
+     *  @param iovcnt   Number of buffers in iov
+     *  @return         Number of received bytes on success, negative error
+     *                  code on failure
+     */
+    virtual nsapi_size_or_error_t recvmsg(SocketAddress *address,
+            const nsapi_iovec_t *iov, unsigned iovcnt);
+
 protected:
     virtual nsapi_protocol_t get_proto();
     virtual void event();
@@ -20,6 +20,10 @@
 
 #include <stdint.h>
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 /**
  * Stack memory module
  *
@@ -111,6 +115,10 @@ uint32_t emac_stack_mem_chain_len(emac_stack_t* stack, emac_stack_mem_chain_t *c
  */
 void emac_stack_mem_ref(emac_stack_t* stack, emac_stack_mem_t *mem);
 
+#ifdef __cplusplus
+}
+#endif
+
 #endif /* DEVICE_EMAC */
 
 #endif /* EMAC_MBED_STACK_MEM_h */
@@ -37,9 +37,13 @@
 #include "netsocket/MeshInterface.h"
 
 #include "netsocket/Socket.h"
+#include "netsocket/NetworkBuffer.h"
 #include "netsocket/UDPSocket.h"
 #include "netsocket/TCPSocket.h"
 #include "netsocket/TCPServer.h"
+#include "netsocket/SocketSet.h"
+#include "netsocket/TLSSocket.h"
+#include "netsocket/DTLSSocket.h"
 
 #endif
 
@@ -16,20 +16,44 @@
  */
 #include "nsapi_dns.h"
 #include "netsocket/UDPSocket.h"
+#include "rtos/Semaphore.h"
+#include "rtos/Thread.h"
+#include "platform/PlatformMutex.h"
+#include "platform/SingletonPtr.h"
+#include "cmsis_os2.h"
 #include <string.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <ctype.h>
+#include <new>
 
 #define CLASS_IN 1
 
 #define RR_A 1
+#define RR_SOA 6
 #define RR_AAAA 28
 
+#define RCODE_NXDOMAIN 3
+
 // DNS options
 #define DNS_BUFFER_SIZE 512
 #define DNS_TIMEOUT 5000
 #define DNS_SERVERS_SIZE 5
 
+// Addresses kept per cached name, larger queries go to the network
+#define DNS_CACHE_ADDRESSES 4
+
+// Upper bound on how long an answer is trusted, whatever its TTL says
+#define DNS_CACHE_TTL_MAX 86400
+
+#ifndef MBED_CONF_NSAPI_DNS_CACHE_SIZE
+#define MBED_CONF_NSAPI_DNS_CACHE_SIZE 3
+#endif
+
+#ifndef MBED_CONF_NSAPI_DNS_THREAD_STACKSIZE
+#define MBED_CONF_NSAPI_DNS_THREAD_STACKSIZE 2048
+#endif
+
 nsapi_addr_t dns_servers[DNS_SERVERS_SIZE] = {
     {NSAPI_IPv4, {8, 8, 8, 8}},                             // Google
     {NSAPI_IPv4, {209, 244, 0, 3}},                         // Level 3
@@ -83,11 +107,35 @@ static uint16_t dns_scan_word(const uint8_t **p)
     return (a << 8) | b;
 }
 
+static uint32_t dns_scan_dword(const uint8_t **p)
+{
+    uint32_t a = dns_scan_word(p);
+    uint32_t b = dns_scan_word(p);
+    return (a << 16) | b;
+}
+
+static bool dns_skip_name(const uint8_t **p, const uint8_t *end)
+{
+    while (*p < end) {
+        uint8_t len = dns_scan_byte(p);
+        if (len == 0) {
+            return true;
+        } else if ((len & 0xc0) == 0xc0) { // this is link
+            *p += 1;
+            return *p <= end;
+        }
+
+        *p += len;
+    }
+
+    return false;
+}
+
 
-static void dns_append_question(uint8_t **p, const char *host, nsapi_version_t version)
+static void dns_append_question(uint8_t **p, uint16_t id, const char *host, nsapi_version_t version)
 {
     // fill the header
-    dns_append_word(p, 1);      // id      = 1
+    dns_append_word(p, id);     // id
     dns_append_word(p, 0x0100); // flags   = recursion required
     dns_append_word(p, 1);      // qdcount = 1
     dns_append_word(p, 0);      // ancount = 0
@@ -112,98 +160,157 @@ static void dns_append_question(uint8_t **p, const char *host, nsapi_version_t v
     dns_append_word(p, CLASS_IN);
 }
 
-static int dns_scan_response(const uint8_t **p, nsapi_addr_t *addr, unsigned addr_count)
+// Scans a response to the query with the given id. Returns the number of
+// addresses found, 0 if the server says there are none, or -1 if this is
+// not a usable answer and another server should be given the chance.
+// ttl is set to how long the answer may be cached, in seconds.
+static int dns_scan_response(const uint8_t *packet, size_t len, uint16_t id,
+        nsapi_addr_t *addr, unsigned addr_count, uint32_t *ttl)
 {
+    const uint8_t *p = packet;
+    const uint8_t *end = packet + len;
+    *ttl = 0;
+
+    if (len < 12) {
+        return -1;
+    }
+
     // scan header
-    uint16_t id    = dns_scan_word(p);
-    uint16_t flags = dns_scan_word(p);
+    uint16_t rid   = dns_scan_word(&p);
+    uint16_t flags = dns_scan_word(&p);
     bool    qr     = 0x1 & (flags >> 15);
     uint8_t opcode = 0xf & (flags >> 11);
     uint8_t rcode  = 0xf & (flags >>  0);
 
-    uint16_t qdcount = dns_scan_word(p); // qdcount
-    uint16_t ancount = dns_scan_word(p); // ancount
-    dns_scan_word(p);                    // nscount
-    dns_scan_word(p);                    // arcount
+    uint16_t qdcount = dns_scan_word(&p);
+    uint16_t ancount = dns_scan_word(&p);
+    uint16_t nscount = dns_scan_word(&p);
+    dns_scan_word(&p);                    // arcount
 
-    // verify header is response to query
-    if (!(id == 1 && qr && opcode == 0 && rcode == 0)) {
-        return 0;
+    // verify header is response to query, anything but an answer or
+    // a definite "no such name" leaves the question to the other servers
+    if (!(rid == id && qr && opcode == 0)) {
+        return -1;
+    }
+
+    if (rcode != 0 && rcode != RCODE_NXDOMAIN) {
+        return -1;
     }
 
     // skip questions
     for (int i = 0; i < qdcount; i++) {
-        while (true) {
-            uint8_t len = dns_scan_byte(p);
-            if (len == 0) {
-                break;
-            }
-
-            *p += len;
+        if (!dns_skip_name(&p, end) || p + 4 > end) {
+            return -1;
         }
 
-        dns_scan_word(p); // qtype
-        dns_scan_word(p); // qclass
+        dns_scan_word(&p); // qtype
+        dns_scan_word(&p); // qclass
     }
 
-    // scan each response
+    // scan each response, the answer lives as long as the shortest
+    // lived record in it, including any CNAMEs on the way
     unsigned count = 0;
+    uint32_t min_ttl = DNS_CACHE_TTL_MAX;
 
-    for (int i = 0; i < ancount && count < addr_count; i++) {
-        while (true) {
-            uint8_t len = dns_scan_byte(p);
-            if (len == 0) {
-                break;
-            } else if (len & 0xc0) { // this is link
-                dns_scan_byte(p);
-                break;
-            }
+    for (int i = 0; i < ancount; i++) {
+        if (!dns_skip_name(&p, end) || p + 10 > end) {
+            return -1;
+        }
 
-            *p += len;
+        uint16_t rtype    = dns_scan_word(&p);
+        uint16_t rclass   = dns_scan_word(&p);
+        uint32_t rttl     = dns_scan_dword(&p);
+        uint16_t rdlength = dns_scan_word(&p);
+
+        if (p + rdlength > end) {
+            return -1;
         }
 
-        uint16_t rtype    = dns_scan_word(p); // rtype
-        uint16_t rclass   = dns_scan_word(p); // rclass
-        *p += 4;                              // ttl
-        uint16_t rdlength = dns_scan_word(p); // rdlength
+        if (rttl < min_ttl) {
+            min_ttl = rttl;
+        }
 
-        if (rtype == RR_A && rclass == CLASS_IN && rdlength == NSAPI_IPv4_BYTES) {
+        if (count < addr_count && rtype == RR_A && rclass == CLASS_IN
+                && rdlength == NSAPI_IPv4_BYTES) {
             // accept A record
             addr->version = NSAPI_IPv4;
-            for (int i = 0; i < NSAPI_IPv4_BYTES; i++) {
-                addr->bytes[i] = dns_scan_byte(p);
-            }
-
+            memcpy(addr->bytes, p, NSAPI_IPv4_BYTES);
             addr += 1;
             count += 1;
-        } else if (rtype == RR_AAAA && rclass == CLASS_IN && rdlength == NSAPI_IPv6_BYTES) {
+        } else if (count < addr_count && rtype == RR_AAAA && rclass == CLASS_IN
+                && rdlength == NSAPI_IPv6_BYTES) {
             // accept AAAA record
             addr->version = NSAPI_IPv6;
-            for (int i = 0; i < NSAPI_IPv6_BYTES; i++) {
-                addr->bytes[i] = dns_scan_byte(p);
-            }
-
+            memcpy(addr->bytes, p, NSAPI_IPv6_BYTES);
             addr += 1;
             count += 1;
-        } else {
-            // skip unrecognized records
-            *p += rdlength;
         }
+
+        p += rdlength;
+    }
+
+    if (count > 0) {
+        *ttl = min_ttl;
+        return count;
+    }
+
+    // no addresses, a negative answer may be cached for the lesser of
+    // the SOA's TTL and its MINIMUM field (RFC 2308), without an SOA it
+    // is not cached at all
+    for (int i = 0; i < nscount; i++) {
+        if (!dns_skip_name(&p, end) || p + 10 > end) {
+            break;
+        }
+
+        uint16_t rtype    = dns_scan_word(&p);
+        dns_scan_word(&p);                    // rclass
+        uint32_t rttl     = dns_scan_dword(&p);
+        uint16_t rdlength = dns_scan_word(&p);
+
+        if (p + rdlength > end) {
+            break;
+        }
+
+        if (rtype == RR_SOA && rdlength >= 22) {
+            const uint8_t *minimum = p + rdlength - 4;
+            uint32_t rminimum = dns_scan_dword(&minimum);
+            *ttl = rminimum < rttl ? rminimum : rttl;
+            if (*ttl > DNS_CACHE_TTL_MAX) {
+                *ttl = DNS_CACHE_TTL_MAX;
+            }
+            break;
+        }
+
+        p += rdlength;
     }
 
-    return count;
+    return 0;
 }
 
-// core query function
-static nsapi_size_or_error_t nsapi_dns_query_multiple(NetworkStack *stack, const char *host,
-        nsapi_addr_t *addr, unsigned addr_count, nsapi_version_t version)
+// Milliseconds since boot
+static uint64_t dns_time()
 {
-    // check for valid host name
-    int host_len = host ? strlen(host) : 0;
-    if (host_len > 128 || host_len == 0) {
-        return NSAPI_ERROR_PARAMETER;
+    return osKernelGetTickCount() * 1000 / osKernelGetTickFreq();
+}
+
+static bool dns_is_server(const SocketAddress &address)
+{
+    for (unsigned i = 0; i < DNS_SERVERS_SIZE; i++) {
+        if (address == SocketAddress(dns_servers[i], 53)) {
+            return true;
+        }
     }
 
+    return false;
+}
+
+// Asks every server at once and takes the first answer, rather than
+// sitting out a full timeout for each server that is down
+static nsapi_size_or_error_t nsapi_dns_query_servers(NetworkStack *stack, const char *host,
+        nsapi_addr_t *addr, unsigned addr_count, nsapi_version_t version, uint32_t *ttl)
+{
+    *ttl = 0;
+
     // create a udp socket
     UDPSocket socket;
     int err = socket.open(stack);
@@ -211,43 +318,61 @@ static nsapi_size_or_error_t nsapi_dns_query_multiple(NetworkStack *stack, const
         return err;
     }
 
-    socket.set_timeout(DNS_TIMEOUT);
-
     // create network packet
     uint8_t *packet = (uint8_t *)malloc(DNS_BUFFER_SIZE);
     if (!packet) {
         return NSAPI_ERROR_NO_MEMORY;
     }
 
-    nsapi_size_or_error_t result = NSAPI_ERROR_DNS_FAILURE;
+    // a fresh id for each query, so a late answer to an earlier one
+    // is not mistaken for this one
+    uint16_t id = rand() & 0xffff;
+    uint8_t *question = packet;
+    dns_append_question(&question, id, host, version);
 
-    // check against each dns server
+    unsigned pending = 0;
     for (unsigned i = 0; i < DNS_SERVERS_SIZE; i++) {
-        // send the question
-        uint8_t *question = packet;
-        dns_append_question(&question, host, version);
-
         err = socket.sendto(SocketAddress(dns_servers[i], 53), packet, question - packet);
         // send may fail for various reasons, including wrong address type - move on
-        if (err < 0) {
-            continue;
+        if (err >= 0) {
+            pending += 1;
+        }
+    }
+
+    nsapi_size_or_error_t result = NSAPI_ERROR_DNS_FAILURE;
+    uint64_t start = dns_time();
+
+    while (pending > 0) {
+        uint64_t elapsed = dns_time() - start;
+        if (elapsed >= DNS_TIMEOUT) {
+            break;
         }
 
+        socket.set_timeout(DNS_TIMEOUT - elapsed);
+
         // recv the response
-        err = socket.recvfrom(NULL, packet, DNS_BUFFER_SIZE);
+        SocketAddress from;
+        err = socket.recvfrom(&from, packet, DNS_BUFFER_SIZE);
         if (err == NSAPI_ERROR_WOULD_BLOCK) {
-            continue;
+            break;
         } else if (err < 0) {
             result = err;
             break;
         }
 
-        const uint8_t *response = packet;
-        if (dns_scan_response(&response, addr, addr_count) > 0) {
-            result = NSAPI_ERROR_OK;
+        int count = dns_scan_response(packet, err, id, addr, addr_count, ttl);
+        if (count < 0) {
+            // a server that could not answer is done, keep waiting for the rest
+            if (dns_is_server(from)) {
+                pending -= 1;
+            }
+            continue;
         }
 
-        /* The DNS response is final, no need to check other servers */
+        /* The DNS response is final, no need to wait for other servers */
+        if (count > 0) {
+            result = count;
+        }
         break;
     }
 
@@ -264,6 +389,202 @@ static nsapi_size_or_error_t nsapi_dns_query_multiple(NetworkStack *stack, const
     return result;
 }
 
+
+// DNS cache
+//
+// Answers are kept for as long as their TTL allows, negative answers
+// included. An entry stays in the cache while its query is in flight,
+// so that concurrent lookups of the same name wait for that query
+// instead of sending their own.
+struct dns_cache_entry {
+    char *host;
+    nsapi_version_t version;
+    bool pending;
+    unsigned waiters;
+    nsapi_size_or_error_t result;
+    nsapi_addr_t addrs[DNS_CACHE_ADDRESSES];
+    uint64_t expires;
+    uint64_t accessed;
+    rtos::Semaphore done;
+};
+
+static SingletonPtr<PlatformMutex> dns_mutex;
+static dns_cache_entry *dns_cache;
+
+static bool dns_host_equal(const char *a, const char *b)
+{
+    while (*a && tolower((unsigned char)*a) == tolower((unsigned char)*b)) {
+        a++;
+        b++;
+    }
+
+    return *a == *b;
+}
+
+static dns_cache_entry *dns_cache_find(const char *host, nsapi_version_t version)
+{
+    if (!dns_cache) {
+        dns_cache = new dns_cache_entry[MBED_CONF_NSAPI_DNS_CACHE_SIZE];
+        for (unsigned i = 0; i < MBED_CONF_NSAPI_DNS_CACHE_SIZE; i++) {
+            dns_cache[i].host = NULL;
+            dns_cache[i].pending = false;
+            dns_cache[i].waiters = 0;
+        }
+    }
+
+    for (unsigned i = 0; i < MBED_CONF_NSAPI_DNS_CACHE_SIZE; i++) {
+        if (dns_cache[i].host && dns_cache[i].version == version
+                && dns_host_equal(dns_cache[i].host, host)) {
+            return &dns_cache[i];
+        }
+    }
+
+    return NULL;
+}
+
+// Claims an entry for a new name, an expired entry is preferred over
+// the least recently used one. Entries with a query in flight, or with
+// lookups still waiting to copy out the result, are never taken.
+static dns_cache_entry *dns_cache_alloc(const char *host, nsapi_version_t version)
+{
+    uint64_t now = dns_time();
+    dns_cache_entry *entry = NULL;
+
+    for (unsigned i = 0; i < MBED_CONF_NSAPI_DNS_CACHE_SIZE; i++) {
+        dns_cache_entry *candidate = &dns_cache[i];
+        if (candidate->pending || candidate->waiters) {
+            continue;
+        }
+
+        if (!candidate->host || candidate->expires <= now) {
+            entry = candidate;
+            break;
+        }
+
+        if (!entry || candidate->accessed < entry->accessed) {
+            entry = candidate;
+        }
+    }
+
+    if (!entry) {
+        return NULL;
+    }
+
+    size_t host_len = strlen(host);
+    char *copy = (char *)malloc(host_len + 1);
+    if (!copy) {
+        return NULL;
+    }
+
+    memcpy(copy, host, host_len + 1);
+    free(entry->host);
+    entry->host = copy;
+    entry->version = version;
+    entry->accessed = now;
+    return entry;
+}
+
+static nsapi_size_or_error_t dns_cache_copy(dns_cache_entry *entry,
+        nsapi_addr_t *addr, unsigned addr_count)
+{
+    entry->accessed = dns_time();
+
+    nsapi_size_or_error_t result = entry->result;
+    if (result > (nsapi_size_or_error_t)addr_count) {
+        result = addr_count;
+    }
+
+    for (int i = 0; i < result; i++) {
+        addr[i] = entry->addrs[i];
+    }
+
+    return result;
+}
+
+// core query function
+static nsapi_size_or_error_t nsapi_dns_query_multiple(NetworkStack *stack, const char *host,
+        nsapi_addr_t *addr, unsigned addr_count, nsapi_version_t version)
+{
+    // check for valid host name
+    int host_len = host ? strlen(host) : 0;
+    if (host_len > 128 || host_len == 0) {
+        return NSAPI_ERROR_PARAMETER;
+    }
+
+    // anything but IPv6 is asked for as an A record
+    if (version != NSAPI_IPv6) {
+        version = NSAPI_IPv4;
+    }
+
+    dns_mutex->lock();
+    dns_cache_entry *entry = dns_cache_find(host, version);
+
+    if (entry && entry->pending) {
+        // someone is already asking, share their answer
+        entry->waiters += 1;
+        dns_mutex->unlock();
+        entry->done.wait();
+
+        dns_mutex->lock();
+        nsapi_size_or_error_t result = dns_cache_copy(entry, addr, addr_count);
+        entry->waiters -= 1;
+        dns_mutex->unlock();
+        return result;
+    }
+
+    if (entry && entry->expires > dns_time() &&
+            !(entry->result == DNS_CACHE_ADDRESSES && addr_count > DNS_CACHE_ADDRESSES)) {
+        nsapi_size_or_error_t result = dns_cache_copy(entry, addr, addr_count);
+        dns_mutex->unlock();
+        return result;
+    }
+
+    if (!entry) {
+        entry = dns_cache_alloc(host, version);
+    } else if (entry->waiters) {
+        // stale, but lookups are still copying out the previous answer
+        entry = NULL;
+    }
+
+    if (entry) {
+        entry->pending = true;
+    }
+    dns_mutex->unlock();
+
+    // ask the servers for at least as many addresses as the cache holds
+    unsigned count = addr_count > DNS_CACHE_ADDRESSES ? addr_count : DNS_CACHE_ADDRESSES;
+    nsapi_addr_t *addrs = new nsapi_addr_t[count];
+    uint32_t ttl;
+    nsapi_size_or_error_t result = nsapi_dns_query_servers(stack, host, addrs, count, version, &ttl);
+
+    if (entry) {
+        dns_mutex->lock();
+        entry->result = result > DNS_CACHE_ADDRESSES ? DNS_CACHE_ADDRESSES : result;
+        for (int i = 0; i < entry->result; i++) {
+            entry->addrs[i] = addrs[i];
+        }
+
+        // timeouts and errors come back with a ttl of 0 and are not kept
+        entry->expires = dns_time() + (uint64_t)ttl * 1000;
+        entry->pending = false;
+        for (unsigned i = 0; i < entry->waiters; i++) {
+            entry->done.release();
+        }
+        dns_mutex->unlock();
+    }
+
+    if (result > (nsapi_size_or_error_t)addr_count) {
+        result = addr_count;
+    }
+
+    for (int i = 0; i < result; i++) {
+        addr[i] = addrs[i];
+    }
+
+    delete[] addrs;
+    return result;
+}
+
 // convenience functions for other forms of queries
 extern "C" nsapi_size_or_error_t nsapi_dns_query_multiple(nsapi_stack_t *stack, const char *host,
         nsapi_addr_t *addr, nsapi_size_t addr_count, nsapi_version_t version)
@@ -304,3 +625,100 @@ nsapi_error_t nsapi_dns_query(NetworkStack *stack, const char *host,
     address->set_addr(addr);
     return (nsapi_error_t)((result > 0) ? 0 : result);
 }
+
+
+// Asynchronous lookups
+//
+// Requests are queued to a resolver thread, started on first use, which
+// runs them one at a time through the stack's gethostbyname. Lookups of
+// a name that is already being resolved are coalesced by the cache.
+struct dns_async_request {
+    dns_async_request *next;
+    NetworkStack *stack;
+    char *host;
+    nsapi_version_t version;
+    NetworkStack::hostbyname_cb_t callback;
+};
+
+static rtos::Thread *dns_thread;
+static rtos::Semaphore *dns_requests_queued;
+static dns_async_request *dns_requests_head;
+static dns_async_request *dns_requests_tail;
+
+static void nsapi_dns_thread()
+{
+    while (true) {
+        dns_requests_queued->wait();
+
+        dns_mutex->lock();
+        dns_async_request *request = dns_requests_head;
+        dns_requests_head = request->next;
+        if (!dns_requests_head) {
+            dns_requests_tail = NULL;
+        }
+        dns_mutex->unlock();
+
+        SocketAddress address;
+        nsapi_error_t err = request->stack->gethostbyname(request->host, &address, request->version);
+        request->callback(err, err ? NULL : &address);
+
+        free(request->host);
+        delete request;
+    }
+}
+
+nsapi_error_t nsapi_dns_query_async(NetworkStack *stack, const char *host,
+        NetworkStack::hostbyname_cb_t callback, nsapi_version_t version)
+{
+    // check for valid host name
+    int host_len = host ? strlen(host) : 0;
+    if (host_len > 128 || host_len == 0 || !callback) {
+        return NSAPI_ERROR_PARAMETER;
+    }
+
+    dns_async_request *request = new (std::nothrow) dns_async_request;
+    if (!request) {
+        return NSAPI_ERROR_NO_MEMORY;
+    }
+
+    request->host = (char *)malloc(host_len + 1);
+    if (!request->host) {
+        delete request;
+        return NSAPI_ERROR_NO_MEMORY;
+    }
+
+    memcpy(request->host, host, host_len + 1);
+    request->next = NULL;
+    request->stack = stack;
+    request->version = version;
+    request->callback = callback;
+
+    dns_mutex->lock();
+    if (!dns_thread) {
+        dns_requests_queued = new rtos::Semaphore(0);
+        dns_thread = new rtos::Thread(osPriorityNormal, MBED_CONF_NSAPI_DNS_THREAD_STACKSIZE);
+
+        if (dns_thread->start(nsapi_dns_thread) != osOK) {
+            delete dns_thread;
+            delete dns_requests_queued;
+            dns_thread = NULL;
+            dns_requests_queued = NULL;
+            dns_mutex->unlock();
+
+            free(request->host);
+            delete request;
+            return NSAPI_ERROR_NO_MEMORY;
+        }
+    }
+
+    if (dns_requests_tail) {
+        dns_requests_tail->next = request;
+    } else {
+        dns_requests_head = request;
+    }
+    dns_requests_tail = request;
+    dns_mutex->unlock();
+
+    dns_requests_queued->release();
+    return NSAPI_ERROR_OK;
+}
@@ -148,6 +148,22 @@ nsapi_size_or_error_t nsapi_dns_query_multiple(S *stack, const char *host,
                 host, addr, addr_count, version);
 }
 
+/** Query a domain name server for an IP address without blocking
+ *
+ *  The lookup is handed to a resolver thread, which resolves the name
+ *  with the stack's gethostbyname and then calls the callback from that
+ *  thread. The address passed to the callback is only valid for the
+ *  duration of the call, and is NULL if the lookup failed.
+ *
+ *  @param stack    Network stack as target for DNS query
+ *  @param host     Hostname to resolve
+ *  @param callback Callback to call with the result
+ *  @param version  IP version to resolve (defaults to NSAPI_UNSPEC)
+ *  @return         0 if the lookup was queued, negative error code on failure
+ */
+nsapi_error_t nsapi_dns_query_async(NetworkStack *stack, const char *host,
+        NetworkStack::hostbyname_cb_t callback, nsapi_version_t version = NSAPI_UNSPEC);
+
 /** Add a domain name server to list of servers to query
  *
  *  @param addr     Destination for the host address
@@ -0,0 +1,378 @@
+/* nsapi_tls.cpp
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "nsapi_tls.h"
+
+#if defined(MBEDTLS_SSL_CLI_C)
+
+#include "mbedtls/entropy.h"
+#include "mbedtls/ctr_drbg.h"
+#include "mbedtls/platform.h"
+#include "mbedtls/sha256.h"
+#include "mbedtls/ssl_internal.h"
+#include "platform/PlatformMutex.h"
+#include "platform/SingletonPtr.h"
+#include "cmsis_os2.h"
+#include <string.h>
+#include <stdlib.h>
+#include <ctype.h>
+
+#ifndef MBED_CONF_NSAPI_TLS_SESSION_CACHE_SIZE
+#define MBED_CONF_NSAPI_TLS_SESSION_CACHE_SIZE 2
+#endif
+
+static SingletonPtr<PlatformMutex> tls_mutex;
+
+
+// Random number generator
+static mbedtls_entropy_context tls_entropy;
+static mbedtls_ctr_drbg_context tls_drbg;
+static bool tls_drbg_seeded;
+
+int nsapi_tls_rng(void *ctx, unsigned char *output, size_t len)
+{
+    tls_mutex->lock();
+
+    int ret = 0;
+    if (!tls_drbg_seeded) {
+        mbedtls_entropy_init(&tls_entropy);
+        mbedtls_ctr_drbg_init(&tls_drbg);
+
+        static const char personalization[] = "nsapi_tls";
+        ret = mbedtls_ctr_drbg_seed(&tls_drbg, mbedtls_entropy_func, &tls_entropy,
+                (const unsigned char *)personalization, sizeof personalization - 1);
+        if (ret) {
+            mbedtls_ctr_drbg_free(&tls_drbg);
+            mbedtls_entropy_free(&tls_entropy);
+        } else {
+            tls_drbg_seeded = true;
+        }
+    }
+
+    if (!ret) {
+        ret = mbedtls_ctr_drbg_random(&tls_drbg, output, len);
+    }
+
+    tls_mutex->unlock();
+    return ret;
+}
+
+
+// Session cache
+//
+// One session per server and client configuration, so that reconnecting
+// to a server resumes the last session with it instead of paying for a
+// full handshake. The server decides whether a session is still good, a
+// session it refuses is simply replaced by the one the full handshake
+// establishes.
+//
+// A resumed handshake skips the checks of the full one, so a session is
+// only offered by a socket that would have negotiated it the same way:
+// same port, transport, authentication mode, trusted CAs and own
+// certificate. The configuration is kept as a digest of those.
+//
+// The peer's certificate chain is dropped from cached sessions. It is
+// only read during a full handshake, and would otherwise cost several
+// times the size of the rest of the session.
+#define TLS_CONFIG_ID_SIZE 32
+
+struct tls_cache_entry {
+    char *host;
+    uint16_t port;
+    unsigned char config[TLS_CONFIG_ID_SIZE];
+    uint64_t accessed;
+    mbedtls_ssl_session session;
+};
+
+static tls_cache_entry tls_cache[MBED_CONF_NSAPI_TLS_SESSION_CACHE_SIZE];
+
+static uint64_t tls_time()
+{
+    return osKernelGetTickCount() * 1000 / osKernelGetTickFreq();
+}
+
+static bool tls_host_equal(const char *a, const char *b)
+{
+    while (*a && tolower((unsigned char)*a) == tolower((unsigned char)*b)) {
+        a++;
+        b++;
+    }
+
+    return *a == *b;
+}
+
+#if defined(MBEDTLS_SHA256_C)
+static void tls_config_hash(mbedtls_sha256_context *sha, unsigned char tag,
+        const unsigned char *data, size_t len)
+{
+    // Tagged and length prefixed, so that no two configurations hash the
+    // same input
+    unsigned char prefix[5] = {
+        tag,
+        (unsigned char)(len >> 24),
+        (unsigned char)(len >> 16),
+        (unsigned char)(len >> 8),
+        (unsigned char)(len),
+    };
+    mbedtls_sha256_update(sha, prefix, sizeof prefix);
+    mbedtls_sha256_update(sha, data, len);
+}
+#endif
+
+#if defined(MBEDTLS_X509_CRT_PARSE_C)
+// Whether a certificate appears earlier in its chain. Parsing the same
+// CA twice adds it twice, but trusts nothing more.
+static bool tls_crt_repeated(const mbedtls_x509_crt *chain, const mbedtls_x509_crt *crt)
+{
+    for (; chain != crt; chain = chain->next) {
+        if (chain->raw.len == crt->raw.len
+                && memcmp(chain->raw.p, crt->raw.p, crt->raw.len) == 0) {
+            return true;
+        }
+    }
+
+    return false;
+}
+#endif
+
+// Digest of the parts of a client configuration a session depends on
+static nsapi_error_t tls_config_id(const mbedtls_ssl_config *conf, unsigned char *id)
+{
+#if defined(MBEDTLS_SHA256_C)
+    mbedtls_sha256_context sha;
+    mbedtls_sha256_init(&sha);
+    mbedtls_sha256_starts(&sha, 0);
+
+    unsigned char mode[2] = { (unsigned char)conf->transport, (unsigned char)conf->authmode };
+    tls_config_hash(&sha, 'M', mode, sizeof mode);
+
+#if defined(MBEDTLS_X509_CRT_PARSE_C)
+    tls_config_hash(&sha, 'V', (const unsigned char *)&conf->f_vrfy, sizeof conf->f_vrfy);
+    tls_config_hash(&sha, 'P', (const unsigned char *)&conf->p_vrfy, sizeof conf->p_vrfy);
+
+    for (const mbedtls_x509_crt *crt = conf->ca_chain; crt; crt = crt->next) {
+        if (!tls_crt_repeated(conf->ca_chain, crt)) {
+            tls_config_hash(&sha, 'C', crt->raw.p, crt->raw.len);
+        }
+    }
+
+#if defined(MBEDTLS_X509_CRL_PARSE_C)
+    for (const mbedtls_x509_crl *crl = conf->ca_crl; crl; crl = crl->next) {
+        tls_config_hash(&sha, 'R', crl->raw.p, crl->raw.len);
+    }
+#endif
+
+    for (const mbedtls_ssl_key_cert *key_cert = conf->key_cert; key_cert; key_cert = key_cert->next) {
+        for (const mbedtls_x509_crt *crt = key_cert->cert; crt; crt = crt->next) {
+            tls_config_hash(&sha, 'O', crt->raw.p, crt->raw.len);
+        }
+    }
+#endif
+
+    mbedtls_sha256_finish(&sha, id);
+    mbedtls_sha256_free(&sha);
+    return NSAPI_ERROR_OK;
+#else
+    // Without a digest configurations can't be told apart, nothing is cached
+    (void)conf;
+    (void)id;
+    return NSAPI_ERROR_UNSUPPORTED;
+#endif
+}
+
+static tls_cache_entry *tls_cache_find(const char *host, uint16_t port, const unsigned char *config)
+{
+    for (unsigned i = 0; i < MBED_CONF_NSAPI_TLS_SESSION_CACHE_SIZE; i++) {
+        if (tls_cache[i].host && tls_cache[i].port == port
+                && memcmp(tls_cache[i].config, config, TLS_CONFIG_ID_SIZE) == 0
+                && tls_host_equal(tls_cache[i].host, host)) {
+            return &tls_cache[i];
+        }
+    }
+
+    return NULL;
+}
+
+static void tls_cache_clear(tls_cache_entry *entry)
+{
+    free(entry->host);
+    entry->host = NULL;
+    mbedtls_ssl_session_free(&entry->session);
+}
+
+// Deep copy of a session without its certificate chain. Whatever the
+// session points to is released by mbedtls_ssl_session_free, so it comes
+// from the allocator of mbed TLS.
+static nsapi_error_t tls_session_copy(mbedtls_ssl_session *dst, const mbedtls_ssl_session *src)
+{
+    memcpy(dst, src, sizeof(mbedtls_ssl_session));
+#if defined(MBEDTLS_X509_CRT_PARSE_C)
+    dst->peer_cert = NULL;
+#endif
+
+#if defined(MBEDTLS_SSL_SESSION_TICKETS)
+    if (src->ticket) {
+        dst->ticket = (unsigned char *)mbedtls_calloc(1, src->ticket_len);
+        if (!dst->ticket) {
+            dst->ticket_len = 0;
+            return NSAPI_ERROR_NO_MEMORY;
+        }
+
+        memcpy(dst->ticket, src->ticket, src->ticket_len);
+    }
+#endif
+
+    return NSAPI_ERROR_OK;
+}
+
+nsapi_error_t nsapi_tls_session_get(const char *host, uint16_t port,
+        const mbedtls_ssl_config *conf, mbedtls_ssl_session *session)
+{
+    unsigned char config[TLS_CONFIG_ID_SIZE];
+    if (tls_config_id(conf, config) != NSAPI_ERROR_OK) {
+        return NSAPI_ERROR_NO_ADDRESS;
+    }
+
+    tls_mutex->lock();
+
+    nsapi_error_t ret = NSAPI_ERROR_NO_ADDRESS;
+    tls_cache_entry *entry = tls_cache_find(host, port, config);
+    if (entry) {
+        entry->accessed = tls_time();
+        mbedtls_ssl_session_free(session);
+        ret = tls_session_copy(session, &entry->session);
+    }
+
+    tls_mutex->unlock();
+    return ret;
+}
+
+nsapi_error_t nsapi_tls_session_set(const char *host, uint16_t port, const mbedtls_ssl_context *ssl)
+{
+    unsigned char config[TLS_CONFIG_ID_SIZE];
+    nsapi_error_t err = tls_config_id(ssl->conf, config);
+    if (err) {
+        return err;
+    }
+
+    // Copy the session out of the context before taking the cache lock,
+    // the chain is copied and dropped again here
+    mbedtls_ssl_session session;
+    mbedtls_ssl_session_init(&session);
+    if (mbedtls_ssl_get_session(ssl, &session) != 0) {
+        mbedtls_ssl_session_free(&session);
+        return NSAPI_ERROR_NO_MEMORY;
+    }
+
+#if defined(MBEDTLS_X509_CRT_PARSE_C)
+    if (session.peer_cert) {
+        mbedtls_x509_crt_free(session.peer_cert);
+        mbedtls_free(session.peer_cert);
+        session.peer_cert = NULL;
+    }
+#endif
+
+    size_t host_len = strlen(host);
+    char *copy = (char *)malloc(host_len + 1);
+    if (!copy) {
+        mbedtls_ssl_session_free(&session);
+        return NSAPI_ERROR_NO_MEMORY;
+    }
+    memcpy(copy, host, host_len + 1);
+
+    tls_mutex->lock();
+
+    tls_cache_entry *entry = tls_cache_find(host, port, config);
+    if (!entry) {
+        for (unsigned i = 0; i < MBED_CONF_NSAPI_TLS_SESSION_CACHE_SIZE; i++) {
+            tls_cache_entry *candidate = &tls_cache[i];
+            if (!candidate->host) {
+                entry = candidate;
+                break;
+            }
+
+            if (!entry || candidate->accessed < entry->accessed) {
+                entry = candidate;
+            }
+        }
+    }
+
+    if (entry->host) {
+        tls_cache_clear(entry);
+    }
+
+    // The entry takes over the session's ticket
+    entry->host = copy;
+    entry->port = port;
+    memcpy(entry->config, config, TLS_CONFIG_ID_SIZE);
+    entry->accessed = tls_time();
+    entry->session = session;
+
+    tls_mutex->unlock();
+    return NSAPI_ERROR_OK;
+}
+
+void nsapi_tls_session_remove(const char *host)
+{
+    tls_mutex->lock();
+
+    for (unsigned i = 0; i < MBED_CONF_NSAPI_TLS_SESSION_CACHE_SIZE; i++) {
+        if (tls_cache[i].host && (!host || tls_host_equal(tls_cache[i].host, host))) {
+            tls_cache_clear(&tls_cache[i]);
+        }
+    }
+
+    tls_mutex->unlock();
+}
+
+
+// Handshake statistics
+static nsapi_tls_stats_t tls_stats;
+
+void nsapi_tls_record_handshake(nsapi_error_t result, bool resumed, uint32_t time)
+{
+    tls_mutex->lock();
+
+    if (result) {
+        tls_stats.failed += 1;
+    } else if (resumed) {
+        tls_stats.resumed += 1;
+        tls_stats.resumed_time += time;
+    } else {
+        tls_stats.full += 1;
+        tls_stats.full_time += time;
+    }
+
+    if (!result && time > tls_stats.max_time) {
+        tls_stats.max_time = time;
+    }
+
+    tls_mutex->unlock();
+}
+
+void nsapi_tls_get_stats(nsapi_tls_stats_t *stats, bool reset)
+{
+    tls_mutex->lock();
+
+    *stats = tls_stats;
+    if (reset) {
+        memset(&tls_stats, 0, sizeof tls_stats);
+    }
+
+    tls_mutex->unlock();
+}
+
+#endif
@@ -0,0 +1,110 @@
+/** \addtogroup netsocket */
+/** @{*/
+/* nsapi_tls.h
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef NSAPI_TLS_H
+#define NSAPI_TLS_H
+
+#include "nsapi_types.h"
+#include "mbedtls/ssl.h"
+
+#if defined(MBEDTLS_SSL_CLI_C)
+
+
+/** Handshake statistics of all TLS and DTLS sockets
+ */
+typedef struct nsapi_tls_stats {
+    uint32_t full;              /*!< Full handshakes completed */
+    uint32_t resumed;           /*!< Handshakes that resumed a cached session */
+    uint32_t failed;            /*!< Handshakes that failed */
+    uint32_t full_time;         /*!< Time spent in full handshakes, in milliseconds */
+    uint32_t resumed_time;      /*!< Time spent in resumed handshakes, in milliseconds */
+    uint32_t max_time;          /*!< Longest handshake, in milliseconds */
+} nsapi_tls_stats_t;
+
+/** Random number generator shared by the TLS and DTLS sockets
+ *
+ *  A CTR_DRBG seeded from the default entropy sources on first use,
+ *  with the signature of mbedtls_ssl_conf_rng's callback. Thread safe.
+ *
+ *  @param ctx      Unused, may be NULL
+ *  @param output   Destination for the random bytes
+ *  @param len      Number of random bytes to generate
+ *  @return         0 on success, negative mbed TLS error code on failure
+ */
+int nsapi_tls_rng(void *ctx, unsigned char *output, size_t len);
+
+/** Look up the cached session of a server
+ *
+ *  Sessions are only shared by clients with the same transport,
+ *  authentication mode, trusted CAs and own certificate, so that a
+ *  resumed handshake never skips a check the client's configuration
+ *  asks for.
+ *
+ *  On success the session is copied into session, which must have been
+ *  initialized with mbedtls_ssl_session_init and is to be released with
+ *  mbedtls_ssl_session_free. Cached sessions do not keep the peer's
+ *  certificate chain.
+ *
+ *  @param host     Name of the server
+ *  @param port     Port of the server
+ *  @param conf     Configuration of the client that would resume the session
+ *  @param session  Destination for the session
+ *  @return         0 on success, negative error code on failure
+ *                  NSAPI_ERROR_NO_ADDRESS indicates no session is cached
+ */
+nsapi_error_t nsapi_tls_session_get(const char *host, uint16_t port,
+        const mbedtls_ssl_config *conf, mbedtls_ssl_session *session);
+
+/** Cache the session of an established connection
+ *
+ *  Replaces any session cached for the same server and client
+ *  configuration, or else the least recently used one.
+ *
+ *  @param host     Name of the server
+ *  @param port     Port of the server
+ *  @param ssl      Client context that has completed a handshake
+ *  @return         0 on success, negative error code on failure
+ */
+nsapi_error_t nsapi_tls_session_set(const char *host, uint16_t port, const mbedtls_ssl_context *ssl);
+
+/** Forget the cached sessions of a server
+ *
+ *  @param host     Name of the server, or NULL to forget all sessions
+ */
+void nsapi_tls_session_remove(const char *host);
+
+/** Record a handshake in the statistics
+ *
+ *  @param result   0 if the handshake completed, negative error code otherwise
+ *  @param resumed  True if the handshake resumed a cached session
+ *  @param time     Duration of the handshake in milliseconds
+ */
+void nsapi_tls_record_handshake(nsapi_error_t result, bool resumed, uint32_t time);
+
+/** Get the handshake statistics
+ *
+ *  @param stats    Destination for the statistics
+ *  @param reset    True to clear the statistics after reading them
+ */
+void nsapi_tls_get_stats(nsapi_tls_stats_t *stats, bool reset = false);
+
+
+#endif
+
+#endif
+
+/** @}*/
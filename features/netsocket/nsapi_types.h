@@ -155,6 +155,45 @@ typedef struct nsapi_addr {
 typedef void *nsapi_socket_t;
 
 
+/** Zero-copy receive buffer
+ *
+ *  Describes received data that is still held in the network stack's own
+ *  memory. The contents are read in place through the stack's
+ *  buffer_segment call, and the memory stays allocated to the buffer until
+ *  it is handed back with buffer_release.
+ */
+typedef struct nsapi_buffer {
+    /** Stack-specific handle to the underlying memory
+     *  NULL if the buffer is empty
+     */
+    void *handle;
+
+    /** Stack-specific offset of the first byte of data in handle
+     */
+    nsapi_size_t offset;
+
+    /** Number of bytes of data in the buffer
+     */
+    nsapi_size_t size;
+} nsapi_buffer_t;
+
+
+/** Scatter-gather vector
+ *
+ *  Describes one contiguous piece of a message passed to sendmsg or
+ *  recvmsg. The pieces of a message are sent or received in array order.
+ */
+typedef struct nsapi_iovec {
+    /** Start of the piece of the message
+     */
+    void *iov_base;
+
+    /** Number of bytes in the piece
+     */
+    nsapi_size_t iov_len;
+} nsapi_iovec_t;
+
+
 /** Enum of socket protocols
  *
  *  The socket protocol specifies a particular protocol to
@@ -214,6 +253,8 @@ typedef enum nsapi_socket_option {
     NSAPI_LINGER,    /*!< Keeps close from returning until queues empty */
     NSAPI_SNDBUF,    /*!< Sets send buffer size */
     NSAPI_RCVBUF,    /*!< Sets recv buffer size */
+    NSAPI_RCVPENDING, /*!< Gets number of bytes ready to recv, or size of the next datagram */
+    NSAPI_TCP_NODELAY, /*!< Sends small writes straight away instead of holding them back */
 } nsapi_socket_option_t;
 
 /* Backwards compatibility - previously didn't distinguish stack and socket options */
@@ -543,6 +584,145 @@ typedef struct nsapi_stack_api
      */    
     nsapi_error_t (*getsockopt)(nsapi_stack_t *stack, nsapi_socket_t socket, int level,
             int optname, void *optval, unsigned *optlen);
+
+    /** Receive data over a TCP socket without copying
+     *
+     *  The socket must be connected to a remote host. Up to size bytes of
+     *  received data are handed over in buffer, which must be released
+     *  with buffer_release once the data has been consumed. Returns the
+     *  number of bytes in the buffer.
+     *
+     *  This call is non-blocking. If recv_buffer would block,
+     *  NSAPI_ERROR_WOULD_BLOCK is returned immediately.
+     *
+     *  @param stack    Stack handle
+     *  @param socket   Socket handle
+     *  @param buffer   Destination for the received buffer
+     *  @param size     Maximum number of bytes to receive
+     *  @return         Number of received bytes on success, negative error
+     *                  code on failure
+     */
+    nsapi_size_or_error_t (*socket_recv_buffer)(nsapi_stack_t *stack, nsapi_socket_t socket,
+            nsapi_buffer_t *buffer, nsapi_size_t size);
+
+    /** Receive a packet over a UDP socket without copying
+     *
+     *  The whole datagram is handed over in buffer, which must be released
+     *  with buffer_release once the data has been consumed. Stores the
+     *  source address in address if address is not NULL. Returns the
+     *  number of bytes in the buffer.
+     *
+     *  This call is non-blocking. If recvfrom_buffer would block,
+     *  NSAPI_ERROR_WOULD_BLOCK is returned immediately.
+     *
+     *  @param stack    Stack handle
+     *  @param socket   Socket handle
+     *  @param addr     Destination for the address of the remote host
+     *  @param port     Destination for the port of the remote host
+     *  @param buffer   Destination for the received buffer
+     *  @return         Number of received bytes on success, negative error
+     *                  code on failure
+     */
+    nsapi_size_or_error_t (*socket_recvfrom_buffer)(nsapi_stack_t *stack, nsapi_socket_t socket,
+            nsapi_addr_t *addr, uint16_t *port, nsapi_buffer_t *buffer);
+
+    /** Get a contiguous segment of a received buffer
+     *
+     *  Returns the number of contiguous bytes stored at offset into the
+     *  buffer and points data at the first of them. Returns 0 if offset
+     *  is past the end of the buffer.
+     *
+     *  @param stack    Stack handle
+     *  @param buffer   Buffer from socket_recv_buffer or socket_recvfrom_buffer
+     *  @param offset   Offset into the buffer in bytes
+     *  @param data     Destination for a pointer to the segment
+     *  @return         Number of bytes in the segment
+     */
+    nsapi_size_t (*buffer_segment)(nsapi_stack_t *stack, const nsapi_buffer_t *buffer,
+            nsapi_size_t offset, const void **data);
+
+    /** Release a received buffer
+     *
+     *  Hands the memory held by the buffer back to the stack and leaves
+     *  the buffer empty. Releasing an empty buffer has no effect.
+     *
+     *  @param stack    Stack handle
+     *  @param buffer   Buffer from socket_recv_buffer or socket_recvfrom_buffer
+     */
+    void (*buffer_release)(nsapi_stack_t *stack, nsapi_buffer_t *buffer);
+
+    /** Send data over a TCP socket without copying
+     *
+     *  The socket must be connected to a remote host. Up to size bytes are
+     *  queued to be sent straight from data, which must stay valid and
+     *  unmodified until callback is called. The callback is called once
+     *  the remote host has acknowledged the queued bytes, or the stack has
+     *  otherwise stopped using them. Returns the number of bytes queued.
+     *  A size of 0 queues nothing and calls callback once all data sent
+     *  before it is no longer needed.
+     *
+     *  This call is non-blocking. If send_ref would block,
+     *  NSAPI_ERROR_WOULD_BLOCK is returned immediately.
+     *
+     *  @param stack    Stack handle
+     *  @param socket   Socket handle
+     *  @param data     Buffer of data to send to the host
+     *  @param size     Size of the buffer in bytes
+     *  @param callback Function to call once the data is no longer needed
+     *  @param context  Argument to pass to callback
+     *  @return         Number of queued bytes on success, negative error
+     *                  code on failure
+     */
+    nsapi_size_or_error_t (*socket_send_ref)(nsapi_stack_t *stack, nsapi_socket_t socket,
+            const void *data, nsapi_size_t size, void (*callback)(void *), void *context);
+
+    /** Send a message gathered from several buffers
+     *
+     *  The contents of the buffers in iov are sent as if they were one
+     *  contiguous buffer. For a UDP socket, addr is the remote host and
+     *  the buffers form one datagram. For a TCP socket, addr is NULL and
+     *  the socket must be connected to a remote host. Returns the number
+     *  of bytes sent from the buffers.
+     *
+     *  This call is non-blocking. If sendmsg would block,
+     *  NSAPI_ERROR_WOULD_BLOCK is returned immediately.
+     *
+     *  @param stack    Stack handle
+     *  @param socket   Socket handle
+     *  @param addr     The address of the remote host, or NULL for TCP
+     *  @param port     The port of the remote host
+     *  @param iov      Array of buffers of data to send to the host
+     *  @param iovcnt   Number of buffers in iov
+     *  @return         Number of sent bytes on success, negative error
+     *                  code on failure
+     */
+    nsapi_size_or_error_t (*socket_sendmsg)(nsapi_stack_t *stack, nsapi_socket_t socket,
+            const nsapi_addr_t *addr, uint16_t port, const nsapi_iovec_t *iov, unsigned iovcnt);
+
+    /** Receive a message scattered into several buffers
+     *
+     *  Received data fills the buffers in iov in order. For a UDP socket,
+     *  one datagram is received, any part of it that does not fit is
+     *  discarded, and the source address is stored in addr. For a TCP
+     *  socket, addr is NULL. Returns the number of bytes received into
+     *  the buffers.
+     *
+     *  This call is non-blocking. If recvmsg would block,
+     *  NSAPI_ERROR_WOULD_BLOCK is returned immediately.
+     *
+     *  @param stack    Stack handle
+     *  @param socket   Socket handle
+     *  @param addr     Destination for the address of the remote host,
+     *                  or NULL for TCP
+     *  @param port     Destination for the port of the remote host
+     *  @param iov      Array of destination buffers for data received
+     *                  from the host
+     *  @param iovcnt   Number of buffers in iov
+     *  @return         Number of received bytes on success, negative error
+     *                  code on failure
+     */
+    nsapi_size_or_error_t (*socket_recvmsg)(nsapi_stack_t *stack, nsapi_socket_t socket,
+            nsapi_addr_t *addr, uint16_t *port, const nsapi_iovec_t *iov, unsigned iovcnt);
 } nsapi_stack_api_t;
 
 
@@ -0,0 +1,223 @@
+/*
+ * mbed Microcontroller Library
+ * Copyright (c) 2006-2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+/** @file find3.cpp Test cases to benchmark Open() and Find() lookups in a
+ *  CFSTORE holding a large number of KVs.
+ *
+ * Please consult the documentation under the test-case functions for
+ * a description of the individual test case.
+ */
+
+#include "mbed.h"
+#include "cfstore_config.h"
+#include "cfstore_test.h"
+#include "cfstore_debug.h"
+#include "Driver_Common.h"
+#include "configuration_store.h"
+#include "utest/utest.h"
+#include "unity/unity.h"
+#include "greentea-client/test_env.h"
+#include "cfstore_utest.h"
+#ifdef YOTTA_CFG_CFSTORE_UVISOR
+#include "uvisor-lib/uvisor-lib.h"
+#endif /* YOTTA_CFG_CFSTORE_UVISOR */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <inttypes.h>
+
+using namespace utest::v1;
+
+static char cfstore_find3_utest_msg_g[CFSTORE_UTEST_MSG_BUF_SIZE];
+
+/* Configure secure box. */
+#ifdef YOTTA_CFG_CFSTORE_UVISOR
+UVISOR_BOX_NAMESPACE("com.arm.mbed.cfstore.test.find3.box1");
+UVISOR_BOX_CONFIG(cfstore_find3_box1, UVISOR_BOX_STACK_SIZE);
+#endif /* YOTTA_CFG_CFSTORE_UVISOR */
+
+/// @cond CFSTORE_DOXYGEN_DISABLE
+#ifdef CFSTORE_DEBUG
+#define CFSTORE_FIND3_GREENTEA_TIMEOUT_S     600
+#else
+#define CFSTORE_FIND3_GREENTEA_TIMEOUT_S     120
+#endif
+#define CFSTORE_FIND3_NUM_KVS                1000
+#define CFSTORE_FIND3_NUM_GROUPS             8
+#define CFSTORE_FIND3_VALUE                  "abcd"
+/// @endcond
+
+
+/* @brief   generate the name of the i-th KV. KVs are spread over CFSTORE_FIND3_NUM_GROUPS
+ *          groups so prefix queries match a subset of the KVs. */
+static void cfstore_find3_kv_name(char* key_name, size_t len, uint32_t i)
+{
+    snprintf(key_name, len, "com.arm.mbed.cfstore.find3.group%d.kv%04d", (int) (i % CFSTORE_FIND3_NUM_GROUPS), (int) i);
+}
+
+
+/* @brief   count the KVs matching key_name_query using the Find() iteration idiom */
+static int32_t cfstore_find3_count(const char* key_name_query, uint32_t* count)
+{
+    int32_t ret = ARM_DRIVER_ERROR;
+    ARM_CFSTORE_DRIVER* drv = &cfstore_driver;
+    ARM_CFSTORE_HANDLE_INIT(prev);
+    ARM_CFSTORE_HANDLE_INIT(next);
+
+    *count = 0;
+    while((ret = drv->Find(key_name_query, prev, next)) == ARM_DRIVER_OK)
+    {
+        (*count)++;
+        CFSTORE_HANDLE_SWAP(prev, next);
+    }
+    if(ret != ARM_CFSTORE_DRIVER_ERROR_KEY_NOT_FOUND){
+        return ret;
+    }
+    /* close the last handle returned by Find() */
+    if(*count > 0){
+        ret = drv->Close(prev);
+        if(ret < ARM_DRIVER_OK){
+            return ret;
+        }
+    }
+    return ARM_DRIVER_OK;
+}
+
+
+/* report whether built/configured for flash sync or async mode */
+static control_t cfstore_find3_test_00(const size_t call_count)
+{
+    int32_t ret = ARM_DRIVER_ERROR;
+
+    (void) call_count;
+    ret = cfstore_test_startup();
+    CFSTORE_TEST_UTEST_MESSAGE(cfstore_find3_utest_msg_g, CFSTORE_UTEST_MSG_BUF_SIZE, "%s:Error: failed to perform test startup (ret=%d).\n", __func__, (int) ret);
+    TEST_ASSERT_MESSAGE(ret >= ARM_DRIVER_OK, cfstore_find3_utest_msg_g);
+    return CaseNext;
+}
+
+
+/** @brief  test to create CFSTORE_FIND3_NUM_KVS KVs and time the following operations:
+ *          - Open() of every KV by name (exact key_name lookup).
+ *          - Find() with a "prefix*" query matching one group of KVs.
+ *          - Find() with a query containing an embedded '*', which is matched
+ *            by walking the KV area.
+ *          - Create() of a KV which already exists (rejected after lookup).
+ *
+ * The times are reported so the cost of lookups with a large store can be
+ * tracked, and the number of KVs found by each query is checked.
+ *
+ * @return on success returns CaseNext to continue to next test case, otherwise will assert on errors.
+ */
+control_t cfstore_find3_test_01_end(const size_t call_count)
+{
+    char key_name[CFSTORE_KEY_NAME_MAX_LENGTH+1];
+    int32_t ret = ARM_DRIVER_ERROR;
+    uint32_t i = 0;
+    uint32_t count = 0;
+    ARM_CFSTORE_SIZE len = 0;
+    ARM_CFSTORE_DRIVER* drv = &cfstore_driver;
+    ARM_CFSTORE_KEYDESC kdesc;
+    ARM_CFSTORE_FMODE flags;
+    ARM_CFSTORE_HANDLE_INIT(hkey);
+    Timer timer;
+
+    CFSTORE_DBGLOG("%s:entered\r\n", __func__);
+    (void) call_count;
+    memset(&kdesc, 0, sizeof(kdesc));
+    memset(&flags, 0, sizeof(flags));
+
+    timer.start();
+    for(i = 0; i < CFSTORE_FIND3_NUM_KVS; i++){
+        cfstore_find3_kv_name(key_name, sizeof(key_name), i);
+        len = strlen(CFSTORE_FIND3_VALUE);
+        ret = cfstore_test_create(key_name, CFSTORE_FIND3_VALUE, &len, &kdesc);
+        CFSTORE_TEST_UTEST_MESSAGE(cfstore_find3_utest_msg_g, CFSTORE_UTEST_MSG_BUF_SIZE, "%s:Error: failed to create KV (key_name=%s, ret=%d).\n", __func__, key_name, (int) ret);
+        TEST_ASSERT_MESSAGE(ret >= ARM_DRIVER_OK, cfstore_find3_utest_msg_g);
+    }
+    CFSTORE_LOG("%s:Create() x %d: %d us\r\n", __func__, (int) CFSTORE_FIND3_NUM_KVS, (int) timer.read_us());
+
+    timer.reset();
+    for(i = 0; i < CFSTORE_FIND3_NUM_KVS; i++){
+        cfstore_find3_kv_name(key_name, sizeof(key_name), i);
+        ret = drv->Open(key_name, flags, hkey);
+        CFSTORE_TEST_UTEST_MESSAGE(cfstore_find3_utest_msg_g, CFSTORE_UTEST_MSG_BUF_SIZE, "%s:Error: failed to open KV (key_name=%s, ret=%d).\n", __func__, key_name, (int) ret);
+        TEST_ASSERT_MESSAGE(ret >= ARM_DRIVER_OK, cfstore_find3_utest_msg_g);
+        drv->Close(hkey);
+    }
+    CFSTORE_LOG("%s:Open() x %d: %d us\r\n", __func__, (int) CFSTORE_FIND3_NUM_KVS, (int) timer.read_us());
+
+    timer.reset();
+    ret = cfstore_find3_count("com.arm.mbed.cfstore.find3.group3.*", &count);
+    CFSTORE_LOG("%s:Find(\"prefix*\") found %d KVs: %d us\r\n", __func__, (int) count, (int) timer.read_us());
+    CFSTORE_TEST_UTEST_MESSAGE(cfstore_find3_utest_msg_g, CFSTORE_UTEST_MSG_BUF_SIZE, "%s:Error: prefix Find() failed (ret=%d, count=%d).\n", __func__, (int) ret, (int) count);
+    TEST_ASSERT_MESSAGE(ret >= ARM_DRIVER_OK && count == CFSTORE_FIND3_NUM_KVS / CFSTORE_FIND3_NUM_GROUPS, cfstore_find3_utest_msg_g);
+
+    timer.reset();
+    ret = cfstore_find3_count("com.arm.mbed.cfstore.find3.group*.kv0*0", &count);
+    CFSTORE_LOG("%s:Find(\"pattern\") found %d KVs: %d us\r\n", __func__, (int) count, (int) timer.read_us());
+    CFSTORE_TEST_UTEST_MESSAGE(cfstore_find3_utest_msg_g, CFSTORE_UTEST_MSG_BUF_SIZE, "%s:Error: pattern Find() failed (ret=%d, count=%d).\n", __func__, (int) ret, (int) count);
+    TEST_ASSERT_MESSAGE(ret >= ARM_DRIVER_OK && count == CFSTORE_FIND3_NUM_KVS / 10, cfstore_find3_utest_msg_g);
+
+    /* creating a pre-existing key must fail */
+    timer.reset();
+    cfstore_find3_kv_name(key_name, sizeof(key_name), CFSTORE_FIND3_NUM_KVS - 1);
+    ret = drv->Create(key_name, strlen(CFSTORE_FIND3_VALUE), &kdesc, hkey);
+    CFSTORE_LOG("%s:Create(pre-existing): %d us\r\n", __func__, (int) timer.read_us());
+    CFSTORE_TEST_UTEST_MESSAGE(cfstore_find3_utest_msg_g, CFSTORE_UTEST_MSG_BUF_SIZE, "%s:Error: Create() of pre-existing key didnt fail (ret=%d).\n", __func__, (int) ret);
+    TEST_ASSERT_MESSAGE(ret == ARM_CFSTORE_DRIVER_ERROR_PREEXISTING_KEY, cfstore_find3_utest_msg_g);
+
+    timer.reset();
+    ret = cfstore_test_delete_all();
+    CFSTORE_LOG("%s:Delete() x %d: %d us\r\n", __func__, (int) CFSTORE_FIND3_NUM_KVS, (int) timer.read_us());
+    CFSTORE_TEST_UTEST_MESSAGE(cfstore_find3_utest_msg_g, CFSTORE_UTEST_MSG_BUF_SIZE, "%s:Error: failed to delete all KVs (ret=%d).\n", __func__, (int) ret);
+    TEST_ASSERT_MESSAGE(ret >= ARM_DRIVER_OK, cfstore_find3_utest_msg_g);
+
+    ret = drv->Uninitialize();
+    CFSTORE_TEST_UTEST_MESSAGE(cfstore_find3_utest_msg_g, CFSTORE_UTEST_MSG_BUF_SIZE, "%s:Error: Uninitialize() call failed.\n", __func__);
+    TEST_ASSERT_MESSAGE(ret >= ARM_DRIVER_OK, cfstore_find3_utest_msg_g);
+    return CaseNext;
+}
+
+
+/// @cond CFSTORE_DOXYGEN_DISABLE
+utest::v1::status_t greentea_setup(const size_t number_of_cases)
+{
+    GREENTEA_SETUP(CFSTORE_FIND3_GREENTEA_TIMEOUT_S, "default_auto");
+    return greentea_test_setup_handler(number_of_cases);
+}
+
+Case cases[] = {
+           /*          1         2         3         4         5         6        7  */
+           /* 1234567890123456789012345678901234567890123456789012345678901234567890 */
+        Case("FIND3_test_00", cfstore_find3_test_00),
+        Case("FIND3_test_01_start", cfstore_utest_default_start),
+        Case("FIND3_test_01_end", cfstore_find3_test_01_end),
+};
+
+
+/* Declare your test specification with a custom setup handler */
+Specification specification(greentea_setup, cases);
+
+int main()
+{
+    return !Harness::run(specification);
+}
+/// @endcond
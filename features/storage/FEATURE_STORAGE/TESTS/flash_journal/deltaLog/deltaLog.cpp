@@ -0,0 +1,459 @@
+/*
+ * Copyright (c) 2006-2017, ARM Limited, All Rights Reserved
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Delta logging for the sequential flash-journal, exercised against a
+ * synchronous, RAM-backed ARM_DRIVER_STORAGE. The MTD counts the octets
+ * programmed and erased, so that the cost of each commit can be checked.
+ */
+
+#ifdef TARGET_LIKE_POSIX
+#define AVOID_GREENTEA
+#endif
+
+#ifndef AVOID_GREENTEA
+#include "greentea-client/test_env.h"
+#endif
+#include "utest/utest.h"
+#include "unity/unity.h"
+
+#include "flash-journal-strategy-sequential/flash_journal_strategy_sequential.h"
+#include "flash-journal-strategy-sequential/flash_journal_private.h"
+#include <string.h>
+#include <stdio.h>
+#include <inttypes.h>
+
+using namespace utest::v1;
+
+/*
+ * RAM-backed MTD made up of two blocks with different erase_units; the journal
+ * is expected to align its header and slots with the LCM of the two.
+ */
+static const uint32_t RAM_MTD_BLOCK0_SIZE       = 16 * 1024;
+static const uint32_t RAM_MTD_BLOCK0_ERASE_UNIT = 1024;
+static const uint32_t RAM_MTD_BLOCK1_SIZE       = 16 * 1024;
+static const uint32_t RAM_MTD_BLOCK1_ERASE_UNIT = 2048;
+static const uint32_t RAM_MTD_ERASE_UNIT_LCM    = 2048;
+static const uint32_t RAM_MTD_PROGRAM_UNIT      = 8;
+static const uint32_t RAM_MTD_SIZE              = RAM_MTD_BLOCK0_SIZE + RAM_MTD_BLOCK1_SIZE;
+
+static uint8_t  ramMtdStorage[RAM_MTD_SIZE];
+static uint32_t ramMtdProgrammed; /* octets programmed since the counters were last cleared */
+static uint32_t ramMtdErased;     /* octets erased since the counters were last cleared */
+
+static ARM_DRIVER_VERSION ramMtd_getVersion(void)
+{
+    ARM_DRIVER_VERSION version = {ARM_STORAGE_API_VERSION, ARM_STORAGE_API_VERSION};
+    return version;
+}
+
+static ARM_STORAGE_CAPABILITIES ramMtd_getCapabilities(void)
+{
+    ARM_STORAGE_CAPABILITIES caps;
+    memset(&caps, 0, sizeof(caps));
+    caps.asynchronous_ops = 0;
+    caps.erase_all        = 1;
+    return caps;
+}
+
+static int32_t ramMtd_initialize(ARM_Storage_Callback_t callback)
+{
+    (void)callback;
+    return 1; /* synchronous completion */
+}
+
+static int32_t ramMtd_uninitialize(void)
+{
+    return 1;
+}
+
+static int32_t ramMtd_powerControl(ARM_POWER_STATE state)
+{
+    (void)state;
+    return ARM_DRIVER_OK;
+}
+
+static int32_t ramMtd_readData(uint64_t addr, void *data, uint32_t size)
+{
+    if ((addr + size) > RAM_MTD_SIZE) {
+        return ARM_DRIVER_ERROR_PARAMETER;
+    }
+    memcpy(data, &ramMtdStorage[addr], size);
+    return size;
+}
+
+static int32_t ramMtd_programData(uint64_t addr, const void *data, uint32_t size)
+{
+    if (((addr + size) > RAM_MTD_SIZE) || (addr % RAM_MTD_PROGRAM_UNIT) || (size % RAM_MTD_PROGRAM_UNIT) || (size == 0)) {
+        return ARM_DRIVER_ERROR_PARAMETER;
+    }
+    for (uint32_t i = 0; i < size; i++) {
+        if (ramMtdStorage[addr + i] != 0xFF) {
+            return ARM_STORAGE_ERROR_RUNTIME_OR_INTEGRITY_FAILURE; /* programming requires erased memory */
+        }
+    }
+    memcpy(&ramMtdStorage[addr], data, size);
+    ramMtdProgrammed += size;
+    return size;
+}
+
+static uint32_t ramMtd_eraseUnit(uint64_t addr)
+{
+    return (addr < RAM_MTD_BLOCK0_SIZE) ? RAM_MTD_BLOCK0_ERASE_UNIT : RAM_MTD_BLOCK1_ERASE_UNIT;
+}
+
+static int32_t ramMtd_erase(uint64_t addr, uint32_t size)
+{
+    if (((addr + size) > RAM_MTD_SIZE) || (addr % ramMtd_eraseUnit(addr)) || ((addr + size) % ramMtd_eraseUnit(addr + size - 1))) {
+        return ARM_DRIVER_ERROR_PARAMETER;
+    }
+    memset(&ramMtdStorage[addr], 0xFF, size);
+    ramMtdErased += size;
+    return size;
+}
+
+static int32_t ramMtd_eraseAll(void)
+{
+    memset(ramMtdStorage, 0xFF, sizeof(ramMtdStorage));
+    return 1;
+}
+
+static ARM_STORAGE_STATUS ramMtd_getStatus(void)
+{
+    ARM_STORAGE_STATUS status;
+    memset(&status, 0, sizeof(status));
+    return status;
+}
+
+static int32_t ramMtd_getInfo(ARM_STORAGE_INFO *info)
+{
+    memset(info, 0, sizeof(ARM_STORAGE_INFO));
+    info->total_storage        = RAM_MTD_SIZE;
+    info->program_unit         = RAM_MTD_PROGRAM_UNIT;
+    info->optimal_program_unit = RAM_MTD_PROGRAM_UNIT;
+    info->program_cycles       = ARM_STORAGE_PROGRAM_CYCLES_INFINITE;
+    info->erased_value         = 1;
+    info->memory_mapped        = 0;
+    info->programmability      = ARM_STORAGE_PROGRAMMABILITY_ERASABLE;
+    info->retention_level      = ARM_RETENTION_NVM;
+    return ARM_DRIVER_OK;
+}
+
+static uint32_t ramMtd_resolveAddress(uint64_t addr)
+{
+    return (uint32_t)(uintptr_t)&ramMtdStorage[addr];
+}
+
+static void ramMtd_fillBlock(unsigned index, ARM_STORAGE_BLOCK *block)
+{
+    memset(block, 0, sizeof(ARM_STORAGE_BLOCK));
+    if (index == 0) {
+        block->addr                  = 0;
+        block->size                  = RAM_MTD_BLOCK0_SIZE;
+        block->attributes.erase_unit = RAM_MTD_BLOCK0_ERASE_UNIT;
+    } else if (index == 1) {
+        block->addr                  = RAM_MTD_BLOCK0_SIZE;
+        block->size                  = RAM_MTD_BLOCK1_SIZE;
+        block->attributes.erase_unit = RAM_MTD_BLOCK1_ERASE_UNIT;
+    } else {
+        block->addr = ARM_STORAGE_INVALID_OFFSET;
+        return;
+    }
+    block->attributes.erasable     = 1;
+    block->attributes.programmable = 1;
+}
+
+static int32_t ramMtd_getNextBlock(const ARM_STORAGE_BLOCK *prevBlock, ARM_STORAGE_BLOCK *nextBlock)
+{
+    ARM_STORAGE_BLOCK block;
+    unsigned index = (prevBlock == NULL) ? 0 : ((prevBlock->addr == 0) ? 1 : 2);
+    ramMtd_fillBlock(index, &block);
+    if (nextBlock) {
+        memcpy(nextBlock, &block, sizeof(block));
+    }
+    return ARM_STORAGE_VALID_BLOCK(&block) ? ARM_DRIVER_OK : ARM_DRIVER_ERROR;
+}
+
+static int32_t ramMtd_getBlock(uint64_t addr, ARM_STORAGE_BLOCK *block)
+{
+    ARM_STORAGE_BLOCK found;
+    ramMtd_fillBlock((addr < RAM_MTD_BLOCK0_SIZE) ? 0 : ((addr < RAM_MTD_SIZE) ? 1 : 2), &found);
+    if (block) {
+        memcpy(block, &found, sizeof(found));
+    }
+    return ARM_STORAGE_VALID_BLOCK(&found) ? ARM_DRIVER_OK : ARM_DRIVER_ERROR;
+}
+
+ARM_DRIVER_STORAGE ramMtd = {
+    ramMtd_getVersion,
+    ramMtd_getCapabilities,
+    ramMtd_initialize,
+    ramMtd_uninitialize,
+    ramMtd_powerControl,
+    ramMtd_readData,
+    ramMtd_programData,
+    ramMtd_erase,
+    ramMtd_eraseAll,
+    ramMtd_getStatus,
+    ramMtd_getInfo,
+    ramMtd_resolveAddress,
+    ramMtd_getNextBlock,
+    ramMtd_getBlock
+};
+
+ARM_DRIVER_STORAGE *drv = &ramMtd;
+
+FlashJournal_t journal;
+
+static const size_t BLOB_SIZE = 2048;
+static uint8_t      blob[BLOB_SIZE + 512];     /* the most recently committed blob */
+static size_t       sizeofBlob;
+static uint8_t      readBuffer[BLOB_SIZE + 512];
+
+static void clearCounters(void)
+{
+    ramMtdProgrammed = 0;
+    ramMtdErased     = 0;
+}
+
+static void logAndCommit(size_t size)
+{
+    int32_t rc = FlashJournal_log(&journal, blob, size);
+    TEST_ASSERT_EQUAL((int32_t)size, rc);
+    rc = FlashJournal_commit(&journal);
+    TEST_ASSERT_EQUAL(1, rc);
+    sizeofBlob = size;
+}
+
+static void verifyBlob(void)
+{
+    FlashJournal_Info_t info;
+    TEST_ASSERT_EQUAL(JOURNAL_STATUS_OK, FlashJournal_getInfo(&journal, &info));
+    TEST_ASSERT_EQUAL(sizeofBlob, info.sizeofJournaledBlob);
+
+    memset(readBuffer, 0, sizeof(readBuffer));
+    int32_t rc = FlashJournal_read(&journal, readBuffer, sizeof(readBuffer));
+    TEST_ASSERT_EQUAL((int32_t)sizeofBlob, rc);
+    TEST_ASSERT_EQUAL(0, memcmp(blob, readBuffer, sizeofBlob));
+
+    /* piecewise reads at an offset should agree as well */
+    rc = FlashJournal_readFrom(&journal, sizeofBlob / 3, readBuffer, 100);
+    TEST_ASSERT_EQUAL(100, rc);
+    TEST_ASSERT_EQUAL(0, memcmp(blob + (sizeofBlob / 3), readBuffer, 100));
+}
+
+static void initialize(void)
+{
+    int32_t rc = FlashJournal_initialize(&journal, drv, &FLASH_JOURNAL_STRATEGY_SEQUENTIAL, NULL);
+    TEST_ASSERT_EQUAL(1, rc);
+}
+
+void test_formatWithMixedEraseUnits()
+{
+    TEST_ASSERT_EQUAL(1, drv->EraseAll());
+    int32_t rc = flashJournalStrategySequential_format(drv, 4 /* numSlots */, NULL);
+    TEST_ASSERT_EQUAL(1, rc);
+
+    SequentialFlashJournalHeader_t header;
+    TEST_ASSERT_EQUAL(sizeof(header), drv->ReadData(0, &header, sizeof(header)));
+    TEST_ASSERT_EQUAL(RAM_MTD_ERASE_UNIT_LCM, header.genericHeader.journalOffset);
+    TEST_ASSERT_EQUAL(0, header.sizeofSlot % RAM_MTD_ERASE_UNIT_LCM);
+    TEST_ASSERT(header.sizeofSlot > 2 * BLOB_SIZE);
+
+    initialize();
+}
+
+void test_logCheckpoint()
+{
+    for (size_t i = 0; i < BLOB_SIZE; i++) {
+        blob[i] = (uint8_t)(i * 7);
+    }
+
+    clearCounters();
+    logAndCommit(BLOB_SIZE);
+    printf("checkpoint of %u octets: %" PRIu32 " octets programmed, %" PRIu32 " erased\r\n",
+           (unsigned)BLOB_SIZE, ramMtdProgrammed, ramMtdErased);
+    TEST_ASSERT(ramMtdProgrammed >= BLOB_SIZE);
+    TEST_ASSERT(ramMtdErased > 0);
+
+    verifyBlob();
+}
+
+void test_smallChangeLoggedAsDelta()
+{
+    blob[100] ^= 0xFF;
+    blob[101] ^= 0xFF;
+    blob[1500] ^= 0xFF;
+
+    clearCounters();
+    logAndCommit(BLOB_SIZE);
+    printf("delta for 3 changed octets: %" PRIu32 " octets programmed, %" PRIu32 " erased\r\n",
+           ramMtdProgrammed, ramMtdErased);
+    TEST_ASSERT(ramMtdProgrammed <= 64);
+    TEST_ASSERT_EQUAL(0, ramMtdErased);
+
+    verifyBlob();
+}
+
+void test_initializeRecoversDeltas()
+{
+    initialize();
+    verifyBlob();
+}
+
+void test_unchangedBlobCommitsCheaply()
+{
+    clearCounters();
+    logAndCommit(BLOB_SIZE);
+    TEST_ASSERT(ramMtdProgrammed <= sizeof(SequentialFlashJournalLogTail_t));
+    TEST_ASSERT_EQUAL(0, ramMtdErased);
+    verifyBlob();
+}
+
+void test_growAndShrinkBlob()
+{
+    for (size_t i = BLOB_SIZE; i < BLOB_SIZE + 256; i++) {
+        blob[i] = (uint8_t)(i * 13);
+    }
+    clearCounters();
+    logAndCommit(BLOB_SIZE + 256);
+    TEST_ASSERT_EQUAL(0, ramMtdErased);
+    verifyBlob();
+
+    clearCounters();
+    logAndCommit(BLOB_SIZE - 512);
+    TEST_ASSERT_EQUAL(0, ramMtdErased);
+    verifyBlob();
+
+    /* growing again has to re-log what lies beyond the shrunk blob */
+    blob[BLOB_SIZE - 256] ^= 0x5A;
+    clearCounters();
+    logAndCommit(BLOB_SIZE);
+    verifyBlob();
+
+    initialize();
+    verifyBlob();
+}
+
+void test_periodicCheckpoint()
+{
+    uint32_t checkpoints = 0;
+    for (unsigned commit = 0; commit < 2 * FLASH_JOURNAL_STRATEGY_SEQUENTIAL_DELTA_MAX_COMMITS; commit++) {
+        blob[(commit * 97) % BLOB_SIZE] += 1;
+
+        clearCounters();
+        logAndCommit(BLOB_SIZE);
+        if (ramMtdErased) {
+            checkpoints++;
+        }
+        verifyBlob();
+    }
+    TEST_ASSERT(checkpoints >= 1);
+
+    initialize();
+    verifyBlob();
+}
+
+void test_uncommittedDeltaIsDiscarded()
+{
+    uint8_t saved = blob[10];
+
+    /* log a change, but re-initialize (as if after a power failure) instead of committing */
+    blob[10] ^= 0xFF;
+    TEST_ASSERT_EQUAL((int32_t)BLOB_SIZE, FlashJournal_log(&journal, blob, BLOB_SIZE));
+    blob[10] = saved;
+
+    initialize();
+    verifyBlob();
+
+    /* the area following the abandoned delta can't be trusted; the next commit writes a checkpoint */
+    blob[20] ^= 0xFF;
+    clearCounters();
+    logAndCommit(BLOB_SIZE);
+    TEST_ASSERT(ramMtdErased > 0);
+    verifyBlob();
+}
+
+void test_deltaSpillsIntoNextSlot()
+{
+    /* use up most of the room for deltas with changes scattered across the blob */
+    for (unsigned round = 0; round < 2; round++) {
+        for (size_t i = 0; i < BLOB_SIZE; i += 32) {
+            blob[i] ^= (uint8_t)(1 << round);
+        }
+        clearCounters();
+        logAndCommit(BLOB_SIZE);
+        TEST_ASSERT_EQUAL(0, ramMtdErased);
+    }
+
+    /* a small change in the first chunk is logged as a delta; the second chunk doesn't fit */
+    blob[0] ^= 0x80;
+    for (size_t i = BLOB_SIZE / 2; i < BLOB_SIZE; i++) {
+        blob[i] = ~blob[i];
+    }
+    clearCounters();
+    TEST_ASSERT_EQUAL((int32_t)(BLOB_SIZE / 2), FlashJournal_log(&journal, blob, BLOB_SIZE / 2));
+    TEST_ASSERT_EQUAL((int32_t)(BLOB_SIZE / 2), FlashJournal_log(&journal, blob + (BLOB_SIZE / 2), BLOB_SIZE / 2));
+    TEST_ASSERT_EQUAL(1, FlashJournal_commit(&journal));
+    TEST_ASSERT(ramMtdErased > 0);
+    sizeofBlob = BLOB_SIZE;
+    verifyBlob();
+
+    initialize();
+    verifyBlob();
+}
+
+#ifndef AVOID_GREENTEA
+// Custom setup handler required for proper Greentea support
+utest::v1::status_t greentea_setup(const size_t number_of_cases)
+{
+    GREENTEA_SETUP(60, "default_auto");
+    // Call the default reporting function
+    return greentea_test_setup_handler(number_of_cases);
+}
+#else
+status_t default_setup(const size_t)
+{
+    return STATUS_CONTINUE;
+}
+#endif
+
+// Specify all your test cases here
+Case cases[] = {
+    Case("format on an MTD with mixed erase units", test_formatWithMixedEraseUnits),
+    Case("log checkpoint",                          test_logCheckpoint),
+    Case("small change logged as delta",            test_smallChangeLoggedAsDelta),
+    Case("initialize recovers deltas",              test_initializeRecoversDeltas),
+    Case("unchanged blob commits cheaply",          test_unchangedBlobCommitsCheaply),
+    Case("grow and shrink blob",                    test_growAndShrinkBlob),
+    Case("periodic checkpoint",                     test_periodicCheckpoint),
+    Case("uncommitted delta is discarded",          test_uncommittedDeltaIsDiscarded),
+    Case("delta spills into next slot",             test_deltaSpillsIntoNextSlot),
+};
+
+// Declare your test specification with a custom setup handler
+#ifndef AVOID_GREENTEA
+Specification specification(greentea_setup, cases);
+#else
+Specification specification(default_setup, cases);
+#endif
+
+int main(int argc, char** argv)
+{
+    // Run the test specification
+    Harness::run(specification);
+}
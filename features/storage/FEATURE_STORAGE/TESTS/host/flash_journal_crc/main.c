@@ -0,0 +1,224 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#if !defined(TARGET_LIKE_POSIX)
+    #error [NOT_SUPPORTED] Host test, build with the Makefile in this directory
+#endif
+
+/* Host test of the CRC-32 of the sequential flash journal
+ *
+ * The slicing tables of flash_journal_crc.c are checked against their
+ * definition, and, run with "tables", printed as they go in the source.
+ * The slice-by-4 engine is then compared with the byte-wise engine it
+ * replaced, on the check value of CRC-32 and on random messages fed at
+ * any alignment and in random fragments, as the journal does.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "flash-journal-strategy-sequential/flash_journal_crc.c"
+
+#define RANDOM_TESTS    10000
+#define MAX_LEN         600
+#define BENCHMARK_LEN   4096
+#define BENCHMARK_NS    200000000
+
+#define CHECK(cond) do {                                                \
+        if (!(cond)) {                                                  \
+            printf("HOST: %s:%d: check failed: %s\r\n",                 \
+                   __FILE__, __LINE__, #cond);                          \
+            exit(EXIT_FAILURE);                                         \
+        }                                                               \
+    } while (0)
+
+
+static uint64_t nanoseconds(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+// Reproducible test data
+static uint32_t seed = 0x12345678;
+
+static uint32_t rand32(void)
+{
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    return seed;
+}
+
+
+// The byte-wise engine as it was, with the unreflected polynomial and the
+// data and remainder reflected on their way in and out
+static uint32_t ref_table[256];
+static uint32_t ref_remainder;
+
+static uint32_t reflect(uint32_t data, unsigned char nBits)
+{
+    uint32_t reflection = 0;
+    for (unsigned char bit = 0; bit < nBits; ++bit) {
+        if (data & 1) {
+            reflection |= 1U << ((nBits - 1) - bit);
+        }
+        data >>= 1;
+    }
+    return reflection;
+}
+
+static void ref_init(void)
+{
+    for (int dividend = 0; dividend < 256; ++dividend) {
+        uint32_t remainder = (uint32_t)dividend << 24;
+        for (int bit = 8; bit > 0; --bit) {
+            if (remainder & 0x80000000U) {
+                remainder = (remainder << 1) ^ POLYNOMIAL;
+            } else {
+                remainder = remainder << 1;
+            }
+        }
+        ref_table[dividend] = remainder;
+    }
+    ref_remainder = INITIAL_REMAINDER;
+}
+
+static uint32_t ref_cummulative(const unsigned char *message, int nBytes)
+{
+    for (int byte = 0; byte < nBytes; ++byte) {
+        unsigned char data = reflect(message[byte], 8) ^ (ref_remainder >> 24);
+        ref_remainder = ref_table[data] ^ (ref_remainder << 8);
+    }
+    return reflect(ref_remainder, 32) ^ FINAL_XOR_VALUE;
+}
+
+
+// Slicing tables from their definition: crcTable[n][i] is the remainder of
+// byte i followed by n zero bytes
+static void compute_tables(uint32_t tables[CRC_SLICES][256])
+{
+    for (int dividend = 0; dividend < 256; ++dividend) {
+        uint32_t remainder = dividend;
+        for (int bit = 8; bit > 0; --bit) {
+            remainder = (remainder & 1) ? (remainder >> 1) ^ REFLECTED_POLYNOMIAL : remainder >> 1;
+        }
+        tables[0][dividend] = remainder;
+    }
+
+    for (int slice = 1; slice < CRC_SLICES; ++slice) {
+        for (int dividend = 0; dividend < 256; ++dividend) {
+            uint32_t remainder = tables[slice - 1][dividend];
+            tables[slice][dividend] = (remainder >> 8) ^ tables[0][remainder & 0xff];
+        }
+    }
+}
+
+static void print_tables(const uint32_t tables[CRC_SLICES][256])
+{
+    printf("static const flash_journal_crc32_t crcTable[CRC_SLICES][256] = {\n");
+    for (int slice = 0; slice < CRC_SLICES; ++slice) {
+        printf("    {\n");
+        for (int i = 0; i < 256; i += 6) {
+            printf("       ");
+            for (int j = i; j < i + 6 && j < 256; j++) {
+                printf(" 0x%08X,", (unsigned)tables[slice][j]);
+            }
+            printf("\n");
+        }
+        printf("    },\n");
+    }
+    printf("};\n");
+}
+
+
+static unsigned char buf[MAX_LEN + 8];
+
+int main(int argc, char **argv)
+{
+    static uint32_t tables[CRC_SLICES][256];
+    compute_tables(tables);
+
+    if (argc > 1 && strcmp(argv[1], "tables") == 0) {
+        print_tables(tables);
+        return 0;
+    }
+
+    CHECK(memcmp(tables, crcTable, sizeof tables) == 0);
+    printf("HOST: slicing tables match their definition\r\n");
+
+    ref_init();
+    flashJournalCrcReset();
+    CHECK(flashJournalCrcCummulative((const unsigned char *)"123456789", 9) == CHECK_VALUE);
+    CHECK(ref_cummulative((const unsigned char *)"123456789", 9) == CHECK_VALUE);
+
+    for (int t = 0; t < RANDOM_TESTS; t++) {
+        size_t len = rand32() % MAX_LEN;
+        size_t align = rand32() % 8;
+        unsigned char *message = buf + align;
+        for (size_t i = 0; i < len; i++) {
+            message[i] = rand32();
+        }
+
+        // In fragments, the result of each call being that of the message
+        // so far
+        size_t done = 0;
+        ref_remainder = INITIAL_REMAINDER;
+        flashJournalCrcReset();
+        do {
+            size_t n = t % 2 ? len - done : rand32() % 40;
+            if (n > len - done) {
+                n = len - done;
+            }
+            CHECK(flashJournalCrcCummulative(message + done, n) ==
+                  ref_cummulative(message + done, n));
+            done += n;
+        } while (done < len);
+    }
+    printf("HOST: slice-by-4 CRC matches the byte-wise CRC on %d random messages\r\n",
+           RANDOM_TESTS);
+
+    // Throughput of both, in ns per byte
+    uint64_t start, elapsed;
+    unsigned long n;
+    static unsigned char bench[BENCHMARK_LEN];
+    for (size_t i = 0; i < sizeof bench; i++) {
+        bench[i] = rand32();
+    }
+
+    start = nanoseconds();
+    for (n = 0; (elapsed = nanoseconds() - start) < BENCHMARK_NS; n++) {
+        flashJournalCrcReset();
+        flashJournalCrcCummulative(bench, sizeof bench);
+    }
+    double sliced = (double)elapsed / n / sizeof bench;
+
+    start = nanoseconds();
+    for (n = 0; (elapsed = nanoseconds() - start) < BENCHMARK_NS; n++) {
+        ref_remainder = INITIAL_REMAINDER;
+        ref_cummulative(bench, sizeof bench);
+    }
+    double bytewise = (double)elapsed / n / sizeof bench;
+
+    printf("HOST: %d bytes: byte-wise %.2f ns/byte, slice-by-4 %.2f ns/byte\r\n",
+           BENCHMARK_LEN, bytewise, sliced);
+
+    printf("HOST: all passed\r\n");
+    return 0;
+}
@@ -56,6 +56,20 @@
 #define CFSTORE_CONFIG_BACKEND_FLASH_ENABLED
 #endif
 
+/* CFSTORE_KEY_INDEX_ENABLE
+ *   Maintain a heap allocated index of key names to speed up Find(), Open(),
+ *   Create() and Delete(). The index is disabled when the client provisions
+ *   the SRAM slab (CFSTORE_YOTTA_CFG_CFSTORE_SRAM_ADDR) as cfstore then has
+ *   no heap.
+ */
+#ifndef CFSTORE_KEY_INDEX_ENABLE
+#define CFSTORE_KEY_INDEX_ENABLE    1
+#endif
+#if defined CFSTORE_YOTTA_CFG_CFSTORE_SRAM_ADDR
+#undef CFSTORE_KEY_INDEX_ENABLE
+#define CFSTORE_KEY_INDEX_ENABLE    0
+#endif
+
 #if defined STORAGE_CONFIG_HARDWARE_MTD_K64F_ASYNC_OPS
 #define CFSTORE_STORAGE_DRIVER_CONFIG_HARDWARE_MTD_ASYNC_OPS STORAGE_CONFIG_HARDWARE_MTD_K64F_ASYNC_OPS
 #endif
@@ -166,6 +166,53 @@ typedef struct cfstore_area_hkvt_t
 } cfstore_area_hkvt_t;
 
 
+#if CFSTORE_KEY_INDEX_ENABLE
+/* @brief   KV area index entry mapping the hash of a key name to the KV.
+ *
+ * @param   hash
+ *          FNV-1a hash of the key name.
+ *
+ * @param   offset
+ *          offset of the KV header from area_0_head. Offsets rather than
+ *          pointers are stored so entries survive realloc() moving the area.
+ */
+typedef struct cfstore_area_index_entry_t
+{
+    uint32_t hash;
+    uint32_t offset;
+} cfstore_area_index_entry_t;
+
+
+/* @brief   index over the KVs in the sram area.
+ *
+ * @param   hash_tbl
+ *          entries sorted by hash, used for exact key_name lookups.
+ *
+ * @param   name_tbl
+ *          KV offsets sorted by key name, used for "prefix*" queries.
+ *
+ * @param   count
+ *          number of KVs indexed.
+ *
+ * @param   size
+ *          number of entries allocated in hash_tbl and name_tbl.
+ *
+ * @param   valid
+ *          false if the index doesnt describe the area (e.g. the area has
+ *          just been loaded from flash, or an index allocation failed). The
+ *          index is rebuilt by the next lookup.
+ */
+typedef struct cfstore_area_index_t
+{
+    cfstore_area_index_entry_t* hash_tbl;
+    uint32_t* name_tbl;
+    uint32_t count;
+    uint32_t size;
+    bool valid;
+} cfstore_area_index_t;
+#endif /* CFSTORE_KEY_INDEX_ENABLE */
+
+
 /* helper struct */
 typedef struct cfstore_client_notify_data_t
 {
@@ -370,6 +417,9 @@ static int32_t cfstore_get_key_name_ex(cfstore_area_hkvt_t *hkvt, char* key_name
  *          flag indicating that the area has been written and therefore is
  *          dirty with respect to the data persisted to flash.
  *
+ * @param   index
+ *          key name index over the KVs in area_0 (see cfstore_area_index_t).
+ *
  * @expected_blob_size  expected_blob_size = area_0_tail - area_0_head + pad
  *          In the case of reading from flash into sram, this will be be size
  *          of the flash blob (rounded to a multiple program_unit if not
@@ -401,6 +451,10 @@ typedef struct cfstore_ctx_t
     uint32_t area_dirty_flag : 1;
     uint32_t f_reserved0 : 30;
 
+#if CFSTORE_KEY_INDEX_ENABLE
+    cfstore_area_index_t index;
+#endif /* CFSTORE_KEY_INDEX_ENABLE */
+
 #ifdef CFSTORE_CONFIG_BACKEND_FLASH_ENABLED
     /* flash journal related data */
     FlashJournal_t jrnl;
@@ -1312,6 +1366,389 @@ static int32_t cfstore_get_next_hkvt(cfstore_area_hkvt_t* prev, cfstore_area_hkv
 }
 
 
+/*
+ * KV area index functions
+ *
+ * The index holds two tables over the KVs in area_0:
+ * - hash_tbl, sorted by key name hash, services exact key_name lookups
+ *   (Open(), Create(), and Find() with a query containing no '*').
+ * - name_tbl, sorted by key name, services "prefix*" queries.
+ * Other queries fall back to walking the area with cfstore_fnmatch().
+ * Entries store offsets from area_0_head and are updated incrementally as
+ * KVs are created, resized and deleted.
+ */
+
+#if CFSTORE_KEY_INDEX_ENABLE
+
+#define CFSTORE_INDEX_SIZE_MIN                  16
+#define CFSTORE_INDEX_OFFSET_NONE               UINT32_MAX
+
+/* @brief   types of key_name_query, classifying how they can be serviced */
+typedef enum cfstore_query_type_t {
+    cfstore_query_type_exact = 0,
+    cfstore_query_type_prefix,
+    cfstore_query_type_pattern,
+} cfstore_query_type_t;
+
+
+/* @brief   compute the FNV-1a hash of a key name */
+static uint32_t cfstore_index_hash(const char* key_name, size_t len)
+{
+    uint32_t hash = 2166136261UL;
+
+    while(len--){
+        hash ^= (uint8_t) *key_name++;
+        hash *= 16777619UL;
+    }
+    return hash;
+}
+
+
+/* @brief   compare the key name of the KV at offset with name (of length len)
+ *
+ * @param   prefix
+ *          if true then the KV key name matches if name is a prefix of it.
+ *
+ * @return  <0, 0 or >0 in the manner of strcmp()
+ */
+static int cfstore_index_name_cmp(uint32_t offset, const char* name, size_t len, bool prefix)
+{
+    cfstore_ctx_t* ctx = cfstore_ctx_get();
+    cfstore_area_header_t* hdr = (cfstore_area_header_t*) (ctx->area_0_head + offset);
+    const char* key = (const char*) hdr + sizeof(cfstore_area_header_t);
+    size_t klen = hdr->klength;
+    int cmp = 0;
+
+    cmp = memcmp(key, name, klen < len ? klen : len);
+    if(cmp != 0){
+        return cmp;
+    }
+    if(klen < len){
+        return -1;
+    }
+    if(klen > len && !prefix){
+        return 1;
+    }
+    return 0;
+}
+
+
+/* @brief   qsort() comparison functions used when rebuilding the index */
+static int cfstore_index_hash_qsort_cmp(const void* a, const void* b)
+{
+    const cfstore_area_index_entry_t* ea = (const cfstore_area_index_entry_t*) a;
+    const cfstore_area_index_entry_t* eb = (const cfstore_area_index_entry_t*) b;
+
+    if(ea->hash != eb->hash){
+        return ea->hash < eb->hash ? -1 : 1;
+    }
+    return ea->offset < eb->offset ? -1 : (ea->offset > eb->offset);
+}
+
+static int cfstore_index_name_qsort_cmp(const void* a, const void* b)
+{
+    uint32_t offset = *(const uint32_t*) b;
+    cfstore_area_header_t* hdr = (cfstore_area_header_t*) (cfstore_ctx_get()->area_0_head + offset);
+
+    return cfstore_index_name_cmp(*(const uint32_t*) a, (const char*) hdr + sizeof(cfstore_area_header_t), hdr->klength, false);
+}
+
+
+/* @brief   return the position of the first hash_tbl entry with hash >= the supplied hash */
+static uint32_t cfstore_index_hash_lower_bound(uint32_t hash)
+{
+    cfstore_area_index_t* index = &cfstore_ctx_get()->index;
+    uint32_t lo = 0;
+    uint32_t hi = index->count;
+    uint32_t mid = 0;
+
+    while(lo < hi){
+        mid = lo + (hi - lo) / 2;
+        if(index->hash_tbl[mid].hash < hash){
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+
+/* @brief   return the position of the first name_tbl entry with key name >= name */
+static uint32_t cfstore_index_name_lower_bound(const char* name, size_t len)
+{
+    cfstore_area_index_t* index = &cfstore_ctx_get()->index;
+    uint32_t lo = 0;
+    uint32_t hi = index->count;
+    uint32_t mid = 0;
+
+    while(lo < hi){
+        mid = lo + (hi - lo) / 2;
+        if(cfstore_index_name_cmp(index->name_tbl[mid], name, len, false) < 0){
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+
+/* @brief   free the index tables and mark the index as invalid so it is
+ *          rebuilt by the next lookup */
+static void cfstore_index_invalidate(void)
+{
+    cfstore_area_index_t* index = &cfstore_ctx_get()->index;
+
+    CFSTORE_FENTRYLOG("%s:entered\n", __func__);
+    free(index->hash_tbl);
+    free(index->name_tbl);
+    memset(index, 0, sizeof(cfstore_area_index_t));
+}
+
+
+/* @brief   grow the index tables so they can hold at least count entries */
+static int32_t cfstore_index_reserve(uint32_t count)
+{
+    uint32_t size = 0;
+    void* ptr = NULL;
+    cfstore_area_index_t* index = &cfstore_ctx_get()->index;
+
+    if(count <= index->size){
+        return ARM_DRIVER_OK;
+    }
+    size = index->size > 0 ? index->size : CFSTORE_INDEX_SIZE_MIN;
+    while(size < count){
+        size *= 2;
+    }
+    ptr = realloc(index->hash_tbl, size * sizeof(cfstore_area_index_entry_t));
+    if(ptr == NULL){
+        return ARM_CFSTORE_DRIVER_ERROR_OUT_OF_MEMORY;
+    }
+    index->hash_tbl = (cfstore_area_index_entry_t*) ptr;
+    ptr = realloc(index->name_tbl, size * sizeof(uint32_t));
+    if(ptr == NULL){
+        return ARM_CFSTORE_DRIVER_ERROR_OUT_OF_MEMORY;
+    }
+    index->name_tbl = (uint32_t*) ptr;
+    index->size = size;
+    return ARM_DRIVER_OK;
+}
+
+
+/* @brief   rebuild the index by walking the KVs in the area.
+ *
+ * On failure the index is left invalid and lookups fall back to walking
+ * the area.
+ */
+static int32_t cfstore_index_build(void)
+{
+    int32_t ret = ARM_DRIVER_ERROR;
+    uint32_t count = 0;
+    cfstore_area_hkvt_t hkvt;
+    cfstore_ctx_t* ctx = cfstore_ctx_get();
+    cfstore_area_index_t* index = &ctx->index;
+
+    CFSTORE_FENTRYLOG("%s:entered\n", __func__);
+    cfstore_index_invalidate();
+    /* first pass counts the KVs so the tables are allocated once */
+    ret = cfstore_get_head_hkvt(&hkvt);
+    while(ret >= ARM_DRIVER_OK && cfstore_hkvt_is_valid(&hkvt, ctx->area_0_tail)){
+        if(hkvt.tail > ctx->area_0_tail){
+            CFSTORE_ERRLOG("%s:Error: found invalid hkvt entry in area\n", __func__);
+            return ARM_CFSTORE_DRIVER_ERROR_INTERNAL;
+        }
+        count++;
+        ret = cfstore_get_next_hkvt(&hkvt, &hkvt);
+    }
+    ret = cfstore_index_reserve(count);
+    if(ret < ARM_DRIVER_OK){
+        CFSTORE_ERRLOG("%s:Error: unable to allocate index (count=%d)\n", __func__, (int) count);
+        cfstore_index_invalidate();
+        return ret;
+    }
+    ret = cfstore_get_head_hkvt(&hkvt);
+    while(ret >= ARM_DRIVER_OK && cfstore_hkvt_is_valid(&hkvt, ctx->area_0_tail)){
+        index->hash_tbl[index->count].hash = cfstore_index_hash((const char*) hkvt.key, cfstore_hkvt_get_key_len(&hkvt));
+        index->hash_tbl[index->count].offset = (uint32_t) (hkvt.head - ctx->area_0_head);
+        index->name_tbl[index->count] = index->hash_tbl[index->count].offset;
+        index->count++;
+        ret = cfstore_get_next_hkvt(&hkvt, &hkvt);
+    }
+    qsort(index->hash_tbl, index->count, sizeof(cfstore_area_index_entry_t), cfstore_index_hash_qsort_cmp);
+    qsort(index->name_tbl, index->count, sizeof(uint32_t), cfstore_index_name_qsort_cmp);
+    index->valid = true;
+    CFSTORE_TP(CFSTORE_TP_VERBOSE1, "%s:index built (count=%d)\n", __func__, (int) index->count);
+    return ARM_DRIVER_OK;
+}
+
+
+/* @brief   add the KV at head to the index.
+ *
+ * @note    the KV header and key name must have been written to the area. On
+ *          failure the index is invalidated so lookups fall back to walking
+ *          the area.
+ */
+static void cfstore_index_add(uint8_t* head)
+{
+    uint32_t pos = 0;
+    uint32_t hash = 0;
+    uint32_t offset = 0;
+    cfstore_area_hkvt_t hkvt;
+    cfstore_ctx_t* ctx = cfstore_ctx_get();
+    cfstore_area_index_t* index = &ctx->index;
+
+    if(!index->valid){
+        return;
+    }
+    if(cfstore_index_reserve(index->count + 1) < ARM_DRIVER_OK){
+        CFSTORE_ERRLOG("%s:Error: unable to grow index, falling back to area walks\n", __func__);
+        cfstore_index_invalidate();
+        return;
+    }
+    hkvt = cfstore_get_hkvt_from_head_ptr(head);
+    offset = (uint32_t) (head - ctx->area_0_head);
+    hash = cfstore_index_hash((const char*) hkvt.key, cfstore_hkvt_get_key_len(&hkvt));
+
+    pos = cfstore_index_hash_lower_bound(hash);
+    memmove(&index->hash_tbl[pos+1], &index->hash_tbl[pos], (index->count - pos) * sizeof(cfstore_area_index_entry_t));
+    index->hash_tbl[pos].hash = hash;
+    index->hash_tbl[pos].offset = offset;
+
+    pos = cfstore_index_name_lower_bound((const char*) hkvt.key, cfstore_hkvt_get_key_len(&hkvt));
+    memmove(&index->name_tbl[pos+1], &index->name_tbl[pos], (index->count - pos) * sizeof(uint32_t));
+    index->name_tbl[pos] = offset;
+    index->count++;
+}
+
+
+/* @brief   update the index after the KVs following the KV at head have
+ *          been moved by size_diff bytes.
+ *
+ * @param   remove
+ *          if true then the KV at head has been deleted and its entry is
+ *          removed from the index.
+ */
+static void cfstore_index_update(uint8_t* head, int32_t size_diff, bool remove)
+{
+    uint32_t i = 0;
+    uint32_t j = 0;
+    uint32_t k = 0;
+    cfstore_ctx_t* ctx = cfstore_ctx_get();
+    cfstore_area_index_t* index = &ctx->index;
+    uint32_t offset = (uint32_t) (head - ctx->area_0_head);
+
+    if(!index->valid){
+        return;
+    }
+    for(i = 0; i < index->count; i++){
+        if(remove && index->hash_tbl[i].offset == offset){
+            continue;
+        }
+        index->hash_tbl[j] = index->hash_tbl[i];
+        if(index->hash_tbl[j].offset > offset){
+            index->hash_tbl[j].offset += size_diff;
+        }
+        j++;
+    }
+    for(i = 0; i < index->count; i++){
+        if(remove && index->name_tbl[i] == offset){
+            continue;
+        }
+        index->name_tbl[k] = index->name_tbl[i];
+        if(index->name_tbl[k] > offset){
+            index->name_tbl[k] += size_diff;
+        }
+        k++;
+    }
+    CFSTORE_ASSERT(j == k);
+    index->count = j;
+}
+
+
+/* @brief   classify a key_name_query and return the length of the literal
+ *          part of the query (i.e. excluding a trailing '*') */
+static cfstore_query_type_t cfstore_index_get_query_type(const char* key_name_query, size_t* len)
+{
+    const char* star = strchr(key_name_query, '*');
+
+    *len = strlen(key_name_query);
+    if(star == NULL){
+        return cfstore_query_type_exact;
+    }
+    if(star == key_name_query + *len - 1){
+        (*len)--;
+        return cfstore_query_type_prefix;
+    }
+    return cfstore_query_type_pattern;
+}
+
+
+/* @brief   check whether the KV at offset may be returned to the client by a find */
+static bool cfstore_index_is_findable(uint32_t offset)
+{
+    cfstore_area_hkvt_t hkvt = cfstore_get_hkvt_from_head_ptr(cfstore_ctx_get()->area_0_head + offset);
+
+    return !cfstore_hkvt_get_flags_delete(&hkvt) && cfstore_is_kv_client_readable(&hkvt);
+}
+
+
+/* @brief   find the first KV following prev (in area order) which matches an
+ *          exact or "prefix*" key_name_query, using the index.
+ *
+ * The search returns the same KV as walking the area would, so Find()
+ * iteration order is unaffected by the index.
+ *
+ * @return  as for cfstore_find_ex()
+ */
+static int32_t cfstore_index_find(const char* key_name_query, cfstore_query_type_t type, size_t len, cfstore_area_hkvt_t *prev, cfstore_area_hkvt_t *next)
+{
+    uint32_t i = 0;
+    uint32_t hash = 0;
+    uint32_t offset = 0;
+    uint32_t start = 0;
+    uint32_t found = CFSTORE_INDEX_OFFSET_NONE;
+    cfstore_ctx_t* ctx = cfstore_ctx_get();
+    cfstore_area_index_t* index = &ctx->index;
+
+    CFSTORE_TP(CFSTORE_TP_FIND, "%s:entered: key_name_query=\"%s\", type=%d\n", __func__, key_name_query, (int) type);
+    if(prev != NULL){
+        start = (uint32_t) (prev->tail - ctx->area_0_head);
+    }
+    if(type == cfstore_query_type_exact){
+        hash = cfstore_index_hash(key_name_query, len);
+        for(i = cfstore_index_hash_lower_bound(hash); i < index->count && index->hash_tbl[i].hash == hash; i++){
+            offset = index->hash_tbl[i].offset;
+            if(offset >= start && offset < found && cfstore_index_name_cmp(offset, key_name_query, len, false) == 0 && cfstore_index_is_findable(offset)){
+                found = offset;
+            }
+        }
+    } else {
+        for(i = cfstore_index_name_lower_bound(key_name_query, len); i < index->count && cfstore_index_name_cmp(index->name_tbl[i], key_name_query, len, true) == 0; i++){
+            offset = index->name_tbl[i];
+            if(offset >= start && offset < found && cfstore_index_is_findable(offset)){
+                found = offset;
+            }
+        }
+    }
+    if(found == CFSTORE_INDEX_OFFSET_NONE){
+        CFSTORE_TP(CFSTORE_TP_FIND, "%s:No more KVs found\n", __func__);
+        memset((void*) next, 0, sizeof(cfstore_area_hkvt_t));
+        return ARM_CFSTORE_DRIVER_ERROR_KEY_NOT_FOUND;
+    }
+    *next = cfstore_get_hkvt_from_head_ptr(ctx->area_0_head + found);
+    return ARM_DRIVER_OK;
+}
+
+#else
+
+static CFSTORE_INLINE void cfstore_index_invalidate(void) { return; }
+static CFSTORE_INLINE void cfstore_index_add(uint8_t* head) { (void) head; return; }
+static CFSTORE_INLINE void cfstore_index_update(uint8_t* head, int32_t size_diff, bool remove) { (void) head; (void) size_diff; (void) remove; return; }
+
+#endif /* CFSTORE_KEY_INDEX_ENABLE */
+
+
 /*
  * Flash support functions
  */
@@ -1727,6 +2164,8 @@ static int32_t cfstore_fsm_read_on_entry(void* context)
             cfstore_fsm_state_set(&ctx->fsm, cfstore_fsm_state_ready, ctx);
             goto out;
         }
+        /* the area is being replaced by the flash image so the index is rebuilt on first use */
+        cfstore_index_invalidate();
         ret = FlashJournal_read(&ctx->jrnl, (void*) ctx->area_0_head, ctx->info.sizeofJournaledBlob);
         if(ret < ARM_DRIVER_OK){
             CFSTORE_ERRLOG("%s:Error: failed to initialize flash journaling layer (ret=%d)\n", __func__, (int) ret);
@@ -2392,6 +2831,7 @@ static int32_t cfstore_delete_ex(cfstore_area_hkvt_t* hkvt)
     memset(ctx->area_0_tail-kv_size, 0, kv_size);
 
     /* The KV area has shrunk so a negative size_diff should be indicated to cfstore_file_update(). */
+    cfstore_index_update(hkvt->head, -1 * kv_size, true);
     ret = cfstore_file_update(hkvt->head, -1 * kv_size);
     if(ret < ARM_DRIVER_OK){
         CFSTORE_ERRLOG("%s:Error:file update failed\n", __func__);
@@ -3142,8 +3582,25 @@ static int32_t cfstore_find_ex(const char* key_name_query, cfstore_area_hkvt_t *
     uint8_t next_key_len;
     char key_name[CFSTORE_KEY_NAME_MAX_LENGTH+1];
     cfstore_ctx_t* ctx = cfstore_ctx_get();
+#if CFSTORE_KEY_INDEX_ENABLE
+    size_t query_len = 0;
+    cfstore_query_type_t query_type = cfstore_query_type_pattern;
+#endif /* CFSTORE_KEY_INDEX_ENABLE */
 
     CFSTORE_TP((CFSTORE_TP_FIND|CFSTORE_TP_FENTRY), "%s:entered: key_name_query=\"%s\", prev=%p, next=%p\n", __func__, key_name_query, prev, next);
+#if CFSTORE_KEY_INDEX_ENABLE
+    /* exact and "prefix*" queries are serviced by the index. Other patterns,
+     * or an index which cant be built, fall through to walking the area. */
+    query_type = cfstore_index_get_query_type(key_name_query, &query_len);
+    if(query_type != cfstore_query_type_pattern){
+        if(!ctx->index.valid){
+            cfstore_index_build();
+        }
+        if(ctx->index.valid){
+            return cfstore_index_find(key_name_query, query_type, query_len, prev, next);
+        }
+    }
+#endif /* CFSTORE_KEY_INDEX_ENABLE */
     if(prev == NULL){
         ret = cfstore_get_head_hkvt(next);
         /* CFSTORE_TP(CFSTORE_TP_FIND, "%s:next->head=%p, next->key=%p, next->value=%p, next->tail=%p, \n", __func__, next->head, next->key, next->value, next->tail); */
@@ -3374,6 +3831,7 @@ static int32_t cfstore_recreate(const char* key_name, ARM_CFSTORE_SIZE value_len
     if (kv_size_diff < 0){
         /* value blob size shrinking => do memmove() before realloc() which will free memory */
         memmove(hkvt->tail + kv_size_diff, hkvt->tail, memmove_len);
+        cfstore_index_update(hkvt->head, kv_size_diff, false);
         ret = cfstore_file_update(hkvt->head, kv_size_diff);
         if(ret < ARM_DRIVER_OK){
             CFSTORE_ERRLOG("%s:Error:file update failed\n", __func__);
@@ -3397,6 +3855,7 @@ static int32_t cfstore_recreate(const char* key_name, ARM_CFSTORE_SIZE value_len
     if(kv_size_diff > 0) {
         /* value blob size growing requires memmove() after realloc() */
         memmove(hkvt->tail+kv_size_diff, hkvt->tail, memmove_len);
+        cfstore_index_update(hkvt->head, kv_size_diff, false);
         ret = cfstore_file_update(hkvt->head, kv_size_diff);
         if(ret < ARM_DRIVER_OK){
             CFSTORE_ERRLOG("%s:Error:file update failed\n", __func__);
@@ -3542,6 +4001,7 @@ static int32_t cfstore_create(const char* key_name, ARM_CFSTORE_SIZE value_len,
     hdr->perm_other_execute = kdesc->acl.perm_other_execute;
     strncpy((char*)hdr + sizeof(cfstore_area_header_t), key_name, strlen(key_name));
     hkvt = cfstore_get_hkvt_from_head_ptr((uint8_t*) hdr);
+    cfstore_index_add(hkvt.head);
     if(cfstore_flags_is_default(kdesc->flags)){
         /* set as read-only by default default */
         flags.read = true;
@@ -3962,6 +4422,7 @@ static int32_t cfstore_initialise(ARM_CFSTORE_CALLBACK callback, void* client_co
         /* ctx->rw_area0_lock initialisation is not required here as the lock is statically initialised to 0 */
         ctx->area_0_head = NULL;
         ctx->area_0_tail = NULL;
+        cfstore_index_invalidate();
 
         CFSTORE_ASSERT(sizeof(cfstore_file_t) == CFSTORE_HANDLE_BUFSIZE);
         if(sizeof(cfstore_file_t) != CFSTORE_HANDLE_BUFSIZE){
@@ -4061,6 +4522,7 @@ static int32_t cfstore_uninitialise(void)
             ctx->area_0_tail = NULL;
             ctx->area_0_len = 0;
         }
+        cfstore_index_invalidate();
     }
 out:
     /* notify client */
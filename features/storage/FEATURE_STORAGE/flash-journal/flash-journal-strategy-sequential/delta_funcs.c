@@ -0,0 +1,529 @@
+/*
+ * Copyright (c) 2006-2017, ARM Limited, All Rights Reserved
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Delta logging for the sequential strategy.
+ *
+ * A slot is normally filled by a single blob (the checkpoint): head, body, and
+ * a tail at the very end of the slot. Unless the blob fills the slot, this
+ * leaves erased space between the end of the body and the tail. Subsequent
+ * commits can then be appended to this space as a sequence of delta records,
+ * each of which carries a range of the blob which changed; a commit is sealed
+ * by a tail-like record holding the new blob size and a CRC32 over the records
+ * of that commit. Only once the space runs out, or after
+ * FLASH_JOURNAL_STRATEGY_SEQUENTIAL_DELTA_MAX_COMMITS deltas, does a commit
+ * fall back to erasing the next slot and writing a fresh checkpoint.
+ *
+ *     +-------------------------------+
+ *     |  slot header                  |
+ *     +-------------------------------+
+ *     |  BODY (checkpoint)            |
+ *     +-------------------------------+  <-- delta.start
+ *     |  delta head | data           |
+ *     |  delta head | data           |   delta commit 1
+ *     |  delta commit tail            |
+ *     |  delta head | data           |   delta commit 2
+ *     |  delta commit tail            |
+ *     +-------------------------------+  <-- delta.end (== delta.writeOffset)
+ *     |  erased                       |
+ *     +-------------------------------+
+ *     |  slot tail (checkpoint)       |
+ *     +-------------------------------+
+ *
+ * Records are only ever appended to erased memory, and a partially written
+ * commit fails its CRC32 during the initialization scan; the journal then
+ * falls back to the previous commit, and the next commit writes a checkpoint.
+ *
+ * All of the delta operations are synchronous; they are only enabled for
+ * MTDs which don't report asynchronous_ops.
+ */
+
+#include "flash-journal-strategy-sequential/flash_journal_crc.h"
+#include "support_funcs.h"
+#include <string.h>
+
+#define DELTA_CHUNK_SIZE 128
+
+/* Runs of changed data separated by fewer unchanged octets than this are
+ * merged into a single record; this is the cost of an additional delta head. */
+#define DELTA_MERGE_GAP  sizeof(SequentialFlashJournalDeltaHead_t)
+
+static inline uint32_t deltaSlotIndexBeingLogged(SequentialFlashJournal_t *journal)
+{
+    uint32_t index = journal->currentBlobIndex + 1;
+    return (index == journal->numSlots) ? 0 : index;
+}
+
+/* The slot-relative offset beyond which delta records may not extend; the slot tail lies beyond it. */
+static inline uint32_t deltaLimit(SequentialFlashJournal_t *journal)
+{
+    return journal->sizeofSlot - roundUp_uint32(sizeof(SequentialFlashJournalLogTail_t), journal->info.program_unit);
+}
+
+static inline uint32_t deltaSizeofRecord(SequentialFlashJournal_t *journal, uint32_t length)
+{
+    return sizeof(SequentialFlashJournalDeltaHead_t) + roundUp_uint32(length, journal->info.program_unit);
+}
+
+static int32_t deltaRead(SequentialFlashJournal_t *journal, uint64_t mtdOffset, void *buffer, uint32_t size)
+{
+    int32_t rc = journal->mtd->ReadData(mtdOffset, buffer, size);
+    if (rc != (int32_t)size) {
+        return JOURNAL_STATUS_STORAGE_IO_ERROR;
+    }
+    return JOURNAL_STATUS_OK;
+}
+
+static int32_t deltaProgram(SequentialFlashJournal_t *journal, uint64_t mtdOffset, const void *data, uint32_t size)
+{
+    const uint8_t *dataP = (const uint8_t *)data;
+    while (size) {
+        int32_t rc = journal->mtd->ProgramData(mtdOffset, dataP, size);
+        if (rc < ARM_DRIVER_OK) {
+            if (rc == ARM_STORAGE_ERROR_RUNTIME_OR_INTEGRITY_FAILURE) {
+                return JOURNAL_STATUS_STORAGE_RUNTIME_OR_INTEGRITY_FAILURE;
+            }
+            return JOURNAL_STATUS_STORAGE_IO_ERROR;
+        }
+        if ((rc == ARM_DRIVER_OK) || ((uint32_t)rc > size)) {
+            return JOURNAL_STATUS_ERROR; /* delta logging depends on synchronous completion. */
+        }
+        mtdOffset += rc;
+        dataP     += rc;
+        size      -= rc;
+    }
+    return JOURNAL_STATUS_OK;
+}
+
+int32_t flashJournalStrategySequential_deltaIsPossible(SequentialFlashJournal_t *journal)
+{
+    return FLASH_JOURNAL_STRATEGY_SEQUENTIAL_DELTA_ENABLE                                             &&
+           !journal->mtdCapabilities.asynchronous_ops                                                 &&
+           (journal->currentBlobIndex < journal->numSlots)                                            &&
+           ((sizeof(SequentialFlashJournalDeltaHead_t) % journal->info.program_unit) == 0)            &&
+           (journal->delta.writeOffset != 0)                                                          &&
+           (journal->delta.writeOffset == journal->delta.end)                                         &&
+           (journal->delta.numCommits < FLASH_JOURNAL_STRATEGY_SEQUENTIAL_DELTA_MAX_COMMITS);
+}
+
+/**
+ * Reset the delta state following the (re)discovery or the logging of a
+ * checkpoint in the current slot; the space following the body is taken to be
+ * erased and available for deltas.
+ */
+void flashJournalStrategySequential_deltaCheckpoint(SequentialFlashJournal_t *journal)
+{
+    journal->delta.sizeofCheckpoint = journal->info.sizeofJournaledBlob;
+    journal->delta.start            = roundUp_uint32(sizeof(SequentialFlashJournalLogHead_t) + journal->delta.sizeofCheckpoint,
+                                                     journal->info.program_unit);
+    journal->delta.end              = journal->delta.start;
+    journal->delta.writeOffset      = (journal->delta.start < deltaLimit(journal)) ? journal->delta.start : 0;
+    journal->delta.numCommits       = 0;
+}
+
+/**
+ * Read a range of the blob as reconstructed from the checkpoint and the delta
+ * records of the current slot lying below 'recordsEnd'.
+ */
+static int32_t deltaReadImage(SequentialFlashJournal_t *journal, uint32_t logicalOffset, uint8_t *buffer, uint32_t size, uint32_t recordsEnd)
+{
+    int32_t  rc;
+    uint64_t slotOffset = SLOT_ADDRESS(journal, journal->currentBlobIndex);
+
+    /* start with the checkpoint held in the body; anything beyond it is covered by deltas. */
+    uint32_t fromBody = 0;
+    if (logicalOffset < journal->delta.sizeofCheckpoint) {
+        fromBody = journal->delta.sizeofCheckpoint - logicalOffset;
+        if (fromBody > size) {
+            fromBody = size;
+        }
+        if ((rc = deltaRead(journal, slotOffset + sizeof(SequentialFlashJournalLogHead_t) + logicalOffset, buffer, fromBody)) != JOURNAL_STATUS_OK) {
+            return rc;
+        }
+    }
+    memset(buffer + fromBody, 0, size - fromBody);
+
+    /* overlay the deltas in the order in which they were logged. */
+    uint32_t recordOffset = journal->delta.start;
+    while (recordOffset < recordsEnd) {
+        SequentialFlashJournalDeltaHead_t head;
+        if ((rc = deltaRead(journal, slotOffset + recordOffset, &head, sizeof(head))) != JOURNAL_STATUS_OK) {
+            return rc;
+        }
+        if (head.magic == SEQUENTIAL_FLASH_JOURNAL_DELTA_COMMIT_MAGIC) {
+            recordOffset += sizeof(SequentialFlashJournalLogTail_t);
+            continue;
+        }
+        if (head.magic != SEQUENTIAL_FLASH_JOURNAL_DELTA_MAGIC) {
+            return JOURNAL_STATUS_METADATA_ERROR; /* records below recordsEnd have been validated before. */
+        }
+
+        uint32_t overlapStart = (head.offset > logicalOffset) ? head.offset : logicalOffset;
+        uint32_t overlapEnd   = ((head.offset + head.length) < (logicalOffset + size)) ? (head.offset + head.length) : (logicalOffset + size);
+        if (overlapStart < overlapEnd) {
+            if ((rc = deltaRead(journal,
+                                slotOffset + recordOffset + sizeof(head) + (overlapStart - head.offset),
+                                buffer + (overlapStart - logicalOffset),
+                                overlapEnd - overlapStart)) != JOURNAL_STATUS_OK) {
+                return rc;
+            }
+        }
+
+        recordOffset += deltaSizeofRecord(journal, head.length);
+    }
+
+    return JOURNAL_STATUS_OK;
+}
+
+int32_t flashJournalStrategySequential_deltaReadBlob(SequentialFlashJournal_t *journal, uint32_t logicalOffset, void *buffer, uint32_t size)
+{
+    return deltaReadImage(journal, logicalOffset, (uint8_t *)buffer, size, journal->delta.end);
+}
+
+/**
+ * Scan the space following the body of the current slot for committed deltas.
+ * This is expected to be called once the current slot has been established
+ * (and its checkpoint validated) during initialization. It leaves
+ * info.sizeofJournaledBlob updated to reflect the most recent delta commit.
+ */
+int32_t flashJournalStrategySequential_deltaDiscover(SequentialFlashJournal_t *journal)
+{
+    int32_t rc;
+
+    flashJournalStrategySequential_deltaCheckpoint(journal);
+    if ((journal->currentBlobIndex >= journal->numSlots) ||
+        (journal->mtdCapabilities.asynchronous_ops)      ||
+        (journal->delta.writeOffset == 0)) {
+        journal->delta.writeOffset = 0;
+        return JOURNAL_STATUS_OK;
+    }
+
+    uint64_t slotOffset   = SLOT_ADDRESS(journal, journal->currentBlobIndex);
+    uint32_t limit        = deltaLimit(journal);
+    uint32_t recordOffset = journal->delta.start;
+    uint8_t  buffer[DELTA_CHUNK_SIZE];
+
+    flashJournalCrcReset();
+    while ((recordOffset + sizeof(SequentialFlashJournalDeltaHead_t)) <= limit) {
+        SequentialFlashJournalDeltaHead_t head;
+        if ((rc = deltaRead(journal, slotOffset + recordOffset, &head, sizeof(head))) != JOURNAL_STATUS_OK) {
+            return rc;
+        }
+
+        if ((head.magic          == SEQUENTIAL_FLASH_JOURNAL_DELTA_MAGIC)                  &&
+            (head.sequenceNumber == journal->delta.numCommits + 1)                         &&
+            (head.length         <= journal->info.capacity)                                &&
+            (head.offset         <= journal->info.capacity - head.length)                  &&
+            (deltaSizeofRecord(journal, head.length) <= (limit - recordOffset))) {
+            flashJournalCrcCummulative((const unsigned char *)&head, sizeof(head));
+            for (uint32_t index = 0; index < head.length; index += DELTA_CHUNK_SIZE) {
+                uint32_t xfer = ((head.length - index) < DELTA_CHUNK_SIZE) ? (head.length - index) : DELTA_CHUNK_SIZE;
+                if ((rc = deltaRead(journal, slotOffset + recordOffset + sizeof(head) + index, buffer, xfer)) != JOURNAL_STATUS_OK) {
+                    return rc;
+                }
+                flashJournalCrcCummulative(buffer, xfer);
+            }
+            recordOffset += deltaSizeofRecord(journal, head.length);
+            continue;
+        }
+
+        if (head.magic == SEQUENTIAL_FLASH_JOURNAL_DELTA_COMMIT_MAGIC) {
+            SequentialFlashJournalLogTail_t *commitP = (SequentialFlashJournalLogTail_t *)&head;
+            uint32_t expectedCRC32 = commitP->crc32;
+            commitP->crc32 = 0;
+            if ((commitP->sequenceNumber == journal->delta.numCommits + 1) &&
+                (commitP->sizeofBlob     <= journal->info.capacity)       &&
+                (flashJournalCrcCummulative((const unsigned char *)commitP, sizeof(*commitP)) == expectedCRC32)) {
+                recordOffset += sizeof(SequentialFlashJournalLogTail_t);
+
+                journal->delta.end                = recordOffset;
+                journal->delta.numCommits        += 1;
+                journal->info.sizeofJournaledBlob = commitP->sizeofBlob;
+                flashJournalCrcReset();
+                continue;
+            }
+        }
+
+        break; /* either erased space, or an incomplete commit. */
+    }
+    flashJournalCrcReset();
+
+    /* Further deltas may only be appended if everything following the last
+     * commit is still erased; otherwise the next commit writes a checkpoint. */
+    ARM_STORAGE_INFO mtdInfo;
+    if (journal->mtd->GetInfo(&mtdInfo) != ARM_DRIVER_OK) {
+        return JOURNAL_STATUS_STORAGE_API_ERROR;
+    }
+    uint8_t erasedValue = mtdInfo.erased_value ? 0xFF : 0x00;
+
+    journal->delta.writeOffset = journal->delta.end;
+    for (uint32_t offset = journal->delta.end; offset < limit; offset += DELTA_CHUNK_SIZE) {
+        uint32_t xfer = ((limit - offset) < DELTA_CHUNK_SIZE) ? (limit - offset) : DELTA_CHUNK_SIZE;
+        if ((rc = deltaRead(journal, slotOffset + offset, buffer, xfer)) != JOURNAL_STATUS_OK) {
+            return rc;
+        }
+        for (uint32_t index = 0; index < xfer; index++) {
+            if (buffer[index] != erasedValue) {
+                journal->delta.writeOffset = 0;
+                return JOURNAL_STATUS_OK;
+            }
+        }
+    }
+
+    return JOURNAL_STATUS_OK;
+}
+
+/**
+ * Account for (or program, if 'program' is set) a delta record carrying
+ * 'length' octets of 'blob' starting at 'runStart'.
+ */
+static int32_t deltaEmitRecord(SequentialFlashJournal_t *journal,
+                               const uint8_t            *blob,
+                               uint32_t                  runStart,
+                               uint32_t                  length,
+                               bool                      program,
+                               uint32_t                 *requiredP)
+{
+    int32_t rc;
+
+    if (program) {
+        SequentialFlashJournalDeltaHead_t head = {
+            .offset         = journal->log.deltaLogicalOffset + runStart,
+            .magic          = SEQUENTIAL_FLASH_JOURNAL_DELTA_MAGIC,
+            .sequenceNumber = journal->delta.numCommits + 1,
+            .length         = length,
+        };
+        uint64_t mtdOffset = SLOT_ADDRESS(journal, journal->currentBlobIndex) + journal->delta.writeOffset;
+        uint32_t aligned   = length - (length % journal->info.program_unit);
+
+        /* Move writeOffset ahead of the IO: if anything fails from here on,
+         * the slot is no longer fit for deltas. */
+        journal->delta.writeOffset += deltaSizeofRecord(journal, length);
+        if (((rc = deltaProgram(journal, mtdOffset, &head, sizeof(head))) != JOURNAL_STATUS_OK) ||
+            ((rc = deltaProgram(journal, mtdOffset + sizeof(head), blob + runStart, aligned)) != JOURNAL_STATUS_OK)) {
+            return rc;
+        }
+        if (aligned < length) {
+            uint8_t padded[sizeof(SequentialFlashJournalDeltaHead_t)]; /* program_unit divides the size of a delta head. */
+            memset(padded, 0xFF, sizeof(padded));
+            memcpy(padded, blob + runStart + aligned, length - aligned);
+            if ((rc = deltaProgram(journal, mtdOffset + sizeof(head) + aligned, padded, journal->info.program_unit)) != JOURNAL_STATUS_OK) {
+                return rc;
+            }
+        }
+        flashJournalCrcCummulative((const unsigned char *)&head, sizeof(head));
+        flashJournalCrcCummulative(blob + runStart, length);
+    }
+
+    *requiredP += deltaSizeofRecord(journal, length);
+    return JOURNAL_STATUS_OK;
+}
+
+/**
+ * Compare a chunk of the blob being logged against the blob as of the previous
+ * commit, and emit a delta record for every changed range.
+ *
+ * @param [out] requiredP
+ *                  the amount of storage taken up by the delta records.
+ */
+static int32_t deltaForEachChange(SequentialFlashJournal_t *journal,
+                                  const uint8_t            *blob,
+                                  uint32_t                  size,
+                                  bool                      program,
+                                  uint32_t                 *requiredP)
+{
+    int32_t  rc;
+    uint32_t base         = journal->log.deltaLogicalOffset;
+    uint32_t previousSize = journal->info.sizeofJournaledBlob;
+    uint8_t  buffer[DELTA_CHUNK_SIZE];
+    bool     inRun        = false;
+    uint32_t runStart     = 0;
+    uint32_t runEnd       = 0;
+
+    *requiredP = 0;
+    for (uint32_t index = 0; index < size; index += DELTA_CHUNK_SIZE) {
+        uint32_t xfer = ((size - index) < DELTA_CHUNK_SIZE) ? (size - index) : DELTA_CHUNK_SIZE;
+
+        /* octets beyond the size of the previous blob are always taken to have changed. */
+        uint32_t comparable = 0;
+        if ((base + index) < previousSize) {
+            comparable = previousSize - (base + index);
+            if (comparable > xfer) {
+                comparable = xfer;
+            }
+            if ((rc = deltaReadImage(journal, base + index, buffer, comparable, journal->delta.end)) != JOURNAL_STATUS_OK) {
+                return rc;
+            }
+        }
+
+        for (uint32_t i = 0; i < xfer; i++) {
+            uint32_t position = index + i;
+            if ((i < comparable) && (buffer[i] == blob[position])) {
+                continue;
+            }
+
+            if (inRun && ((position - runEnd) < DELTA_MERGE_GAP)) {
+                runEnd = position + 1;
+                continue;
+            }
+            if (inRun && ((rc = deltaEmitRecord(journal, blob, runStart, runEnd - runStart, program, requiredP)) != JOURNAL_STATUS_OK)) {
+                return rc;
+            }
+            inRun    = true;
+            runStart = position;
+            runEnd   = position + 1;
+        }
+    }
+    if (inRun && ((rc = deltaEmitRecord(journal, blob, runStart, runEnd - runStart, program, requiredP)) != JOURNAL_STATUS_OK)) {
+        return rc;
+    }
+
+    return JOURNAL_STATUS_OK;
+}
+
+/**
+ * Log a chunk of a blob as a set of deltas against the previous commit.
+ *
+ * @return  > 0 the amount of data logged (aligned to program_unit).
+ *          = 0 if the change can't be (or isn't worth being) logged as a delta;
+ *              nothing has been written in this case.
+ *          < 0 for error.
+ */
+int32_t flashJournalStrategySequential_deltaLog(SequentialFlashJournal_t *journal, const void *blob, size_t size)
+{
+    int32_t  rc;
+    uint32_t required;
+
+    size -= size % journal->info.program_unit;
+
+    if ((rc = deltaForEachChange(journal, (const uint8_t *)blob, size, false, &required)) != JOURNAL_STATUS_OK) {
+        return rc;
+    }
+
+    /* leave room for the commit record. */
+    uint32_t available = deltaLimit(journal) - journal->delta.writeOffset;
+    if ((required + sizeof(SequentialFlashJournalLogTail_t)) > available) {
+        return 0;
+    }
+    if ((journal->state != SEQUENTIAL_JOURNAL_STATE_LOGGING_DELTA) && (required >= size)) {
+        return 0; /* a delta would cost more than logging the blob in full. */
+    }
+
+    if ((rc = deltaForEachChange(journal, (const uint8_t *)blob, size, true, &required)) != JOURNAL_STATUS_OK) {
+        journal->state = SEQUENTIAL_JOURNAL_STATE_INITIALIZED; /* reset state */
+        return rc;
+    }
+
+    journal->log.deltaLogicalOffset += size;
+    journal->state                   = SEQUENTIAL_JOURNAL_STATE_LOGGING_DELTA;
+    return size;
+}
+
+/**
+ * Seal the deltas logged since the previous commit.
+ */
+int32_t flashJournalStrategySequential_deltaCommit(SequentialFlashJournal_t *journal)
+{
+    int32_t rc;
+
+    SequentialFlashJournalLogTail_t commit = {
+        .sizeofBlob     = journal->log.deltaLogicalOffset,
+        .magic          = SEQUENTIAL_FLASH_JOURNAL_DELTA_COMMIT_MAGIC,
+        .sequenceNumber = journal->delta.numCommits + 1,
+        .crc32          = 0,
+    };
+    commit.crc32 = flashJournalCrcCummulative((const unsigned char *)&commit, sizeof(commit));
+    flashJournalCrcReset();
+
+    uint64_t mtdOffset = SLOT_ADDRESS(journal, journal->currentBlobIndex) + journal->delta.writeOffset;
+    journal->delta.writeOffset += sizeof(commit);
+    if ((rc = deltaProgram(journal, mtdOffset, &commit, sizeof(commit))) != JOURNAL_STATUS_OK) {
+        journal->state = SEQUENTIAL_JOURNAL_STATE_INITIALIZED; /* reset state */
+        return rc;
+    }
+
+    journal->delta.end                = journal->delta.writeOffset;
+    journal->delta.numCommits        += 1;
+    journal->info.sizeofJournaledBlob = commit.sizeofBlob;
+    journal->state                    = SEQUENTIAL_JOURNAL_STATE_INITIALIZED;
+    return 1; /* commit returns 1 upon completion. */
+}
+
+/**
+ * Switch an ongoing delta log over to a regular log into the next slot. This
+ * is needed when a chunk being appended to a delta log no longer fits into the
+ * current slot; the blob logged so far is copied over (as reconstructed from
+ * the current slot and the pending deltas) before the caller resumes logging
+ * the remaining chunks into the body of the new slot.
+ */
+int32_t flashJournalStrategySequential_deltaPromote(SequentialFlashJournal_t *journal)
+{
+    int32_t  rc;
+    uint32_t amountLogged   = journal->log.deltaLogicalOffset;
+    uint32_t recordsEnd     = journal->delta.writeOffset;
+    uint64_t mtdSlotOffset  = SLOT_ADDRESS(journal, deltaSlotIndexBeingLogged(journal));
+    uint8_t  buffer[DELTA_CHUNK_SIZE];
+
+    journal->state             = SEQUENTIAL_JOURNAL_STATE_INITIALIZED; /* in case of failure */
+    journal->delta.writeOffset = 0;                                    /* pending deltas are abandoned */
+
+    uint64_t mtdEraseOffset = mtdSlotOffset;
+    while (mtdEraseOffset < mtdSlotOffset + journal->sizeofSlot) {
+        if ((rc = journal->mtd->Erase(mtdEraseOffset, mtdSlotOffset + journal->sizeofSlot - mtdEraseOffset)) < ARM_DRIVER_OK) {
+            if (rc == ARM_STORAGE_ERROR_RUNTIME_OR_INTEGRITY_FAILURE) {
+                return JOURNAL_STATUS_STORAGE_RUNTIME_OR_INTEGRITY_FAILURE;
+            }
+            return JOURNAL_STATUS_ERROR;
+        }
+        if (rc == ARM_DRIVER_OK) {
+            return JOURNAL_STATUS_ERROR; /* delta logging depends on synchronous completion. */
+        }
+        mtdEraseOffset += rc;
+    }
+
+    SequentialFlashJournalLogHead_t head = {
+        .version        = SEQUENTIAL_FLASH_JOURNAL_VERSION,
+        .magic          = SEQUENTIAL_FLASH_JOURNAL_MAGIC,
+        .sequenceNumber = journal->nextSequenceNumber,
+        .reserved       = 0,
+    };
+    if ((rc = deltaProgram(journal, mtdSlotOffset, &head, sizeof(head))) != JOURNAL_STATUS_OK) {
+        return rc;
+    }
+    flashJournalCrcReset();
+    flashJournalCrcCummulative((const unsigned char *)&head, sizeof(head));
+
+    for (uint32_t offset = 0; offset < amountLogged; offset += DELTA_CHUNK_SIZE) {
+        uint32_t xfer = ((amountLogged - offset) < DELTA_CHUNK_SIZE) ? (amountLogged - offset) : DELTA_CHUNK_SIZE;
+        if (((rc = deltaReadImage(journal, offset, buffer, xfer, recordsEnd)) != JOURNAL_STATUS_OK) ||
+            ((rc = deltaProgram(journal, mtdSlotOffset + sizeof(head) + offset, buffer, xfer)) != JOURNAL_STATUS_OK)) {
+            return rc;
+        }
+        flashJournalCrcCummulative(buffer, xfer);
+    }
+
+    /* resume as if the blob logged so far had been logged into the new slot. */
+    journal->log.mtdOffset           = mtdSlotOffset + sizeof(head) + amountLogged;
+    journal->log.mtdTailOffset       = mtdSlotOffset + journal->sizeofSlot - sizeof(SequentialFlashJournalLogTail_t);
+    journal->log.tail.magic          = SEQUENTIAL_FLASH_JOURNAL_MAGIC;
+    journal->log.tail.sequenceNumber = journal->nextSequenceNumber;
+    journal->log.tail.sizeofBlob     = amountLogged;
+    journal->log.tail.crc32          = 0;
+    journal->state                   = SEQUENTIAL_JOURNAL_STATE_LOGGING_BODY;
+
+    return JOURNAL_STATUS_OK;
+}
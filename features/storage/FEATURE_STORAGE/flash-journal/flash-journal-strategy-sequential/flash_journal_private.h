@@ -31,13 +31,33 @@ static inline uint32_t roundDown_uint32(uint32_t N, uint32_t BOUNDARY) {
     return (((N) / (BOUNDARY)) * (BOUNDARY));
 }
 
-#define LCM_OF_ALL_ERASE_UNITS 4096 /* Assume an LCM of erase_units for now. This will be generalized later. */
+/**
+ * Delta logging: when enabled, a log()/commit() sequence on a synchronous MTD
+ * may append only the ranges of the blob which changed since the previous
+ * commit to the free space of the current slot, instead of erasing and
+ * rewriting the next slot in full. Reads reconstruct the blob by applying the
+ * committed deltas on top of the slot's body (the checkpoint).
+ */
+#ifndef FLASH_JOURNAL_STRATEGY_SEQUENTIAL_DELTA_ENABLE
+#define FLASH_JOURNAL_STRATEGY_SEQUENTIAL_DELTA_ENABLE 1
+#endif
+
+/**
+ * Maximum number of delta commits layered on top of a checkpoint. The next
+ * commit after this many deltas writes a full checkpoint into the next slot;
+ * this bounds the work done by reads and by the initialization scan.
+ */
+#ifndef FLASH_JOURNAL_STRATEGY_SEQUENTIAL_DELTA_MAX_COMMITS
+#define FLASH_JOURNAL_STRATEGY_SEQUENTIAL_DELTA_MAX_COMMITS 32
+#endif
 
 static const uint32_t SEQUENTIAL_FLASH_JOURNAL_INVALD_NEXT_SEQUENCE_NUMBER = 0xFFFFFFFFUL;
 static const uint32_t SEQUENTIAL_FLASH_JOURNAL_MAGIC                       = 0xCE02102AUL;
 static const uint32_t SEQUENTIAL_FLASH_JOURNAL_VERSION                     = 1;
 static const uint32_t SEQUENTIAL_FLASH_JOURNAL_HEADER_MAGIC                = 0xCEA00AEEUL;
 static const uint32_t SEQUENTIAL_FLASH_JOURNAL_HEADER_VERSION              = 1;
+static const uint32_t SEQUENTIAL_FLASH_JOURNAL_DELTA_MAGIC                 = 0xCE0DE17AUL;
+static const uint32_t SEQUENTIAL_FLASH_JOURNAL_DELTA_COMMIT_MAGIC          = 0xCE0DC0DEUL;
 
 
 typedef enum {
@@ -50,6 +70,7 @@ typedef enum {
     SEQUENTIAL_JOURNAL_STATE_LOGGING_BODY,
     SEQUENTIAL_JOURNAL_STATE_LOGGING_TAIL,
     SEQUENTIAL_JOURNAL_STATE_READING,
+    SEQUENTIAL_JOURNAL_STATE_LOGGING_DELTA,
 } SequentialFlashJournalState_t;
 
 /**
@@ -97,6 +118,24 @@ typedef struct _SequentialFlashJournalLogTail {
 
 #define SEQUENTIAL_JOURNAL_VALID_TAIL(TAIL_PTR) ((TAIL_PTR)->magic == SEQUENTIAL_FLASH_JOURNAL_MAGIC)
 
+/**
+ * Meta-data placed at the head of a delta record. Delta records are appended
+ * to the free space between the body and the tail of the current slot; each
+ * carries a range of the blob which changed since the previous commit, and is
+ * followed by 'length' octets of data (padded to program_unit).
+ *
+ * A delta commit is terminated by a SequentialFlashJournalLogTail_t carrying
+ * SEQUENTIAL_FLASH_JOURNAL_DELTA_COMMIT_MAGIC; its CRC32 covers the records of
+ * that commit and the terminating tail itself. 'magic' occupies the same
+ * position in both structures so that they can be told apart while scanning.
+ */
+typedef struct _SequentialFlashJournalDeltaHead {
+    uint32_t offset;         /**< logical offset within the blob of the data which follows. */
+    uint32_t magic;
+    uint32_t sequenceNumber; /**< the delta commit (counting from 1 within the slot) to which this record belongs. */
+    uint32_t length;         /**< the amount of data following this head. */
+} SequentialFlashJournalDeltaHead_t;
+
 typedef struct _SequentialFlashJournal_t {
     FlashJournal_Ops_t             ops;                /**< the mandatory OPS table defining the strategy. */
     FlashJournal_Callback_t        callback;           /**< command completion callback. */
@@ -112,6 +151,15 @@ typedef struct _SequentialFlashJournal_t {
     SequentialFlashJournalState_t  state;              /**< state of the journal. SEQUENTIAL_JOURNAL_STATE_INITIALIZED being the default. */
     FlashJournal_OpCode_t          prevCommand;        /**< the last command issued to the journal. */
 
+    /** state of the delta records layered upon the checkpoint in the current slot. */
+    struct {
+        uint32_t sizeofCheckpoint; /**< size of the blob held in the body of the current slot. */
+        uint32_t start;            /**< slot-relative offset of the first delta record. */
+        uint32_t end;              /**< slot-relative offset following the most recently committed delta. */
+        uint32_t writeOffset;      /**< slot-relative offset for the next delta record; 0 if the slot can't take further deltas. */
+        uint32_t numCommits;       /**< number of deltas committed on top of the checkpoint. */
+    } delta;
+
     /**
      * The following is a union of sub-structures meant to keep state relevant
      * to the commands during their execution.
@@ -144,6 +192,9 @@ typedef struct _SequentialFlashJournal_t {
                         SequentialFlashJournalLogTail_t tail;
                     };
                 };
+                struct {
+                    uint32_t deltaLogicalOffset; /**< amount of the new blob already accounted for by delta records. */
+                };
             };
         } log;
 
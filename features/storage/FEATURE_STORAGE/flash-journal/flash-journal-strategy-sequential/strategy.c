@@ -32,6 +32,7 @@ static inline int32_t flashJournalStrategySequential_format_sanityChecks(ARM_DRI
 static inline int32_t flashJournalStrategySequential_read_sanityChecks(SequentialFlashJournal_t *journal, const void *blob, size_t sizeofBlob);
 static inline int32_t flashJournalStrategySequential_log_sanityChecks(SequentialFlashJournal_t *journal, const void *blob, size_t sizeofBlob);
 static inline int32_t flashJournalStrategySequential_commit_sanityChecks(SequentialFlashJournal_t *journal);
+static inline int32_t flashJournalStrategySequential_readDelta(SequentialFlashJournal_t *journal);
 
 
 int32_t flashJournalStrategySequential_format(ARM_DRIVER_STORAGE      *mtd,
@@ -243,8 +244,12 @@ int32_t flashJournalStrategySequential_read(FlashJournal_t *_journal, void *blob
                                         (journal->info.sizeofJournaledBlob - journal->read.logicalOffset) : sizeofBlob;
     // printf("amount left to read %u\n", journal->read.amountLeftToRead);
 
-    journal->state       = SEQUENTIAL_JOURNAL_STATE_READING;
     journal->prevCommand = FLASH_JOURNAL_OPCODE_READ_BLOB;
+    if (journal->delta.numCommits > 0) {
+        return flashJournalStrategySequential_readDelta(journal);
+    }
+
+    journal->state       = SEQUENTIAL_JOURNAL_STATE_READING;
     return flashJournalStrategySequential_read_progress();
 }
 
@@ -269,8 +274,12 @@ int32_t flashJournalStrategySequential_readFrom(FlashJournal_t *_journal, size_t
                                         (journal->info.sizeofJournaledBlob - journal->read.logicalOffset) : sizeofBlob;
     // printf("amount left to read %u\n", journal->read.amountLeftToRead);
 
-    journal->state       = SEQUENTIAL_JOURNAL_STATE_READING;
     journal->prevCommand = FLASH_JOURNAL_OPCODE_READ_BLOB;
+    if (journal->delta.numCommits > 0) {
+        return flashJournalStrategySequential_readDelta(journal);
+    }
+
+    journal->state       = SEQUENTIAL_JOURNAL_STATE_READING;
     return flashJournalStrategySequential_read_progress();
 }
 
@@ -289,7 +298,22 @@ int32_t flashJournalStrategySequential_log(FlashJournal_t *_journal, const void
 
     if (journal->prevCommand != FLASH_JOURNAL_OPCODE_LOG_BLOB) {
         /*
-         * This is the first log in the sequence. We have to begin by identifying a new slot and erasing it.
+         * This is the first log in the sequence. If the changes with respect
+         * to the previous commit fit into the current slot, log them as deltas.
+         */
+        if (flashJournalStrategySequential_deltaIsPossible(journal)) {
+            journal->log.deltaLogicalOffset = 0;
+            flashJournalCrcReset();
+            if ((rc = flashJournalStrategySequential_deltaLog(journal, blob, size)) != 0) {
+                if (rc > 0) {
+                    journal->prevCommand = FLASH_JOURNAL_OPCODE_LOG_BLOB;
+                }
+                return rc;
+            }
+        }
+
+        /*
+         * Otherwise we have to begin by identifying a new slot and erasing it.
          */
 
          /* choose the next slot */
@@ -304,6 +328,18 @@ int32_t flashJournalStrategySequential_log(FlashJournal_t *_journal, const void
         journal->prevCommand        = FLASH_JOURNAL_OPCODE_LOG_BLOB;
     } else {
         /* This is a continuation of an ongoing logging sequence. */
+        if (journal->state == SEQUENTIAL_JOURNAL_STATE_LOGGING_DELTA) {
+            if ((rc = flashJournalStrategySequential_deltaLog(journal, blob, size)) != 0) {
+                return rc;
+            }
+
+            /* The current slot has run out of space for deltas; move the
+             * blob logged so far into the next slot and carry on there. */
+            if ((rc = flashJournalStrategySequential_deltaPromote(journal)) != JOURNAL_STATUS_OK) {
+                return rc;
+            }
+        }
+
         journal->log.dataBeingLogged = blob;
         journal->log.amountLeftToLog = size;
     }
@@ -322,6 +358,11 @@ int32_t flashJournalStrategySequential_commit(FlashJournal_t *_journal)
         return rc;
     }
 
+    if (journal->state == SEQUENTIAL_JOURNAL_STATE_LOGGING_DELTA) {
+        journal->prevCommand = FLASH_JOURNAL_OPCODE_COMMIT;
+        return flashJournalStrategySequential_deltaCommit(journal);
+    }
+
     if (journal->prevCommand == FLASH_JOURNAL_OPCODE_LOG_BLOB) {
         /* the tail has already been setup during previous calls to log(); we can now include it in the crc32. */
         journal->log.tail.crc32 = flashJournalCrcCummulative((const unsigned char *)&journal->log.tail, sizeof(SequentialFlashJournalLogTail_t));
@@ -399,7 +440,12 @@ int32_t flashJournalStrategySequential_format_sanityChecks(ARM_DRIVER_STORAGE *m
     if ((mtdAddr % mtdInfo.program_unit) != 0) { /* ensure that the journal starts at a programmable unit */
         return JOURNAL_STATUS_PARAMETER;
     }
-    if ((mtdAddr % LCM_OF_ALL_ERASE_UNITS) != 0) { /* ensure that the journal starts and ends at an erase-boundary */
+    uint32_t eraseUnitLCM;
+    int32_t rc;
+    if ((rc = mtdGetEraseUnitLCM(mtd, mtdAddr, mtdInfo.total_storage, &eraseUnitLCM)) != JOURNAL_STATUS_OK) {
+        return rc;
+    }
+    if ((mtdAddr % eraseUnitLCM) != 0) { /* ensure that the journal starts and ends at an erase-boundary */
         return JOURNAL_STATUS_PARAMETER;
     }
 
@@ -434,7 +480,9 @@ int32_t flashJournalStrategySequential_log_sanityChecks(SequentialFlashJournal_t
     if ((journal->state == SEQUENTIAL_JOURNAL_STATE_NOT_INITIALIZED) || (journal->state == SEQUENTIAL_JOURNAL_STATE_INIT_SCANNING_LOG_HEADERS)) {
         return JOURNAL_STATUS_NOT_INITIALIZED;
     }
-    if ((journal->state != SEQUENTIAL_JOURNAL_STATE_INITIALIZED) && (journal->state != SEQUENTIAL_JOURNAL_STATE_LOGGING_BODY)) {
+    if ((journal->state != SEQUENTIAL_JOURNAL_STATE_INITIALIZED)  &&
+        (journal->state != SEQUENTIAL_JOURNAL_STATE_LOGGING_BODY) &&
+        (journal->state != SEQUENTIAL_JOURNAL_STATE_LOGGING_DELTA)) {
         return JOURNAL_STATUS_ERROR; /* journal is in an un-expected state. */
     }
     if (journal->state == SEQUENTIAL_JOURNAL_STATE_INITIALIZED) {
@@ -445,6 +493,10 @@ int32_t flashJournalStrategySequential_log_sanityChecks(SequentialFlashJournal_t
         if (journal->log.mtdOffset + sizeofBlob > journal->log.mtdTailOffset) {
             return JOURNAL_STATUS_BOUNDED_CAPACITY; /* adding this log chunk would cause us to exceed capacity (write past the tail). */
         }
+    } else if (journal->state == SEQUENTIAL_JOURNAL_STATE_LOGGING_DELTA) {
+        if (journal->log.deltaLogicalOffset + sizeofBlob > journal->info.capacity) {
+            return JOURNAL_STATUS_BOUNDED_CAPACITY; /* the blob would no longer fit into a slot. */
+        }
     }
 
     /* ensure that the request is at least as large as the minimum program unit */
@@ -460,6 +512,11 @@ int32_t flashJournalStrategySequential_commit_sanityChecks(SequentialFlashJourna
     if (journal == NULL) {
         return JOURNAL_STATUS_PARAMETER;
     }
+    if (journal->state == SEQUENTIAL_JOURNAL_STATE_LOGGING_DELTA) {
+        if (journal->prevCommand != FLASH_JOURNAL_OPCODE_LOG_BLOB) {
+            return JOURNAL_STATUS_ERROR;
+        }
+    }
     if (journal->state == SEQUENTIAL_JOURNAL_STATE_LOGGING_BODY) {
         if (journal->prevCommand != FLASH_JOURNAL_OPCODE_LOG_BLOB) {
             return JOURNAL_STATUS_ERROR;
@@ -475,3 +532,23 @@ int32_t flashJournalStrategySequential_commit_sanityChecks(SequentialFlashJourna
 
     return JOURNAL_STATUS_OK;
 }
+
+/**
+ * Read-back for a slot which holds deltas on top of its checkpoint. This is
+ * always synchronous since deltas are only ever logged to synchronous MTDs.
+ */
+int32_t flashJournalStrategySequential_readDelta(SequentialFlashJournal_t *journal)
+{
+    int32_t rc;
+    if ((rc = flashJournalStrategySequential_deltaReadBlob(journal,
+                                                          journal->read.logicalOffset,
+                                                          journal->read.dataBeingRead,
+                                                          journal->read.amountLeftToRead)) != JOURNAL_STATUS_OK) {
+        return rc;
+    }
+
+    journal->read.logicalOffset    += journal->read.amountLeftToRead;
+    journal->read.dataBeingRead    += journal->read.amountLeftToRead;
+    journal->read.amountLeftToRead  = 0;
+    return (journal->read.dataBeingRead - journal->read.blob);
+}
@@ -37,6 +37,64 @@ int32_t mtdGetStartAddr(ARM_DRIVER_STORAGE *mtd, uint64_t *startAddrP)
     return JOURNAL_STATUS_OK;
 }
 
+static uint32_t gcd_uint32(uint32_t a, uint32_t b)
+{
+    while (b != 0) {
+        uint32_t r = a % b;
+        a = b;
+        b = r;
+    }
+    return a;
+}
+
+/**
+ * Determine the least common multiple of the erase_units of the storage
+ * blocks of an MTD which overlap the range used by the journal. The journal
+ * header and every slot are sized and aligned to this value so that each of
+ * them can be erased independently of its neighbours.
+ *
+ * @param       startAddr
+ *                  start of the range used by the journal.
+ * @param       size
+ *                  size of the range used by the journal.
+ * @param [out] lcmP
+ *                  the LCM of the erase_units; or the program_unit if none of
+ *                  the blocks in the range is erasable.
+ */
+int32_t mtdGetEraseUnitLCM(ARM_DRIVER_STORAGE *mtd, uint64_t startAddr, uint64_t size, uint32_t *lcmP)
+{
+    ARM_STORAGE_INFO mtdInfo;
+    if (mtd->GetInfo(&mtdInfo) < ARM_DRIVER_OK) {
+        return JOURNAL_STATUS_STORAGE_API_ERROR;
+    }
+
+    uint32_t lcm = mtdInfo.program_unit;
+    ARM_STORAGE_BLOCK mtdBlock;
+    for (mtd->GetNextBlock(NULL, &mtdBlock); ARM_STORAGE_VALID_BLOCK(&mtdBlock); mtd->GetNextBlock(&mtdBlock, &mtdBlock)) {
+        if ((mtdBlock.addr >= startAddr + size) || (mtdBlock.addr + mtdBlock.size <= startAddr)) {
+            continue; /* outside the journal */
+        }
+        if (!mtdBlock.attributes.erasable) {
+            continue;
+        }
+        if (mtdBlock.attributes.erase_unit == 0) {
+            return JOURNAL_STATUS_STORAGE_API_ERROR;
+        }
+
+        uint64_t blockLCM = ((uint64_t)lcm / gcd_uint32(lcm, mtdBlock.attributes.erase_unit)) * mtdBlock.attributes.erase_unit;
+        if (blockLCM > size) {
+            return JOURNAL_STATUS_PARAMETER; /* the geometry of the MTD doesn't allow independently erasable slots. */
+        }
+        lcm = (uint32_t)blockLCM;
+    }
+    if (lcm == 0) {
+        return JOURNAL_STATUS_STORAGE_API_ERROR;
+    }
+
+    *lcmP = lcm;
+    return JOURNAL_STATUS_OK;
+}
+
 /**
  * Check the sanity of a given slot
  * @param       journal
@@ -140,6 +198,15 @@ int32_t setupSequentialJournalHeader(SequentialFlashJournalHeader_t *headerP, AR
     if (mtd->GetInfo(&mtdInfo) < ARM_DRIVER_OK) {
         return JOURNAL_STATUS_STORAGE_API_ERROR;
     }
+    uint64_t mtdAddr;
+    if (mtdGetStartAddr(mtd, &mtdAddr) < JOURNAL_STATUS_OK) {
+        return JOURNAL_STATUS_STORAGE_API_ERROR;
+    }
+    uint32_t eraseUnitLCM;
+    int32_t rc;
+    if ((rc = mtdGetEraseUnitLCM(mtd, mtdAddr, totalSize, &eraseUnitLCM)) != JOURNAL_STATUS_OK) {
+        return rc;
+    }
 
     headerP->genericHeader.magic        = FLASH_JOURNAL_HEADER_MAGIC;
     headerP->genericHeader.version      = FLASH_JOURNAL_HEADER_VERSION;
@@ -149,7 +216,7 @@ int32_t setupSequentialJournalHeader(SequentialFlashJournalHeader_t *headerP, AR
      * Constraint: journal header should start and terminate at an erase-boundary
      * (so that slot-0 can be erased independently), and also a program-unit boundary.
      */
-    headerP->genericHeader.journalOffset = roundUp_uint32(headerP->genericHeader.sizeofHeader, LCM_OF_ALL_ERASE_UNITS);
+    headerP->genericHeader.journalOffset = roundUp_uint32(headerP->genericHeader.sizeofHeader, eraseUnitLCM);
     if ((headerP->genericHeader.journalOffset % mtdInfo.program_unit) != 0) {
         //printf("setupSequentialJournalHeader: journalOffset is not a multiple of MTD's program_unit\r\n");
         return JOURNAL_STATUS_PARAMETER;
@@ -163,7 +230,7 @@ int32_t setupSequentialJournalHeader(SequentialFlashJournalHeader_t *headerP, AR
      * Constraint: slot-size should be a multiple of the erase-units of all involved storage blocks.
      */
     uint64_t spaceAvailableForSlots = totalSize - headerP->genericHeader.journalOffset;
-    headerP->sizeofSlot = roundDown_uint32(spaceAvailableForSlots / numSlots, LCM_OF_ALL_ERASE_UNITS);
+    headerP->sizeofSlot = roundDown_uint32(spaceAvailableForSlots / numSlots, eraseUnitLCM);
     if (headerP->sizeofSlot == 0) {
         //printf("setupSequentialJournalHeader: not enough space to create %" PRIu32 " slots\r\n", numSlots);
         return JOURNAL_STATUS_PARAMETER;
@@ -235,6 +302,12 @@ int32_t discoverLatestLoggedBlob(SequentialFlashJournal_t *journal)
         journal->nextSequenceNumber = 0;
     }
 
+    /* pick up any deltas committed on top of the most recent slot. */
+    int32_t rc;
+    if ((rc = flashJournalStrategySequential_deltaDiscover(journal)) != JOURNAL_STATUS_OK) {
+        return rc;
+    }
+
     journal->state = SEQUENTIAL_JOURNAL_STATE_INITIALIZED;
     return JOURNAL_STATUS_OK;
 }
@@ -249,7 +322,7 @@ int32_t flashJournalStrategySequential_format_progress(int32_t status, ARM_STORA
 {
     int32_t rc;
     size_t sizeofWrite = roundUp_uint32(formatInfoSingleton.header.genericHeader.sizeofHeader, formatInfoSingleton.mtdProgramUnit);
-    size_t sizeofErase = roundUp_uint32(formatInfoSingleton.header.genericHeader.sizeofHeader, LCM_OF_ALL_ERASE_UNITS);
+    size_t sizeofErase = formatInfoSingleton.header.genericHeader.journalOffset; /* the header is padded to the LCM of erase_units. */
     switch (operationWhichJustFinshed) {
         case ARM_STORAGE_OPERATION_INITIALIZE:
             if (status != ARM_DRIVER_OK) {
@@ -557,6 +630,7 @@ int32_t flashJournalStrategySequential_log_progress(void)
                     journal->currentBlobIndex = 0;
                 }
                 // printf("currentBlobIndex: %lu\n", journal->currentBlobIndex);
+                flashJournalStrategySequential_deltaCheckpoint(journal); /* the new slot has room for deltas following its body. */
 
                 /* increment next sequence number */
                 ++journal->nextSequenceNumber;
@@ -624,6 +698,7 @@ void mtdHandler(int32_t status, ARM_STORAGE_OPERATION operation)
             case SEQUENTIAL_JOURNAL_STATE_LOGGING_HEAD:
             case SEQUENTIAL_JOURNAL_STATE_LOGGING_BODY:
             case SEQUENTIAL_JOURNAL_STATE_LOGGING_TAIL:
+            case SEQUENTIAL_JOURNAL_STATE_LOGGING_DELTA:
                 /* reset journal state to allow further operation. */
                 activeJournal->state = SEQUENTIAL_JOURNAL_STATE_INITIALIZED;
 
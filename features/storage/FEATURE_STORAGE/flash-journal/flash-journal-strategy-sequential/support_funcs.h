@@ -50,6 +50,7 @@ int32_t slotIsSane(SequentialFlashJournal_t        *journal,
                    SequentialFlashJournalLogTail_t *tailP);
 
 int32_t mtdGetStartAddr(ARM_DRIVER_STORAGE *mtd, uint64_t *startAddrP);
+int32_t mtdGetEraseUnitLCM(ARM_DRIVER_STORAGE *mtd, uint64_t startAddr, uint64_t size, uint32_t *lcmP);
 int32_t setupSequentialJournalHeader(SequentialFlashJournalHeader_t *headerP, ARM_DRIVER_STORAGE *mtd, uint64_t totalSize, uint32_t numSlots);
 int32_t discoverLatestLoggedBlob(SequentialFlashJournal_t *journal);
 
@@ -72,6 +73,17 @@ int32_t flashJournalStrategySequential_log_progress(void);
 int32_t flashJournalStrategySequential_reset_progress(void);
 int32_t flashJournalStrategySequential_read_progress(void);
 
+/*
+ * Delta logging; refer to delta_funcs.c.
+ */
+int32_t flashJournalStrategySequential_deltaIsPossible(SequentialFlashJournal_t *journal);
+void    flashJournalStrategySequential_deltaCheckpoint(SequentialFlashJournal_t *journal);
+int32_t flashJournalStrategySequential_deltaDiscover(SequentialFlashJournal_t *journal);
+int32_t flashJournalStrategySequential_deltaReadBlob(SequentialFlashJournal_t *journal, uint32_t logicalOffset, void *buffer, uint32_t size);
+int32_t flashJournalStrategySequential_deltaLog(SequentialFlashJournal_t *journal, const void *blob, size_t size);
+int32_t flashJournalStrategySequential_deltaCommit(SequentialFlashJournal_t *journal);
+int32_t flashJournalStrategySequential_deltaPromote(SequentialFlashJournal_t *journal);
+
 void    mtdHandler(int32_t status, ARM_STORAGE_OPERATION operation);
 void    formatHandler(int32_t status, ARM_STORAGE_OPERATION operation);
 
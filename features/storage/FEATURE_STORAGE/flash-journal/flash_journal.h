@@ -137,7 +137,7 @@ struct FlashJournal_t;
  * strategy-specific metadata. The value of this MAX_SIZE may need to be
  * increased if some future journal-strategy needs more metadata.
  */
-#define FLASH_JOURNAL_HANDLE_MAX_SIZE 160
+#define FLASH_JOURNAL_HANDLE_MAX_SIZE 192
 
 /**
  * This is the set of operations offered by the flash-journal abstraction. A set
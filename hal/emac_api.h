@@ -134,6 +134,29 @@ typedef void (*emac_set_link_input_cb_fn)(emac_interface_t *emac, emac_link_inpu
  */
 typedef void (*emac_set_link_state_cb_fn)(emac_interface_t *emac, emac_link_state_change_fn state_cb, void *data);
 
+/**
+ * Checksum offloads, reported by @a get_offload
+ *
+ * On receive, offload means the hardware or driver drops frames that fail the
+ * checksum, as the stack no longer checks them.
+ */
+typedef enum emac_offload {
+    EMAC_OFFLOAD_TX_IP_CHECKSUM = (1 << 0), /**< Inserts IPv4 header checksums */
+    EMAC_OFFLOAD_TX_L4_CHECKSUM = (1 << 1), /**< Inserts TCP, UDP, ICMP and ICMPv6 checksums */
+    EMAC_OFFLOAD_RX_IP_CHECKSUM = (1 << 2), /**< Checks IPv4 header checksums */
+    EMAC_OFFLOAD_RX_L4_CHECKSUM = (1 << 3)  /**< Checks TCP, UDP, ICMP and ICMPv6 checksums */
+} emac_offload_t;
+
+/**
+ * Return the checksum offloads the hardware performs
+ *
+ * Optional. Interfaces that leave this NULL have all checksums done by the stack.
+ *
+ * @param emac Emac interface
+ * @return     Mask of emac_offload_t flags
+ */
+typedef uint32_t (*emac_get_offload_fn)(emac_interface_t *emac);
+
 typedef struct emac_interface_ops {
     emac_get_mtu_size_fn        get_mtu_size;
     emac_get_ifname_fn          get_ifname;
@@ -145,6 +168,7 @@ typedef struct emac_interface_ops {
     emac_power_down_fn          power_down;
     emac_set_link_input_cb_fn   set_link_input_cb;
     emac_set_link_state_cb_fn   set_link_state_cb;
+    emac_get_offload_fn         get_offload;
 } emac_interface_ops_t;
 
 typedef struct emac_interface {